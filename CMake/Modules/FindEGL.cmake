@@ -0,0 +1,30 @@
+###############################################################################
+# Find EGL
+#
+# This sets the following variables:
+# EGL_FOUND - True if EGL was found.
+# EGL_INCLUDE_DIRS - Directories containing the EGL include files.
+# EGL_LIBRARIES - Libraries needed to use EGL.
+
+find_package(PkgConfig)
+pkg_check_modules(PC_EGL egl)
+
+find_path(EGL_INCLUDE_DIR EGL/egl.h
+    HINTS ${PC_EGL_INCLUDEDIR} ${PC_EGL_INCLUDE_DIRS} "${EGL_ROOT}" "$ENV{EGL_ROOT}"
+    PATH_SUFFIXES include)
+
+find_library(EGL_LIBRARY NAMES EGL libEGL
+    HINTS ${PC_EGL_LIBDIR} ${PC_EGL_LIBRARY_DIRS} "${EGL_ROOT}" "$ENV{EGL_ROOT}"
+    PATH_SUFFIXES lib)
+
+set(EGL_INCLUDE_DIRS ${EGL_INCLUDE_DIR})
+set(EGL_LIBRARIES ${EGL_LIBRARY})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(EGL DEFAULT_MSG EGL_LIBRARY EGL_INCLUDE_DIR)
+
+mark_as_advanced(EGL_INCLUDE_DIR EGL_LIBRARY)
+
+if(EGL_FOUND)
+  message(STATUS "EGL found (include: ${EGL_INCLUDE_DIRS}, lib: ${EGL_LIBRARIES})")
+endif(EGL_FOUND)
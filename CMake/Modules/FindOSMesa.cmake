@@ -0,0 +1,30 @@
+###############################################################################
+# Find OSMesa
+#
+# This sets the following variables:
+# OSMESA_FOUND - True if OSMesa was found.
+# OSMESA_INCLUDE_DIRS - Directories containing the OSMesa include files.
+# OSMESA_LIBRARIES - Libraries needed to use OSMesa.
+
+find_package(PkgConfig)
+pkg_check_modules(PC_OSMESA osmesa)
+
+find_path(OSMESA_INCLUDE_DIR GL/osmesa.h
+    HINTS ${PC_OSMESA_INCLUDEDIR} ${PC_OSMESA_INCLUDE_DIRS} "${OSMESA_ROOT}" "$ENV{OSMESA_ROOT}"
+    PATH_SUFFIXES include)
+
+find_library(OSMESA_LIBRARY NAMES OSMesa OSMesa32 OSMesa16
+    HINTS ${PC_OSMESA_LIBDIR} ${PC_OSMESA_LIBRARY_DIRS} "${OSMESA_ROOT}" "$ENV{OSMESA_ROOT}"
+    PATH_SUFFIXES lib)
+
+set(OSMESA_INCLUDE_DIRS ${OSMESA_INCLUDE_DIR})
+set(OSMESA_LIBRARIES ${OSMESA_LIBRARY})
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(OSMesa DEFAULT_MSG OSMESA_LIBRARY OSMESA_INCLUDE_DIR)
+
+mark_as_advanced(OSMESA_INCLUDE_DIR OSMESA_LIBRARY)
+
+if(OSMESA_FOUND)
+  message(STATUS "OSMesa found (include: ${OSMESA_INCLUDE_DIRS}, lib: ${OSMESA_LIBRARIES})")
+endif(OSMESA_FOUND)
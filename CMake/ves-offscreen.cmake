@@ -0,0 +1,20 @@
+# Selects the library that creates offscreen GL contexts for the targets that
+# include vesKiwiOffscreenContext.h, and sets offscreen_libraries to link.
+# EGL pbuffers are used by default and OSMesa on request; both run on Mesa's
+# llvmpipe, so no GPU or display server is needed.
+option(VES_OFFSCREEN_USE_OSMESA "Create offscreen contexts with OSMesa instead of EGL." OFF)
+mark_as_advanced(VES_OFFSCREEN_USE_OSMESA)
+
+if(VES_OFFSCREEN_USE_OSMESA)
+  if(NOT VES_USE_DESKTOP_GL)
+    message(FATAL_ERROR "OSMesa offscreen contexts require VES_USE_DESKTOP_GL.")
+  endif()
+  find_package(OSMesa REQUIRED)
+  include_directories(${OSMESA_INCLUDE_DIRS})
+  add_definitions(-DVES_OFFSCREEN_USE_OSMESA)
+  set(offscreen_libraries ${OSMESA_LIBRARIES})
+else()
+  find_package(EGL REQUIRED)
+  include_directories(${EGL_INCLUDE_DIRS})
+  set(offscreen_libraries ${EGL_LIBRARIES})
+endif()
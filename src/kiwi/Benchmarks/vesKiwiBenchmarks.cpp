@@ -0,0 +1,625 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// ves_benchmarks loads a fixed set of scenes into a vesKiwiViewerApp that
+// renders into an offscreen context, and writes the load, conversion and
+// frame times of each scene as JSON.
+//
+// Usage: ves_benchmarks [--output file.json] [--data-dir dir]
+//                       [--scene name]... [--frames n] [--size width height]
+//                       [--lod] [--gpu-timers] [--trace-dir dir]
+
+#include "vesKiwiOffscreenContext.h"
+
+#include <vesKiwiAnimationRepresentation.h>
+#include <vesKiwiDataConversionTools.h>
+#include <vesKiwiDataLoader.h>
+#include <vesKiwiPolyDataRepresentation.h>
+#include <vesKiwiVersion.h>
+#include <vesKiwiViewerApp.h>
+#include <vesCamera.h>
+#include <vesGeometryData.h>
+#include <vesProfiler.h>
+#include <vesRenderer.h>
+
+#include "cJSON.h"
+
+#include <vtkDataSet.h>
+#include <vtkMath.h>
+#include <vtkNew.h>
+#include <vtkPlaneSource.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkSphereSource.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#ifndef VES_BENCHMARK_DATA_DIR
+  #define VES_BENCHMARK_DATA_DIR "."
+#endif
+
+namespace {
+
+//----------------------------------------------------------------------------
+class vesKiwiBenchmarkApp : public vesKiwiViewerApp
+{
+public:
+
+  vesTypeMacro(vesKiwiBenchmarkApp);
+
+  using vesKiwiViewerApp::addManagedDataRepresentation;
+  using vesKiwiViewerApp::addPolyDataRepresentation;
+  using vesKiwiViewerApp::addRepresentationsForDataSet;
+};
+
+//----------------------------------------------------------------------------
+struct Options
+{
+  Options() :
+    DataDirectory(VES_BENCHMARK_DATA_DIR),
+    NumberOfFrames(200),
+    Width(800),
+    Height(600),
+    LevelOfDetail(false),
+    GPUTimers(false)
+  {
+  }
+
+  std::string OutputFile;
+  std::string DataDirectory;
+  std::string TraceDirectory;
+  std::vector<std::string> Scenes;
+  int NumberOfFrames;
+  int Width;
+  int Height;
+  bool LevelOfDetail;
+  bool GPUTimers;
+};
+
+//----------------------------------------------------------------------------
+struct SceneState
+{
+  SceneState() :
+    LoadTime(0.0),
+    ConversionTime(0.0)
+  {
+  }
+
+  double LoadTime;
+  double ConversionTime;
+  std::string ErrorMessage;
+
+  // Set by scenes that change their geometry every frame.
+  vesKiwiAnimationRepresentation::Ptr Animation;
+};
+
+typedef bool (*SceneSetup)(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state);
+
+struct Scene
+{
+  const char* Name;
+  SceneSetup Setup;
+};
+
+//----------------------------------------------------------------------------
+double now()
+{
+  return vesProfiler::currentTime();
+}
+
+//----------------------------------------------------------------------------
+double peakResidentBytes()
+{
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+  return static_cast<double>(usage.ru_maxrss);
+#else
+  return usage.ru_maxrss * 1024.0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+// A fixed sequence, so that every run renders the same scenes.
+class RandomSequence
+{
+public:
+  RandomSequence() : State(12345) {}
+
+  double next()
+  {
+    this->State = this->State * 1664525u + 1013904223u;
+    return this->State / 4294967296.0;
+  }
+
+private:
+  unsigned int State;
+};
+
+//----------------------------------------------------------------------------
+bool setupLargeMesh(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state)
+{
+  vesNotUsed(options);
+
+  double start = now();
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetThetaResolution(1024);
+  sphere->SetPhiResolution(1024);
+  sphere->Update();
+  state.LoadTime = now() - start;
+
+  start = now();
+  app.addPolyDataRepresentation(sphere->GetOutput(), app.shaderProgram());
+  state.ConversionTime = now() - start;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool setupManyActors(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state)
+{
+  vesNotUsed(options);
+
+  const int gridSize = 32;
+  double start = now();
+  std::vector<vtkSmartPointer<vtkPolyData> > spheres;
+  for (int i = 0; i < gridSize; ++i) {
+    for (int j = 0; j < gridSize; ++j) {
+      vtkNew<vtkSphereSource> sphere;
+      sphere->SetThetaResolution(12);
+      sphere->SetPhiResolution(12);
+      sphere->SetRadius(0.4);
+      sphere->SetCenter(i, j, 0.0);
+      sphere->Update();
+      spheres.push_back(sphere->GetOutput());
+    }
+  }
+  state.LoadTime = now() - start;
+
+  start = now();
+  for (size_t i = 0; i < spheres.size(); ++i) {
+    app.addPolyDataRepresentation(spheres[i], app.shaderProgram());
+  }
+  state.ConversionTime = now() - start;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool setupPointCloud(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state)
+{
+  vesNotUsed(options);
+
+  const vtkIdType numberOfPoints = 1000000;
+  double start = now();
+  RandomSequence random;
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  vtkNew<vtkUnsignedCharArray> colors;
+  colors->SetName("rgb_colors");
+  colors->SetNumberOfComponents(3);
+  colors->SetNumberOfTuples(numberOfPoints);
+  for (vtkIdType i = 0; i < numberOfPoints; ++i) {
+    // A noisy height field, like a scanned terrain.
+    double x = random.next();
+    double y = random.next();
+    double z = 0.1 * std::sin(10.0 * x) * std::cos(10.0 * y) + 0.01 * random.next();
+    points->SetPoint(i, x, y, z);
+    unsigned char rgb[3] = {
+      static_cast<unsigned char>(255 * x),
+      static_cast<unsigned char>(255 * y),
+      static_cast<unsigned char>(128 + 1000 * z) };
+    colors->SetTupleValue(i, rgb);
+  }
+  vtkNew<vtkPolyData> polyData;
+  polyData->SetPoints(points.GetPointer());
+  polyData->GetPointData()->AddArray(colors.GetPointer());
+  state.LoadTime = now() - start;
+
+  start = now();
+  app.addPolyDataRepresentation(polyData.GetPointer(), app.shaderProgram());
+  state.ConversionTime = now() - start;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool setupDataFile(vesKiwiBenchmarkApp& app, const std::string& filename, SceneState& state)
+{
+  vesKiwiDataLoader loader;
+  double start = now();
+  vtkSmartPointer<vtkDataSet> dataSet = loader.loadDataset(filename);
+  state.LoadTime = now() - start;
+  if (!dataSet) {
+    state.ErrorMessage = loader.errorTitle() + ": " + loader.errorMessage();
+    return false;
+  }
+
+  start = now();
+  app.addRepresentationsForDataSet(dataSet);
+  state.ConversionTime = now() - start;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool setupImage(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state)
+{
+  return setupDataFile(app, options.DataDirectory + "/head.vti", state);
+}
+
+//----------------------------------------------------------------------------
+bool setupRealMesh(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state)
+{
+  return setupDataFile(app, options.DataDirectory + "/visible-woman-hand.vtp", state);
+}
+
+//----------------------------------------------------------------------------
+bool setupAnimationSeries(vesKiwiBenchmarkApp& app, const Options& options, SceneState& state)
+{
+  vesNotUsed(options);
+
+  // A waving sheet, every frame has the connectivity of the first one.
+  const int numberOfFrames = 60;
+  double start = now();
+  vtkNew<vtkPlaneSource> plane;
+  plane->SetResolution(255, 255);
+  plane->Update();
+  std::vector<vtkSmartPointer<vtkPolyData> > frames;
+  for (int frame = 0; frame < numberOfFrames; ++frame) {
+    vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+    polyData->DeepCopy(plane->GetOutput());
+    vtkPoints* points = polyData->GetPoints();
+    const double phase = 2.0 * vtkMath::Pi() * frame / numberOfFrames;
+    for (vtkIdType i = 0; i < points->GetNumberOfPoints(); ++i) {
+      double point[3];
+      points->GetPoint(i, point);
+      point[2] = 0.05 * std::sin(4.0 * vtkMath::Pi() * point[0] + phase);
+      points->SetPoint(i, point);
+    }
+    frames.push_back(polyData);
+  }
+  state.LoadTime = now() - start;
+
+  start = now();
+  std::vector<vtkSmartPointer<vtkPolyData> > polyData(numberOfFrames);
+  std::vector<vesGeometryData::Ptr> geometryData(numberOfFrames);
+  for (int frame = 0; frame < numberOfFrames; ++frame) {
+    geometryData[frame] = vesKiwiPolyDataRepresentation::PreparePolyData(frames[frame], polyData[frame]);
+    if (frame && vesKiwiDataConversionTools::HasSameTopology(geometryData[0], geometryData[frame])) {
+      vesKiwiDataConversionTools::AdoptTopology(geometryData[0], geometryData[frame]);
+    }
+  }
+
+  vesKiwiPolyDataRepresentation::Ptr rep(new vesKiwiPolyDataRepresentation);
+  rep->initializeWithShader(app.shaderProgram());
+  rep->setShaderVariantCache(app.shaderVariantCache());
+  rep->setPreparedPolyData(polyData[0], geometryData[0]);
+
+  vesKiwiAnimationRepresentation::Ptr series(new vesKiwiAnimationRepresentation);
+  series->setFrames(rep, polyData, geometryData);
+  series->onPause();
+  series->addSelfToRenderer(app.renderer());
+  app.addManagedDataRepresentation(series);
+  state.ConversionTime = now() - start;
+
+  state.Animation = series;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+const Scene scenes[] = {
+  { "large_mesh", setupLargeMesh },
+  { "many_actors", setupManyActors },
+  { "point_cloud", setupPointCloud },
+  { "image_3d", setupImage },
+  { "animation_series", setupAnimationSeries },
+  { "real_mesh", setupRealMesh }
+};
+
+const int numberOfScenes = sizeof(scenes) / sizeof(scenes[0]);
+
+//----------------------------------------------------------------------------
+double percentile(const std::vector<double>& sortedValues, double percent)
+{
+  if (sortedValues.empty()) {
+    return 0.0;
+  }
+
+  // Nearest rank.
+  size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * sortedValues.size()));
+  rank = std::max(rank, static_cast<size_t>(1));
+  return sortedValues[std::min(rank, sortedValues.size()) - 1];
+}
+
+//----------------------------------------------------------------------------
+cJSON* frameTimeStatistics(std::vector<double> frameTimes)
+{
+  std::sort(frameTimes.begin(), frameTimes.end());
+
+  double total = 0.0;
+  for (size_t i = 0; i < frameTimes.size(); ++i) {
+    total += frameTimes[i];
+  }
+
+  cJSON* json = cJSON_CreateObject();
+  cJSON_AddNumberToObject(json, "mean", frameTimes.empty() ? 0.0 : 1000.0 * total / frameTimes.size());
+  cJSON_AddNumberToObject(json, "min", frameTimes.empty() ? 0.0 : 1000.0 * frameTimes.front());
+  cJSON_AddNumberToObject(json, "p50", 1000.0 * percentile(frameTimes, 50.0));
+  cJSON_AddNumberToObject(json, "p90", 1000.0 * percentile(frameTimes, 90.0));
+  cJSON_AddNumberToObject(json, "p99", 1000.0 * percentile(frameTimes, 99.0));
+  cJSON_AddNumberToObject(json, "max", frameTimes.empty() ? 0.0 : 1000.0 * frameTimes.back());
+  return json;
+}
+
+//----------------------------------------------------------------------------
+cJSON* runScene(vesKiwiBenchmarkApp& app, const Scene& scene, const Options& options, bool& success)
+{
+  cJSON* json = cJSON_CreateObject();
+  cJSON_AddStringToObject(json, "name", scene.Name);
+
+  app.resetScene();
+  SceneState state;
+  success = scene.Setup(app, options, state);
+  if (!success) {
+    cJSON_AddStringToObject(json, "error", state.ErrorMessage.c_str());
+    return json;
+  }
+
+  app.resetView();
+
+  // The first frame uploads the geometry and links the shader programs, it
+  // is reported on its own.
+  double start = now();
+  app.render();
+  glFinish();
+  const double firstFrameTime = now() - start;
+
+  vesProfiler::Ptr profiler = app.profiler();
+  profiler->clear();
+
+  std::vector<double> frameTimes;
+  double uniformCalls = 0.0;
+  double stateCalls = 0.0;
+  double skippedStateCalls = 0.0;
+  const int numberOfFrames = options.NumberOfFrames;
+  for (int frame = 0; frame < numberOfFrames; ++frame) {
+    if (state.Animation) {
+      state.Animation->setCurrentFrame(frame % state.Animation->numberOfFrames());
+    }
+    app.camera()->azimuth(360.0 / numberOfFrames);
+
+    // Waiting for the GPU makes the frame time include the rasterization.
+    start = now();
+    app.render();
+    glFinish();
+    frameTimes.push_back(now() - start);
+
+    uniformCalls += app.renderer()->uniformCallCount();
+    stateCalls += app.renderer()->stateCallCount();
+    skippedStateCalls += app.renderer()->skippedStateCallCount();
+  }
+
+  cJSON_AddNumberToObject(json, "load_ms", 1000.0 * state.LoadTime);
+  cJSON_AddNumberToObject(json, "conversion_ms", 1000.0 * state.ConversionTime);
+  cJSON_AddNumberToObject(json, "first_frame_ms", 1000.0 * firstFrameTime);
+  cJSON_AddItemToObject(json, "frame_ms", frameTimeStatistics(frameTimes));
+
+  // Averages over the recorded frames.
+  double phaseTimes[vesProfiler::NumberOfPhases] = { 0.0 };
+  double gpuRenderTime = 0.0;
+  int gpuFrames = 0;
+  double drawCalls = 0.0;
+  double triangles = 0.0;
+  double bufferUploads = 0.0;
+  double uploadedBytes = 0.0;
+  const int recordedFrames = profiler->numberOfFrames();
+  for (int i = 0; i < recordedFrames; ++i) {
+    const vesProfiler::Frame& frame = profiler->frame(i);
+    for (int phase = 0; phase < vesProfiler::NumberOfPhases; ++phase) {
+      phaseTimes[phase] += frame.m_phaseDuration[phase];
+    }
+    if (frame.m_gpuDuration[vesProfiler::Render] >= 0.0) {
+      gpuRenderTime += frame.m_gpuDuration[vesProfiler::Render];
+      ++gpuFrames;
+    }
+    drawCalls += frame.m_drawCalls;
+    triangles += frame.m_triangles;
+    bufferUploads += frame.m_bufferUploads;
+    uploadedBytes += frame.m_uploadedBytes;
+  }
+  const double frames = std::max(recordedFrames, 1);
+
+  cJSON* phases = cJSON_CreateObject();
+  for (int phase = 0; phase < vesProfiler::NumberOfPhases; ++phase) {
+    cJSON_AddNumberToObject(phases, vesProfiler::phaseName(static_cast<vesProfiler::Phase>(phase)),
+                            1000.0 * phaseTimes[phase] / frames);
+  }
+  if (gpuFrames) {
+    cJSON_AddNumberToObject(phases, "gpu_render", 1000.0 * gpuRenderTime / gpuFrames);
+  }
+  cJSON_AddItemToObject(json, "phase_ms", phases);
+
+  cJSON* calls = cJSON_CreateObject();
+  cJSON_AddNumberToObject(calls, "draw_calls", drawCalls / frames);
+  cJSON_AddNumberToObject(calls, "triangles", triangles / frames);
+  cJSON_AddNumberToObject(calls, "buffer_uploads", bufferUploads / frames);
+  cJSON_AddNumberToObject(calls, "uploaded_bytes", uploadedBytes / frames);
+  cJSON_AddNumberToObject(calls, "uniform_calls", uniformCalls / numberOfFrames);
+  cJSON_AddNumberToObject(calls, "state_calls", stateCalls / numberOfFrames);
+  cJSON_AddNumberToObject(calls, "skipped_state_calls", skippedStateCalls / numberOfFrames);
+  cJSON_AddItemToObject(json, "gl_calls_per_frame", calls);
+
+  // The peak of the process, which only grows from scene to scene.
+  cJSON_AddNumberToObject(json, "peak_rss_bytes", peakResidentBytes());
+
+  if (!options.TraceDirectory.empty()) {
+    app.writeProfileTrace(options.TraceDirectory + "/" + scene.Name + ".json");
+  }
+
+  return json;
+}
+
+//----------------------------------------------------------------------------
+bool parseArguments(int argc, char* argv[], Options& options)
+{
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "--output" && hasValue) {
+      options.OutputFile = argv[++i];
+    }
+    else if (argument == "--data-dir" && hasValue) {
+      options.DataDirectory = argv[++i];
+    }
+    else if (argument == "--trace-dir" && hasValue) {
+      options.TraceDirectory = argv[++i];
+    }
+    else if (argument == "--scene" && hasValue) {
+      options.Scenes.push_back(argv[++i]);
+    }
+    else if (argument == "--frames" && hasValue) {
+      options.NumberOfFrames = std::max(atoi(argv[++i]), 1);
+    }
+    else if (argument == "--size" && i + 2 < argc) {
+      options.Width = std::max(atoi(argv[++i]), 1);
+      options.Height = std::max(atoi(argv[++i]), 1);
+    }
+    else if (argument == "--lod") {
+      options.LevelOfDetail = true;
+    }
+    else if (argument == "--gpu-timers") {
+      options.GPUTimers = true;
+    }
+    else {
+      std::cerr << "unknown argument: " << argument << std::endl;
+      return false;
+    }
+  }
+
+  for (size_t i = 0; i < options.Scenes.size(); ++i) {
+    bool found = false;
+    for (int j = 0; j < numberOfScenes; ++j) {
+      found = found || options.Scenes[i] == scenes[j].Name;
+    }
+    if (!found) {
+      std::cerr << "unknown scene: " << options.Scenes[i] << std::endl;
+      return false;
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void printUsage()
+{
+  std::cerr << "usage: ves_benchmarks [--output file.json] [--data-dir dir]\n"
+            << "                      [--scene name]... [--frames n] [--size width height]\n"
+            << "                      [--lod] [--gpu-timers] [--trace-dir dir]\n"
+            << "scenes:";
+  for (int i = 0; i < numberOfScenes; ++i) {
+    std::cerr << " " << scenes[i].Name;
+  }
+  std::cerr << std::endl;
+}
+
+//----------------------------------------------------------------------------
+std::string glString(GLenum name)
+{
+  const GLubyte* value = glGetString(name);
+  return value ? reinterpret_cast<const char*>(value) : std::string();
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  Options options;
+  if (!parseArguments(argc, argv, options)) {
+    printUsage();
+    return 1;
+  }
+
+  vesKiwiOffscreenContext context;
+  if (!context.initialize(options.Width, options.Height) || !context.makeCurrent()) {
+    std::cerr << "error: could not create an offscreen context: "
+              << context.errorMessage() << std::endl;
+    return 1;
+  }
+
+  vesKiwiBenchmarkApp app;
+  app.initGL();
+  app.resizeView(options.Width, options.Height);
+  app.setLevelOfDetailIsEnabled(options.LevelOfDetail);
+  app.setProfilingEnabled(true, options.NumberOfFrames);
+  app.profiler()->setGPUTimersEnabled(options.GPUTimers);
+
+  cJSON* json = cJSON_CreateObject();
+  cJSON_AddStringToObject(json, "benchmark", "ves_benchmarks");
+  cJSON_AddStringToObject(json, "version", VES_KIWI_VERSION_STR);
+  cJSON_AddStringToObject(json, "gl_vendor", glString(GL_VENDOR).c_str());
+  cJSON_AddStringToObject(json, "gl_renderer", glString(GL_RENDERER).c_str());
+  cJSON_AddStringToObject(json, "gl_version", glString(GL_VERSION).c_str());
+  cJSON_AddNumberToObject(json, "width", options.Width);
+  cJSON_AddNumberToObject(json, "height", options.Height);
+  cJSON_AddNumberToObject(json, "frames", options.NumberOfFrames);
+
+  bool success = true;
+  cJSON* sceneResults = cJSON_CreateArray();
+  for (int i = 0; i < numberOfScenes; ++i) {
+    if (!options.Scenes.empty()
+        && std::find(options.Scenes.begin(), options.Scenes.end(), scenes[i].Name) == options.Scenes.end()) {
+      continue;
+    }
+
+    std::cerr << "running " << scenes[i].Name << std::endl;
+    bool sceneSuccess = false;
+    cJSON_AddItemToArray(sceneResults, runScene(app, scenes[i], options, sceneSuccess));
+    success = success && sceneSuccess;
+  }
+  cJSON_AddItemToObject(json, "scenes", sceneResults);
+  app.resetScene();
+
+  char* text = cJSON_Print(json);
+  if (options.OutputFile.empty()) {
+    std::cout << text << std::endl;
+  }
+  else {
+    std::ofstream file(options.OutputFile.c_str());
+    file << text << std::endl;
+    if (!file) {
+      std::cerr << "error: could not write " << options.OutputFile << std::endl;
+      success = false;
+    }
+  }
+  free(text);
+  cJSON_Delete(json);
+
+  return success ? 0 : 1;
+}
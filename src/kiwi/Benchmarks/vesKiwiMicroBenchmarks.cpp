@@ -0,0 +1,619 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// ves_micro_benchmarks times the CPU kernels that convert VTK data to VES
+// geometry and post-process it, on synthetic grids of several sizes.  Like
+// Google Benchmark, every kernel is repeated until it ran for a minimum
+// time, and the time per iteration and the elements per second are
+// reported.  The results can be written as JSON and compared with the JSON
+// of an earlier run.
+//
+// With --pcd, the time vesKiwiPCDReader takes to read the given file is
+// compared with vtkPCLConversions instead, when kiwi is built with PCL.
+//
+// Usage: ves_micro_benchmarks [--filter text] [--min-time seconds]
+//                             [--output file.json]
+//                             [--baseline file.json] [--tolerance percent]
+//        ves_micro_benchmarks --pcd file.pcd
+
+#include <vesKiwiDataConversionTools.h>
+#include <vesKiwiPCDReader.h>
+#include <vesGeometryData.h>
+#include <vesPrimitive.h>
+#include <vesProfiler.h>
+#include <vesSourceData.h>
+#include <vesVertexAttributeKeys.h>
+
+#include "cJSON.h"
+
+#include <vtkCellArray.h>
+#include <vtkDiscretizableColorTransferFunction.h>
+#include <vtkFloatArray.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+//----------------------------------------------------------------------------
+// Handed to every benchmark, which runs its kernel once per iteration of
+//
+//   while (state.keepRunning()) { ... }
+//
+// Work that must not be timed, like restoring an input the kernel modifies,
+// goes between pauseTiming() and resumeTiming().
+class BenchmarkState
+{
+public:
+
+  BenchmarkState(int size, long iterations) :
+    Size(size),
+    Iterations(iterations),
+    Done(0),
+    Started(false),
+    Start(0.0),
+    Elapsed(0.0),
+    ItemsPerIteration(0.0)
+  {
+  }
+
+  bool keepRunning()
+  {
+    if (!this->Started) {
+      this->Started = true;
+      this->Start = vesProfiler::currentTime();
+    }
+
+    if (this->Done == this->Iterations) {
+      this->Elapsed += vesProfiler::currentTime() - this->Start;
+      return false;
+    }
+
+    ++this->Done;
+    return true;
+  }
+
+  void pauseTiming()
+  {
+    this->Elapsed += vesProfiler::currentTime() - this->Start;
+  }
+
+  void resumeTiming()
+  {
+    this->Start = vesProfiler::currentTime();
+  }
+
+  /// The size argument the benchmark was registered with.
+  int size() const { return this->Size; }
+
+  /// Number of elements one iteration processes, for the throughput.
+  void setItemsPerIteration(double items) { this->ItemsPerIteration = items; }
+  double itemsPerIteration() const { return this->ItemsPerIteration; }
+
+  long iterations() const { return this->Iterations; }
+  double elapsedTime() const { return this->Elapsed; }
+
+private:
+  int Size;
+  long Iterations;
+  long Done;
+  bool Started;
+  double Start;
+  double Elapsed;
+  double ItemsPerIteration;
+};
+
+typedef void (*BenchmarkFunction)(BenchmarkState& state);
+
+struct Benchmark
+{
+  const char* Name;
+  BenchmarkFunction Function;
+};
+
+struct Result
+{
+  std::string Name;
+  long Iterations;
+  double TimePerIteration;
+  double ItemsPerSecond;
+};
+
+//----------------------------------------------------------------------------
+// Synthetic data.  A square grid of about numberOfPoints points on a wavy
+// height field, split in triangles, with the height as a point scalar.
+vtkSmartPointer<vtkPolyData> makeGrid(int numberOfPoints)
+{
+  const int side = std::max(2, static_cast<int>(std::sqrt(static_cast<double>(numberOfPoints))));
+
+  vtkSmartPointer<vtkPoints> points = vtkSmartPointer<vtkPoints>::New();
+  points->SetNumberOfPoints(side * side);
+  vtkSmartPointer<vtkFloatArray> heights = vtkSmartPointer<vtkFloatArray>::New();
+  heights->SetName("height");
+  heights->SetNumberOfTuples(side * side);
+  for (int j = 0; j < side; ++j) {
+    for (int i = 0; i < side; ++i) {
+      const double x = static_cast<double>(i) / (side - 1);
+      const double y = static_cast<double>(j) / (side - 1);
+      const double z = 0.1 * std::sin(10.0 * x) * std::cos(10.0 * y);
+      points->SetPoint(j * side + i, x, y, z);
+      heights->SetValue(j * side + i, z);
+    }
+  }
+
+  vtkSmartPointer<vtkCellArray> triangles = vtkSmartPointer<vtkCellArray>::New();
+  for (int j = 0; j + 1 < side; ++j) {
+    for (int i = 0; i + 1 < side; ++i) {
+      const vtkIdType corner = j * side + i;
+      triangles->InsertNextCell(3);
+      triangles->InsertCellPoint(corner);
+      triangles->InsertCellPoint(corner + 1);
+      triangles->InsertCellPoint(corner + side + 1);
+      triangles->InsertNextCell(3);
+      triangles->InsertCellPoint(corner);
+      triangles->InsertCellPoint(corner + side + 1);
+      triangles->InsertCellPoint(corner + side);
+    }
+  }
+
+  vtkSmartPointer<vtkPolyData> polyData = vtkSmartPointer<vtkPolyData>::New();
+  polyData->SetPoints(points);
+  polyData->SetPolys(triangles);
+  polyData->GetPointData()->SetScalars(heights);
+  return polyData;
+}
+
+//----------------------------------------------------------------------------
+// A copy of geometry converted from a grid, whose arrays the kernels that
+// modify their input can change.
+vesGeometryData::Ptr copyGeometry(vesGeometryData::Ptr geometry)
+{
+  vesGeometryData::Ptr copy(new vesGeometryData);
+  vesSourceDataP3N3f::Ptr vertices =
+    std::tr1::static_pointer_cast<vesSourceDataP3N3f>(geometry->sourceData(vesVertexAttributeKeys::Position));
+  copy->addSource(vesSourceDataP3N3f::Ptr(new vesSourceDataP3N3f(*vertices)));
+
+  vesPrimitive::Ptr triangles = geometry->triangles();
+  vesIndices<unsigned int>::Ptr indices(new vesIndices<unsigned int>());
+  *indices->indices() = *std::tr1::static_pointer_cast<vesIndices<unsigned int> >(triangles->getVesIndices())->indices();
+  vesPrimitive::Ptr trianglesCopy(new vesPrimitive());
+  trianglesCopy->setVesIndices(indices);
+  trianglesCopy->setPrimitiveType(triangles->primitiveType());
+  trianglesCopy->setIndicesValueType(triangles->indicesValueType());
+  trianglesCopy->setIndexCount(triangles->indexCount());
+  copy->addPrimitive(trianglesCopy);
+  return copy;
+}
+
+//----------------------------------------------------------------------------
+// Geometry holding the arrays of another one, with its bounds and normals
+// not computed yet.
+vesGeometryData::Ptr shareGeometry(vesGeometryData::Ptr geometry)
+{
+  vesGeometryData::Ptr shared(new vesGeometryData);
+  for (unsigned int i = 0; i < geometry->numberOfSources(); ++i) {
+    shared->addSource(geometry->source(i));
+  }
+  for (unsigned int i = 0; i < geometry->numberOfPrimitiveTypes(); ++i) {
+    shared->addPrimitive(geometry->primitive(i));
+  }
+  return shared;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkScalarsToColors> makeColorMap(vtkPolyData* polyData)
+{
+  double range[2];
+  polyData->GetPointData()->GetScalars()->GetRange(range);
+  return vesKiwiDataConversionTools::GetCoolToWarmLookupTable(range);
+}
+
+//----------------------------------------------------------------------------
+void benchmarkConvert(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  while (state.keepRunning()) {
+    vesKiwiDataConversionTools::Convert(grid);
+  }
+  state.setItemsPerIteration(grid->GetNumberOfPoints());
+}
+
+//----------------------------------------------------------------------------
+void benchmarkConvertScalarsToColors(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  vtkSmartPointer<vtkScalarsToColors> colorMap = makeColorMap(grid);
+  vtkDataArray* scalars = grid->GetPointData()->GetScalars();
+  while (state.keepRunning()) {
+    vesKiwiDataConversionTools::ConvertScalarsToColors(scalars, colorMap);
+  }
+  state.setItemsPerIteration(scalars->GetNumberOfTuples());
+}
+
+//----------------------------------------------------------------------------
+void benchmarkMapScalars(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  vtkSmartPointer<vtkScalarsToColors> colorMap = makeColorMap(grid);
+  vtkDataArray* scalars = grid->GetPointData()->GetScalars();
+  while (state.keepRunning()) {
+    vesKiwiDataConversionTools::MapScalars(scalars, colorMap);
+  }
+  state.setItemsPerIteration(scalars->GetNumberOfTuples());
+}
+
+//----------------------------------------------------------------------------
+void benchmarkRemoveSharedTriangleVertices(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  vesGeometryData::Ptr geometry = vesKiwiDataConversionTools::Convert(grid);
+  const std::vector<vesSourceData::Ptr> sourceData;
+  while (state.keepRunning()) {
+    state.pauseTiming();
+    vesGeometryData::Ptr input = copyGeometry(geometry);
+    state.resumeTiming();
+    vesKiwiDataConversionTools::RemoveSharedTriangleVertices(input, sourceData);
+  }
+  state.setItemsPerIteration(geometry->triangles()->size());
+}
+
+//----------------------------------------------------------------------------
+void benchmarkComputeWireframeVertexArrays(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  vesGeometryData::Ptr geometry = vesKiwiDataConversionTools::Convert(grid);
+  vesKiwiDataConversionTools::RemoveSharedTriangleVertices(geometry, std::vector<vesSourceData::Ptr>());
+  while (state.keepRunning()) {
+    // The kernel adds its arrays to the geometry.
+    state.pauseTiming();
+    vesGeometryData::Ptr input = shareGeometry(geometry);
+    state.resumeTiming();
+    vesKiwiDataConversionTools::ComputeWireframeVertexArrays(input);
+  }
+  state.setItemsPerIteration(geometry->triangles()->size() / 3);
+}
+
+//----------------------------------------------------------------------------
+void benchmarkComputeBounds(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  vesGeometryData::Ptr geometry = vesKiwiDataConversionTools::Convert(grid);
+  while (state.keepRunning()) {
+    // Bounds are computed once per geometry.
+    state.pauseTiming();
+    vesGeometryData::Ptr input = shareGeometry(geometry);
+    state.resumeTiming();
+    input->computeBounds();
+  }
+  state.setItemsPerIteration(geometry->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray());
+}
+
+//----------------------------------------------------------------------------
+void benchmarkComputeNormals(BenchmarkState& state)
+{
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  vesGeometryData::Ptr geometry = vesKiwiDataConversionTools::Convert(grid);
+  while (state.keepRunning()) {
+    // Normals are computed once per geometry.
+    state.pauseTiming();
+    vesGeometryData::Ptr input = shareGeometry(geometry);
+    state.resumeTiming();
+    input->computeNormals<unsigned int>();
+  }
+  state.setItemsPerIteration(geometry->triangles()->size() / 3);
+}
+
+//----------------------------------------------------------------------------
+// Writes the grid points as a binary PCD file with packed colors, the
+// encoding most scanners save.
+bool writePCDFile(const std::string& filename, vtkPolyData* polyData)
+{
+  FILE* file = fopen(filename.c_str(), "wb");
+  if (!file) {
+    return false;
+  }
+
+  const vtkIdType numberOfPoints = polyData->GetNumberOfPoints();
+  fprintf(file, "VERSION 0.7\nFIELDS x y z rgb\nSIZE 4 4 4 4\nTYPE F F F F\nCOUNT 1 1 1 1\n"
+          "WIDTH %d\nHEIGHT 1\nVIEWPOINT 0 0 0 1 0 0 0\nPOINTS %d\nDATA binary\n",
+          static_cast<int>(numberOfPoints), static_cast<int>(numberOfPoints));
+  for (vtkIdType i = 0; i < numberOfPoints; ++i) {
+    double point[3];
+    polyData->GetPoint(i, point);
+    const float record[3] = {
+      static_cast<float>(point[0]), static_cast<float>(point[1]), static_cast<float>(point[2]) };
+    const unsigned int color = static_cast<unsigned int>(i) & 0xffffff;
+    fwrite(record, sizeof(record), 1, file);
+    fwrite(&color, sizeof(color), 1, file);
+  }
+  return fclose(file) == 0;
+}
+
+//----------------------------------------------------------------------------
+void benchmarkReadPCD(BenchmarkState& state)
+{
+  std::stringstream filename;
+  filename << "ves_micro_benchmarks_" << state.size() << ".pcd";
+  vtkSmartPointer<vtkPolyData> grid = makeGrid(state.size());
+  if (!writePCDFile(filename.str(), grid)) {
+    std::cerr << "error: could not write " << filename.str() << std::endl;
+    exit(1);
+  }
+
+  vesKiwiPCDReader reader;
+  while (state.keepRunning()) {
+    reader.read(filename.str());
+  }
+  state.setItemsPerIteration(grid->GetNumberOfPoints());
+  remove(filename.str().c_str());
+}
+
+//----------------------------------------------------------------------------
+const Benchmark benchmarks[] = {
+  { "Convert", benchmarkConvert },
+  { "ConvertScalarsToColors", benchmarkConvertScalarsToColors },
+  { "MapScalars", benchmarkMapScalars },
+  { "RemoveSharedTriangleVertices", benchmarkRemoveSharedTriangleVertices },
+  { "ComputeWireframeVertexArrays", benchmarkComputeWireframeVertexArrays },
+  { "computeBounds", benchmarkComputeBounds },
+  { "computeNormals", benchmarkComputeNormals },
+  { "ReadPCD", benchmarkReadPCD }
+};
+
+const int numberOfBenchmarks = sizeof(benchmarks) / sizeof(benchmarks[0]);
+
+// Number of grid points, from a mesh that fits in cache to a large scan.
+const int sizes[] = { 1 << 10, 1 << 14, 1 << 18, 1 << 20 };
+
+const int numberOfSizes = sizeof(sizes) / sizeof(sizes[0]);
+
+//----------------------------------------------------------------------------
+Result runBenchmark(const Benchmark& benchmark, int size, double minimumTime)
+{
+  // Grow the iteration count until the kernel ran long enough, aiming a bit
+  // above the minimum so that the last run usually is the one reported.
+  long iterations = 1;
+  while (true) {
+    BenchmarkState state(size, iterations);
+    benchmark.Function(state);
+
+    const double elapsed = state.elapsedTime();
+    if (elapsed >= minimumTime || iterations >= 1000000000L) {
+      Result result;
+      std::stringstream name;
+      name << benchmark.Name << "/" << size;
+      result.Name = name.str();
+      result.Iterations = iterations;
+      result.TimePerIteration = elapsed / iterations;
+      result.ItemsPerSecond = elapsed > 0.0 ? state.itemsPerIteration() * iterations / elapsed : 0.0;
+      return result;
+    }
+
+    double factor = elapsed > 0.0 ? 1.4 * minimumTime / elapsed : 10.0;
+    factor = std::min(std::max(factor, 2.0), 10.0);
+    iterations = static_cast<long>(iterations * factor);
+  }
+}
+
+//----------------------------------------------------------------------------
+std::string formatTime(double seconds)
+{
+  char text[32];
+  if (seconds < 1.0e-6) {
+    sprintf(text, "%10.1f ns", seconds * 1.0e9);
+  }
+  else if (seconds < 1.0e-3) {
+    sprintf(text, "%10.2f us", seconds * 1.0e6);
+  }
+  else {
+    sprintf(text, "%10.2f ms", seconds * 1.0e3);
+  }
+  return text;
+}
+
+//----------------------------------------------------------------------------
+std::string formatRate(double itemsPerSecond)
+{
+  char text[32];
+  if (itemsPerSecond >= 1.0e9) {
+    sprintf(text, "%8.2fG/s", itemsPerSecond * 1.0e-9);
+  }
+  else if (itemsPerSecond >= 1.0e6) {
+    sprintf(text, "%8.2fM/s", itemsPerSecond * 1.0e-6);
+  }
+  else {
+    sprintf(text, "%8.2fk/s", itemsPerSecond * 1.0e-3);
+  }
+  return text;
+}
+
+//----------------------------------------------------------------------------
+std::map<std::string, double> readBaseline(const std::string& filename, bool& success)
+{
+  std::map<std::string, double> times;
+
+  std::ifstream file(filename.c_str());
+  std::stringstream text;
+  text << file.rdbuf();
+  cJSON* json = cJSON_Parse(text.str().c_str());
+  cJSON* results = json ? cJSON_GetObjectItem(json, "benchmarks") : 0;
+  success = results && results->type == cJSON_Array;
+  if (!success) {
+    cJSON_Delete(json);
+    return times;
+  }
+
+  for (int i = 0; i < cJSON_GetArraySize(results); ++i) {
+    cJSON* result = cJSON_GetArrayItem(results, i);
+    cJSON* name = cJSON_GetObjectItem(result, "name");
+    cJSON* time = cJSON_GetObjectItem(result, "time_per_iteration_ns");
+    if (name && name->type == cJSON_String && time && time->type == cJSON_Number) {
+      times[name->valuestring] = time->valuedouble * 1.0e-9;
+    }
+  }
+
+  cJSON_Delete(json);
+  return times;
+}
+
+//----------------------------------------------------------------------------
+void printUsage()
+{
+  std::cerr << "usage: ves_micro_benchmarks [--filter text] [--min-time seconds]\n"
+            << "                            [--output file.json]\n"
+            << "                            [--baseline file.json] [--tolerance percent]\n"
+            << "       ves_micro_benchmarks --pcd file.pcd\n"
+            << "benchmarks:";
+  for (int i = 0; i < numberOfBenchmarks; ++i) {
+    std::cerr << " " << benchmarks[i].Name;
+  }
+  std::cerr << std::endl;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  std::string filter;
+  std::string outputFile;
+  std::string baselineFile;
+  double minimumTime = 0.5;
+  double tolerance = 10.0;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "--filter" && hasValue) {
+      filter = argv[++i];
+    }
+    else if (argument == "--min-time" && hasValue) {
+      minimumTime = atof(argv[++i]);
+    }
+    else if (argument == "--output" && hasValue) {
+      outputFile = argv[++i];
+    }
+    else if (argument == "--baseline" && hasValue) {
+      baselineFile = argv[++i];
+    }
+    else if (argument == "--tolerance" && hasValue) {
+      tolerance = atof(argv[++i]);
+    }
+    else if (argument == "--pcd" && hasValue) {
+      vesKiwiPCDReader::performBenchmark(argv[++i]);
+      return 0;
+    }
+    else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  std::map<std::string, double> baseline;
+  if (!baselineFile.empty()) {
+    bool success;
+    baseline = readBaseline(baselineFile, success);
+    if (!success) {
+      std::cerr << "error: could not read benchmark results from " << baselineFile << std::endl;
+      return 1;
+    }
+  }
+
+  printf("%-40s %13s %12s %11s", "Benchmark", "Time", "Iterations", "Items");
+  if (!baseline.empty()) {
+    printf(" %10s", "Speedup");
+  }
+  printf("\n");
+
+  std::vector<Result> results;
+  int numberOfRegressions = 0;
+  for (int i = 0; i < numberOfBenchmarks; ++i) {
+    for (int j = 0; j < numberOfSizes; ++j) {
+      std::stringstream name;
+      name << benchmarks[i].Name << "/" << sizes[j];
+      if (!filter.empty() && name.str().find(filter) == std::string::npos) {
+        continue;
+      }
+
+      Result result = runBenchmark(benchmarks[i], sizes[j], minimumTime);
+      results.push_back(result);
+
+      printf("%-40s %s %12ld %s", result.Name.c_str(), formatTime(result.TimePerIteration).c_str(),
+             result.Iterations, formatRate(result.ItemsPerSecond).c_str());
+
+      // Compare with the baseline: a speedup below 1 is a slowdown, and it
+      // is a regression when it exceeds the tolerance.
+      std::map<std::string, double>::const_iterator reference = baseline.find(result.Name);
+      if (reference != baseline.end() && result.TimePerIteration > 0.0) {
+        const double speedup = reference->second / result.TimePerIteration;
+        const bool regression = speedup < 1.0 / (1.0 + tolerance / 100.0);
+        numberOfRegressions += regression ? 1 : 0;
+        printf(" %9.2fx%s", speedup, regression ? " REGRESSION" : "");
+      }
+      printf("\n");
+      fflush(stdout);
+    }
+  }
+
+  if (!outputFile.empty()) {
+    cJSON* json = cJSON_CreateObject();
+    cJSON* jsonResults = cJSON_CreateArray();
+    for (size_t i = 0; i < results.size(); ++i) {
+      cJSON* result = cJSON_CreateObject();
+      cJSON_AddStringToObject(result, "name", results[i].Name.c_str());
+      cJSON_AddNumberToObject(result, "iterations", results[i].Iterations);
+      cJSON_AddNumberToObject(result, "time_per_iteration_ns", results[i].TimePerIteration * 1.0e9);
+      cJSON_AddNumberToObject(result, "items_per_second", results[i].ItemsPerSecond);
+      cJSON_AddItemToArray(jsonResults, result);
+    }
+    cJSON_AddItemToObject(json, "benchmarks", jsonResults);
+
+    char* text = cJSON_Print(json);
+    std::ofstream file(outputFile.c_str());
+    file << text << std::endl;
+    free(text);
+    cJSON_Delete(json);
+    if (!file) {
+      std::cerr << "error: could not write " << outputFile << std::endl;
+      return 1;
+    }
+  }
+
+  if (numberOfRegressions) {
+    std::cerr << numberOfRegressions << " benchmarks are more than " << tolerance
+              << "% slower than the baseline" << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
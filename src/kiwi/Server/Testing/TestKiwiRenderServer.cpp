@@ -0,0 +1,175 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test puts a batch in the queue directory of ves_render_server, with a
+// single tile job, a job whose file does not exist and a job rendered in
+// tiles, and checks the result file the server leaves and the images it
+// writes.
+//
+// Usage: TestKiwiRenderServer <path to ves_render_server> <data directory>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPNGReader.h>
+#include <vtksys/SystemTools.hxx>
+
+#include "cJSON.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+bool check(bool condition, const std::string& message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message.c_str());
+  }
+  return condition;
+}
+
+std::string jobStatus(cJSON* job)
+{
+  cJSON* status = job ? cJSON_GetObjectItem(job, "status") : 0;
+  return status && status->type == cJSON_String ? status->valuestring : "";
+}
+
+//----------------------------------------------------------------------------
+// The image must have the given size and the background color in its
+// corners, and something else drawn in its center.
+bool checkImage(const std::string& filename, int width, int height, const unsigned char background[3])
+{
+  if (!check(vtksys::SystemTools::FileExists(filename.c_str()), filename + " was written")) {
+    return false;
+  }
+
+  vtkNew<vtkPNGReader> reader;
+  reader->SetFileName(filename.c_str());
+  reader->Update();
+  vtkImageData* image = reader->GetOutput();
+
+  int dimensions[3];
+  image->GetDimensions(dimensions);
+  if (!check(dimensions[0] == width && dimensions[1] == height
+             && image->GetNumberOfScalarComponents() == 3, filename + " size")) {
+    return false;
+  }
+
+  const int corners[4][2] = { { 0, 0 }, { width - 1, 0 }, { 0, height - 1 }, { width - 1, height - 1 } };
+  bool isBackground = true;
+  for (int i = 0; i < 4; ++i) {
+    const unsigned char* pixel = static_cast<const unsigned char*>(
+      image->GetScalarPointer(corners[i][0], corners[i][1], 0));
+    for (int c = 0; c < 3; ++c) {
+      isBackground &= abs(pixel[c] - background[c]) <= 1;
+    }
+  }
+
+  const unsigned char* center = static_cast<const unsigned char*>(
+    image->GetScalarPointer(width / 2, height / 2, 0));
+  const bool isDrawn = center[0] != background[0] || center[1] != background[1]
+    || center[2] != background[2];
+
+  bool testPassed = check(isBackground, filename + " background in the corners");
+  testPassed &= check(isDrawn, filename + " dataset drawn in the center");
+  return testPassed;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  if (argc < 3) {
+    printf("Usage: %s <path to ves_render_server> <data directory>\n", argv[0]);
+    return 1;
+  }
+
+  const std::string server = argv[1];
+  const std::string dataDirectory = argv[2];
+  const std::string queue = vtksys::SystemTools::CollapseFullPath("TestKiwiRenderServerQueue");
+  vtksys::SystemTools::RemoveADirectory(queue.c_str());
+  vtksys::SystemTools::MakeDirectory(queue.c_str());
+
+  // Outputs are relative to the batch file.  The last job is larger than the
+  // tile size, so it is rendered in 3 x 2 tiles by both workers.
+  const std::string batchPath = queue + "/batch.json";
+  std::ofstream batchFile(batchPath.c_str());
+  batchFile << "{ \"jobs\": [\n"
+            << "  { \"file\": \"" << dataDirectory << "/bunny.vtp\", \"output\": \"bunny.png\",\n"
+            << "    \"width\": 64, \"height\": 48, \"background\": [1, 1, 1],\n"
+            << "    \"camera\": { \"view_direction\": [0, 0, -1], \"view_up\": [0, 1, 0] } },\n"
+            << "  { \"file\": \"" << dataDirectory << "/missing.vtp\", \"output\": \"missing.png\" },\n"
+            << "  { \"file\": \"" << dataDirectory << "/bunny.vtp\", \"output\": \"tiled.png\",\n"
+            << "    \"width\": 300, \"height\": 200, \"background\": [0, 0, 0] } ] }\n";
+  batchFile.close();
+
+  const std::string command = "\"" + server + "\" --threads 2 --tile-size 128 --poll-ms 10"
+    + " --exit-when-idle --queue \"" + queue + "\"";
+  printf("%s\n", command.c_str());
+  if (!check(system(command.c_str()) == 0, "ves_render_server exit status")) {
+    return 1;
+  }
+
+  bool testPassed = true;
+  testPassed &= check(!vtksys::SystemTools::FileExists(batchPath.c_str())
+                      && !vtksys::SystemTools::FileExists((batchPath + ".running").c_str()),
+                      "the batch was claimed and removed");
+
+  std::ifstream resultFile((batchPath + ".done").c_str());
+  std::stringstream text;
+  text << resultFile.rdbuf();
+  cJSON* result = resultFile ? cJSON_Parse(text.str().c_str()) : 0;
+  if (!check(result != 0, "the result file was written")) {
+    return 1;
+  }
+
+  cJSON* jobs = cJSON_GetObjectItem(result, "jobs");
+  if (check(jobs && cJSON_GetArraySize(jobs) == 3, "a result per job")) {
+    testPassed &= check(jobStatus(cJSON_GetArrayItem(jobs, 0)) == "ok", "status of the single tile job");
+    testPassed &= check(jobStatus(cJSON_GetArrayItem(jobs, 1)) == "error", "status of the failing job");
+    testPassed &= check(jobStatus(cJSON_GetArrayItem(jobs, 2)) == "ok", "status of the tiled job");
+
+    cJSON* error = cJSON_GetObjectItem(cJSON_GetArrayItem(jobs, 1), "error");
+    testPassed &= check(error && error->type == cJSON_String && error->valuestring[0],
+                        "error message of the failing job");
+    testPassed &= check(!cJSON_GetObjectItem(cJSON_GetArrayItem(jobs, 0), "error"),
+                        "no error message for a job that succeeded");
+  }
+  else {
+    testPassed = false;
+  }
+  cJSON_Delete(result);
+
+  const unsigned char white[3] = { 255, 255, 255 };
+  const unsigned char black[3] = { 0, 0, 0 };
+  testPassed &= checkImage(queue + "/bunny.png", 64, 48, white);
+  testPassed &= checkImage(queue + "/tiled.png", 300, 200, black);
+  testPassed &= check(!vtksys::SystemTools::FileExists((queue + "/missing.png").c_str()),
+                      "no image for the failing job");
+
+  if (testPassed) {
+    vtksys::SystemTools::RemoveADirectory(queue.c_str());
+  }
+  return testPassed ? 0 : 1;
+}
@@ -0,0 +1,1168 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// ves_render_server renders thumbnails and previews of datasets and scene
+// files into PNG images, without a window.  Jobs come in batch files:
+//
+//   { "jobs": [ { "file": "bunny.vtp", "output": "bunny.png",
+//                 "width": 256, "height": 256,
+//                 "camera": { "view_direction": [0, 0, -1], "view_up": [0, 1, 0] },
+//                 "background": [1, 1, 1] } ] }
+//
+// Images larger than the tile size are rendered as tiles, by several workers
+// in parallel, and written band by band as the tiles of each band arrive,
+// so the whole image is never held in memory.  An output ending in .tif or
+// .tiff is written as TIFF, any other as PNG.
+//
+// A camera is either a view direction and up vector, which the camera is
+// reset to so that the scene fits, or a "position", "focal_point" and
+// "view_up".  Without a camera the default view of the file is used.  A batch
+// file can also hold a single job object.  Relative paths are resolved
+// against the directory of the batch file.
+//
+// Given batch files on the command line, the server renders them and exits.
+// Given --queue, it watches a directory: every *.json file there is claimed
+// by renaming it to *.json.running, and when its jobs are done a *.json.done
+// file with the result of each job replaces it.
+//
+// Each worker thread renders with its own offscreen context, and keeps its
+// shader programs linked from job to job.  Loaded and converted datasets are
+// kept in a cache that all workers share, so a file used by several jobs is
+// read once.
+//
+// Usage: ves_render_server [--threads n] [--cache-entries n] [--tile-size n]
+//                          [--warm-up file] [--stats file.json]
+//                          (--queue dir [--poll-ms ms] [--exit-when-idle]
+//                           | batch.json...)
+
+#include "vesKiwiOffscreenContext.h"
+
+#include <vesGeometryData.h>
+#include <vesGLStateCache.h>
+#include <vesImage.h>
+#include <vesKiwiDataLoader.h>
+#include <vesKiwiPolyDataRepresentation.h>
+#include <vesKiwiStreamingImageWriter.h>
+#include <vesKiwiViewerApp.h>
+#include <vesOpenGLSupport.h>
+#include <vesProfiler.h>
+
+#include "cJSON.h"
+
+#include <vtkCellData.h>
+#include <vtkConditionVariable.h>
+#include <vtkDataArray.h>
+#include <vtkDataSet.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkSmartPointer.h>
+
+#include <vtksys/Directory.hxx>
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+volatile sig_atomic_t stopRequested = 0;
+
+void requestStop(int)
+{
+  stopRequested = 1;
+}
+
+//----------------------------------------------------------------------------
+// A vesKiwiViewerApp whose scene is built by the server from cached data.
+class vesKiwiRenderServerApp : public vesKiwiViewerApp
+{
+public:
+
+  vesTypeMacro(vesKiwiRenderServerApp);
+
+  using vesKiwiViewerApp::addManagedDataRepresentation;
+  using vesKiwiViewerApp::addRepresentationsForDataSet;
+  using vesKiwiViewerApp::loadDatasetWithCustomBehavior;
+};
+
+//----------------------------------------------------------------------------
+// The image of a job, assembled from its tiles band by band and written from
+// the top band down as the bands are completed.
+struct TiledImage
+{
+  struct Band
+  {
+    Band() : NumberOfTiles(0)
+    {
+    }
+
+    std::vector<unsigned char> Pixels;
+    int NumberOfTiles;
+  };
+
+  TiledImage() : NextBand(0)
+  {
+  }
+
+  vesKiwiStreamingImageWriter Writer;
+  std::map<int, Band> Bands;
+  int NextBand;
+  vtkNew<vtkMutexLock> Lock;
+};
+
+//----------------------------------------------------------------------------
+struct Job
+{
+  Job() :
+    Id(0),
+    Width(256),
+    Height(256),
+    HasCameraPosition(false),
+    HasViewDirection(false),
+    HasBackground(false),
+    TileWidth(0),
+    TileHeight(0),
+    NumberOfColumns(0),
+    NumberOfTilesLeft(0),
+    IsLoaded(false),
+    Success(false),
+    CacheHit(false),
+    LoadTime(0.0),
+    RenderTime(0.0),
+    WriteTime(0.0)
+  {
+  }
+
+  int Id;
+  std::string File;
+  std::string Output;
+  int Width;
+  int Height;
+
+  bool HasCameraPosition;
+  vesVector3f Position;
+  vesVector3f FocalPoint;
+  bool HasViewDirection;
+  vesVector3f ViewDirection;
+  vesVector3f ViewUp;
+  bool HasBackground;
+  vesVector3f Background;
+
+  // Set when the batch is queued.
+  int TileWidth;
+  int TileHeight;
+  int NumberOfColumns;
+  int NumberOfTilesLeft;
+  vesSharedPtr<TiledImage> Image;
+
+  bool IsLoaded;
+  bool Success;
+  bool CacheHit;
+  std::string ErrorMessage;
+  double LoadTime;
+  double RenderTime;
+  double WriteTime;
+};
+
+//----------------------------------------------------------------------------
+struct Batch
+{
+  Batch() : NumberOfPendingJobs(0)
+  {
+  }
+
+  // The file the jobs were read from, and where the results go in queue
+  // mode, or an empty string.
+  std::string Path;
+  std::string ResultPath;
+  std::string ErrorMessage;
+  std::vector<Job> Jobs;
+  int NumberOfPendingJobs;
+};
+
+//----------------------------------------------------------------------------
+bool readVector(cJSON* object, const char* name, vesVector3f& vector)
+{
+  cJSON* array = cJSON_GetObjectItem(object, name);
+  if (!array || array->type != cJSON_Array || cJSON_GetArraySize(array) != 3) {
+    return false;
+  }
+  for (int i = 0; i < 3; ++i) {
+    cJSON* item = cJSON_GetArrayItem(array, i);
+    if (item->type != cJSON_Number) {
+      return false;
+    }
+    vector[i] = static_cast<float>(item->valuedouble);
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string resolvePath(const std::string& path, const std::string& directory)
+{
+  return vtksys::SystemTools::CollapseFullPath(path.c_str(), directory.c_str());
+}
+
+//----------------------------------------------------------------------------
+bool readJob(cJSON* object, const std::string& directory, Job& job, std::string& errorMessage)
+{
+  cJSON* file = cJSON_GetObjectItem(object, "file");
+  if (!file || file->type != cJSON_String) {
+    errorMessage = "job has no \"file\"";
+    return false;
+  }
+  job.File = resolvePath(file->valuestring, directory);
+
+  cJSON* output = cJSON_GetObjectItem(object, "output");
+  if (output && output->type == cJSON_String) {
+    job.Output = resolvePath(output->valuestring, directory);
+  }
+  else {
+    job.Output = vtksys::SystemTools::GetFilenamePath(job.File) + "/"
+      + vtksys::SystemTools::GetFilenameWithoutLastExtension(job.File) + ".png";
+  }
+
+  cJSON* width = cJSON_GetObjectItem(object, "width");
+  cJSON* height = cJSON_GetObjectItem(object, "height");
+  job.Width = width && width->type == cJSON_Number ? width->valueint : job.Width;
+  job.Height = height && height->type == cJSON_Number ? height->valueint : job.Height;
+  if (job.Width < 1 || job.Height < 1 || job.Width > 65536 || job.Height > 65536) {
+    errorMessage = "job size must be between 1 and 65536 pixels";
+    return false;
+  }
+
+  cJSON* camera = cJSON_GetObjectItem(object, "camera");
+  if (camera) {
+    job.ViewUp = vesVector3f(0.0f, 1.0f, 0.0f);
+    readVector(camera, "view_up", job.ViewUp);
+    job.HasCameraPosition = readVector(camera, "position", job.Position)
+      && readVector(camera, "focal_point", job.FocalPoint);
+    job.HasViewDirection = !job.HasCameraPosition
+      && readVector(camera, "view_direction", job.ViewDirection);
+    if (!job.HasCameraPosition && !job.HasViewDirection) {
+      errorMessage = "camera needs a \"view_direction\", or a \"position\" and \"focal_point\"";
+      return false;
+    }
+  }
+
+  job.HasBackground = readVector(object, "background", job.Background);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Reads the jobs of a batch file.  A batch whose file cannot be parsed has
+// no jobs and an error message.
+Batch* readBatch(const std::string& path, const std::string& resultPath)
+{
+  Batch* batch = new Batch;
+  batch->Path = path;
+  batch->ResultPath = resultPath;
+
+  std::ifstream file(path.c_str());
+  std::stringstream text;
+  text << file.rdbuf();
+  cJSON* json = file ? cJSON_Parse(text.str().c_str()) : 0;
+  if (!json) {
+    batch->ErrorMessage = "could not parse " + path;
+    return batch;
+  }
+
+  const std::string directory = vtksys::SystemTools::GetFilenamePath(
+    vtksys::SystemTools::CollapseFullPath(path.c_str()));
+  cJSON* jobs = cJSON_GetObjectItem(json, "jobs");
+  const int numberOfJobs = jobs ? cJSON_GetArraySize(jobs) : 1;
+  for (int i = 0; i < numberOfJobs; ++i) {
+    Job job;
+    if (!readJob(jobs ? cJSON_GetArrayItem(jobs, i) : json, directory, job, batch->ErrorMessage)) {
+      batch->Jobs.clear();
+      break;
+    }
+    batch->Jobs.push_back(job);
+  }
+
+  cJSON_Delete(json);
+  batch->NumberOfPendingJobs = static_cast<int>(batch->Jobs.size());
+  return batch;
+}
+
+//----------------------------------------------------------------------------
+bool writeBatchResult(const Batch& batch)
+{
+  cJSON* json = cJSON_CreateObject();
+  if (!batch.ErrorMessage.empty()) {
+    cJSON_AddStringToObject(json, "error", batch.ErrorMessage.c_str());
+  }
+  cJSON* jobs = cJSON_CreateArray();
+  for (size_t i = 0; i < batch.Jobs.size(); ++i) {
+    const Job& job = batch.Jobs[i];
+    cJSON* result = cJSON_CreateObject();
+    cJSON_AddStringToObject(result, "file", job.File.c_str());
+    cJSON_AddStringToObject(result, "output", job.Output.c_str());
+    cJSON_AddStringToObject(result, "status", job.Success ? "ok" : "error");
+    if (!job.Success) {
+      cJSON_AddStringToObject(result, "error", job.ErrorMessage.c_str());
+    }
+    cJSON_AddItemToObject(result, "cache_hit", job.CacheHit ? cJSON_CreateTrue() : cJSON_CreateFalse());
+    cJSON_AddNumberToObject(result, "load_ms", job.LoadTime * 1000.0);
+    cJSON_AddNumberToObject(result, "render_ms", job.RenderTime * 1000.0);
+    cJSON_AddNumberToObject(result, "write_ms", job.WriteTime * 1000.0);
+    cJSON_AddItemToArray(jobs, result);
+  }
+  cJSON_AddItemToObject(json, "jobs", jobs);
+
+  // Written next to the result and renamed, so that a client polling for
+  // the result never reads it half written.
+  char* text = cJSON_Print(json);
+  const std::string temporaryPath = batch.ResultPath + ".tmp";
+  std::ofstream file(temporaryPath.c_str());
+  file << text << std::endl;
+  file.close();
+  free(text);
+  cJSON_Delete(json);
+
+  return file && rename(temporaryPath.c_str(), batch.ResultPath.c_str()) == 0;
+}
+
+//----------------------------------------------------------------------------
+// Precompute the value ranges of the arrays, which VTK otherwise computes and
+// stores on first use, so that workers only read shared data.
+void computeArrayRanges(vtkDataSet* dataSet)
+{
+  vtkFieldData* fields[2] = { dataSet->GetPointData(), dataSet->GetCellData() };
+  for (int i = 0; i < 2; ++i) {
+    for (int j = 0; j < fields[i]->GetNumberOfArrays(); ++j) {
+      vtkDataArray* array = fields[i]->GetArray(j);
+      if (!array) {
+        continue;
+      }
+      for (int component = -1; component < array->GetNumberOfComponents(); ++component) {
+        array->GetRange(component);
+      }
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Geometry holding the arrays of a cached geometry, which representations
+// can add their own arrays to.
+vesGeometryData::Ptr shareGeometry(vesGeometryData::Ptr geometry)
+{
+  vesGeometryData::Ptr shared(new vesGeometryData);
+  shared->setName(geometry->name());
+  for (unsigned int i = 0; i < geometry->numberOfSources(); ++i) {
+    shared->addSource(geometry->source(i));
+  }
+  for (unsigned int i = 0; i < geometry->numberOfPrimitiveTypes(); ++i) {
+    shared->addPrimitive(geometry->primitive(i));
+  }
+  return shared;
+}
+
+//----------------------------------------------------------------------------
+// Datasets loaded by the workers, by file name.  Polydata is kept converted
+// to geometry data.  The least recently used entries are dropped beyond the
+// maximum number of entries; jobs that still use them keep them alive.
+class GeometryCache
+{
+public:
+
+  struct Entry
+  {
+    Entry() : IsLoading(false), LastUse(0)
+    {
+    }
+
+    bool IsLoading;
+    unsigned long LastUse;
+    vtkSmartPointer<vtkDataSet> DataSet;
+    vtkSmartPointer<vtkPolyData> PolyData;
+    vesGeometryData::Ptr GeometryData;
+  };
+
+  GeometryCache() :
+    MaximumNumberOfEntries(32),
+    UseCount(0),
+    NumberOfHits(0),
+    NumberOfMisses(0)
+  {
+  }
+
+  void setMaximumNumberOfEntries(int number)
+  {
+    this->MaximumNumberOfEntries = number > 0 ? number : 1;
+  }
+
+  /// Return the entry of a file, loading it if it is not cached.  When
+  /// another worker is loading the file, wait for it.
+  bool get(const std::string& filename, bool errorOnMoreThan65kVertices,
+           Entry& entry, bool& hit, std::string& errorMessage)
+  {
+    this->Lock->Lock();
+    std::map<std::string, Entry>::iterator itr = this->Entries.find(filename);
+    while (itr != this->Entries.end() && itr->second.IsLoading) {
+      this->EntryLoaded->Wait(this->Lock.GetPointer());
+      itr = this->Entries.find(filename);
+    }
+
+    hit = itr != this->Entries.end();
+    if (hit) {
+      ++this->NumberOfHits;
+      itr->second.LastUse = ++this->UseCount;
+      entry = itr->second;
+      this->Lock->Unlock();
+      return true;
+    }
+
+    ++this->NumberOfMisses;
+    this->Entries[filename].IsLoading = true;
+    this->Lock->Unlock();
+
+    const bool success = this->load(filename, errorOnMoreThan65kVertices, entry, errorMessage);
+
+    this->Lock->Lock();
+    if (success) {
+      entry.LastUse = ++this->UseCount;
+      this->Entries[filename] = entry;
+      this->evict();
+    }
+    else {
+      // Failures are not cached, the file may be fixed by the next job.
+      this->Entries.erase(filename);
+    }
+    this->EntryLoaded->Broadcast();
+    this->Lock->Unlock();
+    return success;
+  }
+
+  unsigned long numberOfHits() const { return this->NumberOfHits; }
+  unsigned long numberOfMisses() const { return this->NumberOfMisses; }
+
+private:
+
+  bool load(const std::string& filename, bool errorOnMoreThan65kVertices,
+            Entry& entry, std::string& errorMessage)
+  {
+    vesKiwiDataLoader loader;
+    loader.setErrorOnMoreThan65kVertices(errorOnMoreThan65kVertices);
+    entry.DataSet = loader.loadDataset(filename);
+    if (!entry.DataSet) {
+      errorMessage = loader.errorTitle() + ": " + loader.errorMessage();
+      return false;
+    }
+
+    vtkPolyData* polyData = vtkPolyData::SafeDownCast(entry.DataSet);
+    if (polyData) {
+      entry.GeometryData = vesKiwiPolyDataRepresentation::PreparePolyData(polyData, entry.PolyData);
+      computeArrayRanges(entry.PolyData);
+    }
+    else {
+      computeArrayRanges(entry.DataSet);
+    }
+    return true;
+  }
+
+  void evict()
+  {
+    while (static_cast<int>(this->Entries.size()) > this->MaximumNumberOfEntries) {
+      std::map<std::string, Entry>::iterator oldest = this->Entries.end();
+      std::map<std::string, Entry>::iterator itr = this->Entries.begin();
+      for (; itr != this->Entries.end(); ++itr) {
+        if (!itr->second.IsLoading
+            && (oldest == this->Entries.end() || itr->second.LastUse < oldest->second.LastUse)) {
+          oldest = itr;
+        }
+      }
+      if (oldest == this->Entries.end()) {
+        return;
+      }
+      this->Entries.erase(oldest);
+    }
+  }
+
+  int MaximumNumberOfEntries;
+  unsigned long UseCount;
+  unsigned long NumberOfHits;
+  unsigned long NumberOfMisses;
+  std::map<std::string, Entry> Entries;
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> EntryLoaded;
+};
+
+//----------------------------------------------------------------------------
+class Server;
+
+struct Worker
+{
+  Worker() : Owner(0), SceneJobId(0), NumberOfTiles(0), BusyTime(0.0)
+  {
+  }
+
+  Server* Owner;
+  vesKiwiOffscreenContext::Ptr Context;
+  vesKiwiRenderServerApp::Ptr App;
+  // The job whose scene the app holds, or 0.
+  int SceneJobId;
+  int NumberOfTiles;
+  double BusyTime;
+};
+
+//----------------------------------------------------------------------------
+// A tile of a job.  The tiles of a job are numbered row by row from the top
+// left, and queued in that order so that its bands complete in order.
+struct Task
+{
+  Batch* Owner;
+  int JobIndex;
+  int TileIndex;
+};
+
+//----------------------------------------------------------------------------
+class Server
+{
+public:
+
+  Server() :
+    TileSize(2048),
+    NoMoreBatches(false),
+    LastJobId(0),
+    NumberOfJobs(0),
+    NumberOfFailedJobs(0),
+    StartTime(0.0)
+  {
+  }
+
+  ~Server()
+  {
+    for (std::list<Batch*>::iterator itr = this->Batches.begin(); itr != this->Batches.end(); ++itr) {
+      delete *itr;
+    }
+  }
+
+  /// Create the contexts and apps of the workers on the calling thread.
+  bool initialize(int numberOfThreads, int cacheEntries, int tileSize,
+                  const std::string& warmUpFile)
+  {
+    this->Cache.setMaximumNumberOfEntries(cacheEntries);
+    this->TileSize = tileSize;
+    this->WarmUpFile = warmUpFile;
+
+    this->Workers.resize(numberOfThreads);
+    for (int i = 0; i < numberOfThreads; ++i) {
+      Worker& worker = this->Workers[i];
+      worker.Owner = this;
+      // Jobs render into offscreen targets of their own size, so the default
+      // framebuffer of the context is not used.
+      worker.Context = vesKiwiOffscreenContext::Ptr(new vesKiwiOffscreenContext);
+      if (!worker.Context->initialize(16, 16)) {
+        std::cerr << "error: " << worker.Context->errorMessage() << std::endl;
+        return false;
+      }
+      worker.App = vesKiwiRenderServerApp::Ptr(new vesKiwiRenderServerApp);
+      worker.App->setLevelOfDetailIsEnabled(false);
+    }
+    return true;
+  }
+
+  void start()
+  {
+    this->StartTime = vesProfiler::currentTime();
+    for (size_t i = 0; i < this->Workers.size(); ++i) {
+      this->ThreadIds.push_back(this->MultiThreader->SpawnThread(workerLoop, &this->Workers[i]));
+    }
+  }
+
+  /// Queue the tiles of the jobs of a batch.  A batch without jobs is
+  /// finished at once.
+  void addBatch(Batch* batch)
+  {
+    if (batch->Jobs.empty()) {
+      this->finishBatch(batch);
+      return;
+    }
+
+    this->Lock->Lock();
+    this->Batches.push_back(batch);
+    for (size_t i = 0; i < batch->Jobs.size(); ++i) {
+      Job& job = batch->Jobs[i];
+      job.Id = ++this->LastJobId;
+      job.TileWidth = std::min(job.Width, this->TileSize);
+      job.TileHeight = std::min(job.Height, this->TileSize);
+      job.NumberOfColumns = (job.Width + job.TileWidth - 1) / job.TileWidth;
+      const int numberOfRows = (job.Height + job.TileHeight - 1) / job.TileHeight;
+      job.NumberOfTilesLeft = job.NumberOfColumns * numberOfRows;
+      job.Image = vesSharedPtr<TiledImage>(new TiledImage);
+      for (int tile = 0; tile < job.NumberOfTilesLeft; ++tile) {
+        Task task = { batch, static_cast<int>(i), tile };
+        this->PendingTasks.push_back(task);
+      }
+    }
+    this->TaskAdded->Broadcast();
+    this->Lock->Unlock();
+  }
+
+  bool isIdle()
+  {
+    this->Lock->Lock();
+    const bool idle = this->Batches.empty();
+    this->Lock->Unlock();
+    return idle;
+  }
+
+  /// Let the workers exit once the queued jobs are done, and wait for them.
+  void finish()
+  {
+    this->Lock->Lock();
+    this->NoMoreBatches = true;
+    this->TaskAdded->Broadcast();
+    this->Lock->Unlock();
+
+    for (size_t i = 0; i < this->ThreadIds.size(); ++i) {
+      this->MultiThreader->TerminateThread(this->ThreadIds[i]);
+    }
+    this->ThreadIds.clear();
+  }
+
+  void printStatistics(const std::string& statsFile)
+  {
+    const double wallTime = vesProfiler::currentTime() - this->StartTime;
+    const int numberOfThreads = static_cast<int>(this->Workers.size());
+    const double jobsPerSecond = wallTime > 0.0 ? this->NumberOfJobs / wallTime : 0.0;
+
+    double busyTime = 0.0;
+    int numberOfTiles = 0;
+    for (size_t i = 0; i < this->Workers.size(); ++i) {
+      busyTime += this->Workers[i].BusyTime;
+      numberOfTiles += this->Workers[i].NumberOfTiles;
+    }
+
+    std::cout << this->NumberOfJobs << " jobs (" << numberOfTiles << " tiles), "
+              << this->NumberOfFailedJobs << " failed, in "
+              << wallTime << " s on " << numberOfThreads << " threads: "
+              << jobsPerSecond << " jobs/s, " << jobsPerSecond / numberOfThreads
+              << " jobs/s per core, cache " << this->Cache.numberOfHits() << " hits "
+              << this->Cache.numberOfMisses() << " misses" << std::endl;
+
+    if (statsFile.empty()) {
+      return;
+    }
+
+    cJSON* json = cJSON_CreateObject();
+    cJSON_AddNumberToObject(json, "jobs", this->NumberOfJobs);
+    cJSON_AddNumberToObject(json, "failed_jobs", this->NumberOfFailedJobs);
+    cJSON_AddNumberToObject(json, "tiles", numberOfTiles);
+    cJSON_AddNumberToObject(json, "threads", numberOfThreads);
+    cJSON_AddNumberToObject(json, "wall_time_s", wallTime);
+    cJSON_AddNumberToObject(json, "jobs_per_second", jobsPerSecond);
+    cJSON_AddNumberToObject(json, "jobs_per_second_per_core", jobsPerSecond / numberOfThreads);
+    cJSON_AddNumberToObject(json, "worker_utilization",
+                            wallTime > 0.0 ? busyTime / (wallTime * numberOfThreads) : 0.0);
+    cJSON_AddNumberToObject(json, "cache_hits", this->Cache.numberOfHits());
+    cJSON_AddNumberToObject(json, "cache_misses", this->Cache.numberOfMisses());
+    char* text = cJSON_Print(json);
+    std::ofstream file(statsFile.c_str());
+    file << text << std::endl;
+    free(text);
+    cJSON_Delete(json);
+    if (!file) {
+      std::cerr << "error: could not write " << statsFile << std::endl;
+    }
+  }
+
+private:
+
+  static VTK_THREAD_RETURN_TYPE workerLoop(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    Worker* worker = static_cast<Worker*>(threadInfo->UserData);
+    worker->Owner->runWorker(*worker);
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  void runWorker(Worker& worker)
+  {
+    // The GL state cache of this thread's context.
+    vesGLStateCache stateCache;
+    stateCache.makeCurrent();
+    if (!worker.Context->makeCurrent()) {
+      std::cerr << "error: could not make the offscreen context current" << std::endl;
+      return;
+    }
+    worker.App->initGL();
+
+    // Link the shader programs before the first job.
+    if (!this->WarmUpFile.empty()) {
+      Job job;
+      job.File = this->WarmUpFile;
+      if (this->setUpScene(worker, job)) {
+        worker.App->renderImage(16, 16);
+      }
+      worker.App->resetScene();
+    }
+
+    while (true) {
+      this->Lock->Lock();
+      while (this->PendingTasks.empty() && !this->NoMoreBatches) {
+        this->TaskAdded->Wait(this->Lock.GetPointer());
+      }
+      if (this->PendingTasks.empty()) {
+        this->Lock->Unlock();
+        break;
+      }
+      const Task task = this->PendingTasks.front();
+      this->PendingTasks.pop_front();
+      Job& job = task.Owner->Jobs[task.JobIndex];
+      const bool jobFailed = !job.ErrorMessage.empty();
+      this->Lock->Unlock();
+
+      // The remaining tiles of a failed job are skipped.
+      const double start = vesProfiler::currentTime();
+      if (!jobFailed) {
+        this->renderTile(worker, job, task.TileIndex);
+      }
+      worker.BusyTime += vesProfiler::currentTime() - start;
+      ++worker.NumberOfTiles;
+
+      this->finishTile(task);
+    }
+
+    // Release the buffers of the last scene while the context is current.
+    worker.App->resetScene();
+    worker.Context->doneCurrent();
+  }
+
+  void renderTile(Worker& worker, Job& job, int tileIndex)
+  {
+    vesKiwiRenderServerApp& app = *worker.App;
+
+    // Consecutive tiles of a job rendered by a worker share its scene.
+    double start = vesProfiler::currentTime();
+    if (worker.SceneJobId != job.Id) {
+      worker.SceneJobId = 0;
+      if (!this->setUpScene(worker, job)) {
+        app.resetScene();
+        return;
+      }
+      worker.SceneJobId = job.Id;
+      this->addTime(job.LoadTime, vesProfiler::currentTime() - start);
+    }
+
+    const int maximumSize = app.glSupport()->maximumRenderSize();
+    if (job.TileWidth > maximumSize || job.TileHeight > maximumSize) {
+      std::stringstream message;
+      message << "tiles are larger than the maximum render size of " << maximumSize
+              << " pixels, see --tile-size";
+      this->failJob(job, message.str());
+      return;
+    }
+
+    // Tiles are counted from the top, the pixels of images from the bottom.
+    const int band = tileIndex / job.NumberOfColumns;
+    const int x = (tileIndex % job.NumberOfColumns) * job.TileWidth;
+    const int top = band * job.TileHeight;
+    const int width = std::min(job.TileWidth, job.Width - x);
+    const int height = std::min(job.TileHeight, job.Height - top);
+
+    start = vesProfiler::currentTime();
+    vesImage::Ptr image =
+      app.renderImageTile(job.Width, job.Height, x, job.Height - top - height, width, height);
+    this->addTime(job.RenderTime, vesProfiler::currentTime() - start);
+    if (!image) {
+      this->failJob(job, "rendering failed");
+      return;
+    }
+
+    start = vesProfiler::currentTime();
+    std::string errorMessage;
+    if (!this->addTile(job, band, x, image, errorMessage)) {
+      this->failJob(job, errorMessage);
+    }
+    this->addTime(job.WriteTime, vesProfiler::currentTime() - start);
+  }
+
+  /// Build the scene of a job in the worker's app and set up its view.
+  bool setUpScene(Worker& worker, Job& job)
+  {
+    vesKiwiRenderServerApp& app = *worker.App;
+    app.resetScene();
+
+    std::string errorMessage;
+    bool cacheHit = false;
+    const bool success = this->loadScene(app, job, errorMessage, cacheHit);
+
+    this->Lock->Lock();
+    if (!success && job.ErrorMessage.empty()) {
+      job.ErrorMessage = errorMessage;
+    }
+    // Later loads of the job by other workers always hit the cache.
+    if (success && !job.IsLoaded) {
+      job.IsLoaded = true;
+      job.CacheHit = cacheHit;
+    }
+    this->Lock->Unlock();
+    if (!success) {
+      return false;
+    }
+
+    // Scene files decode their background image on a thread; every tile
+    // needs it.
+    app.finishLoadingBackgroundTexture();
+    if (job.HasBackground) {
+      app.setBackgroundColor(job.Background[0], job.Background[1], job.Background[2]);
+    }
+    app.resizeView(job.Width, job.Height);
+    if (job.HasCameraPosition) {
+      app.setCameraPosition(job.Position);
+      app.setCameraFocalPoint(job.FocalPoint);
+      app.setCameraViewUp(job.ViewUp);
+    }
+    else if (job.HasViewDirection) {
+      app.resetView(job.ViewDirection, job.ViewUp);
+    }
+    else {
+      app.resetView();
+    }
+    return true;
+  }
+
+  bool loadScene(vesKiwiRenderServerApp& app, const Job& job,
+                 std::string& errorMessage, bool& cacheHit)
+  {
+    // Scene files, archives and the like are loaded by the app itself and
+    // not cached.
+    if (app.loadDatasetWithCustomBehavior(job.File)) {
+      return true;
+    }
+    if (!app.loadDatasetErrorMessage().empty()) {
+      errorMessage = app.loadDatasetErrorTitle() + ": " + app.loadDatasetErrorMessage();
+      return false;
+    }
+
+    GeometryCache::Entry entry;
+    if (!this->Cache.get(job.File, !app.glSupport()->isSupportedIndexUnsignedInt(),
+                         entry, cacheHit, errorMessage)) {
+      return false;
+    }
+
+    if (entry.GeometryData) {
+      vesKiwiPolyDataRepresentation::Ptr rep(new vesKiwiPolyDataRepresentation);
+      rep->initializeWithShader(app.shaderProgram());
+      rep->setShaderVariantCache(app.shaderVariantCache());
+      rep->setPreparedPolyData(entry.PolyData, shareGeometry(entry.GeometryData));
+      rep->addSelfToRenderer(app.renderer());
+      app.addManagedDataRepresentation(rep);
+    }
+    else {
+      // Representations connect the dataset to their filters, so each job
+      // gets its own dataset object sharing the cached arrays.
+      vtkSmartPointer<vtkDataSet> dataSet;
+      dataSet.TakeReference(entry.DataSet->NewInstance());
+      dataSet->ShallowCopy(entry.DataSet);
+      app.addRepresentationsForDataSet(dataSet);
+    }
+    return true;
+  }
+
+  /// Copy a tile into its band of the job's image, and write the bands that
+  /// are complete from the top down.
+  bool addTile(Job& job, int band, int x, vesImage::Ptr tile, std::string& errorMessage)
+  {
+    TiledImage& image = *job.Image;
+    const size_t rowSize = static_cast<size_t>(job.Width) * 3;
+
+    // Tiles are copied outside the lock: they do not overlap, and a band is
+    // only written and removed once all of its tiles were copied.
+    image.Lock->Lock();
+    TiledImage::Band& bandPixels = image.Bands[band];
+    if (bandPixels.Pixels.empty()) {
+      const int bandHeight = std::min(job.TileHeight, job.Height - band * job.TileHeight);
+      bandPixels.Pixels.resize(rowSize * bandHeight);
+    }
+    image.Lock->Unlock();
+
+    // RGBA with the bottom row first, to RGB with the top row first.
+    const int width = tile->width();
+    const int height = tile->height();
+    const unsigned char* tilePixels = static_cast<const unsigned char*>(tile->data());
+    for (int row = 0; row < height; ++row) {
+      const unsigned char* inPtr = tilePixels + static_cast<size_t>(height - 1 - row) * width * 4;
+      unsigned char* outPtr = &bandPixels.Pixels[row * rowSize + x * 3];
+      for (int i = 0; i < width; ++i, inPtr += 4, outPtr += 3) {
+        outPtr[0] = inPtr[0];
+        outPtr[1] = inPtr[1];
+        outPtr[2] = inPtr[2];
+      }
+    }
+
+    image.Lock->Lock();
+    ++bandPixels.NumberOfTiles;
+    bool success = true;
+    std::map<int, TiledImage::Band>::iterator next = image.Bands.find(image.NextBand);
+    while (success && next != image.Bands.end()
+           && next->second.NumberOfTiles == job.NumberOfColumns) {
+      if (image.NextBand == 0) {
+        success = image.Writer.open(job.Output, job.Width, job.Height);
+      }
+      const std::vector<unsigned char>& pixels = next->second.Pixels;
+      success = success
+        && image.Writer.writeRows(&pixels[0], static_cast<int>(pixels.size() / rowSize));
+      image.Bands.erase(next);
+      next = image.Bands.find(++image.NextBand);
+    }
+    if (!success) {
+      errorMessage = image.Writer.errorMessage();
+    }
+    image.Lock->Unlock();
+    return success;
+  }
+
+  void addTime(double& time, double duration)
+  {
+    this->Lock->Lock();
+    time += duration;
+    this->Lock->Unlock();
+  }
+
+  /// Record the first error of a job.  Its remaining tiles are skipped.
+  void failJob(Job& job, const std::string& errorMessage)
+  {
+    this->Lock->Lock();
+    if (job.ErrorMessage.empty()) {
+      job.ErrorMessage = errorMessage;
+    }
+    this->Lock->Unlock();
+  }
+
+  void finishTile(const Task& task)
+  {
+    Batch* batch = task.Owner;
+    Job& job = batch->Jobs[task.JobIndex];
+
+    this->Lock->Lock();
+    const bool jobIsDone = --job.NumberOfTilesLeft == 0;
+    this->Lock->Unlock();
+    if (!jobIsDone) {
+      return;
+    }
+
+    // No other worker uses the job anymore.  The file of a failed job is
+    // removed when its image is released.
+    if (job.ErrorMessage.empty() && !job.Image->Writer.close()) {
+      job.ErrorMessage = job.Image->Writer.errorMessage();
+    }
+    job.Success = job.ErrorMessage.empty();
+    job.Image.reset();
+
+    if (job.Success) {
+      std::cout << "ok " << job.Output << " (" << job.RenderTime * 1000.0 << " ms)" << std::endl;
+    }
+    else {
+      std::cout << "error " << job.File << ": " << job.ErrorMessage << std::endl;
+    }
+
+    this->Lock->Lock();
+    ++this->NumberOfJobs;
+    this->NumberOfFailedJobs += job.Success ? 0 : 1;
+    const bool batchIsDone = --batch->NumberOfPendingJobs == 0;
+    this->Lock->Unlock();
+
+    if (batchIsDone) {
+      this->finishBatch(batch);
+    }
+  }
+
+  void finishBatch(Batch* batch)
+  {
+    if (!batch->ResultPath.empty()) {
+      if (!writeBatchResult(*batch)) {
+        std::cerr << "error: could not write " << batch->ResultPath << std::endl;
+      }
+      remove(batch->Path.c_str());
+    }
+    else if (!batch->ErrorMessage.empty()) {
+      std::cout << "error " << batch->Path << ": " << batch->ErrorMessage << std::endl;
+    }
+
+    this->Lock->Lock();
+    this->Batches.remove(batch);
+    this->Lock->Unlock();
+    delete batch;
+  }
+
+  std::vector<Worker> Workers;
+  std::vector<int> ThreadIds;
+  GeometryCache Cache;
+  int TileSize;
+  std::string WarmUpFile;
+
+  std::list<Batch*> Batches;
+  std::list<Task> PendingTasks;
+  bool NoMoreBatches;
+  int LastJobId;
+  int NumberOfJobs;
+  int NumberOfFailedJobs;
+  double StartTime;
+
+  vtkNew<vtkMultiThreader> MultiThreader;
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> TaskAdded;
+};
+
+//----------------------------------------------------------------------------
+// Claim the batch files in the queue directory, oldest name first.  Returns
+// the number of batches queued.
+int pollQueue(Server& server, const std::string& directory)
+{
+  vtksys::Directory listing;
+  if (!listing.Load(directory.c_str())) {
+    return 0;
+  }
+
+  std::vector<std::string> names;
+  for (unsigned long i = 0; i < listing.GetNumberOfFiles(); ++i) {
+    const std::string name = listing.GetFile(i);
+    if (name[0] != '.' && vtksys::SystemTools::GetFilenameLastExtension(name) == ".json") {
+      names.push_back(name);
+    }
+  }
+  std::sort(names.begin(), names.end());
+
+  for (size_t i = 0; i < names.size(); ++i) {
+    // The rename is atomic, so several servers can share a queue.
+    const std::string path = directory + "/" + names[i];
+    const std::string claimedPath = path + ".running";
+    if (rename(path.c_str(), claimedPath.c_str()) != 0) {
+      continue;
+    }
+    server.addBatch(readBatch(claimedPath, path + ".done"));
+  }
+  return static_cast<int>(names.size());
+}
+
+//----------------------------------------------------------------------------
+void printUsage()
+{
+  std::cerr << "usage: ves_render_server [--threads n] [--cache-entries n] [--tile-size n]\n"
+            << "                         [--warm-up file] [--stats file.json]\n"
+            << "                         (--queue dir [--poll-ms ms] [--exit-when-idle]\n"
+            << "                          | batch.json...)" << std::endl;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int argc, char* argv[])
+{
+  int numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  int cacheEntries = 32;
+  int tileSize = 2048;
+  int pollInterval = 200;
+  bool exitWhenIdle = false;
+  std::string queueDirectory;
+  std::string warmUpFile;
+  std::string statsFile;
+  std::vector<std::string> batchFiles;
+
+  for (int i = 1; i < argc; ++i) {
+    std::string argument = argv[i];
+    bool hasValue = i + 1 < argc;
+    if (argument == "--threads" && hasValue) {
+      numberOfThreads = atoi(argv[++i]);
+    }
+    else if (argument == "--cache-entries" && hasValue) {
+      cacheEntries = atoi(argv[++i]);
+    }
+    else if (argument == "--tile-size" && hasValue) {
+      tileSize = std::max(16, atoi(argv[++i]));
+    }
+    else if (argument == "--queue" && hasValue) {
+      queueDirectory = argv[++i];
+    }
+    else if (argument == "--poll-ms" && hasValue) {
+      pollInterval = atoi(argv[++i]);
+    }
+    else if (argument == "--exit-when-idle") {
+      exitWhenIdle = true;
+    }
+    else if (argument == "--warm-up" && hasValue) {
+      warmUpFile = argv[++i];
+    }
+    else if (argument == "--stats" && hasValue) {
+      statsFile = argv[++i];
+    }
+    else if (argument[0] != '-') {
+      batchFiles.push_back(argument);
+    }
+    else {
+      printUsage();
+      return 1;
+    }
+  }
+
+  if (queueDirectory.empty() == batchFiles.empty()) {
+    printUsage();
+    return 1;
+  }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, VTK_MAX_THREADS));
+
+  // Each worker renders on one core.  Mesa's llvmpipe would otherwise start
+  // as many rasterizer threads as there are cores in every context.
+  if (numberOfThreads > 1 && !getenv("LP_NUM_THREADS")) {
+    vtksys::SystemTools::PutEnv("LP_NUM_THREADS=1");
+  }
+
+  Server server;
+  if (!server.initialize(numberOfThreads, cacheEntries, tileSize, warmUpFile)) {
+    return 1;
+  }
+  server.start();
+
+  if (!batchFiles.empty()) {
+    for (size_t i = 0; i < batchFiles.size(); ++i) {
+      server.addBatch(readBatch(batchFiles[i], std::string()));
+    }
+  }
+  else {
+    signal(SIGINT, requestStop);
+    signal(SIGTERM, requestStop);
+    while (!stopRequested) {
+      const int numberOfBatches = pollQueue(server, queueDirectory);
+      if (exitWhenIdle && !numberOfBatches && server.isIdle()) {
+        break;
+      }
+      vtksys::SystemTools::Delay(pollInterval);
+    }
+  }
+
+  server.finish();
+  server.printStatistics(statsFile);
+  return 0;
+}
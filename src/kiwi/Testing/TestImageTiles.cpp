@@ -0,0 +1,194 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test renders an image over a gradient background in tiles, stitches
+// them band by band with vesKiwiStreamingImageWriter, and checks that the
+// file matches the same image rendered in a single pass.
+
+#include <vesBackground.h>
+#include <vesImage.h>
+#include <vesKiwiStreamingImageWriter.h>
+#include <vesKiwiTestHelper.h>
+#include <vesKiwiViewerApp.h>
+#include <vesRenderer.h>
+
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPNGReader.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+class MyTestHelper : public vesKiwiTestHelper {
+public:
+
+  MyTestHelper()
+  {
+    mKiwiApp = vesKiwiViewerApp::Ptr(new vesKiwiViewerApp);
+    this->setApp(mKiwiApp);
+  }
+
+  bool initTesting()
+  {
+    // Each tile draws its part of the gradient.
+    mKiwiApp->renderer()->background()->setGradientColor(
+      vesVector3f(0.1f, 0.2f, 0.3f), vesVector3f(0.6f, 0.5f, 0.4f));
+
+    std::string filename = this->sourceDirectory() +
+      std::string("/Apps/iOS/Kiwi/Kiwi/Data/bunny.vtp");
+    if (!mKiwiApp->loadDataset(filename)) {
+      printf("load data error: %s: %s\n", mKiwiApp->loadDatasetErrorTitle().c_str(),
+             mKiwiApp->loadDatasetErrorMessage().c_str());
+      return false;
+    }
+    return true;
+  }
+
+  bool writeTiledImage(const std::string& filename, int width, int height, int tileSize)
+  {
+    vesKiwiStreamingImageWriter writer;
+    if (!writer.open(filename, width, height)) {
+      printf("failed to open %s: %s\n", filename.c_str(), writer.errorMessage().c_str());
+      return false;
+    }
+
+    // The file is written top row first, tiles come bottom row first.
+    std::vector<unsigned char> band(static_cast<size_t>(width) * tileSize * 3);
+    for (int bandTop = 0; bandTop < height; bandTop += tileSize) {
+      const int bandHeight = std::min(tileSize, height - bandTop);
+      const int y = height - bandTop - bandHeight;
+      for (int x = 0; x < width; x += tileSize) {
+        const int tileWidth = std::min(tileSize, width - x);
+        vesImage::Ptr tile = mKiwiApp->renderImageTile(width, height, x, y, tileWidth, bandHeight);
+        if (!tile || tile->width() != tileWidth || tile->height() != bandHeight) {
+          printf("failed to render the tile at %d, %d\n", x, y);
+          return false;
+        }
+
+        const unsigned char* pixels = static_cast<const unsigned char*>(tile->data());
+        for (int row = 0; row < bandHeight; ++row) {
+          const unsigned char* source = pixels + static_cast<size_t>(bandHeight - 1 - row) * tileWidth * 4;
+          unsigned char* destination = &band[(static_cast<size_t>(row) * width + x) * 3];
+          for (int i = 0; i < tileWidth; ++i) {
+            destination[3*i] = source[4*i];
+            destination[3*i + 1] = source[4*i + 1];
+            destination[3*i + 2] = source[4*i + 2];
+          }
+        }
+      }
+
+      if (!writer.writeRows(&band[0], bandHeight)) {
+        printf("failed to write %s: %s\n", filename.c_str(), writer.errorMessage().c_str());
+        return false;
+      }
+    }
+
+    return writer.close();
+  }
+
+  bool compareWithImage(const std::string& filename, vesImage::Ptr image)
+  {
+    vtkNew<vtkPNGReader> reader;
+    reader->SetFileName(filename.c_str());
+    reader->Update();
+    vtkImageData* stitched = reader->GetOutput();
+
+    int dimensions[3];
+    stitched->GetDimensions(dimensions);
+    if (dimensions[0] != image->width() || dimensions[1] != image->height()
+        || stitched->GetNumberOfScalarComponents() != 3) {
+      printf("the stitched image has the wrong size\n");
+      return false;
+    }
+
+    // Both are stored bottom row first.
+    const unsigned char* expected = static_cast<const unsigned char*>(image->data());
+    const unsigned char* actual = static_cast<const unsigned char*>(stitched->GetScalarPointer(0, 0, 0));
+    int maximumDifference = 0;
+    for (int i = 0; i < image->width() * image->height(); ++i) {
+      for (int c = 0; c < 3; ++c) {
+        maximumDifference = std::max(maximumDifference, abs(expected[4*i + c] - actual[3*i + c]));
+      }
+    }
+
+    // Allow for rounding in the interpolation of vertex attributes.
+    printf("maximum difference between the stitched and single pass image: %d\n", maximumDifference);
+    return maximumDifference <= 2;
+  }
+
+  bool testWriterErrors()
+  {
+    const std::string filename = "TestImageTilesIncomplete.png";
+    std::vector<unsigned char> rows(16 * 8 * 3, 128);
+
+    vesKiwiStreamingImageWriter writer;
+    if (!writer.open(filename, 16, 16) || !writer.writeRows(&rows[0], 8)) {
+      printf("failed to write %s\n", filename.c_str());
+      return false;
+    }
+    if (writer.writeRows(&rows[0], 8) && writer.writeRows(&rows[0], 1)) {
+      printf("writing more rows than the image has did not fail\n");
+      return false;
+    }
+    if (vtksys::SystemTools::FileExists(filename.c_str())) {
+      printf("a failed image was not removed\n");
+      return false;
+    }
+
+    if (!writer.open(filename, 16, 16) || !writer.writeRows(&rows[0], 8) || writer.close()) {
+      printf("closing an incomplete image did not fail\n");
+      return false;
+    }
+    if (vtksys::SystemTools::FileExists(filename.c_str())) {
+      printf("an incomplete image was not removed\n");
+      return false;
+    }
+    return true;
+  }
+
+  bool doTesting()
+  {
+    // Sizes that are not multiples of the tile size leave partial tiles on
+    // the right and top.
+    const int width = 301;
+    const int height = 203;
+    const std::string filename = "TestImageTiles.png";
+
+    vesImage::Ptr image = mKiwiApp->renderImage(width, height);
+    bool testPassed = image && this->writeTiledImage(filename, width, height, 128)
+      && this->compareWithImage(filename, image);
+    vtksys::SystemTools::RemoveFile(filename.c_str());
+
+    testPassed = this->testWriterErrors() && testPassed;
+    return testPassed;
+  }
+
+  vesKiwiViewerApp::Ptr mKiwiApp;
+};
+
+
+int main(int argc, char *argv[])
+{
+  MyTestHelper helper;
+  return vesKiwiTestHelper::main(argc, argv, helper);
+}
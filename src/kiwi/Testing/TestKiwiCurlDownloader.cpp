@@ -0,0 +1,289 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test runs a minimal HTTP server on the loopback interface and checks
+// that vesKiwiCurlDownloader fetches files with parallel range requests,
+// falls back to a single request when ranges are not supported, verifies
+// md5 checksums, and resumes an interrupted or killed download.
+
+#include <vesKiwiCurlDownloader.h>
+#include <vesSetGet.h>
+
+#include "vesKiwiTestHTTPServer.h"
+
+#include <vtksys/SystemTools.hxx>
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+namespace {
+
+class TestServer : public vesKiwiTestHTTPServer
+{
+public:
+
+  TestServer() : AcceptRanges(true), MaxBytesPerResponse(-1), BytesServed(0)
+  {
+  }
+
+  std::string Payload;
+  bool AcceptRanges;
+  long long MaxBytesPerResponse;
+  long long BytesServed;
+
+protected:
+
+  void handleRequest(int fd, const std::string& request, const std::string& body)
+  {
+    vesNotUsed(body);
+
+    const bool isHead = request.compare(0, 4, "HEAD") == 0;
+    const long long size = static_cast<long long>(this->Payload.size());
+    long long begin = 0;
+    long long end = size - 1;
+    bool isRange = false;
+
+    std::string range = headerValue(request, "Range:");
+    if (!range.empty() && this->AcceptRanges) {
+      isRange = true;
+      begin = atoll(range.c_str() + 6);
+      end = atoll(range.c_str() + range.find('-') + 1);
+    }
+
+    std::stringstream header;
+    header << (isRange ? "HTTP/1.1 206 Partial Content\r\n" : "HTTP/1.1 200 OK\r\n");
+    header << "Content-Length: " << (end - begin + 1) << "\r\n";
+    if (this->AcceptRanges) {
+      header << "Accept-Ranges: bytes\r\n";
+    }
+    if (isRange) {
+      header << "Content-Range: bytes " << begin << "-" << end << "/" << size << "\r\n";
+    }
+    header << "Connection: close\r\n\r\n";
+
+    if (!sendAll(fd, header.str()) || isHead) {
+      return;
+    }
+
+    long long length = end - begin + 1;
+    if (this->MaxBytesPerResponse >= 0 && length > this->MaxBytesPerResponse) {
+      length = this->MaxBytesPerResponse;
+    }
+
+    if (sendAll(fd, this->Payload.c_str() + begin, length)) {
+      this->BytesServed += length;
+    }
+  }
+};
+
+std::string readFile(const std::string& filename)
+{
+  std::ifstream file(filename.c_str(), std::ios::in | std::ios::binary);
+  std::stringstream contents;
+  contents << file.rdbuf();
+  return contents.str();
+}
+
+// Number of ranges a saved download state marks as complete.
+int completedRanges(const std::string& stateFile)
+{
+  std::ifstream state(stateFile.c_str());
+  std::string url;
+  long long totalSize = 0;
+  size_t numberOfRanges = 0;
+  std::getline(state, url);
+  state >> totalSize >> numberOfRanges;
+
+  int completed = 0;
+  long long begin, end, done;
+  for (size_t i = 0; i < numberOfRanges && state >> begin >> end >> done; ++i) {
+    if (begin + done == end + 1) {
+      ++completed;
+    }
+  }
+  return completed;
+}
+
+void copyFile(const std::string& source, const std::string& destination)
+{
+  std::ofstream file(destination.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  const std::string contents = readFile(source);
+  file.write(contents.c_str(), contents.size());
+}
+
+// Copies the partial download as soon as the state of a completed range is
+// on disk, which is what a process killed at that moment leaves behind.
+class SnapshotDelegate : public vesKiwiCurlDownloader::ProgressDelegate
+{
+public:
+
+  SnapshotDelegate(const std::string& destFile) : DestFile(destFile), HasSnapshot(false)
+  {
+  }
+
+  virtual int downloadProgress(double totalToDownload, double nowDownloaded)
+  {
+    vesNotUsed(totalToDownload);
+    vesNotUsed(nowDownloaded);
+    const std::string partFile = this->DestFile + ".part";
+    const std::string stateFile = partFile + ".ranges";
+    if (!this->HasSnapshot && completedRanges(stateFile) > 0) {
+      copyFile(partFile, partFile + ".snapshot");
+      copyFile(stateFile, stateFile + ".snapshot");
+      this->HasSnapshot = true;
+    }
+    return 0;
+  }
+
+  std::string DestFile;
+  bool HasSnapshot;
+};
+
+bool check(bool condition, const char* message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message);
+  }
+  return condition;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  TestServer server;
+  server.Payload.resize(1024*1024 + 17);
+  for (size_t i = 0; i < server.Payload.size(); ++i) {
+    server.Payload[i] = static_cast<char>((i * 7919) >> 3);
+  }
+
+  if (!server.start()) {
+    printf("failed to start the test server\n");
+    return 1;
+  }
+
+  const std::string url = server.url("/payload.bin");
+
+  const std::string destFile = "TestKiwiCurlDownloader.bin";
+  const std::string payloadFile = destFile + ".expected";
+  {
+    std::ofstream file(payloadFile.c_str(), std::ios::out | std::ios::binary);
+    file.write(server.Payload.c_str(), server.Payload.size());
+  }
+  const std::string md5 = vesKiwiCurlDownloader::computeFileMD5(payloadFile);
+
+  bool testPassed = true;
+
+  // parallel ranged download with a matching checksum
+  {
+    vesKiwiCurlDownloader downloader;
+    downloader.setNumberOfConnections(4);
+    downloader.setExpectedMD5(md5);
+    testPassed &= check(downloader.downloadUrlToFile(url, destFile), "ranged download");
+    testPassed &= check(readFile(destFile) == server.Payload, "ranged download contents");
+    vtksys::SystemTools::RemoveFile(destFile.c_str());
+  }
+
+  // a checksum mismatch fails and leaves no file behind
+  {
+    vesKiwiCurlDownloader downloader;
+    downloader.setNumberOfConnections(4);
+    downloader.setExpectedMD5("00000000000000000000000000000000");
+    testPassed &= check(!downloader.downloadUrlToFile(url, destFile), "checksum mismatch");
+    testPassed &= check(!vtksys::SystemTools::FileExists(destFile.c_str()), "checksum mismatch removes file");
+
+    // the checksum only applied to the previous download
+    testPassed &= check(downloader.downloadUrlToFile(url, destFile), "checksum cleared after download");
+    vtksys::SystemTools::RemoveFile(destFile.c_str());
+  }
+
+  // an interrupted download is resumed from the bytes already received
+  {
+    vesKiwiCurlDownloader downloader;
+    downloader.setNumberOfConnections(4);
+    downloader.setResumeEnabled(true);
+    downloader.setExpectedMD5(md5);
+
+    server.MaxBytesPerResponse = 100000;
+    testPassed &= check(!downloader.downloadUrlToFile(url, destFile), "interrupted download");
+
+    server.MaxBytesPerResponse = -1;
+    server.BytesServed = 0;
+    downloader.setExpectedMD5(md5);
+    testPassed &= check(downloader.downloadUrlToFile(url, destFile), "resumed download");
+    testPassed &= check(server.BytesServed == static_cast<long long>(server.Payload.size()) - 4*100000,
+                        "resumed download only fetches missing bytes");
+    testPassed &= check(readFile(destFile) == server.Payload, "resumed download contents");
+    vtksys::SystemTools::RemoveFile(destFile.c_str());
+  }
+
+  // a killed download is resumed from the state saved as ranges completed
+  {
+    const std::string partFile = destFile + ".part";
+    const std::string stateFile = partFile + ".ranges";
+    vesSharedPtr<SnapshotDelegate> delegate(new SnapshotDelegate(destFile));
+
+    vesKiwiCurlDownloader downloader;
+    downloader.setNumberOfConnections(4);
+    downloader.setResumeEnabled(true);
+    downloader.setProgressDelegate(delegate);
+    testPassed &= check(downloader.downloadUrlToFile(url, destFile), "download with saved state");
+    testPassed &= check(delegate->HasSnapshot, "state saved while downloading");
+    vtksys::SystemTools::RemoveFile(destFile.c_str());
+
+    if (delegate->HasSnapshot) {
+      vtksys::SystemTools::RenameFile((partFile + ".snapshot").c_str(), partFile.c_str());
+      vtksys::SystemTools::RenameFile((stateFile + ".snapshot").c_str(), stateFile.c_str());
+
+      vesKiwiCurlDownloader resumer;
+      resumer.setNumberOfConnections(4);
+      resumer.setResumeEnabled(true);
+      resumer.setExpectedMD5(md5);
+      server.BytesServed = 0;
+      testPassed &= check(resumer.downloadUrlToFile(url, destFile), "download resumed after kill");
+      testPassed &= check(server.BytesServed < static_cast<long long>(server.Payload.size()),
+                          "download resumed after kill skips saved ranges");
+      testPassed &= check(readFile(destFile) == server.Payload, "download resumed after kill contents");
+      vtksys::SystemTools::RemoveFile(destFile.c_str());
+    }
+  }
+
+  // servers without range support fall back to a single request
+  {
+    server.AcceptRanges = false;
+    vesKiwiCurlDownloader downloader;
+    downloader.setNumberOfConnections(4);
+    downloader.setExpectedMD5(md5);
+    testPassed &= check(downloader.downloadUrlToFile(url, destFile), "serial download");
+    testPassed &= check(readFile(destFile) == server.Payload, "serial download contents");
+    vtksys::SystemTools::RemoveFile(destFile.c_str());
+  }
+
+  server.stop();
+  vtksys::SystemTools::RemoveFile(payloadFile.c_str());
+
+  return testPassed ? 0 : 1;
+}
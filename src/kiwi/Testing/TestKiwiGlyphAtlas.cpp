@@ -0,0 +1,224 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test checks the text layout of vesKiwiGlyphAtlas and the quad
+// capacity of the geometry it creates.  Nothing is rendered, so it runs
+// without a GL context.
+
+#include <vesKiwiGlyphAtlas.h>
+#include <vesGeometryData.h>
+#include <vesPrimitive.h>
+#include <vesSourceData.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool check(bool condition, const char* message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message);
+  }
+  return condition;
+}
+
+std::vector<vesVertexDataP3T3C3f> layout(const vesKiwiGlyphAtlas& atlas, const std::string& text,
+                                         const vesVector2f& position, float scale = 1.0f)
+{
+  std::vector<vesVertexDataP3T3C3f> vertices;
+  atlas.appendText(text, position, vesVector3f(1.0f, 0.5f, 0.25f), scale, vertices);
+  return vertices;
+}
+
+bool isSameQuad(const vesVertexDataP3T3C3f* a, const vesVertexDataP3T3C3f* b)
+{
+  for (int i = 0; i < 4; ++i) {
+    if (a[i].m_position != b[i].m_position
+        || a[i].m_texureCoordinates != b[i].m_texureCoordinates) {
+      return false;
+    }
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool testTextSize(const vesKiwiGlyphAtlas& atlas)
+{
+  bool testPassed = true;
+
+  const vesVector2f a = atlas.textSize("a");
+  const vesVector2f b = atlas.textSize("b");
+  testPassed &= check(a[0] > 0.0f && a[1] > 0.0f, "size of one character");
+  testPassed &= check(atlas.textSize("")[0] == 0.0f && atlas.textSize("")[1] == a[1],
+                      "an empty string is one empty line");
+  testPassed &= check(atlas.textSize("ab") == vesVector2f(a[0] + b[0], a[1]),
+                      "advances add up along a line");
+  testPassed &= check(atlas.textSize("ab", 2.0f) == 2.0f * atlas.textSize("ab"),
+                      "size scales with the text");
+
+  // The box is as wide as the longest line and grows by a line height per line.
+  const vesVector2f lines = atlas.textSize("ab\na\n");
+  testPassed &= check(lines[0] == a[0] + b[0], "width of the longest line");
+  testPassed &= check(lines[1] == a[1] + 2 * atlas.lineHeight(), "height of three lines");
+
+  // Characters outside printable ASCII are measured as '?'.
+  testPassed &= check(atlas.textSize("\xe9\t") == atlas.textSize("??"), "unprintable characters");
+  return testPassed;
+}
+
+//----------------------------------------------------------------------------
+bool testAppendText(const vesKiwiGlyphAtlas& atlas)
+{
+  bool testPassed = true;
+
+  const vesVector2f origin(10.0f, 20.0f);
+  const std::vector<vesVertexDataP3T3C3f> ab = layout(atlas, "ab", origin);
+  testPassed &= check(ab.size() == 8, "a quad per character");
+  if (ab.size() != 8) {
+    return false;
+  }
+
+  // The second character starts where the advance of the first ends.
+  const std::vector<vesVertexDataP3T3C3f> a = layout(atlas, "a", origin);
+  const std::vector<vesVertexDataP3T3C3f> b =
+    layout(atlas, "b", origin + vesVector2f(atlas.textSize("a")[0], 0.0f));
+  testPassed &= check(isSameQuad(&ab[0], &a[0]), "first quad of a line");
+  testPassed &= check(isSameQuad(&ab[4], &b[0]), "quad after an advance");
+
+  // Lines go down from the first, and the last line sits on the position.
+  const std::vector<vesVertexDataP3T3C3f> lines = layout(atlas, "a\nb", origin);
+  const std::vector<vesVertexDataP3T3C3f> raised =
+    layout(atlas, "a", origin + vesVector2f(0.0f, static_cast<float>(atlas.lineHeight())));
+  const std::vector<vesVertexDataP3T3C3f> last = layout(atlas, "b", origin);
+  testPassed &= check(lines.size() == 8, "newlines have no quad");
+  testPassed &= check(lines.size() == 8 && isSameQuad(&lines[0], &raised[0]), "first of two lines");
+  testPassed &= check(lines.size() == 8 && isSameQuad(&lines[4], &last[0]), "last of two lines");
+
+  // Quads scale about the position.  The third texture coordinate is the
+  // distance field edge width, which narrows as the text grows.
+  const std::vector<vesVertexDataP3T3C3f> scaled = layout(atlas, "a", vesVector2f(0.0f, 0.0f), 2.0f);
+  const std::vector<vesVertexDataP3T3C3f> unscaled = layout(atlas, "a", vesVector2f(0.0f, 0.0f));
+  bool isScaled = scaled.size() == 4;
+  for (size_t i = 0; isScaled && i < 4; ++i) {
+    isScaled = scaled[i].m_position == 2.0f * unscaled[i].m_position
+      && scaled[i].m_texureCoordinates[0] == unscaled[i].m_texureCoordinates[0]
+      && scaled[i].m_texureCoordinates[1] == unscaled[i].m_texureCoordinates[1]
+      && scaled[i].m_texureCoordinates[2] <= unscaled[i].m_texureCoordinates[2];
+  }
+  testPassed &= check(isScaled, "scaled quad");
+
+  testPassed &= check(ab[0].m_color == vesVector3f(1.0f, 0.5f, 0.25f), "vertex color");
+
+  const std::vector<vesVertexDataP3T3C3f> unprintable = layout(atlas, "\xe9", origin);
+  const std::vector<vesVertexDataP3T3C3f> question = layout(atlas, "?", origin);
+  testPassed &= check(unprintable.size() == 4 && isSameQuad(&unprintable[0], &question[0]),
+                      "unprintable characters are drawn as '?'");
+  return testPassed;
+}
+
+//----------------------------------------------------------------------------
+bool checkGeometry(vesGeometryData::Ptr geometry, vesPrimitive::Ptr triangles,
+                   unsigned int numberOfQuads, unsigned int capacity, const char* message)
+{
+  vesSourceDataP3T3C3f::Ptr source = std::tr1::dynamic_pointer_cast<vesSourceDataP3T3C3f>(
+    geometry->sourceData(vesVertexAttributeKeys::Position));
+  bool isValid = source && geometry->primitive(0) == triangles
+    && triangles->numberOfIndices() == 6 * capacity
+    && source->sizeOfArray() == 4 * capacity;
+
+  // Quads past the text are degenerate.
+  for (unsigned int i = 4 * numberOfQuads; isValid && i < 4 * capacity; ++i) {
+    isValid = source->arrayReference()[i].m_position == vesVector3f(0.0f, 0.0f, 0.0f);
+  }
+
+  if (!isValid) {
+    printf("failed: %s, expected %u quads in room for %u\n", message, numberOfQuads, capacity);
+  }
+  return isValid;
+}
+
+bool testCreateGeometry(const vesKiwiGlyphAtlas& atlas)
+{
+  bool testPassed = true;
+  const std::vector<vesVertexDataP3T3C3f> quad = layout(atlas, "a", vesVector2f(0.0f, 0.0f));
+  if (!check(quad.size() == 4, "quad of a character")) {
+    return false;
+  }
+
+  std::vector<vesVertexDataP3T3C3f> vertices;
+  for (int i = 0; i < 3; ++i) {
+    vertices.insert(vertices.end(), quad.begin(), quad.end());
+  }
+
+  vesPrimitive::Ptr triangles;
+  vesGeometryData::Ptr geometry = vesKiwiGlyphAtlas::createGeometry(vertices, triangles);
+  testPassed &= checkGeometry(geometry, triangles, 3, 16, "initial capacity");
+
+  // The indices are kept while the text fits.
+  vesPrimitive::Ptr previous = triangles;
+  vertices.resize(4 * 16, quad[0]);
+  geometry = vesKiwiGlyphAtlas::createGeometry(vertices, triangles);
+  testPassed &= check(triangles == previous, "indices kept while the text fits");
+  testPassed &= checkGeometry(geometry, triangles, 16, 16, "full capacity");
+
+  // and double when it outgrows them.
+  vertices.resize(4 * 40, quad[0]);
+  geometry = vesKiwiGlyphAtlas::createGeometry(vertices, triangles);
+  testPassed &= check(triangles != previous, "indices replaced when the text outgrows them");
+  testPassed &= checkGeometry(geometry, triangles, 40, 64, "grown capacity");
+
+  vertices.resize(4 * 8, quad[0]);
+  previous = triangles;
+  geometry = vesKiwiGlyphAtlas::createGeometry(vertices, triangles);
+  testPassed &= check(triangles == previous, "indices kept when the text shrinks");
+  testPassed &= checkGeometry(geometry, triangles, 8, 64, "shrunk text");
+
+  // Unsigned short indices address at most 16383 quads, the rest is dropped.
+  vertices.resize(4 * 20000, quad[0]);
+  geometry = vesKiwiGlyphAtlas::createGeometry(vertices, triangles);
+  testPassed &= checkGeometry(geometry, triangles, 16383, 16383, "maximum capacity");
+  return testPassed;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  bool testPassed = true;
+  const bool distanceFields[] = { false, true };
+  for (int i = 0; i < 2; ++i) {
+    vesKiwiGlyphAtlas atlas;
+    if (!atlas.initialize(32, distanceFields[i])) {
+      printf("failed to rasterize the font\n");
+      return 1;
+    }
+    testPassed &= check(atlas.fontSize() == 32 && atlas.lineHeight() > 0, "font metrics");
+    testPassed &= testTextSize(atlas);
+    testPassed &= testAppendText(atlas);
+  }
+
+  vesKiwiGlyphAtlas atlas;
+  testPassed &= atlas.initialize(32) && testCreateGeometry(atlas);
+  return testPassed ? 0 : 1;
+}
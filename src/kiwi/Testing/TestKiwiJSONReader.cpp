@@ -0,0 +1,264 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test checks the tokens produced by vesKiwiJSONReader, then generates
+// a scene with thousands of objects and compares the reader against cJSON
+// for both the values read and the time taken.
+
+#include <vesKiwiJSONReader.h>
+#include <vesSetGet.h>
+#include <cJSON.h>
+
+#include <vtkTimerLog.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool check(bool condition, const char* message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message);
+  }
+  return condition;
+}
+
+bool testTokens()
+{
+  const std::string json =
+    "{\"name\": \"a\\\"b\\\\c\\n\\u00e9\\ud83d\\ude00\","
+    " \"numbers\": [0, -1.5e3, 1e-2, 42, 3.25],"
+    " \"flags\": [true, false, null],"
+    " \"skipped\": {\"nested\": [1, {\"x\": \"]}\"}, [[]]]},"
+    " \"raw\": {\"a\": [1, 2]},"
+    " \"count\": 7}";
+
+  vesKiwiJSONReader reader(json.c_str(), json.size());
+  bool testPassed = true;
+
+  testPassed &= check(reader.peek() == vesKiwiJSONReader::BeginObject, "begin object");
+  reader.beginObject();
+
+  testPassed &= check(reader.nextName() == "name", "first name");
+  testPassed &= check(reader.nextString() == "a\"b\\c\n\xc3\xa9\xf0\x9f\x98\x80", "string escapes");
+
+  testPassed &= check(reader.nextName() == "numbers", "numbers name");
+  std::vector<double> numbers = reader.nextDoubleArray();
+  testPassed &= check(numbers.size() == 5, "number count");
+  testPassed &= check(numbers.size() == 5 && numbers[0] == 0 && numbers[1] == -1500
+                      && std::fabs(numbers[2] - 0.01) < 1e-15 && numbers[3] == 42
+                      && numbers[4] == 3.25, "number values");
+
+  testPassed &= check(reader.nextName() == "flags", "flags name");
+  reader.beginArray();
+  testPassed &= check(reader.peek() == vesKiwiJSONReader::Boolean && reader.nextBool(), "true");
+  testPassed &= check(!reader.nextBool(), "false");
+  testPassed &= check(reader.nextNull(), "null");
+  testPassed &= check(!reader.hasNext(), "end of flags");
+  reader.endArray();
+
+  // skipping a name skips its value too, brackets inside strings are ignored
+  testPassed &= check(reader.nextName() == "skipped", "skipped name");
+  reader.skipValue();
+
+  testPassed &= check(reader.nextName() == "raw", "raw name");
+  const char* data = 0;
+  size_t length = 0;
+  testPassed &= check(reader.nextRawValue(data, length), "raw value");
+  testPassed &= check(std::string(data, length) == "{\"a\": [1, 2]}", "raw value span");
+
+  testPassed &= check(reader.nextName() == "count", "count name");
+  testPassed &= check(reader.nextInt() == 7, "count value");
+  testPassed &= check(!reader.hasNext(), "end of object");
+  reader.endObject();
+
+  testPassed &= check(reader.peek() == vesKiwiJSONReader::EndDocument, "end of document");
+  testPassed &= check(!reader.hasError(), reader.errorMessage().c_str());
+
+  // malformed input reports an error instead of reading past the buffer
+  const std::string truncated = "{\"a\": [1, 2";
+  vesKiwiJSONReader badReader(truncated.c_str(), truncated.size());
+  badReader.beginObject();
+  badReader.nextName();
+  badReader.nextDoubleArray();
+  testPassed &= check(badReader.hasError(), "truncated input");
+
+  return testPassed;
+}
+
+// Builds a scene in the format read by vesKiwiSceneRepresentation.
+std::string makeScene(int numberOfObjects)
+{
+  std::stringstream scene;
+  scene.precision(10);
+  scene << "{\"background_color\": [0.1, 0.2, 0.3],\n"
+        << " \"camera\": {\"position\": [0, 0, 10], \"focal_point\": [0, 0, 0], \"view_up\": [0, 1, 0]},\n"
+        << " \"objects\": [\n";
+  for (int i = 0; i < numberOfObjects; ++i) {
+    scene << (i ? ",\n" : "")
+          << "  {\"filename\": \"data/object_" << i << ".vtp\","
+          << " \"name\": \"Object \\\"" << i << "\\\"\","
+          << " \"color\": [" << (i % 7) / 7.0 << ", " << (i % 11) / 11.0 << ", " << (i % 13) / 13.0 << "],"
+          << " \"opacity\": " << 1.0 - (i % 10) / 20.0 << ","
+          << " \"transform\": [1, 0, 0, " << i << ", 0, 1, 0, " << -i << ", 0, 0, 1, 0.5, 0, 0, 0, 1],"
+          << " \"visible\": " << ((i % 3) ? "true" : "false") << ","
+          << " \"metadata\": {\"author\": \"kiwi\", \"tags\": [\"a\", \"b\", {\"c\": [1, 2, 3]}]}}";
+  }
+  scene << "\n ]}\n";
+  return scene.str();
+}
+
+struct Summary
+{
+  Summary() : NumberOfObjects(0), NumberOfVisible(0), Sum(0) {}
+  int NumberOfObjects;
+  int NumberOfVisible;
+  double Sum;
+  std::string LastName;
+};
+
+double sumArray(cJSON* array)
+{
+  double sum = 0;
+  for (cJSON* item = array ? array->child : 0; item; item = item->next) {
+    sum += item->valuedouble;
+  }
+  return sum;
+}
+
+Summary readWithCJSON(const std::string& scene)
+{
+  Summary summary;
+  cJSON* json = cJSON_Parse(scene.c_str());
+  cJSON* objects = json ? cJSON_GetObjectItem(json, "objects") : 0;
+  // walk the child list directly, indexed access is linear in cJSON
+  for (cJSON* object = objects ? objects->child : 0; object; object = object->next) {
+    summary.NumberOfObjects++;
+    summary.LastName = cJSON_GetObjectItem(object, "name")->valuestring;
+    summary.Sum += sumArray(cJSON_GetObjectItem(object, "color"));
+    summary.Sum += sumArray(cJSON_GetObjectItem(object, "transform"));
+    summary.Sum += cJSON_GetObjectItem(object, "opacity")->valuedouble;
+    if (cJSON_GetObjectItem(object, "visible")->type == cJSON_True) {
+      summary.NumberOfVisible++;
+    }
+  }
+  cJSON_Delete(json);
+  return summary;
+}
+
+double sumArray(const std::vector<double>& values)
+{
+  double sum = 0;
+  for (size_t i = 0; i < values.size(); ++i) {
+    sum += values[i];
+  }
+  return sum;
+}
+
+Summary readWithReader(const std::string& scene)
+{
+  Summary summary;
+  vesKiwiJSONReader reader(scene.c_str(), scene.size());
+  reader.beginObject();
+  while (reader.hasNext()) {
+    if (reader.nextName() != "objects") {
+      reader.skipValue();
+      continue;
+    }
+    reader.beginArray();
+    while (reader.hasNext()) {
+      summary.NumberOfObjects++;
+      reader.beginObject();
+      while (reader.hasNext()) {
+        std::string name = reader.nextName();
+        if (name == "name") {
+          summary.LastName = reader.nextString();
+        }
+        else if (name == "color" || name == "transform") {
+          summary.Sum += sumArray(reader.nextDoubleArray());
+        }
+        else if (name == "opacity") {
+          summary.Sum += reader.nextDouble();
+        }
+        else if (name == "visible") {
+          summary.NumberOfVisible += reader.nextBool() ? 1 : 0;
+        }
+        else {
+          reader.skipValue();
+        }
+      }
+      reader.endObject();
+    }
+    reader.endArray();
+  }
+  reader.endObject();
+  return reader.hasError() ? Summary() : summary;
+}
+
+bool testLargeScene()
+{
+  const int numberOfObjects = 20000;
+  const int iterations = 5;
+  const std::string scene = makeScene(numberOfObjects);
+
+  Summary expected, actual;
+  double start = vtkTimerLog::GetUniversalTime();
+  for (int i = 0; i < iterations; ++i) {
+    expected = readWithCJSON(scene);
+  }
+  const double cjsonTime = (vtkTimerLog::GetUniversalTime() - start) / iterations;
+
+  start = vtkTimerLog::GetUniversalTime();
+  for (int i = 0; i < iterations; ++i) {
+    actual = readWithReader(scene);
+  }
+  const double readerTime = (vtkTimerLog::GetUniversalTime() - start) / iterations;
+
+  printf("scene with %d objects, %.1f MB\n", numberOfObjects, scene.size() / (1024.0*1024.0));
+  printf("  cJSON:             %8.2f ms\n", cjsonTime * 1000.0);
+  printf("  vesKiwiJSONReader: %8.2f ms\n", readerTime * 1000.0);
+
+  bool testPassed = true;
+  testPassed &= check(expected.NumberOfObjects == numberOfObjects, "cJSON object count");
+  testPassed &= check(actual.NumberOfObjects == expected.NumberOfObjects, "object count");
+  testPassed &= check(actual.NumberOfVisible == expected.NumberOfVisible, "visible count");
+  testPassed &= check(actual.LastName == expected.LastName, "object name");
+  testPassed &= check(std::fabs(actual.Sum - expected.Sum) <= 1e-9 * std::fabs(expected.Sum), "object values");
+  return testPassed;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  bool testPassed = true;
+  testPassed &= testTokens();
+  testPassed &= testLargeScene();
+
+  return testPassed ? 0 : 1;
+}
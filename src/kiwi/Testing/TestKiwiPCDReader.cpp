@@ -0,0 +1,301 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test writes the same point cloud in the ascii, binary and
+// binary_compressed PCD encodings, and checks that vesKiwiPCDReader reads
+// back the same points and colors from each, with one and several threads.
+
+#include <vesKiwiPCDReader.h>
+#include <vesGeometryData.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct TestPoint
+{
+  float Position[3];
+  unsigned char Color[3];
+};
+
+bool check(bool condition, const std::string& message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message.c_str());
+  }
+  return condition;
+}
+
+//----------------------------------------------------------------------------
+// A height field with few distinct heights, so the compressed data has
+// repeated bytes, and an invalid point every 97 points.
+std::vector<TestPoint> makeCloud(int numberOfPoints)
+{
+  std::vector<TestPoint> points(numberOfPoints);
+  for (int i = 0; i < numberOfPoints; ++i) {
+    TestPoint& point = points[i];
+    point.Position[0] = (i % 100) * 0.125f - 6.0f;
+    point.Position[1] = (i / 100) * 0.25f + 1.0f / 3.0f;
+    point.Position[2] = (i % 7) * 0.5f;
+    if (i % 97 == 13) {
+      point.Position[i % 3] = std::numeric_limits<float>::quiet_NaN();
+    }
+    point.Color[0] = static_cast<unsigned char>(i);
+    point.Color[1] = static_cast<unsigned char>(i * 7);
+    point.Color[2] = static_cast<unsigned char>(255 - i % 256);
+  }
+  return points;
+}
+
+unsigned int packColor(const TestPoint& point)
+{
+  return (point.Color[0] << 16) | (point.Color[1] << 8) | point.Color[2];
+}
+
+bool isNaN(float value)
+{
+  return value != value;
+}
+
+bool isValid(const TestPoint& point)
+{
+  return !isNaN(point.Position[0]) && !isNaN(point.Position[1]) && !isNaN(point.Position[2]);
+}
+
+//----------------------------------------------------------------------------
+// Compress like liblzf, the library PCL uses for binary_compressed: literal
+// runs of up to 32 bytes, and back references of 3 to 264 bytes found with a
+// hash of the next 3 bytes.
+std::vector<unsigned char> lzfCompress(const std::vector<unsigned char>& input)
+{
+  std::vector<unsigned char> output;
+  std::vector<int> table(1 << 14, -1);
+  std::vector<unsigned char> literals;
+  const int length = static_cast<int>(input.size());
+
+  int i = 0;
+  while (i < length) {
+    int match = 0;
+    int reference = -1;
+    if (i + 3 <= length) {
+      const unsigned int hash = ((input[i] << 16) | (input[i + 1] << 8) | input[i + 2]) * 2654435761u >> 18;
+      reference = table[hash];
+      table[hash] = i;
+      if (reference >= 0 && i - reference <= 8192) {
+        while (i + match < length && match < 264 && input[reference + match] == input[i + match]) {
+          ++match;
+        }
+      }
+    }
+
+    if (match < 3) {
+      literals.push_back(input[i++]);
+      if (literals.size() == 32 || i == length) {
+        output.push_back(static_cast<unsigned char>(literals.size() - 1));
+        output.insert(output.end(), literals.begin(), literals.end());
+        literals.clear();
+      }
+      continue;
+    }
+
+    if (!literals.empty()) {
+      output.push_back(static_cast<unsigned char>(literals.size() - 1));
+      output.insert(output.end(), literals.begin(), literals.end());
+      literals.clear();
+    }
+
+    const int distance = i - reference - 1;
+    const int encodedLength = match - 2;
+    if (encodedLength < 7) {
+      output.push_back(static_cast<unsigned char>((encodedLength << 5) | (distance >> 8)));
+    }
+    else {
+      output.push_back(static_cast<unsigned char>((7 << 5) | (distance >> 8)));
+      output.push_back(static_cast<unsigned char>(encodedLength - 7));
+    }
+    output.push_back(static_cast<unsigned char>(distance & 0xff));
+    i += match;
+  }
+
+  return output;
+}
+
+//----------------------------------------------------------------------------
+bool writeCloud(const std::string& filename, const std::vector<TestPoint>& points,
+                vesKiwiPCDReader::DataEncoding encoding)
+{
+  FILE* file = fopen(filename.c_str(), "wb");
+  if (!file) {
+    printf("could not write %s\n", filename.c_str());
+    return false;
+  }
+
+  // The binary record has a one byte padding field the reader must skip.
+  const bool isAscii = encoding == vesKiwiPCDReader::Ascii;
+  const size_t numberOfPoints = points.size();
+  fprintf(file, "# .PCD v0.7 - Point Cloud Data file format\n"
+          "VERSION 0.7\n"
+          "FIELDS x y z%s rgb\n"
+          "SIZE 4 4 4%s 4\n"
+          "TYPE F F F%s %s\n"
+          "COUNT 1 1 1%s 1\n"
+          "WIDTH %u\n"
+          "HEIGHT 1\n"
+          "VIEWPOINT 1 2 3 1 0 0 0\n"
+          "POINTS %u\n"
+          "DATA %s\n",
+          isAscii ? "" : " _", isAscii ? "" : " 1", isAscii ? "" : " U",
+          isAscii ? "U" : "F", isAscii ? "" : " 1",
+          static_cast<unsigned int>(numberOfPoints), static_cast<unsigned int>(numberOfPoints),
+          isAscii ? "ascii" : (encoding == vesKiwiPCDReader::Binary ? "binary" : "binary_compressed"));
+
+  if (isAscii) {
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+      const TestPoint& point = points[i];
+      for (int j = 0; j < 3; ++j) {
+        if (isNaN(point.Position[j])) {
+          fprintf(file, "nan ");
+        }
+        else {
+          fprintf(file, "%.9g ", point.Position[j]);
+        }
+      }
+      fprintf(file, "%u\n", packColor(point));
+    }
+  }
+  else if (encoding == vesKiwiPCDReader::Binary) {
+    const unsigned char padding = 0;
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+      const unsigned int color = packColor(points[i]);
+      fwrite(points[i].Position, sizeof(float), 3, file);
+      fwrite(&padding, 1, 1, file);
+      fwrite(&color, sizeof(color), 1, file);
+    }
+  }
+  else {
+    // Compressed data stores each field for all points in turn, and like
+    // PCL leaves the padding field out.
+    std::vector<unsigned char> fields(numberOfPoints * 16);
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+      const unsigned int color = packColor(points[i]);
+      for (int j = 0; j < 3; ++j) {
+        memcpy(&fields[(j * numberOfPoints + i) * 4], &points[i].Position[j], 4);
+      }
+      memcpy(&fields[(3 * numberOfPoints + i) * 4], &color, 4);
+    }
+
+    const std::vector<unsigned char> compressed = lzfCompress(fields);
+    const unsigned int sizes[2] = {
+      static_cast<unsigned int>(compressed.size()), static_cast<unsigned int>(fields.size()) };
+    fwrite(sizes, sizeof(sizes), 1, file);
+    fwrite(&compressed[0], 1, compressed.size(), file);
+  }
+
+  return fclose(file) == 0;
+}
+
+//----------------------------------------------------------------------------
+bool checkCloud(const std::string& filename, const std::vector<TestPoint>& points,
+                vesKiwiPCDReader::DataEncoding encoding, int numberOfThreads)
+{
+  vesKiwiPCDReader reader;
+  reader.setNumberOfThreads(numberOfThreads);
+  if (!reader.read(filename)) {
+    printf("failed to read %s: %s\n", filename.c_str(), reader.errorMessage().c_str());
+    return false;
+  }
+
+  std::vector<TestPoint> expected;
+  for (size_t i = 0; i < points.size(); ++i) {
+    if (isValid(points[i])) {
+      expected.push_back(points[i]);
+    }
+  }
+
+  bool testPassed = true;
+  testPassed &= check(reader.dataEncoding() == encoding, filename + " encoding");
+  testPassed &= check(reader.width() == points.size() && reader.height() == 1, filename + " dimensions");
+  testPassed &= check(reader.viewpoint()(0, 3) == 1.0f && reader.viewpoint()(1, 3) == 2.0f
+                      && reader.viewpoint()(2, 3) == 3.0f, filename + " viewpoint");
+  testPassed &= check(reader.hasColors(), filename + " colors");
+  testPassed &= check(reader.numberOfPoints() == expected.size(), filename + " number of points");
+
+  vesSourceDataP3C4ub::Ptr vertices = std::tr1::dynamic_pointer_cast<vesSourceDataP3C4ub>(
+    reader.geometryData()->sourceData(vesVertexAttributeKeys::Position));
+  if (!check(vertices && vertices->sizeOfArray() == expected.size(), filename + " vertices")) {
+    return false;
+  }
+
+  size_t numberOfDifferences = 0;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    const vesVertexDataP3C4ub& vertex = vertices->arrayReference()[i];
+    bool isEqual = vertex.m_color[3] == 255;
+    for (int j = 0; j < 3; ++j) {
+      isEqual &= vertex.m_position[j] == expected[i].Position[j];
+      isEqual &= vertex.m_color[j] == expected[i].Color[j];
+    }
+    numberOfDifferences += isEqual ? 0 : 1;
+  }
+  testPassed &= check(numberOfDifferences == 0, filename + " point values");
+
+  printf("%s with %d threads: %u points, %d differences\n", filename.c_str(),
+         numberOfThreads, reader.numberOfPoints(), static_cast<int>(numberOfDifferences));
+  return testPassed;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  const std::vector<TestPoint> points = makeCloud(10000);
+
+  const char* filenames[] = {
+    "TestKiwiPCDReaderAscii.pcd",
+    "TestKiwiPCDReaderBinary.pcd",
+    "TestKiwiPCDReaderCompressed.pcd"
+  };
+  const vesKiwiPCDReader::DataEncoding encodings[] = {
+    vesKiwiPCDReader::Ascii,
+    vesKiwiPCDReader::Binary,
+    vesKiwiPCDReader::BinaryCompressed
+  };
+
+  bool testPassed = true;
+  for (int i = 0; i < 3; ++i) {
+    if (!writeCloud(filenames[i], points, encodings[i])) {
+      testPassed = false;
+      continue;
+    }
+
+    // Several threads split the points in chunks that must line up again.
+    testPassed = checkCloud(filenames[i], points, encodings[i], 1) && testPassed;
+    testPassed = checkCloud(filenames[i], points, encodings[i], 4) && testPassed;
+    remove(filenames[i]);
+  }
+
+  return testPassed ? 0 : 1;
+}
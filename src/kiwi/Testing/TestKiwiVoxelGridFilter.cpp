@@ -0,0 +1,169 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test checks the voxels vesKiwiVoxelGridFilter computes on a lattice,
+// and that the output stays within the maximum number of points for clouds
+// shaped like a surface, a volume, a line and a few far apart clusters.
+
+#include <vesKiwiVoxelGridFilter.h>
+#include <vesGeometryData.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+namespace {
+
+bool check(bool condition, const std::string& message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message.c_str());
+  }
+  return condition;
+}
+
+vesGeometryData::Ptr makeGeometry(vesSourceData::Ptr positions)
+{
+  vesGeometryData::Ptr geometry(new vesGeometryData());
+  geometry->addSource(positions);
+  return geometry;
+}
+
+//----------------------------------------------------------------------------
+// Points at the integer coordinates of a size^3 lattice, colored black and
+// white in alternating x.
+vesGeometryData::Ptr makeLattice(int size)
+{
+  vesSourceDataP3C4ub::Ptr points(new vesSourceDataP3C4ub());
+  for (int z = 0; z < size; ++z) {
+    for (int y = 0; y < size; ++y) {
+      for (int x = 0; x < size; ++x) {
+        vesVertexDataP3C4ub vertex;
+        vertex.m_position = vesVector3f(x, y, z);
+        const unsigned char value = x % 2 ? 255 : 0;
+        vertex.m_color[0] = vertex.m_color[1] = vertex.m_color[2] = value;
+        vertex.m_color[3] = 255;
+        points->pushBack(vertex);
+      }
+    }
+  }
+  return makeGeometry(points);
+}
+
+bool testLattice()
+{
+  bool testPassed = true;
+  vesGeometryData::Ptr lattice = makeLattice(10);
+
+  // One voxel per point, and with twice the leaf size one per 2^3 points
+  // centered between them, with the average color.
+  vesKiwiVoxelGridFilter filter;
+  filter.setLeafSize(1.0f);
+  vesGeometryData::Ptr output = filter.filter(lattice);
+  testPassed &= check(output && output->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray() == 1000,
+                      "one voxel per lattice point");
+
+  filter.setLeafSize(2.0f);
+  output = filter.filter(lattice);
+  vesSourceDataP3C4ub::Ptr points = output ? std::tr1::dynamic_pointer_cast<vesSourceDataP3C4ub>(
+    output->sourceData(vesVertexAttributeKeys::Position)) : vesSourceDataP3C4ub::Ptr();
+  if (!check(points && points->sizeOfArray() == 125, "one voxel per 2^3 lattice points")) {
+    return false;
+  }
+
+  bool isAveraged = true;
+  for (unsigned int i = 0; i < points->sizeOfArray(); ++i) {
+    const vesVertexDataP3C4ub& vertex = points->arrayReference()[i];
+    for (int j = 0; j < 3; ++j) {
+      isAveraged &= std::fabs(vertex.m_position[j] - 0.5f - 2.0f * floor(vertex.m_position[j] / 2.0f)) < 1.0e-5f;
+    }
+    isAveraged &= vertex.m_color[0] == 128 && vertex.m_color[3] == 255;
+  }
+  testPassed &= check(isAveraged, "voxel centroids and colors");
+  testPassed &= check(filter.usedLeafSize() == vesVector3f::Constant(2.0f), "leaf size without a budget");
+  return testPassed;
+}
+
+//----------------------------------------------------------------------------
+vesGeometryData::Ptr makeCloud(const std::string& shape)
+{
+  vesSourceDataP3f::Ptr points(new vesSourceDataP3f());
+  vesVertexDataP3f vertex;
+  const int numberOfPoints = 100000;
+  for (int i = 0; i < numberOfPoints; ++i) {
+    const float u = static_cast<float>(i % 317) / 317.0f;
+    const float v = static_cast<float>(i / 317) / 316.0f;
+    const float w = static_cast<float>((i * 7919) % numberOfPoints) / numberOfPoints;
+    if (shape == "surface") {
+      vertex.m_position = vesVector3f(u, v, 0.1f * sin(10.0f * u));
+    }
+    else if (shape == "volume") {
+      vertex.m_position = vesVector3f(u, v, w);
+    }
+    else if (shape == "line") {
+      vertex.m_position = vesVector3f(static_cast<float>(i) / numberOfPoints, 0.0f, 0.0f);
+    }
+    else {
+      // Dense clusters at the corners of a large box leave it mostly empty.
+      const int cluster = i % 8;
+      vertex.m_position = 0.001f * vesVector3f(u, v, w)
+        + 1000.0f * vesVector3f(cluster & 1, (cluster >> 1) & 1, (cluster >> 2) & 1);
+    }
+    points->pushBack(vertex);
+  }
+  return makeGeometry(points);
+}
+
+bool testBudget()
+{
+  bool testPassed = true;
+  const char* shapes[] = { "surface", "volume", "line", "clusters" };
+  const unsigned int budgets[] = { 1, 7, 100, 5000 };
+
+  for (int i = 0; i < 4; ++i) {
+    vesGeometryData::Ptr cloud = makeCloud(shapes[i]);
+    for (int j = 0; j < 4; ++j) {
+      vesKiwiVoxelGridFilter filter;
+      filter.setLeafSize(1.0e-4f);
+      filter.setMaximumNumberOfPoints(budgets[j]);
+      vesGeometryData::Ptr output = filter.filter(cloud);
+      const unsigned int numberOfPoints = output
+        ? output->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray() : 0;
+
+      char message[128];
+      sprintf(message, "%s cloud with a budget of %u points has %u", shapes[i], budgets[j], numberOfPoints);
+      testPassed &= check(numberOfPoints > 0 && numberOfPoints <= budgets[j], message);
+      testPassed &= check(filter.usedLeafSize()[0] > filter.leafSize()[0], std::string(message) + ", leaf size not grown");
+    }
+  }
+  return testPassed;
+}
+
+}
+
+//----------------------------------------------------------------------------
+int main(int, char*[])
+{
+  bool testPassed = testLattice();
+  testPassed = testBudget() && testPassed;
+  return testPassed ? 0 : 1;
+}
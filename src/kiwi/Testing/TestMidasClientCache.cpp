@@ -0,0 +1,251 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test replays recorded Midas responses from a local HTTP server and
+// checks that vesMidasClient serves repeated listings from its cache,
+// prefetches child folders in the background, and revalidates expired
+// responses with their ETag.
+
+#include <vesMidasClient.h>
+#include <vesSetGet.h>
+
+#include "vesKiwiTestHTTPServer.h"
+
+#include <vtkMutexLock.h>
+
+#include <cstdio>
+#include <map>
+#include <sstream>
+#include <string>
+
+namespace {
+
+struct RecordedResponse
+{
+  const char* Method;
+  const char* Id;
+  const char* Data;
+};
+
+// Responses recorded from midas3.kitware.com, trimmed to the fields that
+// vesMidasClient reads.
+const RecordedResponse recordedResponses[] = {
+  { "midas.community.list", "",
+    "[{\"community_id\":\"11\",\"name\":\"KiwiViewer Data\"},"
+    "{\"community_id\":\"12\",\"name\":\"Other Data\"}]" },
+  { "midas.community.children", "11",
+    "{\"folders\":[{\"folder_id\":\"1272\",\"name\":\"Public\"},"
+    "{\"folder_id\":\"1273\",\"name\":\"Private\"}]}" },
+  { "midas.community.children", "12",
+    "{\"folders\":[{\"folder_id\":\"1300\",\"name\":\"Public\"}]}" },
+  { "midas.folder.children", "1272",
+    "{\"folders\":[{\"folder_id\":\"1280\",\"name\":\"Meshes\"}],"
+    "\"items\":[{\"item_id\":\"23821\",\"name\":\"teapot dataset\",\"sizebytes\":\"14388\"},"
+    "{\"item_id\":\"23822\",\"name\":\"Space Shuttle\",\"sizebytes\":\"182528\"}]}" },
+  { "midas.folder.children", "1273", "{\"folders\":[],\"items\":[]}" },
+  { "midas.folder.children", "1280", "{\"folders\":[],\"items\":[]}" },
+  { "midas.folder.children", "1300", "{\"folders\":[],\"items\":[]}" },
+};
+
+class MockMidasServer : public vesKiwiTestHTTPServer
+{
+public:
+
+  MockMidasServer() : NotModified(0)
+  {
+    for (size_t i = 0; i < sizeof(recordedResponses)/sizeof(recordedResponses[0]); ++i) {
+      this->Responses[key(recordedResponses[i].Method, recordedResponses[i].Id)] = recordedResponses[i].Data;
+    }
+  }
+
+  static std::string key(const std::string& method, const std::string& id)
+  {
+    return method + " " + id;
+  }
+
+  int count(const std::string& method, const std::string& id)
+  {
+    this->Lock->Lock();
+    int result = this->Counts[key(method, id)];
+    this->Lock->Unlock();
+    return result;
+  }
+
+  int totalCount()
+  {
+    this->Lock->Lock();
+    int result = 0;
+    for (std::map<std::string, int>::const_iterator itr = this->Counts.begin(); itr != this->Counts.end(); ++itr) {
+      result += itr->second;
+    }
+    this->Lock->Unlock();
+    return result;
+  }
+
+  void resetCounts()
+  {
+    this->Lock->Lock();
+    this->Counts.clear();
+    this->NotModified = 0;
+    this->Lock->Unlock();
+  }
+
+  int notModifiedCount()
+  {
+    this->Lock->Lock();
+    int result = this->NotModified;
+    this->Lock->Unlock();
+    return result;
+  }
+
+protected:
+
+  static std::string argument(const std::string& args, const std::string& name)
+  {
+    size_t start = args.find(name + "=");
+    if (start == std::string::npos) {
+      return std::string();
+    }
+    start += name.size() + 1;
+    return args.substr(start, args.find_first_of("& ", start) - start);
+  }
+
+  void handleRequest(int fd, const std::string& header, const std::string& body)
+  {
+    const std::string requestKey = key(argument(header, "method"), argument(body, "id"));
+
+    this->Lock->Lock();
+    this->Counts[requestKey]++;
+    this->Lock->Unlock();
+
+    std::map<std::string, std::string>::const_iterator itr = this->Responses.find(requestKey);
+    std::string content = "{\"stat\":\"fail\",\"message\":\"Unknown request\",\"code\":\"-1\"}";
+    if (itr != this->Responses.end()) {
+      content = "{\"stat\":\"ok\",\"code\":\"0\",\"message\":\"\",\"data\":" + itr->second + "}";
+    }
+
+    unsigned int hash = 5381;
+    for (size_t i = 0; i < content.size(); ++i) {
+      hash = hash*33 + static_cast<unsigned char>(content[i]);
+    }
+    std::stringstream etag;
+    etag << "\"" << std::hex << hash << "\"";
+
+    std::stringstream response;
+    if (headerValue(header, "If-None-Match:") == etag.str()) {
+      this->Lock->Lock();
+      this->NotModified++;
+      this->Lock->Unlock();
+      response << "HTTP/1.1 304 Not Modified\r\n";
+      response << "ETag: " << etag.str() << "\r\n";
+      response << "Connection: close\r\n\r\n";
+    }
+    else {
+      response << "HTTP/1.1 200 OK\r\n";
+      response << "Content-Type: application/json\r\n";
+      response << "Content-Length: " << content.size() << "\r\n";
+      response << "ETag: " << etag.str() << "\r\n";
+      response << "Connection: close\r\n\r\n";
+      response << content;
+    }
+
+    sendAll(fd, response.str());
+  }
+
+  std::map<std::string, std::string> Responses;
+  std::map<std::string, int> Counts;
+  int NotModified;
+  vtkNew<vtkMutexLock> Lock;
+};
+
+bool check(bool condition, const char* message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message);
+  }
+  return condition;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+  vesNotUsed(argc);
+  vesNotUsed(argv);
+
+  MockMidasServer server;
+  if (!server.start()) {
+    printf("failed to start the test server\n");
+    return 1;
+  }
+
+  bool testPassed = true;
+
+  {
+    vesMidasClient midas;
+    midas.setHost(server.url("/midas"));
+
+    // listing the communities prefetches the children of each community
+    testPassed &= check(midas.listCommunities(), "list communities");
+    testPassed &= check(midas.folderIds().size() == 2, "number of communities");
+    midas.waitForPrefetch();
+    testPassed &= check(server.count("midas.community.children", "11") == 1, "prefetch community 11");
+    testPassed &= check(server.count("midas.community.children", "12") == 1, "prefetch community 12");
+
+    // the prefetched listing is served from the cache, and its folders are
+    // prefetched in turn
+    testPassed &= check(midas.listCommunityChildren("11"), "list community children");
+    testPassed &= check(midas.folderNames().size() == 2 && midas.folderNames()[0] == "Public", "community children");
+    testPassed &= check(server.count("midas.community.children", "11") == 1, "community children cached");
+    midas.waitForPrefetch();
+    testPassed &= check(server.count("midas.folder.children", "1272") == 1, "prefetch folder 1272");
+    testPassed &= check(server.count("midas.folder.children", "1273") == 1, "prefetch folder 1273");
+
+    testPassed &= check(midas.listFolderChildren("1272"), "list folder children");
+    testPassed &= check(midas.itemNames().size() == 2 && midas.itemNames()[1] == "Space Shuttle", "folder items");
+    testPassed &= check(midas.itemBytes().size() == 2 && midas.itemBytes()[1] == 182528, "folder item sizes");
+    testPassed &= check(server.count("midas.folder.children", "1272") == 1, "folder children cached");
+
+    // an expired response is revalidated with its etag
+    midas.waitForPrefetch();
+    midas.setCacheTimeToLive(0);
+    testPassed &= check(midas.listFolderChildren("1272"), "revalidate folder children");
+    testPassed &= check(midas.itemNames().size() == 2, "revalidated folder items");
+    testPassed &= check(server.count("midas.folder.children", "1272") == 2, "revalidation request");
+    testPassed &= check(server.notModifiedCount() == 1, "revalidation not modified");
+    midas.waitForPrefetch();
+  }
+
+  // without prefetching only the requested listings are fetched
+  {
+    server.resetCounts();
+    vesMidasClient midas;
+    midas.setHost(server.url("/midas"));
+    midas.setPrefetchEnabled(false);
+
+    testPassed &= check(midas.listCommunities(), "list communities without prefetch");
+    testPassed &= check(midas.listCommunities(), "list communities again");
+    testPassed &= check(server.totalCount() == 1, "no prefetch requests");
+  }
+
+  server.stop();
+
+  return testPassed ? 0 : 1;
+}
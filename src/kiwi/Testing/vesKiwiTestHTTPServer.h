@@ -0,0 +1,218 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiTestHTTPServer
+/// \brief Minimal HTTP server on the loopback interface for network tests.
+///
+/// The server runs on its own thread and handles one connection at a time.
+/// Subclasses implement handleRequest() and write the response with
+/// sendAll().  Every connection is closed after one request.
+#ifndef __vesKiwiTestHTTPServer_h
+#define __vesKiwiTestHTTPServer_h
+
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <sstream>
+#include <string>
+
+class vesKiwiTestHTTPServer
+{
+public:
+
+  vesKiwiTestHTTPServer() : mSocket(-1), mPort(0), mThreadId(-1), mQuit(false)
+  {
+  }
+
+  virtual ~vesKiwiTestHTTPServer()
+  {
+    this->stop();
+  }
+
+  bool start()
+  {
+    mSocket = socket(AF_INET, SOCK_STREAM, 0);
+    if (mSocket < 0) {
+      return false;
+    }
+
+    struct sockaddr_in address;
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+    socklen_t addressLength = sizeof(address);
+
+    if (bind(mSocket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0
+        || listen(mSocket, 16) != 0
+        || getsockname(mSocket, reinterpret_cast<sockaddr*>(&address), &addressLength) != 0) {
+      close(mSocket);
+      mSocket = -1;
+      return false;
+    }
+
+    mPort = ntohs(address.sin_port);
+    mQuit = false;
+    mThreadId = mThreader->SpawnThread(ServerLoop, this);
+    return true;
+  }
+
+  void stop()
+  {
+    if (mThreadId >= 0) {
+      mQuit = true;
+      mThreader->TerminateThread(mThreadId);
+      mThreadId = -1;
+    }
+    if (mSocket >= 0) {
+      close(mSocket);
+      mSocket = -1;
+    }
+  }
+
+  std::string url(const std::string& path) const
+  {
+    std::stringstream url;
+    url << "http://127.0.0.1:" << mPort << path;
+    return url.str();
+  }
+
+  /// Returns the value of the given header, for example "Range:", or an
+  /// empty string if the header is missing or malformed.
+  static std::string headerValue(const std::string& header, const std::string& name)
+  {
+    size_t start = header.find("\r\n" + name);
+    if (start == std::string::npos) {
+      return std::string();
+    }
+    start += 2 + name.size();
+    size_t end = header.find("\r\n", start);
+    if (end == std::string::npos) {
+      end = header.size();
+    }
+
+    // the name may be given with or without its colon
+    if (name.empty() || name[name.size() - 1] != ':') {
+      if (start >= end || header[start] != ':') {
+        return std::string();
+      }
+      ++start;
+    }
+
+    start = header.find_first_not_of(' ', start);
+    if (start == std::string::npos || start >= end) {
+      return std::string();
+    }
+    return header.substr(start, end - start);
+  }
+
+  static bool sendAll(int fd, const char* data, size_t length)
+  {
+    while (length) {
+      ssize_t sent = send(fd, data, length, MSG_NOSIGNAL);
+      if (sent <= 0) {
+        return false;
+      }
+      data += sent;
+      length -= sent;
+    }
+    return true;
+  }
+
+  static bool sendAll(int fd, const std::string& data)
+  {
+    return sendAll(fd, data.c_str(), data.size());
+  }
+
+protected:
+
+  /// Called on the server thread with the request line and headers, and the
+  /// request body if it declared a Content-Length.
+  virtual void handleRequest(int fd, const std::string& header, const std::string& body) = 0;
+
+private:
+
+  void handleConnection(int fd)
+  {
+    std::string request;
+    char buffer[4096];
+    size_t headerEnd;
+    while ((headerEnd = request.find("\r\n\r\n")) == std::string::npos) {
+      ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+      if (length <= 0) {
+        return;
+      }
+      request.append(buffer, length);
+    }
+
+    std::string header = request.substr(0, headerEnd + 2);
+    std::string body = request.substr(headerEnd + 4);
+    size_t contentLength = atol(headerValue(header, "Content-Length:").c_str());
+    while (body.size() < contentLength) {
+      ssize_t length = recv(fd, buffer, sizeof(buffer), 0);
+      if (length <= 0) {
+        return;
+      }
+      body.append(buffer, length);
+    }
+
+    this->handleRequest(fd, header, body);
+  }
+
+  static VTK_THREAD_RETURN_TYPE ServerLoop(void* arg)
+  {
+    vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+    vesKiwiTestHTTPServer* self = static_cast<vesKiwiTestHTTPServer*>(threadInfo->UserData);
+
+    while (!self->mQuit) {
+
+      fd_set readSet;
+      FD_ZERO(&readSet);
+      FD_SET(self->mSocket, &readSet);
+      struct timeval timeout;
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 50000;
+      if (select(self->mSocket + 1, &readSet, 0, 0, &timeout) <= 0) {
+        continue;
+      }
+
+      int fd = accept(self->mSocket, 0, 0);
+      if (fd >= 0) {
+        self->handleConnection(fd);
+        close(fd);
+      }
+    }
+
+    return VTK_THREAD_RETURN_VALUE;
+  }
+
+  int mSocket;
+  int mPort;
+  int mThreadId;
+  volatile bool mQuit;
+  vtkNew<vtkMultiThreader> mThreader;
+};
+
+#endif
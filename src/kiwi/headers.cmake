@@ -13,16 +13,29 @@ set(headers
   vesKiwiDataLoader.h
   vesKiwiDataRepresentation.h
   vesKiwiFPSCounter.h
+  vesKiwiGlyphAtlas.h
+  vesKiwiGlyphRepresentation.h
   vesKiwiImagePlaneDataRepresentation.h
   vesKiwiImageWidgetRepresentation.h
+  vesKiwiJSONReader.h
+  vesKiwiParallelDataLoader.h
+  vesKiwiPCDReader.h
   vesKiwiPlaneWidget.h
+  vesKiwiPointCloudOctree.h
+  vesKiwiPointCloudOctreeBuilder.h
+  vesKiwiPointCloudRepresentation.h
   vesKiwiPolyDataRepresentation.h
   vesKiwiPVRemoteRepresentation.h
   vesKiwiSceneRepresentation.h
+  vesKiwiShaderVariantCache.h
+  vesKiwiStaticBatchRepresentation.h
   vesKiwiStreamingDataRepresentation.h
+  vesKiwiStreamingImageWriter.h
   vesKiwiTestHelper.h
   vesKiwiText2DRepresentation.h
+  vesKiwiTextLabelsRepresentation.h
   vesKiwiViewerApp.h
+  vesKiwiVoxelGridFilter.h
   vesKiwiWidgetInteractionDelegate.h
   vesKiwiWidgetRepresentation.h
   vesMidasClient.h
@@ -24,6 +24,7 @@
 #include "vesCamera.h"
 #include "vesMapper.h"
 #include "vesActor.h"
+#include "vesGeometryData.h"
 #include "vesShaderProgram.h"
 #include "vesTexture.h"
 #include "vesKiwiColorMapCollection.h"
@@ -32,7 +33,11 @@
 #include "vesKiwiText2DRepresentation.h"
 #include "vesKiwiPolyDataRepresentation.h"
 
+#include <vtkConditionVariable.h>
+#include <vtkDataSet.h>
 #include <vtkDiscretizableColorTransferFunction.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
 #include <vtkPolyData.h>
 #include <vtkTimerLog.h>
 #include <vtkNew.h>
@@ -42,6 +47,7 @@
 
 #include <vtksys/SystemTools.hxx>
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 #include <sstream>
@@ -65,13 +71,109 @@ public:
     this->AnimationFrameStart = 0;
     this->AnimationFramesPerSecond = 24;
     this->EnableTapToPlay = false;
+
+    this->ShownFrame = 0;
+    this->NumberOfDroppedFrames = 0;
+    this->WindowStart = 0;
+    this->WindowSize = 0;
+    this->AverageLoadTime = 0.0;
+    this->ShouldQuit = false;
+    this->ThreadId = -1;
   }
 
   ~vesInternal()
   {
+    this->stopLoader();
+  }
+
+  struct DecodedFrame
+  {
+    DecodedFrame() : Index(-1)
+    {
+    }
+
+    int Index;
+    vtkSmartPointer<vtkPolyData> PolyData;
+    vesGeometryData::Ptr GeometryData;
+  };
+
+  void stopLoader()
+  {
+    if (this->ThreadId < 0) {
+      return;
+    }
+    this->Lock->Lock();
+    this->ShouldQuit = true;
+    this->WindowChanged->Broadcast();
+    this->Lock->Unlock();
+    this->MultiThreader->TerminateThread(this->ThreadId);
+    this->ThreadId = -1;
+  }
+
+  // Number of frames from \p from forward to \p to, wrapping at the end.
+  int frameDistance(int from, int to) const
+  {
+    int distance = (to - from) % this->NumberOfFrames;
+    return distance < 0 ? distance + this->NumberOfFrames : distance;
+  }
+
+  bool isInWindow(int frameIndex) const
+  {
+    return frameIndex >= 0 && this->frameDistance(this->WindowStart, frameIndex) < this->WindowSize;
+  }
+
+  const DecodedFrame* findFrame(int frameIndex) const
+  {
+    for (size_t i = 0; i < this->Ring.size(); ++i) {
+      if (this->Ring[i].Index == frameIndex) {
+        return &this->Ring[i];
+      }
+    }
+    return 0;
+  }
+
+  int nextFrameToLoad() const
+  {
+    for (int i = 0; i < this->WindowSize; ++i) {
+      int frameIndex = (this->WindowStart + i) % this->NumberOfFrames;
+      if (!this->findFrame(frameIndex)) {
+        return frameIndex;
+      }
+    }
+    return -1;
+  }
+
+  void storeFrame(const DecodedFrame& frame)
+  {
+    if (!this->isInWindow(frame.Index)) {
+      return;
+    }
+
+    // The window is never larger than the ring, so there is always a slot
+    // that is empty or holds a frame the playhead has left behind.
+    for (size_t i = 0; i < this->Ring.size(); ++i) {
+      if (!this->isInWindow(this->Ring[i].Index)) {
+        this->Ring[i] = frame;
+        return;
+      }
+    }
+  }
+
+  void decodeFrame(const std::string& filename, DecodedFrame& frame) const
+  {
+    vesKiwiDataLoader loader;
+    loader.copySettings(this->LoaderSettings);
 
+    vtkSmartPointer<vtkDataSet> dataSet = loader.loadDataset(filename);
+    vtkPolyData* polyData = vtkPolyData::SafeDownCast(dataSet);
+    if (polyData) {
+      frame.GeometryData = vesKiwiPolyDataRepresentation::PreparePolyData(polyData, frame.PolyData);
+    }
   }
 
+  void showFrame(const DecodedFrame& frame);
+  void updateStreamedFrame();
+
   int CurrentFrame;
   int LastFrame;
   int AnimationFrameStart;
@@ -93,8 +195,151 @@ public:
 
   vesSharedPtr<vesShaderProgram> GeometryShader;
   vesSharedPtr<vesShaderProgram> TextureShader;
+
+  // Set when every frame is shown with the same representation, either from
+  // Frames or streamed from Filenames.
+  vesKiwiPolyDataRepresentation::Ptr FrameRep;
+  std::vector<DecodedFrame> Frames;
+  std::vector<std::string> Filenames;
+  vesKiwiDataLoader LoaderSettings;
+  int ShownFrame;
+  int NumberOfDroppedFrames;
+
+  // Shared with the loader thread, guarded by Lock.  The loader decodes the
+  // frames of the window, nearest first, into the ring.
+  std::vector<DecodedFrame> Ring;
+  int WindowStart;
+  int WindowSize;
+  double AverageLoadTime;
+  bool ShouldQuit;
+
+  int ThreadId;
+  vtkNew<vtkMultiThreader> MultiThreader;
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> WindowChanged;
 };
 
+namespace {
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE StreamLoop(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+
+  vesKiwiAnimationRepresentation::vesInternal* selfInternal =
+    static_cast<vesKiwiAnimationRepresentation::vesInternal*>(threadInfo->UserData);
+
+  selfInternal->Lock->Lock();
+  while (true) {
+
+    int frameIndex = -1;
+    while (!selfInternal->ShouldQuit && (frameIndex = selfInternal->nextFrameToLoad()) < 0) {
+      selfInternal->WindowChanged->Wait(selfInternal->Lock.GetPointer());
+    }
+    if (selfInternal->ShouldQuit) {
+      break;
+    }
+
+    // The filenames and loader settings do not change while this thread
+    // runs, so they are read without the lock.
+    selfInternal->Lock->Unlock();
+
+    vesKiwiAnimationRepresentation::vesInternal::DecodedFrame frame;
+    frame.Index = frameIndex;
+    double startTime = vtkTimerLog::GetUniversalTime();
+    selfInternal->decodeFrame(selfInternal->Filenames[frameIndex], frame);
+    double loadTime = vtkTimerLog::GetUniversalTime() - startTime;
+
+    // A frame that failed to load is stored without geometry, so it is
+    // skipped instead of being read again.
+    selfInternal->Lock->Lock();
+    selfInternal->AverageLoadTime = selfInternal->AverageLoadTime > 0.0 ?
+      0.8 * selfInternal->AverageLoadTime + 0.2 * loadTime : loadTime;
+    selfInternal->storeFrame(frame);
+  }
+  selfInternal->Lock->Unlock();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiAnimationRepresentation::vesInternal::updateStreamedFrame()
+{
+  DecodedFrame frame;
+  int frameDistance = 0;
+
+  this->Lock->Lock();
+
+  // While playing, the frames that are due before they could be decoded are
+  // not requested, otherwise a slow loader would only ever produce frames
+  // that are already late.
+  int lead = 0;
+  if (this->PlayMode) {
+    lead = static_cast<int>(this->AverageLoadTime * this->AnimationFramesPerSecond);
+    lead = std::min(lead, this->NumberOfFrames - 1);
+  }
+  this->WindowStart = (this->CurrentFrame + lead) % this->NumberOfFrames;
+  this->WindowChanged->Broadcast();
+
+  // Show the latest decoded frame that is due.  While paused only the
+  // current frame is shown, so scrubbing backwards does not pick up frames
+  // that were decoded ahead.
+  const int dueDistance = this->frameDistance(this->ShownFrame, this->CurrentFrame);
+  for (size_t i = 0; i < this->Ring.size(); ++i) {
+    const DecodedFrame& candidate = this->Ring[i];
+    if (candidate.Index < 0 || !candidate.GeometryData) {
+      continue;
+    }
+    int distance = this->frameDistance(this->ShownFrame, candidate.Index);
+    if (!this->PlayMode && distance != dueDistance) {
+      continue;
+    }
+    if (distance > frameDistance && distance <= dueDistance) {
+      frame = candidate;
+      frameDistance = distance;
+    }
+  }
+
+  this->Lock->Unlock();
+
+  if (!frame.GeometryData) {
+    return;
+  }
+
+  if (this->PlayMode) {
+    this->NumberOfDroppedFrames += frameDistance - 1;
+  }
+
+  this->showFrame(frame);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiAnimationRepresentation::vesInternal::showFrame(const DecodedFrame& frame)
+{
+  // A frame with the connectivity of the shown one only replaces the vertex
+  // buffers.  Otherwise the representation is reused, keeping the color mode
+  // if the new frame has the same array.
+  vesGeometryData::Ptr shownGeometry = this->FrameRep->geometryData();
+  const bool hasSameTopology =
+    vesKiwiDataConversionTools::HasSameTopology(shownGeometry, frame.GeometryData);
+  if (hasSameTopology) {
+    vesKiwiDataConversionTools::AdoptTopology(shownGeometry, frame.GeometryData);
+  }
+  if (!hasSameTopology
+      || !this->FrameRep->setSharedTopologyPolyData(frame.PolyData, frame.GeometryData)) {
+    std::string colorMode = this->FrameRep->colorMode();
+    this->FrameRep->setPreparedPolyData(frame.PolyData, frame.GeometryData);
+    std::vector<std::string> colorModes = this->FrameRep->colorModes();
+    if (std::find(colorModes.begin(), colorModes.end(), colorMode) != colorModes.end()) {
+      this->FrameRep->setColorMode(colorMode);
+    }
+  }
+
+  this->ShownFrame = frame.Index;
+}
+
 //----------------------------------------------------------------------------
 vesKiwiAnimationRepresentation::vesKiwiAnimationRepresentation()
 {
@@ -136,10 +381,83 @@ void vesKiwiAnimationRepresentation::initializeWithShader(
 //----------------------------------------------------------------------------
 void vesKiwiAnimationRepresentation::setRepresentations(const std::vector<vesKiwiPolyDataRepresentation::Ptr> reps)
 {
+  this->Internal->stopLoader();
+  this->Internal->FrameRep.reset();
+  this->Internal->Frames.clear();
+  this->Internal->Filenames.clear();
+  this->Internal->Ring.clear();
+
   this->Internal->FrameReps = reps;
   this->Internal->NumberOfFrames = static_cast<int>(this->Internal->FrameReps.size());
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiAnimationRepresentation::setFrames(vesKiwiPolyDataRepresentation::Ptr frameRep,
+                                               const std::vector<vtkSmartPointer<vtkPolyData> >& polyData,
+                                               const std::vector<vesGeometryData::Ptr>& geometryData)
+{
+  assert(frameRep);
+  assert(polyData.size() && polyData.size() == geometryData.size());
+
+  this->Internal->stopLoader();
+  this->Internal->FrameReps.clear();
+  this->Internal->Filenames.clear();
+  this->Internal->Ring.clear();
+
+  this->Internal->FrameRep = frameRep;
+  this->Internal->Frames.resize(polyData.size());
+  for (size_t i = 0; i < polyData.size(); ++i) {
+    this->Internal->Frames[i].Index = static_cast<int>(i);
+    this->Internal->Frames[i].PolyData = polyData[i];
+    this->Internal->Frames[i].GeometryData = geometryData[i];
+  }
+
+  this->Internal->NumberOfFrames = static_cast<int>(polyData.size());
+  this->Internal->CurrentFrame = 0;
+  this->Internal->LastFrame = 0;
+  this->Internal->ShownFrame = 0;
+  this->Internal->NumberOfDroppedFrames = 0;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiAnimationRepresentation::setStreamedFrames(vesKiwiPolyDataRepresentation::Ptr frameRep,
+                                                       const std::vector<std::string>& filenames,
+                                                       const vesKiwiDataLoader& loader,
+                                                       int prefetchCount)
+{
+  assert(frameRep);
+  assert(filenames.size());
+
+  this->Internal->stopLoader();
+  this->Internal->FrameReps.clear();
+  this->Internal->Frames.clear();
+
+  this->Internal->FrameRep = frameRep;
+  this->Internal->Filenames = filenames;
+  this->Internal->LoaderSettings.copySettings(loader);
+  this->Internal->NumberOfFrames = static_cast<int>(filenames.size());
+  this->Internal->CurrentFrame = 0;
+  this->Internal->LastFrame = 0;
+  this->Internal->ShownFrame = 0;
+  this->Internal->NumberOfDroppedFrames = 0;
+
+  prefetchCount = std::max(prefetchCount, 1);
+  this->Internal->Ring.assign(prefetchCount, vesInternal::DecodedFrame());
+  this->Internal->WindowStart = 0;
+  this->Internal->WindowSize = std::min(prefetchCount, this->Internal->NumberOfFrames);
+  this->Internal->AverageLoadTime = 0.0;
+  this->Internal->ShouldQuit = false;
+
+  this->Internal->ThreadId =
+    this->Internal->MultiThreader->SpawnThread(StreamLoop, this->Internal);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiAnimationRepresentation::isStreamed() const
+{
+  return !this->Internal->Filenames.empty();
+}
+
 //----------------------------------------------------------------------------
 bool vesKiwiAnimationRepresentation::handleDoubleTap(int displayX, int displayY)
 {
@@ -210,7 +528,7 @@ void vesKiwiAnimationRepresentation::onPlay()
 bool vesKiwiAnimationRepresentation::handleSingleTouchTap(int displayX, int displayY)
 {
 /*
-  vesVector2f textSize = this->Internal->PlayRep->textureSize();
+  vesVector2f textSize = this->Internal->PlayRep->textSize();
   double margin = 30;
   textSize += vesVector2f(margin, margin);
 
@@ -318,6 +636,12 @@ void vesKiwiAnimationRepresentation::setFramesPerSecond(float fps)
   }
 }
 
+//----------------------------------------------------------------------------
+float vesKiwiAnimationRepresentation::framesPerSecond() const
+{
+  return static_cast<float>(this->Internal->AnimationFramesPerSecond);
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiAnimationRepresentation::setCurrentFrame(int frameIndex)
 {
@@ -326,6 +650,24 @@ void vesKiwiAnimationRepresentation::setCurrentFrame(int frameIndex)
   this->Internal->CurrentFrame = frameIndex;
 }
 
+//----------------------------------------------------------------------------
+int vesKiwiAnimationRepresentation::currentFrame() const
+{
+  return this->Internal->CurrentFrame;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiAnimationRepresentation::numberOfFrames() const
+{
+  return this->Internal->NumberOfFrames;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiAnimationRepresentation::numberOfDroppedFrames() const
+{
+  return this->Internal->NumberOfDroppedFrames;
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiAnimationRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
 {
@@ -340,17 +682,26 @@ void vesKiwiAnimationRepresentation::willRender(vesSharedPtr<vesRenderer> render
 
     int elapsedFrames = static_cast<int>(elapsedTime * animationFramesPerSecond);
 
+    // Keep the remainder of the elapsed time so the frames advance at the
+    // target rate rather than somewhat below it.
     if (elapsedFrames != 0) {
       this->Internal->CurrentFrame += elapsedFrames;
       this->Internal->CurrentFrame = this->Internal->CurrentFrame % this->Internal->NumberOfFrames;
-      this->Internal->AnimationT0 = currentTime;
+      this->Internal->AnimationT0 += elapsedFrames / animationFramesPerSecond;
     }
   }
 
+  if (this->Internal->FrameRep && this->Internal->Filenames.size()) {
+    this->Internal->updateStreamedFrame();
+  }
+  else if (this->Internal->FrameRep && this->Internal->ShownFrame != this->Internal->CurrentFrame) {
+    this->Internal->showFrame(this->Internal->Frames[this->Internal->CurrentFrame]);
+  }
+
 /*
   int screenHeight = this->renderer()->height();
   double margin = 10;
-  vesVector2f textSize = this->Internal->PlayRep->textureSize();
+  vesVector2f textSize = this->Internal->PlayRep->textSize();
   this->Internal->PlayRep->setDisplayPosition(vesVector2f(margin, screenHeight - (margin + textSize[1])));
 */
 
@@ -372,6 +723,9 @@ void vesKiwiAnimationRepresentation::willRender(vesSharedPtr<vesRenderer> render
 //----------------------------------------------------------------------------
 vesKiwiPolyDataRepresentation::Ptr vesKiwiAnimationRepresentation::currentFrameRepresentation()
 {
+  if (this->Internal->FrameRep) {
+    return this->Internal->FrameRep;
+  }
   if (this->Internal->FrameReps.size()) {
     return this->Internal->FrameReps[this->Internal->CurrentFrame];
   }
@@ -19,13 +19,28 @@
  ========================================================================*/
 /// \class vesKiwiAnimationRepresentation
 /// \ingroup KiwiPlatform
+/// \brief Plays a series of poly data frames.
+///
+/// The frames are either given up front, as one representation per frame or
+/// as converted data shown by a single representation, or streamed from
+/// files.  Frames that share the connectivity of the shown frame only replace
+/// its vertex buffers.  A streamed series keeps a bounded ring of decoded
+/// frames ahead of the current frame, filled by a loader thread, and shows
+/// every frame with the same representation so no per frame actors or
+/// mappers are created.  Playback runs at the target frames per second and
+/// skips the frames that are not decoded by the time they are due.
 #ifndef __vesKiwiAnimationRepresentation_h
 #define __vesKiwiAnimationRepresentation_h
 
 #include "vesKiwiWidgetRepresentation.h"
 
+#include <vtkSmartPointer.h>
+
+class vesGeometryData;
 class vesShaderProgram;
+class vesKiwiDataLoader;
 class vesKiwiPolyDataRepresentation;
+class vtkPolyData;
 
 class vesKiwiAnimationRepresentation : public vesKiwiWidgetRepresentation
 {
@@ -39,6 +54,26 @@ public:
 
   void setRepresentations(const std::vector<vesSharedPtr<vesKiwiPolyDataRepresentation> > reps);
 
+  /// Show every frame with \p frameRep, which must already hold the first
+  /// one.  The frames are the polydata and geometry data produced by
+  /// vesKiwiPolyDataRepresentation::PreparePolyData().  Frames whose
+  /// geometry shares the primitives of the first one, see
+  /// vesKiwiDataConversionTools::AdoptTopology(), keep the index buffers of
+  /// \p frameRep and only upload their vertex arrays.
+  void setFrames(vesSharedPtr<vesKiwiPolyDataRepresentation> frameRep,
+                 const std::vector<vtkSmartPointer<vtkPolyData> >& polyData,
+                 const std::vector<vesSharedPtr<vesGeometryData> >& geometryData);
+
+  /// Stream the frames from \p filenames.  \p frameRep shows every frame and
+  /// must already hold the first one.  Up to \p prefetchCount frames after
+  /// the current frame are read and converted on a loader thread, using a
+  /// vesKiwiDataLoader with the settings and memory files of \p loader.
+  void setStreamedFrames(vesSharedPtr<vesKiwiPolyDataRepresentation> frameRep,
+                         const std::vector<std::string>& filenames,
+                         const vesKiwiDataLoader& loader,
+                         int prefetchCount = 8);
+  bool isStreamed() const;
+
   void initializeWithShader(vesSharedPtr<vesShaderProgram> geometryShader, 
     vesSharedPtr<vesShaderProgram> textureShader,
     vesSharedPtr<vesShaderProgram> gouraudTextureShader);
@@ -56,8 +91,18 @@ public:
   virtual std::vector<std::string> actions() const;
   virtual bool handleAction(const std::string& action);
 
+  /// Set the target playback rate.  Streamed frames that are not decoded in
+  /// time are dropped so that playback keeps this rate.
   void setFramesPerSecond(float fps);
+  float framesPerSecond() const;
+
   void setCurrentFrame(int frameIndex);
+  int currentFrame() const;
+  int numberOfFrames() const;
+
+  /// The number of streamed frames skipped during playback because they were
+  /// not decoded when they were due.
+  int numberOfDroppedFrames() const;
 
   void onPlay();
   void onPause();
@@ -68,12 +113,15 @@ protected:
 
   vesSharedPtr<vesKiwiPolyDataRepresentation> currentFrameRepresentation();
 
+public:
+
+  class vesInternal;
+
 private:
 
   vesKiwiAnimationRepresentation(const vesKiwiAnimationRepresentation&); // Not implemented
   void operator=(const vesKiwiAnimationRepresentation&); // Not implemented
 
-  class vesInternal;
   vesInternal* Internal;
 };
 
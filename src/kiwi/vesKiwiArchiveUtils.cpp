@@ -25,15 +25,73 @@
 #include <sys/stat.h>
 #include <archive.h>
 #include <archive_entry.h>
-#include <fcntl.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>
+
+#if !defined(_WIN32)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+#include <vtksys/SystemTools.hxx>
 
 
 namespace {
 
+// Map a whole file read only.  Where mmap is not available the file is read
+// into memory instead.  Returns 0 on failure.
+void* map_file(const std::string& filename, size_t* length)
+{
+#if defined(_WIN32)
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (!file) {
+    return 0;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  void* data = size > 0 ? malloc(size) : 0;
+  if (data && fread(data, 1, size, file) != static_cast<size_t>(size)) {
+    free(data);
+    data = 0;
+  }
+  fclose(file);
+  *length = data ? static_cast<size_t>(size) : 0;
+  return data;
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return 0;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return 0;
+  }
+
+  void* mapped = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (mapped == MAP_FAILED) {
+    return 0;
+  }
+  *length = static_cast<size_t>(st.st_size);
+  return mapped;
+#endif
+}
+
+void unmap_file(void* data, size_t length)
+{
+#if defined(_WIN32)
+  (void)length;
+  free(data);
+#else
+  munmap(data, length);
+#endif
+}
+
 int copy_data(struct archive *ar, struct archive *aw)
 {
   int r;
@@ -55,21 +113,267 @@ int copy_data(struct archive *ar, struct archive *aw)
   }
 }
 
+unsigned int read_uint16(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8);
 }
 
-vesKiwiArchiveUtils::vesKiwiArchiveUtils()
+unsigned int read_uint32(const unsigned char* p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<unsigned int>(p[3]) << 24);
+}
+
+const unsigned int zip_end_of_central_dir_signature = 0x06054b50;
+const unsigned int zip_central_dir_signature = 0x02014b50;
+const unsigned int zip_local_header_signature = 0x04034b50;
+
+}
+
+vesKiwiArchiveUtils::vesKiwiArchiveUtils() :
+  mMappedFile(0),
+  mMappedFileLength(0),
+  mMappedEntryBytes(0)
 {
 
 }
 
 vesKiwiArchiveUtils::~vesKiwiArchiveUtils()
 {
+  this->releaseEntryData();
+}
+
+void vesKiwiArchiveUtils::releaseEntryData()
+{
+  for (size_t i = 0; i < this->mBuffers.size(); ++i) {
+    delete this->mBuffers[i];
+  }
+  this->mBuffers.clear();
+  this->mEntryData.clear();
+
+  if (this->mMappedFile) {
+    unmap_file(this->mMappedFile, this->mMappedFileLength);
+    this->mMappedFile = 0;
+    this->mMappedFileLength = 0;
+  }
+  this->mMappedEntryBytes = 0;
+}
+
+void vesKiwiArchiveUtils::mapStoredZipEntries(const std::string& filename, const std::string& destDir)
+{
+  size_t length = 0;
+  void* mapped = map_file(filename, &length);
+  if (!mapped) {
+    return;
+  }
+  if (length < 22) {
+    unmap_file(mapped, length);
+    return;
+  }
+
+  const unsigned char* bytes = static_cast<const unsigned char*>(mapped);
+
+  // The end of central directory record is at the end of the file, followed
+  // by an archive comment of at most 64k.
+  size_t eocd = 0;
+  bool foundEocd = false;
+  size_t searchStart = length >= 22 + 0xffff ? length - 22 - 0xffff : 0;
+  for (size_t i = length - 21; i > searchStart; --i) {
+    if (read_uint32(bytes + i - 1) == zip_end_of_central_dir_signature) {
+      eocd = i - 1;
+      foundEocd = true;
+      break;
+    }
+  }
+
+  if (!foundEocd) {
+    // Not a zip file, libarchive decodes everything.
+    unmap_file(mapped, length);
+    return;
+  }
+
+  this->mMappedFile = mapped;
+  this->mMappedFileLength = length;
+
+  const unsigned int numberOfEntries = read_uint16(bytes + eocd + 10);
+  size_t offset = read_uint32(bytes + eocd + 16);
+
+  for (unsigned int i = 0; i < numberOfEntries; ++i) {
+
+    if (offset + 46 > length || read_uint32(bytes + offset) != zip_central_dir_signature) {
+      break;
+    }
+
+    const unsigned char* header = bytes + offset;
+    const unsigned int method = read_uint16(header + 10);
+    const size_t compressedSize = read_uint32(header + 20);
+    const size_t uncompressedSize = read_uint32(header + 24);
+    const unsigned int nameLength = read_uint16(header + 28);
+    const unsigned int extraLength = read_uint16(header + 30);
+    const unsigned int commentLength = read_uint16(header + 32);
+    const size_t localHeaderOffset = read_uint32(header + 42);
+
+    std::string name(reinterpret_cast<const char*>(header + 46), nameLength);
+    offset += 46 + nameLength + extraLength + commentLength;
+
+    // Only stored entries can be used in place.  Zip64 entries have their
+    // sizes in the extra field, leave those to libarchive.
+    if (method != 0 || compressedSize != uncompressedSize
+        || compressedSize == 0xffffffff || localHeaderOffset == 0xffffffff
+        || name.empty() || name[name.size() - 1] == '/') {
+      continue;
+    }
+
+    if (localHeaderOffset + 30 > length
+        || read_uint32(bytes + localHeaderOffset) != zip_local_header_signature) {
+      continue;
+    }
+
+    const unsigned char* localHeader = bytes + localHeaderOffset;
+    const size_t dataOffset = localHeaderOffset + 30
+      + read_uint16(localHeader + 26) + read_uint16(localHeader + 28);
+    if (dataOffset + compressedSize > length) {
+      continue;
+    }
+
+    if (destDir.size()) {
+      name = destDir + "/" + name;
+    }
+
+    EntryData entryData;
+    entryData.Data = reinterpret_cast<const char*>(bytes + dataOffset);
+    entryData.Length = compressedSize;
+    this->mEntryData[name] = entryData;
+    this->mMappedEntryBytes += compressedSize;
+  }
+}
+
+bool vesKiwiArchiveUtils::readArchive(const std::string& filename, const std::string& destDir)
+{
+  this->mEntries.clear();
+  this->releaseEntryData();
+
+  this->mapStoredZipEntries(filename, destDir);
+
+  struct archive *a;
+  struct archive_entry *entry;
+  int r;
 
+  a = archive_read_new();
+  archive_read_support_format_all(a);
+  archive_read_support_compression_all(a);
+
+  if ((r = archive_read_open_file(a, filename.c_str(), 10240))) {
+    this->setError("Error Opening File", "Failed to open file: " + filename);
+    archive_read_free(a);
+    return false;
+  }
+
+  for (;;) {
+    r = archive_read_next_header(a, &entry);
+    if (r == ARCHIVE_EOF)
+      break;
+    if (r != ARCHIVE_OK)
+      fprintf(stderr, "%s\n", archive_error_string(a));
+    if (r < ARCHIVE_WARN) {
+      this->setError("Error Reading Archive", archive_error_string(a));
+      archive_read_free(a);
+      return false;
+    }
+
+    if (archive_entry_filetype(entry) != AE_IFREG) {
+      archive_read_data_skip(a);
+      continue;
+    }
+
+    std::string destPath = archive_entry_pathname(entry);
+    if (destDir.size()) {
+      destPath = destDir + "/" + destPath;
+    }
+
+    this->mEntries.push_back(destPath);
+
+    // Stored zip entries are already mapped, skip over their data.
+    if (this->mEntryData.find(destPath) != this->mEntryData.end()) {
+      archive_read_data_skip(a);
+      continue;
+    }
+
+    std::vector<char>* buffer = new std::vector<char>();
+    this->mBuffers.push_back(buffer);
+    if (archive_entry_size_is_set(entry)) {
+      buffer->reserve(static_cast<size_t>(archive_entry_size(entry)));
+    }
+
+    char block[65536];
+    for (;;) {
+      ssize_t size = archive_read_data(a, block, sizeof(block));
+      if (size == 0) {
+        break;
+      }
+      if (size < 0) {
+        this->setError("Error Reading Archive", archive_error_string(a));
+        archive_read_free(a);
+        return false;
+      }
+      buffer->insert(buffer->end(), block, block + size);
+    }
+
+    EntryData entryData;
+    entryData.Data = buffer->empty() ? 0 : &(*buffer)[0];
+    entryData.Length = buffer->size();
+    this->mEntryData[destPath] = entryData;
+  }
+
+  archive_read_close(a);
+  archive_read_free(a);
+  return true;
+}
+
+bool vesKiwiArchiveUtils::entryData(const std::string& entry, const char*& data, size_t& length) const
+{
+  std::map<std::string, EntryData>::const_iterator itr = this->mEntryData.find(entry);
+  if (itr == this->mEntryData.end()) {
+    return false;
+  }
+
+  data = itr->second.Data;
+  length = itr->second.Length;
+  return true;
+}
+
+bool vesKiwiArchiveUtils::writeEntry(const std::string& entry)
+{
+  const char* data;
+  size_t length;
+  if (!this->entryData(entry, data, length)) {
+    return false;
+  }
+
+  std::string dir = vtksys::SystemTools::GetFilenamePath(entry);
+  if (dir.size() && !vtksys::SystemTools::MakeDirectory(dir.c_str())) {
+    this->setError("Error Writing File", "Failed to create directory: " + dir);
+    return false;
+  }
+
+  FILE* file = fopen(entry.c_str(), "wb");
+  if (!file) {
+    this->setError("Error Writing File", "Failed to open file for writing: " + entry);
+    return false;
+  }
+
+  bool success = (length == 0 || fwrite(data, 1, length, file) == length);
+  fclose(file);
+
+  if (!success) {
+    this->setError("Error Writing File", "Failed to write file: " + entry);
+  }
+  return success;
 }
 
 bool vesKiwiArchiveUtils::extractArchive(const std::string& filename, const std::string& destDir)
 {
   this->mEntries.clear();
+  this->releaseEntryData();
 
 
   struct archive *a;
@@ -22,6 +22,7 @@
 #ifndef __vesKiwiArchiveUtils_h
 #define __vesKiwiArchiveUtils_h
 
+#include <map>
 #include <string>
 #include <vector>
 
@@ -35,6 +36,29 @@ public:
 
   bool extractArchive(const std::string& filename, const std::string& destDir);
 
+  /// Read the file entries of the archive into memory without writing
+  /// anything to disk.  Stored (uncompressed) zip entries are not copied, they
+  /// point into a read-only memory mapping of the archive file.  As with
+  /// extractArchive(), entry names are prefixed with destDir.  Directory
+  /// entries are skipped.
+  bool readArchive(const std::string& filename, const std::string& destDir);
+
+  /// Get the contents of an entry read by readArchive().  The data stays valid
+  /// until the next call to readArchive() or extractArchive(), or until this
+  /// object is destroyed.
+  bool entryData(const std::string& entry, const char*& data, size_t& length) const;
+
+  /// Write an entry read by readArchive() to disk at its entry path, for
+  /// files that cannot be loaded from memory.
+  bool writeEntry(const std::string& entry);
+
+  /// Return the number of bytes of entry data that are mapped from the
+  /// archive file rather than decompressed into memory.
+  size_t mappedEntryBytes() const
+  {
+    return this->mMappedEntryBytes;
+  }
+
   const std::vector<std::string>& entries() const;
 
   std::string errorTitle() const
@@ -64,12 +88,30 @@ protected:
     }
   }
 
+  void mapStoredZipEntries(const std::string& filename, const std::string& destDir);
+  void releaseEntryData();
+
 private:
 
+  vesKiwiArchiveUtils(const vesKiwiArchiveUtils&); // Not implemented
+  void operator=(const vesKiwiArchiveUtils&); // Not implemented
+
+  struct EntryData
+  {
+    const char* Data;
+    size_t Length;
+  };
+
   std::string mErrorTitle;
   std::string mErrorMessage;
   std::vector<std::string> mEntries;
 
+  std::map<std::string, EntryData> mEntryData;
+  std::vector<std::vector<char>* > mBuffers;
+  void* mMappedFile;
+  size_t mMappedFileLength;
+  size_t mMappedEntryBytes;
+
 };
 
 #endif
@@ -21,12 +21,16 @@
 #include <vesKiwiBaseApp.h>
 #include <vesKiwiCameraInteractor.h>
 #include <vesCamera.h>
+#include <vesImage.h>
+#include <vesOffscreenRenderTarget.h>
 #include <vesOpenGLSupport.h>
+#include <vesProfiler.h>
 #include <vesRenderer.h>
 #include <vesSetGet.h>
 #include <vesUniform.h>
 #include <vesVertexAttribute.h>
 #include <vesShader.h>
+#include <vesProgramBinaryCache.h>
 #include <vesShaderProgram.h>
 #include <vesModelViewUniform.h>
 #include <vesNormalMatrixUniform.h>
@@ -53,11 +57,35 @@ public:
 
   ~vesInternal()
   {
+    if (this->ProgramBinaryCache
+        && vesShaderProgram::programBinaryCache() == this->ProgramBinaryCache.get()) {
+      vesShaderProgram::setProgramBinaryCache(0);
+    }
   }
 
   vesOpenGLSupport::Ptr GLSupport;
   vesRenderer::Ptr Renderer;
   vesKiwiCameraInteractor::Ptr CameraInteractor;
+  vesProfiler::Ptr Profiler;
+  vesOffscreenRenderTarget::Ptr OffscreenTarget;
+  vesOffscreenRenderTarget::Ptr ImageTarget;
+  std::string ProgramBinaryCacheDirectory;
+  vesProgramBinaryCache::Ptr ProgramBinaryCache;
+
+  // Each app sets its own cache on the thread of its context, so apps
+  // rendering on worker threads never share it.
+  void setupProgramBinaryCache()
+  {
+    this->ProgramBinaryCache.reset();
+    if (!this->ProgramBinaryCacheDirectory.empty()) {
+      this->ProgramBinaryCache = vesProgramBinaryCache::Ptr(
+        new vesProgramBinaryCache(this->ProgramBinaryCacheDirectory));
+      if (!this->ProgramBinaryCache->initialize()) {
+        this->ProgramBinaryCache.reset();
+      }
+    }
+    vesShaderProgram::setProgramBinaryCache(this->ProgramBinaryCache.get());
+  }
 
   std::vector< vesSharedPtr<vesShaderProgram> > ShaderPrograms;
   std::vector< vesSharedPtr<vesShader> > Shaders;
@@ -85,6 +113,140 @@ void vesKiwiBaseApp::initGL()
     return;
   }
   this->Internal->GLSupport->initialize();
+  this->Internal->setupProgramBinaryCache();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::setProgramBinaryCacheDirectory(const std::string& directory)
+{
+  this->Internal->ProgramBinaryCacheDirectory = directory;
+  if (this->Internal->GLSupport->isInitialized()) {
+    this->Internal->setupProgramBinaryCache();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::setProfilingEnabled(bool enabled, int numberOfFrames)
+{
+  if (!enabled) {
+    this->Internal->Renderer->setProfiler(vesProfiler::Ptr());
+    return;
+  }
+
+  if (!this->Internal->Profiler
+      || this->Internal->Profiler->capacity() != numberOfFrames) {
+    vesProfiler::Ptr profiler(new vesProfiler(numberOfFrames));
+    if (this->Internal->Profiler) {
+      profiler->setGPUTimersEnabled(this->Internal->Profiler->gpuTimersEnabled());
+    }
+    this->Internal->Profiler = profiler;
+  }
+  this->Internal->Renderer->setProfiler(this->Internal->Profiler);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::isProfilingEnabled() const
+{
+  return this->Internal->Renderer->profiler().get() != 0;
+}
+
+//----------------------------------------------------------------------------
+vesProfiler::Ptr vesKiwiBaseApp::profiler() const
+{
+  return this->Internal->Profiler;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::writeProfileTrace(const std::string& fileName) const
+{
+  if (!this->Internal->Profiler) {
+    return false;
+  }
+  return this->Internal->Profiler->writeChromeTrace(fileName);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiBaseApp::setOffscreenRenderingEnabled(bool enabled, int width, int height)
+{
+  if (!enabled) {
+    this->Internal->Renderer->setOffscreenTarget(vesOffscreenRenderTarget::Ptr());
+    return;
+  }
+
+  if (!this->Internal->OffscreenTarget) {
+    this->Internal->OffscreenTarget = vesOffscreenRenderTarget::Ptr(new vesOffscreenRenderTarget());
+  }
+  this->Internal->OffscreenTarget->setSize(width, height);
+  this->Internal->Renderer->setOffscreenTarget(this->Internal->OffscreenTarget);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiBaseApp::isOffscreenRenderingEnabled() const
+{
+  return this->Internal->Renderer->offscreenTarget().get() != 0;
+}
+
+//----------------------------------------------------------------------------
+vesImage::Ptr vesKiwiBaseApp::offscreenImage() const
+{
+  if (!this->Internal->OffscreenTarget) {
+    return vesImage::Ptr();
+  }
+  return this->Internal->OffscreenTarget->image();
+}
+
+//----------------------------------------------------------------------------
+vesImage::Ptr vesKiwiBaseApp::renderImage(int width, int height)
+{
+  return this->renderImageTile(width, height, 0, 0, width, height);
+}
+
+//----------------------------------------------------------------------------
+vesImage::Ptr vesKiwiBaseApp::renderImageTile(int imageWidth, int imageHeight,
+                                              int x, int y, int width, int height)
+{
+  // A target of its own, so that the frames of offscreen rendering pending
+  // readback are not dropped.
+  vesOffscreenRenderTarget::Ptr& target = this->Internal->ImageTarget;
+  if (!target) {
+    target = vesOffscreenRenderTarget::Ptr(new vesOffscreenRenderTarget());
+    target->setAsynchronousReadback(false);
+  }
+  target->setSize(width, height);
+  target->setImageRegion(imageWidth, imageHeight, x, y);
+
+  const bool isTile = x != 0 || y != 0 || width != imageWidth || height != imageHeight;
+  vesCamera::Ptr camera = this->camera();
+  const float viewAngle = camera->viewAngle();
+  const float parallelScale = camera->parallelScale();
+  const vesVector2f windowCenter = camera->windowCenter();
+
+  // The tile sees the fraction of the image's view angle or scale that its
+  // size is of the image size, and its window center is the offset of its
+  // center from the image's in units of its own half size.
+  if (isTile) {
+    const double scale = camera->useHorizontalViewAngle()
+      ? static_cast<double>(width) / imageWidth
+      : static_cast<double>(height) / imageHeight;
+    const double halfAngle = deg2Rad(viewAngle) / 2.0;
+    camera->setViewAngle(2.0 * atan(tan(halfAngle) * scale) * 180.0 / M_PI);
+    camera->setParallelScale(parallelScale * height / imageHeight);
+    camera->setWindowCenter(
+      (2.0 * x + width - imageWidth + windowCenter[0] * imageWidth) / width,
+      (2.0 * y + height - imageHeight + windowCenter[1] * imageHeight) / height);
+  }
+
+  vesOffscreenRenderTarget::Ptr previousTarget = this->Internal->Renderer->offscreenTarget();
+  this->Internal->Renderer->setOffscreenTarget(target);
+  this->render();
+  this->Internal->Renderer->setOffscreenTarget(previousTarget);
+
+  if (isTile) {
+    camera->setViewAngle(viewAngle);
+    camera->setParallelScale(parallelScale);
+    camera->setWindowCenter(windowCenter[0], windowCenter[1]);
+  }
+  return target->image();
 }
 
 //----------------------------------------------------------------------------
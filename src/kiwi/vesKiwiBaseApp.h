@@ -34,7 +34,9 @@
 #include <string>
 
 class vesCamera;
+class vesImage;
 class vesOpenGLSupport;
+class vesProfiler;
 class vesRenderer;
 class vesShader;
 class vesShaderProgram;
@@ -152,6 +154,56 @@ public:
   /// before initGL().
   vesSharedPtr<vesOpenGLSupport> glSupport();
 
+  /// Store linked shader programs in the given directory so that later runs
+  /// load them instead of compiling from source.  The directory must exist.
+  /// Takes effect at initGL(), or immediately if initGL() was called, and
+  /// applies to the thread the app renders on.
+  void setProgramBinaryCacheDirectory(const std::string& directory);
+
+  /// Record the timings and draw counts of the last \p numberOfFrames
+  /// renders.  Disabling keeps the recorded frames until profiling is
+  /// enabled again.
+  /// \see vesProfiler
+  void setProfilingEnabled(bool enabled, int numberOfFrames = 300);
+  bool isProfilingEnabled() const;
+
+  /// Return the profiler, or a null pointer if profiling was never enabled.
+  /// Call vesProfiler::setGPUTimersEnabled() on it to time the GPU as well.
+  vesSharedPtr<vesProfiler> profiler() const;
+
+  /// Write the recorded frames as a Chrome trace.  Returns false if
+  /// profiling was never enabled or the file could not be written.
+  bool writeProfileTrace(const std::string& fileName) const;
+
+  /// Render into an offscreen target of the given size instead of the view,
+  /// reading every frame back into offscreenImage().  Where the driver has
+  /// pixel buffer objects the readback does not stall rendering, and the
+  /// image lags one frame behind.
+  /// \see vesOffscreenRenderTarget
+  void setOffscreenRenderingEnabled(bool enabled, int width = 0, int height = 0);
+  bool isOffscreenRenderingEnabled() const;
+
+  /// Return the last frame read back while rendering offscreen, in RGBA
+  /// with the bottom row first, or a null pointer.
+  vesSharedPtr<vesImage> offscreenImage() const;
+
+  /// Render one frame offscreen at the given size and return it, in RGBA
+  /// with the bottom row first.  The view is not changed.  The image is
+  /// reused by the next call with the same size, so copy it to keep it.
+  vesSharedPtr<vesImage> renderImage(int width, int height);
+
+  /// Render one tile of a larger image offscreen and return it, in RGBA with
+  /// the bottom row first.  The tile is the rectangle of the given size at
+  /// pixel (x, y) from the bottom left corner of an image of size
+  /// imageWidth x imageHeight, as seen with the current view resized to the
+  /// image size.  Tiles larger images than renderImage() can be rendered
+  /// from, and can be rendered in parallel by apps sharing a view.
+  /// The background and 2D items are laid out in the image, each tile draws
+  /// the part it covers.
+  /// \see vesCamera::setWindowCenter()
+  vesSharedPtr<vesImage> renderImageTile(int imageWidth, int imageHeight,
+                                         int x, int y, int width, int height);
+
   /// Return the camera interactor used by the app instance for handling
   /// touch gestures.
   vesSharedPtr<vesKiwiCameraInteractor> cameraInteractor() const;
@@ -19,9 +19,7 @@
  ========================================================================*/
 
 #include "vesKiwiBaselineImageTester.h"
-#include "vesGL.h"
-#include "vesGLTypes.h"
-#include "vesOpenGLSupport.h"
+#include "vesImage.h"
 #include "vesKiwiBaseApp.h"
 
 #include <vtkErrorCode.h>
@@ -88,14 +86,24 @@ vtkSmartPointer<vtkImageData> vesKiwiBaselineImageTester::imageFromRenderView()
   int width = this->app()->viewWidth();
   int height = this->app()->viewHeight();
 
+  // The frame is rendered again offscreen, where the color buffer has 8 bits
+  // per channel whatever the format of the window.
+  vesImage::Ptr rendered = this->app()->renderImage(width, height);
+  if (!rendered) {
+    return 0;
+  }
+
   vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
   image->SetDimensions(width, height, 1);
   image->AllocateScalars(VTK_UNSIGNED_CHAR, 3);
 
+  const unsigned char* inPtr = static_cast<const unsigned char*>(rendered->data());
   unsigned char* outPtr = static_cast<unsigned char*>(image->GetScalarPointer(0, 0, 0));
-  vesOpenGLSupport::readBuffer(0, 0, width, height, vesColorDataType::RGB,
-                               vesColorDataType::UnsignedByte, (void*)outPtr,
-                               vesBufferType::Back);
+  for (int i = 0; i < width * height; ++i, inPtr += 4, outPtr += 3) {
+    outPtr[0] = inPtr[0];
+    outPtr[1] = inPtr[1];
+    outPtr[2] = inPtr[2];
+  }
   return image;
 }
 
@@ -117,6 +125,11 @@ bool vesKiwiBaselineImageTester::performTest(const std::string& testName, double
   vtkSmartPointer<vtkImageData> baselineImage = this->imageFromFile(inFile);
   vtkSmartPointer<vtkImageData> image = this->imageFromRenderView();
 
+  if (!image) {
+    std::cout << "Could not render test image: " << testName << std::endl;
+    return false;
+  }
+
   if (!baselineImage) {
     std::cout << "Could not read baseline image: " << inFile << std::endl;
     this->writeImage(image, outFile.c_str());
@@ -22,8 +22,8 @@
 /// \brief A class for testing rendered images against baseline images
 //
 /// This class uses the vtk filter vtkImageDifference to test rendered images
-/// against baseline images.  It uses a GL call to fetch pixels from the
-/// current GL context and converts them to a vtkImageData for comparison.
+/// against baseline images.  It renders the scene of the app offscreen and
+/// converts the pixels to a vtkImageData for comparison.
 /// This class also performs I/O to read baseline images and write difference images.
 #ifndef __vesKiwiBaselineImageTester_h
 #define __vesKiwiBaselineImageTester_h
@@ -59,9 +59,9 @@ public:
   /// filename.  The filename must be a PNG image.  Returns the output of the reader.
   vtkSmartPointer<vtkImageData> imageFromFile(const std::string& filename);
 
-  /// Uses the GL call glReadPixels to read GL_RGB pixels from the current context and
-  /// returns the result as a vtkImageData.  The width and height of the pixel buffer is
-  /// determined by the current vesKiwiBaseApp.
+  /// Renders the scene of the current vesKiwiBaseApp offscreen and returns the RGB pixels
+  /// as a vtkImageData, or a null pointer on failure.  The width and height of the image
+  /// are those of the app's view.
   /// \see setApp()
   /// \see vesKiwiBaseApp::viewWidth()
   /// \see vesKiwiBaseApp::viewHeight()
@@ -24,7 +24,7 @@
 #include "vesCamera.h"
 #include "vesMapper.h"
 #include "vesActor.h"
-#include "vesKiwiDataLoader.h"
+#include "vesKiwiParallelDataLoader.h"
 #include "vesKiwiText2DRepresentation.h"
 #include "vesKiwiPolyDataRepresentation.h"
 #include "vesEigen.h"
@@ -133,6 +133,12 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
 
   f.open(modelInfoFile.c_str());
 
+  // Read the whole model list first and queue every model file, so that the
+  // models are read and converted concurrently.
+  vesKiwiParallelDataLoader loader;
+  std::vector<std::string> anatomicalNames;
+  std::vector<vesVector3f> colors;
+
   while (!f.eof()) {
 
     std::string anatomicalName;
@@ -148,13 +154,25 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
 
     modelFile = dataDir + "/" + modelFile;
 
-    vesKiwiDataLoader dataLoader;
-    vtkSmartPointer<vtkPolyData> polyData = vtkPolyData::SafeDownCast(dataLoader.loadDataset(modelFile));
-    if (!polyData) {
-      std::cout << "Failed to read: " << modelFile << std::endl;
+    loader.addFile(modelFile);
+    anatomicalNames.push_back(anatomicalName);
+    colors.push_back(vesVector3f(color[0], color[1], color[2]));
+  }
+
+  loader.start();
+
+  for (int taskIndex = 0; taskIndex < loader.numberOfTasks(); ++taskIndex) {
+
+    const std::string& anatomicalName = anatomicalNames[taskIndex];
+    const vesVector3f& color = colors[taskIndex];
+
+    if (!loader.waitForTask(taskIndex) || !loader.geometryData(taskIndex)) {
+      std::cout << "Failed to read: " << loader.filename(taskIndex) << std::endl;
       continue;
     }
 
+    vtkSmartPointer<vtkPolyData> polyData = loader.polyData(taskIndex);
+
     vesSharedPtr<vesShaderProgram> shader = this->Internal->GeometryShader;
 
     double opacity = 1.0;
@@ -166,7 +184,7 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
 
     vesKiwiPolyDataRepresentation::Ptr rep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation);
     rep->initializeWithShader(shader);
-    rep->setPolyData(polyData);
+    rep->setPreparedPolyData(polyData, loader.geometryData(taskIndex));
     rep->setColor(color[0], color[1], color[2], opacity);
     rep->setBinNumber(binNumber);
     this->Internal->AllReps.push_back(rep);
@@ -179,7 +197,7 @@ void vesKiwiBrainAtlasRepresentation::loadData(const std::string& filename)
     this->Internal->AnatomicalModels.push_back(rep);
     this->Internal->ModelStatus.push_back(true);
     this->Internal->ModelSceneStatus.push_back(true);
-    this->Internal->Colors.push_back(vesVector3f(color[0], color[1], color[2]));
+    this->Internal->Colors.push_back(color);
 
 
     double center[3];
@@ -22,11 +22,14 @@
 #include "vesCamera.h"
 #include "vesRenderer.h"
 
+#include <vtkTimerLog.h>
+
 #include <cstdio>
 
 //----------------------------------------------------------------------------
 vesKiwiCameraInteractor::vesKiwiCameraInteractor()
 {
+  mLastMotionTime = 0.0;
 }
 
 //----------------------------------------------------------------------------
@@ -49,6 +52,8 @@ vesRenderer::Ptr vesKiwiCameraInteractor::renderer() const
 //----------------------------------------------------------------------------
 void vesKiwiCameraInteractor::dolly(double scale)
 {
+  mLastMotionTime = vtkTimerLog::GetUniversalTime();
+
   vesCamera::Ptr camera = mRenderer->camera();
   if (camera->parallelProjection()) {
     camera->setParallelScale((1.0/scale)*camera->parallelScale());
@@ -61,6 +66,8 @@ void vesKiwiCameraInteractor::dolly(double scale)
 //----------------------------------------------------------------------------
 void vesKiwiCameraInteractor::roll(double rotation)
 {
+  mLastMotionTime = vtkTimerLog::GetUniversalTime();
+
   vesCamera::Ptr camera = mRenderer->camera();
   camera->roll(rotation * 180.0 / M_PI);
   camera->orthogonalizeViewUp();
@@ -69,6 +76,8 @@ void vesKiwiCameraInteractor::roll(double rotation)
 //----------------------------------------------------------------------------
 void vesKiwiCameraInteractor::rotate(const vesVector2d& screenTranslation)
 {
+  mLastMotionTime = vtkTimerLog::GetUniversalTime();
+
   //
   // Rotate camera
   // Based on vtkInteractionStyleTrackballCamera::Rotate().
@@ -90,6 +99,8 @@ void vesKiwiCameraInteractor::rotate(const vesVector2d& screenTranslation)
 //----------------------------------------------------------------------------
 void vesKiwiCameraInteractor::pan(const vesVector2d& p0, const vesVector2d& p1)
 {
+  mLastMotionTime = vtkTimerLog::GetUniversalTime();
+
   // calculate the focal depth so we'll know how far to move
   vesCamera::Ptr camera = mRenderer->camera();
   vesVector3f viewFocus = camera->focalPoint();
@@ -108,3 +119,9 @@ void vesKiwiCameraInteractor::pan(const vesVector2d& p0, const vesVector2d& p1)
   camera->setFocalPoint(newViewFocus);
   camera->setPosition(newViewPoint);
 }
+
+//----------------------------------------------------------------------------
+double vesKiwiCameraInteractor::lastMotionTime() const
+{
+  return mLastMotionTime;
+}
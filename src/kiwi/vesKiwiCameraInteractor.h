@@ -60,12 +60,17 @@ public:
   /// p0 and p1 define the end points of a movement on the screen.
   void pan(const vesVector2d& p0, const vesVector2d& p1);
 
+  /// Time in seconds, as given by vtkTimerLog::GetUniversalTime(), of the
+  /// last camera motion, or 0 if the camera has not been moved yet.
+  double lastMotionTime() const;
+
 private:
 
   vesKiwiCameraInteractor(const vesKiwiCameraInteractor&); // Not implemented
   void operator=(const vesKiwiCameraInteractor&); // Not implemented
 
   vesSharedPtr<vesRenderer> mRenderer;
+  double mLastMotionTime;
 };
 
 #endif
@@ -21,9 +21,16 @@
 #include "vesKiwiCurlDownloader.h"
 
 #include <curl/curl.h>
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <sys/select.h>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include <vector>
 
+#include <vtksys/MD5.h>
 #include <vtksys/SystemTools.hxx>
 
 namespace {
@@ -66,10 +73,110 @@ int progress_function(void* userData, double totalToDownload, double nowDownload
   return static_cast<vesKiwiCurlDownloader::ProgressDelegate*>(userData)->downloadProgress(totalToDownload, nowDownloaded);
 }
 
+struct RangeQuery
+{
+  vesKiwiCurlDownloader* Downloader;
+  bool AcceptsRanges;
+};
+
+size_t range_header_function(char *buffer, size_t size, size_t nmemb, void *userData)
+{
+  size_t totalSize = size*nmemb;
+  RangeQuery& query = *static_cast<RangeQuery*>(userData);
+
+  std::string header(buffer, totalSize);
+  for (size_t i = 0; i < header.size(); ++i) {
+    header[i] = tolower(header[i]);
+  }
+
+  if (header.find("accept-ranges:") == 0 && header.find("bytes") != std::string::npos) {
+    query.AcceptsRanges = true;
+  }
+
+  // a redirect starts a new set of headers
+  if (header.find("http/") == 0) {
+    query.AcceptsRanges = false;
+  }
 
+  return header_function(buffer, size, nmemb, query.Downloader);
 }
 
-vesKiwiCurlDownloader::vesKiwiCurlDownloader()
+// One byte range of a ranged download.  All chunks of a download share the
+// same FILE, which is safe because curl multi runs every callback on the
+// thread that calls curl_multi_perform.
+struct DownloadChunk
+{
+  long long Begin;
+  long long End;
+  long long Done;
+  FILE* File;
+  CURL* Handle;
+};
+
+size_t write_chunk(char *buffer, size_t size, size_t nmemb, void *userData)
+{
+  size_t totalSize = size*nmemb;
+  DownloadChunk& chunk = *static_cast<DownloadChunk*>(userData);
+
+  // never write past the end of the requested range
+  long long remaining = chunk.End + 1 - (chunk.Begin + chunk.Done);
+  if (static_cast<long long>(totalSize) > remaining) {
+    return 0;
+  }
+
+  if (fseeko(chunk.File, chunk.Begin + chunk.Done, SEEK_SET) != 0
+      || fwrite(buffer, 1, totalSize, chunk.File) != totalSize) {
+    return 0;
+  }
+
+  chunk.Done += totalSize;
+  return totalSize;
+}
+
+bool readRangeState(const std::string& stateFile, const std::string& url, long long totalSize, std::vector<DownloadChunk>& chunks)
+{
+  std::ifstream state(stateFile.c_str());
+  std::string stateUrl;
+  long long stateTotalSize = -1;
+  size_t numberOfChunks = 0;
+  if (!std::getline(state, stateUrl) || stateUrl != url
+      || !(state >> stateTotalSize >> numberOfChunks) || stateTotalSize != totalSize) {
+    return false;
+  }
+
+  chunks.resize(numberOfChunks);
+  for (size_t i = 0; i < numberOfChunks; ++i) {
+    if (!(state >> chunks[i].Begin >> chunks[i].End >> chunks[i].Done)) {
+      chunks.clear();
+      return false;
+    }
+  }
+
+  return !chunks.empty();
+}
+
+void writeRangeState(const std::string& stateFile, const std::string& url, long long totalSize, const std::vector<DownloadChunk>& chunks)
+{
+  // write a new file and rename it so a crash never leaves half a state
+  const std::string temporaryFile = stateFile + ".tmp";
+  std::ofstream state(temporaryFile.c_str(), std::ios::out | std::ios::trunc);
+  state << url << std::endl;
+  state << totalSize << " " << chunks.size() << std::endl;
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    state << chunks[i].Begin << " " << chunks[i].End << " " << chunks[i].Done << std::endl;
+  }
+  state.close();
+  if (state) {
+    vtksys::SystemTools::RenameFile(temporaryFile.c_str(), stateFile.c_str());
+  }
+}
+
+
+}
+
+vesKiwiCurlDownloader::vesKiwiCurlDownloader() :
+  mNumberOfConnections(1),
+  mResumeEnabled(false)
 {
   this->m_curl = curl_easy_init();
   if (!this->m_curl) {
@@ -96,6 +203,10 @@ bool vesKiwiCurlDownloader::createDirectoryForFile(const std::string& filename)
 
 bool vesKiwiCurlDownloader::downloadUrlToFile(const std::string& url, const std::string& destFile)
 {
+  // the checksum only applies to this download
+  const std::string expectedMD5 = this->mExpectedMD5;
+  this->mExpectedMD5 = std::string();
+
   if (!m_curl) {
     return false;
   }
@@ -105,6 +216,29 @@ bool vesKiwiCurlDownloader::downloadUrlToFile(const std::string& url, const std:
     return false;
   }
 
+  if (this->mNumberOfConnections > 1 || this->mResumeEnabled) {
+    std::string effectiveUrl;
+    long long totalSize = 0;
+    if (this->queryRangeSupport(url, effectiveUrl, totalSize)) {
+      return this->rangedDownload(effectiveUrl, destFile, totalSize, expectedMD5);
+    }
+  }
+
+  if (!this->serialDownload(url, destFile)) {
+    return false;
+  }
+
+  if (!this->verifyChecksum(destFile, expectedMD5)) {
+    vtksys::SystemTools::RemoveFile(destFile.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiCurlDownloader::serialDownload(const std::string& url, const std::string& destFile)
+{
   std::ofstream outFile;
   outFile.open(destFile.c_str(), std::ios::out | std::ios::trunc | std::ios::binary);
 
@@ -113,6 +247,7 @@ bool vesKiwiCurlDownloader::downloadUrlToFile(const std::string& url, const std:
     return false;
   }
 
+  curl_easy_reset(m_curl);
   curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
 
   curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, header_function);
@@ -157,6 +292,263 @@ bool vesKiwiCurlDownloader::downloadUrlToFile(const std::string& url, const std:
   */
 }
 
+//----------------------------------------------------------------------------
+bool vesKiwiCurlDownloader::queryRangeSupport(const std::string& url, std::string& effectiveUrl, long long& totalSize)
+{
+  RangeQuery query;
+  query.Downloader = this;
+  query.AcceptsRanges = false;
+
+  curl_easy_reset(m_curl);
+  curl_easy_setopt(m_curl, CURLOPT_URL, url.c_str());
+  curl_easy_setopt(m_curl, CURLOPT_NOBODY, 1);
+  curl_easy_setopt(m_curl, CURLOPT_FOLLOWLOCATION, 1);
+  curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, range_header_function);
+  curl_easy_setopt(m_curl, CURLOPT_HEADERDATA, &query);
+
+  if (curl_easy_perform(m_curl) != CURLE_OK) {
+    return false;
+  }
+
+  long responseCode = 0;
+  double contentLength = -1;
+  char* lastUrl = 0;
+  curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &responseCode);
+  curl_easy_getinfo(m_curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength);
+  curl_easy_getinfo(m_curl, CURLINFO_EFFECTIVE_URL, &lastUrl);
+
+  if (responseCode != 200 || !query.AcceptsRanges || contentLength <= 0) {
+    return false;
+  }
+
+  effectiveUrl = lastUrl ? lastUrl : url;
+  totalSize = static_cast<long long>(contentLength);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiCurlDownloader::rangedDownload(const std::string& url, const std::string& destFile, long long totalSize, const std::string& expectedMD5)
+{
+  const std::string partFile = destFile + ".part";
+  const std::string stateFile = partFile + ".ranges";
+
+  std::vector<DownloadChunk> chunks;
+  bool resuming = this->mResumeEnabled
+    && vtksys::SystemTools::FileExists(partFile.c_str(), true)
+    && static_cast<long long>(vtksys::SystemTools::FileLength(partFile.c_str())) == totalSize
+    && readRangeState(stateFile, url, totalSize, chunks);
+
+  if (!resuming) {
+    const long long numberOfChunks = std::min(static_cast<long long>(this->mNumberOfConnections), totalSize);
+    const long long chunkSize = totalSize / numberOfChunks;
+    chunks.resize(numberOfChunks);
+    for (long long i = 0; i < numberOfChunks; ++i) {
+      chunks[i].Begin = i*chunkSize;
+      chunks[i].End = (i == numberOfChunks - 1) ? totalSize - 1 : (i + 1)*chunkSize - 1;
+      chunks[i].Done = 0;
+    }
+  }
+
+  FILE* file = fopen(partFile.c_str(), resuming ? "r+b" : "w+b");
+  if (!file) {
+    this->setError("File Error", "Could not open file for writing.");
+    return false;
+  }
+
+  // allocate the whole file up front so that chunks can be written anywhere
+  if (!resuming && (fseeko(file, totalSize - 1, SEEK_SET) != 0 || fputc(0, file) == EOF)) {
+    fclose(file);
+    this->setError("File Error", "Could not allocate file: " + partFile);
+    return false;
+  }
+
+  // with resume enabled the state is kept up to date on disk, so even a
+  // killed process leaves a download that can be continued
+  if (this->mResumeEnabled && !resuming) {
+    fflush(file);
+    writeRangeState(stateFile, url, totalSize, chunks);
+  }
+
+  CURLM* multi = curl_multi_init();
+  std::vector<std::string> ranges(chunks.size());
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    DownloadChunk& chunk = chunks[i];
+    chunk.File = file;
+    chunk.Handle = 0;
+
+    if (chunk.Begin + chunk.Done > chunk.End) {
+      continue;
+    }
+
+    std::stringstream range;
+    range << chunk.Begin + chunk.Done << "-" << chunk.End;
+    ranges[i] = range.str();
+
+    chunk.Handle = curl_easy_init();
+    curl_easy_setopt(chunk.Handle, CURLOPT_URL, url.c_str());
+    curl_easy_setopt(chunk.Handle, CURLOPT_RANGE, ranges[i].c_str());
+    curl_easy_setopt(chunk.Handle, CURLOPT_WRITEFUNCTION, write_chunk);
+    curl_easy_setopt(chunk.Handle, CURLOPT_WRITEDATA, &chunk);
+    curl_easy_setopt(chunk.Handle, CURLOPT_FOLLOWLOCATION, 1);
+    curl_multi_add_handle(multi, chunk.Handle);
+  }
+
+  bool success = true;
+  bool aborted = false;
+  int stillRunning = 1;
+  double lastStateTime = vtksys::SystemTools::GetTime();
+
+  while (true) {
+
+    curl_multi_perform(multi, &stillRunning);
+
+    // collect the result of each finished transfer
+    bool finishedRange = false;
+    CURLMsg* message;
+    int messagesLeft;
+    while ((message = curl_multi_info_read(multi, &messagesLeft))) {
+      if (message->msg != CURLMSG_DONE) {
+        continue;
+      }
+      if (message->data.result != CURLE_OK) {
+        this->setError("Download Error", curl_easy_strerror(message->data.result));
+        success = false;
+      }
+      else {
+        finishedRange = true;
+      }
+    }
+
+    // save the state as each range completes, and at least every second
+    const double now = vtksys::SystemTools::GetTime();
+    if (this->mResumeEnabled && (finishedRange || now - lastStateTime >= 1.0)) {
+      fflush(file);
+      writeRangeState(stateFile, url, totalSize, chunks);
+      lastStateTime = now;
+    }
+
+    if (this->mProgressDelegate) {
+      long long done = 0;
+      for (size_t i = 0; i < chunks.size(); ++i) {
+        done += chunks[i].Done;
+      }
+      aborted = this->mProgressDelegate->downloadProgress(totalSize, done) != 0;
+    }
+
+    if (!stillRunning || aborted) {
+      break;
+    }
+
+    fd_set readSet, writeSet, errorSet;
+    FD_ZERO(&readSet);
+    FD_ZERO(&writeSet);
+    FD_ZERO(&errorSet);
+    int maxFd = -1;
+    curl_multi_fdset(multi, &readSet, &writeSet, &errorSet, &maxFd);
+
+    struct timeval timeout;
+    timeout.tv_sec = 0;
+    timeout.tv_usec = 100000;
+    if (maxFd >= 0) {
+      select(maxFd + 1, &readSet, &writeSet, &errorSet, &timeout);
+    }
+    else {
+      select(0, 0, 0, 0, &timeout);
+    }
+  }
+
+  if (aborted) {
+    success = false;
+  }
+
+  for (size_t i = 0; i < chunks.size(); ++i) {
+    if (chunks[i].Handle) {
+      long responseCode = 0;
+      curl_easy_getinfo(chunks[i].Handle, CURLINFO_RESPONSE_CODE, &responseCode);
+      if (responseCode != 206) {
+        this->setError("Download Error", "The server did not honor the byte range request.");
+        success = false;
+      }
+      curl_multi_remove_handle(multi, chunks[i].Handle);
+      curl_easy_cleanup(chunks[i].Handle);
+      chunks[i].Handle = 0;
+    }
+    if (chunks[i].Begin + chunks[i].Done != chunks[i].End + 1) {
+      success = false;
+    }
+  }
+
+  curl_multi_cleanup(multi);
+  fclose(file);
+
+  if (!success) {
+    this->setError("Download Error", "The download did not complete.");
+    if (this->mResumeEnabled) {
+      writeRangeState(stateFile, url, totalSize, chunks);
+    }
+    else {
+      vtksys::SystemTools::RemoveFile(partFile.c_str());
+    }
+    return false;
+  }
+
+  vtksys::SystemTools::RemoveFile(stateFile.c_str());
+
+  if (!this->verifyChecksum(partFile, expectedMD5)) {
+    vtksys::SystemTools::RemoveFile(partFile.c_str());
+    return false;
+  }
+
+  return this->renameFile(partFile, destFile);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiCurlDownloader::verifyChecksum(const std::string& filename, const std::string& expectedMD5)
+{
+  if (expectedMD5.empty()) {
+    return true;
+  }
+
+  std::string md5 = computeFileMD5(filename);
+  std::string expected = expectedMD5;
+  for (size_t i = 0; i < expected.size(); ++i) {
+    expected[i] = tolower(expected[i]);
+  }
+
+  if (md5 != expected) {
+    this->setError("Download Error", "The downloaded file does not match its checksum.");
+    return false;
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiCurlDownloader::computeFileMD5(const std::string& filename)
+{
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (!file) {
+    return std::string();
+  }
+
+  vtksysMD5* md5 = vtksysMD5_New();
+  vtksysMD5_Initialize(md5);
+
+  unsigned char buffer[65536];
+  size_t length;
+  while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+    vtksysMD5_Append(md5, buffer, static_cast<int>(length));
+  }
+  fclose(file);
+
+  char digest[32];
+  vtksysMD5_FinalizeHex(md5, digest);
+  vtksysMD5_Delete(md5);
+
+  return std::string(digest, 32);
+}
+
 //----------------------------------------------------------------------------
 bool vesKiwiCurlDownloader::renameFile(const std::string& srcFile, const std::string& destFile)
 {
@@ -35,6 +35,13 @@ public:
 
   ~vesKiwiCurlDownloader();
 
+  /// Download the url to destFile.  If the server accepts byte ranges and
+  /// more than one connection or resuming is enabled, the file is fetched as
+  /// parallel range requests into destFile + ".part".  With resume enabled
+  /// the transfer state is saved to destFile + ".part.ranges" as ranges
+  /// complete, so a failed or killed download continues from the bytes
+  /// already on disk.  If an expected md5 is set the finished
+  /// file is verified before it is renamed to destFile.
   bool downloadUrlToFile(const std::string& url, const std::string& destFile);
 
   std::string downloadUrlToDirectory(const std::string& url, const std::string& downloadDir);
@@ -70,6 +77,40 @@ public:
     return this->mErrorMessage;
   }
 
+  /// Set the number of parallel range requests used for one file.  The
+  /// default is 1.
+  void setNumberOfConnections(int numberOfConnections)
+  {
+    this->mNumberOfConnections = numberOfConnections > 0 ? numberOfConnections : 1;
+  }
+
+  int numberOfConnections() const
+  {
+    return this->mNumberOfConnections;
+  }
+
+  /// Keep partial downloads on failure and resume them on the next call to
+  /// downloadUrlToFile().  Disabled by default.
+  void setResumeEnabled(bool enabled)
+  {
+    this->mResumeEnabled = enabled;
+  }
+
+  bool isResumeEnabled() const
+  {
+    return this->mResumeEnabled;
+  }
+
+  /// Set the expected md5 checksum, as a hex string, of the next download.
+  /// The checksum is cleared when that download finishes.  An empty string
+  /// disables the check.
+  void setExpectedMD5(const std::string& md5)
+  {
+    this->mExpectedMD5 = md5;
+  }
+
+  static std::string computeFileMD5(const std::string& filename);
+
   bool renameFile(const std::string& srcFile, const std::string& destFile);
 
   // Computes the directory name from the given filename and creates the
@@ -79,6 +120,11 @@ public:
 
 protected:
 
+  bool serialDownload(const std::string& url, const std::string& destFile);
+  bool rangedDownload(const std::string& url, const std::string& destFile, long long totalSize, const std::string& expectedMD5);
+  bool queryRangeSupport(const std::string& url, std::string& effectiveUrl, long long& totalSize);
+  bool verifyChecksum(const std::string& filename, const std::string& expectedMD5);
+
   void resetErrorMessages()
   {
     this->mErrorTitle = std::string();
@@ -99,6 +145,10 @@ private:
   std::string mErrorTitle;
   std::string mErrorMessage;
   std::string mAttachmentFileName;
+  std::string mExpectedMD5;
+
+  int mNumberOfConnections;
+  bool mResumeEnabled;
 
   CURL* m_curl;
 
@@ -44,6 +44,7 @@
 #include "vtkShrinkPolyData.h"
 
 #include <cassert>
+#include <cstring>
 #include <vector>
 
 //----------------------------------------------------------------------------
@@ -823,6 +824,62 @@ vtkSmartPointer<vtkPolyData> vesKiwiDataConversionTools::TriangulatePolyData(vtk
   return polyData;
 }
 
+//-----------------------------------------------------------------------------
+bool vesKiwiDataConversionTools::HasSameTopology(vesGeometryData::Ptr reference, vesGeometryData::Ptr geometryData)
+{
+  if (!reference || !geometryData) {
+    return false;
+  }
+  if (reference == geometryData) {
+    return true;
+  }
+
+  const unsigned int numberOfPrimitiveTypes = reference->numberOfPrimitiveTypes();
+  if (!numberOfPrimitiveTypes || numberOfPrimitiveTypes != geometryData->numberOfPrimitiveTypes()) {
+    return false;
+  }
+
+  vesSourceData::Ptr referencePoints = reference->sourceData(vesVertexAttributeKeys::Position);
+  vesSourceData::Ptr points = geometryData->sourceData(vesVertexAttributeKeys::Position);
+  if (!referencePoints || !points || referencePoints->sizeOfArray() != points->sizeOfArray()) {
+    return false;
+  }
+
+  for (unsigned int i = 0; i < numberOfPrimitiveTypes; ++i) {
+    vesPrimitive::Ptr first = reference->primitive(i);
+    vesPrimitive::Ptr second = geometryData->primitive(i);
+    if (first != second) {
+      if (first->primitiveType() != second->primitiveType()
+          || first->indexCount() != second->indexCount()
+          || first->indicesValueType() != second->indicesValueType()
+          || first->sizeInBytes() != second->sizeInBytes()
+          || memcmp(first->data(), second->data(), first->sizeInBytes()) != 0) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+void vesKiwiDataConversionTools::AdoptTopology(vesGeometryData::Ptr reference, vesGeometryData::Ptr geometryData)
+{
+  if (reference == geometryData) {
+    return;
+  }
+
+  std::vector<vesPrimitive::Ptr> primitives;
+  for (unsigned int i = 0; i < geometryData->numberOfPrimitiveTypes(); ++i) {
+    primitives.push_back(geometryData->primitive(i));
+  }
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    geometryData->removePrimitive(primitives[i]);
+  }
+  for (unsigned int i = 0; i < reference->numberOfPrimitiveTypes(); ++i) {
+    geometryData->addPrimitive(reference->primitive(i));
+  }
+}
+
 //-----------------------------------------------------------------------------
 void vesKiwiDataConversionTools::RemoveSharedTriangleVertices(vesGeometryData::Ptr geometryData, const std::vector<vesSourceData::Ptr>& sourceData)
 {
@@ -77,6 +77,15 @@ public:
 
   static void RemoveSharedTriangleVertices(vesSharedPtr<vesGeometryData> geometryData, const std::vector<vesSharedPtr<vesSourceData> >& sourceData);
 
+  // Return true if geometryData has the same primitives and number of
+  // vertices as reference.  Used to detect the frames of a series with fixed
+  // connectivity, so they share one set of index arrays and buffers.
+  static bool HasSameTopology(vesSharedPtr<vesGeometryData> reference, vesSharedPtr<vesGeometryData> geometryData);
+
+  // Replace the primitives of geometryData with those of reference, which
+  // must have the same topology, see HasSameTopology().
+  static void AdoptTopology(vesSharedPtr<vesGeometryData> reference, vesSharedPtr<vesGeometryData> geometryData);
+
   static vtkSmartPointer<vtkPolyData> TriangulatePolyData(vtkPolyData* polyData, bool computeNormals, bool duplicateVertices);
 
   static vtkUnsignedCharArray* FindRGBColorsArray(vtkDataSet* dataSet);
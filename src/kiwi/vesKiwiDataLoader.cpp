@@ -49,6 +49,7 @@
 
 #include <cassert>
 #include <limits>
+#include <map>
 
 //----------------------------------------------------------------------------
 class vesKiwiDataLoader::vesInternal
@@ -58,9 +59,19 @@ public:
   vesInternal()
   {
     this->IsErrorOnMoreThan65kVertices = true;
+    this->IsExpandMoleculeGlyphs = true;
   }
 
+  struct MemoryFile
+  {
+    const char* Data;
+    size_t Length;
+    vesSharedPtr<void> Owner;
+  };
+
   bool IsErrorOnMoreThan65kVertices;
+  bool IsExpandMoleculeGlyphs;
+  std::map<std::string, MemoryFile> MemoryFiles;
   std::string ErrorTitle;
   std::string ErrorMessage;
 };
@@ -89,6 +100,85 @@ bool vesKiwiDataLoader::isErrorOnMoreThan65kVertices() const
   return this->Internal->IsErrorOnMoreThan65kVertices;
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiDataLoader::setExpandMoleculeGlyphs(bool isEnabled)
+{
+  this->Internal->IsExpandMoleculeGlyphs = isEnabled;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiDataLoader::isExpandMoleculeGlyphs() const
+{
+  return this->Internal->IsExpandMoleculeGlyphs;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vesKiwiDataLoader::moleculeAtomGlyph()
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetCenter(0.0, 0.0, 0.0);
+  sphere->SetRadius(1.0);
+  sphere->SetThetaResolution(8);
+  sphere->SetPhiResolution(8);
+  sphere->Update();
+  return sphere->GetOutput();
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiDataLoader::moleculeAtomScaleFactor()
+{
+  return 0.25;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiDataLoader::addMemoryFile(const std::string& filename, const char* data, size_t length,
+                                      vesSharedPtr<void> owner)
+{
+  vesInternal::MemoryFile memoryFile;
+  memoryFile.Data = data;
+  memoryFile.Length = length;
+  memoryFile.Owner = owner;
+  this->Internal->MemoryFiles[filename] = memoryFile;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiDataLoader::memoryFile(const std::string& filename, const char*& data, size_t& length) const
+{
+  std::map<std::string, vesInternal::MemoryFile>::const_iterator itr =
+    this->Internal->MemoryFiles.find(filename);
+  if (itr == this->Internal->MemoryFiles.end()) {
+    return false;
+  }
+
+  data = itr->second.Data;
+  length = itr->second.Length;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiDataLoader::clearMemoryFiles()
+{
+  this->Internal->MemoryFiles.clear();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiDataLoader::copySettings(const vesKiwiDataLoader& other)
+{
+  this->Internal->IsErrorOnMoreThan65kVertices = other.Internal->IsErrorOnMoreThan65kVertices;
+  this->Internal->IsExpandMoleculeGlyphs = other.Internal->IsExpandMoleculeGlyphs;
+  this->Internal->MemoryFiles = other.Internal->MemoryFiles;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiDataLoader::canLoadFromMemory(const std::string& filename, size_t length)
+{
+  // These are the formats whose VTK readers can parse an input string.
+  return (hasEnding(filename, "vtk") && length <= static_cast<size_t>(std::numeric_limits<int>::max()))
+    || hasEnding(filename, "vtp")
+    || hasEnding(filename, "vti")
+    || hasEnding(filename, "vtu");
+}
+
 //----------------------------------------------------------------------------
 bool vesKiwiDataLoader::hasEnding(const std::string& fullString, const std::string& ending)
 {
@@ -173,12 +263,60 @@ vtkSmartPointer<vtkDataSet> vesKiwiDataLoader::datasetFromAlgorithm(vtkAlgorithm
   return dataset;
 }
 
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataSet> vesKiwiDataLoader::loadDatasetFromMemory(const std::string& filename,
+                                                                     const char* data, size_t length)
+{
+  if (this->hasEnding(filename, "vtk"))
+    {
+    vtkSmartPointer<vtkDataSetReader> reader = vtkSmartPointer<vtkDataSetReader>::New();
+    assert(length <= static_cast<size_t>(std::numeric_limits<int>::max()));
+    reader->ReadFromInputStringOn();
+    reader->SetInputString(data, static_cast<int>(length));
+    return this->datasetFromAlgorithm(reader);
+    }
+  else if (this->hasEnding(filename, "vtp"))
+    {
+    vtkSmartPointer<vtkXMLPolyDataReader> reader = vtkSmartPointer<vtkXMLPolyDataReader>::New();
+    reader->ReadFromInputStringOn();
+    reader->SetInputString(std::string(data, length));
+    return this->datasetFromAlgorithm(reader);
+    }
+  else if (this->hasEnding(filename, "vti"))
+    {
+    vtkSmartPointer<vtkXMLImageDataReader> reader = vtkSmartPointer<vtkXMLImageDataReader>::New();
+    reader->ReadFromInputStringOn();
+    reader->SetInputString(std::string(data, length));
+    return this->datasetFromAlgorithm(reader);
+    }
+  else if (this->hasEnding(filename, "vtu"))
+    {
+    vtkSmartPointer<vtkXMLUnstructuredGridReader> reader = vtkSmartPointer<vtkXMLUnstructuredGridReader>::New();
+    reader->ReadFromInputStringOn();
+    reader->SetInputString(std::string(data, length));
+    return this->datasetFromAlgorithm(reader);
+    }
+  else
+    {
+    this->Internal->ErrorTitle = "Unsupported file format";
+    this->Internal->ErrorMessage = "Cannot read files of this format from memory";
+    return 0;
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkSmartPointer<vtkDataSet> vesKiwiDataLoader::loadDataset(const std::string& filename)
 {
   this->Internal->ErrorTitle = std::string();
   this->Internal->ErrorMessage = std::string();
 
+  const char* data;
+  size_t length;
+  if (this->memoryFile(filename, data, length))
+    {
+    return this->loadDatasetFromMemory(filename, data, length);
+    }
+
   if (!vtksys::SystemTools::FileExists(filename.c_str(), true))
     {
     this->Internal->ErrorTitle = "File Not Found";
@@ -223,19 +361,17 @@ vtkSmartPointer<vtkDataSet> vesKiwiDataLoader::loadDataset(const std::string& fi
     reader->SetHBScale(1.0);
     reader->SetBScale(1.0);
 
-    vtkNew<vtkSphereSource> sphere;
-    sphere->SetCenter(0.0, 0.0, 0.0);
-    sphere->SetRadius(1.0);
-    sphere->SetThetaResolution(8);
-    sphere->SetPhiResolution(8);
-    sphere->Update();
+    if (!this->isExpandMoleculeGlyphs())
+      {
+      return this->datasetFromAlgorithm(reader.GetPointer());
+      }
 
     vtkNew<vtkGlyph3D> glyph;
     glyph->SetInputConnection(reader->GetOutputPort());
-    glyph->SetSourceData(sphere->GetOutput());
+    glyph->SetSourceData(moleculeAtomGlyph());
     glyph->SetOrient(1);
     glyph->SetScaleMode(2);
-    glyph->SetScaleFactor(0.25);
+    glyph->SetScaleFactor(moleculeAtomScaleFactor());
     glyph->SetColorMode(1);
 
     vtkNew<vtkAppendPolyData> append;
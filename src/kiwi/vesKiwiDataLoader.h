@@ -22,11 +22,14 @@
 #ifndef __vesKiwiDataLoader_h
 #define __vesKiwiDataLoader_h
 
+#include "vesSharedPtr.h"
+
 #include <string>
 #include <vtkSmartPointer.h>
 
 class vtkAlgorithm;
 class vtkDataSet;
+class vtkPolyData;
 
 class vesKiwiDataLoader
 {
@@ -44,10 +47,42 @@ public:
   void setErrorOnMoreThan65kVertices(bool isEnabled);
   bool isErrorOnMoreThan65kVertices() const;
 
+  /// Set/get whether molecules are returned with a sphere glyph copied to
+  /// every atom.  When disabled the atoms are returned as points, with the
+  /// radius vectors and rgb_colors of the reader, next to the bond lines, so
+  /// the spheres can be drawn with a vesKiwiGlyphRepresentation.  The default
+  /// setting is enabled.
+  void setExpandMoleculeGlyphs(bool isEnabled);
+  bool isExpandMoleculeGlyphs() const;
+
+  /// The sphere placed at every atom, and the factor its radius is scaled by.
+  static vtkSmartPointer<vtkPolyData> moleculeAtomGlyph();
+  static double moleculeAtomScaleFactor();
+
   vtkSmartPointer<vtkDataSet> loadDataset(const std::string& filename);
   std::string errorTitle() const;
   std::string errorMessage() const;
 
+  /// Register an in-memory file.  When loadDataset() is called with
+  /// \p filename the dataset is parsed from this buffer instead of being read
+  /// from disk.  The buffer is not copied.  If \p owner is given, this
+  /// loader and every loader that copies its settings hold a reference to it,
+  /// so the buffer stays valid for as long as any of them may read it.
+  /// Otherwise the buffer must stay valid until clearMemoryFiles() is called.
+  /// Only files for which canLoadFromMemory() returns true can be registered.
+  void addMemoryFile(const std::string& filename, const char* data, size_t length,
+                     vesSharedPtr<void> owner = vesSharedPtr<void>());
+  bool memoryFile(const std::string& filename, const char*& data, size_t& length) const;
+  void clearMemoryFiles();
+
+  /// Copy the settings and the registered memory files of another loader.
+  void copySettings(const vesKiwiDataLoader& other);
+
+  /// Whether a file of this name and \p length in bytes can be parsed from a
+  /// memory buffer.  Legacy .vtk files are read from a string whose length is
+  /// an int, so larger ones must be read from disk.
+  static bool canLoadFromMemory(const std::string& filename, size_t length);
+
   static bool hasEnding(const std::string& fullString, const std::string& ending);
 
 protected:
@@ -57,6 +92,9 @@ protected:
   /// a surface filter and return the result of the surface filter instead.
   vtkSmartPointer<vtkDataSet> datasetFromAlgorithm(vtkAlgorithm* algorithm);
 
+  vtkSmartPointer<vtkDataSet> loadDatasetFromMemory(const std::string& filename,
+                                                    const char* data, size_t length);
+
 
   bool updateAlgorithmOrSetErrorString(vtkAlgorithm* algorithm);
   void setMaximumNumberOfPointsErrorMessage();
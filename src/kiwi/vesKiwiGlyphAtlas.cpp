@@ -0,0 +1,513 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiGlyphAtlas.h"
+
+#include "vesBuiltinShaders.h"
+#include "vesGeometryData.h"
+#include "vesImage.h"
+#include "vesModelViewUniform.h"
+#include "vesPrimitive.h"
+#include "vesProjectionUniform.h"
+#include "vesShader.h"
+#include "vesShaderProgram.h"
+#include "vesSourceData.h"
+#include "vesTexture.h"
+#include "vesVertexAttribute.h"
+#include "vesVertexAttributeKeys.h"
+
+#include <vtkFreeTypeTools.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkTextProperty.h>
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+
+//----------------------------------------------------------------------------
+namespace {
+
+const int FirstCharacter = 32;
+const int LastCharacter = 126;
+
+// Indices are unsigned shorts, four vertices per quad.
+const unsigned int MaximumNumberOfQuads = 16383;
+
+struct Glyph
+{
+  Glyph()
+  {
+    this->Advance = 0;
+    this->Left = 0;
+    this->Top = 0;
+    this->Width = 0;
+    this->Height = 0;
+    this->X = 0;
+    this->Y = 0;
+  }
+
+  int Advance;
+  int Left;
+  int Top;
+  int Width;
+  int Height;
+  int X;
+  int Y;
+  std::vector<unsigned char> Pixels;
+};
+
+// FreeType and the map of shared atlases are not thread safe.
+vtkSimpleMutexLock& FreeTypeLock()
+{
+  static vtkSimpleMutexLock lock;
+  return lock;
+}
+
+//----------------------------------------------------------------------------
+// Replace the coverage of a glyph, padded by spread texels on each side, by
+// the distance of each texel to the outline, mapped so that 0.5 is the
+// outline and 0 and 1 are spread texels outside and inside.
+void ComputeDistanceField(Glyph& glyph, int spread)
+{
+  const int width = glyph.Width;
+  const int height = glyph.Height;
+  std::vector<unsigned char> distances(glyph.Pixels.size());
+
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const bool inside = glyph.Pixels[y * width + x] >= 128;
+      int nearest = spread * spread;
+      for (int j = std::max(0, y - spread); j <= std::min(height - 1, y + spread); ++j) {
+        for (int i = std::max(0, x - spread); i <= std::min(width - 1, x + spread); ++i) {
+          if ((glyph.Pixels[j * width + i] >= 128) != inside) {
+            nearest = std::min(nearest, (i - x) * (i - x) + (j - y) * (j - y));
+          }
+        }
+      }
+
+      // The outline lies halfway between a texel and its nearest opposite.
+      float distance = sqrt(static_cast<float>(nearest)) - 0.5f;
+      distance = inside ? distance : -distance;
+      const float value = std::min(std::max(0.5f + 0.5f * distance / spread, 0.0f), 1.0f);
+      distances[y * width + x] = static_cast<unsigned char>(value * 255.0f + 0.5f);
+    }
+  }
+
+  glyph.Pixels.swap(distances);
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiGlyphAtlas::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->IsInitialized = false;
+    this->FontSize = 0;
+    this->DistanceField = false;
+    this->Spread = 0;
+    this->LineHeight = 0;
+    this->Ascender = 0;
+    this->Descender = 0;
+    this->Glyphs.resize(LastCharacter - FirstCharacter + 1);
+  }
+
+  ~vesInternal()
+  {
+  }
+
+  const Glyph& glyph(char character) const
+  {
+    const int index = static_cast<unsigned char>(character);
+    return this->Glyphs[(index >= FirstCharacter && index <= LastCharacter)
+                        ? index - FirstCharacter : '?' - FirstCharacter];
+  }
+
+  bool rasterize(int fontSize);
+  void pack();
+
+  bool IsInitialized;
+  int FontSize;
+  bool DistanceField;
+  int Spread;
+  int LineHeight;
+  int Ascender;
+  int Descender;
+  std::vector<Glyph> Glyphs;
+
+  vesImage::Ptr Image;
+  vesTexture::Ptr Texture;
+  vesShaderProgram::Ptr ShaderProgram;
+};
+
+//----------------------------------------------------------------------------
+bool vesKiwiGlyphAtlas::vesInternal::rasterize(int fontSize)
+{
+  vtkNew<vtkTextProperty> textProperty;
+  textProperty->SetFontFamilyToArial();
+  textProperty->SetFontSize(fontSize);
+
+  vtkFreeTypeTools* freeType = vtkFreeTypeTools::GetInstance();
+  FT_Size size;
+  if (!freeType->GetSize(textProperty.GetPointer(), &size)) {
+    return false;
+  }
+
+  // Metrics are in 26.6 fixed point.
+  this->Ascender = (size->metrics.ascender + 32) >> 6;
+  this->Descender = (-size->metrics.descender + 32) >> 6;
+  this->LineHeight = (size->metrics.height + 32) >> 6;
+
+  for (int c = FirstCharacter; c <= LastCharacter; ++c) {
+    Glyph& glyph = this->Glyphs[c - FirstCharacter];
+    FT_Glyph ftGlyph;
+    if (!freeType->GetGlyph(textProperty.GetPointer(), c, &ftGlyph,
+                            vtkFreeTypeTools::GLYPH_REQUEST_BITMAP)) {
+      continue;
+    }
+
+    // The glyph belongs to the cache of vtkFreeTypeTools.
+    FT_BitmapGlyph bitmapGlyph = reinterpret_cast<FT_BitmapGlyph>(ftGlyph);
+    const FT_Bitmap& bitmap = bitmapGlyph->bitmap;
+    glyph.Advance = static_cast<int>((ftGlyph->advance.x + 0x8000) >> 16);
+
+    // Pad the glyph so that filtering does not reach into its neighbors, by
+    // the width of the distance ramp for distance fields.
+    const int padding = this->DistanceField ? this->Spread : 1;
+    glyph.Left = bitmapGlyph->left - padding;
+    glyph.Top = bitmapGlyph->top + padding;
+    glyph.Width = bitmap.width + 2 * padding;
+    glyph.Height = bitmap.rows + 2 * padding;
+    glyph.Pixels.assign(glyph.Width * glyph.Height, 0);
+
+    for (int y = 0; y < static_cast<int>(bitmap.rows); ++y) {
+      const unsigned char* row = bitmap.buffer + y * bitmap.pitch;
+      unsigned char* pixels = &glyph.Pixels[(y + padding) * glyph.Width + padding];
+      for (int x = 0; x < static_cast<int>(bitmap.width); ++x) {
+        if (bitmap.pixel_mode == FT_PIXEL_MODE_MONO) {
+          pixels[x] = (row[x / 8] & (0x80 >> (x % 8))) ? 255 : 0;
+        }
+        else {
+          pixels[x] = row[x];
+        }
+      }
+    }
+
+    if (this->DistanceField) {
+      ComputeDistanceField(glyph, this->Spread);
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphAtlas::vesInternal::pack()
+{
+  // Lay the glyphs out in rows of an atlas about as wide as high, one texel
+  // apart.
+  int area = 0;
+  int width = 64;
+  for (size_t i = 0; i < this->Glyphs.size(); ++i) {
+    area += (this->Glyphs[i].Width + 1) * (this->Glyphs[i].Height + 1);
+    width = std::max(width, this->Glyphs[i].Width + 1);
+  }
+  while (width * width < area) {
+    width *= 2;
+  }
+
+  int x = 0;
+  int y = 0;
+  int rowHeight = 0;
+  for (size_t i = 0; i < this->Glyphs.size(); ++i) {
+    Glyph& glyph = this->Glyphs[i];
+    if (x + glyph.Width + 1 > width) {
+      x = 0;
+      y += rowHeight;
+      rowHeight = 0;
+    }
+    glyph.X = x;
+    glyph.Y = y;
+    x += glyph.Width + 1;
+    rowHeight = std::max(rowHeight, glyph.Height + 1);
+  }
+  const int height = y + rowHeight;
+
+  std::vector<unsigned char> pixels(width * height, 0);
+  for (size_t i = 0; i < this->Glyphs.size(); ++i) {
+    Glyph& glyph = this->Glyphs[i];
+    for (int row = 0; row < glyph.Height; ++row) {
+      std::copy(glyph.Pixels.begin() + row * glyph.Width,
+                glyph.Pixels.begin() + (row + 1) * glyph.Width,
+                pixels.begin() + (glyph.Y + row) * width + glyph.X);
+    }
+    std::vector<unsigned char>().swap(glyph.Pixels);
+  }
+
+  this->Image = vesImage::Ptr(new vesImage());
+  this->Image->setWidth(width);
+  this->Image->setHeight(height);
+  this->Image->setPixelFormat(vesColorDataType::Luminance);
+  this->Image->setPixelDataType(vesColorDataType::UnsignedByte);
+  this->Image->setData(&pixels[0], pixels.size());
+  this->Texture->setImage(this->Image);
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphAtlas::vesKiwiGlyphAtlas()
+{
+  this->Internal = new vesInternal();
+  this->Internal->Texture = vesTexture::Ptr(new vesTexture());
+
+  vesShaderProgram::Ptr program(new vesShaderProgram());
+  program->addShader(vesShader::Ptr(new vesShader(vesShader::Vertex,
+    vesBuiltinShaders::vesText_vert())));
+  program->addShader(vesShader::Ptr(new vesShader(vesShader::Fragment,
+    vesBuiltinShaders::vesText_frag())));
+  program->addUniform(vesUniform::Ptr(new vesModelViewUniform()));
+  program->addUniform(vesUniform::Ptr(new vesProjectionUniform()));
+  program->addVertexAttribute(vesVertexAttribute::Ptr(
+    new vesPositionVertexAttribute()), vesVertexAttributeKeys::Position);
+  program->addVertexAttribute(vesVertexAttribute::Ptr(
+    new vesTextureCoordinateVertexAttribute()), vesVertexAttributeKeys::TextureCoordinate);
+  program->addVertexAttribute(vesVertexAttribute::Ptr(
+    new vesColorVertexAttribute()), vesVertexAttributeKeys::Color);
+  this->Internal->ShaderProgram = program;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphAtlas::~vesKiwiGlyphAtlas()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphAtlas::Ptr vesKiwiGlyphAtlas::shared(bool distanceField)
+{
+  typedef std::pair<vtkMultiThreaderIDType, bool> Key;
+  static std::map<Key, vesWeakPtr<vesKiwiGlyphAtlas> > atlases;
+
+  const Key key(vtkMultiThreader::GetCurrentThreadID(), distanceField);
+  FreeTypeLock().Lock();
+  vesKiwiGlyphAtlas::Ptr atlas = atlases[key].lock();
+  FreeTypeLock().Unlock();
+  if (atlas) {
+    return atlas;
+  }
+
+  // Distance fields are rasterized larger and scaled down when drawn.
+  atlas = vesKiwiGlyphAtlas::Ptr(new vesKiwiGlyphAtlas());
+  atlas->initialize(distanceField ? 48 : 32, distanceField);
+
+  FreeTypeLock().Lock();
+  atlases[key] = atlas;
+  FreeTypeLock().Unlock();
+  return atlas;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiGlyphAtlas::initialize(int fontSize, bool distanceField)
+{
+  this->Internal->IsInitialized = false;
+  this->Internal->FontSize = fontSize;
+  this->Internal->DistanceField = distanceField;
+  this->Internal->Spread = std::max(2, fontSize / 8);
+  this->Internal->Glyphs.assign(LastCharacter - FirstCharacter + 1, Glyph());
+
+  FreeTypeLock().Lock();
+  const bool success = this->Internal->rasterize(fontSize);
+  FreeTypeLock().Unlock();
+  if (!success) {
+    return false;
+  }
+
+  this->Internal->pack();
+  this->Internal->IsInitialized = true;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiGlyphAtlas::isInitialized() const
+{
+  return this->Internal->IsInitialized;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiGlyphAtlas::fontSize() const
+{
+  return this->Internal->FontSize;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiGlyphAtlas::distanceField() const
+{
+  return this->Internal->DistanceField;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiGlyphAtlas::lineHeight() const
+{
+  return this->Internal->LineHeight;
+}
+
+//----------------------------------------------------------------------------
+vesVector2f vesKiwiGlyphAtlas::textSize(const std::string& text, float scale) const
+{
+  int width = 0;
+  int lineWidth = 0;
+  int numberOfLines = 1;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') {
+      lineWidth = 0;
+      ++numberOfLines;
+      continue;
+    }
+    lineWidth += this->Internal->glyph(text[i]).Advance;
+    width = std::max(width, lineWidth);
+  }
+
+  const int height = (numberOfLines - 1) * this->Internal->LineHeight
+    + this->Internal->Ascender + this->Internal->Descender;
+  return vesVector2f(width * scale, height * scale);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphAtlas::appendText(const std::string& text,
+                                   const vesVector2f& position,
+                                   const vesVector3f& color, float scale,
+                                   std::vector<vesVertexDataP3T3C3f>& vertices) const
+{
+  const vesInternal* internal = this->Internal;
+  if (!internal->IsInitialized) {
+    return;
+  }
+
+  // Coverage glyphs are only sharp on whole pixels.
+  vesVector2f origin = position;
+  if (!internal->DistanceField) {
+    origin = vesVector2f(floor(origin[0] + 0.5f), floor(origin[1] + 0.5f));
+  }
+
+  const int numberOfLines = 1 + static_cast<int>(std::count(text.begin(), text.end(), '\n'));
+  float penX = origin[0];
+  float baseline = origin[1]
+    + (internal->Descender + (numberOfLines - 1) * internal->LineHeight) * scale;
+
+  // Edge width for the distance field shader, about a pixel on screen.
+  const float smoothing = internal->DistanceField
+    ? 0.25f / (internal->Spread * scale) : 0.0f;
+  const float textureWidth = static_cast<float>(internal->Image->width());
+  const float textureHeight = static_cast<float>(internal->Image->height());
+
+  vesVertexDataP3T3C3f vertex;
+  vertex.m_color = color;
+  for (size_t i = 0; i < text.size(); ++i) {
+    if (text[i] == '\n') {
+      penX = origin[0];
+      baseline -= internal->LineHeight * scale;
+      continue;
+    }
+
+    const Glyph& glyph = internal->glyph(text[i]);
+    if (glyph.Width > 0 && glyph.Height > 0) {
+      const float x0 = penX + glyph.Left * scale;
+      const float x1 = x0 + glyph.Width * scale;
+      const float y1 = baseline + glyph.Top * scale;
+      const float y0 = y1 - glyph.Height * scale;
+      const float s0 = glyph.X / textureWidth;
+      const float s1 = (glyph.X + glyph.Width) / textureWidth;
+      const float t0 = glyph.Y / textureHeight;
+      const float t1 = (glyph.Y + glyph.Height) / textureHeight;
+
+      // The top row of the glyph is the first row of the atlas image.
+      vertex.m_position = vesVector3f(x0, y0, 0.0f);
+      vertex.m_texureCoordinates = vesVector3f(s0, t1, smoothing);
+      vertices.push_back(vertex);
+      vertex.m_position = vesVector3f(x1, y0, 0.0f);
+      vertex.m_texureCoordinates = vesVector3f(s1, t1, smoothing);
+      vertices.push_back(vertex);
+      vertex.m_position = vesVector3f(x1, y1, 0.0f);
+      vertex.m_texureCoordinates = vesVector3f(s1, t0, smoothing);
+      vertices.push_back(vertex);
+      vertex.m_position = vesVector3f(x0, y1, 0.0f);
+      vertex.m_texureCoordinates = vesVector3f(s0, t0, smoothing);
+      vertices.push_back(vertex);
+    }
+    penX += glyph.Advance * scale;
+  }
+}
+
+//----------------------------------------------------------------------------
+vesGeometryData::Ptr vesKiwiGlyphAtlas::createGeometry(
+  const std::vector<vesVertexDataP3T3C3f>& vertices, vesPrimitive::Ptr& triangles)
+{
+  const unsigned int numberOfQuads = std::min(
+    static_cast<unsigned int>(vertices.size() / 4), MaximumNumberOfQuads);
+
+  unsigned int capacity = triangles ? triangles->numberOfIndices() / 6 : 0;
+  if (!triangles || capacity < numberOfQuads) {
+    capacity = std::max(capacity, 16u);
+    while (capacity < numberOfQuads) {
+      capacity = std::min(2 * capacity, MaximumNumberOfQuads);
+    }
+
+    vesIndices<unsigned short>::Ptr indices(new vesIndices<unsigned short>());
+    for (unsigned int i = 0; i < capacity; ++i) {
+      const unsigned short first = static_cast<unsigned short>(4 * i);
+      indices->pushBackIndices(first, first + 1, first + 2);
+      indices->pushBackIndices(first, first + 2, first + 3);
+    }
+    triangles = vesPrimitive::Ptr(new vesPrimitive());
+    triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+    triangles->setIndicesValueType(vesPrimitiveIndicesValueType::UnsignedShort);
+    triangles->setIndexCount(3);
+    triangles->setVesIndices(indices);
+  }
+
+  vesSourceDataP3T3C3f::Ptr source(new vesSourceDataP3T3C3f());
+  std::vector<vesVertexDataP3T3C3f>& data = source->arrayReference();
+  data.assign(vertices.begin(), vertices.begin() + 4 * numberOfQuads);
+  vesVertexDataP3T3C3f unused;
+  unused.m_position = unused.m_texureCoordinates = unused.m_color = vesVector3f(0.0f, 0.0f, 0.0f);
+  data.resize(4 * capacity, unused);
+
+  vesGeometryData::Ptr geometryData(new vesGeometryData());
+  geometryData->setName("TextData");
+  geometryData->addSource(source);
+  geometryData->addPrimitive(triangles);
+  return geometryData;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesTexture> vesKiwiGlyphAtlas::texture() const
+{
+  return this->Internal->Texture;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesShaderProgram> vesKiwiGlyphAtlas::shaderProgram() const
+{
+  return this->Internal->ShaderProgram;
+}
@@ -0,0 +1,101 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiGlyphAtlas
+/// \ingroup KiwiPlatform
+/// \brief Printable ASCII characters of a font rasterized once into a texture
+///
+/// Strings are drawn as one textured quad per character, laid out by
+/// appendText() and colored per vertex, so changing the text of a label only
+/// uploads a few vertices.  Glyphs may be stored as signed distance fields,
+/// which stay sharp when the text is scaled up.  All quads are drawn with
+/// shaderProgram() and texture().
+#ifndef __vesKiwiGlyphAtlas_h
+#define __vesKiwiGlyphAtlas_h
+
+#include <vesMath.h>
+#include <vesSetGet.h>
+#include <vesSharedPtr.h>
+
+#include <string>
+#include <vector>
+
+class vesGeometryData;
+class vesPrimitive;
+class vesShaderProgram;
+class vesTexture;
+struct vesVertexDataP3T3C3f;
+
+class vesKiwiGlyphAtlas
+{
+public:
+
+  vesTypeMacro(vesKiwiGlyphAtlas);
+
+  vesKiwiGlyphAtlas();
+  ~vesKiwiGlyphAtlas();
+
+  /// Return the atlas of the default font that text representations created
+  /// on the calling thread share.  Textures belong to the GL context of the
+  /// thread, so threads rendering with different contexts get their own.
+  static Ptr shared(bool distanceField = false);
+
+  /// Rasterize the characters at \p fontSize pixels.  Returns false if the
+  /// font could not be loaded.
+  bool initialize(int fontSize, bool distanceField = false);
+  bool isInitialized() const;
+
+  int fontSize() const;
+  bool distanceField() const;
+
+  /// Distance between the baselines of two lines, in pixels at scale 1.
+  int lineHeight() const;
+
+  /// Size of the box the text is laid out in, in pixels.
+  vesVector2f textSize(const std::string& text, float scale = 1.0f) const;
+
+  /// Append the four corners of a quad per visible character of \p text.
+  /// \p position is the lower left corner of the text box, lines are
+  /// separated by '\n' and characters that are not printable ASCII are drawn
+  /// as '?'.
+  void appendText(const std::string& text, const vesVector2f& position,
+                  const vesVector3f& color, float scale,
+                  std::vector<vesVertexDataP3T3C3f>& vertices) const;
+
+  /// Create geometry drawing the quads of \p vertices.  \p triangles keeps
+  /// the indices between calls and is only replaced when the quads outgrow
+  /// it, so a mapper given the new geometry uploads just the vertices.
+  /// Unused quads are degenerate.
+  static vesSharedPtr<vesGeometryData> createGeometry(
+    const std::vector<vesVertexDataP3T3C3f>& vertices,
+    vesSharedPtr<vesPrimitive>& triangles);
+
+  vesSharedPtr<vesTexture> texture() const;
+  vesSharedPtr<vesShaderProgram> shaderProgram() const;
+
+private:
+
+  vesKiwiGlyphAtlas(const vesKiwiGlyphAtlas&); // Not implemented
+  void operator=(const vesKiwiGlyphAtlas&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,174 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiGlyphRepresentation.h"
+#include "vesKiwiDataConversionTools.h"
+
+#include "vesActor.h"
+#include "vesGeometryData.h"
+#include "vesInstancedMapper.h"
+#include "vesMaterial.h"
+#include "vesRenderer.h"
+#include "vesShaderProgram.h"
+
+#include <vtkDataArray.h>
+#include <vtkDataSet.h>
+#include <vtkPointData.h>
+#include <vtkPolyData.h>
+#include <vtkUnsignedCharArray.h>
+
+#include <cassert>
+#include <vector>
+
+//----------------------------------------------------------------------------
+class vesKiwiGlyphRepresentation::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+  }
+
+  ~vesInternal()
+  {
+  }
+
+  vesSharedPtr<vesActor>            Actor;
+  vesSharedPtr<vesInstancedMapper>  Mapper;
+  vesSharedPtr<vesMaterial>         Material;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphRepresentation::vesKiwiGlyphRepresentation()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiGlyphRepresentation::~vesKiwiGlyphRepresentation()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphRepresentation::initializeWithShader(
+  vesSharedPtr<vesShaderProgram> shaderProgram)
+{
+  assert(shaderProgram);
+  assert(!this->Internal->Mapper && !this->Internal->Actor);
+
+  this->Internal->Mapper = vesSharedPtr<vesInstancedMapper>(new vesInstancedMapper());
+
+  this->Internal->Actor = vesSharedPtr<vesActor>(new vesActor());
+  this->Internal->Actor->setMapper(this->Internal->Mapper);
+
+  this->Internal->Material = vesSharedPtr<vesMaterial>(new vesMaterial());
+  this->Internal->Actor->setMaterial(this->Internal->Material);
+  this->Internal->Material->addAttribute(shaderProgram);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphRepresentation::setGlyph(vtkPolyData* glyph)
+{
+  assert(glyph);
+  assert(this->Internal->Mapper);
+
+  const bool addNormals = true;
+  const bool duplicateVerts = false;
+  vtkSmartPointer<vtkPolyData> triangles =
+    vesKiwiDataConversionTools::TriangulatePolyData(glyph, addNormals, duplicateVerts);
+  this->Internal->Mapper->setGeometryData(vesKiwiDataConversionTools::Convert(triangles));
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphRepresentation::setDataSet(vtkDataSet* dataSet,
+  const std::string& scaleArrayName, double scaleFactor)
+{
+  assert(dataSet);
+  assert(this->Internal->Mapper);
+
+  vtkPointData* pointData = dataSet->GetPointData();
+  vtkDataArray* scales = scaleArrayName.empty()
+    ? pointData->GetVectors() : pointData->GetArray(scaleArrayName.c_str());
+  if (!scales && scaleArrayName.empty()) {
+    scales = pointData->GetScalars();
+  }
+  vtkUnsignedCharArray* rgb = vesKiwiDataConversionTools::FindRGBColorsArray(dataSet);
+
+  const vtkIdType numberOfPoints = dataSet->GetNumberOfPoints();
+  std::vector<vesVector4f> offsets(numberOfPoints);
+  std::vector<vesVector3f> colors(rgb ? numberOfPoints : 0);
+
+  double point[3];
+  for (vtkIdType i = 0; i < numberOfPoints; ++i) {
+    dataSet->GetPoint(i, point);
+    const double scale = scales ? scales->GetComponent(i, 0) * scaleFactor : scaleFactor;
+    offsets[i] = vesVector4f(point[0], point[1], point[2], scale);
+    if (rgb) {
+      colors[i] = vesVector3f(rgb->GetValue(i*rgb->GetNumberOfComponents() + 0)/255.0,
+                              rgb->GetValue(i*rgb->GetNumberOfComponents() + 1)/255.0,
+                              rgb->GetValue(i*rgb->GetNumberOfComponents() + 2)/255.0);
+    }
+  }
+
+  this->Internal->Mapper->setInstanceOffsets(offsets);
+  this->Internal->Mapper->setInstanceColors(colors);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphRepresentation::setColor(double r, double g, double b, double a)
+{
+  assert(this->Internal->Mapper);
+  this->Internal->Mapper->setColor(r, g, b, a);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiGlyphRepresentation::numberOfGlyphs() const
+{
+  return this->Internal->Mapper ? this->Internal->Mapper->numberOfInstances() : 0;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphRepresentation::addSelfToRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  renderer->addActor(this->Internal->Actor);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiGlyphRepresentation::removeSelfFromRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  renderer->removeActor(this->Internal->Actor);
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesActor> vesKiwiGlyphRepresentation::actor() const
+{
+  return this->Internal->Actor;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesInstancedMapper> vesKiwiGlyphRepresentation::mapper() const
+{
+  return this->Internal->Mapper;
+}
@@ -0,0 +1,86 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiGlyphRepresentation
+/// \ingroup KiwiPlatform
+/// \brief Draws a glyph, e.g. a sphere, at every point of a dataset.
+///
+/// The glyph geometry is converted once and drawn with a vesInstancedMapper,
+/// so the memory and conversion cost does not grow with the glyph size times
+/// the number of points as it does with vtkGlyph3D.  The shader program must
+/// read the instance attributes, e.g. the vesKiwiShaderVariantCache Instanced
+/// variant.
+#ifndef __vesKiwiGlyphRepresentation_h
+#define __vesKiwiGlyphRepresentation_h
+
+#include "vesKiwiDataRepresentation.h"
+
+#include <string>
+
+class vesActor;
+class vesInstancedMapper;
+class vesRenderer;
+class vesShaderProgram;
+
+class vtkDataSet;
+class vtkPolyData;
+
+class vesKiwiGlyphRepresentation : public vesKiwiDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiGlyphRepresentation);
+
+  vesKiwiGlyphRepresentation();
+  ~vesKiwiGlyphRepresentation();
+
+  void initializeWithShader(vesSharedPtr<vesShaderProgram> shaderProgram);
+
+  /// The geometry drawn at every point, centered at the origin.
+  void setGlyph(vtkPolyData* glyph);
+
+  /// Place a glyph at every point of \p dataSet.  Each glyph is scaled by the
+  /// first component of the \p scaleArrayName point array times
+  /// \p scaleFactor.  Without a scale array name the point vectors, then the
+  /// point scalars, are used, and without either every glyph is scaled by
+  /// \p scaleFactor.  Glyphs are colored by the rgb colors of the points if
+  /// there are any, otherwise by the solid color.
+  void setDataSet(vtkDataSet* dataSet, const std::string& scaleArrayName = std::string(),
+                  double scaleFactor = 1.0);
+
+  void setColor(double r, double g, double b, double a);
+
+  int numberOfGlyphs() const;
+
+  virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
+
+  vesSharedPtr<vesActor> actor() const;
+  vesSharedPtr<vesInstancedMapper> mapper() const;
+
+private:
+
+  vesKiwiGlyphRepresentation(const vesKiwiGlyphRepresentation&); // Not implemented
+  void operator=(const vesKiwiGlyphRepresentation&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,775 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiJSONReader.h"
+
+#if defined(_WIN32)
+# include <cstdio>
+# include <cstdlib>
+#else
+# include <sys/types.h>
+# include <sys/stat.h>
+# include <sys/mman.h>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+#include <cmath>
+#include <sstream>
+
+namespace {
+
+int hexValue(char c)
+{
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+void appendUTF8(std::string& str, unsigned int codePoint)
+{
+  if (codePoint < 0x80) {
+    str += static_cast<char>(codePoint);
+  }
+  else if (codePoint < 0x800) {
+    str += static_cast<char>(0xC0 | (codePoint >> 6));
+    str += static_cast<char>(0x80 | (codePoint & 0x3F));
+  }
+  else if (codePoint < 0x10000) {
+    str += static_cast<char>(0xE0 | (codePoint >> 12));
+    str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (codePoint & 0x3F));
+  }
+  else {
+    str += static_cast<char>(0xF0 | (codePoint >> 18));
+    str += static_cast<char>(0x80 | ((codePoint >> 12) & 0x3F));
+    str += static_cast<char>(0x80 | ((codePoint >> 6) & 0x3F));
+    str += static_cast<char>(0x80 | (codePoint & 0x3F));
+  }
+}
+
+bool isDelimiter(char c)
+{
+  return c == ',' || c == '}' || c == ']' || c == ':'
+    || c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+}
+
+//----------------------------------------------------------------------------
+vesKiwiJSONReader::vesKiwiJSONReader() :
+  mMappedFile(0),
+  mMappedFileLength(0)
+{
+  this->setInput(0, 0);
+}
+
+//----------------------------------------------------------------------------
+vesKiwiJSONReader::vesKiwiJSONReader(const char* data, size_t length) :
+  mMappedFile(0),
+  mMappedFileLength(0)
+{
+  this->setInput(data, length);
+}
+
+//----------------------------------------------------------------------------
+vesKiwiJSONReader::~vesKiwiJSONReader()
+{
+  this->closeFile();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiJSONReader::closeFile()
+{
+  if (this->mMappedFile) {
+#if defined(_WIN32)
+    free(this->mMappedFile);
+#else
+    munmap(this->mMappedFile, this->mMappedFileLength);
+#endif
+    this->mMappedFile = 0;
+    this->mMappedFileLength = 0;
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiJSONReader::reset()
+{
+  this->mPosition = 0;
+  this->mHasPeeked = false;
+  this->mPeeked = Invalid;
+  this->mStack.clear();
+  this->mStack.push_back(EmptyDocument);
+  this->mHasError = false;
+  this->mErrorMessage = std::string();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiJSONReader::setInput(const char* data, size_t length)
+{
+  this->closeFile();
+  this->mData = data;
+  this->mLength = data ? length : 0;
+  this->reset();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::openFile(const std::string& filename)
+{
+  this->setInput(0, 0);
+
+#if defined(_WIN32)
+  // without mmap the file is read into memory
+  FILE* file = fopen(filename.c_str(), "rb");
+  if (!file) {
+    this->setError("Could not open file: " + filename);
+    return false;
+  }
+
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  if (size <= 0) {
+    fclose(file);
+    return size == 0;
+  }
+
+  void* buffer = malloc(size);
+  const bool success = buffer && fread(buffer, 1, size, file) == static_cast<size_t>(size);
+  fclose(file);
+  if (!success) {
+    free(buffer);
+    this->setError("Could not read file: " + filename);
+    return false;
+  }
+
+  this->mData = static_cast<const char*>(buffer);
+  this->mLength = size;
+  this->mMappedFile = buffer;
+  this->mMappedFileLength = size;
+  return true;
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0) {
+    this->setError("Could not open file: " + filename);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    this->setError("Could not read file: " + filename);
+    return false;
+  }
+
+  // an empty file cannot be mapped, and is not a valid document either
+  if (st.st_size == 0) {
+    close(fd);
+    return true;
+  }
+
+  void* mapped = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+
+  if (mapped == MAP_FAILED) {
+    this->setError("Could not map file: " + filename);
+    return false;
+  }
+
+  this->mData = static_cast<const char*>(mapped);
+  this->mLength = st.st_size;
+  this->mMappedFile = mapped;
+  this->mMappedFileLength = st.st_size;
+  return true;
+#endif
+}
+
+//----------------------------------------------------------------------------
+vesKiwiJSONReader::TokenType vesKiwiJSONReader::setError(const std::string& message)
+{
+  if (!this->mHasError) {
+    std::stringstream str;
+    str << message << " at offset " << this->mPosition;
+    this->mErrorMessage = str.str();
+    this->mHasError = true;
+  }
+  this->mHasPeeked = true;
+  this->mPeeked = Invalid;
+  return Invalid;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::hasError() const
+{
+  return this->mHasError;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiJSONReader::errorMessage() const
+{
+  return this->mErrorMessage;
+}
+
+//----------------------------------------------------------------------------
+size_t vesKiwiJSONReader::position() const
+{
+  return this->mPosition;
+}
+
+//----------------------------------------------------------------------------
+char vesKiwiJSONReader::skipWhitespace()
+{
+  while (this->mPosition < this->mLength) {
+    char c = this->mData[this->mPosition];
+    if (c != ' ' && c != '\t' && c != '\n' && c != '\r') {
+      return c;
+    }
+    ++this->mPosition;
+  }
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiJSONReader::TokenType vesKiwiJSONReader::peek()
+{
+  if (this->mHasPeeked) {
+    return this->mPeeked;
+  }
+
+  // Resolve the separators that precede the next token based on the
+  // enclosing scope.  The position is left on the first character of the
+  // token itself.
+  ScopeType& scope = this->mStack.back();
+  char c;
+
+  switch (scope) {
+
+    case EmptyArray:
+      scope = NonEmptyArray;
+      if (this->skipWhitespace() == ']') {
+        this->mHasPeeked = true;
+        return this->mPeeked = EndArray;
+      }
+      break;
+
+    case NonEmptyArray:
+      c = this->skipWhitespace();
+      if (c == ']') {
+        this->mHasPeeked = true;
+        return this->mPeeked = EndArray;
+      }
+      if (c != ',') {
+        return this->setError("Expected ',' or ']'");
+      }
+      ++this->mPosition;
+      break;
+
+    case EmptyObject:
+    case NonEmptyObject:
+      c = this->skipWhitespace();
+      if (c == '}') {
+        this->mHasPeeked = true;
+        return this->mPeeked = EndObject;
+      }
+      if (scope == NonEmptyObject) {
+        if (c != ',') {
+          return this->setError("Expected ',' or '}'");
+        }
+        ++this->mPosition;
+        c = this->skipWhitespace();
+      }
+      if (c != '"') {
+        return this->setError("Expected name");
+      }
+      scope = DanglingName;
+      this->mHasPeeked = true;
+      return this->mPeeked = Name;
+
+    case DanglingName:
+      if (this->skipWhitespace() != ':') {
+        return this->setError("Expected ':'");
+      }
+      ++this->mPosition;
+      scope = NonEmptyObject;
+      break;
+
+    case EmptyDocument:
+      scope = NonEmptyDocument;
+      break;
+
+    case NonEmptyDocument:
+      if (this->skipWhitespace() || this->mPosition < this->mLength) {
+        return this->setError("Unexpected data after document");
+      }
+      this->mHasPeeked = true;
+      return this->mPeeked = EndDocument;
+  }
+
+  return this->peekValue();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiJSONReader::TokenType vesKiwiJSONReader::peekValue()
+{
+  TokenType type;
+  switch (this->skipWhitespace()) {
+    case '{': type = BeginObject; break;
+    case '[': type = BeginArray; break;
+    case '"': type = String; break;
+    case 't':
+    case 'f': type = Boolean; break;
+    case 'n': type = Null; break;
+    case '-':
+    case '0': case '1': case '2': case '3': case '4':
+    case '5': case '6': case '7': case '8': case '9':
+      type = Number;
+      break;
+    case 0:
+      if (this->mPosition >= this->mLength) {
+        return this->setError("Unexpected end of input");
+      }
+      // fall through
+    default:
+      return this->setError("Unexpected character");
+  }
+
+  this->mHasPeeked = true;
+  return this->mPeeked = type;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::consume(TokenType expected)
+{
+  if (this->peek() != expected) {
+    if (!this->mHasError) {
+      this->setError("Unexpected token");
+    }
+    return false;
+  }
+  this->mHasPeeked = false;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::beginObject()
+{
+  if (!this->consume(BeginObject)) {
+    return false;
+  }
+  ++this->mPosition;
+  this->mStack.push_back(EmptyObject);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::endObject()
+{
+  if (!this->consume(EndObject)) {
+    return false;
+  }
+  ++this->mPosition;
+  this->mStack.pop_back();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::beginArray()
+{
+  if (!this->consume(BeginArray)) {
+    return false;
+  }
+  ++this->mPosition;
+  this->mStack.push_back(EmptyArray);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::endArray()
+{
+  if (!this->consume(EndArray)) {
+    return false;
+  }
+  ++this->mPosition;
+  this->mStack.pop_back();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::hasNext()
+{
+  TokenType type = this->peek();
+  return type != EndObject && type != EndArray && type != EndDocument && type != Invalid;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::readString(std::string& value)
+{
+  // the position is on the opening quote
+  size_t pos = this->mPosition + 1;
+  value.clear();
+
+  while (true) {
+
+    // copy runs of plain characters at once
+    size_t start = pos;
+    while (pos < this->mLength && this->mData[pos] != '"' && this->mData[pos] != '\\') {
+      ++pos;
+    }
+    value.append(this->mData + start, pos - start);
+
+    if (pos >= this->mLength) {
+      this->mPosition = pos;
+      this->setError("Unterminated string");
+      return false;
+    }
+
+    if (this->mData[pos] == '"') {
+      this->mPosition = pos + 1;
+      return true;
+    }
+
+    // escape sequence
+    if (pos + 1 >= this->mLength) {
+      this->mPosition = pos;
+      this->setError("Unterminated string");
+      return false;
+    }
+
+    char escaped = this->mData[pos + 1];
+    pos += 2;
+    switch (escaped) {
+      case '"': value += '"'; break;
+      case '\\': value += '\\'; break;
+      case '/': value += '/'; break;
+      case 'b': value += '\b'; break;
+      case 'f': value += '\f'; break;
+      case 'n': value += '\n'; break;
+      case 'r': value += '\r'; break;
+      case 't': value += '\t'; break;
+      case 'u': {
+        unsigned int codePoint = 0;
+        for (int i = 0; i < 4; ++i) {
+          int digit = pos < this->mLength ? hexValue(this->mData[pos++]) : -1;
+          if (digit < 0) {
+            this->mPosition = pos;
+            this->setError("Invalid unicode escape");
+            return false;
+          }
+          codePoint = codePoint*16 + digit;
+        }
+
+        // combine a surrogate pair
+        if (codePoint >= 0xD800 && codePoint <= 0xDBFF && pos + 6 <= this->mLength
+            && this->mData[pos] == '\\' && this->mData[pos + 1] == 'u') {
+          unsigned int low = 0;
+          bool isValid = true;
+          for (int i = 0; i < 4; ++i) {
+            int digit = hexValue(this->mData[pos + 2 + i]);
+            isValid = isValid && digit >= 0;
+            low = low*16 + (digit >= 0 ? digit : 0);
+          }
+          if (isValid && low >= 0xDC00 && low <= 0xDFFF) {
+            codePoint = 0x10000 + ((codePoint - 0xD800) << 10) + (low - 0xDC00);
+            pos += 6;
+          }
+        }
+
+        appendUTF8(value, codePoint);
+        break;
+      }
+      default:
+        this->mPosition = pos;
+        this->setError("Invalid escape sequence");
+        return false;
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::skipString()
+{
+  size_t pos = this->mPosition + 1;
+  while (pos < this->mLength) {
+    char c = this->mData[pos];
+    if (c == '"') {
+      this->mPosition = pos + 1;
+      return true;
+    }
+    pos += (c == '\\') ? 2 : 1;
+  }
+
+  this->mPosition = this->mLength;
+  this->setError("Unterminated string");
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::skipLiteral()
+{
+  while (this->mPosition < this->mLength && !isDelimiter(this->mData[this->mPosition])) {
+    ++this->mPosition;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::expectLiteral(const char* literal)
+{
+  size_t pos = this->mPosition;
+  for (const char* c = literal; *c; ++c, ++pos) {
+    if (pos >= this->mLength || this->mData[pos] != *c) {
+      this->setError("Invalid literal");
+      return false;
+    }
+  }
+
+  if (pos < this->mLength && !isDelimiter(this->mData[pos])) {
+    this->setError("Invalid literal");
+    return false;
+  }
+
+  this->mPosition = pos;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiJSONReader::nextName()
+{
+  std::string name;
+  if (this->consume(Name)) {
+    this->readString(name);
+  }
+  return name;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiJSONReader::nextString()
+{
+  std::string value;
+  if (this->consume(String)) {
+    this->readString(value);
+  }
+  return value;
+}
+
+//----------------------------------------------------------------------------
+double vesKiwiJSONReader::nextDouble()
+{
+  if (!this->consume(Number)) {
+    return 0.0;
+  }
+
+  // parse without strtod so the result does not depend on the locale and
+  // the input does not need to be null terminated
+  const char* c = this->mData + this->mPosition;
+  const char* end = this->mData + this->mLength;
+
+  double sign = 1.0;
+  if (c < end && *c == '-') {
+    sign = -1.0;
+    ++c;
+  }
+
+  double value = 0.0;
+  bool hasDigits = false;
+  while (c < end && *c >= '0' && *c <= '9') {
+    value = value*10.0 + (*c++ - '0');
+    hasDigits = true;
+  }
+
+  int scale = 0;
+  if (c < end && *c == '.') {
+    ++c;
+    while (c < end && *c >= '0' && *c <= '9') {
+      value = value*10.0 + (*c++ - '0');
+      --scale;
+      hasDigits = true;
+    }
+  }
+
+  if (c < end && (*c == 'e' || *c == 'E')) {
+    ++c;
+    int exponentSign = 1;
+    if (c < end && (*c == '+' || *c == '-')) {
+      exponentSign = (*c++ == '-') ? -1 : 1;
+    }
+    int exponent = 0;
+    while (c < end && *c >= '0' && *c <= '9') {
+      exponent = exponent*10 + (*c++ - '0');
+    }
+    scale += exponentSign*exponent;
+  }
+
+  this->mPosition = c - this->mData;
+
+  if (!hasDigits || (c < end && !isDelimiter(*c))) {
+    this->setError("Invalid number");
+    return 0.0;
+  }
+
+  return sign*(scale ? value*pow(10.0, scale) : value);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiJSONReader::nextInt()
+{
+  return static_cast<int>(this->nextDouble());
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::nextBool()
+{
+  if (!this->consume(Boolean)) {
+    return false;
+  }
+
+  if (this->mData[this->mPosition] == 't') {
+    return this->expectLiteral("true");
+  }
+
+  this->expectLiteral("false");
+  return false;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::nextNull()
+{
+  return this->consume(Null) && this->expectLiteral("null");
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiJSONReader::skipValue()
+{
+  TokenType type = this->peek();
+
+  if (type == Name) {
+    this->mHasPeeked = false;
+    this->skipString();
+    type = this->peek();
+  }
+
+  if (type == Invalid || type == EndObject || type == EndArray || type == EndDocument) {
+    this->setError("Expected a value");
+    return;
+  }
+
+  this->mHasPeeked = false;
+
+  if (type == String) {
+    this->skipString();
+    return;
+  }
+
+  if (type != BeginObject && type != BeginArray) {
+    this->skipLiteral();
+    return;
+  }
+
+  // scan to the matching bracket, stepping over strings
+  int depth = 0;
+  while (this->mPosition < this->mLength) {
+    char c = this->mData[this->mPosition];
+    if (c == '"') {
+      if (!this->skipString()) {
+        return;
+      }
+      continue;
+    }
+    if (c == '{' || c == '[') {
+      ++depth;
+    }
+    else if (c == '}' || c == ']') {
+      if (--depth == 0) {
+        ++this->mPosition;
+        return;
+      }
+    }
+    ++this->mPosition;
+  }
+
+  this->setError("Unterminated object or array");
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiJSONReader::nextRawValue(const char*& data, size_t& length)
+{
+  // resolve a pending name and separators first so the span starts at the
+  // value itself
+  if (this->peek() == Name) {
+    this->nextName();
+  }
+
+  if (this->peek() == Invalid) {
+    return false;
+  }
+
+  size_t start = this->mPosition;
+  this->skipValue();
+  if (this->mHasError) {
+    return false;
+  }
+
+  data = this->mData + start;
+  length = this->mPosition - start;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::vector<double> vesKiwiJSONReader::nextDoubleArray()
+{
+  std::vector<double> values;
+  if (!this->beginArray()) {
+    return values;
+  }
+
+  while (this->hasNext()) {
+    if (this->peek() == Number) {
+      values.push_back(this->nextDouble());
+    }
+    else {
+      this->skipValue();
+    }
+  }
+
+  this->endArray();
+  return values;
+}
+
+//----------------------------------------------------------------------------
+std::vector<std::string> vesKiwiJSONReader::nextStringArray()
+{
+  std::vector<std::string> values;
+  if (!this->beginArray()) {
+    return values;
+  }
+
+  while (this->hasNext()) {
+    if (this->peek() == String) {
+      values.push_back(this->nextString());
+    }
+    else {
+      this->skipValue();
+    }
+  }
+
+  this->endArray();
+  return values;
+}
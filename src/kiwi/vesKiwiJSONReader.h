@@ -0,0 +1,162 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiJSONReader
+/// \ingroup KiwiPlatform
+/// \brief Pull parser that reads JSON tokens straight from a buffer.
+///
+/// The reader walks the input one token at a time and never builds a
+/// document tree, so the caller decides what to keep and everything else is
+/// skipped without being decoded.  The input is either a caller owned buffer,
+/// which is not copied and must outlive the reader, or a file that is memory
+/// mapped by openFile().
+///
+/// \code
+/// reader.beginObject();
+/// while (reader.hasNext()) {
+///   std::string name = reader.nextName();
+///   if (name == "opacity" && reader.peek() == vesKiwiJSONReader::Number) {
+///     opacity = reader.nextDouble();
+///   }
+///   else {
+///     reader.skipValue();
+///   }
+/// }
+/// reader.endObject();
+/// \endcode
+///
+/// Errors do not throw.  The first error is recorded, every later call
+/// returns a default value, and hasError() reports the failure.
+#ifndef __vesKiwiJSONReader_h
+#define __vesKiwiJSONReader_h
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+class vesKiwiJSONReader
+{
+public:
+
+  enum TokenType
+  {
+    BeginObject,
+    EndObject,
+    BeginArray,
+    EndArray,
+    Name,
+    String,
+    Number,
+    Boolean,
+    Null,
+    EndDocument,
+    Invalid
+  };
+
+  vesKiwiJSONReader();
+  vesKiwiJSONReader(const char* data, size_t length);
+  ~vesKiwiJSONReader();
+
+  /// Read from the given buffer.  The buffer is not copied.
+  void setInput(const char* data, size_t length);
+
+  /// Memory map the file and read from it.  Returns false if the file could
+  /// not be mapped.
+  bool openFile(const std::string& filename);
+
+  /// Returns the type of the next token without consuming it.
+  TokenType peek();
+
+  bool beginObject();
+  bool endObject();
+  bool beginArray();
+  bool endArray();
+
+  /// Returns true if the current object or array has another element.
+  bool hasNext();
+
+  std::string nextName();
+  std::string nextString();
+  double nextDouble();
+  int nextInt();
+  bool nextBool();
+  bool nextNull();
+
+  /// Skip the next value, including nested objects and arrays, without
+  /// decoding it.  A pending name is skipped together with its value.
+  void skipValue();
+
+  /// Skip the next value and return the span of the input it occupies, for
+  /// example to hand a nested document to another reader.
+  bool nextRawValue(const char*& data, size_t& length);
+
+  /// Convenience readers for arrays of values.  Elements of other types are
+  /// skipped.
+  std::vector<double> nextDoubleArray();
+  std::vector<std::string> nextStringArray();
+
+  bool hasError() const;
+  std::string errorMessage() const;
+
+  /// Returns the offset of the reader in the input.
+  size_t position() const;
+
+private:
+
+  vesKiwiJSONReader(const vesKiwiJSONReader&); // Not implemented
+  void operator=(const vesKiwiJSONReader&); // Not implemented
+
+  enum ScopeType
+  {
+    EmptyDocument,
+    NonEmptyDocument,
+    EmptyArray,
+    NonEmptyArray,
+    EmptyObject,
+    DanglingName,
+    NonEmptyObject
+  };
+
+  void reset();
+  void closeFile();
+  char skipWhitespace();
+  TokenType peekValue();
+  TokenType setError(const std::string& message);
+  bool consume(TokenType expected);
+  bool readString(std::string& value);
+  bool skipString();
+  bool skipLiteral();
+  bool expectLiteral(const char* literal);
+
+  const char* mData;
+  size_t mLength;
+  size_t mPosition;
+  TokenType mPeeked;
+  bool mHasPeeked;
+  std::vector<ScopeType> mStack;
+
+  bool mHasError;
+  std::string mErrorMessage;
+
+  void* mMappedFile;
+  size_t mMappedFileLength;
+};
+
+
+#endif
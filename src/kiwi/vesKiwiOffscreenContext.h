@@ -0,0 +1,226 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiOffscreenContext
+/// \ingroup KiwiPlatform
+/// \brief A GL context without a window, for benchmarks and servers.
+//
+/// The context renders into a pbuffer created with EGL, or into a memory
+/// buffer with OSMesa when the target is compiled with
+/// VES_OFFSCREEN_USE_OSMESA.  Both work with Mesa's llvmpipe software
+/// rasterizer, so no GPU or display server is needed.  When EGL has no
+/// default display, the Mesa surfaceless platform is used.
+///
+/// Like vesKiwiTestHelper, this class is header only so that kiwi does not
+/// link EGL or OSMesa.  Targets that include it link ${EGL_LIBRARIES} or
+/// ${OSMESA_LIBRARIES}.
+#ifndef __vesKiwiOffscreenContext_h
+#define __vesKiwiOffscreenContext_h
+
+#include "vesGL.h"
+#include "vesSetGet.h"
+
+#ifdef VES_OFFSCREEN_USE_OSMESA
+  #include <GL/osmesa.h>
+  #include <vector>
+#else
+  #include <EGL/egl.h>
+  #include <EGL/eglext.h>
+#endif
+
+#include <string>
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+  #define EGL_PLATFORM_SURFACELESS_MESA 0x31DD
+#endif
+
+class vesKiwiOffscreenContext
+{
+public:
+
+  vesTypeMacro(vesKiwiOffscreenContext);
+
+  vesKiwiOffscreenContext() :
+#ifdef VES_OFFSCREEN_USE_OSMESA
+    Context(0),
+#else
+    Display(EGL_NO_DISPLAY),
+    Surface(EGL_NO_SURFACE),
+    Context(EGL_NO_CONTEXT),
+#endif
+    Width(0),
+    Height(0)
+  {
+  }
+
+  ~vesKiwiOffscreenContext()
+  {
+#ifdef VES_OFFSCREEN_USE_OSMESA
+    if (this->Context) {
+      OSMesaDestroyContext(this->Context);
+    }
+#else
+    // The display is shared by every context of the process, so it is not
+    // terminated here.
+    if (this->Context != EGL_NO_CONTEXT) {
+      if (eglGetCurrentContext() == this->Context) {
+        eglMakeCurrent(this->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+      }
+      eglDestroyContext(this->Display, this->Context);
+    }
+    if (this->Surface != EGL_NO_SURFACE) {
+      eglDestroySurface(this->Display, this->Surface);
+    }
+#endif
+  }
+
+  /// Create the context with a default framebuffer of the given size, with
+  /// 8 bit RGBA color and a depth buffer.  Returns false on failure, see
+  /// errorMessage().
+  bool initialize(int width, int height)
+  {
+    this->Width = width;
+    this->Height = height;
+
+#ifdef VES_OFFSCREEN_USE_OSMESA
+    this->Context = OSMesaCreateContextExt(OSMESA_RGBA, 24, 0, 0, 0);
+    if (!this->Context) {
+      this->ErrorMessage = "OSMesaCreateContextExt failed";
+      return false;
+    }
+    this->Buffer.resize(static_cast<size_t>(width) * height * 4);
+    return true;
+#else
+    this->Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (this->Display == EGL_NO_DISPLAY || !eglInitialize(this->Display, 0, 0)) {
+      this->Display = surfacelessDisplay();
+      if (this->Display == EGL_NO_DISPLAY || !eglInitialize(this->Display, 0, 0)) {
+        this->ErrorMessage = "no EGL display could be initialized";
+        return false;
+      }
+    }
+
+#ifdef VES_USE_DESKTOP_GL
+    const EGLenum api = EGL_OPENGL_API;
+    const EGLint renderableType = EGL_OPENGL_BIT;
+    const EGLint* contextAttributes = 0;
+#else
+    const EGLenum api = EGL_OPENGL_ES_API;
+    const EGLint renderableType = EGL_OPENGL_ES2_BIT;
+    const EGLint contextAttributes[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+#endif
+
+    const EGLint configAttributes[] = {
+      EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+      EGL_RENDERABLE_TYPE, renderableType,
+      EGL_RED_SIZE, 8,
+      EGL_GREEN_SIZE, 8,
+      EGL_BLUE_SIZE, 8,
+      EGL_ALPHA_SIZE, 8,
+      EGL_DEPTH_SIZE, 24,
+      EGL_NONE
+    };
+
+    EGLConfig config;
+    EGLint numberOfConfigs = 0;
+    if (!eglChooseConfig(this->Display, configAttributes, &config, 1, &numberOfConfigs)
+        || numberOfConfigs < 1) {
+      this->ErrorMessage = "no EGL config with an RGBA8 pbuffer and depth";
+      return false;
+    }
+
+    const EGLint surfaceAttributes[] = { EGL_WIDTH, width, EGL_HEIGHT, height, EGL_NONE };
+    this->Surface = eglCreatePbufferSurface(this->Display, config, surfaceAttributes);
+    if (this->Surface == EGL_NO_SURFACE) {
+      this->ErrorMessage = "eglCreatePbufferSurface failed";
+      return false;
+    }
+
+    eglBindAPI(api);
+    this->Context = eglCreateContext(this->Display, config, EGL_NO_CONTEXT, contextAttributes);
+    if (this->Context == EGL_NO_CONTEXT) {
+      this->ErrorMessage = "eglCreateContext failed";
+      return false;
+    }
+    return true;
+#endif
+  }
+
+  /// Make the context current on the calling thread.
+  bool makeCurrent()
+  {
+#ifdef VES_OFFSCREEN_USE_OSMESA
+    return this->Context
+      && OSMesaMakeCurrent(this->Context, &this->Buffer[0], GL_UNSIGNED_BYTE,
+                           this->Width, this->Height);
+#else
+    return this->Context != EGL_NO_CONTEXT
+      && eglMakeCurrent(this->Display, this->Surface, this->Surface, this->Context);
+#endif
+  }
+
+  /// Release the context from the calling thread, so that another thread
+  /// can make it current.
+  void doneCurrent()
+  {
+#ifdef VES_OFFSCREEN_USE_OSMESA
+    // OSMesa contexts are released by making another one current.
+    glFinish();
+#else
+    eglMakeCurrent(this->Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+#endif
+  }
+
+  int width() const { return this->Width; }
+  int height() const { return this->Height; }
+
+  std::string errorMessage() const { return this->ErrorMessage; }
+
+private:
+
+  vesKiwiOffscreenContext(const vesKiwiOffscreenContext&); // Not implemented
+  void operator=(const vesKiwiOffscreenContext&); // Not implemented
+
+#ifndef VES_OFFSCREEN_USE_OSMESA
+  static EGLDisplay surfacelessDisplay()
+  {
+    PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+      reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(
+        eglGetProcAddress("eglGetPlatformDisplayEXT"));
+    if (!getPlatformDisplay) {
+      return EGL_NO_DISPLAY;
+    }
+    return getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, 0);
+  }
+#endif
+
+#ifdef VES_OFFSCREEN_USE_OSMESA
+  OSMesaContext Context;
+  std::vector<unsigned char> Buffer;
+#else
+  EGLDisplay Display;
+  EGLSurface Surface;
+  EGLContext Context;
+#endif
+  int Width;
+  int Height;
+  std::string ErrorMessage;
+};
+
+#endif
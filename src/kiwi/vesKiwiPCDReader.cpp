@@ -0,0 +1,992 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiPCDReader.h"
+#include "vesKiwiOptions.h"
+
+#include "vesGeometryData.h"
+
+#ifdef VES_USE_PCL
+#include "vesKiwiDataConversionTools.h"
+#include "vtkPCLConversions.h"
+#include <vtkPolyData.h>
+#include <vtkUnsignedCharArray.h>
+#endif
+
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#if !defined(_WIN32)
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif
+
+namespace {
+
+//----------------------------------------------------------------------------
+// Read only view of a whole file.  Files are memory mapped where possible so
+// that the points are decoded straight from the page cache.
+class vesMappedFile
+{
+public:
+
+  vesMappedFile() : Data(0), Size(0)
+  {
+  }
+
+  ~vesMappedFile()
+  {
+    this->close();
+  }
+
+  bool open(const std::string& filename)
+  {
+    this->close();
+#if defined(_WIN32)
+    FILE* file = fopen(filename.c_str(), "rb");
+    if (!file) {
+      return false;
+    }
+    fseek(file, 0, SEEK_END);
+    this->Buffer.resize(ftell(file));
+    fseek(file, 0, SEEK_SET);
+    const bool success = this->Buffer.empty()
+      || fread(&this->Buffer[0], 1, this->Buffer.size(), file) == this->Buffer.size();
+    fclose(file);
+    this->Data = this->Buffer.empty() ? 0 : &this->Buffer[0];
+    this->Size = this->Buffer.size();
+    return success;
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      return false;
+    }
+    struct stat status;
+    if (fstat(fd, &status) != 0) {
+      ::close(fd);
+      return false;
+    }
+    this->Size = static_cast<size_t>(status.st_size);
+    if (this->Size) {
+      void* data = mmap(0, this->Size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        this->Size = 0;
+        ::close(fd);
+        return false;
+      }
+      madvise(data, this->Size, MADV_SEQUENTIAL);
+      this->Data = static_cast<const unsigned char*>(data);
+    }
+    ::close(fd);
+    return true;
+#endif
+  }
+
+  void close()
+  {
+#if defined(_WIN32)
+    this->Buffer.clear();
+#else
+    if (this->Data) {
+      munmap(const_cast<unsigned char*>(this->Data), this->Size);
+    }
+#endif
+    this->Data = 0;
+    this->Size = 0;
+  }
+
+  const unsigned char* Data;
+  size_t Size;
+
+#if defined(_WIN32)
+  std::vector<unsigned char> Buffer;
+#endif
+};
+
+//----------------------------------------------------------------------------
+struct vesPCDField
+{
+  std::string Name;
+  int Size;
+  char Type;
+  int Count;
+};
+
+//----------------------------------------------------------------------------
+// Decompress the LZF stream that PCL writes for binary_compressed files.
+bool lzfDecompress(const unsigned char* input, size_t inputLength,
+                   unsigned char* output, size_t outputLength)
+{
+  const unsigned char* in = input;
+  const unsigned char* inEnd = input + inputLength;
+  unsigned char* out = output;
+  unsigned char* outEnd = output + outputLength;
+
+  while (in < inEnd) {
+    unsigned int control = *in++;
+
+    if (control < 32) {
+      // literal run
+      const size_t length = control + 1;
+      if (static_cast<size_t>(outEnd - out) < length
+          || static_cast<size_t>(inEnd - in) < length) {
+        return false;
+      }
+      memcpy(out, in, length);
+      out += length;
+      in += length;
+    }
+    else {
+      // back reference, which may overlap the bytes it produces
+      size_t length = control >> 5;
+      if (in >= inEnd) {
+        return false;
+      }
+      if (length == 7) {
+        length += *in++;
+        if (in >= inEnd) {
+          return false;
+        }
+      }
+      const size_t distance = ((control & 0x1f) << 8) + *in++ + 1;
+      length += 2;
+      if (static_cast<size_t>(out - output) < distance
+          || static_cast<size_t>(outEnd - out) < length) {
+        return false;
+      }
+      const unsigned char* reference = out - distance;
+      for (size_t i = 0; i < length; ++i) {
+        out[i] = reference[i];
+      }
+      out += length;
+    }
+  }
+
+  return out == outEnd;
+}
+
+//----------------------------------------------------------------------------
+inline float readValue(const unsigned char* data, char type, int size)
+{
+  switch (type) {
+    case 'F':
+      if (size == 4) {
+        float value;
+        memcpy(&value, data, 4);
+        return value;
+      }
+      else {
+        double value;
+        memcpy(&value, data, 8);
+        return static_cast<float>(value);
+      }
+    case 'I':
+      switch (size) {
+        case 1: return static_cast<float>(*reinterpret_cast<const signed char*>(data));
+        case 2: { short value; memcpy(&value, data, 2); return value; }
+        case 4: { int value; memcpy(&value, data, 4); return static_cast<float>(value); }
+        default: { long long value; memcpy(&value, data, 8); return static_cast<float>(value); }
+      }
+    default:
+      switch (size) {
+        case 1: return *data;
+        case 2: { unsigned short value; memcpy(&value, data, 2); return value; }
+        case 4: { unsigned int value; memcpy(&value, data, 4); return static_cast<float>(value); }
+        default: { unsigned long long value; memcpy(&value, data, 8); return static_cast<float>(value); }
+      }
+  }
+}
+
+//----------------------------------------------------------------------------
+// Parse a number of an ascii body.  The mapped file is not null terminated,
+// so strtod() cannot be used safely.  Sets \p isInteger when the token has no
+// fraction or exponent, and returns NaN for nan/inf tokens.
+inline double parseNumber(const char*& p, const char* end, bool& isInteger)
+{
+  isInteger = true;
+  bool isNegative = false;
+  if (p < end && (*p == '-' || *p == '+')) {
+    isNegative = *p == '-';
+    ++p;
+  }
+
+  if (p < end && (*p == 'n' || *p == 'N' || *p == 'i' || *p == 'I')) {
+    while (p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '\r') {
+      ++p;
+    }
+    isInteger = false;
+    return std::numeric_limits<double>::quiet_NaN();
+  }
+
+  unsigned long long mantissa = 0;
+  int exponent = 0;
+  int numberOfDigits = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    if (numberOfDigits < 19) {
+      mantissa = 10 * mantissa + (*p - '0');
+      ++numberOfDigits;
+    }
+    else {
+      ++exponent;
+    }
+  }
+  if (p < end && *p == '.') {
+    isInteger = false;
+    for (++p; p < end && *p >= '0' && *p <= '9'; ++p) {
+      if (numberOfDigits < 19) {
+        mantissa = 10 * mantissa + (*p - '0');
+        ++numberOfDigits;
+        --exponent;
+      }
+    }
+  }
+  if (p < end && (*p == 'e' || *p == 'E')) {
+    isInteger = false;
+    ++p;
+    bool isExponentNegative = false;
+    if (p < end && (*p == '-' || *p == '+')) {
+      isExponentNegative = *p == '-';
+      ++p;
+    }
+    int value = 0;
+    for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+      value = std::min(10 * value + (*p - '0'), 1000);
+    }
+    exponent += isExponentNegative ? -value : value;
+  }
+
+  // Powers of ten up to 1e22 are exact doubles.
+  static const double powersOfTen[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22};
+  double value = static_cast<double>(mantissa);
+  if (exponent < 0 && exponent >= -22) {
+    value /= powersOfTen[-exponent];
+  }
+  else if (exponent > 0 && exponent <= 22) {
+    value *= powersOfTen[exponent];
+  }
+  else if (exponent) {
+    value *= pow(10.0, exponent);
+  }
+  return isNegative ? -value : value;
+}
+
+//----------------------------------------------------------------------------
+inline bool isFinite(float value)
+{
+  return value - value == 0.0f;
+}
+
+//----------------------------------------------------------------------------
+inline void setVertex(vesVertexDataP3f& vertex, const float position[3], unsigned int)
+{
+  vertex.m_position = vesVector3f(position[0], position[1], position[2]);
+}
+
+//----------------------------------------------------------------------------
+inline void setVertex(vesVertexDataP3C4ub& vertex, const float position[3], unsigned int packedColor)
+{
+  vertex.m_position = vesVector3f(position[0], position[1], position[2]);
+  vertex.m_color[0] = static_cast<unsigned char>(packedColor >> 16);
+  vertex.m_color[1] = static_cast<unsigned char>(packedColor >> 8);
+  vertex.m_color[2] = static_cast<unsigned char>(packedColor);
+  vertex.m_color[3] = static_cast<unsigned char>(packedColor >> 24);
+}
+
+//----------------------------------------------------------------------------
+// Shared state of the decoding threads.  Thread i decodes chunk i into the
+// output starting at ChunkBegin[i], keeping only finite points, and stores how
+// many it kept in ValidCount[i].  The chunks are compacted afterwards.
+struct vesDecodeTask
+{
+  enum Pass
+  {
+    CountLines,
+    Decode
+  };
+
+  Pass CurrentPass;
+  int NumberOfChunks;
+  size_t NumberOfPoints;
+
+  // binary and binary_compressed: value of coordinate j (x, y, z, color) of
+  // point i is at Data + Offsets[j] + i * Strides[j].
+  const unsigned char* Data;
+  size_t Offsets[4];
+  size_t Strides[4];
+  char Types[3];
+  int Sizes[3];
+
+  // ascii: chunks of whole lines, and the token column of each coordinate.
+  const char* Text;
+  std::vector<size_t> TextBegin;
+  int Columns[4];
+  int LastColumn;
+  char ColorType;
+
+  bool HasColors;
+  unsigned int AlphaMask;
+  void* Output;
+
+  std::vector<size_t> ChunkBegin;
+  std::vector<size_t> ValidCount;
+
+  template <typename VertexT>
+  void decodeBinary(int chunk)
+  {
+    VertexT* output = static_cast<VertexT*>(this->Output);
+    const size_t begin = this->ChunkBegin[chunk];
+    const size_t end = this->ChunkBegin[chunk + 1];
+
+    size_t count = 0;
+    float position[3];
+    unsigned int packedColor = 0;
+    for (size_t i = begin; i < end; ++i) {
+      for (int j = 0; j < 3; ++j) {
+        position[j] = readValue(this->Data + this->Offsets[j] + i * this->Strides[j],
+                                this->Types[j], this->Sizes[j]);
+      }
+      if (!isFinite(position[0]) || !isFinite(position[1]) || !isFinite(position[2])) {
+        continue;
+      }
+      if (this->HasColors) {
+        memcpy(&packedColor, this->Data + this->Offsets[3] + i * this->Strides[3], 4);
+        packedColor |= this->AlphaMask;
+      }
+      setVertex(output[begin + count], position, packedColor);
+      ++count;
+    }
+    this->ValidCount[chunk] = count;
+  }
+
+  template <typename VertexT>
+  void decodeAscii(int chunk)
+  {
+    VertexT* output = static_cast<VertexT*>(this->Output);
+    const char* p = this->Text + this->TextBegin[chunk];
+    const char* end = this->Text + this->TextBegin[chunk + 1];
+    const bool isCounting = this->CurrentPass == CountLines;
+    const size_t begin = isCounting ? 0 : this->ChunkBegin[chunk];
+    const size_t maximumCount = isCounting ? this->NumberOfPoints
+      : this->ChunkBegin[chunk + 1] - this->ChunkBegin[chunk];
+
+    size_t numberOfLines = 0;
+    size_t count = 0;
+    while (numberOfLines < maximumCount) {
+      while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')) {
+        ++p;
+      }
+      if (p == end) {
+        break;
+      }
+      const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+      if (!lineEnd) {
+        lineEnd = end;
+      }
+      ++numberOfLines;
+      if (isCounting) {
+        p = lineEnd;
+        continue;
+      }
+
+      float position[3] = {0.0f, 0.0f, 0.0f};
+      unsigned int packedColor = 0;
+      for (int column = 0; p < lineEnd && column <= this->LastColumn; ++column) {
+        bool isInteger;
+        const double value = parseNumber(p, lineEnd, isInteger);
+        for (int j = 0; j < 3; ++j) {
+          if (column == this->Columns[j]) {
+            position[j] = static_cast<float>(value);
+          }
+        }
+        if (column == this->Columns[3]) {
+          if (isInteger || this->ColorType != 'F') {
+            packedColor = static_cast<unsigned int>(value);
+          }
+          else {
+            const float floatValue = static_cast<float>(value);
+            memcpy(&packedColor, &floatValue, 4);
+          }
+          packedColor |= this->AlphaMask;
+        }
+        while (p < lineEnd && *p != ' ' && *p != '\t') {
+          ++p;
+        }
+        while (p < lineEnd && (*p == ' ' || *p == '\t' || *p == '\r')) {
+          ++p;
+        }
+      }
+      p = lineEnd;
+
+      if (!isFinite(position[0]) || !isFinite(position[1]) || !isFinite(position[2])) {
+        continue;
+      }
+      setVertex(output[begin + count], position, packedColor);
+      ++count;
+    }
+
+    if (isCounting) {
+      this->ValidCount[chunk] = numberOfLines;
+    }
+    else {
+      this->ValidCount[chunk] = count;
+    }
+  }
+
+  void run(int chunk)
+  {
+    if (chunk >= this->NumberOfChunks) {
+      return;
+    }
+    if (this->Text) {
+      if (this->HasColors) {
+        this->decodeAscii<vesVertexDataP3C4ub>(chunk);
+      }
+      else {
+        this->decodeAscii<vesVertexDataP3f>(chunk);
+      }
+    }
+    else if (this->HasColors) {
+      this->decodeBinary<vesVertexDataP3C4ub>(chunk);
+    }
+    else {
+      this->decodeBinary<vesVertexDataP3f>(chunk);
+    }
+  }
+
+  // Move the valid points of each chunk next to the previous chunk's and
+  // return the total number of valid points.
+  template <typename VertexT>
+  size_t compact()
+  {
+    VertexT* output = static_cast<VertexT*>(this->Output);
+    size_t numberOfPoints = 0;
+    for (int i = 0; i < this->NumberOfChunks; ++i) {
+      if (this->ChunkBegin[i] != numberOfPoints && this->ValidCount[i]) {
+        // The destination is before the source, so a forward copy is safe.
+        std::copy(output + this->ChunkBegin[i],
+                  output + this->ChunkBegin[i] + this->ValidCount[i],
+                  output + numberOfPoints);
+      }
+      numberOfPoints += this->ValidCount[i];
+    }
+    return numberOfPoints;
+  }
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE DecodeChunk(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vesDecodeTask* task = static_cast<vesDecodeTask*>(threadInfo->UserData);
+  task->run(threadInfo->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiPCDReader::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    this->reset();
+  }
+
+  void reset()
+  {
+    this->Fields.clear();
+    this->Width = 0;
+    this->Height = 1;
+    this->NumberOfPoints = 0;
+    this->HasColors = false;
+    this->Encoding = Ascii;
+    this->Viewpoint = vesMatrix4x4f::Identity();
+    this->GeometryData.reset();
+  }
+
+  bool fail(const std::string& message)
+  {
+    this->ErrorMessage = message;
+    this->GeometryData.reset();
+    return false;
+  }
+
+  bool parseHeader(const unsigned char* data, size_t size, size_t& dataOffset);
+  bool decode(const unsigned char* data, size_t size, size_t dataOffset);
+  void runTask(vesDecodeTask& task);
+
+  int NumberOfThreads;
+  std::string ErrorMessage;
+
+  std::vector<vesPCDField> Fields;
+  unsigned int Width;
+  unsigned int Height;
+  unsigned int NumberOfPoints;
+  bool HasColors;
+  DataEncoding Encoding;
+  vesMatrix4x4f Viewpoint;
+
+  vesGeometryData::Ptr GeometryData;
+};
+
+//----------------------------------------------------------------------------
+bool vesKiwiPCDReader::vesInternal::parseHeader(const unsigned char* data, size_t size,
+                                                size_t& dataOffset)
+{
+  const char* text = reinterpret_cast<const char*>(data);
+  size_t position = 0;
+  bool hasPoints = false;
+
+  while (position < size) {
+    const char* lineEnd = static_cast<const char*>(memchr(text + position, '\n', size - position));
+    const size_t lineLength = lineEnd ? lineEnd - (text + position) : size - position;
+    std::istringstream line(std::string(text + position, lineLength));
+    position += lineLength + 1;
+
+    std::string key;
+    if (!(line >> key) || key[0] == '#') {
+      continue;
+    }
+
+    if (key == "VERSION") {
+      continue;
+    }
+    else if (key == "FIELDS") {
+      std::string name;
+      while (line >> name) {
+        vesPCDField field;
+        field.Name = name;
+        field.Size = 4;
+        field.Type = 'F';
+        field.Count = 1;
+        this->Fields.push_back(field);
+      }
+    }
+    else if (key == "SIZE" || key == "TYPE" || key == "COUNT") {
+      for (size_t i = 0; i < this->Fields.size(); ++i) {
+        std::string value;
+        if (!(line >> value)) {
+          return this->fail("Missing values in the " + key + " line");
+        }
+        if (key == "TYPE") {
+          this->Fields[i].Type = value[0];
+        }
+        else if (key == "SIZE") {
+          this->Fields[i].Size = atoi(value.c_str());
+        }
+        else {
+          this->Fields[i].Count = atoi(value.c_str());
+        }
+      }
+    }
+    else if (key == "WIDTH") {
+      line >> this->Width;
+    }
+    else if (key == "HEIGHT") {
+      line >> this->Height;
+    }
+    else if (key == "POINTS") {
+      line >> this->NumberOfPoints;
+      hasPoints = true;
+    }
+    else if (key == "VIEWPOINT") {
+      float values[7];
+      for (int i = 0; i < 7; ++i) {
+        line >> values[i];
+      }
+      if (line) {
+        Eigen::Quaternionf orientation(values[3], values[4], values[5], values[6]);
+        this->Viewpoint.setIdentity();
+        this->Viewpoint.block<3, 3>(0, 0) = orientation.toRotationMatrix();
+        this->Viewpoint.block<3, 1>(0, 3) = vesVector3f(values[0], values[1], values[2]);
+      }
+    }
+    else if (key == "DATA") {
+      std::string encoding;
+      line >> encoding;
+      if (encoding == "ascii") {
+        this->Encoding = Ascii;
+      }
+      else if (encoding == "binary") {
+        this->Encoding = Binary;
+      }
+      else if (encoding == "binary_compressed") {
+        this->Encoding = BinaryCompressed;
+      }
+      else {
+        return this->fail("Unknown data encoding: " + encoding);
+      }
+      dataOffset = std::min(position, size);
+
+      if (!hasPoints) {
+        this->NumberOfPoints = this->Width * this->Height;
+      }
+      for (size_t i = 0; i < this->Fields.size(); ++i) {
+        const vesPCDField& field = this->Fields[i];
+        const bool isValid = field.Count > 0
+          && ((field.Type == 'F' && (field.Size == 4 || field.Size == 8))
+              || ((field.Type == 'I' || field.Type == 'U')
+                  && (field.Size == 1 || field.Size == 2 || field.Size == 4 || field.Size == 8)));
+        if (!isValid) {
+          return this->fail("Unsupported type of field " + field.Name);
+        }
+      }
+      return true;
+    }
+    else {
+      return this->fail("Unknown header line: " + key);
+    }
+  }
+
+  return this->fail("The file has no DATA line");
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPCDReader::vesInternal::runTask(vesDecodeTask& task)
+{
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(task.NumberOfChunks);
+  threader->SetSingleMethod(DecodeChunk, &task);
+  threader->SingleMethodExecute();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPCDReader::vesInternal::decode(const unsigned char* data, size_t size,
+                                           size_t dataOffset)
+{
+  vesDecodeTask task;
+  task.Data = 0;
+  task.Text = 0;
+  task.HasColors = false;
+  task.AlphaMask = 0xff000000;
+  task.ColorType = 'U';
+  task.NumberOfPoints = this->NumberOfPoints;
+
+  // Locate x, y, z and the packed color in the record of a point.  Padding
+  // fields named "_" are only stored in the binary encoding.
+  const std::string names[4] = {"x", "y", "z", "rgb"};
+  int fieldIndices[4] = {-1, -1, -1, -1};
+  size_t fieldOffsets[4] = {0, 0, 0, 0};
+  size_t fieldColumns[4] = {0, 0, 0, 0};
+  size_t recordSize = 0;
+  size_t compactRecordSize = 0;
+  size_t numberOfColumns = 0;
+  std::vector<size_t> compressedOffsets;
+  for (size_t i = 0; i < this->Fields.size(); ++i) {
+    const vesPCDField& field = this->Fields[i];
+    for (int j = 0; j < 4; ++j) {
+      const bool isMatch = field.Name == names[j] || (j == 3 && field.Name == "rgba");
+      if (isMatch && fieldIndices[j] < 0) {
+        fieldIndices[j] = static_cast<int>(i);
+        fieldOffsets[j] = recordSize;
+        fieldColumns[j] = numberOfColumns;
+      }
+    }
+    compressedOffsets.push_back(compactRecordSize);
+    recordSize += field.Size * field.Count;
+    if (field.Name != "_") {
+      compactRecordSize += field.Size * field.Count;
+      numberOfColumns += field.Count;
+    }
+  }
+
+  if (fieldIndices[0] < 0 || fieldIndices[1] < 0 || fieldIndices[2] < 0) {
+    return this->fail("The file has no x, y and z fields");
+  }
+  if (fieldIndices[3] >= 0 && this->Fields[fieldIndices[3]].Size == 4) {
+    task.HasColors = true;
+    task.ColorType = this->Fields[fieldIndices[3]].Type;
+    task.AlphaMask = this->Fields[fieldIndices[3]].Name == "rgba" ? 0 : 0xff000000;
+  }
+  else {
+    fieldIndices[3] = -1;
+  }
+
+  for (int j = 0; j < 3; ++j) {
+    task.Types[j] = this->Fields[fieldIndices[j]].Type;
+    task.Sizes[j] = this->Fields[fieldIndices[j]].Size;
+  }
+
+  std::vector<unsigned char> uncompressed;
+  const size_t numberOfPoints = this->NumberOfPoints;
+
+  if (this->Encoding == Binary) {
+    if ((size - dataOffset) / std::max(recordSize, size_t(1)) < numberOfPoints) {
+      return this->fail("The file is shorter than its header says");
+    }
+    task.Data = data + dataOffset;
+    for (int j = 0; j < 4; ++j) {
+      task.Offsets[j] = fieldOffsets[j];
+      task.Strides[j] = recordSize;
+    }
+  }
+  else if (this->Encoding == BinaryCompressed) {
+    unsigned int sizes[2];
+    if (size - dataOffset < sizeof(sizes)) {
+      return this->fail("The file is shorter than its header says");
+    }
+    memcpy(sizes, data + dataOffset, sizeof(sizes));
+    if (sizes[1] != numberOfPoints * compactRecordSize
+        || sizes[0] > size - dataOffset - sizeof(sizes)) {
+      return this->fail("The compressed data does not match the header");
+    }
+
+    // The fields are stored one after the other, each for all points.
+    uncompressed.resize(sizes[1]);
+    if (sizes[1] && !lzfDecompress(data + dataOffset + sizeof(sizes), sizes[0],
+                                   &uncompressed[0], uncompressed.size())) {
+      return this->fail("Could not decompress the point data");
+    }
+    task.Data = uncompressed.empty() ? 0 : &uncompressed[0];
+    for (int j = 0; j < 4; ++j) {
+      if (fieldIndices[j] >= 0) {
+        const vesPCDField& field = this->Fields[fieldIndices[j]];
+        task.Offsets[j] = numberOfPoints * compressedOffsets[fieldIndices[j]];
+        task.Strides[j] = field.Size * field.Count;
+      }
+    }
+  }
+  else {
+    task.Text = reinterpret_cast<const char*>(data);
+    for (int j = 0; j < 4; ++j) {
+      task.Columns[j] = fieldIndices[j] >= 0 ? static_cast<int>(fieldColumns[j]) : -1;
+    }
+    task.LastColumn = *std::max_element(task.Columns, task.Columns + 4);
+  }
+
+  // Small clouds are not worth the threads.
+  const size_t minimumPointsPerChunk = 16384;
+  task.NumberOfChunks = static_cast<int>(std::max(size_t(1), std::min(
+    static_cast<size_t>(std::max(this->NumberOfThreads, 1)), numberOfPoints / minimumPointsPerChunk)));
+  task.ChunkBegin.resize(task.NumberOfChunks + 1);
+  task.ValidCount.resize(task.NumberOfChunks);
+
+  if (task.Text) {
+    // Split the text at line ends, then count the lines of each chunk to
+    // know where its points go.
+    task.TextBegin.resize(task.NumberOfChunks + 1);
+    for (int i = 0; i < task.NumberOfChunks; ++i) {
+      size_t begin = dataOffset + (size - dataOffset) * i / task.NumberOfChunks;
+      while (i && begin < size && task.Text[begin - 1] != '\n') {
+        ++begin;
+      }
+      task.TextBegin[i] = begin;
+    }
+    task.TextBegin[task.NumberOfChunks] = size;
+
+    task.CurrentPass = vesDecodeTask::CountLines;
+    this->runTask(task);
+
+    task.ChunkBegin[0] = 0;
+    for (int i = 0; i < task.NumberOfChunks; ++i) {
+      task.ChunkBegin[i + 1] = std::min(task.ChunkBegin[i] + task.ValidCount[i], numberOfPoints);
+    }
+  }
+  else {
+    for (int i = 0; i <= task.NumberOfChunks; ++i) {
+      task.ChunkBegin[i] = numberOfPoints * i / task.NumberOfChunks;
+    }
+  }
+  task.CurrentPass = vesDecodeTask::Decode;
+
+  vesSourceData::Ptr sourceData;
+  if (task.HasColors) {
+    vesSourceDataP3C4ub::Ptr points(new vesSourceDataP3C4ub());
+    points->arrayReference().resize(numberOfPoints);
+    task.Output = numberOfPoints ? &points->arrayReference()[0] : 0;
+    this->runTask(task);
+    points->arrayReference().resize(task.compact<vesVertexDataP3C4ub>());
+    sourceData = points;
+  }
+  else {
+    vesSourceDataP3f::Ptr points(new vesSourceDataP3f());
+    points->arrayReference().resize(numberOfPoints);
+    task.Output = numberOfPoints ? &points->arrayReference()[0] : 0;
+    this->runTask(task);
+    points->arrayReference().resize(task.compact<vesVertexDataP3f>());
+    sourceData = points;
+  }
+  this->NumberOfPoints = sourceData->sizeOfArray();
+  this->HasColors = task.HasColors;
+
+  this->GeometryData = vesGeometryData::Ptr(new vesGeometryData());
+  this->GeometryData->addSource(sourceData);
+  this->GeometryData->setName("PointCloud");
+
+  vesPrimitive::Ptr pointPrimitive(new vesPrimitive());
+  pointPrimitive->setPrimitiveType(vesPrimitiveRenderType::Points);
+  pointPrimitive->setIndexCount(1);
+  this->GeometryData->addPrimitive(pointPrimitive);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPCDReader::vesKiwiPCDReader()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPCDReader::~vesKiwiPCDReader()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPCDReader::setNumberOfThreads(int numberOfThreads)
+{
+  this->Internal->NumberOfThreads = numberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPCDReader::numberOfThreads() const
+{
+  return this->Internal->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPCDReader::read(const std::string& filename)
+{
+  this->Internal->reset();
+  this->Internal->ErrorMessage.clear();
+
+  vesMappedFile file;
+  if (!file.open(filename)) {
+    return this->Internal->fail("Could not open " + filename);
+  }
+
+  size_t dataOffset = 0;
+  if (!this->Internal->parseHeader(file.Data, file.Size, dataOffset)) {
+    return false;
+  }
+  return this->Internal->decode(file.Data, file.Size, dataOffset);
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiPCDReader::errorMessage() const
+{
+  return this->Internal->ErrorMessage;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesGeometryData> vesKiwiPCDReader::geometryData() const
+{
+  return this->Internal->GeometryData;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPCDReader::numberOfPoints() const
+{
+  return this->Internal->NumberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPCDReader::hasColors() const
+{
+  return this->Internal->HasColors;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPCDReader::DataEncoding vesKiwiPCDReader::dataEncoding() const
+{
+  return this->Internal->Encoding;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPCDReader::width() const
+{
+  return this->Internal->Width;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPCDReader::height() const
+{
+  return this->Internal->Height;
+}
+
+//----------------------------------------------------------------------------
+vesMatrix4x4f vesKiwiPCDReader::viewpoint() const
+{
+  return this->Internal->Viewpoint;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPCDReader::performBenchmark(const std::string& filename)
+{
+  double start;
+  double elapsed;
+
+  vesKiwiPCDReader reader;
+  start = vtkTimerLog::GetUniversalTime();
+  if (!reader.read(filename)) {
+    std::cout << reader.errorMessage() << std::endl;
+    return;
+  }
+  elapsed = vtkTimerLog::GetUniversalTime() - start;
+
+  const unsigned int numberOfPoints = reader.numberOfPoints();
+  std::cout << "Number of points: " << numberOfPoints << std::endl;
+  std::cout << "vesKiwiPCDReader took " << elapsed << " seconds with "
+            << reader.numberOfThreads() << " threads. "
+            << numberOfPoints / elapsed << " points per second." << std::endl;
+
+#ifdef VES_USE_PCL
+  start = vtkTimerLog::GetUniversalTime();
+  vtkSmartPointer<vtkPolyData> polyData = vtkPCLConversions::PolyDataFromPCDFile(filename);
+  elapsed = vtkTimerLog::GetUniversalTime() - start;
+  if (!polyData) {
+    return;
+  }
+
+  std::cout << "vtkPCLConversions::PolyDataFromPCDFile took " << elapsed << " seconds. "
+            << numberOfPoints / elapsed << " points per second." << std::endl;
+
+  start = vtkTimerLog::GetUniversalTime();
+  vesGeometryData::Ptr geometryData = vesKiwiDataConversionTools::ConvertPoints(polyData);
+  vtkUnsignedCharArray* colors = vesKiwiDataConversionTools::FindRGBColorsArray(polyData);
+  if (colors) {
+    geometryData->addSource(vesKiwiDataConversionTools::ConvertColors(colors));
+  }
+  elapsed = vtkTimerLog::GetUniversalTime() - start;
+
+  std::cout << "Conversion to vesGeometryData took " << elapsed << " seconds. "
+            << numberOfPoints / elapsed << " points per second." << std::endl;
+
+  vtkPCLConversions::PerformPointCloudConversionBenchmark(polyData);
+#endif
+}
@@ -0,0 +1,93 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiPCDReader
+/// \ingroup KiwiPlatform
+/// \brief Reads PCL point cloud (.pcd) files directly into vesGeometryData.
+///
+/// The ascii, binary and binary_compressed encodings are supported, without
+/// depending on PCL.  The file is memory mapped and the points are decoded in
+/// parallel chunks straight into an interleaved vertex array: a
+/// vesSourceDataP3C4ub when the file has an rgb or rgba field, otherwise a
+/// vesSourceDataP3f.  Points with a non finite coordinate are dropped, like
+/// vtkPCLConversions::PolyDataFromPointCloud() does.
+#ifndef __vesKiwiPCDReader_h
+#define __vesKiwiPCDReader_h
+
+#include "vesSetGet.h"
+#include "vesMath.h"
+
+#include <string>
+
+class vesGeometryData;
+
+class vesKiwiPCDReader
+{
+public:
+
+  vesTypeMacro(vesKiwiPCDReader);
+
+  enum DataEncoding
+  {
+    Ascii,
+    Binary,
+    BinaryCompressed
+  };
+
+  vesKiwiPCDReader();
+  ~vesKiwiPCDReader();
+
+  /// Set/Get the number of threads used to decode the points.  The default is
+  /// the VTK global default number of threads, which is the number of cores.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+
+  bool read(const std::string& filename);
+  std::string errorMessage() const;
+
+  /// Results of the last successful read().  The geometry data holds a
+  /// single points primitive.
+  vesSharedPtr<vesGeometryData> geometryData() const;
+  unsigned int numberOfPoints() const;
+  bool hasColors() const;
+  DataEncoding dataEncoding() const;
+
+  /// Width and height of the cloud as stored in the header.  An organized
+  /// cloud has a height greater than one.
+  unsigned int width() const;
+  unsigned int height() const;
+
+  /// The sensor pose from the VIEWPOINT header field.
+  vesMatrix4x4f viewpoint() const;
+
+  /// Print how long reading \p filename takes with this reader, and with
+  /// vtkPCLConversions followed by the polydata to geometry conversion when
+  /// kiwi is built with PCL.
+  static void performBenchmark(const std::string& filename);
+
+private:
+
+  vesKiwiPCDReader(const vesKiwiPCDReader&); // Not implemented
+  void operator=(const vesKiwiPCDReader&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -212,7 +212,7 @@ bool SendCameraState(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal)
 }
 
 //----------------------------------------------------------------------------
-bool ReceiveSceneMetaData(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal, std::stringstream& resp)
+bool ReceiveSceneMetaData(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal, std::string& resp)
 {
   if (!SendCommand(selfInternal, 2)) {
     return false;
@@ -223,15 +223,12 @@ bool ReceiveSceneMetaData(vesKiwiPVRemoteRepresentation::vesInternal* selfIntern
     return false;
   }
 
-  vtkCharArray* streamData = vtkCharArray::New();
-  streamData->SetNumberOfTuples(streamLength);
-
-  if (selfInternal->Comm->Receive(streamData->GetPointer(0), streamLength) == 0) {
+  // receive straight into the buffer that is parsed
+  resp.resize(streamLength);
+  if (streamLength && selfInternal->Comm->Receive(&resp[0], streamLength) == 0) {
     return false;
   }
 
-  resp << std::string(streamData->GetPointer(0), streamLength);
-
   return (selfInternal->ShouldQuit != true);
 }
 
@@ -280,11 +277,11 @@ void ChooseDataSetsToRemove(vesKiwiPVRemoteRepresentation::vesInternal* selfInte
 }
 
 //----------------------------------------------------------------------------
-bool ReceiveScene(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal, const std::stringstream& resp)
+bool ReceiveScene(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal, const std::string& resp)
 {
   vesPVWebClient client;
 
-  bool success = client.parseSceneMetaData(resp);
+  bool success = client.parseSceneMetaData(resp.c_str(), resp.size());
   if (!success) {
     return false;
   }
@@ -391,7 +388,7 @@ bool ReceiveScene(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal, cons
 //----------------------------------------------------------------------------
 bool RequestScene(vesKiwiPVRemoteRepresentation::vesInternal* selfInternal)
 {
-  std::stringstream resp;
+  std::string resp;
   if (!ReceiveSceneMetaData(selfInternal, resp)) {
     return false;
   }
@@ -0,0 +1,286 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiParallelDataLoader.h"
+
+#include "vesGeometryData.h"
+#include "vesKiwiDataLoader.h"
+#include "vesKiwiPolyDataRepresentation.h"
+
+#include <vtkConditionVariable.h>
+#include <vtkDataSet.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkPolyData.h>
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+//----------------------------------------------------------------------------
+class vesKiwiParallelDataLoader::vesInternal
+{
+public:
+
+  struct Task
+  {
+    Task() : IsDone(false)
+    {
+    }
+
+    std::string Filename;
+    bool IsDone;
+
+    vtkSmartPointer<vtkDataSet> DataSet;
+    vtkSmartPointer<vtkPolyData> PolyData;
+    vesGeometryData::Ptr GeometryData;
+
+    std::string ErrorTitle;
+    std::string ErrorMessage;
+  };
+
+  vesInternal()
+  {
+    this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    this->IsStarted = false;
+    this->ShouldQuit = false;
+    this->NextTask = 0;
+  }
+
+  ~vesInternal()
+  {
+  }
+
+  void runTask(Task& task)
+  {
+    vesKiwiDataLoader loader;
+    loader.copySettings(this->Settings);
+
+    task.DataSet = loader.loadDataset(task.Filename);
+    if (!task.DataSet) {
+      task.ErrorTitle = loader.errorTitle();
+      task.ErrorMessage = loader.errorMessage();
+      return;
+    }
+
+    vtkPolyData* polyData = vtkPolyData::SafeDownCast(task.DataSet);
+    if (polyData) {
+      task.GeometryData = vesKiwiPolyDataRepresentation::PreparePolyData(polyData, task.PolyData);
+    }
+  }
+
+  int NumberOfThreads;
+  vesKiwiDataLoader Settings;
+  bool IsStarted;
+  bool ShouldQuit;
+  size_t NextTask;
+
+  std::vector<Task> Tasks;
+  std::vector<int> ThreadIds;
+
+  vtkNew<vtkMultiThreader> MultiThreader;
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> TaskDone;
+};
+
+namespace {
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE WorkerLoop(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+
+  vesKiwiParallelDataLoader::vesInternal* selfInternal =
+    static_cast<vesKiwiParallelDataLoader::vesInternal*>(threadInfo->UserData);
+
+  while (true) {
+
+    selfInternal->Lock->Lock();
+    if (selfInternal->ShouldQuit || selfInternal->NextTask >= selfInternal->Tasks.size()) {
+      selfInternal->Lock->Unlock();
+      break;
+    }
+    vesKiwiParallelDataLoader::vesInternal::Task& task = selfInternal->Tasks[selfInternal->NextTask++];
+    selfInternal->Lock->Unlock();
+
+    // The task list does not change after start() so the reference stays
+    // valid, and no other thread touches this task until IsDone is set.
+    selfInternal->runTask(task);
+
+    selfInternal->Lock->Lock();
+    task.IsDone = true;
+    selfInternal->TaskDone->Broadcast();
+    selfInternal->Lock->Unlock();
+  }
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+vesKiwiParallelDataLoader::vesKiwiParallelDataLoader()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiParallelDataLoader::~vesKiwiParallelDataLoader()
+{
+  this->Internal->Lock->Lock();
+  this->Internal->ShouldQuit = true;
+  this->Internal->Lock->Unlock();
+  this->finish();
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiParallelDataLoader::setNumberOfThreads(int numberOfThreads)
+{
+  assert(!this->Internal->IsStarted);
+  this->Internal->NumberOfThreads = numberOfThreads > 0 ? numberOfThreads : 1;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiParallelDataLoader::numberOfThreads() const
+{
+  return this->Internal->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiParallelDataLoader::setErrorOnMoreThan65kVertices(bool isEnabled)
+{
+  assert(!this->Internal->IsStarted);
+  this->Internal->Settings.setErrorOnMoreThan65kVertices(isEnabled);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiParallelDataLoader::isErrorOnMoreThan65kVertices() const
+{
+  return this->Internal->Settings.isErrorOnMoreThan65kVertices();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiParallelDataLoader::copySettings(const vesKiwiDataLoader& loader)
+{
+  assert(!this->Internal->IsStarted);
+  this->Internal->Settings.copySettings(loader);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiParallelDataLoader::addFile(const std::string& filename)
+{
+  assert(!this->Internal->IsStarted);
+
+  vesInternal::Task task;
+  task.Filename = filename;
+  this->Internal->Tasks.push_back(task);
+  return static_cast<int>(this->Internal->Tasks.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiParallelDataLoader::numberOfTasks() const
+{
+  return static_cast<int>(this->Internal->Tasks.size());
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiParallelDataLoader::start()
+{
+  if (this->Internal->IsStarted) {
+    return;
+  }
+
+  this->Internal->IsStarted = true;
+
+  int numberOfThreads = std::min(this->Internal->NumberOfThreads,
+                                 static_cast<int>(this->Internal->Tasks.size()));
+  numberOfThreads = std::min(numberOfThreads, VTK_MAX_THREADS);
+
+  for (int i = 0; i < numberOfThreads; ++i) {
+    this->Internal->ThreadIds.push_back(
+      this->Internal->MultiThreader->SpawnThread(WorkerLoop, this->Internal));
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiParallelDataLoader::waitForTask(int taskIndex)
+{
+  assert(taskIndex >= 0 && taskIndex < this->numberOfTasks());
+
+  this->start();
+
+  vesInternal::Task& task = this->Internal->Tasks[taskIndex];
+
+  this->Internal->Lock->Lock();
+  while (!task.IsDone && !this->Internal->ShouldQuit) {
+    this->Internal->TaskDone->Wait(this->Internal->Lock.GetPointer());
+  }
+  bool isDone = task.IsDone;
+  this->Internal->Lock->Unlock();
+
+  return isDone && task.DataSet;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiParallelDataLoader::finish()
+{
+  for (size_t i = 0; i < this->Internal->ThreadIds.size(); ++i) {
+    this->Internal->MultiThreader->TerminateThread(this->Internal->ThreadIds[i]);
+  }
+  this->Internal->ThreadIds.clear();
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkDataSet> vesKiwiParallelDataLoader::dataset(int taskIndex) const
+{
+  return this->Internal->Tasks[taskIndex].DataSet;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkPolyData> vesKiwiParallelDataLoader::polyData(int taskIndex) const
+{
+  return this->Internal->Tasks[taskIndex].PolyData;
+}
+
+//----------------------------------------------------------------------------
+vesGeometryData::Ptr vesKiwiParallelDataLoader::geometryData(int taskIndex) const
+{
+  return this->Internal->Tasks[taskIndex].GeometryData;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiParallelDataLoader::filename(int taskIndex) const
+{
+  return this->Internal->Tasks[taskIndex].Filename;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiParallelDataLoader::errorTitle(int taskIndex) const
+{
+  return this->Internal->Tasks[taskIndex].ErrorTitle;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiParallelDataLoader::errorMessage(int taskIndex) const
+{
+  return this->Internal->Tasks[taskIndex].ErrorMessage;
+}
@@ -0,0 +1,102 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiParallelDataLoader
+/// \ingroup KiwiPlatform
+/// \brief Loads a list of independent files on a bounded pool of threads.
+///
+/// Each file is a task that is read with its own vesKiwiDataLoader and, for
+/// polydata, triangulated and converted to vesGeometryData on the worker
+/// thread.  Callers add all files, call start(), and then consume the results
+/// in the order the files were added by calling waitForTask() for each index.
+/// No GL calls are made by this class, so the results can be attached to a
+/// renderer on the main thread as they become ready.
+#ifndef __vesKiwiParallelDataLoader_h
+#define __vesKiwiParallelDataLoader_h
+
+#include "vesSetGet.h"
+
+#include <vtkSmartPointer.h>
+
+#include <string>
+
+class vesGeometryData;
+class vesKiwiDataLoader;
+class vtkDataSet;
+class vtkPolyData;
+
+class vesKiwiParallelDataLoader
+{
+public:
+
+  vesTypeMacro(vesKiwiParallelDataLoader);
+
+  vesKiwiParallelDataLoader();
+  ~vesKiwiParallelDataLoader();
+
+  /// Set/get the maximum number of worker threads.  The default is the VTK
+  /// global default number of threads, which is the number of cores.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+
+  /// Forwarded to the vesKiwiDataLoader used by each task.
+  void setErrorOnMoreThan65kVertices(bool isEnabled);
+  bool isErrorOnMoreThan65kVertices() const;
+
+  /// Copy the settings and memory files of \p loader to the vesKiwiDataLoader
+  /// used by each task.
+  void copySettings(const vesKiwiDataLoader& loader);
+
+  /// Add a file to load and return its task index.  Files can only be added
+  /// before start() is called.
+  int addFile(const std::string& filename);
+  int numberOfTasks() const;
+
+  /// Spawn the worker threads.  Returns immediately.
+  void start();
+
+  /// Block until the given task is finished.  Returns true if the task
+  /// produced a dataset.
+  bool waitForTask(int taskIndex);
+
+  /// Block until all tasks are finished and join the worker threads.
+  void finish();
+
+  /// Results of a finished task.  The geometry data is only set for polydata,
+  /// in which case polyData() returns the triangulated polydata that the
+  /// geometry data was converted from.
+  vtkSmartPointer<vtkDataSet> dataset(int taskIndex) const;
+  vtkSmartPointer<vtkPolyData> polyData(int taskIndex) const;
+  vesSharedPtr<vesGeometryData> geometryData(int taskIndex) const;
+  std::string filename(int taskIndex) const;
+  std::string errorTitle(int taskIndex) const;
+  std::string errorMessage(int taskIndex) const;
+
+  class vesInternal;
+
+private:
+
+  vesKiwiParallelDataLoader(const vesKiwiParallelDataLoader&); // Not implemented
+  void operator=(const vesKiwiParallelDataLoader&); // Not implemented
+
+  vesInternal* Internal;
+};
+
+
+#endif
@@ -0,0 +1,258 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiPointCloudOctree.h"
+
+#include <cstdio>
+#include <cstring>
+
+// Point clouds easily exceed 2 GB, use 64 bit file offsets.
+#if defined(_WIN32)
+# define vesFileSeek _fseeki64
+#else
+# define vesFileSeek fseeko
+#endif
+
+//----------------------------------------------------------------------------
+class vesKiwiPointCloudOctree::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->File = 0;
+    this->Flags = 0;
+    this->NumberOfPoints = 0;
+  }
+
+  ~vesInternal()
+  {
+    this->close();
+  }
+
+  void close()
+  {
+    if (this->File) {
+      fclose(this->File);
+      this->File = 0;
+    }
+    this->Nodes.clear();
+    this->Flags = 0;
+    this->NumberOfPoints = 0;
+  }
+
+  bool fail(const std::string& message)
+  {
+    this->ErrorMessage = message;
+    this->close();
+    return false;
+  }
+
+  FILE* File;
+  unsigned int Flags;
+  unsigned long long NumberOfPoints;
+  std::vector<Node> Nodes;
+  std::string ErrorMessage;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiPointCloudOctree::vesKiwiPointCloudOctree()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPointCloudOctree::~vesKiwiPointCloudOctree()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+const char* vesKiwiPointCloudOctree::fileMagic()
+{
+  return "VESPCOCT";
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPointCloudOctree::fileVersion()
+{
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPointCloudOctree::headerSize()
+{
+  // magic, version, flags, node count, reserved, point count, node table
+  // offset, root origin and size, padding
+  return 64;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPointCloudOctree::nodeRecordSize()
+{
+  // offset, point count, children, spacing
+  return 48;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctree::open(const std::string& filename)
+{
+  this->close();
+  this->Internal->ErrorMessage.clear();
+
+  this->Internal->File = fopen(filename.c_str(), "rb");
+  if (!this->Internal->File) {
+    return this->Internal->fail("Could not open " + filename);
+  }
+
+  unsigned char header[64];
+  if (fread(header, 1, headerSize(), this->Internal->File) != headerSize()
+      || memcmp(header, fileMagic(), 8) != 0) {
+    return this->Internal->fail(filename + " is not a point cloud octree file");
+  }
+
+  unsigned int version, numberOfNodes;
+  unsigned long long nodeTableOffset;
+  float origin[3], size;
+  memcpy(&version, header + 8, 4);
+  memcpy(&this->Internal->Flags, header + 12, 4);
+  memcpy(&numberOfNodes, header + 16, 4);
+  memcpy(&this->Internal->NumberOfPoints, header + 24, 8);
+  memcpy(&nodeTableOffset, header + 32, 8);
+  memcpy(origin, header + 40, 12);
+  memcpy(&size, header + 52, 4);
+
+  if (version != fileVersion()) {
+    return this->Internal->fail(filename + " has an unsupported version");
+  }
+
+  std::vector<unsigned char> table(static_cast<size_t>(numberOfNodes) * nodeRecordSize());
+  if (!numberOfNodes
+      || vesFileSeek(this->Internal->File, nodeTableOffset, SEEK_SET) != 0
+      || fread(&table[0], 1, table.size(), this->Internal->File) != table.size()) {
+    return this->Internal->fail("Could not read the node table of " + filename);
+  }
+
+  this->Internal->Nodes.resize(numberOfNodes);
+  for (unsigned int i = 0; i < numberOfNodes; ++i) {
+    const unsigned char* record = &table[static_cast<size_t>(i) * nodeRecordSize()];
+    Node& node = this->Internal->Nodes[i];
+    memcpy(&node.Offset, record, 8);
+    memcpy(&node.NumberOfPoints, record + 8, 4);
+    memcpy(node.Children, record + 12, 32);
+    memcpy(&node.Spacing, record + 44, 4);
+    node.Parent = -1;
+  }
+
+  // Nodes are stored breadth first, so parents come before their children
+  // and the cubes can be derived from the root cube.
+  Node& root = this->Internal->Nodes[0];
+  root.Level = 0;
+  root.Origin = vesVector3f(origin[0], origin[1], origin[2]);
+  root.Size = size;
+  for (unsigned int i = 0; i < numberOfNodes; ++i) {
+    const Node& node = this->Internal->Nodes[i];
+    for (int j = 0; j < 8; ++j) {
+      const int childIndex = node.Children[j];
+      if (childIndex < 0) {
+        continue;
+      }
+      if (childIndex <= static_cast<int>(i) || childIndex >= static_cast<int>(numberOfNodes)) {
+        return this->Internal->fail("Corrupt node table in " + filename);
+      }
+
+      Node& child = this->Internal->Nodes[childIndex];
+      child.Parent = i;
+      child.Level = node.Level + 1;
+      child.Size = 0.5f * node.Size;
+      child.Origin = node.Origin + child.Size * vesVector3f(
+        static_cast<float>(j & 1), static_cast<float>((j >> 1) & 1), static_cast<float>((j >> 2) & 1));
+    }
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudOctree::close()
+{
+  this->Internal->close();
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctree::isOpen() const
+{
+  return this->Internal->File != 0;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudOctree::numberOfNodes() const
+{
+  return static_cast<int>(this->Internal->Nodes.size());
+}
+
+//----------------------------------------------------------------------------
+const vesKiwiPointCloudOctree::Node& vesKiwiPointCloudOctree::node(int index) const
+{
+  return this->Internal->Nodes[index];
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vesKiwiPointCloudOctree::numberOfPoints() const
+{
+  return this->Internal->NumberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctree::hasColors() const
+{
+  return (this->Internal->Flags & HasColors) != 0;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctree::readNode(int index, std::vector<float>& points,
+                                       std::vector<unsigned char>& colors)
+{
+  if (!this->isOpen() || index < 0 || index >= this->numberOfNodes()) {
+    return false;
+  }
+
+  const Node& node = this->Internal->Nodes[index];
+  points.resize(3 * static_cast<size_t>(node.NumberOfPoints));
+  colors.resize(this->hasColors() ? points.size() : 0);
+  if (!node.NumberOfPoints) {
+    return true;
+  }
+
+  FILE* file = this->Internal->File;
+  if (vesFileSeek(file, node.Offset, SEEK_SET) != 0
+      || fread(&points[0], sizeof(float), points.size(), file) != points.size()
+      || (!colors.empty() && fread(&colors[0], 1, colors.size(), file) != colors.size())) {
+    this->Internal->ErrorMessage = "Could not read the points of a node";
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiPointCloudOctree::errorMessage() const
+{
+  return this->Internal->ErrorMessage;
+}
@@ -0,0 +1,108 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiPointCloudOctree
+/// \ingroup KiwiPlatform
+/// \brief Reads the node hierarchy and the point chunks of a paged point cloud.
+///
+/// A point cloud octree file (.vpc) is written by
+/// vesKiwiPointCloudOctreeBuilder.  Every node of the octree stores a chunk of
+/// points that covers its cube evenly, with a spacing that halves at each
+/// level, so drawing a node together with some of its descendants refines the
+/// cloud where it matters.  open() only reads the small node table; the points
+/// of a node are read on demand with readNode().
+///
+/// The file starts with a fixed size header, followed by the point chunks and
+/// the node table, in native byte order.  Nodes are stored breadth first with
+/// the root first.
+#ifndef __vesKiwiPointCloudOctree_h
+#define __vesKiwiPointCloudOctree_h
+
+#include "vesSetGet.h"
+#include "vesMath.h"
+
+#include <string>
+#include <vector>
+
+class vesKiwiPointCloudOctree
+{
+public:
+
+  vesTypeMacro(vesKiwiPointCloudOctree);
+
+  struct Node
+  {
+    unsigned long long Offset;
+    unsigned int NumberOfPoints;
+    int Children[8];
+    int Parent;
+    int Level;
+
+    /// Minimum corner and edge length of the cube of the node.  Child i
+    /// covers the octant with bit 0, 1 and 2 of i selecting the upper half
+    /// in x, y and z.
+    vesVector3f Origin;
+    float Size;
+
+    /// Typical distance between neighbouring points of the node.
+    float Spacing;
+  };
+
+  vesKiwiPointCloudOctree();
+  ~vesKiwiPointCloudOctree();
+
+  bool open(const std::string& filename);
+  void close();
+  bool isOpen() const;
+
+  int numberOfNodes() const;
+  const Node& node(int index) const;
+
+  unsigned long long numberOfPoints() const;
+  bool hasColors() const;
+
+  /// Read the points of a node as xyz triples and, if the file has colors,
+  /// rgb triples.  Reads are not synchronized, call it from one thread at a
+  /// time.
+  bool readNode(int index, std::vector<float>& points,
+                std::vector<unsigned char>& colors);
+
+  std::string errorMessage() const;
+
+  /// Format constants shared with vesKiwiPointCloudOctreeBuilder.
+  static const char* fileMagic();
+  static unsigned int fileVersion();
+  static unsigned int headerSize();
+  static unsigned int nodeRecordSize();
+
+  enum
+  {
+    HasColors = 1
+  };
+
+private:
+
+  vesKiwiPointCloudOctree(const vesKiwiPointCloudOctree&); // Not implemented
+  void operator=(const vesKiwiPointCloudOctree&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,556 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiPointCloudOctreeBuilder.h"
+#include "vesKiwiPointCloudOctree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+# define vesFileSeek _fseeki64
+#else
+# define vesFileSeek fseeko
+#endif
+
+namespace {
+
+// Partition cells are the nodes of this level, 8^3 of them.
+const int PartitionLevel = 3;
+const int NumberOfPartitions = 512;
+
+// Points buffered per partition cell before they are appended to its file.
+const size_t PartitionBufferSize = 8192;
+
+// Nodes this deep keep all their points, e.g. for duplicated points.
+const int MaximumLevel = 24;
+
+struct PointRecord
+{
+  float Position[3];
+  unsigned char Color[3];
+  unsigned char Padding;
+};
+
+struct BuildNode
+{
+  unsigned long long Offset;
+  unsigned int NumberOfPoints;
+  int Children[8];
+  float Spacing;
+};
+
+int cellCoordinate(float value, float origin, float size, int resolution)
+{
+  const int coordinate = static_cast<int>((value - origin) / size * resolution);
+  return std::min(std::max(coordinate, 0), resolution - 1);
+}
+
+// Append about \p count points of \p points, evenly strided, to \p sample.
+void appendSample(const std::vector<PointRecord>& points, size_t count,
+                  std::vector<PointRecord>& sample)
+{
+  const double stride = std::max(1.0, static_cast<double>(points.size()) / count);
+  for (double i = 0.0; i < points.size(); i += stride) {
+    sample.push_back(points[static_cast<size_t>(i)]);
+  }
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiPointCloudOctreeBuilder::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->HasBounds = false;
+    this->Size = 0.0f;
+    this->MaximumPointsPerNode = 20000;
+    this->TemporaryDirectory = ".";
+    this->HasColors = -1;
+    this->NumberOfPoints = 0;
+    this->Output = 0;
+    this->Position = 0;
+    this->Buffers.resize(NumberOfPartitions);
+    this->PartitionSizes.resize(NumberOfPartitions, 0);
+  }
+
+  ~vesInternal()
+  {
+    this->removePartitionFiles();
+    if (this->Output) {
+      fclose(this->Output);
+    }
+  }
+
+  std::string partitionFileName(int partition) const
+  {
+    std::ostringstream name;
+    name << this->TemporaryDirectory << "/vesPointCloud-" << this << "-" << partition << ".tmp";
+    return name.str();
+  }
+
+  void removePartitionFiles()
+  {
+    for (int i = 0; i < NumberOfPartitions; ++i) {
+      if (this->PartitionSizes[i]) {
+        remove(this->partitionFileName(i).c_str());
+        this->PartitionSizes[i] = 0;
+      }
+    }
+  }
+
+  bool fail(const std::string& message)
+  {
+    this->ErrorMessage = message;
+    return false;
+  }
+
+  bool flushPartition(int partition);
+  bool readPartition(int partition, std::vector<PointRecord>& points);
+  int writeNode(const std::vector<PointRecord>& points, float spacing);
+  int buildSubtree(std::vector<PointRecord>& points, const vesVector3f& origin,
+                   float size, int level);
+  bool writeNodeTable();
+
+  bool HasBounds;
+  vesVector3f Origin;
+  float Size;
+  int MaximumPointsPerNode;
+  std::string TemporaryDirectory;
+  int HasColors;
+  unsigned long long NumberOfPoints;
+
+  std::vector<std::vector<PointRecord> > Buffers;
+  std::vector<unsigned long long> PartitionSizes;
+
+  FILE* Output;
+  unsigned long long Position;
+  std::vector<BuildNode> Nodes;
+  std::string ErrorMessage;
+};
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctreeBuilder::vesInternal::flushPartition(int partition)
+{
+  std::vector<PointRecord>& buffer = this->Buffers[partition];
+  if (buffer.empty()) {
+    return true;
+  }
+
+  FILE* file = fopen(this->partitionFileName(partition).c_str(), "ab");
+  const bool success = file
+    && fwrite(&buffer[0], sizeof(PointRecord), buffer.size(), file) == buffer.size();
+  if (file) {
+    fclose(file);
+  }
+  if (!success) {
+    return this->fail("Could not write to " + this->partitionFileName(partition));
+  }
+
+  this->PartitionSizes[partition] += buffer.size();
+  buffer.clear();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctreeBuilder::vesInternal::readPartition(
+  int partition, std::vector<PointRecord>& points)
+{
+  points.clear();
+  if (!this->flushPartition(partition)) {
+    return false;
+  }
+  if (!this->PartitionSizes[partition]) {
+    return true;
+  }
+
+  const std::string fileName = this->partitionFileName(partition);
+  points.resize(static_cast<size_t>(this->PartitionSizes[partition]));
+  FILE* file = fopen(fileName.c_str(), "rb");
+  const bool success = file
+    && fread(&points[0], sizeof(PointRecord), points.size(), file) == points.size();
+  if (file) {
+    fclose(file);
+  }
+  remove(fileName.c_str());
+  this->PartitionSizes[partition] = 0;
+
+  return success ? true : this->fail("Could not read " + fileName);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudOctreeBuilder::vesInternal::writeNode(
+  const std::vector<PointRecord>& points, float spacing)
+{
+  BuildNode node;
+  node.Offset = this->Position;
+  node.NumberOfPoints = static_cast<unsigned int>(points.size());
+  std::fill(node.Children, node.Children + 8, -1);
+  node.Spacing = spacing;
+
+  // Positions and colors are stored as separate arrays, ready to upload.
+  std::vector<float> positions(3 * points.size());
+  std::vector<unsigned char> colors(this->HasColors == 1 ? positions.size() : 0);
+  for (size_t i = 0; i < points.size(); ++i) {
+    memcpy(&positions[3 * i], points[i].Position, sizeof(points[i].Position));
+    if (!colors.empty()) {
+      memcpy(&colors[3 * i], points[i].Color, sizeof(points[i].Color));
+    }
+  }
+
+  if (!positions.empty()) {
+    if (fwrite(&positions[0], sizeof(float), positions.size(), this->Output) != positions.size()
+        || (!colors.empty()
+            && fwrite(&colors[0], 1, colors.size(), this->Output) != colors.size())) {
+      this->fail("Could not write the point cloud octree");
+      return -1;
+    }
+    this->Position += positions.size() * sizeof(float) + colors.size();
+  }
+
+  this->Nodes.push_back(node);
+  return static_cast<int>(this->Nodes.size() - 1);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudOctreeBuilder::vesInternal::buildSubtree(
+  std::vector<PointRecord>& points, const vesVector3f& origin, float size, int level)
+{
+  if (points.size() <= static_cast<size_t>(this->MaximumPointsPerNode)
+      || level >= MaximumLevel) {
+    const float spacing = size / std::max(1.0f, std::pow(static_cast<float>(points.size()), 1.0f / 3.0f));
+    return this->writeNode(points, spacing);
+  }
+
+  // Keep the first point of every cell of a grid with about as many cells
+  // as a node may hold points, so that the node covers its cube evenly.
+  const int resolution = std::max(2, static_cast<int>(
+    std::pow(static_cast<float>(this->MaximumPointsPerNode), 1.0f / 3.0f)));
+  std::vector<char> isOccupied(resolution * resolution * resolution, 0);
+  std::vector<PointRecord> kept;
+  std::vector<PointRecord> children[8];
+  const float halfSize = 0.5f * size;
+
+  for (size_t i = 0; i < points.size(); ++i) {
+    const float* position = points[i].Position;
+    const int cell = cellCoordinate(position[0], origin[0], size, resolution)
+      + resolution * (cellCoordinate(position[1], origin[1], size, resolution)
+      + resolution * cellCoordinate(position[2], origin[2], size, resolution));
+    if (!isOccupied[cell]) {
+      isOccupied[cell] = 1;
+      kept.push_back(points[i]);
+      continue;
+    }
+
+    const int octant = (position[0] >= origin[0] + halfSize ? 1 : 0)
+      | (position[1] >= origin[1] + halfSize ? 2 : 0)
+      | (position[2] >= origin[2] + halfSize ? 4 : 0);
+    children[octant].push_back(points[i]);
+  }
+  std::vector<PointRecord>().swap(points);
+
+  const int index = this->writeNode(kept, size / resolution);
+  if (index < 0) {
+    return -1;
+  }
+  std::vector<PointRecord>().swap(kept);
+
+  for (int i = 0; i < 8; ++i) {
+    if (children[i].empty()) {
+      continue;
+    }
+    const vesVector3f childOrigin = origin + halfSize * vesVector3f(
+      static_cast<float>(i & 1), static_cast<float>((i >> 1) & 1), static_cast<float>((i >> 2) & 1));
+    const int child = this->buildSubtree(children[i], childOrigin, halfSize, level + 1);
+    if (child < 0) {
+      return -1;
+    }
+    this->Nodes[index].Children[i] = child;
+  }
+  return index;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctreeBuilder::vesInternal::writeNodeTable()
+{
+  // Number the nodes breadth first from the root, which is written last.
+  const int root = static_cast<int>(this->Nodes.size() - 1);
+  std::vector<int> order;
+  std::vector<int> newIndices(this->Nodes.size(), -1);
+  std::deque<int> queue(1, root);
+  while (!queue.empty()) {
+    const int index = queue.front();
+    queue.pop_front();
+    newIndices[index] = static_cast<int>(order.size());
+    order.push_back(index);
+    for (int i = 0; i < 8; ++i) {
+      if (this->Nodes[index].Children[i] >= 0) {
+        queue.push_back(this->Nodes[index].Children[i]);
+      }
+    }
+  }
+
+  const unsigned long long tableOffset = this->Position;
+  std::vector<unsigned char> record(vesKiwiPointCloudOctree::nodeRecordSize(), 0);
+  for (size_t i = 0; i < order.size(); ++i) {
+    const BuildNode& node = this->Nodes[order[i]];
+    int children[8];
+    for (int j = 0; j < 8; ++j) {
+      children[j] = node.Children[j] >= 0 ? newIndices[node.Children[j]] : -1;
+    }
+    memcpy(&record[0], &node.Offset, 8);
+    memcpy(&record[8], &node.NumberOfPoints, 4);
+    memcpy(&record[12], children, 32);
+    memcpy(&record[44], &node.Spacing, 4);
+    if (fwrite(&record[0], 1, record.size(), this->Output) != record.size()) {
+      return this->fail("Could not write the point cloud octree");
+    }
+  }
+
+  unsigned char header[64];
+  memset(header, 0, sizeof(header));
+  const unsigned int version = vesKiwiPointCloudOctree::fileVersion();
+  const unsigned int flags = this->HasColors == 1 ? vesKiwiPointCloudOctree::HasColors : 0;
+  const unsigned int numberOfNodes = static_cast<unsigned int>(order.size());
+  memcpy(header, vesKiwiPointCloudOctree::fileMagic(), 8);
+  memcpy(header + 8, &version, 4);
+  memcpy(header + 12, &flags, 4);
+  memcpy(header + 16, &numberOfNodes, 4);
+  memcpy(header + 24, &this->NumberOfPoints, 8);
+  memcpy(header + 32, &tableOffset, 8);
+  memcpy(header + 40, this->Origin.data(), 12);
+  memcpy(header + 52, &this->Size, 4);
+
+  if (vesFileSeek(this->Output, 0, SEEK_SET) != 0
+      || fwrite(header, 1, vesKiwiPointCloudOctree::headerSize(), this->Output)
+         != vesKiwiPointCloudOctree::headerSize()) {
+    return this->fail("Could not write the point cloud octree");
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPointCloudOctreeBuilder::vesKiwiPointCloudOctreeBuilder()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPointCloudOctreeBuilder::~vesKiwiPointCloudOctreeBuilder()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudOctreeBuilder::setBounds(const vesVector3f& minimum,
+                                               const vesVector3f& maximum)
+{
+  // The octree subdivides a cube, slightly enlarged so that the maximum
+  // falls inside.
+  const float size = (maximum - minimum).maxCoeff();
+  this->Internal->Size = size > 0.0f ? 1.0001f * size : 1.0f;
+  this->Internal->Origin = minimum;
+  this->Internal->HasBounds = true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudOctreeBuilder::setMaximumPointsPerNode(int numberOfPoints)
+{
+  this->Internal->MaximumPointsPerNode = std::max(8, numberOfPoints);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudOctreeBuilder::maximumPointsPerNode() const
+{
+  return this->Internal->MaximumPointsPerNode;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudOctreeBuilder::setTemporaryDirectory(const std::string& directory)
+{
+  this->Internal->TemporaryDirectory = directory;
+}
+
+//----------------------------------------------------------------------------
+const std::string& vesKiwiPointCloudOctreeBuilder::temporaryDirectory() const
+{
+  return this->Internal->TemporaryDirectory;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctreeBuilder::addPoints(const float* points,
+  const unsigned char* colors, size_t numberOfPoints)
+{
+  if (!this->Internal->HasBounds) {
+    return this->Internal->fail("setBounds() must be called before addPoints()");
+  }
+  if (this->Internal->HasColors < 0) {
+    this->Internal->HasColors = colors ? 1 : 0;
+  }
+  else if (this->Internal->HasColors != (colors ? 1 : 0)) {
+    return this->Internal->fail("Either all or no points must have colors");
+  }
+
+  const vesVector3f& origin = this->Internal->Origin;
+  const float size = this->Internal->Size;
+  const int resolution = 1 << PartitionLevel;
+
+  for (size_t i = 0; i < numberOfPoints; ++i) {
+    PointRecord record;
+    memcpy(record.Position, points + 3 * i, sizeof(record.Position));
+    if (colors) {
+      memcpy(record.Color, colors + 3 * i, sizeof(record.Color));
+    }
+    else {
+      memset(record.Color, 0, sizeof(record.Color));
+    }
+    record.Padding = 0;
+
+    // Partitions are numbered by their path from the root, matching the
+    // child order of the octree nodes.
+    int coordinates[3];
+    for (int k = 0; k < 3; ++k) {
+      coordinates[k] = cellCoordinate(record.Position[k], origin[k], size, resolution);
+    }
+    int partition = 0;
+    for (int level = PartitionLevel - 1; level >= 0; --level) {
+      partition = 8 * partition + ((coordinates[0] >> level) & 1)
+        + 2 * ((coordinates[1] >> level) & 1) + 4 * ((coordinates[2] >> level) & 1);
+    }
+
+    std::vector<PointRecord>& buffer = this->Internal->Buffers[partition];
+    buffer.push_back(record);
+    if (buffer.size() >= PartitionBufferSize && !this->Internal->flushPartition(partition)) {
+      return false;
+    }
+  }
+
+  this->Internal->NumberOfPoints += numberOfPoints;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+unsigned long long vesKiwiPointCloudOctreeBuilder::numberOfPoints() const
+{
+  return this->Internal->NumberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudOctreeBuilder::write(const std::string& filename)
+{
+  vesInternal* internal = this->Internal;
+  if (!internal->NumberOfPoints) {
+    return internal->fail("No points to write");
+  }
+
+  internal->Output = fopen(filename.c_str(), "wb");
+  if (!internal->Output) {
+    return internal->fail("Could not open " + filename + " for writing");
+  }
+
+  // Reserve the header, it is written once the node table is known.
+  unsigned char header[64];
+  memset(header, 0, sizeof(header));
+  fwrite(header, 1, vesKiwiPointCloudOctree::headerSize(), internal->Output);
+  internal->Position = vesKiwiPointCloudOctree::headerSize();
+  internal->Nodes.clear();
+
+  // Nodes above the partition cells are indexed by their path from the
+  // root.  Each node passes an eighth of its maximum up to its parent, so
+  // the parent ends up with about as many points as a node may hold.
+  std::vector<std::vector<PointRecord> > samples[PartitionLevel];
+  std::vector<int> nodes[PartitionLevel + 1];
+  for (int level = 0; level <= PartitionLevel; ++level) {
+    nodes[level].resize(1 << (3 * level), -1);
+    if (level < PartitionLevel) {
+      samples[level].resize(1 << (3 * level));
+    }
+  }
+  const size_t sampleSize = internal->MaximumPointsPerNode / 8;
+
+  bool success = true;
+  std::vector<PointRecord> points;
+  const float partitionSize = internal->Size / (1 << PartitionLevel);
+  for (int partition = 0; partition < NumberOfPartitions && success; ++partition) {
+    success = internal->readPartition(partition, points);
+    if (!success || points.empty()) {
+      continue;
+    }
+
+    vesVector3f origin = internal->Origin;
+    for (int level = 0; level < PartitionLevel; ++level) {
+      const int octant = (partition >> (3 * (PartitionLevel - 1 - level))) & 7;
+      const float size = internal->Size / (2 << level);
+      origin += size * vesVector3f(static_cast<float>(octant & 1),
+        static_cast<float>((octant >> 1) & 1), static_cast<float>((octant >> 2) & 1));
+    }
+
+    appendSample(points, sampleSize, samples[PartitionLevel - 1][partition / 8]);
+    nodes[PartitionLevel][partition] =
+      internal->buildSubtree(points, origin, partitionSize, PartitionLevel);
+    success = nodes[PartitionLevel][partition] >= 0;
+  }
+
+  const float gridResolution = std::pow(static_cast<float>(internal->MaximumPointsPerNode), 1.0f / 3.0f);
+  for (int level = PartitionLevel - 1; level >= 0 && success; --level) {
+    for (size_t code = 0; code < samples[level].size() && success; ++code) {
+      if (samples[level][code].empty()) {
+        continue;
+      }
+
+      const float size = internal->Size / (1 << level);
+      const int index = internal->writeNode(samples[level][code], size / gridResolution);
+      success = index >= 0;
+      for (int i = 0; i < 8 && success; ++i) {
+        internal->Nodes[index].Children[i] = nodes[level + 1][8 * code + i];
+      }
+      nodes[level][code] = index;
+
+      if (level > 0) {
+        appendSample(samples[level][code], sampleSize, samples[level - 1][code / 8]);
+      }
+      std::vector<PointRecord>().swap(samples[level][code]);
+    }
+  }
+
+  success = success && internal->writeNodeTable();
+
+  fclose(internal->Output);
+  internal->Output = 0;
+  internal->removePartitionFiles();
+  if (!success) {
+    remove(filename.c_str());
+  }
+  return success;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiPointCloudOctreeBuilder::errorMessage() const
+{
+  return this->Internal->ErrorMessage;
+}
@@ -0,0 +1,86 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiPointCloudOctreeBuilder
+/// \ingroup KiwiPlatform
+/// \brief Writes a point cloud of any size into a paged octree file.
+///
+/// The builder is meant for offline conversion of clouds that do not fit in
+/// memory.  Points are added in batches and spilled to temporary files, one
+/// per cell of an 8x8x8 partition of the bounds.  write() then builds the
+/// octree of each cell in turn: a node keeps one point per cell of a coarse
+/// grid and hands the others down to its children, until a node holds at most
+/// maximumPointsPerNode() points.  The levels above the partition cells are
+/// built from samples of the cells.  Only one partition cell has to fit in
+/// memory at a time.
+///
+/// \see vesKiwiPointCloudOctree, vesKiwiPointCloudRepresentation
+#ifndef __vesKiwiPointCloudOctreeBuilder_h
+#define __vesKiwiPointCloudOctreeBuilder_h
+
+#include "vesSetGet.h"
+#include "vesMath.h"
+
+#include <string>
+
+class vesKiwiPointCloudOctreeBuilder
+{
+public:
+
+  vesTypeMacro(vesKiwiPointCloudOctreeBuilder);
+
+  vesKiwiPointCloudOctreeBuilder();
+  ~vesKiwiPointCloudOctreeBuilder();
+
+  /// Set the bounds of all points that will be added.  Must be called before
+  /// the first addPoints(); points outside are assigned to the nearest
+  /// partition cell.
+  void setBounds(const vesVector3f& minimum, const vesVector3f& maximum);
+
+  /// Set/Get the maximum number of points of a node, 20000 by default.
+  void setMaximumPointsPerNode(int numberOfPoints);
+  int maximumPointsPerNode() const;
+
+  /// Set/Get the directory of the temporary partition files, the current
+  /// directory by default.
+  void setTemporaryDirectory(const std::string& directory);
+  const std::string& temporaryDirectory() const;
+
+  /// Add points as xyz triples with optional rgb triples.  Either every call
+  /// passes colors or none does.
+  bool addPoints(const float* points, const unsigned char* colors, size_t numberOfPoints);
+
+  unsigned long long numberOfPoints() const;
+
+  /// Build the octree of all added points into \p filename and remove the
+  /// temporary files.
+  bool write(const std::string& filename);
+
+  std::string errorMessage() const;
+
+private:
+
+  vesKiwiPointCloudOctreeBuilder(const vesKiwiPointCloudOctreeBuilder&); // Not implemented
+  void operator=(const vesKiwiPointCloudOctreeBuilder&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,537 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiPointCloudRepresentation.h"
+#include "vesKiwiPointCloudOctree.h"
+
+#include "vesActor.h"
+#include "vesCamera.h"
+#include "vesDepth.h"
+#include "vesGeometryData.h"
+#include "vesMapper.h"
+#include "vesMaterial.h"
+#include "vesRenderer.h"
+#include "vesShaderProgram.h"
+
+#include <vtkConditionVariable.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <queue>
+#include <utility>
+#include <vector>
+
+namespace {
+
+//----------------------------------------------------------------------------
+vesGeometryData::Ptr createGeometry(const std::vector<float>& points,
+                                    const std::vector<unsigned char>& colors)
+{
+  vesGeometryData::Ptr geometry(new vesGeometryData());
+  const size_t numberOfPoints = points.size() / 3;
+
+  vesSourceDataP3f::Ptr positions(new vesSourceDataP3f());
+  positions->arrayReference().resize(numberOfPoints);
+  for (size_t i = 0; i < numberOfPoints; ++i) {
+    positions->arrayReference()[i].m_position =
+      vesVector3f(points[3 * i], points[3 * i + 1], points[3 * i + 2]);
+  }
+  geometry->addSource(positions);
+
+  if (!colors.empty()) {
+    vesSourceDataC3f::Ptr colorData(new vesSourceDataC3f());
+    colorData->arrayReference().resize(numberOfPoints);
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+      colorData->arrayReference()[i].m_color = vesVector3f(
+        colors[3 * i] / 255.0f, colors[3 * i + 1] / 255.0f, colors[3 * i + 2] / 255.0f);
+    }
+    geometry->addSource(colorData);
+  }
+
+  vesPrimitive::Ptr pointPrimitive(new vesPrimitive());
+  pointPrimitive->setPrimitiveType(vesPrimitiveRenderType::Points);
+  pointPrimitive->setIndexCount(1);
+  geometry->addPrimitive(pointPrimitive);
+  geometry->setName("PointCloudNode");
+  return geometry;
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiPointCloudRepresentation::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->PointBudget = 3000000;
+    this->MaximumScreenSpaceError = 2.0f;
+    this->PointSize = 2;
+    this->FrameNumber = 0;
+    this->NumberOfLoadedPoints = 0;
+    this->NumberOfVisibleNodes = 0;
+    this->NumberOfPendingNodes = 0;
+    this->ThreadId = -1;
+    this->ShouldQuit = false;
+    this->LoadingNode = -1;
+  }
+
+  ~vesInternal()
+  {
+    this->stopLoader();
+  }
+
+  struct LoadedNode
+  {
+    vesActor::Ptr Actor;
+    unsigned int NumberOfPoints;
+    unsigned long LastUsedFrame;
+  };
+
+  void stopLoader()
+  {
+    if (this->ThreadId < 0) {
+      return;
+    }
+    this->Lock->Lock();
+    this->ShouldQuit = true;
+    this->RequestAdded->Broadcast();
+    this->Lock->Unlock();
+    this->MultiThreader->TerminateThread(this->ThreadId);
+    this->ThreadId = -1;
+  }
+
+  void addNode(int index, vesGeometryData::Ptr geometry);
+  void releaseNode(int index);
+  void selectNodes(vesRenderer::Ptr renderer, std::vector<int>& selected,
+                   std::vector<std::pair<float, int> >& requests);
+
+  vesKiwiPointCloudOctree Octree;
+  std::string ErrorMessage;
+
+  unsigned int PointBudget;
+  float MaximumScreenSpaceError;
+  int PointSize;
+
+  vesRenderer::Ptr Renderer;
+  vesMaterial::Ptr Material;
+  std::map<int, LoadedNode> LoadedNodes;
+  unsigned long FrameNumber;
+  unsigned int NumberOfLoadedPoints;
+  int NumberOfVisibleNodes;
+  int NumberOfPendingNodes;
+
+  // Shared with the loader thread, guarded by Lock.  Requests are sorted by
+  // increasing priority so the loader takes them from the back.
+  std::vector<int> Requests;
+  std::vector<std::pair<int, vesGeometryData::Ptr> > Completed;
+  int LoadingNode;
+  bool ShouldQuit;
+
+  int ThreadId;
+  vtkNew<vtkMultiThreader> MultiThreader;
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> RequestAdded;
+};
+
+namespace {
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE LoaderLoop(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+
+  vesKiwiPointCloudRepresentation::vesInternal* selfInternal =
+    static_cast<vesKiwiPointCloudRepresentation::vesInternal*>(threadInfo->UserData);
+
+  std::vector<float> points;
+  std::vector<unsigned char> colors;
+
+  selfInternal->Lock->Lock();
+  while (true) {
+
+    while (!selfInternal->ShouldQuit && selfInternal->Requests.empty()) {
+      selfInternal->RequestAdded->Wait(selfInternal->Lock.GetPointer());
+    }
+    if (selfInternal->ShouldQuit) {
+      break;
+    }
+
+    const int index = selfInternal->Requests.back();
+    selfInternal->Requests.pop_back();
+    selfInternal->LoadingNode = index;
+    selfInternal->Lock->Unlock();
+
+    // Only this thread reads points, the main thread only uses the node
+    // table, which does not change while the file is open.
+    vesGeometryData::Ptr geometry;
+    if (selfInternal->Octree.readNode(index, points, colors)) {
+      geometry = createGeometry(points, colors);
+    }
+
+    selfInternal->Lock->Lock();
+    selfInternal->Completed.push_back(std::make_pair(index, geometry));
+    selfInternal->LoadingNode = -1;
+  }
+  selfInternal->Lock->Unlock();
+
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::vesInternal::addNode(int index,
+  vesGeometryData::Ptr geometry)
+{
+  vesMapper::Ptr mapper(new vesMapper());
+  mapper->setGeometryData(geometry);
+  mapper->setPointSize(this->PointSize);
+
+  LoadedNode& node = this->LoadedNodes[index];
+  node.Actor = vesActor::Ptr(new vesActor());
+  node.Actor->setMapper(mapper);
+  node.Actor->setMaterial(this->Material);
+  node.Actor->setVisible(false);
+  node.NumberOfPoints = this->Octree.node(index).NumberOfPoints;
+  node.LastUsedFrame = this->FrameNumber;
+  this->NumberOfLoadedPoints += node.NumberOfPoints;
+
+  if (this->Renderer) {
+    this->Renderer->addActor(node.Actor);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::vesInternal::releaseNode(int index)
+{
+  std::map<int, LoadedNode>::iterator itr = this->LoadedNodes.find(index);
+  if (itr == this->LoadedNodes.end()) {
+    return;
+  }
+  if (this->Renderer) {
+    this->Renderer->removeActor(itr->second.Actor);
+  }
+  this->NumberOfLoadedPoints -= itr->second.NumberOfPoints;
+  this->LoadedNodes.erase(itr);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::vesInternal::selectNodes(
+  vesRenderer::Ptr renderer, std::vector<int>& selected,
+  std::vector<std::pair<float, int> >& requests)
+{
+  vesCamera::Ptr camera = renderer->camera();
+  const float height = static_cast<float>(std::max(renderer->height(), 1));
+  const float aspect = static_cast<float>(std::max(renderer->width(), 1)) / height;
+
+  // The side planes of the frustum do not depend on the clipping range.
+  const vesMatrix4x4f viewProjection =
+    camera->computeProjectionTransform(aspect, 1.0f, 2.0f) * camera->computeViewTransform();
+  vesVector4f planes[4];
+  for (int i = 0; i < 2; ++i) {
+    planes[2 * i] = viewProjection.row(3) + viewProjection.row(i);
+    planes[2 * i + 1] = viewProjection.row(3) - viewProjection.row(i);
+  }
+  for (int i = 0; i < 4; ++i) {
+    planes[i] /= planes[i].head<3>().norm();
+  }
+
+  const vesVector3f eye = camera->position();
+  const float tanHalfAngle = tan(0.5f * camera->viewAngle() * M_PI / 180.0);
+
+  // Largest screen space error first.
+  std::priority_queue<std::pair<float, int> > queue;
+  const int root = 0;
+  queue.push(std::make_pair(std::numeric_limits<float>::max(), root));
+  unsigned int numberOfPoints = 0;
+
+  while (!queue.empty()) {
+    const float error = queue.top().first;
+    const int index = queue.top().second;
+    queue.pop();
+
+    const vesKiwiPointCloudOctree::Node& node = this->Octree.node(index);
+    if (numberOfPoints + node.NumberOfPoints > this->PointBudget) {
+      break;
+    }
+    numberOfPoints += node.NumberOfPoints;
+
+    if (this->LoadedNodes.find(index) == this->LoadedNodes.end()) {
+      requests.push_back(std::make_pair(error, index));
+      continue;
+    }
+    selected.push_back(index);
+
+    if (index != root && error <= this->MaximumScreenSpaceError) {
+      continue;
+    }
+
+    for (int i = 0; i < 8; ++i) {
+      if (node.Children[i] < 0) {
+        continue;
+      }
+
+      const vesKiwiPointCloudOctree::Node& child = this->Octree.node(node.Children[i]);
+      const vesVector3f center = child.Origin + vesVector3f::Constant(0.5f * child.Size);
+      const float radius = 0.5f * sqrt(3.0f) * child.Size;
+      bool isVisible = true;
+      for (int j = 0; j < 4 && isVisible; ++j) {
+        isVisible = planes[j].head<3>().dot(center) + planes[j][3] >= -radius;
+      }
+      if (!isVisible) {
+        continue;
+      }
+
+      float pixelsPerUnit;
+      if (camera->parallelProjection()) {
+        pixelsPerUnit = height / (2.0f * camera->parallelScale());
+      }
+      else {
+        const float distance = std::max((center - eye).norm() - radius, 1e-6f * child.Size);
+        pixelsPerUnit = height / (2.0f * distance * tanHalfAngle);
+      }
+      queue.push(std::make_pair(child.Spacing * pixelsPerUnit, node.Children[i]));
+    }
+  }
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPointCloudRepresentation::vesKiwiPointCloudRepresentation()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiPointCloudRepresentation::~vesKiwiPointCloudRepresentation()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::initializeWithShader(
+  vesSharedPtr<vesShaderProgram> shaderProgram)
+{
+  assert(shaderProgram);
+
+  this->Internal->Material = vesMaterial::Ptr(new vesMaterial());
+  this->Internal->Material->addAttribute(shaderProgram);
+  this->Internal->Material->addAttribute(vesDepth::Ptr(new vesDepth()));
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudRepresentation::loadOctree(const std::string& filename)
+{
+  assert(this->Internal->Material);
+
+  this->Internal->stopLoader();
+  while (!this->Internal->LoadedNodes.empty()) {
+    this->Internal->releaseNode(this->Internal->LoadedNodes.begin()->first);
+  }
+  this->Internal->Requests.clear();
+  this->Internal->Completed.clear();
+  this->Internal->ShouldQuit = false;
+
+  if (!this->Internal->Octree.open(filename)) {
+    this->Internal->ErrorMessage = this->Internal->Octree.errorMessage();
+    return false;
+  }
+
+  std::vector<float> points;
+  std::vector<unsigned char> colors;
+  if (!this->Internal->Octree.readNode(0, points, colors)) {
+    this->Internal->ErrorMessage = this->Internal->Octree.errorMessage();
+    this->Internal->Octree.close();
+    return false;
+  }
+  this->Internal->addNode(0, createGeometry(points, colors));
+  this->Internal->LoadedNodes[0].Actor->setVisible(true);
+
+  this->Internal->ThreadId =
+    this->Internal->MultiThreader->SpawnThread(LoaderLoop, this->Internal);
+  return true;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiPointCloudRepresentation::errorMessage() const
+{
+  return this->Internal->ErrorMessage;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::setPointBudget(unsigned int numberOfPoints)
+{
+  this->Internal->PointBudget = numberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPointCloudRepresentation::pointBudget() const
+{
+  return this->Internal->PointBudget;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::setMaximumScreenSpaceError(float pixels)
+{
+  this->Internal->MaximumScreenSpaceError = pixels;
+}
+
+//----------------------------------------------------------------------------
+float vesKiwiPointCloudRepresentation::maximumScreenSpaceError() const
+{
+  return this->Internal->MaximumScreenSpaceError;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::setPointSize(int size)
+{
+  this->Internal->PointSize = size;
+  std::map<int, vesInternal::LoadedNode>::iterator itr = this->Internal->LoadedNodes.begin();
+  for (; itr != this->Internal->LoadedNodes.end(); ++itr) {
+    itr->second.Actor->mapper()->setPointSize(size);
+  }
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudRepresentation::pointSize() const
+{
+  return this->Internal->PointSize;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudRepresentation::numberOfLoadedNodes() const
+{
+  return static_cast<int>(this->Internal->LoadedNodes.size());
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPointCloudRepresentation::numberOfVisibleNodes() const
+{
+  return this->Internal->NumberOfVisibleNodes;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiPointCloudRepresentation::numberOfLoadedPoints() const
+{
+  return this->Internal->NumberOfLoadedPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiPointCloudRepresentation::isLoading() const
+{
+  return this->Internal->NumberOfPendingNodes > 0;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::addSelfToRenderer(vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  this->Internal->Renderer = renderer;
+  std::map<int, vesInternal::LoadedNode>::iterator itr = this->Internal->LoadedNodes.begin();
+  for (; itr != this->Internal->LoadedNodes.end(); ++itr) {
+    renderer->addActor(itr->second.Actor);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  std::map<int, vesInternal::LoadedNode>::iterator itr = this->Internal->LoadedNodes.begin();
+  for (; itr != this->Internal->LoadedNodes.end(); ++itr) {
+    renderer->removeActor(itr->second.Actor);
+  }
+  this->Internal->Renderer.reset();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPointCloudRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
+{
+  if (!this->Internal->Octree.isOpen()) {
+    return;
+  }
+  ++this->Internal->FrameNumber;
+
+  // Adopt the nodes that finished loading since the last frame.
+  std::vector<std::pair<int, vesGeometryData::Ptr> > completed;
+  int loadingNode;
+  this->Internal->Lock->Lock();
+  completed.swap(this->Internal->Completed);
+  loadingNode = this->Internal->LoadingNode;
+  this->Internal->Lock->Unlock();
+
+  for (size_t i = 0; i < completed.size(); ++i) {
+    if (completed[i].second
+        && this->Internal->LoadedNodes.find(completed[i].first) == this->Internal->LoadedNodes.end()) {
+      this->Internal->addNode(completed[i].first, completed[i].second);
+    }
+  }
+
+  std::vector<int> selected;
+  std::vector<std::pair<float, int> > requests;
+  this->Internal->selectNodes(renderer, selected, requests);
+
+  std::map<int, vesInternal::LoadedNode>::iterator itr = this->Internal->LoadedNodes.begin();
+  for (; itr != this->Internal->LoadedNodes.end(); ++itr) {
+    itr->second.Actor->setVisible(false);
+  }
+  for (size_t i = 0; i < selected.size(); ++i) {
+    vesInternal::LoadedNode& node = this->Internal->LoadedNodes[selected[i]];
+    node.Actor->setVisible(true);
+    node.LastUsedFrame = this->Internal->FrameNumber;
+  }
+  this->Internal->NumberOfVisibleNodes = static_cast<int>(selected.size());
+
+  // Replace the queue of the loader with this frame's wishes.
+  std::sort(requests.begin(), requests.end());
+  this->Internal->Lock->Lock();
+  this->Internal->Requests.clear();
+  for (size_t i = 0; i < requests.size(); ++i) {
+    if (requests[i].second != loadingNode) {
+      this->Internal->Requests.push_back(requests[i].second);
+    }
+  }
+  this->Internal->RequestAdded->Broadcast();
+  this->Internal->Lock->Unlock();
+  this->Internal->NumberOfPendingNodes = static_cast<int>(requests.size());
+
+  // Release the least recently used nodes beyond the budget, keeping the
+  // ones drawn in this frame.
+  if (this->Internal->NumberOfLoadedPoints > this->Internal->PointBudget) {
+    std::vector<std::pair<unsigned long, int> > candidates;
+    for (itr = this->Internal->LoadedNodes.begin(); itr != this->Internal->LoadedNodes.end(); ++itr) {
+      if (itr->second.LastUsedFrame != this->Internal->FrameNumber) {
+        candidates.push_back(std::make_pair(itr->second.LastUsedFrame, itr->first));
+      }
+    }
+    std::sort(candidates.begin(), candidates.end());
+    for (size_t i = 0; i < candidates.size()
+         && this->Internal->NumberOfLoadedPoints > this->Internal->PointBudget; ++i) {
+      this->Internal->releaseNode(candidates[i].second);
+    }
+  }
+}
@@ -0,0 +1,95 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiPointCloudRepresentation
+/// \ingroup KiwiPlatform
+/// \brief Draws a paged point cloud octree, loading nodes as they are needed.
+///
+/// Every frame, willRender() walks the octree from the root and refines the
+/// nodes in the view frustum whose point spacing projects to more than
+/// maximumScreenSpaceError() pixels, largest error first, until the point
+/// budget is used up.  Selected nodes that are not in memory are queued for a
+/// background thread that reads them from the file and converts them to
+/// geometry; they are drawn from the next frame after they arrive.  Loaded
+/// nodes that are no longer selected stay cached until the point budget is
+/// exceeded, then the least recently used ones are released.
+///
+/// \see vesKiwiPointCloudOctreeBuilder
+#ifndef __vesKiwiPointCloudRepresentation_h
+#define __vesKiwiPointCloudRepresentation_h
+
+#include "vesKiwiDataRepresentation.h"
+
+#include <string>
+
+class vesShaderProgram;
+
+class vesKiwiPointCloudRepresentation : public vesKiwiDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiPointCloudRepresentation);
+  typedef vesKiwiDataRepresentation Superclass;
+
+  vesKiwiPointCloudRepresentation();
+  ~vesKiwiPointCloudRepresentation();
+
+  void initializeWithShader(vesSharedPtr<vesShaderProgram> shaderProgram);
+
+  /// Open an octree file and load its root node, so that the cloud has
+  /// bounds right away.  The other nodes are loaded in the background.
+  bool loadOctree(const std::string& filename);
+  std::string errorMessage() const;
+
+  /// Set/Get the maximum number of points kept in memory, 3 million by
+  /// default.
+  void setPointBudget(unsigned int numberOfPoints);
+  unsigned int pointBudget() const;
+
+  /// Set/Get the point spacing, in pixels, above which a node is refined by
+  /// its children.  2 by default.
+  void setMaximumScreenSpaceError(float pixels);
+  float maximumScreenSpaceError() const;
+
+  void setPointSize(int size);
+  int pointSize() const;
+
+  int numberOfLoadedNodes() const;
+  int numberOfVisibleNodes() const;
+  unsigned int numberOfLoadedPoints() const;
+
+  /// Whether nodes selected by the last willRender() are still being loaded,
+  /// i.e. whether rendering another frame would show more detail.
+  bool isLoading() const;
+
+  virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void willRender(vesSharedPtr<vesRenderer> renderer);
+
+  class vesInternal;
+
+private:
+
+  vesKiwiPointCloudRepresentation(const vesKiwiPointCloudRepresentation&); // Not implemented
+  void operator=(const vesKiwiPointCloudRepresentation&); // Not implemented
+
+  vesInternal* Internal;
+};
+
+#endif
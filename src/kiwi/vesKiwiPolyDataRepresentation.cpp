@@ -21,10 +21,12 @@
 #include "vesKiwiPolyDataRepresentation.h"
 #include "vesKiwiColorMapCollection.h"
 #include "vesKiwiDataConversionTools.h"
+#include "vesKiwiShaderVariantCache.h"
 #include "vesActor.h"
 #include "vesBlend.h"
 #include "vesDepth.h"
 #include "vesGeometryData.h"
+#include "vesGeometrySimplifier.h"
 #include "vesMapper.h"
 #include "vesMaterial.h"
 #include "vesRenderer.h"
@@ -38,12 +40,58 @@
 #include "vesPrimitive.h"
 #include "vesUniform.h"
 
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
 #include <vtkNew.h>
 #include <vtkTriangleFilter.h>
 #include <vtkLookupTable.h>
 #include <vtkDiscretizableColorTransferFunction.h>
 
 #include <cassert>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+namespace {
+
+struct LevelOfDetailTask
+{
+  LevelOfDetailTask()
+  {
+    this->ThreadId = -1;
+    this->IsDone = false;
+    this->IsCancelled = false;
+  }
+
+  int ThreadId;
+  bool IsDone;
+  volatile bool IsCancelled;
+  vesGeometryData::Ptr Input;
+  std::vector<vesPrimitive::Ptr> Levels;
+  vtkNew<vtkMutexLock> Lock;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE SimplifyGeometry(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LevelOfDetailTask* task = static_cast<LevelOfDetailTask*>(threadInfo->UserData);
+
+  // Each level keeps about a quarter of the triangles of the previous one.
+  std::vector<float> ratios;
+  ratios.push_back(0.25f);
+  ratios.push_back(0.0625f);
+  ratios.push_back(0.015625f);
+  std::vector<vesPrimitive::Ptr> levels = vesGeometrySimplifier::simplify(
+    task->Input, ratios, &task->IsCancelled);
+
+  task->Lock->Lock();
+  task->Levels = levels;
+  task->IsDone = true;
+  task->Lock->Unlock();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
 
 //----------------------------------------------------------------------------
 class vesKiwiPolyDataRepresentation::vesInternal
@@ -53,10 +101,23 @@ public:
   vesInternal()
   {
     this->GeometryMode = SURFACE_MODE;
+    this->ShaderFeatures = 0;
   }
 
   ~vesInternal()
   {
+    this->finishLevelOfDetailTask();
+  }
+
+  void finishLevelOfDetailTask()
+  {
+    if (this->SimplifyTask.ThreadId >= 0) {
+      // Stop a simplification that is still running instead of waiting for
+      // it, its levels would be dropped anyway.
+      this->SimplifyTask.IsCancelled = true;
+      this->MultiThreader->TerminateThread(this->SimplifyTask.ThreadId);
+      this->SimplifyTask.ThreadId = -1;
+    }
   }
 
   int GeometryMode;
@@ -73,6 +134,9 @@ public:
   vesShaderProgram::Ptr SurfaceShader;
   vesShaderProgram::Ptr TextureSurfaceShader;
 
+  vesKiwiShaderVariantCache::Ptr ShaderVariantCache;
+  int ShaderFeatures;
+
   vesPrimitive::Ptr Triangles;
   vesPrimitive::Ptr Lines;
   vesPrimitive::Ptr Points;
@@ -85,6 +149,10 @@ public:
   std::vector<vesSourceData::Ptr> ScalarArrays;
 
   vesSourceData::Ptr WireframeSources[3];
+
+  vtkNew<vtkMultiThreader> MultiThreader;
+  LevelOfDetailTask SimplifyTask;
+  std::vector<vesPrimitive::Ptr> LevelsOfDetail;
 };
 
 //----------------------------------------------------------------------------
@@ -103,28 +171,116 @@ vesKiwiPolyDataRepresentation::~vesKiwiPolyDataRepresentation()
 void vesKiwiPolyDataRepresentation::setPolyData(vtkPolyData* input)
 {
   assert(input);
+
+  vtkSmartPointer<vtkPolyData> polyData;
+  vesGeometryData::Ptr geometryData = PreparePolyData(input, polyData);
+  this->setPreparedPolyData(polyData, geometryData);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setPreparedPolyData(vtkPolyData* polyData, vesGeometryData::Ptr geometryData)
+{
+  assert(polyData);
+  assert(geometryData);
   assert(this->Internal->Mapper);
 
-  vesGeometryData::Ptr geometryData;
-  vtkSmartPointer<vtkPolyData> polyData = input;
+  this->Internal->finishLevelOfDetailTask();
+  this->Internal->SimplifyTask.IsDone = false;
+  this->Internal->LevelsOfDetail.clear();
 
+  // The saved primitives and wireframe arrays belong to the previous
+  // geometry, so drop them and enter the current geometry mode again.
+  const int geometryMode = this->Internal->GeometryMode;
+  this->Internal->Triangles.reset();
+  this->Internal->Lines.reset();
+  this->Internal->Points.reset();
+  for (int i = 0; i < 3; ++i) {
+    this->Internal->WireframeSources[i].reset();
+  }
 
-  if (!polyData->GetNumberOfStrips() && !polyData->GetNumberOfPolys() && !polyData->GetNumberOfLines()) {
+  this->Internal->Mapper->setGeometryData(geometryData);
+  this->convertVertexArrays(polyData);
+  this->colorByDefault();
 
-    geometryData = vesKiwiDataConversionTools::ConvertPoints(polyData);
+  if (geometryMode == WIREFRAME_MODE) {
+    this->wireframeOn();
+  }
+  else if (geometryMode == SURFACE_WITH_EDGES_MODE) {
+    this->surfaceWithEdgesOn();
+  }
+  else if (geometryMode == POINTS_MODE) {
+    this->pointsOn();
+  }
+}
 
+//----------------------------------------------------------------------------
+bool vesKiwiPolyDataRepresentation::setSharedTopologyPolyData(vtkPolyData* polyData, vesGeometryData::Ptr geometryData)
+{
+  assert(polyData);
+  assert(geometryData);
+
+  vesGeometryData::Ptr current = this->geometryData();
+  if (this->Internal->GeometryMode != SURFACE_MODE || !current
+      || current->numberOfPrimitiveTypes() != geometryData->numberOfPrimitiveTypes()) {
+    return false;
   }
-  else {
+  for (unsigned int i = 0; i < current->numberOfPrimitiveTypes(); ++i) {
+    if (current->primitive(i) != geometryData->primitive(i)) {
+      return false;
+    }
+  }
+
+  // Attach the array of the current color mode directly, the colorBy
+  // methods would reset all buffers of the mapper.
+  const std::string colorMode = this->colorMode();
+  this->convertVertexArrays(polyData);
 
-    bool addNormals = true;
-    bool duplicateVerts = false;
-    polyData = vesKiwiDataConversionTools::TriangulatePolyData(polyData, addNormals, duplicateVerts);
-    geometryData =  vesKiwiDataConversionTools::Convert(polyData);
+  vesSourceData::Ptr colorSource;
+  if (colorMode == "Vertex RGB") {
+    colorSource = this->Internal->Colors;
+  }
+  else if (colorMode == "Texture") {
+    colorSource = this->Internal->TCoords;
+  }
+  else if (colorMode != "Solid Color") {
+    std::vector<std::string>::const_iterator itr = std::find(this->Internal->ScalarArrayNames.begin(),
+                                                             this->Internal->ScalarArrayNames.end(), colorMode);
+    if (itr != this->Internal->ScalarArrayNames.end()) {
+      colorSource = this->Internal->ScalarArrays[itr - this->Internal->ScalarArrayNames.begin()];
+    }
+  }
+
+  geometryData->removeSource(geometryData->sourceData(vesVertexAttributeKeys::Color));
+  geometryData->removeSource(geometryData->sourceData(vesVertexAttributeKeys::TextureCoordinate));
+  if (colorSource) {
+    geometryData->addSource(colorSource);
   }
 
   this->Internal->Mapper->setGeometryData(geometryData);
-  this->convertVertexArrays(polyData);
-  this->colorByDefault();
+
+  // The frame does not have the array that was colored by.
+  if (!colorSource && colorMode != "Solid Color") {
+    this->colorByDefault();
+  }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vesGeometryData::Ptr vesKiwiPolyDataRepresentation::PreparePolyData(vtkPolyData* input, vtkSmartPointer<vtkPolyData>& output)
+{
+  assert(input);
+
+  output = input;
+
+  if (!output->GetNumberOfStrips() && !output->GetNumberOfPolys() && !output->GetNumberOfLines()) {
+    return vesKiwiDataConversionTools::ConvertPoints(output);
+  }
+
+  bool addNormals = true;
+  bool duplicateVerts = false;
+  output = vesKiwiDataConversionTools::TriangulatePolyData(output, addNormals, duplicateVerts);
+  return vesKiwiDataConversionTools::Convert(output);
 }
 
 //----------------------------------------------------------------------------
@@ -168,6 +324,7 @@ void vesKiwiPolyDataRepresentation::surfaceOn()
   this->setShaderProgram(this->Internal->SurfaceShader);
 
   this->Internal->GeometryMode = SURFACE_MODE;
+  this->updateShaderVariant();
 }
 
 //----------------------------------------------------------------------------
@@ -176,6 +333,7 @@ void vesKiwiPolyDataRepresentation::surfaceWithEdgesOn()
   this->wireframeOn();
   this->setShaderProgram(this->Internal->SurfaceWithEdgesShader);
   this->Internal->GeometryMode = SURFACE_WITH_EDGES_MODE;
+  this->updateShaderVariant();
 }
 
 //----------------------------------------------------------------------------
@@ -207,6 +365,26 @@ void vesKiwiPolyDataRepresentation::wireframeOn()
       sourceData.push_back(this->Internal->TCoords);
     }
 
+    // The triangles may be shared by the frames of a series, see
+    // setSharedTopologyPolyData(), so split the vertices of a copy.
+    vesPrimitive::Ptr triangles = this->geometryData()->triangles();
+    if (triangles) {
+      vesIndices<unsigned int>::Ptr indices(new vesIndices<unsigned int>());
+      *indices->indices() = *std::tr1::static_pointer_cast<vesIndices<unsigned int> >(triangles->getVesIndices())->indices();
+      vesPrimitive::Ptr trianglesCopy(new vesPrimitive());
+      trianglesCopy->setVesIndices(indices);
+      trianglesCopy->setPrimitiveType(triangles->primitiveType());
+      trianglesCopy->setIndicesValueType(triangles->indicesValueType());
+      trianglesCopy->setIndexCount(triangles->indexCount());
+      this->geometryData()->removePrimitive(triangles);
+      this->geometryData()->addPrimitive(trianglesCopy);
+    }
+
+    // Drop the wireframe arrays of an earlier visit of the same geometry.
+    for (int i = 0; i < 3; ++i) {
+      this->geometryData()->removeSource(this->geometryData()->sourceData(10 + i));
+    }
+
     vesKiwiDataConversionTools::RemoveSharedTriangleVertices(this->geometryData(), sourceData);
     vesKiwiDataConversionTools::ComputeWireframeVertexArrays(this->geometryData());
     this->Internal->WireframeSources[0] = this->geometryData()->sourceData(10);
@@ -228,6 +406,7 @@ void vesKiwiPolyDataRepresentation::wireframeOn()
   this->setShaderProgram(this->Internal->WireframeShader);
 
   this->Internal->GeometryMode = WIREFRAME_MODE;
+  this->updateShaderVariant();
 }
 
 //----------------------------------------------------------------------------
@@ -268,6 +447,7 @@ void vesKiwiPolyDataRepresentation::pointsOn()
   this->Internal->Points = pointPrimitive;
 
   this->Internal->GeometryMode = POINTS_MODE;
+  this->updateShaderVariant();
 }
 
 //----------------------------------------------------------------------------
@@ -346,6 +526,62 @@ void vesKiwiPolyDataRepresentation::setTextureSurfaceShader(vesSharedPtr<vesShad
   this->Internal->TextureSurfaceShader = shader;
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setShaderVariantCache(
+  vesSharedPtr<vesKiwiShaderVariantCache> cache)
+{
+  this->Internal->ShaderVariantCache = cache;
+  this->updateShaderVariant();
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesKiwiShaderVariantCache> vesKiwiPolyDataRepresentation::shaderVariantCache() const
+{
+  return this->Internal->ShaderVariantCache;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::setShaderFeatures(int features)
+{
+  this->Internal->ShaderFeatures = features;
+  this->updateShaderVariant();
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPolyDataRepresentation::shaderFeatures() const
+{
+  return this->Internal->ShaderFeatures;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::updateShaderVariant()
+{
+  if (!this->Internal->ShaderVariantCache || !this->Internal->Actor
+      || !this->geometryData()) {
+    return;
+  }
+
+  int features = this->Internal->ShaderFeatures;
+
+  if (this->Internal->GeometryMode == WIREFRAME_MODE) {
+    features |= vesKiwiShaderVariantCache::Wireframe;
+  }
+  else if (this->Internal->GeometryMode == SURFACE_WITH_EDGES_MODE) {
+    features |= vesKiwiShaderVariantCache::SurfaceWithEdges;
+  }
+
+  if (this->geometryData()->sourceData(vesVertexAttributeKeys::Color)) {
+    features |= vesKiwiShaderVariantCache::VertexColors;
+  }
+
+  if (this->Internal->Texture
+      && this->geometryData()->sourceData(vesVertexAttributeKeys::TextureCoordinate)) {
+    features |= vesKiwiShaderVariantCache::Texture;
+  }
+
+  this->setShaderProgram(this->Internal->ShaderVariantCache->program(features));
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiPolyDataRepresentation::initializeWithShader(
   vesSharedPtr<vesShaderProgram> shaderProgram)
@@ -383,6 +619,7 @@ void vesKiwiPolyDataRepresentation::setTexture(vesSharedPtr<vesTexture> texture)
   assert(this->Internal->Actor);
   this->Internal->Texture = texture;
   this->Internal->Actor->material()->addAttribute(texture);
+  this->updateShaderVariant();
 }
 
 //----------------------------------------------------------------------------
@@ -465,6 +702,73 @@ void vesKiwiPolyDataRepresentation::removeSelfFromRenderer(
   renderer->removeActor(this->Internal->Actor);
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
+{
+  vesNotUsed(renderer);
+
+  LevelOfDetailTask& task = this->Internal->SimplifyTask;
+  if (task.ThreadId >= 0) {
+    task.Lock->Lock();
+    const bool isDone = task.IsDone;
+    task.Lock->Unlock();
+
+    if (isDone) {
+      this->Internal->finishLevelOfDetailTask();
+      this->Internal->LevelsOfDetail = task.Levels;
+      task.Levels.clear();
+      task.Input.reset();
+    }
+  }
+
+  // The wireframe shaders rely on per vertex attributes that only match the
+  // full resolution triangles.
+  vesMapper::Ptr mapper = this->Internal->Mapper;
+  const bool useLevels = this->Internal->GeometryMode == SURFACE_MODE;
+  if (useLevels && !mapper->numberOfLevelsOfDetail()) {
+    for (size_t i = 0; i < this->Internal->LevelsOfDetail.size(); ++i) {
+      // Switch to a level once it has about one triangle per four pixels.
+      const vesPrimitive::Ptr& triangles = this->Internal->LevelsOfDetail[i];
+      mapper->addLevelOfDetail(triangles, 2.0f * sqrt(triangles->numberOfIndices() / 3.0f));
+    }
+  }
+  else if (!useLevels && mapper->numberOfLevelsOfDetail()) {
+    mapper->removeAllLevelsOfDetail();
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiPolyDataRepresentation::generateLevelsOfDetail(int minimumNumberOfTriangles)
+{
+  LevelOfDetailTask& task = this->Internal->SimplifyTask;
+  if (task.ThreadId >= 0 || !this->Internal->LevelsOfDetail.empty()) {
+    return;
+  }
+
+  vesPrimitive::Ptr triangles = this->Internal->Triangles
+    ? this->Internal->Triangles : this->geometryData()->triangles();
+  vesSourceData::Ptr points = this->geometryData()->sourceData(vesVertexAttributeKeys::Position);
+  if (!triangles || !points
+      || triangles->numberOfIndices() / 3 < static_cast<unsigned int>(minimumNumberOfTriangles)) {
+    return;
+  }
+
+  // Hand the thread its own geometry so that color and geometry mode changes
+  // may add and remove sources and primitives meanwhile.
+  task.Input = vesGeometryData::Ptr(new vesGeometryData());
+  task.Input->addSource(points);
+  task.Input->addPrimitive(triangles);
+  task.IsDone = false;
+  task.IsCancelled = false;
+  task.ThreadId = this->Internal->MultiThreader->SpawnThread(SimplifyGeometry, &task);
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiPolyDataRepresentation::numberOfLevelsOfDetail() const
+{
+  return static_cast<int>(this->Internal->LevelsOfDetail.size());
+}
+
 //----------------------------------------------------------------------------
 vesSharedPtr<vesActor> vesKiwiPolyDataRepresentation::actor() const
 {
@@ -560,9 +864,15 @@ void vesKiwiPolyDataRepresentation::colorByDefault()
 void vesKiwiPolyDataRepresentation::colorByTexture()
 {
   this->colorBySolidColor();
-  if (this->Internal->TCoords && this->Internal->TextureSurfaceShader) {
+  if (this->Internal->TCoords && (this->Internal->TextureSurfaceShader
+      || (this->Internal->ShaderVariantCache && this->Internal->Texture))) {
     this->geometryData()->addSource(this->Internal->TCoords);
-    this->setShaderProgram(this->Internal->TextureSurfaceShader);
+    if (this->Internal->ShaderVariantCache) {
+      this->updateShaderVariant();
+    }
+    else {
+      this->setShaderProgram(this->Internal->TextureSurfaceShader);
+    }
   }
 }
 
@@ -572,6 +882,7 @@ void vesKiwiPolyDataRepresentation::colorByRGBArray()
   this->colorBySolidColor();
   if (this->Internal->Colors) {
     this->geometryData()->addSource(this->Internal->Colors);
+    this->updateShaderVariant();
   }
 }
 
@@ -593,6 +904,7 @@ void vesKiwiPolyDataRepresentation::colorBySolidColor()
   else if (this->Internal->GeometryMode == SURFACE_WITH_EDGES_MODE) {
     this->setShaderProgram(this->Internal->SurfaceWithEdgesShader);
   }
+  this->updateShaderVariant();
 
 
   // reset VBO
@@ -607,6 +919,7 @@ void vesKiwiPolyDataRepresentation::colorByScalars()
   this->colorBySolidColor();
   if (this->Internal->ScalarColors) {
     this->geometryData()->addSource(this->Internal->ScalarColors);
+    this->updateShaderVariant();
   }
 }
 
@@ -621,6 +934,7 @@ void vesKiwiPolyDataRepresentation::colorByScalars(const std::string& arrayName)
   if (itr != this->Internal->ScalarArrayNames.end()) {
     vesSourceData::Ptr scalarColors = this->Internal->ScalarArrays[itr - this->Internal->ScalarArrayNames.begin()];
     this->geometryData()->addSource(scalarColors);
+    this->updateShaderVariant();
   }
 }
 
@@ -29,6 +29,7 @@
 #include <vector>
 
 class vesGeometryData;
+class vesKiwiShaderVariantCache;
 class vesActor;
 class vesMapper;
 class vesRenderer;
@@ -53,12 +54,38 @@ public:
 
   void setPolyData(vtkPolyData* polyData);
 
+  /// Set polydata and geometry data that were produced by PreparePolyData(),
+  /// for example on a vesKiwiParallelDataLoader worker thread.
+  void setPreparedPolyData(vtkPolyData* polyData, vesSharedPtr<vesGeometryData> geometryData);
+
+  /// Show the next frame of a series whose geometry shares the primitives of
+  /// the current geometry, see vesKiwiDataConversionTools::AdoptTopology().
+  /// Only the vertex arrays are uploaded again and the color mode is kept.
+  /// Returns false without changing anything if the primitives differ or the
+  /// representation is not in surface mode, in which case callers should use
+  /// setPreparedPolyData().
+  bool setSharedTopologyPolyData(vtkPolyData* polyData, vesSharedPtr<vesGeometryData> geometryData);
+
+  /// Triangulate and convert the input the same way setPolyData() does, but
+  /// without touching any representation state, so it is safe to call from a
+  /// worker thread.  The polydata the geometry was built from is returned in
+  /// \p output.
+  static vesSharedPtr<vesGeometryData> PreparePolyData(vtkPolyData* input, vtkSmartPointer<vtkPolyData>& output);
+
   void addTextureCoordinates(vtkDataArray* textureCoordinates);
 
+  /// Simplify the triangles into coarser levels of detail on a background
+  /// thread if there are at least \p minimumNumberOfTriangles of them.  The
+  /// levels are handed to the mapper by willRender() once they are ready and
+  /// are only drawn in surface mode.
+  void generateLevelsOfDetail(int minimumNumberOfTriangles = 20000);
+  int numberOfLevelsOfDetail() const;
+
   vesSharedPtr<vesGeometryData> geometryData() const;
 
   virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer>);
+  virtual void willRender(vesSharedPtr<vesRenderer> renderer);
 
   void setColor(double r, double g, double b, double a);
   vesVector4f color();
@@ -109,6 +136,17 @@ public:
   void setTextureSurfaceShader(vesSharedPtr<vesShaderProgram> shader);
   int geometryMode() const;
 
+  /// Set a variant cache to pick the program from the geometry mode and color
+  /// mode instead of using the surface, wireframe, surface with edges and
+  /// texture surface shaders.
+  void setShaderVariantCache(vesSharedPtr<vesKiwiShaderVariantCache> cache);
+  vesSharedPtr<vesKiwiShaderVariantCache> shaderVariantCache() const;
+
+  /// Set/Get vesKiwiShaderVariantCache::Feature flags, such as ClipPlane or
+  /// BlinnPhong, that are always requested from the variant cache.
+  void setShaderFeatures(int features);
+  int shaderFeatures() const;
+
   std::vector<std::string> colorModes();
   void setColorMode(const std::string& colorMode);
   std::string colorMode() const;
@@ -128,6 +166,7 @@ public:
 
 protected:
 
+  void updateShaderVariant();
 
 private:
 
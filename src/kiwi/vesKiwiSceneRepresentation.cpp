@@ -35,7 +35,11 @@
 #include "vesKiwiPolyDataRepresentation.h"
 #include "vesKiwiAnimationRepresentation.h"
 #include "vesKiwiImageWidgetRepresentation.h"
+#include "vesKiwiJSONReader.h"
 #include "vesKiwiImagePlaneDataRepresentation.h"
+#include "vesKiwiParallelDataLoader.h"
+#include "vesKiwiShaderVariantCache.h"
+#include "vesKiwiStaticBatchRepresentation.h"
 #include "vesEigen.h"
 
 #include "vesKiwiOptions.h"
@@ -61,44 +65,215 @@
 
 #include <vtksys/SystemTools.hxx>
 
+#include <algorithm>
 #include <vector>
 #include <cassert>
 
-#include <fstream>
 #include <string>
 
-#include <cJSON.h>
+namespace {
 
-typedef std::tr1::shared_ptr<cJSON> jsonSharedPtr;
+// Scene file contents are read in a single pass into these descriptions,
+// so the order of keys in the file does not matter and no document tree is
+// kept around while the objects load.
 
-namespace {
+struct ColorMapDescription
+{
+  ColorMapDescription() : HasNumberOfValues(false), NumberOfValues(0)
+  {
+  }
+
+  std::string Name;
+  std::string ColorSpace;
+  std::vector<double> RGBPoints;
+  bool HasNumberOfValues;
+  int NumberOfValues;
+};
+
+struct ObjectDescription
+{
+  ObjectDescription() :
+    HasFilenames(false), HasInlineColorMap(false),
+    HasOpacity(false), Opacity(1.0),
+    HasPointSize(false), PointSize(1.0),
+    HasLineWidth(false), LineWidth(1.0),
+    HasDrawOrder(false), DrawOrder(0),
+    HasFramesPerSecond(false), FramesPerSecond(0),
+    Stream(false), PrefetchFrames(8)
+  {
+  }
+
+  bool HasFilenames;
+  std::vector<std::string> Filenames;
+  bool Stream;
+  int PrefetchFrames;
+  std::string Filename;
+  std::string Url;
+
+  std::string ColorBy;
+  std::string ColorMapName;
+  bool HasInlineColorMap;
+  ColorMapDescription InlineColorMap;
+
+  std::vector<double> Color;
+  std::string Texture;
+  std::string GeometryMode;
+
+  bool HasOpacity;
+  double Opacity;
+  bool HasPointSize;
+  double PointSize;
+  bool HasLineWidth;
+  double LineWidth;
+  bool HasDrawOrder;
+  int DrawOrder;
+  bool HasFramesPerSecond;
+  int FramesPerSecond;
+};
 
-jsonSharedPtr makeShared(cJSON* json)
+std::string readString(vesKiwiJSONReader& reader)
 {
-  return jsonSharedPtr(json, free);
+  if (reader.peek() == vesKiwiJSONReader::String) {
+    return reader.nextString();
+  }
+  reader.skipValue();
+  return std::string();
 }
 
-void strPrint(const std::string& title, const std::string& str)
+std::vector<double> readDoubles(vesKiwiJSONReader& reader)
 {
-  printf("----%s----\n%s\n-----\n", title.c_str(), str.c_str());
+  if (reader.peek() == vesKiwiJSONReader::BeginArray) {
+    return reader.nextDoubleArray();
+  }
+  reader.skipValue();
+  return std::vector<double>();
 }
 
-std::string jsonToStr(cJSON* json)
+bool readNumber(vesKiwiJSONReader& reader, double& value)
 {
-  if (json) {
-    char* cstr = cJSON_Print(json);
-    std::string str = cstr;
-    free(cstr);
-    return str;
+  if (reader.peek() == vesKiwiJSONReader::Number) {
+    value = reader.nextDouble();
+    return true;
   }
-  else {
-    return "(null json object)";
+  reader.skipValue();
+  return false;
+}
+
+// Usage: assignVector<vesVector3d>(values, color);
+template<typename T>
+bool assignVector(const std::vector<double>& values, T& vec)
+{
+  if (values.size() == static_cast<size_t>(vec.size())) {
+    for (size_t i = 0; i < values.size(); ++i) {
+      vec[i] = values[i];
+    }
+    return true;
+  }
+  return false;
+}
+
+void readColorMap(vesKiwiJSONReader& reader, ColorMapDescription& colorMap)
+{
+  reader.beginObject();
+  while (reader.hasNext()) {
+    std::string name = reader.nextName();
+    double value = 0;
+    if (name == "color_space") {
+      colorMap.ColorSpace = readString(reader);
+    }
+    else if (name == "rgb_points") {
+      colorMap.RGBPoints = readDoubles(reader);
+    }
+    else if (name == "number_of_values") {
+      colorMap.HasNumberOfValues = readNumber(reader, value);
+      colorMap.NumberOfValues = static_cast<int>(value);
+    }
+    else {
+      reader.skipValue();
+    }
   }
+  reader.endObject();
 }
 
-std::string jsonToStr(jsonSharedPtr json)
+void readObject(vesKiwiJSONReader& reader, ObjectDescription& object)
 {
-  return jsonToStr(json.get());
+  reader.beginObject();
+  while (reader.hasNext()) {
+
+    std::string name = reader.nextName();
+    double value = 0;
+
+    if (name == "filenames") {
+      object.HasFilenames = true;
+      if (reader.peek() == vesKiwiJSONReader::BeginArray) {
+        object.Filenames = reader.nextStringArray();
+      }
+      else {
+        reader.skipValue();
+      }
+    }
+    else if (name == "stream") {
+      if (reader.peek() == vesKiwiJSONReader::Boolean) {
+        object.Stream = reader.nextBool();
+      }
+      else {
+        reader.skipValue();
+      }
+    }
+    else if (name == "prefetch_frames") {
+      if (readNumber(reader, value)) {
+        object.PrefetchFrames = static_cast<int>(value);
+      }
+    }
+    else if (name == "filename") {
+      object.Filename = readString(reader);
+    }
+    else if (name == "url") {
+      object.Url = readString(reader);
+    }
+    else if (name == "color_by") {
+      object.ColorBy = readString(reader);
+    }
+    else if (name == "color_map") {
+      if (reader.peek() == vesKiwiJSONReader::BeginObject) {
+        object.HasInlineColorMap = true;
+        readColorMap(reader, object.InlineColorMap);
+      }
+      else {
+        object.ColorMapName = readString(reader);
+      }
+    }
+    else if (name == "color") {
+      object.Color = readDoubles(reader);
+    }
+    else if (name == "texture") {
+      object.Texture = readString(reader);
+    }
+    else if (name == "geometry_mode") {
+      object.GeometryMode = readString(reader);
+    }
+    else if (name == "opacity") {
+      object.HasOpacity = readNumber(reader, object.Opacity);
+    }
+    else if (name == "point_size") {
+      object.HasPointSize = readNumber(reader, object.PointSize);
+    }
+    else if (name == "line_width") {
+      object.HasLineWidth = readNumber(reader, object.LineWidth);
+    }
+    else if (name == "draw_order") {
+      object.HasDrawOrder = readNumber(reader, value);
+      object.DrawOrder = static_cast<int>(value);
+    }
+    else if (name == "frames_per_second") {
+      object.HasFramesPerSecond = readNumber(reader, value);
+      object.FramesPerSecond = static_cast<int>(value);
+    }
+    else {
+      reader.skipValue();
+    }
+  }
+  reader.endObject();
 }
 
 }
@@ -117,6 +292,8 @@ public:
   vesSharedPtr<vesShaderProgram> GeometryTextureShader;
   vesSharedPtr<vesShaderProgram> ImageTextureShader;
   vesSharedPtr<vesShaderProgram> ClipShader;
+  vesSharedPtr<vesKiwiShaderVariantCache> ShaderVariantCache;
+  bool StaticBatchingIsEnabled;
 
   vesKiwiDataLoader* DataLoader;
 
@@ -141,6 +318,7 @@ public:
   {
     this->HasBackgroundSettings = false;
     this->HasCameraSettings = false;
+    this->StaticBatchingIsEnabled = false;
     this->BackgroundColor = vesVector3d(0.2, 0.2, 0.2);
     this->BackgroundColor2 = vesVector3d(0, 0, 0);
   }
@@ -158,59 +336,7 @@ public:
     }
   }
 
-  std::string getStr(cJSON* json, const char* key)
-  {
-    cJSON* value = cJSON_GetObjectItem(json, key);
-    if (value && value->type == cJSON_String) {
-      return value->valuestring;
-    }
-    return std::string();
-  }
-
-  std::vector<std::string> getStrings(cJSON* json, const char* key)
-  {
-    std::vector<std::string> values;
-    cJSON* jsonList = cJSON_GetObjectItem(json, key);
-    int numberOfValues = jsonList ? cJSON_GetArraySize(jsonList) : 0;
-    for (int i = 0; i < numberOfValues; ++i) {
-      cJSON* value = cJSON_GetArrayItem(jsonList, i);
-      if (value && value->type == cJSON_String) {
-        values.push_back(value->valuestring);
-      }
-    }
-    return values;
-  }
-
-  std::vector<double> getDoubles(cJSON* json, const char* key)
-  {
-    cJSON* jsonList = cJSON_GetObjectItem(json, key);
-
-    int numberOfValues = jsonList ? cJSON_GetArraySize(jsonList) : 0;
-    std::vector<double> values(numberOfValues);
-
-    for (int i = 0; i < numberOfValues; ++i) {
-      values[i] = cJSON_GetArrayItem(jsonList, i)->valuedouble;
-    }
-
-    return values;
-  }
-
-
-  // Usage: getVector<vesVector3d>(json, "color", color);
-  template<typename T>
-  bool getVector(cJSON* json, const char* key, T& vec)
-  {
-    std::vector<double> values = getDoubles(json, key);
-    if (values.size() == vec.size()) {
-      for (size_t i = 0; i < values.size(); ++i) {
-        vec[i] = values[i];
-      }
-      return true;
-    }
-    return false;
-  }
-
-  void assignColorMaps(vesKiwiDataRepresentation::Ptr rep, cJSON* properties)
+  void assignColorMaps(vesKiwiDataRepresentation::Ptr rep, const ObjectDescription& properties)
   {
 
     vesKiwiColorMapCollection::Ptr collection = rep->colorMapCollection();
@@ -227,23 +353,20 @@ public:
 
     // set object color map
 
-    std::string colorBy = getStr(properties, "color_by");
-    cJSON* colorMapJson = cJSON_GetObjectItem(properties, "color_map");
-    if (colorMapJson && !colorBy.empty()) {
+    const std::string& colorBy = properties.ColorBy;
+    if (!colorBy.empty()) {
 
-      vtkSmartPointer<vtkScalarsToColors> colorMap;
-      if (colorMapJson->type == cJSON_Object) {
-        collection->setColorMap(colorBy, this->createColorMap(colorMapJson));
+      if (properties.HasInlineColorMap) {
+        collection->setColorMap(colorBy, this->createColorMap(properties.InlineColorMap));
       }
-      else if (colorMapJson && colorMapJson->type == cJSON_String) {
-        //printf("%s --> %s\n", colorBy.c_str(), colorMapJson->valuestring);
-        collection->setColorMapForArray(colorBy, colorMapJson->valuestring);
+      else if (!properties.ColorMapName.empty()) {
+        collection->setColorMapForArray(colorBy, properties.ColorMapName);
       }
     }
 
   }
 
-  vesKiwiPolyDataRepresentation::Ptr createPolyDataRepresentation(vtkPolyData* polyData, cJSON* properties)
+  vesKiwiPolyDataRepresentation::Ptr createPolyDataRepresentation(vtkPolyData* polyData, vesGeometryData::Ptr geometryData, const ObjectDescription& properties)
   {
     vesKiwiPolyDataRepresentation::Ptr rep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation);
 
@@ -252,34 +375,31 @@ public:
     rep->initializeWithShader(this->GeometryShader);
     rep->setWireframeShader(this->GeometryWireframeShader);
     rep->setSurfaceWithEdgesShader(this->GeometrySurfaceWithEdgesShader);
-    rep->setPolyData(polyData);
+    rep->setShaderVariantCache(this->ShaderVariantCache);
+    rep->setPreparedPolyData(polyData, geometryData);
 
     vesVector3d color(1.0 ,1.0 ,1.0);
-    getVector<vesVector3d>(properties, "color", color);
+    assignVector<vesVector3d>(properties.Color, color);
     rep->setColor(color[0], color[1], color[2], 1.0);
 
-    cJSON* opacityJson = cJSON_GetObjectItem(properties, "opacity");
-    if (opacityJson && opacityJson->type == cJSON_Number) {
-      rep->setOpacity(opacityJson->valuedouble);
+    if (properties.HasOpacity) {
+      rep->setOpacity(properties.Opacity);
     }
 
-    cJSON* pointSizeJson = cJSON_GetObjectItem(properties, "point_size");
-    if (pointSizeJson && pointSizeJson->type == cJSON_Number) {
-      rep->setPointSize(pointSizeJson->valuedouble);
+    if (properties.HasPointSize) {
+      rep->setPointSize(properties.PointSize);
     }
 
-    cJSON* lineWidthJson = cJSON_GetObjectItem(properties, "line_width");
-    if (lineWidthJson && lineWidthJson->type == cJSON_Number) {
-      rep->setLineWidth(lineWidthJson->valuedouble);
+    if (properties.HasLineWidth) {
+      rep->setLineWidth(properties.LineWidth);
     }
 
-    cJSON* drawOrderJson = cJSON_GetObjectItem(properties, "draw_order");
-    if (drawOrderJson && drawOrderJson->type == cJSON_Number) {
-      rep->setBinNumber(opacityJson->valueint);
+    if (properties.HasDrawOrder) {
+      rep->setBinNumber(properties.DrawOrder);
     }
 
-    std::string colorBy = getStr(properties, "color_by");
-    std::string textureFile = getStr(properties, "texture");
+    const std::string& colorBy = properties.ColorBy;
+    std::string textureFile = properties.Texture;
 
     if (!textureFile.empty()) {
 
@@ -325,7 +445,7 @@ public:
     }
 
 
-    std::string geometryMode = getStr(properties, "geometry_mode");
+    const std::string& geometryMode = properties.GeometryMode;
     if (geometryMode == "wireframe") {
       rep->wireframeOn();
     }
@@ -339,7 +459,7 @@ public:
     return rep;
   }
 
-  vesKiwiDataRepresentation::Ptr createImageDataRepresentation(vtkImageData* image, cJSON* properties)
+  vesKiwiDataRepresentation::Ptr createImageDataRepresentation(vtkImageData* image, const ObjectDescription& properties)
   {
     if (image->GetDataDimension() == 3) {
       vesKiwiImageWidgetRepresentation::Ptr rep = vesKiwiImageWidgetRepresentation::Ptr(new vesKiwiImageWidgetRepresentation);
@@ -362,46 +482,106 @@ public:
   }
 
 
-  vesKiwiDataRepresentation::Ptr loadDataset(const std::string& filename, cJSON* objectJson)
+  vesKiwiDataRepresentation::Ptr createRepresentation(vesKiwiParallelDataLoader& loader, int taskIndex, const ObjectDescription& object)
   {
-    //std::cout << "loading: " << filename << std::endl;
-
     vesKiwiDataRepresentation::Ptr rep;
 
-    vtkSmartPointer<vtkDataSet> dataSet = this->DataLoader->loadDataset(filename);
-    if (dataSet) {
+    if (!loader.waitForTask(taskIndex)) {
+      this->setError(loader.errorTitle(taskIndex), loader.errorMessage(taskIndex));
+      return rep;
+    }
 
-      vtkPolyData* polyData = vtkPolyData::SafeDownCast(dataSet);
-      vtkImageData* imageData = vtkImageData::SafeDownCast(dataSet);
+    vtkSmartPointer<vtkDataSet> dataSet = loader.dataset(taskIndex);
+    vtkImageData* imageData = vtkImageData::SafeDownCast(dataSet);
 
-      if (polyData) {
-        rep = this->createPolyDataRepresentation(polyData, objectJson);
-      }
-      else if (vtkImageData::SafeDownCast(dataSet)) {
-        rep = this->createImageDataRepresentation(imageData, objectJson);
-      }
-      else {
-        this->setError("Unhandled data type", "Loaded unhandled data type from file: " + filename);
-      }
+    if (loader.geometryData(taskIndex)) {
+      rep = this->createPolyDataRepresentation(loader.polyData(taskIndex), loader.geometryData(taskIndex), object);
+    }
+    else if (imageData) {
+      rep = this->createImageDataRepresentation(imageData, object);
     }
     else {
-      this->setError(this->DataLoader->errorTitle(), this->DataLoader->errorMessage());
+      this->setError("Unhandled data type", "Loaded unhandled data type from file: " + loader.filename(taskIndex));
     }
 
     return rep;
   }
 
-  bool loadObjectSeries(cJSON* objectJson)
+  // A streamed series only loads its first frame here, the animation
+  // representation reads the others while it plays.
+  bool createStreamedObjectSeries(vesKiwiParallelDataLoader& loader, const std::vector<int>& taskIndices, const ObjectDescription& object)
   {
-    std::vector<vesKiwiPolyDataRepresentation::Ptr> reps;
+    vesKiwiPolyDataRepresentation::Ptr rep =
+      std::tr1::dynamic_pointer_cast<vesKiwiPolyDataRepresentation>(this->createRepresentation(loader, taskIndices[0], object));
+
+    if (!rep) {
+      return false;
+    }
+
+    std::vector<std::string> filenames;
+    for (size_t i = 0; i < object.Filenames.size(); ++i) {
+      filenames.push_back(this->BaseDir + "/" + object.Filenames[i]);
+    }
 
-    std::vector<std::string> filenames = getStrings(objectJson, "filenames");
+    vesKiwiAnimationRepresentation::Ptr series(new vesKiwiAnimationRepresentation);
+    series->setStreamedFrames(rep, filenames, *this->DataLoader, object.PrefetchFrames);
 
-    for (size_t i = 0; i < filenames.size(); ++i) {
+    if (object.HasFramesPerSecond) {
+      series->setFramesPerSecond(object.FramesPerSecond);
+    }
+
+    this->AllReps.push_back(series);
+    return true;
+  }
+
+  bool createObjectSeries(vesKiwiParallelDataLoader& loader, const std::vector<int>& taskIndices, const ObjectDescription& object)
+  {
+    if (object.Stream) {
+      return this->createStreamedObjectSeries(loader, taskIndices, object);
+    }
+
+    // When every frame has the connectivity of the first one, a single
+    // representation shows them all and the frames share its index buffers.
+    // Wireframe modes split the triangle vertices per frame, so they keep a
+    // representation per frame.
+    if (object.GeometryMode.empty() || object.GeometryMode == "surface") {
+      std::vector<vtkSmartPointer<vtkPolyData> > polyData;
+      std::vector<vesGeometryData::Ptr> geometryData;
+      for (size_t i = 0; i < taskIndices.size(); ++i) {
+        if (!loader.waitForTask(taskIndices[i]) || !loader.geometryData(taskIndices[i])) {
+          break;
+        }
+        if (i) {
+          if (!vesKiwiDataConversionTools::HasSameTopology(geometryData[0], loader.geometryData(taskIndices[i]))) {
+            break;
+          }
+          vesKiwiDataConversionTools::AdoptTopology(geometryData[0], loader.geometryData(taskIndices[i]));
+        }
+        polyData.push_back(loader.polyData(taskIndices[i]));
+        geometryData.push_back(loader.geometryData(taskIndices[i]));
+      }
+
+      if (polyData.size() > 1 && polyData.size() == taskIndices.size()) {
+        vesKiwiPolyDataRepresentation::Ptr rep = this->createPolyDataRepresentation(polyData[0], geometryData[0], object);
+
+        vesKiwiAnimationRepresentation::Ptr series(new vesKiwiAnimationRepresentation);
+        series->setFrames(rep, polyData, geometryData);
+
+        if (object.HasFramesPerSecond) {
+          series->setFramesPerSecond(object.FramesPerSecond);
+        }
+
+        this->AllReps.push_back(series);
+        return true;
+      }
+    }
+
+    std::vector<vesKiwiPolyDataRepresentation::Ptr> reps;
+
+    for (size_t i = 0; i < taskIndices.size(); ++i) {
 
-      std::string filename = this->BaseDir + "/" + filenames[i];
       vesKiwiPolyDataRepresentation::Ptr rep =
-        std::tr1::dynamic_pointer_cast<vesKiwiPolyDataRepresentation>(this->loadDataset(filename, objectJson));
+        std::tr1::dynamic_pointer_cast<vesKiwiPolyDataRepresentation>(this->createRepresentation(loader, taskIndices[i], object));
 
       if (!rep) {
         return false;
@@ -417,9 +597,8 @@ public:
     vesKiwiAnimationRepresentation::Ptr series(new vesKiwiAnimationRepresentation);
     series->setRepresentations(reps);
 
-    cJSON* framesPerSecondJson = cJSON_GetObjectItem(objectJson, "frames_per_second");
-    if (framesPerSecondJson && framesPerSecondJson->type == cJSON_Number) {
-      series->setFramesPerSecond(framesPerSecondJson->valueint);
+    if (object.HasFramesPerSecond) {
+      series->setFramesPerSecond(object.FramesPerSecond);
     }
 
 
@@ -427,27 +606,26 @@ public:
     return true;
   }
 
-
-  bool loadObject(cJSON* objectJson)
+  // Adds the files referenced by the object to the loader and returns their
+  // task indices.  Remote files are downloaded here, before loading starts.
+  std::vector<int> queueObject(vesKiwiParallelDataLoader& loader, const ObjectDescription& object)
   {
-    //strPrint("load object", jsonToStr(objectJson));
+    std::vector<int> taskIndices;
 
-    if (!objectJson) {
-      return false;
-    }
-
-
-    cJSON* filenamesJson = cJSON_GetObjectItem(objectJson, "filenames");
-    if (filenamesJson) {
-      return this->loadObjectSeries(objectJson);
+    if (object.HasFilenames) {
+      size_t numberOfFiles = object.Stream ? std::min<size_t>(object.Filenames.size(), 1) : object.Filenames.size();
+      for (size_t i = 0; i < numberOfFiles; ++i) {
+        taskIndices.push_back(loader.addFile(this->BaseDir + "/" + object.Filenames[i]));
+      }
+      return taskIndices;
     }
 
-    std::string url = getStr(objectJson, "url");
-    std::string filename = getStr(objectJson, "filename");
+    const std::string& url = object.Url;
+    std::string filename = object.Filename;
 
     if (filename.empty()) {
       this->setError("Missing Filename", "The object filename is missing.");
-      return false;
+      return taskIndices;
     }
 
     filename = this->BaseDir + "/" + filename;
@@ -455,16 +633,32 @@ public:
     if (!url.empty() && !vtksys::SystemTools::FileExists(filename.c_str(), true)) {
 #ifdef VES_USE_CURL
       vesKiwiCurlDownloader downloader;
+      downloader.setNumberOfConnections(4);
+      downloader.setResumeEnabled(true);
       if (!downloader.downloadUrlToFile(url, filename)) {
         this->setError(downloader.errorTitle(), downloader.errorMessage());
-        return false;
+        return taskIndices;
       }
 #else
-      return false;
+      return taskIndices;
 #endif // VES_USE_CURL
     }
 
-    vesKiwiDataRepresentation::Ptr rep = this->loadDataset(filename, objectJson);
+    taskIndices.push_back(loader.addFile(filename));
+    return taskIndices;
+  }
+
+  bool createObject(vesKiwiParallelDataLoader& loader, const std::vector<int>& taskIndices, const ObjectDescription& object)
+  {
+    if (!taskIndices.size()) {
+      return false;
+    }
+
+    if (object.HasFilenames) {
+      return this->createObjectSeries(loader, taskIndices, object);
+    }
+
+    vesKiwiDataRepresentation::Ptr rep = this->createRepresentation(loader, taskIndices[0], object);
     if (!rep) {
       return false;
     }
@@ -473,30 +667,63 @@ public:
     return true;
   }
 
-  bool loadObjects(cJSON* objectsJson)
+  bool loadObjects(const std::vector<ObjectDescription>& objects)
   {
-    if (!objectsJson) {
+    if (objects.empty()) {
       return false;
     }
 
-    const int numberOfObjects = cJSON_GetArraySize(objectsJson);
-    for (int i = 0; i < numberOfObjects; ++i) {
-      cJSON* objectJson = cJSON_GetArrayItem(objectsJson, i);
+    // Queue every file of every object first so that reading, parsing and
+    // conversion run concurrently, then create the representations in the
+    // declared order as each object becomes ready.
+    vesKiwiParallelDataLoader loader;
+    loader.copySettings(*this->DataLoader);
+
+    std::vector<std::vector<int> > objectTasks(objects.size());
+    for (size_t i = 0; i < objects.size(); ++i) {
+      objectTasks[i] = this->queueObject(loader, objects[i]);
+    }
+
+    loader.start();
 
-      this->loadObject(objectJson);
+    for (size_t i = 0; i < objects.size(); ++i) {
+      this->createObject(loader, objectTasks[i], objects[i]);
     }
 
     return this->ErrorMessage.empty();
   }
 
-  vtkSmartPointer<vtkDiscretizableColorTransferFunction> createColorMap(cJSON* mapJson)
+  void batchObjects()
   {
-    if (!mapJson) {
-      return 0;
+    // Animation series and images are left as they are.
+    std::vector<vesKiwiPolyDataRepresentation::Ptr> polyDataReps;
+    std::vector<vesKiwiDataRepresentation::Ptr> otherReps;
+    for (size_t i = 0; i < this->AllReps.size(); ++i) {
+      vesKiwiPolyDataRepresentation::Ptr rep =
+        std::tr1::dynamic_pointer_cast<vesKiwiPolyDataRepresentation>(this->AllReps[i]);
+      if (rep) {
+        polyDataReps.push_back(rep);
+      }
+      else {
+        otherReps.push_back(this->AllReps[i]);
+      }
+    }
+
+    if (polyDataReps.size() < 2) {
+      return;
     }
 
-    std::string colorSpace = getStr(mapJson, "color_space");
-    std::vector<double> rgbPoints = getDoubles(mapJson, "rgb_points");
+    vesKiwiStaticBatchRepresentation::Ptr batch(new vesKiwiStaticBatchRepresentation);
+    batch->setRepresentations(polyDataReps);
+
+    this->AllReps = otherReps;
+    this->AllReps.push_back(batch);
+  }
+
+  vtkSmartPointer<vtkDiscretizableColorTransferFunction> createColorMap(const ColorMapDescription& description)
+  {
+    const std::string& colorSpace = description.ColorSpace;
+    const std::vector<double>& rgbPoints = description.RGBPoints;
 
     if (rgbPoints.empty() || rgbPoints.size() % 4 != 0) {
       return 0;
@@ -529,30 +756,24 @@ public:
                             rgbPoints[i*4 + 3]);
     }
 
-    cJSON* numberOfValuesJson = cJSON_GetObjectItem(mapJson, "number_of_values");
-    if (numberOfValuesJson) {
+    if (description.HasNumberOfValues) {
       colorMap->DiscretizeOn();
-      colorMap->SetNumberOfValues(numberOfValuesJson->valueint);
+      colorMap->SetNumberOfValues(description.NumberOfValues);
     }
 
     return colorMap;
   }
 
-  bool loadColorMaps(cJSON* mapsJson)
+  bool loadColorMaps(const std::vector<ColorMapDescription>& maps)
   {
-    if (!mapsJson) {
+    if (maps.empty()) {
       return false;
     }
 
-    const int numberOfMaps = cJSON_GetArraySize(mapsJson);
-
-    for (int i = 0; i < numberOfMaps; ++i) {
-      cJSON* mapJson = cJSON_GetArrayItem(mapsJson, i);
-      std::string colorMapName = mapJson->string;
-
-      vtkSmartPointer<vtkDiscretizableColorTransferFunction> colorMap = this->createColorMap(mapJson);
+    for (size_t i = 0; i < maps.size(); ++i) {
+      vtkSmartPointer<vtkDiscretizableColorTransferFunction> colorMap = this->createColorMap(maps[i]);
       if (colorMap) {
-        this->ColorMaps[colorMapName] = colorMap;
+        this->ColorMaps[maps[i].Name] = colorMap;
       }
     }
 
@@ -590,64 +811,156 @@ void vesKiwiSceneRepresentation::setShaders(vesSharedPtr<vesShaderProgram> geome
   this->Internal->ClipShader = clipShader;
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiSceneRepresentation::setShaderVariantCache(vesSharedPtr<vesKiwiShaderVariantCache> cache)
+{
+  this->Internal->ShaderVariantCache = cache;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiSceneRepresentation::setStaticBatchingIsEnabled(bool enabled)
+{
+  this->Internal->StaticBatchingIsEnabled = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiSceneRepresentation::staticBatchingIsEnabled() const
+{
+  return this->Internal->StaticBatchingIsEnabled;
+}
+
 //----------------------------------------------------------------------------
 bool vesKiwiSceneRepresentation::loadScene(const std::string& filename, vesKiwiDataLoader* dataLoader)
 {
   this->Internal->BaseDir = vtksys::SystemTools::GetFilenamePath(filename);
   this->Internal->DataLoader = dataLoader;
 
-  // read contents of file
-  std::ifstream ifs(filename.c_str());
-  std::string jsonContent((std::istreambuf_iterator<char>(ifs)),
-                          (std::istreambuf_iterator<char>()));
-
+  // parse the file in place, either memory mapped or straight from the
+  // loader if the scene was read from an archive into memory
+  vesKiwiJSONReader reader;
+  const char* memoryData;
+  size_t memoryLength;
+  if (dataLoader->memoryFile(filename, memoryData, memoryLength)) {
+    reader.setInput(memoryData, memoryLength);
+  }
+  else {
+    reader.openFile(filename);
+  }
 
-  jsonSharedPtr sceneJson = makeShared(cJSON_Parse(jsonContent.c_str()));
+  std::vector<ColorMapDescription> colorMaps;
+  std::vector<ObjectDescription> objects;
+  std::vector<double> backgroundColor;
+  std::vector<double> backgroundColor2;
+  std::string backgroundImage;
+  bool hasCamera = false;
+  std::vector<double> cameraPosition;
+  std::vector<double> cameraFocalPoint;
+  std::vector<double> cameraViewUp;
+
+  reader.beginObject();
+  while (reader.hasNext()) {
+
+    std::string name = reader.nextName();
+
+    if (name == "color_maps" && reader.peek() == vesKiwiJSONReader::BeginObject) {
+      reader.beginObject();
+      while (reader.hasNext()) {
+        colorMaps.push_back(ColorMapDescription());
+        colorMaps.back().Name = reader.nextName();
+        if (reader.peek() == vesKiwiJSONReader::BeginObject) {
+          readColorMap(reader, colorMaps.back());
+        }
+        else {
+          reader.skipValue();
+        }
+      }
+      reader.endObject();
+    }
+    else if (name == "objects" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+      reader.beginArray();
+      while (reader.hasNext()) {
+        if (reader.peek() == vesKiwiJSONReader::BeginObject) {
+          objects.push_back(ObjectDescription());
+          readObject(reader, objects.back());
+        }
+        else {
+          reader.skipValue();
+        }
+      }
+      reader.endArray();
+    }
+    else if (name == "background_color") {
+      backgroundColor = readDoubles(reader);
+    }
+    else if (name == "background_color2") {
+      backgroundColor2 = readDoubles(reader);
+    }
+    else if (name == "background_image") {
+      backgroundImage = readString(reader);
+    }
+    else if (name == "camera" && reader.peek() == vesKiwiJSONReader::BeginObject) {
+      hasCamera = true;
+      reader.beginObject();
+      while (reader.hasNext()) {
+        std::string cameraName = reader.nextName();
+        if (cameraName == "position") {
+          cameraPosition = readDoubles(reader);
+        }
+        else if (cameraName == "focal_point") {
+          cameraFocalPoint = readDoubles(reader);
+        }
+        else if (cameraName == "view_up") {
+          cameraViewUp = readDoubles(reader);
+        }
+        else {
+          reader.skipValue();
+        }
+      }
+      reader.endObject();
+    }
+    else {
+      reader.skipValue();
+    }
+  }
+  reader.endObject();
 
-  if (!sceneJson) {
+  if (reader.hasError()) {
     this->setError("Parse Error", "Error parsing JSON file contents.");
-
-    //
-    //std::string errorStr = std::string(cJSON_GetErrorPtr()-5, 10);
-    //printf("parse error: %s\n", errorStr.c_str());
-
     return false;
   }
 
-  //strPrint("json data", jsonToStr(sceneJson));
-
   // load color maps
-  cJSON* colorMapsJson = cJSON_GetObjectItem(sceneJson.get(), "color_maps");
-  this->Internal->loadColorMaps(colorMapsJson);
+  this->Internal->loadColorMaps(colorMaps);
 
   // load objects
-  cJSON* objectsJson = cJSON_GetObjectItem(sceneJson.get(), "objects");
-  this->Internal->loadObjects(objectsJson);
+  this->Internal->loadObjects(objects);
+  if (this->Internal->StaticBatchingIsEnabled) {
+    this->Internal->batchObjects();
+  }
 
 
-  // parse background settings
+  // apply background settings
   this->Internal->HasBackgroundSettings = false;
-  if (this->Internal->getVector<vesVector3d>(sceneJson.get(), "background_color", this->Internal->BackgroundColor)) {
+  if (assignVector<vesVector3d>(backgroundColor, this->Internal->BackgroundColor)) {
     this->Internal->HasBackgroundSettings = true;
-    if (!this->Internal->getVector<vesVector3d>(sceneJson.get(), "background_color2", this->Internal->BackgroundColor2)) {
+    if (!assignVector<vesVector3d>(backgroundColor2, this->Internal->BackgroundColor2)) {
       this->Internal->BackgroundColor2 = this->Internal->BackgroundColor;
     }
   }
 
-  this->Internal->BackgroundImage = this->Internal->getStr(sceneJson.get(), "background_image");
+  this->Internal->BackgroundImage = backgroundImage;
   if (!this->Internal->BackgroundImage.empty()) {
     this->Internal->HasBackgroundSettings = true;
   }
 
 
-  // parse camera settings
+  // apply camera settings
   this->Internal->HasCameraSettings = false;
-  cJSON* cameraJson = cJSON_GetObjectItem(sceneJson.get(), "camera");
-  if (cameraJson) {
+  if (hasCamera) {
     this->Internal->HasCameraSettings =
-      (    this->Internal->getVector<vesVector3d>(cameraJson, "position", this->Internal->CameraPosition)
-        && this->Internal->getVector<vesVector3d>(cameraJson, "focal_point", this->Internal->CameraFocalPoint)
-        && this->Internal->getVector<vesVector3d>(cameraJson, "view_up", this->Internal->CameraViewUp));
+      (    assignVector<vesVector3d>(cameraPosition, this->Internal->CameraPosition)
+        && assignVector<vesVector3d>(cameraFocalPoint, this->Internal->CameraFocalPoint)
+        && assignVector<vesVector3d>(cameraViewUp, this->Internal->CameraViewUp));
   }
 
 
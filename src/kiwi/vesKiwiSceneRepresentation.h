@@ -25,6 +25,7 @@
 #include "vesKiwiWidgetRepresentation.h"
 
 class vesKiwiDataLoader;
+class vesKiwiShaderVariantCache;
 class vesShaderProgram;
 class vtkPlane;
 
@@ -44,6 +45,15 @@ public:
                             vesSharedPtr<vesShaderProgram> imageTextureShader,
                             vesSharedPtr<vesShaderProgram> clipShader);
 
+  /// When set, geometry representations pick their program from the variant
+  /// cache instead of the geometry shaders passed to setShaders().
+  void setShaderVariantCache(vesSharedPtr<vesKiwiShaderVariantCache> cache);
+
+  /// When enabled, loadScene() merges the poly data objects that share a
+  /// material into a vesKiwiStaticBatchRepresentation.  Off by default.
+  void setStaticBatchingIsEnabled(bool enabled);
+  bool staticBatchingIsEnabled() const;
+
   bool loadScene(const std::string& filename, vesKiwiDataLoader* dataLoader);
 
   const std::vector<vesSharedPtr<vesKiwiDataRepresentation> > dataRepresentations() const;
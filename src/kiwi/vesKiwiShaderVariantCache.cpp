@@ -0,0 +1,193 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiShaderVariantCache.h"
+
+#include "vesBuiltinShaders.h"
+#include "vesModelViewUniform.h"
+#include "vesNormalMatrixUniform.h"
+#include "vesProjectionUniform.h"
+#include "vesShader.h"
+#include "vesShaderProgram.h"
+#include "vesUniform.h"
+#include "vesVertexAttribute.h"
+#include "vesVertexAttributeKeys.h"
+
+#include <map>
+
+//----------------------------------------------------------------------------
+class vesKiwiShaderVariantCache::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->ClipPlaneUniform = vesUniform::Ptr(
+      new vesUniform("clipPlaneEquation", vesVector4f(1.0f, 0.0f, 0.0f, 0.0f)));
+  }
+
+  vesShaderProgram::Ptr createProgram(int features);
+
+  std::map<int, vesShaderProgram::Ptr> Variants;
+  vesUniform::Ptr ClipPlaneUniform;
+};
+
+//----------------------------------------------------------------------------
+vesShaderProgram::Ptr vesKiwiShaderVariantCache::vesInternal::createProgram(int features)
+{
+  const std::string defines = vesKiwiShaderVariantCache::defines(features);
+
+  vesShaderProgram::Ptr program(new vesShaderProgram());
+  program->addShader(vesShader::Ptr(new vesShader(vesShader::Vertex,
+    defines + vesBuiltinShaders::vesUberShader_vert())));
+  program->addShader(vesShader::Ptr(new vesShader(vesShader::Fragment,
+    defines + vesBuiltinShaders::vesUberShader_frag())));
+
+  program->addUniform(vesUniform::Ptr(new vesModelViewUniform()));
+  program->addUniform(vesUniform::Ptr(new vesProjectionUniform()));
+  program->addUniform(vesUniform::Ptr(new vesNormalMatrixUniform()));
+
+  program->addVertexAttribute(vesVertexAttribute::Ptr(
+    new vesPositionVertexAttribute()), vesVertexAttributeKeys::Position);
+  program->addVertexAttribute(vesVertexAttribute::Ptr(
+    new vesNormalVertexAttribute()), vesVertexAttributeKeys::Normal);
+
+  if (features & Instanced) {
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesGenericVertexAttribute("instanceOffset")), vesVertexAttributeKeys::InstanceOffset);
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesGenericVertexAttribute("instanceColor")), vesVertexAttributeKeys::InstanceColor);
+  }
+  else if (!(features & Texture) || (features & VertexColors)) {
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesColorVertexAttribute()), vesVertexAttributeKeys::Color);
+  }
+
+  if (features & Texture) {
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesTextureCoordinateVertexAttribute()), vesVertexAttributeKeys::TextureCoordinate);
+  }
+
+  if (features & ClipPlane) {
+    program->addUniform(this->ClipPlaneUniform);
+  }
+
+  if (features & (Wireframe | SurfaceWithEdges)) {
+    // Same locations as vesKiwiPolyDataRepresentation::wireframeOn() uses.
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesGenericVertexAttribute("tri_p1")), 10);
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesGenericVertexAttribute("tri_p2")), 11);
+    program->addVertexAttribute(vesVertexAttribute::Ptr(
+      new vesGenericVertexAttribute("tri_point_index")), 12);
+  }
+
+  return program;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiShaderVariantCache::vesKiwiShaderVariantCache()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiShaderVariantCache::~vesKiwiShaderVariantCache()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiShaderVariantCache::normalizedFeatures(int features)
+{
+  if (features & Instanced) {
+    features &= (Instanced | ClipPlane | BlinnPhong);
+  }
+
+  if (!(features & Texture)) {
+    features &= ~VertexColors;
+  }
+
+  if (features & SurfaceWithEdges) {
+    features &= ~Wireframe;
+  }
+
+  return features;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiShaderVariantCache::defines(int features)
+{
+  features = normalizedFeatures(features);
+
+  std::string result;
+  if (features & VertexColors) {
+    result += "#define VES_VERTEX_COLORS\n";
+  }
+  if (features & Texture) {
+    result += "#define VES_TEXTURE\n";
+  }
+  if (features & ClipPlane) {
+    result += "#define VES_CLIP_PLANE\n";
+  }
+  if (features & (Wireframe | SurfaceWithEdges)) {
+    result += "#define VES_WIREFRAME\n";
+  }
+  if (features & SurfaceWithEdges) {
+    result += "#define VES_SURFACE_WITH_EDGES\n";
+  }
+  if (features & BlinnPhong) {
+    result += "#define VES_BLINN_PHONG\n";
+  }
+  if (features & Instanced) {
+    result += "#define VES_INSTANCED\n";
+  }
+  return result;
+}
+
+//----------------------------------------------------------------------------
+vesShaderProgram::Ptr vesKiwiShaderVariantCache::program(int features)
+{
+  features = normalizedFeatures(features);
+
+  vesShaderProgram::Ptr& program = this->Internal->Variants[features];
+  if (!program) {
+    program = this->Internal->createProgram(features);
+  }
+  return program;
+}
+
+//----------------------------------------------------------------------------
+vesUniform::Ptr vesKiwiShaderVariantCache::clipPlaneUniform() const
+{
+  return this->Internal->ClipPlaneUniform;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiShaderVariantCache::numberOfVariants() const
+{
+  return static_cast<int>(this->Internal->Variants.size());
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiShaderVariantCache::clear()
+{
+  this->Internal->Variants.clear();
+}
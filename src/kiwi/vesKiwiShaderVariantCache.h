@@ -0,0 +1,97 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiShaderVariantCache
+/// \ingroup KiwiPlatform
+/// \brief Specialized variants of the builtin uber shader.
+///
+/// A program is requested with a mask of Feature flags.  The first request
+/// for a mask builds a vesShaderProgram from vesUberShader_vert.glsl and
+/// vesUberShader_frag.glsl with a VES_* define for each feature, later
+/// requests return the same program.  Masks that only differ in features
+/// which do not change the generated source share one program, see
+/// normalizedFeatures().  The GL program itself is still compiled lazily on
+/// first bind.
+///
+/// One cache is meant to be shared by every representation of an app, so
+/// representations that need the same features render with the same program.
+#ifndef __vesKiwiShaderVariantCache_h
+#define __vesKiwiShaderVariantCache_h
+
+#include <vesSharedPtr.h>
+#include <vesSetGet.h>
+
+#include <string>
+
+class vesShaderProgram;
+class vesUniform;
+
+class vesKiwiShaderVariantCache
+{
+public:
+
+  vesTypeMacro(vesKiwiShaderVariantCache);
+
+  enum Feature
+  {
+    VertexColors     = 1 << 0,
+    Texture          = 1 << 1,
+    ClipPlane        = 1 << 2,
+    Wireframe        = 1 << 3,
+    SurfaceWithEdges = 1 << 4,
+    BlinnPhong       = 1 << 5,
+    Instanced        = 1 << 6
+  };
+
+  vesKiwiShaderVariantCache();
+  ~vesKiwiShaderVariantCache();
+
+  /// Return the program for the given features, creating it on first use.
+  vesSharedPtr<vesShaderProgram> program(int features);
+
+  /// The features after dropping those that do not change the program.
+  /// Colors are always read from the vertexColor attribute, which vesMapper
+  /// sets to the solid color when there is no color array, so VertexColors
+  /// only matters together with Texture.  SurfaceWithEdges replaces
+  /// Wireframe.  Instanced glyphs are colored per instance and only combine
+  /// with ClipPlane and BlinnPhong.
+  static int normalizedFeatures(int features);
+
+  /// The preprocessor lines prepended to the uber shader sources.
+  static std::string defines(int features);
+
+  /// The clipPlaneEquation uniform shared by all ClipPlane variants.
+  vesSharedPtr<vesUniform> clipPlaneUniform() const;
+
+  /// Number of distinct programs created so far.
+  int numberOfVariants() const;
+
+  /// Forget all variants.  Programs still referenced elsewhere stay valid.
+  void clear();
+
+private:
+
+  vesKiwiShaderVariantCache(const vesKiwiShaderVariantCache&); // Not implemented
+  void operator=(const vesKiwiShaderVariantCache&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -0,0 +1,103 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiStaticBatchRepresentation.h"
+#include "vesKiwiPolyDataRepresentation.h"
+
+#include "vesActor.h"
+#include "vesRenderer.h"
+#include "vesStaticBatcher.h"
+
+#include <cassert>
+
+//----------------------------------------------------------------------------
+class vesKiwiStaticBatchRepresentation::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+  }
+
+  ~vesInternal()
+  {
+  }
+
+  std::vector<vesKiwiPolyDataRepresentation::Ptr> Reps;
+  std::vector<vesActor::Ptr> Actors;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiStaticBatchRepresentation::vesKiwiStaticBatchRepresentation()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiStaticBatchRepresentation::~vesKiwiStaticBatchRepresentation()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiStaticBatchRepresentation::setRepresentations(
+  const std::vector<vesKiwiPolyDataRepresentation::Ptr>& reps)
+{
+  this->Internal->Reps = reps;
+
+  std::vector<vesActor::Ptr> actors;
+  for (size_t i = 0; i < reps.size(); ++i) {
+    actors.push_back(reps[i]->actor());
+  }
+  this->Internal->Actors = vesStaticBatcher::merge(actors);
+}
+
+//----------------------------------------------------------------------------
+const std::vector<vesKiwiPolyDataRepresentation::Ptr>&
+  vesKiwiStaticBatchRepresentation::representations() const
+{
+  return this->Internal->Reps;
+}
+
+//----------------------------------------------------------------------------
+const std::vector<vesActor::Ptr>& vesKiwiStaticBatchRepresentation::actors() const
+{
+  return this->Internal->Actors;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiStaticBatchRepresentation::addSelfToRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  for (size_t i = 0; i < this->Internal->Actors.size(); ++i) {
+    renderer->addActor(this->Internal->Actors[i]);
+  }
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiStaticBatchRepresentation::removeSelfFromRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  for (size_t i = 0; i < this->Internal->Actors.size(); ++i) {
+    renderer->removeActor(this->Internal->Actors[i]);
+  }
+}
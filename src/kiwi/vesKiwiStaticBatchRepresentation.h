@@ -0,0 +1,65 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiStaticBatchRepresentation
+/// \ingroup KiwiPlatform
+/// \brief Draws many static poly data representations through a few batches.
+///
+/// The actors of the representations are merged with vesStaticBatcher when
+/// they are set, so they should be fully configured by then.  Hiding the
+/// actor of a representation still hides its part of the batch.
+#ifndef __vesKiwiStaticBatchRepresentation_h
+#define __vesKiwiStaticBatchRepresentation_h
+
+#include "vesKiwiDataRepresentation.h"
+
+#include <vector>
+
+class vesActor;
+class vesKiwiPolyDataRepresentation;
+class vesRenderer;
+
+class vesKiwiStaticBatchRepresentation : public vesKiwiDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiStaticBatchRepresentation);
+
+  vesKiwiStaticBatchRepresentation();
+  ~vesKiwiStaticBatchRepresentation();
+
+  void setRepresentations(const std::vector<vesSharedPtr<vesKiwiPolyDataRepresentation> >& reps);
+  const std::vector<vesSharedPtr<vesKiwiPolyDataRepresentation> >& representations() const;
+
+  /// The actors added to the renderer, batches first.
+  const std::vector<vesSharedPtr<vesActor> >& actors() const;
+
+  virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
+
+private:
+
+  vesKiwiStaticBatchRepresentation(const vesKiwiStaticBatchRepresentation&); // Not implemented
+  void operator=(const vesKiwiStaticBatchRepresentation&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -28,6 +28,7 @@
 #include "vesShaderProgram.h"
 #include "vesKiwiDataConversionTools.h"
 #include "vesKiwiPolyDataRepresentation.h"
+#include "vesKiwiVoxelGridFilter.h"
 
 #include <vtkPolyData.h>
 #include <vtkTimerLog.h>
@@ -61,19 +62,40 @@ public:
     this->ShouldQuit = false;
     this->HaveNew = false;
     this->ClientThreadId = -1;
+    this->MaximumNumberOfPoints = 0;
   }
 
   ~vesInternal()
   {
   }
 
+  // Voxel grid downsample clouds that exceed the maximum number of points.
+  vesGeometryData::Ptr limitNumberOfPoints(vesGeometryData::Ptr geometryData)
+  {
+    this->Lock->Lock();
+    const unsigned int maximumNumberOfPoints = this->MaximumNumberOfPoints;
+    this->Lock->Unlock();
+
+    vesSourceData::Ptr points = geometryData
+      ? geometryData->sourceData(vesVertexAttributeKeys::Position) : vesSourceData::Ptr();
+    if (!maximumNumberOfPoints || !points || points->sizeOfArray() <= maximumNumberOfPoints) {
+      return geometryData;
+    }
+
+    this->VoxelGrid.setMaximumNumberOfPoints(maximumNumberOfPoints);
+    vesGeometryData::Ptr downsampled = this->VoxelGrid.filter(geometryData);
+    return downsampled ? downsampled : geometryData;
+  }
+
   int ClientThreadId;
+  unsigned int MaximumNumberOfPoints;
   bool HaveNew;
   bool ShouldQuit;
 
   vtkNew<vtkClientSocket> Comm;
 
   vesGeometryData::Ptr GeometryData;
+  vesKiwiVoxelGridFilter VoxelGrid;
 
   vtkNew<vtkMultiThreader> MultiThreader;
   vtkNew<vtkMutexLock> Lock;
@@ -190,7 +212,8 @@ VTK_THREAD_RETURN_TYPE ClientLoop(void* arg)
   bool shouldQuit = false;
   while (!shouldQuit) {
 
-      vesGeometryData::Ptr geometryData = ReceiveGeometryData(selfInternal->Comm.GetPointer());
+      vesGeometryData::Ptr geometryData = selfInternal->limitNumberOfPoints(
+        ReceiveGeometryData(selfInternal->Comm.GetPointer()));
 
       if (!geometryData) {
         break;
@@ -217,13 +240,31 @@ void vesKiwiStreamingDataRepresentation::initializeWithShader(
   this->Internal->GeometryShader = shader;
   this->Internal->PolyDataRep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation);
   this->Internal->PolyDataRep->initializeWithShader(this->Internal->GeometryShader);
-  this->Internal->PolyDataRep->mapper()->setGeometryData(ReceiveGeometryData(this->Internal->Comm.GetPointer()));
+  this->Internal->PolyDataRep->mapper()->setGeometryData(
+    this->Internal->limitNumberOfPoints(ReceiveGeometryData(this->Internal->Comm.GetPointer())));
   this->Internal->PolyDataRep->setPointSize(2.0);
 
 
   this->Internal->ClientThreadId = this->Internal->MultiThreader->SpawnThread(ClientLoop, this->Internal);
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiStreamingDataRepresentation::setMaximumNumberOfPoints(unsigned int numberOfPoints)
+{
+  this->Internal->Lock->Lock();
+  this->Internal->MaximumNumberOfPoints = numberOfPoints;
+  this->Internal->Lock->Unlock();
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiStreamingDataRepresentation::maximumNumberOfPoints() const
+{
+  this->Internal->Lock->Lock();
+  const unsigned int numberOfPoints = this->Internal->MaximumNumberOfPoints;
+  this->Internal->Lock->Unlock();
+  return numberOfPoints;
+}
+
 //----------------------------------------------------------------------------
 bool vesKiwiStreamingDataRepresentation::handleSingleTouchDown(int displayX, int displayY)
 {
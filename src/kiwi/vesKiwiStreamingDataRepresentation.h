@@ -41,6 +41,12 @@ public:
 
   bool connectToServer(const std::string& host, int port);
 
+  /// Set/Get the maximum number of points drawn, 0 for no limit.  Received
+  /// clouds with more points are downsampled with a vesKiwiVoxelGridFilter
+  /// on the client thread.
+  void setMaximumNumberOfPoints(unsigned int numberOfPoints);
+  unsigned int maximumNumberOfPoints() const;
+
   virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
   virtual void willRender(vesSharedPtr<vesRenderer> renderer);
@@ -0,0 +1,302 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiStreamingImageWriter.h"
+
+#include <vtk_png.h>
+#include <vtk_tiff.h>
+#include <vtksys/SystemTools.hxx>
+
+#include <csetjmp>
+#include <cstdio>
+
+namespace {
+
+// Classic TIFF addresses at most 4 GB.  LZW may grow incompressible data a
+// little, so images of more than 3 GB of pixels are written as BigTIFF.
+const unsigned long long maximumClassicTiffBytes = 3ULL << 30;
+
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiStreamingImageWriter::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->File = 0;
+    this->Png = 0;
+    this->PngInfo = 0;
+    this->Tiff = 0;
+    this->Width = 0;
+    this->Height = 0;
+    this->NumberOfWrittenRows = 0;
+    this->PngErrorMessage[0] = '\0';
+  }
+
+  // libpng reports errors by calling this, which must not return.
+  static void pngError(png_structp png, png_const_charp message)
+  {
+    vesInternal* self = static_cast<vesInternal*>(png_get_error_ptr(png));
+    snprintf(self->PngErrorMessage, sizeof(self->PngErrorMessage), "%s", message);
+    longjmp(png_jmpbuf(png), 1);
+  }
+
+  static void pngWarning(png_structp, png_const_charp)
+  {
+  }
+
+  // The libpng calls are kept in functions without C++ objects, which
+  // longjmp would not destroy.
+  bool pngWriteHeader()
+  {
+    if (setjmp(png_jmpbuf(this->Png))) {
+      return false;
+    }
+    png_init_io(this->Png, this->File);
+    png_set_IHDR(this->Png, this->PngInfo, this->Width, this->Height, 8,
+                 PNG_COLOR_TYPE_RGB, PNG_INTERLACE_NONE,
+                 PNG_COMPRESSION_TYPE_DEFAULT, PNG_FILTER_TYPE_DEFAULT);
+    png_write_info(this->Png, this->PngInfo);
+    return true;
+  }
+
+  bool pngWriteRows(const unsigned char* rows, int numberOfRows)
+  {
+    if (setjmp(png_jmpbuf(this->Png))) {
+      return false;
+    }
+    for (int i = 0; i < numberOfRows; ++i) {
+      png_write_row(this->Png, const_cast<png_bytep>(rows + static_cast<size_t>(i) * this->Width * 3));
+    }
+    return true;
+  }
+
+  bool pngWriteEnd()
+  {
+    if (setjmp(png_jmpbuf(this->Png))) {
+      return false;
+    }
+    png_write_end(this->Png, this->PngInfo);
+    return true;
+  }
+
+  void release()
+  {
+    if (this->Png) {
+      png_destroy_write_struct(&this->Png, &this->PngInfo);
+    }
+    if (this->File) {
+      fclose(this->File);
+    }
+    if (this->Tiff) {
+      TIFFClose(this->Tiff);
+    }
+    this->File = 0;
+    this->Png = 0;
+    this->PngInfo = 0;
+    this->Tiff = 0;
+  }
+
+  void fail(const std::string& message)
+  {
+    this->ErrorMessage = message;
+    if (this->PngErrorMessage[0]) {
+      this->ErrorMessage += std::string(": ") + this->PngErrorMessage;
+    }
+    this->release();
+    remove(this->FileName.c_str());
+  }
+
+  std::string FileName;
+  std::string ErrorMessage;
+  FILE* File;
+  png_structp Png;
+  png_infop PngInfo;
+  char PngErrorMessage[256];
+  TIFF* Tiff;
+  int Width;
+  int Height;
+  int NumberOfWrittenRows;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiStreamingImageWriter::vesKiwiStreamingImageWriter()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiStreamingImageWriter::~vesKiwiStreamingImageWriter()
+{
+  if (this->isOpen()) {
+    this->Internal->fail("the image was not closed");
+  }
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiStreamingImageWriter::open(const std::string& filename, int width, int height)
+{
+  vesInternal* internal = this->Internal;
+  internal->release();
+  internal->FileName = filename;
+  internal->ErrorMessage.clear();
+  internal->PngErrorMessage[0] = '\0';
+  internal->Width = width;
+  internal->Height = height;
+  internal->NumberOfWrittenRows = 0;
+
+  if (width < 1 || height < 1) {
+    internal->ErrorMessage = "the image is empty";
+    return false;
+  }
+
+  const std::string extension = vtksys::SystemTools::LowerCase(
+    vtksys::SystemTools::GetFilenameLastExtension(filename));
+  if (extension == ".tif" || extension == ".tiff") {
+    const bool bigTiff = static_cast<unsigned long long>(width) * height * 3 > maximumClassicTiffBytes;
+#if defined(TIFF_BIGTIFF_VERSION)
+    internal->Tiff = TIFFOpen(filename.c_str(), bigTiff ? "w8" : "w");
+#else
+    if (bigTiff) {
+      internal->ErrorMessage = "the image is too large for TIFF, write it as PNG";
+      return false;
+    }
+    internal->Tiff = TIFFOpen(filename.c_str(), "w");
+#endif
+    if (!internal->Tiff) {
+      internal->fail("could not create " + filename);
+      return false;
+    }
+    TIFFSetField(internal->Tiff, TIFFTAG_IMAGEWIDTH, width);
+    TIFFSetField(internal->Tiff, TIFFTAG_IMAGELENGTH, height);
+    TIFFSetField(internal->Tiff, TIFFTAG_BITSPERSAMPLE, 8);
+    TIFFSetField(internal->Tiff, TIFFTAG_SAMPLESPERPIXEL, 3);
+    TIFFSetField(internal->Tiff, TIFFTAG_PHOTOMETRIC, PHOTOMETRIC_RGB);
+    TIFFSetField(internal->Tiff, TIFFTAG_PLANARCONFIG, PLANARCONFIG_CONTIG);
+    TIFFSetField(internal->Tiff, TIFFTAG_ORIENTATION, ORIENTATION_TOPLEFT);
+    TIFFSetField(internal->Tiff, TIFFTAG_COMPRESSION, COMPRESSION_LZW);
+    TIFFSetField(internal->Tiff, TIFFTAG_PREDICTOR, PREDICTOR_HORIZONTAL);
+    TIFFSetField(internal->Tiff, TIFFTAG_ROWSPERSTRIP, TIFFDefaultStripSize(internal->Tiff, 0));
+    return true;
+  }
+
+  internal->File = fopen(filename.c_str(), "wb");
+  if (!internal->File) {
+    internal->fail("could not create " + filename);
+    return false;
+  }
+  internal->Png = png_create_write_struct(PNG_LIBPNG_VER_STRING, internal,
+                                          vesInternal::pngError, vesInternal::pngWarning);
+  internal->PngInfo = internal->Png ? png_create_info_struct(internal->Png) : 0;
+  if (!internal->PngInfo || !internal->pngWriteHeader()) {
+    internal->fail("could not write " + filename);
+    return false;
+  }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiStreamingImageWriter::writeRows(const unsigned char* rows, int numberOfRows)
+{
+  vesInternal* internal = this->Internal;
+  if (!this->isOpen()) {
+    return false;
+  }
+  if (internal->NumberOfWrittenRows + numberOfRows > internal->Height) {
+    internal->fail("more rows were written than the image has");
+    return false;
+  }
+
+  if (internal->Tiff) {
+    const size_t rowSize = static_cast<size_t>(internal->Width) * 3;
+    for (int i = 0; i < numberOfRows; ++i) {
+      if (TIFFWriteScanline(internal->Tiff, const_cast<unsigned char*>(rows + i * rowSize),
+                            internal->NumberOfWrittenRows + i, 0) < 0) {
+        internal->fail("could not write " + internal->FileName);
+        return false;
+      }
+    }
+  }
+  else if (!internal->pngWriteRows(rows, numberOfRows)) {
+    internal->fail("could not write " + internal->FileName);
+    return false;
+  }
+
+  internal->NumberOfWrittenRows += numberOfRows;
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiStreamingImageWriter::close()
+{
+  vesInternal* internal = this->Internal;
+  if (!this->isOpen()) {
+    return false;
+  }
+  if (internal->NumberOfWrittenRows != internal->Height) {
+    internal->fail("the image is incomplete");
+    return false;
+  }
+
+  if (internal->Png && !internal->pngWriteEnd()) {
+    internal->fail("could not write " + internal->FileName);
+    return false;
+  }
+
+  // Closing flushes what the libraries buffered.
+  bool success = true;
+  if (internal->File) {
+    png_destroy_write_struct(&internal->Png, &internal->PngInfo);
+    success = fclose(internal->File) == 0;
+    internal->File = 0;
+    internal->Png = 0;
+    internal->PngInfo = 0;
+  }
+  else {
+    success = TIFFFlush(internal->Tiff) == 1;
+    internal->release();
+  }
+
+  if (!success) {
+    internal->fail("could not write " + internal->FileName);
+  }
+  return success;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiStreamingImageWriter::isOpen() const
+{
+  return this->Internal->File || this->Internal->Tiff;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiStreamingImageWriter::numberOfWrittenRows() const
+{
+  return this->Internal->NumberOfWrittenRows;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiStreamingImageWriter::errorMessage() const
+{
+  return this->Internal->ErrorMessage;
+}
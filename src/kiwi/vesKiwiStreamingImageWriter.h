@@ -0,0 +1,72 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiStreamingImageWriter
+/// \ingroup KiwiPlatform
+/// \brief Writes an RGB image to a PNG or TIFF file a few rows at a time
+///
+/// Rows are compressed and written as they are given, so images larger than
+/// memory, such as the tiles of vesKiwiBaseApp::renderImageTile() assembled
+/// band by band, can be written.  The format follows the file extension:
+/// .tif or .tiff for TIFF with LZW compression, PNG otherwise.  TIFF images
+/// of more than 3 GB of pixels are written as BigTIFF, or rejected when the
+/// libtiff in use predates it.
+#ifndef __vesKiwiStreamingImageWriter_h
+#define __vesKiwiStreamingImageWriter_h
+
+#include <vesSetGet.h>
+
+#include <string>
+
+class vesKiwiStreamingImageWriter
+{
+public:
+
+  vesTypeMacro(vesKiwiStreamingImageWriter);
+
+  vesKiwiStreamingImageWriter();
+  ~vesKiwiStreamingImageWriter();
+
+  /// Create the file for an image of the given size.  Returns false on
+  /// failure, see errorMessage().
+  bool open(const std::string& filename, int width, int height);
+
+  /// Append rows of 8 bit RGB pixels, top row first, with no padding
+  /// between rows.
+  bool writeRows(const unsigned char* rows, int numberOfRows);
+
+  /// Finish the file.  Fails if fewer rows than the image height were
+  /// written; the incomplete file is removed.
+  bool close();
+
+  bool isOpen() const;
+  int numberOfWrittenRows() const;
+
+  std::string errorMessage() const;
+
+private:
+
+  vesKiwiStreamingImageWriter(const vesKiwiStreamingImageWriter&); // Not implemented
+  void operator=(const vesKiwiStreamingImageWriter&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -19,19 +19,13 @@
  ========================================================================*/
 
 #include "vesKiwiText2DRepresentation.h"
+#include "vesKiwiGlyphAtlas.h"
 #include "vesActor.h"
 #include "vesRenderer.h"
 #include "vesCamera.h"
-#include "vesTexture.h"
-#include "vesImage.h"
-
-#include <vtkFreeTypeStringToImage.h>
-#include <vtkTextProperty.h>
-#include <vtkSmartPointer.h>
-#include <vtkStdString.h>
-#include <vtkImageData.h>
-#include <vtkPolyData.h>
-#include <vtkNew.h>
+#include "vesMapper.h"
+#include "vesPrimitive.h"
+#include "vesSourceData.h"
 
 #include <cassert>
 
@@ -42,16 +36,27 @@ public:
 
   vesInternal()
   {
-    this->TextToImage = vtkSmartPointer<vtkFreeTypeStringToImage>::New();
+    this->FontSize = 32;
+    this->TextColor = vesVector3f(1.0, 0.8, 0.0);
+    this->DistanceFieldEnabled = false;
     this->WorldAnchorPointEnabled = false;
     this->AnchorOffset = 0.0;
+    this->TextSize = vesVector2f(0.0, 0.0);
   }
 
   ~vesInternal()
   {
   }
 
-  vtkSmartPointer<vtkFreeTypeStringToImage> TextToImage;
+  std::string Text;
+  int FontSize;
+  vesVector3f TextColor;
+  bool DistanceFieldEnabled;
+  vesVector2f TextSize;
+
+  vesKiwiGlyphAtlas::Ptr Atlas;
+  vesPrimitive::Ptr Triangles;
+  std::vector<vesVertexDataP3T3C3f> Vertices;
 
   bool WorldAnchorPointEnabled;
   double AnchorOffset;
@@ -76,21 +81,82 @@ void vesKiwiText2DRepresentation::setText(const std::string& text)
 {
   assert(this->actor());
 
-  vtkNew<vtkTextProperty> textProperty;
-  textProperty->SetFontFamilyToArial();
-  textProperty->SetFontSize(32);
-  textProperty->SetColor(1.0, 0.8, 0.0);
+  this->Internal->Text = text;
+  this->updateGeometry();
 
-  vtkNew<vtkImageData> imageTexture;
-  this->Internal->TextToImage->RenderString(textProperty.GetPointer(), text, imageTexture.GetPointer());
+  this->actor()->setIsOverlayNode(true);
+  this->setBinNumber(20);
+}
 
-  // The above call to RenderString() sets the imageTexture origin so some nonzero value, not sure why
-  imageTexture->SetOrigin(0, 0, 0);
+//----------------------------------------------------------------------------
+const std::string& vesKiwiText2DRepresentation::text() const
+{
+  return this->Internal->Text;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::setFontSize(int fontSize)
+{
+  this->Internal->FontSize = fontSize;
+  if (this->geometryData()) {
+    this->updateGeometry();
+  }
+}
 
-  this->setImageData(imageTexture.GetPointer());
+//----------------------------------------------------------------------------
+int vesKiwiText2DRepresentation::fontSize() const
+{
+  return this->Internal->FontSize;
+}
 
-  this->actor()->setIsOverlayNode(true);
-  this->setBinNumber(20);
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::setTextColor(const vesVector3f& color)
+{
+  this->Internal->TextColor = color;
+  if (this->geometryData()) {
+    this->updateGeometry();
+  }
+}
+
+//----------------------------------------------------------------------------
+vesVector3f vesKiwiText2DRepresentation::textColor() const
+{
+  return this->Internal->TextColor;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::setDistanceFieldEnabled(bool enabled)
+{
+  this->Internal->DistanceFieldEnabled = enabled;
+  if (this->geometryData()) {
+    this->updateGeometry();
+  }
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiText2DRepresentation::distanceFieldEnabled() const
+{
+  return this->Internal->DistanceFieldEnabled;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiText2DRepresentation::updateGeometry()
+{
+  vesInternal* internal = this->Internal;
+  if (!internal->Atlas || internal->Atlas->distanceField() != internal->DistanceFieldEnabled) {
+    internal->Atlas = vesKiwiGlyphAtlas::shared(internal->DistanceFieldEnabled);
+    this->setTexture(internal->Atlas->texture());
+    this->setShaderProgram(internal->Atlas->shaderProgram());
+  }
+
+  // Only the vertices of the quads are uploaded when the text changes.
+  const float scale = static_cast<float>(internal->FontSize) / internal->Atlas->fontSize();
+  internal->Vertices.clear();
+  internal->Atlas->appendText(internal->Text, vesVector2f(0.0, 0.0),
+                              internal->TextColor, scale, internal->Vertices);
+  internal->TextSize = internal->Atlas->textSize(internal->Text, scale);
+  this->mapper()->setGeometryData(
+    vesKiwiGlyphAtlas::createGeometry(internal->Vertices, internal->Triangles));
 }
 
 //----------------------------------------------------------------------------
@@ -142,16 +208,22 @@ vesVector2f vesKiwiText2DRepresentation::displayPosition() const
   return this->Internal->DisplayPosition;
 }
 
+//----------------------------------------------------------------------------
+vesVector2f vesKiwiText2DRepresentation::textSize() const
+{
+  return this->Internal->TextSize;
+}
+
 //----------------------------------------------------------------------------
 int vesKiwiText2DRepresentation::textWidth()
 {
-  return this->texture()->image()->width();
+  return static_cast<int>(this->Internal->TextSize[0] + 0.5f);
 }
 
 //----------------------------------------------------------------------------
 void vesKiwiText2DRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
 {
-  if (!this->Internal->WorldAnchorPointEnabled || !this->texture()) {
+  if (!this->Internal->WorldAnchorPointEnabled || !this->geometryData()) {
     return;
   }
 
@@ -161,7 +233,7 @@ void vesKiwiText2DRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
   anchorOffset *= this->Internal->AnchorOffset;
   vesVector3f worldPoint = this->Internal->WorldAnchorPoint - anchorOffset;
   vesVector3f displayPoint = renderer->computeWorldToDisplay(worldPoint);
-  displayPoint[0] -= this->texture()->image()->width() / 2.0;
+  displayPoint[0] -= this->Internal->TextSize[0] / 2.0;
 
   this->setDisplayPosition(vesVector2f(displayPoint[0], displayPoint[1]));
 }
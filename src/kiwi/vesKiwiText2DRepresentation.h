@@ -19,15 +19,19 @@
  ========================================================================*/
 /// \class vesKiwiText2DRepresentation
 /// \ingroup KiwiPlatform
+/// \brief Text overlay drawn from the shared vesKiwiGlyphAtlas
+///
+/// setText() only lays out quads for the characters, so text that changes
+/// every frame, like a time or frame rate display, costs a small vertex
+/// upload.  See vesKiwiTextLabelsRepresentation to draw many labels at once.
 #ifndef __vesKiwiText2DRepresentation_h
 #define __vesKiwiText2DRepresentation_h
 
-#include "vesKiwiImagePlaneDataRepresentation.h"
+#include "vesKiwiPolyDataRepresentation.h"
 
+#include <string>
 
-class vtkImageData;
-
-class vesKiwiText2DRepresentation : public vesKiwiImagePlaneDataRepresentation
+class vesKiwiText2DRepresentation : public vesKiwiPolyDataRepresentation
 {
 public:
 
@@ -37,6 +41,21 @@ public:
   ~vesKiwiText2DRepresentation();
 
   void setText(const std::string& text);
+  const std::string& text() const;
+
+  /// Height of the text in pixels, 32 by default.  The text is rescaled
+  /// from the atlas, so changing the size does not rasterize the font again.
+  void setFontSize(int fontSize);
+  int fontSize() const;
+
+  void setTextColor(const vesVector3f& color);
+  vesVector3f textColor() const;
+
+  /// Use the distance field glyphs, for text drawn larger than the atlas
+  /// font.  This replaces the texture and shader program of the
+  /// representation with those of the other atlas.
+  void setDistanceFieldEnabled(bool enabled);
+  bool distanceFieldEnabled() const;
 
   virtual void willRender(vesSharedPtr<vesRenderer> renderer);
 
@@ -52,7 +71,10 @@ public:
   void setDisplayPosition(vesVector2f displayPosition);
   vesVector2f displayPosition() const;
 
-  /// Return the width of the texture used by this text annotation.
+  /// Return the size of the text in pixels.
+  vesVector2f textSize() const;
+
+  /// Return the width of the text in pixels.
   int textWidth();
 
 private:
@@ -60,6 +82,7 @@ private:
   vesKiwiText2DRepresentation(const vesKiwiText2DRepresentation&); // Not implemented
   void operator=(const vesKiwiText2DRepresentation&); // Not implemented
 
+  void updateGeometry();
 
   class vesInternal;
   vesInternal* Internal;
@@ -0,0 +1,286 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiTextLabelsRepresentation.h"
+#include "vesKiwiGlyphAtlas.h"
+
+#include "vesActor.h"
+#include "vesBlend.h"
+#include "vesCamera.h"
+#include "vesMapper.h"
+#include "vesMaterial.h"
+#include "vesPrimitive.h"
+#include "vesRenderer.h"
+#include "vesShaderProgram.h"
+#include "vesSourceData.h"
+#include "vesTexture.h"
+
+#include <cassert>
+#include <vector>
+
+//----------------------------------------------------------------------------
+class vesKiwiTextLabelsRepresentation::vesInternal
+{
+public:
+
+  struct Label
+  {
+    Label()
+    {
+      this->Color = vesVector3f(1.0, 0.8, 0.0);
+      this->IsVisible = true;
+      this->HasWorldAnchorPoint = false;
+      this->AnchorOffset = 0.0;
+      this->DisplayPosition = vesVector2f(0.0, 0.0);
+    }
+
+    std::string Text;
+    vesVector3f Color;
+    bool IsVisible;
+    bool HasWorldAnchorPoint;
+    vesVector3f WorldAnchorPoint;
+    double AnchorOffset;
+    vesVector2f DisplayPosition;
+  };
+
+  vesInternal()
+  {
+    this->FontSize = 32;
+    this->DistanceFieldEnabled = false;
+    this->IsDirty = true;
+  }
+
+  ~vesInternal()
+  {
+  }
+
+  Label& label(int index)
+  {
+    assert(index >= 0 && index < static_cast<int>(this->Labels.size()));
+    this->IsDirty = true;
+    return this->Labels[index];
+  }
+
+  void updateGeometry();
+
+  std::vector<Label> Labels;
+  int FontSize;
+  bool DistanceFieldEnabled;
+  bool IsDirty;
+
+  vesKiwiGlyphAtlas::Ptr Atlas;
+  vesPrimitive::Ptr Triangles;
+  std::vector<vesVertexDataP3T3C3f> Vertices;
+
+  vesActor::Ptr Actor;
+  vesMapper::Ptr Mapper;
+  vesMaterial::Ptr Material;
+};
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::vesInternal::updateGeometry()
+{
+  if (!this->Atlas || this->Atlas->distanceField() != this->DistanceFieldEnabled) {
+    this->Atlas = vesKiwiGlyphAtlas::shared(this->DistanceFieldEnabled);
+    this->Material->addAttribute(this->Atlas->texture());
+    this->Material->addAttribute(this->Atlas->shaderProgram());
+  }
+
+  const float scale = static_cast<float>(this->FontSize) / this->Atlas->fontSize();
+  this->Vertices.clear();
+  for (size_t i = 0; i < this->Labels.size(); ++i) {
+    const Label& label = this->Labels[i];
+    if (label.IsVisible) {
+      this->Atlas->appendText(label.Text, label.DisplayPosition, label.Color,
+                              scale, this->Vertices);
+    }
+  }
+
+  this->Mapper->setGeometryData(
+    vesKiwiGlyphAtlas::createGeometry(this->Vertices, this->Triangles));
+  this->IsDirty = false;
+}
+
+//----------------------------------------------------------------------------
+vesKiwiTextLabelsRepresentation::vesKiwiTextLabelsRepresentation()
+{
+  this->Internal = new vesInternal();
+  this->Internal->Mapper = vesMapper::Ptr(new vesMapper());
+  this->Internal->Material = vesMaterial::Ptr(new vesMaterial());
+  this->Internal->Material->addAttribute(vesBlend::Ptr(new vesBlend()));
+  this->Internal->Material->setBinNumber(vesMaterial::Overlay);
+  this->Internal->Actor = vesActor::Ptr(new vesActor());
+  this->Internal->Actor->setMapper(this->Internal->Mapper);
+  this->Internal->Actor->setMaterial(this->Internal->Material);
+  this->Internal->Actor->setIsOverlayNode(true);
+  this->Internal->updateGeometry();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiTextLabelsRepresentation::~vesKiwiTextLabelsRepresentation()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiTextLabelsRepresentation::addLabel(const std::string& text)
+{
+  this->Internal->Labels.push_back(vesInternal::Label());
+  this->Internal->Labels.back().Text = text;
+  this->Internal->IsDirty = true;
+  return static_cast<int>(this->Internal->Labels.size()) - 1;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiTextLabelsRepresentation::numberOfLabels() const
+{
+  return static_cast<int>(this->Internal->Labels.size());
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::removeAllLabels()
+{
+  this->Internal->Labels.clear();
+  this->Internal->IsDirty = true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setLabelText(int index, const std::string& text)
+{
+  this->Internal->label(index).Text = text;
+}
+
+//----------------------------------------------------------------------------
+const std::string& vesKiwiTextLabelsRepresentation::labelText(int index) const
+{
+  assert(index >= 0 && index < this->numberOfLabels());
+  return this->Internal->Labels[index].Text;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setLabelColor(int index, const vesVector3f& color)
+{
+  this->Internal->label(index).Color = color;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setLabelVisible(int index, bool visible)
+{
+  this->Internal->label(index).IsVisible = visible;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setLabelDisplayPosition(
+  int index, const vesVector2f& displayPosition)
+{
+  vesInternal::Label& label = this->Internal->label(index);
+  label.DisplayPosition = displayPosition;
+  label.HasWorldAnchorPoint = false;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setLabelWorldAnchorPoint(
+  int index, const vesVector3f& worldPoint, double anchorOffset)
+{
+  vesInternal::Label& label = this->Internal->label(index);
+  label.WorldAnchorPoint = worldPoint;
+  label.AnchorOffset = anchorOffset;
+  label.HasWorldAnchorPoint = true;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setFontSize(int fontSize)
+{
+  this->Internal->FontSize = fontSize;
+  this->Internal->IsDirty = true;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiTextLabelsRepresentation::fontSize() const
+{
+  return this->Internal->FontSize;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::setDistanceFieldEnabled(bool enabled)
+{
+  this->Internal->DistanceFieldEnabled = enabled;
+  this->Internal->IsDirty = true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiTextLabelsRepresentation::distanceFieldEnabled() const
+{
+  return this->Internal->DistanceFieldEnabled;
+}
+
+//----------------------------------------------------------------------------
+vesSharedPtr<vesActor> vesKiwiTextLabelsRepresentation::actor() const
+{
+  return this->Internal->Actor;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::addSelfToRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  renderer->addActor(this->Internal->Actor);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::removeSelfFromRenderer(
+  vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+  renderer->removeActor(this->Internal->Actor);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiTextLabelsRepresentation::willRender(vesSharedPtr<vesRenderer> renderer)
+{
+  assert(renderer);
+
+  vesVector3f viewUp = renderer->camera()->viewUp();
+  viewUp.normalize();
+  const float scale = this->Internal->Atlas
+    ? static_cast<float>(this->Internal->FontSize) / this->Internal->Atlas->fontSize() : 1.0f;
+
+  for (size_t i = 0; i < this->Internal->Labels.size(); ++i) {
+    vesInternal::Label& label = this->Internal->Labels[i];
+    if (!label.HasWorldAnchorPoint || !label.IsVisible) {
+      continue;
+    }
+
+    const vesVector3f worldPoint = label.WorldAnchorPoint - viewUp * static_cast<float>(label.AnchorOffset);
+    const vesVector3f displayPoint = renderer->computeWorldToDisplay(worldPoint);
+    const float width = this->Internal->Atlas
+      ? this->Internal->Atlas->textSize(label.Text, scale)[0] : 0.0f;
+    const vesVector2f displayPosition(displayPoint[0] - width / 2.0f, displayPoint[1]);
+    if (displayPosition != label.DisplayPosition) {
+      label.DisplayPosition = displayPosition;
+      this->Internal->IsDirty = true;
+    }
+  }
+
+  if (this->Internal->IsDirty) {
+    this->Internal->updateGeometry();
+  }
+}
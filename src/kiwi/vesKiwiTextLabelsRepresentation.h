@@ -0,0 +1,93 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiTextLabelsRepresentation
+/// \ingroup KiwiPlatform
+/// \brief Draws many text labels with a single actor.
+///
+/// The characters of all labels are quads of one geometry textured from the
+/// shared vesKiwiGlyphAtlas, so the labels are drawn in one draw call and
+/// changing a label only uploads vertices.  Labels are placed at display
+/// positions or follow points in the world.
+#ifndef __vesKiwiTextLabelsRepresentation_h
+#define __vesKiwiTextLabelsRepresentation_h
+
+#include "vesKiwiDataRepresentation.h"
+
+#include <string>
+
+class vesActor;
+class vesRenderer;
+
+class vesKiwiTextLabelsRepresentation : public vesKiwiDataRepresentation
+{
+public:
+
+  vesTypeMacro(vesKiwiTextLabelsRepresentation);
+
+  vesKiwiTextLabelsRepresentation();
+  ~vesKiwiTextLabelsRepresentation();
+
+  /// Add a label at the lower left corner of the display and return its
+  /// index.
+  int addLabel(const std::string& text);
+  int numberOfLabels() const;
+  void removeAllLabels();
+
+  void setLabelText(int index, const std::string& text);
+  const std::string& labelText(int index) const;
+
+  void setLabelColor(int index, const vesVector3f& color);
+  void setLabelVisible(int index, bool visible);
+
+  /// Place the lower left corner of the label at a display position.
+  void setLabelDisplayPosition(int index, const vesVector2f& displayPosition);
+
+  /// Center the label above a world point, moved down by \p anchorOffset
+  /// along the view up of the camera.  The display position follows the
+  /// point in willRender().
+  void setLabelWorldAnchorPoint(int index, const vesVector3f& worldPoint,
+                                double anchorOffset = 0.0);
+
+  /// Font height in pixels shared by all labels, 32 by default.  World
+  /// anchored labels are centered using this size.
+  void setFontSize(int fontSize);
+  int fontSize() const;
+
+  /// Switch every label to the distance field glyphs, which keep edges
+  /// sharp when labels are zoomed.
+  void setDistanceFieldEnabled(bool enabled);
+  bool distanceFieldEnabled() const;
+
+  vesSharedPtr<vesActor> actor() const;
+
+  virtual void addSelfToRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void removeSelfFromRenderer(vesSharedPtr<vesRenderer> renderer);
+  virtual void willRender(vesSharedPtr<vesRenderer> renderer);
+
+private:
+
+  vesKiwiTextLabelsRepresentation(const vesKiwiTextLabelsRepresentation&); // Not implemented
+  void operator=(const vesKiwiTextLabelsRepresentation&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
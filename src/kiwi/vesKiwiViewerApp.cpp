@@ -19,18 +19,22 @@
  ========================================================================*/
 
 #include "vesKiwiViewerApp.h"
+#include "vesKiwiCameraInteractor.h"
 #include "vesKiwiCameraSpinner.h"
 #include "vesKiwiDataConversionTools.h"
 #include "vesKiwiDataLoader.h"
 #include "vesKiwiDataRepresentation.h"
+#include "vesKiwiGlyphRepresentation.h"
 #include "vesKiwiImagePlaneDataRepresentation.h"
 #include "vesKiwiImageWidgetRepresentation.h"
 #include "vesKiwiAnimationRepresentation.h"
 #include "vesKiwiBrainAtlasRepresentation.h"
 #include "vesKiwiText2DRepresentation.h"
 #include "vesKiwiPlaneWidget.h"
+#include "vesKiwiPointCloudRepresentation.h"
 #include "vesKiwiPolyDataRepresentation.h"
 #include "vesKiwiSceneRepresentation.h"
+#include "vesKiwiShaderVariantCache.h"
 #include "vesKiwiWidgetInteractionDelegate.h"
 
 #include "vesBackground.h"
@@ -63,10 +67,13 @@
 #endif
 
 
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
 #include <vtkNew.h>
 #include <vtkPolyData.h>
 #include <vtkImageData.h>
 #include <vtkPointData.h>
+#include <vtkTimerLog.h>
 #include <vtkTransform.h>
 #include <vtkMatrix4x4.h>
 
@@ -81,6 +88,56 @@
 
 using std::tr1::dynamic_pointer_cast;
 
+//----------------------------------------------------------------------------
+namespace {
+
+struct BackgroundImageTask
+{
+  BackgroundImageTask()
+  {
+    this->ThreadId = -1;
+    this->IsDone = false;
+    this->IsCancelled = false;
+  }
+
+  int ThreadId;
+  bool IsDone;
+  bool IsCancelled;
+  std::string FileName;
+  vesKiwiDataLoader DataLoader;
+  vesImage::Ptr Image;
+  vtkNew<vtkMutexLock> Lock;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE LoadBackgroundImage(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  BackgroundImageTask* task = static_cast<BackgroundImageTask*>(threadInfo->UserData);
+
+  vesImage::Ptr image;
+  vtkSmartPointer<vtkImageData> vtkimage = vtkImageData::SafeDownCast(task->DataLoader.loadDataset(task->FileName));
+
+  // Release the archive the image may have been read from as soon as possible.
+  task->DataLoader.clearMemoryFiles();
+
+  // The reader cannot be interrupted, but a cancelled image is not converted.
+  task->Lock->Lock();
+  const bool isCancelled = task->IsCancelled;
+  task->Lock->Unlock();
+  if (vtkimage && !isCancelled) {
+    image = vesKiwiDataConversionTools::ConvertImage(vtkimage);
+  }
+
+  task->Lock->Lock();
+  task->Image = image;
+  task->IsDone = true;
+  task->Lock->Unlock();
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
 //----------------------------------------------------------------------------
 class vesKiwiViewerApp::vesInternal
 {
@@ -90,17 +147,40 @@ public:
   {
     this->IsAnimating = false;
     this->CameraRotationInertiaIsEnabled = true;
+    this->StaticBatchingIsEnabled = false;
+    this->LevelOfDetailIsEnabled = true;
+    this->InteractiveLevelOfDetailBias = 1;
     this->CameraSpinner = vesKiwiCameraSpinner::Ptr(new vesKiwiCameraSpinner);
+    this->ShaderVariantCache = vesKiwiShaderVariantCache::Ptr(new vesKiwiShaderVariantCache);
   }
 
   ~vesInternal()
   {
+    this->cancelBackgroundImageTask();
     this->DataRepresentations.clear();
     this->BuiltinDatasetNames.clear();
     this->BuiltinDatasetFilenames.clear();
     this->BuiltinShadingModels.clear();
   }
 
+  void finishBackgroundImageTask()
+  {
+    if (this->BackgroundTask.ThreadId >= 0) {
+      this->MultiThreader->TerminateThread(this->BackgroundTask.ThreadId);
+      this->BackgroundTask.ThreadId = -1;
+    }
+  }
+
+  void cancelBackgroundImageTask()
+  {
+    if (this->BackgroundTask.ThreadId >= 0) {
+      this->BackgroundTask.Lock->Lock();
+      this->BackgroundTask.IsCancelled = true;
+      this->BackgroundTask.Lock->Unlock();
+    }
+    this->finishBackgroundImageTask();
+  }
+
   struct vesShaderProgramData
   {
     vesShaderProgramData(
@@ -132,6 +212,9 @@ public:
 
   bool IsAnimating;
   bool CameraRotationInertiaIsEnabled;
+  bool StaticBatchingIsEnabled;
+  bool LevelOfDetailIsEnabled;
+  int InteractiveLevelOfDetailBias;
   std::string ErrorTitle;
   std::string ErrorMessage;
 
@@ -142,12 +225,17 @@ public:
   vesSharedPtr<vesShaderProgram> WireframeShader;
   vesSharedPtr<vesShaderProgram> SurfaceWithEdgesShader;
   vesSharedPtr<vesUniform> ClipUniform;
+  vesKiwiShaderVariantCache::Ptr ShaderVariantCache;
 
   std::vector<vesKiwiDataRepresentation::Ptr> DataRepresentations;
+  std::vector<vesKiwiPointCloudRepresentation::Ptr> PointClouds;
 
   vesKiwiCameraSpinner::Ptr CameraSpinner;
   vesKiwiDataLoader DataLoader;
 
+  vtkNew<vtkMultiThreader> MultiThreader;
+  BackgroundImageTask BackgroundTask;
+
   std::vector<std::string> BuiltinDatasetNames;
   std::vector<std::string> BuiltinDatasetFilenames;
   std::vector<vesCameraParameters> BuiltinDatasetCameraParameters;
@@ -191,30 +279,27 @@ vesKiwiViewerApp::vesKiwiViewerApp()
   this->addBuiltinDataset("KiwiViewer Logo", "kiwi.png");
 
 
-  this->initBlinnPhongShader(
-    vesBuiltinShaders::vesBlinnPhong_vert(),
-    vesBuiltinShaders::vesBlinnPhong_frag());
+  // The lit surface programs are variants of the uber shader, shared with the
+  // representations that pick their own variant from the cache.
+  vesKiwiShaderVariantCache::Ptr variants = this->Internal->ShaderVariantCache;
+  this->addBuiltinShadingModel("BlinnPhong",
+    variants->program(vesKiwiShaderVariantCache::BlinnPhong));
   this->initToonShader(
     vesBuiltinShaders::vesToonShader_vert(),
     vesBuiltinShaders::vesToonShader_frag());
-  this->initGouraudShader(
-    vesBuiltinShaders::vesShader_vert(),
-    vesBuiltinShaders::vesShader_frag());
-  this->initGouraudTextureShader(
-    vesBuiltinShaders::vesGouraudTexture_vert(),
-    vesBuiltinShaders::vesGouraudTexture_frag());
-  this->initWireframeShader(
-    vesBuiltinShaders::vesWireframeShader_vert(),
-    vesBuiltinShaders::vesWireframeShader_frag());
-  this->initSurfaceWithEdgesShader(
-    vesBuiltinShaders::vesWireframeShader_vert(),
-    vesBuiltinShaders::vesWireframeShader_frag());
+  this->Internal->ShaderProgram = variants->program(0);
+  this->addBuiltinShadingModel("Gouraud", this->Internal->ShaderProgram);
+  this->Internal->GouraudTextureShader = variants->program(vesKiwiShaderVariantCache::Texture);
+  this->addBuiltinShadingModel("GouraudTexture", this->Internal->GouraudTextureShader);
+  this->Internal->WireframeShader = variants->program(vesKiwiShaderVariantCache::Wireframe);
+  this->addBuiltinShadingModel("Wireframe", this->Internal->WireframeShader);
+  this->Internal->SurfaceWithEdgesShader = variants->program(vesKiwiShaderVariantCache::SurfaceWithEdges);
+  this->addBuiltinShadingModel("SurfaceWithEdges", this->Internal->SurfaceWithEdgesShader);
   this->initTextureShader(
     vesBuiltinShaders::vesBackgroundTexture_vert(),
     vesBuiltinShaders::vesBackgroundTexture_frag());
-  this->initClipShader(
-    vesBuiltinShaders::vesClipPlane_vert(),
-    vesBuiltinShaders::vesClipPlane_frag());
+  this->Internal->ClipShader = variants->program(vesKiwiShaderVariantCache::ClipPlane);
+  this->Internal->ClipUniform = variants->clipPlaneUniform();
 }
 
 //----------------------------------------------------------------------------
@@ -269,9 +354,8 @@ bool vesKiwiViewerApp::loadPVWebDataSet(vesSharedPtr<vesPVWebDataSet> dataset)
   vesGeometryData::Ptr geometryData = vesKiwiDataConversionTools::ConvertPVWebData(dataset);
   vesKiwiPolyDataRepresentation::Ptr rep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation());
   rep->initializeWithShader(this->shaderProgram());
-  rep->setWireframeShader(this->Internal->WireframeShader);
-  rep->setSurfaceWithEdgesShader(this->Internal->SurfaceWithEdgesShader);
   rep->mapper()->setGeometryData(geometryData);
+  rep->setShaderVariantCache(this->Internal->ShaderVariantCache);
   rep->assignColorsInternal();
   if (dataset->m_transparency) {
     rep->setOpacity(0.4);
@@ -415,6 +499,8 @@ std::string vesKiwiViewerApp::downloadFile(const std::string& url, const std::st
 {
 #ifdef VES_USE_CURL
   vesKiwiCurlDownloader downloader;
+  downloader.setNumberOfConnections(4);
+  downloader.setResumeEnabled(true);
   std::string result = downloader.downloadUrlToDirectory(url, downloadDir);
   if (!result.size()) {
     this->setErrorMessage(downloader.errorTitle(), downloader.errorMessage());
@@ -439,6 +525,12 @@ vesSharedPtr<vesShaderProgram> vesKiwiViewerApp::shaderProgram()
   return this->Internal->ShaderProgram;
 }
 
+//----------------------------------------------------------------------------
+vesSharedPtr<vesKiwiShaderVariantCache> vesKiwiViewerApp::shaderVariantCache() const
+{
+  return this->Internal->ShaderVariantCache;
+}
+
 //----------------------------------------------------------------------------
 const std::vector<vesKiwiDataRepresentation::Ptr>& vesKiwiViewerApp::dataRepresentations() const
 {
@@ -512,7 +604,17 @@ void vesKiwiViewerApp::addBuiltinShadingModel(
 //----------------------------------------------------------------------------
 bool vesKiwiViewerApp::isAnimating() const
 {
-  return this->Internal->IsAnimating;
+  // Keep rendering until a full detail frame follows the camera motion, and
+  // until the point cloud nodes needed by the current view are loaded.
+  if (this->Internal->IsAnimating || this->renderer()->levelOfDetailBias() != 0) {
+    return true;
+  }
+  for (size_t i = 0; i < this->Internal->PointClouds.size(); ++i) {
+    if (this->Internal->PointClouds[i]->isLoading()) {
+      return true;
+    }
+  }
+  return false;
 }
 
 //----------------------------------------------------------------------------
@@ -524,9 +626,28 @@ void vesKiwiViewerApp::setAnimating(bool animating)
 //----------------------------------------------------------------------------
 void vesKiwiViewerApp::willRender()
 {
+  BackgroundImageTask& task = this->Internal->BackgroundTask;
+  if (task.ThreadId >= 0) {
+    task.Lock->Lock();
+    const bool isDone = task.IsDone;
+    task.Lock->Unlock();
+
+    if (isDone) {
+      this->finishLoadingBackgroundTexture();
+    }
+  }
+
   for (size_t i = 0; i < this->Internal->DataRepresentations.size(); ++i) {
     this->Internal->DataRepresentations[i]->willRender(this->renderer());
   }
+
+  // Draw coarser levels of detail while the camera is moving.
+  const double motionTimeout = 0.2;
+  const bool cameraIsMoving = this->Internal->CameraSpinner->isEnabled()
+    || vtkTimerLog::GetUniversalTime() - this->cameraInteractor()->lastMotionTime() < motionTimeout;
+  this->renderer()->setLevelOfDetailBias(
+    cameraIsMoving ? this->Internal->InteractiveLevelOfDetailBias : 0);
+
   this->Internal->CameraSpinner->updateSpin();
 }
 
@@ -811,6 +932,7 @@ bool vesKiwiViewerApp::initClipShader(const std::string& vertexSource, const std
 //----------------------------------------------------------------------------
 void vesKiwiViewerApp::resetScene()
 {
+  this->cancelLoadingBackgroundTexture();
   this->resetErrorMessage();
   this->removeAllDataRepresentations();
   this->setDefaultBackgroundColor();
@@ -827,6 +949,7 @@ void vesKiwiViewerApp::removeAllDataRepresentations()
     this->Internal->DataRepresentations[i]->removeSelfFromRenderer(this->renderer());
   }
   this->Internal->DataRepresentations.clear();
+  this->Internal->PointClouds.clear();
 }
 
 //----------------------------------------------------------------------------
@@ -871,9 +994,20 @@ vesKiwiPolyDataRepresentation::Ptr vesKiwiViewerApp::addPolyDataRepresentation(
 {
   vesKiwiPolyDataRepresentation::Ptr rep = vesKiwiPolyDataRepresentation::Ptr(new vesKiwiPolyDataRepresentation());
   rep->initializeWithShader(program);
-  rep->setWireframeShader(this->Internal->WireframeShader);
-  rep->setSurfaceWithEdgesShader(this->Internal->SurfaceWithEdgesShader);
+  if (program == this->Internal->ShaderProgram
+      || program == this->Internal->GouraudTextureShader) {
+    // Builtin programs, let the representation pick the variant that matches
+    // its geometry and color mode.
+    rep->setShaderVariantCache(this->Internal->ShaderVariantCache);
+  }
+  else {
+    rep->setWireframeShader(this->Internal->WireframeShader);
+    rep->setSurfaceWithEdgesShader(this->Internal->SurfaceWithEdgesShader);
+  }
   rep->setPolyData(polyData);
+  if (this->Internal->LevelOfDetailIsEnabled) {
+    rep->generateLevelsOfDetail();
+  }
   rep->addSelfToRenderer(this->renderer());
   this->Internal->DataRepresentations.push_back(rep);
   return rep;
@@ -903,6 +1037,8 @@ vesKiwiPlaneWidget::Ptr vesKiwiViewerApp::addPlaneWidget()
 //----------------------------------------------------------------------------
 void vesKiwiViewerApp::setBackgroundTexture(const std::string& filename)
 {
+  this->cancelLoadingBackgroundTexture();
+
   vtkSmartPointer<vtkImageData> vtkimage = vtkImageData::SafeDownCast(this->Internal->DataLoader.loadDataset(filename));
   if (vtkimage) {
     vesImage::Ptr image = vesKiwiDataConversionTools::ConvertImage(vtkimage);
@@ -912,6 +1048,53 @@ void vesKiwiViewerApp::setBackgroundTexture(const std::string& filename)
   }
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::loadBackgroundTexture(const std::string& filename)
+{
+  this->cancelLoadingBackgroundTexture();
+
+  // The thread reads with its own loader, the app's loader may be used for
+  // datasets meanwhile.  The copied memory files keep the archive they come
+  // from alive until the thread has read the image.
+  BackgroundImageTask& task = this->Internal->BackgroundTask;
+  task.FileName = filename;
+  task.DataLoader.copySettings(this->Internal->DataLoader);
+  task.IsDone = false;
+  task.IsCancelled = false;
+  task.ThreadId = this->Internal->MultiThreader->SpawnThread(LoadBackgroundImage, &task);
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiViewerApp::isLoadingBackgroundTexture() const
+{
+  return this->Internal->BackgroundTask.ThreadId >= 0;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::finishLoadingBackgroundTexture()
+{
+  BackgroundImageTask& task = this->Internal->BackgroundTask;
+  if (task.ThreadId < 0) {
+    return;
+  }
+
+  this->Internal->finishBackgroundImageTask();
+  if (task.Image) {
+    this->renderer()->background()->setImage(task.Image);
+  }
+  task.Image.reset();
+  task.DataLoader.clearMemoryFiles();
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::cancelLoadingBackgroundTexture()
+{
+  BackgroundImageTask& task = this->Internal->BackgroundTask;
+  this->Internal->cancelBackgroundImageTask();
+  task.Image.reset();
+  task.DataLoader.clearMemoryFiles();
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiViewerApp::setDefaultBackgroundColor()
 {
@@ -952,6 +1135,50 @@ bool vesKiwiViewerApp::loadBrainAtlas(const std::string& filename)
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vesKiwiViewerApp::loadMolecule(const std::string& filename)
+{
+  // Load the atoms as points and draw the same sphere at each of them,
+  // instead of letting the loader copy the sphere mesh to every atom.
+  const bool expandGlyphs = this->Internal->DataLoader.isExpandMoleculeGlyphs();
+  this->Internal->DataLoader.setExpandMoleculeGlyphs(false);
+  vtkSmartPointer<vtkPolyData> molecule = vtkPolyData::SafeDownCast(this->Internal->DataLoader.loadDataset(filename));
+  this->Internal->DataLoader.setExpandMoleculeGlyphs(expandGlyphs);
+  if (!molecule) {
+    this->handleLoadDatasetError();
+    return false;
+  }
+
+  if (molecule->GetNumberOfLines()) {
+    this->addPolyDataRepresentation(molecule, this->shaderProgram());
+  }
+
+  vesKiwiGlyphRepresentation::Ptr atoms = vesKiwiGlyphRepresentation::Ptr(new vesKiwiGlyphRepresentation());
+  atoms->initializeWithShader(this->Internal->ShaderVariantCache->program(vesKiwiShaderVariantCache::Instanced));
+  atoms->setGlyph(vesKiwiDataLoader::moleculeAtomGlyph());
+  atoms->setDataSet(molecule, std::string(), vesKiwiDataLoader::moleculeAtomScaleFactor());
+  atoms->addSelfToRenderer(this->renderer());
+  this->Internal->DataRepresentations.push_back(atoms);
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiViewerApp::loadPointCloud(const std::string& filename)
+{
+  vesKiwiPointCloudRepresentation::Ptr rep(new vesKiwiPointCloudRepresentation());
+  rep->initializeWithShader(this->shaderProgram());
+  if (!rep->loadOctree(filename)) {
+    this->setErrorMessage("Error loading data", rep->errorMessage());
+    return false;
+  }
+
+  rep->addSelfToRenderer(this->renderer());
+  this->Internal->DataRepresentations.push_back(rep);
+  this->Internal->PointClouds.push_back(rep);
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool vesKiwiViewerApp::loadTexturedMesh(const std::string& meshFile, const std::string& imageFile)
 {
@@ -980,6 +1207,7 @@ bool vesKiwiViewerApp::loadTexturedMesh(const std::string& meshFile, const std::
   vesTexture::Ptr texture = vesTexture::Ptr(new vesTexture());
   vesKiwiDataConversionTools::SetTextureData(pixels, texture, width, height);
   rep->setTexture(texture);
+  rep->colorByTexture();
 
   return true;
 }
@@ -995,6 +1223,8 @@ bool vesKiwiViewerApp::loadKiwiScene(const std::string& sceneFile)
       this->Internal->GouraudTextureShader,
       this->Internal->TextureShader,
       this->Internal->ClipShader);
+  rep->setShaderVariantCache(this->Internal->ShaderVariantCache);
+  rep->setStaticBatchingIsEnabled(this->Internal->StaticBatchingIsEnabled);
 
   bool result = rep->loadScene(sceneFile, &this->Internal->DataLoader);
 
@@ -1023,7 +1253,7 @@ bool vesKiwiViewerApp::loadKiwiScene(const std::string& sceneFile)
       this->renderer()->background()->setGradientColor(rep->backgroundColor(), rep->backgroundColor2());
     }
     else {
-      this->setBackgroundTexture(rep->backgroundImage());
+      this->loadBackgroundTexture(rep->backgroundImage());
     }
   }
 
@@ -1036,9 +1266,12 @@ bool vesKiwiViewerApp::loadArchive(const std::string& archiveFile)
   std::string baseDir = vtksys::SystemTools::GetFilenamePath(archiveFile);
 
 #ifdef VES_USE_LIBARCHIVE
-  vesKiwiArchiveUtils archiveLoader;
+  // Loaders that copy the memory files, like the ones of streamed series and
+  // background images, keep the archive alive after this method returns.
+  vesSharedPtr<vesKiwiArchiveUtils> archive(new vesKiwiArchiveUtils());
+  vesKiwiArchiveUtils& archiveLoader = *archive;
 
-  bool result = archiveLoader.extractArchive(archiveFile, baseDir);
+  bool result = archiveLoader.readArchive(archiveFile, baseDir);
   if (!result) {
     this->setErrorMessage(archiveLoader.errorTitle(), archiveLoader.errorMessage());
     return false;
@@ -1046,22 +1279,57 @@ bool vesKiwiViewerApp::loadArchive(const std::string& archiveFile)
 
   const std::vector<std::string>& entries = archiveLoader.entries();
 
-  //printf("have %lu extracted entries\n", entries.size());
+  // The brain atlas reads its model list from disk, so it still needs the
+  // whole archive to be written out.
+  bool extractAll = false;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    if (vtksys::SystemTools::GetFilenameName(entries[i]) == "spl_pnl_brain_atlas.kiwi") {
+      extractAll = true;
+    }
+  }
+
+  // Hand entries that can be parsed from memory to the data loader and only
+  // write the remaining ones to disk.
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const char* data;
+    size_t length;
+    archiveLoader.entryData(entries[i], data, length);
+
+    if (!extractAll
+        && (vesKiwiDataLoader::canLoadFromMemory(entries[i], length)
+            || vtksys::SystemTools::GetFilenameLastExtension(entries[i]) == ".kiwi")) {
+      this->Internal->DataLoader.addMemoryFile(entries[i], data, length, archive);
+    }
+    else if (!archiveLoader.writeEntry(entries[i])) {
+      this->setErrorMessage(archiveLoader.errorTitle(), archiveLoader.errorMessage());
+      this->Internal->DataLoader.clearMemoryFiles();
+      return false;
+    }
+  }
 
   // load .kiwi file if it exists
+  bool loadedScene = false;
   for (size_t i = 0; i < entries.size(); ++i) {
-    //printf("extracted entry:  %s\n", entries[i].c_str());
     if (vtksys::SystemTools::GetFilenameLastExtension(entries[i]) == ".kiwi") {
-      return this->loadDataset(entries[i]);
+      result = this->loadDataset(entries[i]);
+      loadedScene = true;
+      break;
     }
   }
 
-  // try to load all entries that are not directories
-  for (size_t i = 0; i < entries.size(); ++i) {
-    if (!vtksys::SystemTools::FileIsDirectory(entries[i].c_str())) {
+  // try to load all entries
+  if (!loadedScene) {
+    for (size_t i = 0; i < entries.size(); ++i) {
       this->loadDataset(entries[i]);
     }
   }
+
+  // the archive buffers are released once no loader refers to them
+  this->Internal->DataLoader.clearMemoryFiles();
+
+  if (loadedScene) {
+    return result;
+  }
 #else
   this->setErrorMessage("Unsupported", "Kiwi not built with libarchive support.");
 #endif // VES_USE_LIBARCHIVE
@@ -1081,6 +1349,12 @@ bool vesKiwiViewerApp::loadDatasetWithCustomBehavior(const std::string& filename
   else if (vtksys::SystemTools::GetFilenameLastExtension(filename) == ".pvwebgl") {
     return loadPVWebDataSet(filename);
   }
+  else if (vtksys::SystemTools::GetFilenameLastExtension(filename) == ".pdb") {
+    return loadMolecule(filename);
+  }
+  else if (vtksys::SystemTools::GetFilenameLastExtension(filename) == ".vpc") {
+    return loadPointCloud(filename);
+  }
   else if (vtksys::SystemTools::GetFilenameLastExtension(filename) == ".zip"
            || vtksys::SystemTools::GetFilenameLastExtension(filename) == ".gz"
            || vtksys::SystemTools::GetFilenameLastExtension(filename) == ".tgz"
@@ -1159,6 +1433,42 @@ bool vesKiwiViewerApp::cameraRotationInertiaIsEnabled() const
   return this->Internal->CameraRotationInertiaIsEnabled;
 }
 
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::setStaticBatchingIsEnabled(bool enabled)
+{
+  this->Internal->StaticBatchingIsEnabled = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiViewerApp::staticBatchingIsEnabled() const
+{
+  return this->Internal->StaticBatchingIsEnabled;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::setLevelOfDetailIsEnabled(bool enabled)
+{
+  this->Internal->LevelOfDetailIsEnabled = enabled;
+}
+
+//----------------------------------------------------------------------------
+bool vesKiwiViewerApp::levelOfDetailIsEnabled() const
+{
+  return this->Internal->LevelOfDetailIsEnabled;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiViewerApp::setInteractiveLevelOfDetailBias(int bias)
+{
+  this->Internal->InteractiveLevelOfDetailBias = bias;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiViewerApp::interactiveLevelOfDetailBias() const
+{
+  return this->Internal->InteractiveLevelOfDetailBias;
+}
+
 //----------------------------------------------------------------------------
 void vesKiwiViewerApp::haltCameraRotationInertia()
 {
@@ -38,6 +38,7 @@ class vesKiwiDataRepresentation;
 class vesKiwiPolyDataRepresentation;
 class vesKiwiText2DRepresentation;
 class vesKiwiPlaneWidget;
+class vesKiwiShaderVariantCache;
 class vesKiwiPVRemoteRepresentation;
 class vesRenderer;
 class vesShaderProgram;
@@ -103,6 +104,21 @@ public:
   bool isAnimating() const;
   void setBackgroundTexture(const std::string& filename);
 
+  /// Read and decode a background image on a separate thread.  The image
+  /// replaces the background in the first willRender() after it is decoded,
+  /// unless the scene is reset or another background texture is set first.
+  /// An image inside an archive stays readable after loadArchive() returns.
+  void loadBackgroundTexture(const std::string& filename);
+  bool isLoadingBackgroundTexture() const;
+
+  /// Wait for the image started by loadBackgroundTexture() and show it.
+  void finishLoadingBackgroundTexture();
+
+  /// Discard the image started by loadBackgroundTexture().  A file being
+  /// read is still read to the end, which this waits for, but it is not
+  /// converted to a texture.
+  void cancelLoadingBackgroundTexture();
+
   virtual void handleSingleTouchPanGesture(double deltaX, double deltaY);
   virtual void handleSingleTouchDown(int displayX, int displayY);
   virtual void handleSingleTouchTap(int displayX, int displayY);
@@ -126,6 +142,9 @@ public:
   const vesSharedPtr<vesShaderProgram> shaderProgram() const;
   vesSharedPtr<vesShaderProgram> shaderProgram();
 
+  /// The uber shader variants shared by all representations of the app.
+  vesSharedPtr<vesKiwiShaderVariantCache> shaderVariantCache() const;
+
   /// Override superclass method in order to stop the camera spinner if needed.
   using Superclass::resetView;
   virtual void resetView();
@@ -135,6 +154,22 @@ public:
   void setCameraRotationInertiaIsEnabled(bool enabled);
   bool cameraRotationInertiaIsEnabled() const;
 
+  /// Set/Get whether or not kiwi scenes merge their static objects into a few
+  /// draw batches when they are loaded.  Off by default.
+  void setStaticBatchingIsEnabled(bool enabled);
+  bool staticBatchingIsEnabled() const;
+
+  /// Set/Get whether or not large meshes get coarser levels of detail,
+  /// simplified in the background after loading.  On by default.
+  void setLevelOfDetailIsEnabled(bool enabled);
+  bool levelOfDetailIsEnabled() const;
+
+  /// Set/Get how many levels coarser than their screen size meshes are drawn
+  /// while the camera moves, 1 by default.  The last frame after the motion
+  /// stops is drawn at full detail again.
+  void setInteractiveLevelOfDetailBias(int bias);
+  int interactiveLevelOfDetailBias() const;
+
   /// Halt camera rotation inertia if the camera is currently rotating.
   void haltCameraRotationInertia();
 
@@ -171,6 +206,8 @@ protected:
   vesSharedPtr<vesKiwiText2DRepresentation> addTextRepresentation(const std::string& text);
   vesSharedPtr<vesKiwiPlaneWidget> addPlaneWidget();
   bool loadBrainAtlas(const std::string& filename);
+  bool loadMolecule(const std::string& filename);
+  bool loadPointCloud(const std::string& filename);
   bool loadKiwiScene(const std::string& filename);
   bool loadArchive(const std::string& filename);
   bool loadTexturedMesh(const std::string& meshFile, const std::string& imageFile);
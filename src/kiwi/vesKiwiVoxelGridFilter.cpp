@@ -0,0 +1,500 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesKiwiVoxelGridFilter.h"
+
+#include "vesGeometryData.h"
+
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace {
+
+//----------------------------------------------------------------------------
+struct vesVoxel
+{
+  double Sum[3];
+  unsigned int ColorSum[4];
+  unsigned int Count;
+};
+
+// Voxel coordinates are packed into 21 bits each.
+const unsigned long long MaximumVoxelCoordinate = (1 << 21) - 1;
+const unsigned long long InvalidKey = ~0ULL;
+
+//----------------------------------------------------------------------------
+inline unsigned long long hashKey(unsigned long long key)
+{
+  key ^= key >> 33;
+  key *= 0xff51afd7ed558ccdULL;
+  key ^= key >> 33;
+  key *= 0xc4ceb9fe1a85ec53ULL;
+  key ^= key >> 33;
+  return key;
+}
+
+//----------------------------------------------------------------------------
+// Shared state of the threads.  Each pass splits the work differently: the
+// bounds and keys are computed over chunks of points, while the voxels are
+// accumulated by every thread over all points, each keeping the voxels whose
+// hash falls into its partition.
+struct vesVoxelGridTask
+{
+  enum Pass
+  {
+    ComputeBounds,
+    ComputeKeys,
+    Accumulate
+  };
+
+  Pass CurrentPass;
+  int NumberOfThreads;
+  size_t NumberOfPoints;
+
+  const unsigned char* Positions;
+  size_t PositionStride;
+  const unsigned char* Colors;
+  size_t ColorStride;
+  bool IsFloatColor;
+  int NumberOfColorComponents;
+
+  vesVector3f Origin;
+  vesVector3f InverseLeafSize;
+
+  std::vector<vesVector3f> Minimums;
+  std::vector<vesVector3f> Maximums;
+  std::vector<unsigned long long> Keys;
+  std::vector<std::vector<vesVoxel> > Voxels;
+
+  inline const float* position(size_t i) const
+  {
+    return reinterpret_cast<const float*>(this->Positions + i * this->PositionStride);
+  }
+
+  inline void addColor(vesVoxel& voxel, size_t i) const
+  {
+    const unsigned char* color = this->Colors + i * this->ColorStride;
+    for (int j = 0; j < 4; ++j) {
+      unsigned int value = 255;
+      if (j < this->NumberOfColorComponents) {
+        if (this->IsFloatColor) {
+          float component;
+          memcpy(&component, color + j * sizeof(float), sizeof(float));
+          value = static_cast<unsigned int>(std::max(0.0f, std::min(component, 1.0f)) * 255.0f + 0.5f);
+        }
+        else {
+          value = color[j];
+        }
+      }
+      voxel.ColorSum[j] += value;
+    }
+  }
+
+  void computeBounds(int thread)
+  {
+    const size_t begin = this->NumberOfPoints * thread / this->NumberOfThreads;
+    const size_t end = this->NumberOfPoints * (thread + 1) / this->NumberOfThreads;
+
+    vesVector3f minimum = vesVector3f::Constant(std::numeric_limits<float>::max());
+    vesVector3f maximum = -minimum;
+    for (size_t i = begin; i < end; ++i) {
+      const float* point = this->position(i);
+      for (int j = 0; j < 3; ++j) {
+        // comparisons with NaN are false, so invalid points are skipped
+        if (point[j] < minimum[j]) {
+          minimum[j] = point[j];
+        }
+        if (point[j] > maximum[j]) {
+          maximum[j] = point[j];
+        }
+      }
+    }
+    this->Minimums[thread] = minimum;
+    this->Maximums[thread] = maximum;
+  }
+
+  void computeKeys(int thread)
+  {
+    const size_t begin = this->NumberOfPoints * thread / this->NumberOfThreads;
+    const size_t end = this->NumberOfPoints * (thread + 1) / this->NumberOfThreads;
+
+    for (size_t i = begin; i < end; ++i) {
+      const float* point = this->position(i);
+      unsigned long long key = 0;
+      for (int j = 0; j < 3; ++j) {
+        const float coordinate = (point[j] - this->Origin[j]) * this->InverseLeafSize[j];
+        if (!(coordinate >= 0.0f && coordinate <= MaximumVoxelCoordinate)) {
+          key = InvalidKey;
+          break;
+        }
+        key |= static_cast<unsigned long long>(coordinate) << (21 * j);
+      }
+      this->Keys[i] = key;
+    }
+  }
+
+  void accumulate(int thread)
+  {
+    std::vector<vesVoxel>& voxels = this->Voxels[thread];
+    voxels.clear();
+
+    // Open addressing table from voxel key to index in voxels.
+    size_t mask = 1023;
+    std::vector<unsigned long long> slotKeys(mask + 1, InvalidKey);
+    std::vector<unsigned int> slotVoxels(mask + 1);
+
+    for (size_t i = 0; i < this->NumberOfPoints; ++i) {
+      const unsigned long long key = this->Keys[i];
+      if (key == InvalidKey) {
+        continue;
+      }
+      const unsigned long long hash = hashKey(key);
+      if (static_cast<int>((hash >> 40) % this->NumberOfThreads) != thread) {
+        continue;
+      }
+
+      size_t slot = hash & mask;
+      while (slotKeys[slot] != key && slotKeys[slot] != InvalidKey) {
+        slot = (slot + 1) & mask;
+      }
+
+      if (slotKeys[slot] == InvalidKey) {
+        slotKeys[slot] = key;
+        slotVoxels[slot] = static_cast<unsigned int>(voxels.size());
+        vesVoxel voxel;
+        memset(&voxel, 0, sizeof(voxel));
+        voxels.push_back(voxel);
+
+        // Keep the table at most half full.
+        if (2 * voxels.size() > mask) {
+          std::vector<unsigned long long> oldKeys;
+          std::vector<unsigned int> oldVoxels;
+          oldKeys.swap(slotKeys);
+          oldVoxels.swap(slotVoxels);
+          mask = 2 * mask + 1;
+          slotKeys.assign(mask + 1, InvalidKey);
+          slotVoxels.resize(mask + 1);
+          for (size_t j = 0; j < oldKeys.size(); ++j) {
+            if (oldKeys[j] == InvalidKey) {
+              continue;
+            }
+            size_t newSlot = hashKey(oldKeys[j]) & mask;
+            while (slotKeys[newSlot] != InvalidKey) {
+              newSlot = (newSlot + 1) & mask;
+            }
+            slotKeys[newSlot] = oldKeys[j];
+            slotVoxels[newSlot] = oldVoxels[j];
+          }
+          slot = hash & mask;
+          while (slotKeys[slot] != key) {
+            slot = (slot + 1) & mask;
+          }
+        }
+      }
+
+      vesVoxel& voxel = voxels[slotVoxels[slot]];
+      const float* point = this->position(i);
+      voxel.Sum[0] += point[0];
+      voxel.Sum[1] += point[1];
+      voxel.Sum[2] += point[2];
+      if (this->Colors) {
+        this->addColor(voxel, i);
+      }
+      ++voxel.Count;
+    }
+  }
+
+  void run(int thread)
+  {
+    switch (this->CurrentPass) {
+      case ComputeBounds:
+        this->computeBounds(thread);
+        break;
+      case ComputeKeys:
+        this->computeKeys(thread);
+        break;
+      case Accumulate:
+        this->accumulate(thread);
+        break;
+    }
+  }
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE RunPass(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  vesVoxelGridTask* task = static_cast<vesVoxelGridTask*>(threadInfo->UserData);
+  task->run(threadInfo->ThreadID);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vesKiwiVoxelGridFilter::vesInternal
+{
+public:
+
+  vesInternal()
+  {
+    this->LeafSize = vesVector3f::Constant(0.01f);
+    this->UsedLeafSize = this->LeafSize;
+    this->MaximumNumberOfPoints = 0;
+    this->NumberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+  }
+
+  void runPass(vesVoxelGridTask& task, vesVoxelGridTask::Pass pass)
+  {
+    task.CurrentPass = pass;
+    this->MultiThreader->SetNumberOfThreads(task.NumberOfThreads);
+    this->MultiThreader->SetSingleMethod(RunPass, &task);
+    this->MultiThreader->SingleMethodExecute();
+  }
+
+  vesVector3f LeafSize;
+  vesVector3f UsedLeafSize;
+  unsigned int MaximumNumberOfPoints;
+  int NumberOfThreads;
+  std::string ErrorMessage;
+
+  vtkNew<vtkMultiThreader> MultiThreader;
+};
+
+//----------------------------------------------------------------------------
+vesKiwiVoxelGridFilter::vesKiwiVoxelGridFilter()
+{
+  this->Internal = new vesInternal();
+}
+
+//----------------------------------------------------------------------------
+vesKiwiVoxelGridFilter::~vesKiwiVoxelGridFilter()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVoxelGridFilter::setLeafSize(float size)
+{
+  this->Internal->LeafSize = vesVector3f::Constant(size);
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVoxelGridFilter::setLeafSize(const vesVector3f& size)
+{
+  this->Internal->LeafSize = size;
+}
+
+//----------------------------------------------------------------------------
+const vesVector3f& vesKiwiVoxelGridFilter::leafSize() const
+{
+  return this->Internal->LeafSize;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVoxelGridFilter::setMaximumNumberOfPoints(unsigned int numberOfPoints)
+{
+  this->Internal->MaximumNumberOfPoints = numberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+unsigned int vesKiwiVoxelGridFilter::maximumNumberOfPoints() const
+{
+  return this->Internal->MaximumNumberOfPoints;
+}
+
+//----------------------------------------------------------------------------
+void vesKiwiVoxelGridFilter::setNumberOfThreads(int numberOfThreads)
+{
+  this->Internal->NumberOfThreads = numberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+int vesKiwiVoxelGridFilter::numberOfThreads() const
+{
+  return this->Internal->NumberOfThreads;
+}
+
+//----------------------------------------------------------------------------
+vesVector3f vesKiwiVoxelGridFilter::usedLeafSize() const
+{
+  return this->Internal->UsedLeafSize;
+}
+
+//----------------------------------------------------------------------------
+std::string vesKiwiVoxelGridFilter::errorMessage() const
+{
+  return this->Internal->ErrorMessage;
+}
+
+//----------------------------------------------------------------------------
+vesGeometryData::Ptr vesKiwiVoxelGridFilter::filter(vesGeometryData::Ptr input)
+{
+  this->Internal->ErrorMessage.clear();
+  this->Internal->UsedLeafSize = this->Internal->LeafSize;
+
+  const vesSourceData::Ptr positions =
+    input ? input->sourceData(vesVertexAttributeKeys::Position) : vesSourceData::Ptr();
+  if (!positions
+      || positions->attributeDataType(vesVertexAttributeKeys::Position) != vesDataType::Float
+      || positions->numberOfComponents(vesVertexAttributeKeys::Position) < 3) {
+    this->Internal->ErrorMessage = "The input has no float positions";
+    return vesGeometryData::Ptr();
+  }
+  if (!(this->Internal->LeafSize.minCoeff() > 0.0f)) {
+    this->Internal->ErrorMessage = "The leaf size must be positive";
+    return vesGeometryData::Ptr();
+  }
+
+  vesVoxelGridTask task;
+  task.NumberOfPoints = positions->sizeOfArray();
+  task.NumberOfThreads = static_cast<int>(std::max(size_t(1), std::min(
+    static_cast<size_t>(std::max(this->Internal->NumberOfThreads, 1)), task.NumberOfPoints / 16384)));
+  task.Positions = static_cast<const unsigned char*>(positions->data())
+    + positions->attributeOffset(vesVertexAttributeKeys::Position);
+  task.PositionStride = positions->attributeStride(vesVertexAttributeKeys::Position);
+  task.Colors = 0;
+  task.ColorStride = 0;
+  task.IsFloatColor = false;
+  task.NumberOfColorComponents = 0;
+
+  const vesSourceData::Ptr colors = input->sourceData(vesVertexAttributeKeys::Color);
+  if (colors && colors->sizeOfArray() == task.NumberOfPoints) {
+    const unsigned int type = colors->attributeDataType(vesVertexAttributeKeys::Color);
+    if (type == vesDataType::Float || type == vesDataType::UnsignedByte) {
+      task.Colors = static_cast<const unsigned char*>(colors->data())
+        + colors->attributeOffset(vesVertexAttributeKeys::Color);
+      task.ColorStride = colors->attributeStride(vesVertexAttributeKeys::Color);
+      task.IsFloatColor = type == vesDataType::Float;
+      task.NumberOfColorComponents =
+        std::min(4u, colors->numberOfComponents(vesVertexAttributeKeys::Color));
+    }
+  }
+
+  vesVector3f minimum = vesVector3f::Zero();
+  vesVector3f maximum = vesVector3f::Zero();
+  if (task.NumberOfPoints) {
+    task.Minimums.resize(task.NumberOfThreads);
+    task.Maximums.resize(task.NumberOfThreads);
+    this->Internal->runPass(task, vesVoxelGridTask::ComputeBounds);
+    minimum = task.Minimums[0];
+    maximum = task.Maximums[0];
+    for (int i = 1; i < task.NumberOfThreads; ++i) {
+      minimum = minimum.cwiseMin(task.Minimums[i]);
+      maximum = maximum.cwiseMax(task.Maximums[i]);
+    }
+  }
+  task.Origin = minimum;
+  task.Keys.resize(task.NumberOfPoints);
+  task.Voxels.resize(task.NumberOfThreads);
+
+  // When the points have to be reduced to fit, start near the leaf size of
+  // a surface spanning the bounds with that many points, so that inputs with
+  // a leaf size much finer than their spacing converge in a few iterations.
+  vesVector3f leafSize = this->Internal->LeafSize;
+  const unsigned int maximumNumberOfPoints = this->Internal->MaximumNumberOfPoints;
+  if (maximumNumberOfPoints && task.NumberOfPoints > maximumNumberOfPoints) {
+    const float surfaceLeafSize = 0.5f * (maximum - minimum).maxCoeff() / sqrt(static_cast<float>(maximumNumberOfPoints));
+    leafSize = leafSize.cwiseMax(vesVector3f::Constant(surfaceLeafSize));
+  }
+
+  size_t numberOfVoxels = 0;
+  while (task.NumberOfPoints) {
+    const vesVector3f extent = (maximum - minimum).cwiseMax(vesVector3f::Zero());
+    const vesVector3f dimensions = extent.cwiseQuotient(leafSize);
+    if (!(dimensions.maxCoeff() < MaximumVoxelCoordinate)) {
+      this->Internal->ErrorMessage = "The leaf size is too small for the bounds of the points";
+      return vesGeometryData::Ptr();
+    }
+
+    task.InverseLeafSize = leafSize.cwiseInverse();
+    this->Internal->runPass(task, vesVoxelGridTask::ComputeKeys);
+    this->Internal->runPass(task, vesVoxelGridTask::Accumulate);
+
+    numberOfVoxels = 0;
+    for (int i = 0; i < task.NumberOfThreads; ++i) {
+      numberOfVoxels += task.Voxels[i].size();
+    }
+
+    if (!maximumNumberOfPoints || numberOfVoxels <= maximumNumberOfPoints) {
+      break;
+    }
+
+    // Point clouds are mostly scanned surfaces, where the number of voxels
+    // goes with the inverse square of the leaf size.  Growing by at least 10%
+    // always ends with a budget met: once a voxel spans the bounds, all
+    // points fall into one.
+    leafSize *= static_cast<float>(
+      std::max(1.1, sqrt(static_cast<double>(numberOfVoxels) / maximumNumberOfPoints)));
+  }
+  this->Internal->UsedLeafSize = leafSize;
+
+  vesGeometryData::Ptr output(new vesGeometryData());
+  output->setName("PointCloud");
+
+  if (task.Colors) {
+    vesSourceDataP3C4ub::Ptr sourceData(new vesSourceDataP3C4ub());
+    std::vector<vesVertexDataP3C4ub>& vertices = sourceData->arrayReference();
+    vertices.resize(numberOfVoxels);
+    size_t index = 0;
+    for (int i = 0; i < task.NumberOfThreads; ++i) {
+      for (size_t j = 0; j < task.Voxels[i].size(); ++j, ++index) {
+        const vesVoxel& voxel = task.Voxels[i][j];
+        const double scale = 1.0 / voxel.Count;
+        vertices[index].m_position = vesVector3f(static_cast<float>(voxel.Sum[0] * scale),
+                                                 static_cast<float>(voxel.Sum[1] * scale),
+                                                 static_cast<float>(voxel.Sum[2] * scale));
+        for (int k = 0; k < 4; ++k) {
+          vertices[index].m_color[k] =
+            static_cast<unsigned char>((voxel.ColorSum[k] + voxel.Count / 2) / voxel.Count);
+        }
+      }
+    }
+    output->addSource(sourceData);
+  }
+  else {
+    vesSourceDataP3f::Ptr sourceData(new vesSourceDataP3f());
+    std::vector<vesVertexDataP3f>& vertices = sourceData->arrayReference();
+    vertices.resize(numberOfVoxels);
+    size_t index = 0;
+    for (int i = 0; i < task.NumberOfThreads; ++i) {
+      for (size_t j = 0; j < task.Voxels[i].size(); ++j, ++index) {
+        const vesVoxel& voxel = task.Voxels[i][j];
+        const double scale = 1.0 / voxel.Count;
+        vertices[index].m_position = vesVector3f(static_cast<float>(voxel.Sum[0] * scale),
+                                                 static_cast<float>(voxel.Sum[1] * scale),
+                                                 static_cast<float>(voxel.Sum[2] * scale));
+      }
+    }
+    output->addSource(sourceData);
+  }
+
+  vesPrimitive::Ptr pointPrimitive(new vesPrimitive());
+  pointPrimitive->setPrimitiveType(vesPrimitiveRenderType::Points);
+  pointPrimitive->setIndexCount(1);
+  output->addPrimitive(pointPrimitive);
+  return output;
+}
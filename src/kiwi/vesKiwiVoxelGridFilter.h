@@ -0,0 +1,93 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesKiwiVoxelGridFilter
+/// \ingroup KiwiPlatform
+/// \brief Downsamples point geometry to one point per voxel of a grid.
+///
+/// Every output point is the centroid of the input points that fall into a
+/// voxel, with their average color.  This is the same result as
+/// vtkPCLVoxelGrid, computed directly on the vertex arrays of a
+/// vesGeometryData.  The positions and colors are read through the attribute
+/// layout of the sources, so vesSourceDataP3f with or without a color source,
+/// and interleaved layouts like vesSourceDataP3C4ub, are all accepted.
+///
+/// Voxels are found with a hash table keyed by the voxel coordinates.  The
+/// work is split over threads by voxel hash, so no two threads accumulate
+/// into the same voxel.
+///
+/// When a maximum number of points is set, the leaf size is grown until the
+/// output fits, which lets callers keep a cloud within a point budget without
+/// knowing its density.
+#ifndef __vesKiwiVoxelGridFilter_h
+#define __vesKiwiVoxelGridFilter_h
+
+#include "vesSetGet.h"
+#include "vesMath.h"
+
+#include <string>
+
+class vesGeometryData;
+
+class vesKiwiVoxelGridFilter
+{
+public:
+
+  vesTypeMacro(vesKiwiVoxelGridFilter);
+
+  vesKiwiVoxelGridFilter();
+  ~vesKiwiVoxelGridFilter();
+
+  /// Set/Get the size of a voxel, 0.01 along each axis by default.
+  void setLeafSize(float size);
+  void setLeafSize(const vesVector3f& size);
+  const vesVector3f& leafSize() const;
+
+  /// Set/Get the maximum number of output points, 0 for no limit.  When the
+  /// leaf size produces more points, it is scaled up until the output fits.
+  void setMaximumNumberOfPoints(unsigned int numberOfPoints);
+  unsigned int maximumNumberOfPoints() const;
+
+  /// Set/Get the number of threads.  The default is the VTK global default
+  /// number of threads, which is the number of cores.
+  void setNumberOfThreads(int numberOfThreads);
+  int numberOfThreads() const;
+
+  /// Return the downsampled points of \p input as a new geometry with a
+  /// points primitive, or a null pointer on error.  The positions are stored
+  /// in a vesSourceDataP3C4ub if the input has colors, otherwise in a
+  /// vesSourceDataP3f.
+  vesSharedPtr<vesGeometryData> filter(vesSharedPtr<vesGeometryData> input);
+
+  /// The leaf size used by the last filter(), which is larger than
+  /// leafSize() if the maximum number of points forced it.
+  vesVector3f usedLeafSize() const;
+
+  std::string errorMessage() const;
+
+private:
+
+  vesKiwiVoxelGridFilter(const vesKiwiVoxelGridFilter&); // Not implemented
+  void operator=(const vesKiwiVoxelGridFilter&); // Not implemented
+
+  class vesInternal;
+  vesInternal* Internal;
+};
+
+#endif
@@ -20,6 +20,7 @@
 
 #include "vesMidasClient.h"
 #include "vesKiwiCurlDownloader.h"
+#include "vesKiwiJSONReader.h"
 
 #include <stdio.h>
 #include <iostream>
@@ -27,10 +28,19 @@
 #include <cstring>
 #include <cstdlib>
 #include <cassert>
+#include <cctype>
+#include <deque>
+#include <set>
 
 #include <curl/curl.h>
 #include <cJSON.h>
 
+#include <vtkConditionVariable.h>
+#include <vtkMultiThreader.h>
+#include <vtkMutexLock.h>
+#include <vtkNew.h>
+#include <vtkTimerLog.h>
+
 namespace {
 
 jsonSharedPtr makeShared(cJSON* json)
@@ -79,6 +89,294 @@ size_t write_data(char *buffer, size_t size, size_t nmemb, void *userData)
   return totalSize;
 }
 
+size_t etag_header_function(char *buffer, size_t size, size_t nmemb, void *userData)
+{
+  size_t totalSize = size*nmemb;
+  std::string header(buffer, totalSize);
+  std::string name = header.substr(0, 5);
+  for (size_t i = 0; i < name.size(); ++i) {
+    name[i] = tolower(name[i]);
+  }
+
+  if (name == "etag:") {
+    size_t start = header.find_first_not_of(" \t", 5);
+    size_t end = header.find_last_not_of(" \t\r\n");
+    if (start != std::string::npos && end != std::string::npos && end >= start) {
+      *static_cast<std::string*>(userData) = header.substr(start, end - start + 1);
+    }
+  }
+  return totalSize;
+}
+
+// Reads the stat, message and the span of the data member of a Midas
+// response without decoding the data itself.
+bool parseResponse(const std::string& response, std::string& stat, std::string& message,
+                   const char*& data, size_t& dataLength)
+{
+  vesKiwiJSONReader reader(response.c_str(), response.size());
+  data = 0;
+  dataLength = 0;
+
+  reader.beginObject();
+  while (reader.hasNext()) {
+    std::string name = reader.nextName();
+    if (name == "stat" && reader.peek() == vesKiwiJSONReader::String) {
+      stat = reader.nextString();
+    }
+    else if (name == "message" && reader.peek() == vesKiwiJSONReader::String) {
+      message = reader.nextString();
+    }
+    else if (name == "data") {
+      reader.nextRawValue(data, dataLength);
+    }
+    else {
+      reader.skipValue();
+    }
+  }
+  reader.endObject();
+
+  return !reader.hasError();
+}
+
+bool isOkResponse(const std::string& response)
+{
+  std::string stat, message;
+  const char* data;
+  size_t dataLength;
+  return parseResponse(response, stat, message, data, dataLength) && stat == "ok";
+}
+
+// Midas encodes most numbers as strings, accept either.
+std::string readStringValue(vesKiwiJSONReader& reader)
+{
+  if (reader.peek() == vesKiwiJSONReader::String) {
+    return reader.nextString();
+  }
+  else if (reader.peek() == vesKiwiJSONReader::Number) {
+    std::stringstream str;
+    str.precision(15);
+    str << reader.nextDouble();
+    return str.str();
+  }
+  reader.skipValue();
+  return std::string();
+}
+
+// Reads the named string members of an object, in any order.
+void readMembers(vesKiwiJSONReader& reader, const char* name1, std::string& value1,
+                 const char* name2 = 0, std::string* value2 = 0,
+                 const char* name3 = 0, std::string* value3 = 0)
+{
+  reader.beginObject();
+  while (reader.hasNext()) {
+    std::string name = reader.nextName();
+    if (name == name1) {
+      value1 = readStringValue(reader);
+    }
+    else if (name2 && name == name2) {
+      *value2 = readStringValue(reader);
+    }
+    else if (name3 && name == name3) {
+      *value3 = readStringValue(reader);
+    }
+    else {
+      reader.skipValue();
+    }
+  }
+  reader.endObject();
+}
+
+}
+
+//----------------------------------------------------------------------------
+class vesMidasClient::vesInternal
+{
+public:
+
+  struct CacheEntry
+  {
+    std::string Response;
+    std::string ETag;
+    double Time;
+  };
+
+  struct Transfer
+  {
+    std::string Key;
+    std::string Url;
+    std::string PostArgs;
+    std::string ETag;
+    std::stringstream Response;
+    CURL* Handle;
+  };
+
+  vesInternal()
+  {
+    this->TimeToLive = 300;
+    this->PrefetchEnabled = true;
+    this->MaximumConcurrentRequests = 4;
+    this->ThreadId = -1;
+    this->ShouldQuit = false;
+  }
+
+  // Returns true if a response is cached.  isFresh is set if it is still
+  // within its time to live.  Must be called with the lock held.
+  bool lookup(const std::string& key, CacheEntry& entry, bool& isFresh)
+  {
+    std::map<std::string, CacheEntry>::const_iterator itr = this->Cache.find(key);
+    if (itr == this->Cache.end()) {
+      return false;
+    }
+
+    entry = itr->second;
+    isFresh = vtkTimerLog::GetUniversalTime() - entry.Time < this->TimeToLive;
+    return true;
+  }
+
+  // Must be called with the lock held.
+  void store(const std::string& key, const std::string& response, const std::string& etag)
+  {
+    CacheEntry& entry = this->Cache[key];
+    entry.Response = response;
+    entry.ETag = etag;
+    entry.Time = vtkTimerLog::GetUniversalTime();
+  }
+
+  // Must be called with the lock held.
+  bool isQueued(const std::string& key) const
+  {
+    if (this->InFlight.count(key)) {
+      return true;
+    }
+    for (size_t i = 0; i < this->Pending.size(); ++i) {
+      if (this->Pending[i]->Key == key) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+  void startTransfer(CURLM* multi, Transfer* transfer)
+  {
+    transfer->Handle = curl_easy_init();
+    curl_easy_setopt(transfer->Handle, CURLOPT_URL, transfer->Url.c_str());
+    curl_easy_setopt(transfer->Handle, CURLOPT_WRITEFUNCTION, write_data);
+    curl_easy_setopt(transfer->Handle, CURLOPT_WRITEDATA, &transfer->Response);
+    curl_easy_setopt(transfer->Handle, CURLOPT_HEADERFUNCTION, etag_header_function);
+    curl_easy_setopt(transfer->Handle, CURLOPT_HEADERDATA, &transfer->ETag);
+    curl_easy_setopt(transfer->Handle, CURLOPT_COPYPOSTFIELDS, transfer->PostArgs.c_str());
+    curl_easy_setopt(transfer->Handle, CURLOPT_CONNECTTIMEOUT, 30);
+    curl_multi_add_handle(multi, transfer->Handle);
+  }
+
+  void finishTransfer(CURLM* multi, Transfer* transfer, bool success)
+  {
+    std::string response = transfer->Response.str();
+    if (success && isOkResponse(response)) {
+      this->store(transfer->Key, response, transfer->ETag);
+    }
+
+    this->InFlight.erase(transfer->Key);
+    curl_multi_remove_handle(multi, transfer->Handle);
+    curl_easy_cleanup(transfer->Handle);
+    delete transfer;
+  }
+
+  double TimeToLive;
+  bool PrefetchEnabled;
+  int MaximumConcurrentRequests;
+
+  std::map<std::string, CacheEntry> Cache;
+  std::deque<Transfer*> Pending;
+  std::set<std::string> InFlight;
+
+  int ThreadId;
+  bool ShouldQuit;
+  vtkNew<vtkMultiThreader> MultiThreader;
+  vtkNew<vtkMutexLock> Lock;
+  vtkNew<vtkConditionVariable> Condition;
+};
+
+namespace {
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE PrefetchLoop(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+
+  vesMidasClient::vesInternal* selfInternal =
+    static_cast<vesMidasClient::vesInternal*>(threadInfo->UserData);
+
+  typedef vesMidasClient::vesInternal::Transfer Transfer;
+  std::map<CURL*, Transfer*> active;
+  CURLM* multi = curl_multi_init();
+
+  while (true) {
+
+    selfInternal->Lock->Lock();
+    while (!selfInternal->ShouldQuit && active.empty() && selfInternal->Pending.empty()) {
+      selfInternal->Condition->Wait(selfInternal->Lock.GetPointer());
+    }
+
+    if (selfInternal->ShouldQuit) {
+      selfInternal->Lock->Unlock();
+      break;
+    }
+
+    while (!selfInternal->Pending.empty()
+           && static_cast<int>(active.size()) < selfInternal->MaximumConcurrentRequests) {
+      Transfer* transfer = selfInternal->Pending.front();
+      selfInternal->Pending.pop_front();
+      selfInternal->InFlight.insert(transfer->Key);
+      selfInternal->startTransfer(multi, transfer);
+      active[transfer->Handle] = transfer;
+    }
+    selfInternal->Lock->Unlock();
+
+    int stillRunning = 0;
+    curl_multi_perform(multi, &stillRunning);
+
+    if (stillRunning) {
+      fd_set readSet, writeSet, errorSet;
+      FD_ZERO(&readSet);
+      FD_ZERO(&writeSet);
+      FD_ZERO(&errorSet);
+      int maxFd = -1;
+      curl_multi_fdset(multi, &readSet, &writeSet, &errorSet, &maxFd);
+
+      struct timeval timeout;
+      timeout.tv_sec = 0;
+      timeout.tv_usec = 100000;
+      select(maxFd + 1, &readSet, &writeSet, &errorSet, &timeout);
+      curl_multi_perform(multi, &stillRunning);
+    }
+
+    CURLMsg* message;
+    int messagesLeft;
+    selfInternal->Lock->Lock();
+    while ((message = curl_multi_info_read(multi, &messagesLeft))) {
+      if (message->msg == CURLMSG_DONE) {
+        CURL* handle = message->easy_handle;
+        bool success = message->data.result == CURLE_OK;
+        selfInternal->finishTransfer(multi, active[handle], success);
+        active.erase(handle);
+      }
+    }
+    selfInternal->Condition->Broadcast();
+    selfInternal->Lock->Unlock();
+  }
+
+  selfInternal->Lock->Lock();
+  for (std::map<CURL*, Transfer*>::iterator itr = active.begin(); itr != active.end(); ++itr) {
+    selfInternal->finishTransfer(multi, itr->second, false);
+  }
+  selfInternal->Condition->Broadcast();
+  selfInternal->Lock->Unlock();
+
+  curl_multi_cleanup(multi);
+  return VTK_THREAD_RETURN_VALUE;
+}
+
 }
 
 
@@ -86,6 +384,7 @@ size_t write_data(char *buffer, size_t size, size_t nmemb, void *userData)
 
 vesMidasClient::vesMidasClient()
 {
+  this->Internal = new vesInternal();
   this->m_curl = curl_easy_init();
   if (!this->m_curl) {
     std::cout << "error initializing CURL object" << std::endl;
@@ -95,7 +394,20 @@ vesMidasClient::vesMidasClient()
 
 vesMidasClient::~vesMidasClient()
 {
+  if (this->Internal->ThreadId >= 0) {
+    this->Internal->Lock->Lock();
+    this->Internal->ShouldQuit = true;
+    this->Internal->Condition->Broadcast();
+    this->Internal->Lock->Unlock();
+    this->Internal->MultiThreader->TerminateThread(this->Internal->ThreadId);
+  }
+
+  for (size_t i = 0; i < this->Internal->Pending.size(); ++i) {
+    delete this->Internal->Pending[i];
+  }
+
   curl_easy_cleanup(this->m_curl);
+  delete this->Internal;
 }
 
 /** Join arguments into a single string, escaping each parameter name and value.
@@ -128,57 +440,135 @@ std::string vesMidasClient::methodUrl(const std::string& method)
 }
 
 
-jsonSharedPtr vesMidasClient::request(const std::string& method, const RequestArgs& args, bool tryTokenRenewal)
+bool vesMidasClient::isCacheable(const std::string& method) const
+{
+  return method == "midas.community.list"
+    || method == "midas.community.children"
+    || method == "midas.folder.children"
+    || method == "midas.user.folders"
+    || method == "midas.item.get";
+}
+
+std::string vesMidasClient::cacheKey(const std::string& method, const RequestArgs& args)
+{
+  // the token changes on renewal, the user and host identify the session
+  RequestArgs keyArgs = args;
+  keyArgs.erase("token");
+  return this->m_host + " " + this->m_email + " " + method + this->argList(keyArgs);
+}
+
+bool vesMidasClient::requestData(const std::string& method, const RequestArgs& args, std::string& data, bool tryTokenRenewal)
 {
   if (!this->token().size()) {
     this->setError("Request Error", "Invalid request token.");
   }
 
-  jsonSharedPtr resultJson;
-
-  curl_easy_reset(this->m_curl);
+  bool success = false;
+  data = std::string();
 
   std::string requestUrl = this->methodUrl(method);
   std::string postArgs = this->argList(args);
 
+  const bool isCacheable = this->isCacheable(method);
+  const std::string key = isCacheable ? this->cacheKey(method, args) : std::string();
+
+  // use a fresh cached response, or the cached etag to revalidate a stale one
+  vesInternal::CacheEntry cachedEntry;
+  bool isCached = false;
+  bool isFresh = false;
+  if (isCacheable) {
+    this->Internal->Lock->Lock();
+    for (size_t i = 0; i < this->Internal->Pending.size(); ++i) {
+      if (this->Internal->Pending[i]->Key == key) {
+        delete this->Internal->Pending[i];
+        this->Internal->Pending.erase(this->Internal->Pending.begin() + i);
+        break;
+      }
+    }
+    while (this->Internal->InFlight.count(key)) {
+      this->Internal->Condition->Wait(this->Internal->Lock.GetPointer());
+    }
+    isCached = this->Internal->lookup(key, cachedEntry, isFresh);
+    this->Internal->Lock->Unlock();
+  }
 
   //strPrint("post " + method, "url: " + requestUrl + "\npost args: " + postArgs);
 
-  curl_easy_reset(this->m_curl);
+  std::string response;
+  std::string etag;
+  CURLcode result = CURLE_OK;
+
+  if (isCached && isFresh) {
+    response = cachedEntry.Response;
+    etag = cachedEntry.ETag;
+  }
+  else {
 
-  std::stringstream responseData;
-  curl_easy_setopt(m_curl, CURLOPT_URL, requestUrl.c_str());
-  curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, write_data);
-  curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &responseData);
-  curl_easy_setopt(m_curl, CURLOPT_COPYPOSTFIELDS, postArgs.c_str());
-  curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT, 30);
+    curl_easy_reset(this->m_curl);
+
+    std::stringstream responseData;
+    curl_easy_setopt(m_curl, CURLOPT_URL, requestUrl.c_str());
+    curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, write_data);
+    curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &responseData);
+    curl_easy_setopt(m_curl, CURLOPT_COPYPOSTFIELDS, postArgs.c_str());
+    curl_easy_setopt(m_curl, CURLOPT_CONNECTTIMEOUT, 30);
+
+    struct curl_slist* headers = 0;
+    if (isCacheable) {
+      curl_easy_setopt(m_curl, CURLOPT_HEADERFUNCTION, etag_header_function);
+      curl_easy_setopt(m_curl, CURLOPT_HEADERDATA, &etag);
+      if (isCached && !cachedEntry.ETag.empty()) {
+        headers = curl_slist_append(headers, ("If-None-Match: " + cachedEntry.ETag).c_str());
+        curl_easy_setopt(m_curl, CURLOPT_HTTPHEADER, headers);
+      }
+    }
+
+    result = curl_easy_perform(m_curl);
+    curl_slist_free_all(headers);
+
+    long responseCode = 0;
+    curl_easy_getinfo(m_curl, CURLINFO_RESPONSE_CODE, &responseCode);
+    if (result == CURLE_OK && responseCode == 304 && isCached) {
+      response = cachedEntry.Response;
+      etag = cachedEntry.ETag;
+    }
+    else {
+      response = responseData.str();
+    }
+  }
 
-  CURLcode result = curl_easy_perform(m_curl);
   if (result == CURLE_OK) {
 
-    //strPrint(method + " response:", responseData.str());
-    jsonSharedPtr respJson = makeShared(cJSON_Parse(responseData.str().c_str()));
+    //strPrint(method + " response:", response);
+    std::string statusStr;
+    std::string messageStr;
+    const char* dataStart;
+    size_t dataLength;
 
-    if (respJson) {
-      std::string statusStr = cJSON_GetObjectItem(respJson.get(), "stat")->valuestring;
+    if (parseResponse(response, statusStr, messageStr, dataStart, dataLength)) {
       if (statusStr == "ok") {
-          resultJson = makeShared(cJSON_DetachItemFromObject(respJson.get(), "data"));
-        if (!resultJson) {
+        if (dataStart) {
+          data.assign(dataStart, dataLength);
+        }
+        else {
           //printf("response json did not have 'data' field\n");
         }
+        success = true;
+
+        if (isCacheable && !(isCached && isFresh)) {
+          this->Internal->Lock->Lock();
+          this->Internal->store(key, response, etag);
+          this->Internal->Lock->Unlock();
+        }
       }
       else {
 
         // if it's a token error, maybe try renewing the token
-        if (cJSON_GetObjectItem(respJson.get(), "message")) {
-          std::string messageStr = cJSON_GetObjectItem(respJson.get(), "message")->valuestring;
-          if (messageStr == "Invalid token" && tryTokenRenewal) {
-            //printf("renewing token\n");
-            this->renewToken();
-            RequestArgs newArgs = args;
-            newArgs["token"] = this->token();
-            return this->request(method, newArgs, false);
-          }
+        if (messageStr == "Invalid token" && tryTokenRenewal) {
+          this->renewToken();
+          RequestArgs newArgs = args;
+          newArgs["token"] = this->token();
+          return this->requestData(method, newArgs, data, false);
         }
 
       this->defaultResponseErrorMessage();
@@ -194,9 +584,113 @@ jsonSharedPtr vesMidasClient::request(const std::string& method, const RequestAr
     //printf("curl_easy_perform() returned an error code: %d\n", result);
   }
 
+  return success;
+}
+
+jsonSharedPtr vesMidasClient::request(const std::string& method, const RequestArgs& args, bool tryTokenRenewal)
+{
+  jsonSharedPtr resultJson;
+  std::string data;
+  if (this->requestData(method, args, data, tryTokenRenewal) && !data.empty()) {
+    resultJson = makeShared(cJSON_Parse(data.c_str()));
+  }
   return resultJson;
 }
 
+void vesMidasClient::setCacheTimeToLive(double seconds)
+{
+  this->Internal->Lock->Lock();
+  this->Internal->TimeToLive = seconds;
+  this->Internal->Lock->Unlock();
+}
+
+double vesMidasClient::cacheTimeToLive() const
+{
+  return this->Internal->TimeToLive;
+}
+
+void vesMidasClient::clearCache()
+{
+  this->Internal->Lock->Lock();
+  this->Internal->Cache.clear();
+  this->Internal->Lock->Unlock();
+}
+
+void vesMidasClient::setPrefetchEnabled(bool enabled)
+{
+  this->Internal->PrefetchEnabled = enabled;
+}
+
+bool vesMidasClient::isPrefetchEnabled() const
+{
+  return this->Internal->PrefetchEnabled;
+}
+
+void vesMidasClient::setMaximumConcurrentRequests(int maximumRequests)
+{
+  this->Internal->Lock->Lock();
+  this->Internal->MaximumConcurrentRequests = maximumRequests > 0 ? maximumRequests : 1;
+  this->Internal->Lock->Unlock();
+}
+
+int vesMidasClient::maximumConcurrentRequests() const
+{
+  return this->Internal->MaximumConcurrentRequests;
+}
+
+void vesMidasClient::prefetch(const std::string& method, const std::vector<std::string>& ids)
+{
+  const std::string url = this->methodUrl(method);
+
+  this->Internal->Lock->Lock();
+
+  for (size_t i = 0; i < ids.size(); ++i) {
+
+    RequestArgs args;
+    if (this->m_token.size()) args["token"] = this->m_token;
+    args["id"] = ids[i];
+
+    const std::string key = this->cacheKey(method, args);
+
+    vesInternal::CacheEntry entry;
+    bool isFresh = false;
+    if (this->Internal->isQueued(key) || (this->Internal->lookup(key, entry, isFresh) && isFresh)) {
+      continue;
+    }
+
+    vesInternal::Transfer* transfer = new vesInternal::Transfer;
+    transfer->Key = key;
+    transfer->Url = url;
+    transfer->PostArgs = this->argList(args);
+    transfer->Handle = 0;
+    this->Internal->Pending.push_back(transfer);
+  }
+
+  if (!this->Internal->Pending.empty() && this->Internal->ThreadId < 0) {
+    this->Internal->ThreadId = this->Internal->MultiThreader->SpawnThread(PrefetchLoop, this->Internal);
+  }
+
+  this->Internal->Condition->Broadcast();
+  this->Internal->Lock->Unlock();
+}
+
+void vesMidasClient::waitForPrefetch()
+{
+  this->Internal->Lock->Lock();
+  while (this->Internal->ThreadId >= 0
+         && (!this->Internal->Pending.empty() || !this->Internal->InFlight.empty())) {
+    this->Internal->Condition->Wait(this->Internal->Lock.GetPointer());
+  }
+  this->Internal->Lock->Unlock();
+}
+
+void vesMidasClient::prefetchChildren(const std::string& method)
+{
+  if (this->Internal->PrefetchEnabled) {
+    this->prefetch(method, this->m_folderIds);
+  }
+}
+
 std::string vesMidasClient::errorTitle() const
 {
   return this->mErrorTitle;
@@ -241,11 +735,13 @@ bool vesMidasClient::login(const std::string& username, const std::string& passw
   args["password"] = password;
   args["email"] = username;
   std::string method = "midas.user.apikey.default";
-  jsonSharedPtr response = this->request(method, args);
-  if (response) {
-    cJSON* apikeyJson = cJSON_GetObjectItem(response.get(), "apikey");
-    if (apikeyJson) {
-      this->m_apikey = apikeyJson->valuestring;
+  std::string data;
+  if (this->requestData(method, args, data)) {
+    vesKiwiJSONReader reader(data.c_str(), data.size());
+    std::string apikey;
+    readMembers(reader, "apikey", apikey);
+    if (!apikey.empty()) {
+      this->m_apikey = apikey;
       return this->renewToken();
     }
   }
@@ -259,11 +755,13 @@ bool vesMidasClient::renewToken()
   args["email"] = this->m_email;
   args["apikey"] = this->m_apikey;
   std::string method = "midas.login";
-  jsonSharedPtr response = this->request(method, args);
-  if (response) {
-    cJSON* tokenJson = cJSON_GetObjectItem(response.get(), "token");
-    if (tokenJson) {
-      this->m_token = tokenJson->valuestring;
+  std::string data;
+  if (this->requestData(method, args, data)) {
+    vesKiwiJSONReader reader(data.c_str(), data.size());
+    std::string token;
+    readMembers(reader, "token", token);
+    if (!token.empty()) {
+      this->m_token = token;
       return true;
     }
   }
@@ -272,22 +770,24 @@ bool vesMidasClient::renewToken()
 
 namespace {
 
-bool parseFoldersJson(cJSON* foldersJson, std::vector<std::string>& folderNames, std::vector<std::string>& folderIds)
+bool readFolders(vesKiwiJSONReader& reader, std::vector<std::string>& folderNames, std::vector<std::string>& folderIds)
 {
-  if (!foldersJson) {
+  if (reader.peek() != vesKiwiJSONReader::BeginArray) {
+    reader.skipValue();
     return false;
   }
 
-  const int numberOfFolders = cJSON_GetArraySize(foldersJson);
-  for (int i = 0; i < numberOfFolders; ++i) {
-    cJSON* folderJson = cJSON_GetArrayItem(foldersJson, i);
-    std::string folderName = cJSON_GetObjectItem(folderJson, "name")->valuestring;
-    std::string folderId = cJSON_GetObjectItem(folderJson, "folder_id")->valuestring;
+  reader.beginArray();
+  while (reader.hasNext()) {
+    std::string folderName;
+    std::string folderId;
+    readMembers(reader, "name", folderName, "folder_id", &folderId);
     folderNames.push_back(folderName);
     folderIds.push_back(folderId);
   }
+  reader.endArray();
 
-  return true;
+  return !reader.hasError();
 }
 
 }
@@ -300,11 +800,15 @@ bool vesMidasClient::listUserFolders()
   RequestArgs args;
   args["token"] = this->m_token;
   std::string method = "midas.user.folders";
-  jsonSharedPtr response = this->request(method, args);
+  std::string data;
 
-  if (response) {
-    cJSON* foldersJson = response.get();
-    return parseFoldersJson(foldersJson, m_folderNames, m_folderIds);
+  if (this->requestData(method, args, data)) {
+    vesKiwiJSONReader reader(data.c_str(), data.size());
+    if (!readFolders(reader, m_folderNames, m_folderIds)) {
+      return false;
+    }
+    this->prefetchChildren("midas.folder.children");
+    return true;
   }
   return false;
 }
@@ -318,11 +822,26 @@ bool vesMidasClient::listCommunityChildren(const std::string& communityId)
   if (this->m_token.size()) args["token"] = this->m_token;
   args["id"] = communityId;
   std::string method = "midas.community.children";
-  jsonSharedPtr response = this->request(method, args);
-
-  if (response) {
-    cJSON* foldersJson = cJSON_GetObjectItem(response.get(), "folders");
-    return parseFoldersJson(foldersJson, m_folderNames, m_folderIds);
+  std::string data;
+
+  if (this->requestData(method, args, data)) {
+    vesKiwiJSONReader reader(data.c_str(), data.size());
+    bool hasFolders = false;
+    reader.beginObject();
+    while (reader.hasNext()) {
+      if (reader.nextName() == "folders") {
+        hasFolders = readFolders(reader, m_folderNames, m_folderIds);
+      }
+      else {
+        reader.skipValue();
+      }
+    }
+    reader.endObject();
+    if (!hasFolders || reader.hasError()) {
+      return false;
+    }
+    this->prefetchChildren("midas.folder.children");
+    return true;
   }
   return false;
 }
@@ -340,28 +859,41 @@ bool vesMidasClient::listFolderChildren(const std::string& inputFolderId)
   if (this->m_token.size()) args["token"] = this->m_token;
   args["id"] = inputFolderId;
   std::string method = "midas.folder.children";
-  jsonSharedPtr response = this->request(method, args);
+  std::string data;
 
-  if (response) {
-    cJSON* foldersJson = cJSON_GetObjectItem(response.get(), "folders");
-    cJSON* itemsJson = cJSON_GetObjectItem(response.get(), "items");
+  if (this->requestData(method, args, data)) {
+    vesKiwiJSONReader reader(data.c_str(), data.size());
+    bool hasFolders = false;
 
-    if (!parseFoldersJson(foldersJson, m_folderNames, m_folderIds)) {
-      return false;
+    reader.beginObject();
+    while (reader.hasNext()) {
+      std::string name = reader.nextName();
+      if (name == "folders") {
+        hasFolders = readFolders(reader, m_folderNames, m_folderIds);
+      }
+      else if (name == "items" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+        reader.beginArray();
+        while (reader.hasNext()) {
+          std::string itemName;
+          std::string itemId;
+          std::string itemBytes;
+          readMembers(reader, "name", itemName, "item_id", &itemId, "sizebytes", &itemBytes);
+          m_itemNames.push_back(itemName);
+          m_itemIds.push_back(itemId);
+          m_itemBytes.push_back(atol(itemBytes.c_str()));
+        }
+        reader.endArray();
+      }
+      else {
+        reader.skipValue();
+      }
     }
+    reader.endObject();
 
-    if (itemsJson) {
-      const int numberOfItems = cJSON_GetArraySize(itemsJson);
-      for (int i = 0; i < numberOfItems; ++i) {
-        cJSON* itemJson = cJSON_GetArrayItem(itemsJson, i);
-        std::string itemName = cJSON_GetObjectItem(itemJson, "name")->valuestring;
-        std::string itemId = cJSON_GetObjectItem(itemJson, "item_id")->valuestring;
-        std::string itemBytes = cJSON_GetObjectItem(itemJson, "sizebytes")->valuestring;
-        m_itemNames.push_back(itemName);
-        m_itemIds.push_back(itemId);
-        m_itemBytes.push_back(atol(itemBytes.c_str()));
-      }
+    if (!hasFolders || reader.hasError()) {
+      return false;
     }
+    this->prefetchChildren("midas.folder.children");
     return true;
   }
   return false;
@@ -375,18 +907,29 @@ bool vesMidasClient::listCommunities()
   RequestArgs args;
   if (this->m_token.size()) args["token"] = this->m_token;
   std::string method = "midas.community.list";
-  jsonSharedPtr response = this->request(method, args);
+  std::string data;
+
+  if (this->requestData(method, args, data)) {
 
-  if (response) {
+    vesKiwiJSONReader reader(data.c_str(), data.size());
+    if (reader.peek() != vesKiwiJSONReader::BeginArray) {
+      return false;
+    }
 
-    const int numberOfCommunities = cJSON_GetArraySize(response.get());
-    for (int i = 0; i < numberOfCommunities; ++i) {
-      cJSON* communityJson = cJSON_GetArrayItem(response.get(), i);
-      std::string communityName = cJSON_GetObjectItem(communityJson, "name")->valuestring;
-      std::string communityId = cJSON_GetObjectItem(communityJson, "community_id")->valuestring;
+    reader.beginArray();
+    while (reader.hasNext()) {
+      std::string communityName;
+      std::string communityId;
+      readMembers(reader, "name", communityName, "community_id", &communityId);
       m_folderNames.push_back(communityName);
       m_folderIds.push_back(communityId);
     }
+    reader.endArray();
+
+    if (reader.hasError()) {
+      return false;
+    }
+    this->prefetchChildren("midas.community.children");
     return true;
   }
   return false;
@@ -403,6 +946,60 @@ std::string vesMidasClient::itemDownloadUrl(const std::string& itemId)
   return requestUrl;
 }
 
+std::string vesMidasClient::itemChecksum(const std::string& itemId)
+{
+  RequestArgs args;
+  if (this->m_token.size()) args["token"] = this->m_token;
+  args["id"] = itemId;
+  std::string method = "midas.item.get";
+  std::string data;
+  if (!this->requestData(method, args, data)) {
+    return std::string();
+  }
+
+  // the item download is only the raw bitstream when there is exactly one,
+  // otherwise midas serves a zip of all bitstreams.  Revisions are listed
+  // oldest first, so the checksum of the last one wins.
+  std::string checksum;
+  vesKiwiJSONReader reader(data.c_str(), data.size());
+  reader.beginObject();
+  while (reader.hasNext()) {
+    if (reader.nextName() != "revisions" || reader.peek() != vesKiwiJSONReader::BeginArray) {
+      reader.skipValue();
+      continue;
+    }
+
+    reader.beginArray();
+    while (reader.hasNext()) {
+      checksum.clear();
+      reader.beginObject();
+      while (reader.hasNext()) {
+        if (reader.nextName() != "bitstreams" || reader.peek() != vesKiwiJSONReader::BeginArray) {
+          reader.skipValue();
+          continue;
+        }
+
+        int numberOfBitstreams = 0;
+        reader.beginArray();
+        while (reader.hasNext()) {
+          readMembers(reader, "checksum", checksum);
+          ++numberOfBitstreams;
+        }
+        reader.endArray();
+
+        if (numberOfBitstreams != 1) {
+          checksum.clear();
+        }
+      }
+      reader.endObject();
+    }
+    reader.endArray();
+  }
+  reader.endObject();
+
+  return reader.hasError() ? std::string() : checksum;
+}
+
 
 /*
 
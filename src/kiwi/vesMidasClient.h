@@ -19,6 +19,15 @@
  ========================================================================*/
 /// \class vesMidasClient
 /// \ingroup KiwiPlatform
+/// \brief JSON-RPC client for the Midas web API.
+///
+/// Responses to the browsing methods (community, folder and item listings)
+/// are cached by host, user, method and arguments.  A cached response is
+/// used without contacting the server until its time to live expires, after
+/// which it is revalidated with If-None-Match when the server sent an ETag.
+/// After a listing the child folders are prefetched on a background thread
+/// that runs up to maximumConcurrentRequests() transfers at once on a curl
+/// multi handle, so the next level of the tree is usually already cached.
 #ifndef __vesMidasClient_h
 #define __vesMidasClient_h
 
@@ -74,6 +83,34 @@ public:
 
   std::string itemDownloadUrl(const std::string& itemId);
 
+  // Set/get the number of seconds a cached response is used without
+  // revalidating it.  The default is 300.  A value of 0 always revalidates.
+  void setCacheTimeToLive(double seconds);
+  double cacheTimeToLive() const;
+
+  void clearCache();
+
+  // Enable/disable prefetching the children of listed folders.  Enabled by
+  // default.
+  void setPrefetchEnabled(bool enabled);
+  bool isPrefetchEnabled() const;
+
+  // Set/get the maximum number of concurrent background requests.  The
+  // default is 4.
+  void setMaximumConcurrentRequests(int maximumRequests);
+  int maximumConcurrentRequests() const;
+
+  // Queue background requests of method for each id.  Requests whose
+  // response is already cached and fresh are skipped.
+  void prefetch(const std::string& method, const std::vector<std::string>& ids);
+
+  // Block until all queued background requests have finished.
+  void waitForPrefetch();
+
+  // Returns the md5 checksum of the bitstream in the latest revision of the
+  // item, or an empty string if the item has no single bitstream.
+  std::string itemChecksum(const std::string& itemId);
+
   const std::vector<std::string>& folderNames();
   const std::vector<std::string>& folderIds();
 
@@ -91,8 +128,23 @@ public:
 
   std::string argList(const RequestArgs& args);
 
+  class vesInternal;
+
 private:
 
+  vesMidasClient(const vesMidasClient&); // Not implemented
+  void operator=(const vesMidasClient&); // Not implemented
+
+  // Performs the request and returns the raw json text of the data member
+  // of the response.
+  bool requestData(const std::string& method, const RequestArgs& args, std::string& data, bool tryTokenRenewal=true);
+
+  bool isCacheable(const std::string& method) const;
+  std::string cacheKey(const std::string& method, const RequestArgs& args);
+  void prefetchChildren(const std::string& method);
+
+  vesInternal* Internal;
+
   std::string m_apikey;
   std::string m_token;
   std::string m_email;
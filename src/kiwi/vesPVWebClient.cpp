@@ -20,6 +20,7 @@
 
 #include "vesPVWebClient.h"
 #include "vesPVWebDataSet.h"
+#include "vesKiwiJSONReader.h"
 
 #include <stdio.h>
 #include <iostream>
@@ -99,6 +100,13 @@ size_t write_data(char *buffer, size_t size, size_t nmemb, void *userData)
   return totalSize;
 }
 
+size_t write_string(char *buffer, size_t size, size_t nmemb, void *userData)
+{
+  size_t totalSize = size*nmemb;
+  static_cast<std::string*>(userData)->append(buffer, totalSize);
+  return totalSize;
+}
+
 }
 
 
@@ -177,70 +185,130 @@ bool vesPVWebClient::downloadObject(int objectIndex)
   return true;
 }
 
-bool vesPVWebClient::parseSceneMetaData(const std::stringstream& resp)
+namespace {
+
+void readRenderer(vesKiwiJSONReader& reader, std::vector<double>& lookAt, std::vector<double>& backgroundColor)
 {
-  //strPrint("poll scene response", resp.str());
-  jsonSharedPtr respJson = makeShared(cJSON_Parse(resp.str().c_str()));
+  std::vector<double> background1;
+  std::vector<double> background2;
 
-  if (respJson) {
+  reader.beginObject();
+  while (reader.hasNext()) {
+    std::string name = reader.nextName();
+    if (name == "LookAt" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+      lookAt = reader.nextDoubleArray();
+    }
+    else if (name == "Background1" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+      background1 = reader.nextDoubleArray();
+    }
+    else if (name == "Background2" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+      background2 = reader.nextDoubleArray();
+    }
+    else {
+      reader.skipValue();
+    }
+  }
+  reader.endObject();
 
-    // parse renderer
-    cJSON* renderersJson = cJSON_GetObjectItem(respJson.get(), "Renderers");
+  lookAt.resize(10, 0.0);
+  if (!background1.empty()) {
+    background1.resize(3, 0.0);
+    backgroundColor.insert(backgroundColor.end(), background1.begin(), background1.end());
+  }
+  if (!background2.empty()) {
+    background2.resize(3, 0.0);
+    backgroundColor.insert(backgroundColor.end(), background2.begin(), background2.end());
+  }
+}
 
-    m_lookAt.clear();
-    m_backgroundColor.clear();
+void readObject(vesKiwiJSONReader& reader, std::vector<vesPVWebDataSet::Ptr>& datasets)
+{
+  int parts = 0;
+  long long id = 0;
+  int layer = 0;
+  int transparency = 0;
+  std::string md5;
 
-    if (renderersJson) {
+  reader.beginObject();
+  while (reader.hasNext()) {
+    std::string name = reader.nextName();
+    vesKiwiJSONReader::TokenType type = reader.peek();
+    if (name == "parts" && type == vesKiwiJSONReader::Number) {
+      parts = reader.nextInt();
+    }
+    else if (name == "id" && type == vesKiwiJSONReader::Number) {
+      id = static_cast<long long>(reader.nextDouble());
+    }
+    else if (name == "layer" && type == vesKiwiJSONReader::Number) {
+      layer = reader.nextInt();
+    }
+    else if (name == "md5" && type == vesKiwiJSONReader::String) {
+      md5 = reader.nextString();
+    }
+    else if (name == "transparency" && type == vesKiwiJSONReader::Number) {
+      transparency = reader.nextInt();
+    }
+    else {
+      reader.skipValue();
+    }
+  }
+  reader.endObject();
+
+  for (int part = 0; part < parts; ++part) {
+    vesPVWebDataSet::Ptr dataset = vesPVWebDataSet::Ptr(new vesPVWebDataSet());
+    dataset->m_id = id;
+    dataset->m_layer = layer;
+    dataset->m_md5 = md5;
+    dataset->m_transparency = transparency;
+    dataset->m_part = part;
+    datasets.push_back(dataset);
+  }
+}
 
-      cJSON* rendererJson = cJSON_GetArrayItem(renderersJson, 0);
+}
 
-      cJSON* lookAtJson = cJSON_GetObjectItem(rendererJson, "LookAt");
-      if (lookAtJson) {
-        for (int i = 0; i < 10; ++i) {
-          m_lookAt.push_back(cJSON_GetArrayItem(lookAtJson, i)->valuedouble);
-        }
-      }
+bool vesPVWebClient::parseSceneMetaData(const char* data, size_t length)
+{
+  //strPrint("poll scene response", std::string(data, length));
+  vesKiwiJSONReader reader(data, length);
 
-      cJSON* backgroundJson = cJSON_GetObjectItem(rendererJson, "Background1");
-      if (backgroundJson) {
-        for (int i = 0; i < 3; ++i) {
-          m_backgroundColor.push_back(cJSON_GetArrayItem(backgroundJson, i)->valuedouble);
-        }
-      }
+  m_lookAt.clear();
+  m_backgroundColor.clear();
 
-      backgroundJson = cJSON_GetObjectItem(rendererJson, "Background2");
-      if (backgroundJson) {
-        for (int i = 0; i < 3; ++i) {
-          m_backgroundColor.push_back(cJSON_GetArrayItem(backgroundJson, i)->valuedouble);
-        }
+  reader.beginObject();
+  while (reader.hasNext()) {
+
+    std::string name = reader.nextName();
+
+    // parse renderer, only the first one is used
+    if (name == "Renderers" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+      reader.beginArray();
+      if (reader.hasNext()) {
+        readRenderer(reader, m_lookAt, m_backgroundColor);
+      }
+      while (reader.hasNext()) {
+        reader.skipValue();
       }
+      reader.endArray();
     }
 
-
     // parse objects
-    cJSON* objectsJson = cJSON_GetObjectItem(respJson.get(), "Objects");
-
-    int numberOfObjects = cJSON_GetArraySize(objectsJson);
-
-    //printf("parsing %d objects\n", numberOfObjects);
-
-    for (int i = 0; i < numberOfObjects; ++i) {
-      cJSON* objectJson = cJSON_GetArrayItem(objectsJson, i);
-      int parts = cJSON_GetObjectItem(objectJson, "parts")->valueint;
-      for (int part = 0; part < parts; ++part) {
-        vesPVWebDataSet::Ptr dataset = vesPVWebDataSet::Ptr(new vesPVWebDataSet());
-        dataset->m_id = static_cast<long long>(cJSON_GetObjectItem(objectJson, "id")->valuedouble);
-        dataset->m_layer = cJSON_GetObjectItem(objectJson, "layer")->valueint;
-        dataset->m_md5 = cJSON_GetObjectItem(objectJson, "md5")->valuestring;
-        dataset->m_transparency = cJSON_GetObjectItem(objectJson, "transparency")->valueint;
-        dataset->m_part = part;
-        this->m_datasets.push_back(dataset);
+    else if (name == "Objects" && reader.peek() == vesKiwiJSONReader::BeginArray) {
+      reader.beginArray();
+      while (reader.hasNext()) {
+        readObject(reader, this->m_datasets);
       }
+      reader.endArray();
+    }
+
+    else {
+      reader.skipValue();
     }
   }
-  else {
+  reader.endObject();
+
+  if (reader.hasError()) {
     this->defaultResponseErrorMessage();
-    //printf("response json parse error\n");
     return false;
   }
 
@@ -275,15 +343,15 @@ bool vesPVWebClient::pollSceneMetaData()
 
   curl_easy_reset(this->m_curl);
 
-  std::stringstream resp;
+  std::string resp;
 
   curl_easy_setopt(m_curl, CURLOPT_URL, url.str().c_str());
-  curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, write_data);
+  curl_easy_setopt(m_curl, CURLOPT_WRITEFUNCTION, write_string);
   curl_easy_setopt(m_curl, CURLOPT_WRITEDATA, &resp);
 
   CURLcode result = curl_easy_perform(m_curl);
   if (result == CURLE_OK) {
-    return this->parseSceneMetaData(resp);
+    return this->parseSceneMetaData(resp.c_str(), resp.size());
   }
   else {
     this->defaultCurlErrorMessage();
@@ -51,7 +51,8 @@ public:
 
   bool pollSceneMetaData();
 
-  bool parseSceneMetaData(const std::stringstream& resp);
+  /// Parse the scene meta data directly from the response buffer.
+  bool parseSceneMetaData(const char* data, size_t length);
 
   jsonSharedPtr rpc(const std::string& method, cJSON* params=0, int connectTimeout=0);
 
@@ -0,0 +1,40 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesText_frag.glsl
+///
+/// \ingroup shaders
+
+varying mediump vec3 textureCoordinate;
+varying mediump vec4 varColor;
+
+uniform highp sampler2D image;
+
+void main()
+{
+  // The glyph atlas holds the coverage of each texel, or its distance to the
+  // glyph outline when the third texture coordinate gives the width of the
+  // edge.
+  mediump float alpha = texture2D(image, textureCoordinate.xy).r;
+  if (textureCoordinate.z > 0.0) {
+    alpha = smoothstep(0.5 - textureCoordinate.z, 0.5 + textureCoordinate.z, alpha);
+  }
+
+  gl_FragColor = vec4(varColor.rgb, varColor.a * alpha);
+}
@@ -0,0 +1,125 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesUberShader_frag.glsl
+///
+/// Specialized by the VES_* defines prepended by vesKiwiShaderVariantCache.
+/// \ingroup shaders
+
+// Uniforms.
+#ifdef VES_BLINN_PHONG
+uniform lowp int primitiveType;
+#endif
+
+#ifdef VES_TEXTURE
+uniform highp sampler2D image;
+#endif
+
+#ifdef VES_WIREFRAME
+uniform lowp float lineWidth;
+#endif
+
+// Varying attributes.
+varying lowp vec4 varColor;
+
+#ifdef VES_TEXTURE
+varying mediump vec2 textureCoordinate;
+#endif
+
+#ifdef VES_BLINN_PHONG
+varying mediump vec3 varNormal;
+varying mediump vec3 varPosition;
+#endif
+
+#ifdef VES_CLIP_PLANE
+varying highp float clipDistance;
+#endif
+
+#ifdef VES_WIREFRAME
+varying highp vec3 dist;
+#endif
+
+void main()
+{
+#ifdef VES_CLIP_PLANE
+  if (clipDistance < 0.0)
+    discard;
+#endif
+
+  lowp vec4 color = varColor;
+
+#ifdef VES_TEXTURE
+  color = vec4(texture2D(image, textureCoordinate).xyz * color.xyz, color.w);
+#endif
+
+#ifdef VES_BLINN_PHONG
+  // 0 is points and 1 is lines, neither is lit.
+  if (primitiveType != 1 && primitiveType != 0) {
+    highp vec3 n = normalize(varNormal);
+    highp vec3 lightDirection = vec3(0.0, 0.0, 1.0);
+
+    // Default to metallic look and feel.
+    highp float specularShininess = 64.0;
+    lowp vec4  specularColor = vec4(0.6, 0.6, 0.6, 0.0);
+
+    highp vec3  viewDirection = normalize(-varPosition);
+
+    // Using half vector for specular lighting as it is much cheaper than
+    // calculating reflection vector.
+    highp vec3 halfVector = normalize(lightDirection + viewDirection);
+
+    lowp float nDotL = max(dot(n, lightDirection), 0.0);
+    lowp float nDotH = max(dot(n, halfVector), 0.1);
+    color = vec4(color.xyz * nDotL, color.w) + specularColor * pow(nDotH, specularShininess);
+  }
+#endif
+
+#ifdef VES_WIREFRAME
+  // Undo perspective correction.
+  highp vec3 dist_vec = dist * gl_FragCoord.w;
+
+  // Compute the shortest distance to the edge
+  highp float d = min(dist_vec[0], min(dist_vec[1], dist_vec[2]));
+
+#ifdef VES_SURFACE_WITH_EDGES
+  lowp vec4 fillColor = color;
+  lowp vec4 edgeColor = fillColor - vec4(0.4, 0.4, 0.4, 0.0);
+  lowp float a = 2.0;
+  lowp float myLineWidth = (lineWidth-1.0)*0.5;
+  d = max(d - myLineWidth, 0.0);
+#else
+  lowp float isFront = float(gl_FrontFacing);
+
+  lowp float myLineWidth = isFront*(lineWidth-1.0)*0.5;
+
+  if (d > myLineWidth + 1.0) discard;
+
+  lowp vec4 edgeColor = color*isFront + vec4(0.3, 0.3, 0.3, color.a)*(1.0-isFront);
+  lowp vec4 fillColor = vec4(edgeColor.rgb, 0.0);
+  lowp float a = 2.0;
+  d = max(d - myLineWidth, 0.0);
+#endif
+
+  // Compute line intensity and then fragment color
+  highp float I = exp2(-a*d*d);
+  gl_FragColor = I*edgeColor + (1.0 - I)*fillColor;
+#else
+  gl_FragColor = color;
+#endif
+}
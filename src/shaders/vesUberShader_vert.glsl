@@ -0,0 +1,163 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \file vesUberShader_vert.glsl
+///
+/// Specialized by the VES_* defines prepended by vesKiwiShaderVariantCache.
+/// Wireframe implementation based on demo code from
+/// http://www2.imm.dtu.dk/~janba/Wireframe/
+/// \ingroup shaders
+
+// Uniforms.
+uniform highp mat4   modelViewMatrix;
+uniform highp mat4   projectionMatrix;
+uniform mediump mat3 normalMatrix;
+uniform lowp int     primitiveType;
+uniform lowp int     pointSize;
+uniform lowp float   vertexOpacity;
+
+#ifdef VES_CLIP_PLANE
+uniform highp vec4   clipPlaneEquation;
+#endif
+
+#ifdef VES_WIREFRAME
+uniform mediump vec2 windowSize;
+#endif
+
+// Vertex attributes.
+attribute highp vec3   vertexPosition;
+attribute mediump vec3 vertexNormal;
+
+#if defined(VES_INSTANCED)
+attribute highp vec4   instanceOffset;
+attribute lowp vec3    instanceColor;
+#elif !defined(VES_TEXTURE) || defined(VES_VERTEX_COLORS)
+attribute lowp vec3    vertexColor;
+#endif
+
+#ifdef VES_TEXTURE
+attribute mediump vec4 vertexTextureCoordinate;
+#endif
+
+#ifdef VES_WIREFRAME
+attribute highp vec3 tri_p1;
+attribute highp vec3 tri_p2;
+attribute lowp float tri_point_index;
+#endif
+
+// Varying attributes.
+varying lowp vec4 varColor;
+
+#ifdef VES_TEXTURE
+varying mediump vec2 textureCoordinate;
+#endif
+
+#ifdef VES_BLINN_PHONG
+varying mediump vec3 varNormal;
+varying mediump vec3 varPosition;
+#endif
+
+#ifdef VES_CLIP_PLANE
+varying highp float clipDistance;
+#endif
+
+#ifdef VES_WIREFRAME
+varying highp vec3 dist;
+#endif
+
+void main()
+{
+#ifdef VES_INSTANCED
+  // Offset in xyz and uniform scale in w, see vesInstancedMapper.
+  highp vec3 position = vertexPosition * instanceOffset.w + instanceOffset.xyz;
+#else
+  highp vec3 position = vertexPosition;
+#endif
+
+  highp vec4 eyePosition = modelViewMatrix * vec4(position, 1.0);
+  gl_Position = projectionMatrix * eyePosition;
+  gl_PointSize = float(pointSize);
+
+#ifdef VES_TEXTURE
+  textureCoordinate = vertexTextureCoordinate.xy;
+  varColor = vec4(1.5, 1.5, 1.5, vertexOpacity);
+#ifdef VES_VERTEX_COLORS
+  varColor.xyz *= vertexColor;
+#endif
+#elif defined(VES_INSTANCED)
+  varColor = vec4(instanceColor, vertexOpacity);
+#else
+  varColor = vec4(vertexColor, vertexOpacity);
+#endif
+
+#ifdef VES_BLINN_PHONG
+  // Lit per fragment.
+  varNormal = normalMatrix * vertexNormal;
+  varPosition = eyePosition.xyz;
+#else
+  // 0 is points and 1 is lines, neither is lit.
+  if (primitiveType != 1 && primitiveType != 0) {
+    // Transform vertex normal into eye space.
+    lowp vec3 normal = normalize(normalMatrix * vertexNormal);
+
+    // Save light direction (direction light for now)
+    lowp vec3 lightDirection = normalize(vec3(0.0, 0.0, 0.650));
+
+    lowp float nDotL = max(dot(normal, lightDirection), 0.0);
+
+    // Do backface lighting too.
+    nDotL = max(dot(-normal, lightDirection), nDotL);
+
+    varColor = vec4(varColor.xyz * nDotL, varColor.w);
+  }
+#endif
+
+#ifdef VES_CLIP_PLANE
+  clipDistance = dot(position, clipPlaneEquation.xyz) + clipPlaneEquation.w;
+#endif
+
+#ifdef VES_WIREFRAME
+  // p0 is the 2D position of the current vertex.
+  highp vec2 p0 = gl_Position.xy/gl_Position.w;
+
+  // Project p1 and p2 and compute the vectors v1 = p1-p0
+  // and v2 = p2-p0
+  highp vec4 p1_3d_ = projectionMatrix * modelViewMatrix * vec4(tri_p1, 1.0);
+  highp vec2 v1 = windowSize*(p1_3d_.xy / p1_3d_.w - p0);
+
+  highp vec4 p2_3d_ = projectionMatrix * modelViewMatrix * vec4(tri_p2, 1.0);
+  highp vec2 v2 = windowSize*(p2_3d_.xy / p2_3d_.w - p0);
+
+  // Compute 2D area of triangle.
+  highp float area2 = abs(v1.x*v2.y - v1.y * v2.x);
+
+  // Compute distance from vertex to line in 2D coords
+  highp float h = area2/length(v1-v2);
+
+  if(tri_point_index < 0.1)
+    dist = vec3(h,0,0);
+  else if(tri_point_index < 1.1)
+    dist = vec3(0,h,0);
+  else
+    dist = vec3(0,0,h);
+
+  // Quick fix to defy perspective correction
+  dist *= gl_Position.w;
+#endif
+}
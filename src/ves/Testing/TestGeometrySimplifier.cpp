@@ -0,0 +1,155 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include <ves/vesGeometryData.h>
+#include <ves/vesGeometrySimplifier.h>
+#include <ves/vesGLTypes.h>
+#include <ves/vesPrimitive.h>
+#include <ves/vesSourceData.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+using std::cout;
+using std::endl;
+
+// A unit sphere of rings x segments quads.  The vertices along the seam and
+// at the poles are duplicated, as in most tessellated spheres.
+vesGeometryData::Ptr createSphere(int rings, int segments)
+{
+  vesSourceDataP3f::Ptr points(new vesSourceDataP3f());
+  for (int i = 0; i <= rings; ++i) {
+    const float theta = static_cast<float>(M_PI) * i / rings;
+    for (int j = 0; j <= segments; ++j) {
+      // Duplicates get exactly the same position.
+      const float phi = 2.0f * static_cast<float>(M_PI) * (j % segments) / segments;
+      const float radius = (i == 0 || i == rings) ? 0.0f : sin(theta);
+      vesVertexDataP3f vertex;
+      vertex.m_position = vesVector3f(radius * cos(phi), radius * sin(phi),
+                                      i == rings ? -1.0f : cos(theta));
+      points->pushBack(vertex);
+    }
+  }
+
+  vesSharedPtr< vesIndices<unsigned short> > indices(new vesIndices<unsigned short>());
+  for (int i = 0; i < rings; ++i) {
+    for (int j = 0; j < segments; ++j) {
+      const unsigned short a = i * (segments + 1) + j;
+      const unsigned short b = a + segments + 1;
+      indices->pushBackIndices(a, b, a + 1);
+      indices->pushBackIndices(a + 1, b, b + 1);
+    }
+  }
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+  triangles->setIndicesValueType(vesPrimitiveIndicesValueType::UnsignedShort);
+  triangles->setVesIndices(indices);
+
+  vesGeometryData::Ptr geometry(new vesGeometryData());
+  geometry->addSource(points);
+  geometry->addPrimitive(triangles);
+  return geometry;
+}
+
+vesVector3f position(vesGeometryData::Ptr geometry, unsigned int index)
+{
+  vesSourceDataP3f::Ptr points = std::tr1::static_pointer_cast<vesSourceDataP3f>(
+    geometry->sourceData(vesVertexAttributeKeys::Position));
+  return points->arrayReference()[index].m_position;
+}
+
+// Every triangle of a level must still face away from the center of the
+// sphere and stay close to its surface.
+bool checkLevel(vesGeometryData::Ptr geometry, vesPrimitive::Ptr level,
+                float maximumDeviation)
+{
+  const unsigned short *corners = static_cast<const unsigned short*>(level->data());
+  const unsigned int numberOfTriangles = level->numberOfIndices() / 3;
+  int inverted = 0;
+  float deviation = 0.0f;
+  for (unsigned int i = 0; i < numberOfTriangles; ++i) {
+    const vesVector3f a = position(geometry, corners[3 * i]);
+    const vesVector3f b = position(geometry, corners[3 * i + 1]);
+    const vesVector3f c = position(geometry, corners[3 * i + 2]);
+    const vesVector3f centroid = (a + b + c) / 3.0f;
+    if ((b - a).cross(c - a).dot(centroid) <= 0.0f) {
+      ++inverted;
+    }
+    deviation = std::max(deviation, std::fabs(1.0f - centroid.norm()));
+  }
+
+  cout << numberOfTriangles << " triangles, " << inverted
+       << " inverted, maximum deviation " << deviation << endl;
+  if (inverted) {
+    cout << "Simplified triangles are inverted!" << endl;
+    return false;
+  }
+  if (deviation > maximumDeviation) {
+    cout << "Simplified triangles deviate from the surface!" << endl;
+    return false;
+  }
+  return true;
+}
+
+int main(int, char *[])
+{
+  bool success = true;
+
+  vesGeometryData::Ptr sphere = createSphere(60, 60);
+  if (vesGeometrySimplifier::numberOfTriangles(sphere) != 7200) {
+    cout << "Unexpected number of sphere triangles!" << endl;
+    success = false;
+  }
+
+  std::vector<float> ratios;
+  ratios.push_back(0.25f);
+  ratios.push_back(0.0625f);
+  ratios.push_back(0.015625f);
+  std::vector<vesPrimitive::Ptr> levels =
+    vesGeometrySimplifier::simplify(sphere, ratios);
+  if (levels.size() != ratios.size()) {
+    cout << "Expected " << ratios.size() << " levels, got " << levels.size() << endl;
+    success = false;
+  }
+
+  unsigned int previous = 7200;
+  for (size_t i = 0; i < levels.size(); ++i) {
+    const unsigned int numberOfTriangles = levels[i]->numberOfIndices() / 3;
+    if (numberOfTriangles >= previous) {
+      cout << "Level " << i << " is not coarser than the previous one!" << endl;
+      success = false;
+    }
+    previous = numberOfTriangles;
+    success = checkLevel(sphere, levels[i], 0.2f) && success;
+  }
+
+  // A cancelled simplification returns no levels.
+  const volatile bool cancel = true;
+  if (!vesGeometrySimplifier::simplify(sphere, ratios, &cancel).empty()) {
+    cout << "Cancelled simplification returned levels!" << endl;
+    success = false;
+  }
+
+  return success ? 0 : 1;
+}
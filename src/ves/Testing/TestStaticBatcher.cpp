@@ -0,0 +1,368 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// This test merges a row of quads with vesStaticBatcher and checks the index
+// range of every part in the batch, that actors too large for 16 bit indices
+// are left alone, and that hiding parts removes them from the draw calls and
+// the rendered image.
+
+#include <vesActor.h>
+#include <vesBatchedMapper.h>
+#include <vesCamera.h>
+#include <vesGeometryData.h>
+#include <vesMapper.h>
+#include <vesMaterial.h>
+#include <vesModelViewUniform.h>
+#include <vesProjectionUniform.h>
+#include <vesRenderer.h>
+#include <vesShader.h>
+#include <vesShaderProgram.h>
+#include <vesStaticBatcher.h>
+#include <vesVertexAttribute.h>
+#include <vesVertexAttributeKeys.h>
+
+#include <vesTestHelper.h>
+
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+namespace {
+
+const int numberOfQuads = 4;
+
+bool check(bool condition, const char* message)
+{
+  if (!condition) {
+    printf("failed: %s\n", message);
+  }
+  return condition;
+}
+
+vesShaderProgram::Ptr createShaderProgram()
+{
+  const std::string vertexShaderSource =
+    "uniform highp mat4 modelViewMatrix;\n \
+     uniform highp mat4 projectionMatrix;\n \
+     attribute highp vec4 vertexPosition;\n \
+     attribute mediump vec4 vertexColor;\n \
+     varying mediump vec4 varColor;\n \
+     void main()\n \
+     {\n \
+       gl_Position = projectionMatrix * modelViewMatrix * vertexPosition;\n \
+       varColor = vertexColor;\n \
+     }";
+
+  const std::string fragmentShaderSource =
+    "varying mediump vec4 varColor;\n \
+     void main()\n \
+     {\n \
+       gl_FragColor = varColor;\n \
+     }";
+
+  vesShaderProgram::Ptr program(new vesShaderProgram());
+  program->addShader(vesShader::Ptr(new vesShader(vesShader::Vertex, vertexShaderSource)));
+  program->addShader(vesShader::Ptr(new vesShader(vesShader::Fragment, fragmentShaderSource)));
+  program->addUniform(vesModelViewUniform::Ptr(new vesModelViewUniform()));
+  program->addUniform(vesProjectionUniform::Ptr(new vesProjectionUniform()));
+  program->addVertexAttribute(vesPositionVertexAttribute::Ptr(new vesPositionVertexAttribute()),
+                              vesVertexAttributeKeys::Position);
+  program->addVertexAttribute(vesColorVertexAttribute::Ptr(new vesColorVertexAttribute()),
+                              vesVertexAttributeKeys::Color);
+  return program;
+}
+
+// A grid of quads covering [-1, 1] x [-1, 1], with rows x columns cells and
+// (rows + 1) x (columns + 1) vertices.
+vesGeometryData::Ptr createGrid(int rows, int columns)
+{
+  vesSourceDataP3f::Ptr points(new vesSourceDataP3f());
+  for (int i = 0; i <= rows; ++i) {
+    for (int j = 0; j <= columns; ++j) {
+      vesVertexDataP3f vertex;
+      vertex.m_position = vesVector3f(2.0f * j / columns - 1.0f, 2.0f * i / rows - 1.0f, 0.0f);
+      points->pushBack(vertex);
+    }
+  }
+
+  vesSharedPtr< vesIndices<unsigned short> > indices(new vesIndices<unsigned short>());
+  for (int i = 0; i < rows; ++i) {
+    for (int j = 0; j < columns; ++j) {
+      const unsigned short a = i * (columns + 1) + j;
+      const unsigned short b = a + columns + 1;
+      indices->pushBackIndices(a, a + 1, b + 1);
+      indices->pushBackIndices(a, b + 1, b);
+    }
+  }
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+  triangles->setIndicesValueType(vesPrimitiveIndicesValueType::UnsignedShort);
+  triangles->setVesIndices(indices);
+
+  vesGeometryData::Ptr geometry(new vesGeometryData());
+  geometry->addSource(points);
+  geometry->addPrimitive(triangles);
+  return geometry;
+}
+
+vesActor::Ptr createActor(vesGeometryData::Ptr geometry, vesMaterial::Ptr material,
+                          const vesVector3f& translation, const vesVector4f& color)
+{
+  vesMapper::Ptr mapper(new vesMapper());
+  mapper->setGeometryData(geometry);
+  mapper->setColor(color[0], color[1], color[2], color[3]);
+
+  vesActor::Ptr actor(new vesActor());
+  actor->setMapper(mapper);
+  actor->setMaterial(material);
+  actor->setTranslation(translation);
+  return actor;
+}
+
+vesVector3f vertexPosition(vesGeometryData::Ptr geometry, unsigned int index)
+{
+  vesSourceData::Ptr positions = geometry->sourceData(vesVertexAttributeKeys::Position);
+  const unsigned char* data = static_cast<const unsigned char*>(positions->data())
+    + positions->attributeOffset(vesVertexAttributeKeys::Position);
+  const unsigned int stride = positions->attributeStride(vesVertexAttributeKeys::Position)
+    ? positions->attributeStride(vesVertexAttributeKeys::Position) : 3 * sizeof(float);
+  const float* position = reinterpret_cast<const float*>(data + index * stride);
+  return vesVector3f(position[0], position[1], position[2]);
+}
+
+}
+
+class vesTestStaticBatcher {
+public:
+
+  vesTestStaticBatcher() :
+    m_material(new vesMaterial()),
+    m_renderer(new vesRenderer())
+  {
+  }
+
+  vesRenderer::Ptr renderer()
+  {
+    return this->m_renderer;
+  }
+
+  void init()
+  {
+    this->m_material->addAttribute(createShaderProgram());
+
+    vesGeometryData::Ptr quad = createGrid(1, 1);
+    for (int i = 0; i < numberOfQuads; ++i) {
+      const vesVector4f color(i % 2 ? 0.0f : 1.0f, i % 2 ? 1.0f : 0.0f, 0.0f, 1.0f);
+      this->m_quads.push_back(createActor(quad, this->m_material,
+        vesVector3f(3.0f * i, 0.0f, 0.0f), color));
+    }
+
+    std::vector<vesActor::Ptr> actors = vesStaticBatcher::merge(this->m_quads);
+    if (actors.size() == 1) {
+      this->m_batch = actors[0];
+      this->m_renderer->addActor(this->m_batch);
+    }
+
+    this->m_renderer->camera()->setParallelProjection(true);
+    this->m_renderer->setBackgroundColor(0.0, 0.0, 0.0);
+  }
+
+  vesBatchedMapper::Ptr batchedMapper()
+  {
+    return this->m_batch ? std::tr1::dynamic_pointer_cast<vesBatchedMapper>(
+      this->m_batch->mapper()) : vesBatchedMapper::Ptr();
+  }
+
+  // Every part owns the next two triangles of the batch, whose indices point
+  // at the vertices of the part moved by its actor translation.
+  bool testIndexRanges()
+  {
+    vesBatchedMapper::Ptr mapper = this->batchedMapper();
+    if (!check(mapper && mapper->numberOfParts() == numberOfQuads, "all quads in one batch")) {
+      return false;
+    }
+
+    vesGeometryData::Ptr geometry = mapper->geometryData();
+    vesPrimitive::Ptr triangles = geometry->triangles();
+    if (!check(geometry->numberOfPrimitiveTypes() == 1 && triangles
+               && triangles->numberOfIndices() == 6 * numberOfQuads
+               && triangles->indicesValueType() == vesPrimitiveIndicesValueType::UnsignedShort,
+               "one triangle primitive with 16 bit indices")) {
+      return false;
+    }
+
+    bool testPassed = true;
+    vesGeometryData::Ptr quad = this->m_quads[0]->mapper()->geometryData();
+    vesPrimitive::Ptr quadTriangles = quad->triangles();
+    const unsigned short* indices = static_cast<const unsigned short*>(triangles->data());
+    const unsigned short* quadIndices = static_cast<const unsigned short*>(quadTriangles->data());
+    for (int i = 0; i < numberOfQuads; ++i) {
+      testPassed &= check(mapper->part(i) == this->m_quads[i], "parts in the order they were merged");
+      for (int j = 0; j < 6; ++j) {
+        const vesVector3f expected = vertexPosition(quad, quadIndices[j]) + vesVector3f(3.0f * i, 0.0f, 0.0f);
+        const vesVector3f position = vertexPosition(geometry, indices[6 * i + j]);
+        testPassed &= check((position - expected).norm() < 1.0e-6f, "index range of a part");
+      }
+    }
+    return testPassed;
+  }
+
+  // Quads hidden in the middle or at the ends of the batch split or shorten
+  // the runs of indices drawn, and disappear from the image.
+  bool testVisibility()
+  {
+    vesBatchedMapper::Ptr mapper = this->batchedMapper();
+    if (!mapper) {
+      return false;
+    }
+
+    const bool visibilities[][numberOfQuads] = {
+      { true, true, true, true },
+      { true, false, true, true },
+      { false, true, false, true },
+      { false, true, true, false },
+      { false, false, false, false }
+    };
+    const int drawCalls[] = { 1, 2, 2, 1, 0 };
+
+    bool testPassed = true;
+    for (int i = 0; i < 5; ++i) {
+      for (int j = 0; j < numberOfQuads; ++j) {
+        this->m_quads[j]->setVisible(visibilities[i][j]);
+      }
+      this->m_renderer->render();
+
+      char message[128];
+      sprintf(message, "visibility %d draws %d ranges, expected %d", i,
+              mapper->numberOfDrawCalls(), drawCalls[i]);
+      testPassed &= check(mapper->numberOfDrawCalls() == drawCalls[i], message);
+
+      for (int j = 0; j < numberOfQuads; ++j) {
+        const vesVector3f center = this->m_renderer->computeWorldToDisplay(vesVector3f(3.0f * j, 0.0f, 0.0f));
+        unsigned char pixel[4];
+        glReadPixels(static_cast<int>(center[0]), static_cast<int>(center[1]), 1, 1,
+                     GL_RGBA, GL_UNSIGNED_BYTE, pixel);
+        const bool isDrawn = pixel[0] > 128 || pixel[1] > 128;
+        sprintf(message, "visibility %d, quad %d is %s", i, j, isDrawn ? "drawn" : "not drawn");
+        testPassed &= check(isDrawn == visibilities[i][j], message);
+      }
+    }
+
+    for (int j = 0; j < numberOfQuads; ++j) {
+      this->m_quads[j]->setVisible(true);
+    }
+    return testPassed;
+  }
+
+  // Actors with more vertices than 16 bit indices address are not batched,
+  // and batches that would outgrow them start a new batch.
+  bool testVertexLimit()
+  {
+    bool testPassed = true;
+    const int maximumVertices = vesBatchedMapper::maximumVerticesPerBatch();
+    testPassed &= check(maximumVertices == 65536, "16 bit vertex limit");
+
+    // 256 x 256 cells have 257^2 vertices.
+    vesActor::Ptr oversized = createActor(createGrid(256, 256), this->m_material,
+      vesVector3f(0.0f, 0.0f, 0.0f), vesVector4f(1.0f, 1.0f, 1.0f, 1.0f));
+    testPassed &= check(!vesBatchedMapper::isBatchable(oversized), "oversized actor is not batchable");
+
+    std::vector<vesActor::Ptr> actors = this->m_quads;
+    actors.push_back(oversized);
+    std::vector<vesActor::Ptr> merged = vesStaticBatcher::merge(actors);
+    testPassed &= check(merged.size() == 2 && merged[1] == oversized,
+                        "oversized actor is rendered unchanged after the batch");
+
+    // Grids of 128 x 128 cells have 129^2 = 16641 vertices, three of them
+    // fit in a batch but not a fourth.
+    vesGeometryData::Ptr grid = createGrid(128, 128);
+    std::vector<vesActor::Ptr> grids;
+    for (int i = 0; i < 5; ++i) {
+      grids.push_back(createActor(grid, this->m_material,
+        vesVector3f(3.0f * i, 0.0f, 0.0f), vesVector4f(1.0f, 1.0f, 1.0f, 1.0f)));
+    }
+
+    vesBatchedMapper::Ptr mapper(new vesBatchedMapper());
+    testPassed &= check(mapper->addPart(grids[0]) && mapper->addPart(grids[1]) && mapper->addPart(grids[2]),
+                        "grids within the vertex limit are merged");
+    testPassed &= check(!mapper->addPart(grids[3]) && mapper->numberOfParts() == 3,
+                        "a grid past the vertex limit is refused");
+
+    merged = vesStaticBatcher::merge(grids);
+    bool isSplit = merged.size() == 2;
+    for (size_t i = 0; isSplit && i < merged.size(); ++i) {
+      vesBatchedMapper::Ptr batch = std::tr1::dynamic_pointer_cast<vesBatchedMapper>(merged[i]->mapper());
+      isSplit = batch && batch->numberOfParts() == (i ? 2 : 3);
+    }
+    testPassed &= check(isSplit, "grids split into batches within the vertex limit");
+    return testPassed;
+  }
+
+private:
+
+  vesMaterial::Ptr m_material;
+  vesRenderer::Ptr m_renderer;
+  std::vector<vesActor::Ptr> m_quads;
+  vesActor::Ptr m_batch;
+};
+
+
+class MyTestHelper : public vesTestHelper {
+public:
+
+  MyTestHelper()
+  {
+    this->setRenderer(mApp.renderer());
+  }
+
+  vesTestStaticBatcher mApp;
+};
+
+
+int main(int argc, char *argv[])
+{
+  if (argc < 2) {
+    printf("Usage: %s <path to VES source directory> [path to testing data directory]\n", argv[0]);
+    return 1;
+  }
+
+  const int windowWidth = 400;
+  const int windowHeight = 100;
+  MyTestHelper helper;
+  helper.init(&argc, argv, windowWidth, windowHeight, "TestStaticBatcher");
+  helper.mApp.init();
+
+  helper.resize(windowWidth, windowHeight);
+  helper.renderer()->resetCamera();
+
+  bool testPassed = helper.mApp.testIndexRanges();
+  testPassed = helper.mApp.testVisibility() && testPassed;
+  testPassed = helper.mApp.testVertexLimit() && testPassed;
+
+  // begin the event loop if not in testing mode
+  if (argc < 3) {
+    helper.render();
+    helper.startMainLoop();
+  }
+
+  return testPassed ? 0 : 1;
+}
@@ -1,6 +1,7 @@
 set(headers
   vesActor.h
   vesBackground.h
+  vesBatchedMapper.h
   vesBlend.h
   vesBlendFunction.h
   vesBooleanUniform.h
@@ -14,10 +15,13 @@ set(headers
   vesFBO.h
   vesFBORenderTarget.h
   vesGL.h
+  vesGLStateCache.h
   vesGLTypes.h
   vesGeometryData.h
+  vesGeometrySimplifier.h
   vesGroupNode.h
   vesImage.h
+  vesInstancedMapper.h
   vesIntegerUniform.h
   vesMapper.h
   vesMaterial.h
@@ -27,8 +31,11 @@ set(headers
   vesNode.h
   vesNormalMatrixUniform.h
   vesObject.h
+  vesOffscreenRenderTarget.h
   vesOpenGLSupport.h
   vesPrimitive.h
+  vesProfiler.h
+  vesProgramBinaryCache.h
   vesProjectionUniform.h
   vesRenderData.h
   vesRenderLeaf.h
@@ -43,6 +50,7 @@ set(headers
   vesSharedPtr.h
   vesSourceData.h
   vesStateAttributeBits.h
+  vesStaticBatcher.h
   vesTestHelper.h
   vesTexture.h
   vesTransformInterface.h
@@ -28,8 +28,6 @@
 #include "vesGLTypes.h"
 #include "vesMapper.h"
 #include "vesMaterial.h"
-#include "vesModelViewUniform.h"
-#include "vesProjectionUniform.h"
 #include "vesShader.h"
 #include "vesShaderProgram.h"
 #include "vesTexture.h"
@@ -45,24 +43,15 @@ public:
     m_backgroundActor(new vesActor()),
     m_backgroundMapper(new vesMapper()),
     m_backgroundMaterial(new vesMaterial()),
-    m_shaderProgram(new vesShaderProgram()),
-    m_vertexShader(new vesShader(vesShader::Vertex)),
-    m_fragmentShader(new vesShader(vesShader::Fragment)),
-    m_modelViewUniform(new vesModelViewUniform()),
-    m_projectionUniform(new vesProjectionUniform()),
+    m_gradientShaderProgram(new vesShaderProgram()),
+    m_imageShaderProgram(new vesShaderProgram()),
+    m_topColorUniform(new vesUniform("topColor", vesVector4f(1.0f, 1.0f, 1.0f, 1.0f))),
+    m_bottomColorUniform(new vesUniform("bottomColor", vesVector4f(1.0f, 1.0f, 1.0f, 1.0f))),
+    m_regionUniform(new vesUniform("region", vesVector4f(0.0f, 0.0f, 1.0f, 1.0f))),
     m_positionVertexAttribute(new vesPositionVertexAttribute()),
-    m_colorVertexAttribute(new vesColorVertexAttribute()),
     m_textureCoodinateAttribute(new vesTextureCoordinateVertexAttribute()),
     m_depth(new vesDepth())
   {
-    this->m_shaderProgram->addShader(this->m_vertexShader);
-    this->m_shaderProgram->addShader(this->m_fragmentShader);
-    this->m_shaderProgram->addUniform(this->m_modelViewUniform);
-    this->m_shaderProgram->addUniform(this->m_projectionUniform);
-    this->m_shaderProgram->addVertexAttribute(
-      this->m_positionVertexAttribute, vesVertexAttributeKeys::Position);
-    this->m_shaderProgram->addVertexAttribute(
-      this->m_normalVertexAttribute, vesVertexAttributeKeys::Normal);
     this->m_depth->disable();
   }
 
@@ -70,27 +59,28 @@ public:
   {
   }
 
-  void deleteBackground();
-  void createBackground(vesBackground *background, const vesVector4f &topColor,
-                        const vesVector4f &bottomColor);
-  void createBackground(const vesVector4f &topColor,
-                        const vesVector4f &bottomColor);
-  vesSharedPtr<vesGeometryData> createBackgroundPlane(
-    const vesVector4f &topColor, const vesVector4f &bottomColor);
+  void createBackground(vesBackground *background);
+  vesSharedPtr<vesGeometryData> createBackgroundPlane();
+  void setColors(const vesVector4f &topColor, const vesVector4f &bottomColor);
+  void setImage(const vesSharedPtr<vesImage> &image);
 
+  // The gradient is interpolated along the plane from the colors given as
+  // uniforms, so changing them does not touch the geometry.  Both shaders
+  // map the plane to the region of the background that is drawn.
   void createShaderSourceForNonTexturedPlane(std::string &vertShaderText,
                                              std::string &fragShaderText)
   {
     const std::string vertexShaderSource =
-      "uniform highp mat4 modelViewMatrix;\n \
-       uniform highp mat4 projectionMatrix;\n \
+      "uniform mediump vec4 topColor;\n \
+       uniform mediump vec4 bottomColor;\n \
+       uniform highp vec4 region;\n \
        attribute highp vec4 vertexPosition;\n \
-       attribute mediump vec4 vertexColor;\n \
        varying mediump vec4 varColor;\n \
        void main()\n \
        {\n \
          gl_Position = vertexPosition;\n \
-         varColor = vertexColor;\n \
+         highp float height = mix(region.y, region.w, vertexPosition.y * 0.5 + 0.5);\n \
+         varColor = mix(bottomColor, topColor, height);\n \
        }";
 
     const std::string fragmentShaderSource =
@@ -108,15 +98,14 @@ public:
                                           std::string &fragShaderText)
   {
     const std::string vertexShaderSource =
-      "uniform highp mat4 modelViewMatrix;\n \
-       uniform highp mat4 projectionMatrix;\n \
+      "uniform highp vec4 region;\n \
        attribute highp vec4 vertexPosition;\n \
        attribute mediump vec3 vertexTextureCoordinate;\n \
        varying mediump vec2 textureCoordinate;\n \
        void main()\n \
        {\n \
          gl_Position = vertexPosition;\n \
-         textureCoordinate = vertexTextureCoordinate.xy;\n \
+         textureCoordinate = mix(region.xy, region.zw, vertexTextureCoordinate.xy);\n \
        }";
 
     const std::string fragmentShaderSource =
@@ -137,90 +126,89 @@ public:
   vesSharedPtr<vesActor> m_backgroundActor;
   vesSharedPtr<vesMapper> m_backgroundMapper;
   vesSharedPtr<vesMaterial> m_backgroundMaterial;
-  vesSharedPtr<vesShaderProgram> m_shaderProgram;
-  vesSharedPtr<vesShader> m_vertexShader;
-  vesSharedPtr<vesShader> m_fragmentShader;
-  vesSharedPtr<vesModelViewUniform> m_modelViewUniform;
-  vesSharedPtr<vesProjectionUniform> m_projectionUniform;
+  vesSharedPtr<vesShaderProgram> m_gradientShaderProgram;
+  vesSharedPtr<vesShaderProgram> m_imageShaderProgram;
+  vesSharedPtr<vesUniform> m_topColorUniform;
+  vesSharedPtr<vesUniform> m_bottomColorUniform;
+  vesSharedPtr<vesUniform> m_regionUniform;
   vesSharedPtr<vesPositionVertexAttribute> m_positionVertexAttribute;
-  vesSharedPtr<vesNormalVertexAttribute> m_normalVertexAttribute;
-  vesSharedPtr<vesColorVertexAttribute> m_colorVertexAttribute;
   vesSharedPtr<vesTextureCoordinateVertexAttribute> m_textureCoodinateAttribute;
   vesSharedPtr<vesGeometryData> m_backgroundPlaneData;
   vesSharedPtr<vesDepth> m_depth;
   vesSharedPtr<vesImage> m_image;
   vesSharedPtr<vesTexture> m_texture;
-
-  vesVector4f m_topColor;
-  vesVector4f m_bottomColor;
 };
 
 
-void vesBackground::vesInternal::deleteBackground()
-{
-}
-
-
-void vesBackground::vesInternal::createBackground(const vesVector4f &topColor,
-  const vesVector4f &bottomColor)
+void vesBackground::vesInternal::createBackground(vesBackground *background)
 {
-  this->m_backgroundActor = vesActor::Ptr(new vesActor());
-  this->m_backgroundMapper = vesMapper::Ptr(new vesMapper());
-
-  this->m_backgroundPlaneData =
-    this->createBackgroundPlane(topColor, bottomColor);
-
   std::string vertShaderText;
   std::string fragShaderText;
 
-  if(!this->m_image)
-  {
-    this->createShaderSourceForNonTexturedPlane(vertShaderText, fragShaderText);
-    this->m_shaderProgram->addVertexAttribute(
-      this->m_colorVertexAttribute, vesVertexAttributeKeys::Color);
-  }
-  else
-  {
-    this->createShaderSourceForTexturedPlane(vertShaderText, fragShaderText);
-    this->m_shaderProgram->addVertexAttribute(
-      this->m_textureCoodinateAttribute,
-      vesVertexAttributeKeys::TextureCoordinate);
-  }
+  this->createShaderSourceForNonTexturedPlane(vertShaderText, fragShaderText);
+  this->m_gradientShaderProgram->addShader(
+    vesShader::Ptr(new vesShader(vesShader::Vertex, vertShaderText)));
+  this->m_gradientShaderProgram->addShader(
+    vesShader::Ptr(new vesShader(vesShader::Fragment, fragShaderText)));
+  this->m_gradientShaderProgram->addUniform(this->m_topColorUniform);
+  this->m_gradientShaderProgram->addUniform(this->m_bottomColorUniform);
+  this->m_gradientShaderProgram->addUniform(this->m_regionUniform);
+  this->m_gradientShaderProgram->addVertexAttribute(
+    this->m_positionVertexAttribute, vesVertexAttributeKeys::Position);
+
+  this->createShaderSourceForTexturedPlane(vertShaderText, fragShaderText);
+  this->m_imageShaderProgram->addShader(
+    vesShader::Ptr(new vesShader(vesShader::Vertex, vertShaderText)));
+  this->m_imageShaderProgram->addShader(
+    vesShader::Ptr(new vesShader(vesShader::Fragment, fragShaderText)));
+  this->m_imageShaderProgram->addUniform(this->m_regionUniform);
+  this->m_imageShaderProgram->addVertexAttribute(
+    this->m_positionVertexAttribute, vesVertexAttributeKeys::Position);
+  this->m_imageShaderProgram->addVertexAttribute(
+    this->m_textureCoodinateAttribute, vesVertexAttributeKeys::TextureCoordinate);
+
+  // The plane and its buffers are created once; colors and images only
+  // change the uniforms and the texture drawn on it.
+  this->m_backgroundPlaneData = this->createBackgroundPlane();
+  this->m_backgroundMapper->setGeometryData(this->m_backgroundPlaneData);
+  this->m_backgroundActor->setMapper(this->m_backgroundMapper);
+  this->m_backgroundActor->setMaterial(this->m_backgroundMaterial);
+  this->m_backgroundMaterial->addAttribute(this->m_gradientShaderProgram);
+  this->m_backgroundMaterial->addAttribute(this->m_depth);
 
-  this->m_vertexShader->setShaderSource(vertShaderText);
-  this->m_fragmentShader->setShaderSource(fragShaderText);
+  background->addChild(this->m_backgroundActor);
 }
 
 
-void vesBackground::vesInternal::createBackground(vesBackground *background,
-  const vesVector4f &topColor, const vesVector4f &bottomColor)
+void vesBackground::vesInternal::setColors(const vesVector4f &topColor,
+                                          const vesVector4f &bottomColor)
 {
-  if (this->m_backgroundActor) {
-    background->removeChild(this->m_backgroundActor);
-  }
+  this->m_topColorUniform->set(topColor);
+  this->m_bottomColorUniform->set(bottomColor);
+}
 
-  this->deleteBackground();
-  this->createBackground(topColor, bottomColor);
 
-  this->m_backgroundActor->setMapper(this->m_backgroundMapper);
-  this->m_backgroundMapper->setGeometryData(this->m_backgroundPlaneData);
-  this->m_backgroundActor->setMaterial(this->m_backgroundMaterial);
-  this->m_backgroundMaterial->addAttribute(this->m_shaderProgram);
-  this->m_backgroundMaterial->addAttribute(this->m_depth);
+void vesBackground::vesInternal::setImage(const vesSharedPtr<vesImage> &image)
+{
+  this->m_image = image;
 
-  if(this->m_image)
-  {
+  if (!image) {
+    this->m_backgroundMaterial->addAttribute(this->m_gradientShaderProgram);
+    return;
+  }
+
+  // The texture is kept when switching back to a gradient, so that the next
+  // image of the same size is uploaded into it.
+  if (!this->m_texture) {
     this->m_texture = vesSharedPtr<vesTexture>(new vesTexture());
-    this->m_texture->setImage(this->m_image);
     this->m_backgroundMaterial->addAttribute(this->m_texture);
   }
-
-  background->addChild(this->m_backgroundActor);
+  this->m_texture->setImage(image);
+  this->m_backgroundMaterial->addAttribute(this->m_imageShaderProgram);
 }
 
 
-vesSharedPtr<vesGeometryData> vesBackground::vesInternal::createBackgroundPlane(
-  const vesVector4f &topColor, const vesVector4f &bottomColor)
+vesSharedPtr<vesGeometryData> vesBackground::vesInternal::createBackgroundPlane()
 {
   vesGeometryData::Ptr backgroundGeometryData (new vesGeometryData());
   vesSourceDataP3T3C3f::Ptr sourceData(new vesSourceDataP3T3C3f());
@@ -228,22 +216,22 @@ vesSharedPtr<vesGeometryData> vesBackground::vesInternal::createBackgroundPlane(
   // Points.
   vesVertexDataP3T3C3f v1;
   v1.m_position = vesVector3f(-1.0f, -1.0f, 0.0f);
-  v1.m_color = vesVector3f(bottomColor[0], bottomColor[1], bottomColor[2]);
+  v1.m_color = vesVector3f(1.0f, 1.0f, 1.0f);
   v1.m_texureCoordinates = vesVector3f(0.0f, 0.0f, 0.0f);
 
   vesVertexDataP3T3C3f v2;
   v2.m_position = vesVector3f(1.0f, -1.0f, 0.0f);
-  v2.m_color = vesVector3f(bottomColor[0], bottomColor[1], bottomColor[2]);
+  v2.m_color = vesVector3f(1.0f, 1.0f, 1.0f);
   v2.m_texureCoordinates = vesVector3f(1.0f, 0.0f, 0.0f);
 
   vesVertexDataP3T3C3f v3;
   v3.m_position = vesVector3f(1.0f, 1.0f, 0.0f);
-  v3.m_color = vesVector3f(topColor[0], topColor[1], topColor[2]);
+  v3.m_color = vesVector3f(1.0f, 1.0f, 1.0f);
   v3.m_texureCoordinates = vesVector3f(1.0f, 1.0f, 0.0f);
 
   vesVertexDataP3T3C3f v4;
   v4.m_position = vesVector3f(-1.0f, 1.0f, 0.0f);
-  v4.m_color = vesVector3f(topColor[0], topColor[1], topColor[2]);
+  v4.m_color = vesVector3f(1.0f, 1.0f, 1.0f);
   v4.m_texureCoordinates = vesVector3f(0.0f, 1.0f, 0.0f);
 
   sourceData->pushBack(v1);
@@ -310,15 +298,16 @@ void vesBackground::setGradientColor(const vesVector4f &topColor,
 {
   this->m_topColor = topColor;
   this->m_bottomColor = bottomColor;
-  this->m_internal->m_image.reset();
-  this->createBackground();
+  this->m_internal->setColors(topColor, bottomColor);
+  if (this->m_internal->m_image) {
+    this->m_internal->setImage(vesSharedPtr<vesImage>());
+  }
 }
 
 
 void vesBackground::setImage(const vesSharedPtr<vesImage> image)
 {
-  this->m_internal->m_image = image;
-  this->createBackground();
+  this->m_internal->setImage(image);
 }
 
 
@@ -328,6 +317,12 @@ vesSharedPtr<vesImage> vesBackground::image() const
 }
 
 
+void vesBackground::setRegion(float left, float bottom, float right, float top)
+{
+  this->m_internal->m_regionUniform->set(vesVector4f(left, bottom, right, top));
+}
+
+
 vesMatrix4x4f vesBackground::modelViewMatrix()
 {
   return vesMatrix4x4f::Identity();
@@ -343,5 +338,6 @@ vesMatrix4x4f vesBackground::projectionMatrix()
 
 void vesBackground::createBackground()
 {
-  this->m_internal->createBackground(this, this->m_topColor, this->m_bottomColor);
+  this->m_internal->createBackground(this);
+  this->m_internal->setColors(this->m_topColor, this->m_bottomColor);
 }
@@ -60,6 +60,12 @@ public:
   /// Get image for the background
   vesSharedPtr<vesImage> image() const;
 
+  /// Set the region of the background drawn in the viewport, in fractions of
+  /// the background from its bottom left corner.  Tiles of a larger image
+  /// draw the part of the gradient or image they cover.  The default region
+  /// is the whole background, (0, 0, 1, 1).
+  void setRegion(float left, float bottom, float right, float top);
+
   /// \copydoc vesCamera::modelViewMatrix()
   virtual vesMatrix4x4f modelViewMatrix();
 
@@ -0,0 +1,553 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesBatchedMapper.h"
+
+// VES includes
+#include "vesActor.h"
+#include "vesGeometryData.h"
+#include "vesGL.h"
+#include "vesGLTypes.h"
+#include "vesVertexAttributeKeys.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cstring>
+#include <map>
+#include <stdint.h>
+#include <typeinfo>
+#include <vector>
+
+namespace {
+
+struct vesBatchAttribute
+{
+  vesBatchAttribute(int key, unsigned int type, unsigned int numberOfComponents,
+                    unsigned int sizeOfDataType, bool normalized) :
+    m_key(key),
+    m_type(type),
+    m_numberOfComponents(numberOfComponents),
+    m_sizeOfDataType(sizeOfDataType),
+    m_normalized(normalized)
+  {
+  }
+
+  unsigned int sizeInBytes() const
+  {
+    return this->m_numberOfComponents * this->m_sizeOfDataType;
+  }
+
+  bool operator==(const vesBatchAttribute &other) const
+  {
+    return this->m_key == other.m_key && this->m_type == other.m_type
+      && this->m_numberOfComponents == other.m_numberOfComponents
+      && this->m_sizeOfDataType == other.m_sizeOfDataType
+      && this->m_normalized == other.m_normalized;
+  }
+
+  bool operator<(const vesBatchAttribute &other) const
+  {
+    return this->m_key < other.m_key;
+  }
+
+  int m_key;
+  unsigned int m_type;
+  unsigned int m_numberOfComponents;
+  unsigned int m_sizeOfDataType;
+  bool m_normalized;
+};
+
+typedef std::vector<vesBatchAttribute> vesBatchLayout;
+
+// Tightly packed data of a single attribute.
+class vesBatchSourceData : public vesGenericSourceData<unsigned char>
+{
+public:
+  vesTypeMacro(vesBatchSourceData);
+
+  vesBatchSourceData(const vesBatchAttribute &attribute) :
+    vesGenericSourceData<unsigned char>(),
+    m_vertexSize(attribute.sizeInBytes())
+  {
+    this->setAttributeDataType(attribute.m_key, attribute.m_type);
+    this->setAttributeOffset(attribute.m_key, 0);
+    this->setAttributeStride(attribute.m_key, this->m_vertexSize);
+    this->setNumberOfComponents(attribute.m_key, attribute.m_numberOfComponents);
+    this->setSizeOfAttributeDataType(attribute.m_key, attribute.m_sizeOfDataType);
+    this->setIsAttributeNormalized(attribute.m_key, attribute.m_normalized);
+  }
+
+  virtual unsigned int sizeOfArray() const
+  {
+    return static_cast<unsigned int>(this->m_data.size() / this->m_vertexSize);
+  }
+
+  virtual unsigned int sizeInBytes() const
+  {
+    return static_cast<unsigned int>(this->m_data.size());
+  }
+
+  inline void pushBackVertex(const void *vertex)
+  {
+    const unsigned char *bytes = static_cast<const unsigned char*>(vertex);
+    this->m_data.insert(this->m_data.end(), bytes, bytes + this->m_vertexSize);
+  }
+
+  inline unsigned char* vertex(unsigned int index)
+  {
+    return &this->m_data[index * this->m_vertexSize];
+  }
+
+private:
+  unsigned int m_vertexSize;
+};
+
+struct vesBatchRange
+{
+  vesBatchRange(unsigned int first, unsigned int count) :
+    m_first(first),
+    m_count(count)
+  {
+  }
+
+  unsigned int m_first;
+  unsigned int m_count;
+};
+
+struct vesBatchPrimitive
+{
+  vesPrimitive::Ptr m_primitive;
+  vesSharedPtr< vesIndices<unsigned short> > m_indices;
+
+  // One range per part, and the merged ranges of the visible parts.
+  std::vector<vesBatchRange> m_partRanges;
+  std::vector<vesBatchRange> m_visibleRanges;
+};
+
+vesBatchLayout layoutOf(vesGeometryData::Ptr geometry)
+{
+  vesBatchLayout layout;
+  for (unsigned int i = 0; i < geometry->numberOfSources(); ++i) {
+    vesSourceData::Ptr source = geometry->source(i);
+    std::vector<int> keys = source->keys();
+    for (size_t j = 0; j < keys.size(); ++j) {
+      layout.push_back(vesBatchAttribute(keys[j],
+        source->attributeDataType(keys[j]), source->numberOfComponents(keys[j]),
+        source->sizeOfAttributeDataType(keys[j]), source->isAttributeNormalized(keys[j])));
+    }
+  }
+
+  // The mapper color is baked into parts without vertex colors.
+  if (!geometry->sourceData(vesVertexAttributeKeys::Color)) {
+    layout.push_back(vesBatchAttribute(vesVertexAttributeKeys::Color,
+      vesDataType::Float, 3, sizeof(float), false));
+  }
+
+  std::sort(layout.begin(), layout.end());
+  return layout;
+}
+
+unsigned int readIndex(vesPrimitive::Ptr primitive, unsigned int index)
+{
+  if (primitive->sizeOfDataType() == sizeof(unsigned short)) {
+    return static_cast<const unsigned short*>(primitive->data())[index];
+  }
+  return static_cast<const unsigned int*>(primitive->data())[index];
+}
+
+void transformVector3f(const vesMatrix3x3f &matrix, const vesVector3f &translation,
+                       bool normalize, unsigned char *bytes)
+{
+  float values[3];
+  memcpy(values, bytes, sizeof(values));
+  vesVector3f result = matrix * vesVector3f(values[0], values[1], values[2]) + translation;
+  if (normalize && result.norm() > 0.0f) {
+    result.normalize();
+  }
+  values[0] = result[0];
+  values[1] = result[1];
+  values[2] = result[2];
+  memcpy(bytes, values, sizeof(values));
+}
+
+}
+
+class vesBatchedMapper::vesBatch
+{
+public:
+  vesBatch() :
+    m_numberOfVertices(0),
+    m_drawCalls(0),
+    m_visibilityDirty(true),
+    m_anyVisible(false),
+    m_geometry(new vesGeometryData())
+  {
+    this->m_geometry->setName("vesBatchedMapper");
+  }
+
+  vesBatchPrimitive& primitive(unsigned int type, unsigned int indexCount,
+                               std::map<unsigned int, unsigned int> &starts);
+  void updateVisibleRanges();
+
+  std::vector<vesSharedPtr<vesActor> > m_parts;
+  std::vector<bool> m_visibility;
+  vesBatchLayout m_layout;
+  std::map<int, vesBatchSourceData::Ptr> m_sources;
+  std::map<unsigned int, vesBatchPrimitive> m_primitives;
+  unsigned int m_numberOfVertices;
+  vesVector3f m_boundsMin;
+  vesVector3f m_boundsMax;
+  int m_drawCalls;
+  bool m_visibilityDirty;
+  bool m_anyVisible;
+
+  vesGeometryData::Ptr m_geometry;
+};
+
+
+vesBatchPrimitive& vesBatchedMapper::vesBatch::primitive(unsigned int type,
+  unsigned int indexCount, std::map<unsigned int, unsigned int> &starts)
+{
+  std::map<unsigned int, vesBatchPrimitive>::iterator itr =
+    this->m_primitives.find(type);
+  if (itr != this->m_primitives.end()) {
+    return itr->second;
+  }
+
+  vesBatchPrimitive &result = this->m_primitives[type];
+  result.m_indices = vesSharedPtr< vesIndices<unsigned short> >(
+    new vesIndices<unsigned short>());
+  result.m_primitive = vesPrimitive::Ptr(new vesPrimitive());
+  result.m_primitive->setPrimitiveType(type);
+  result.m_primitive->setIndexCount(indexCount);
+  result.m_primitive->setIndicesValueType(vesPrimitiveIndicesValueType::UnsignedShort);
+  result.m_primitive->setVesIndices(result.m_indices);
+  this->m_geometry->addPrimitive(result.m_primitive);
+
+  // The parts merged so far have none of this type.
+  result.m_partRanges.resize(this->m_parts.size(), vesBatchRange(0, 0));
+  starts[type] = 0;
+  return result;
+}
+
+
+void vesBatchedMapper::vesBatch::updateVisibleRanges()
+{
+  bool changed = this->m_visibilityDirty;
+  this->m_visibility.resize(this->m_parts.size());
+  for (size_t i = 0; i < this->m_parts.size(); ++i) {
+    const bool visible = this->m_parts[i]->isVisible();
+    changed |= (this->m_visibility[i] != visible);
+    this->m_visibility[i] = visible;
+  }
+
+  if (!changed) {
+    return;
+  }
+
+  this->m_anyVisible = std::find(this->m_visibility.begin(),
+    this->m_visibility.end(), true) != this->m_visibility.end();
+
+  std::map<unsigned int, vesBatchPrimitive>::iterator itr =
+    this->m_primitives.begin();
+  for (; itr != this->m_primitives.end(); ++itr) {
+    std::vector<vesBatchRange> &runs = itr->second.m_visibleRanges;
+    runs.clear();
+    for (size_t i = 0; i < this->m_parts.size(); ++i) {
+      const vesBatchRange &range = itr->second.m_partRanges[i];
+      if (!this->m_visibility[i] || !range.m_count) {
+        continue;
+      }
+      if (!runs.empty() && runs.back().m_first + runs.back().m_count == range.m_first) {
+        runs.back().m_count += range.m_count;
+      }
+      else {
+        runs.push_back(range);
+      }
+    }
+  }
+
+  this->m_visibilityDirty = false;
+}
+
+
+vesBatchedMapper::vesBatchedMapper() : vesMapper(),
+  m_batch(0x0)
+{
+  this->m_batch = new vesBatch();
+  this->setGeometryData(this->m_batch->m_geometry);
+}
+
+
+vesBatchedMapper::~vesBatchedMapper()
+{
+  delete this->m_batch; this->m_batch = 0x0;
+}
+
+
+bool vesBatchedMapper::isBatchable(vesSharedPtr<vesActor> actor)
+{
+  if (!actor || !actor->mapper() || typeid(*actor->mapper()) != typeid(vesMapper)) {
+    return false;
+  }
+
+  vesGeometryData::Ptr geometry = actor->mapper()->geometryData();
+  if (!geometry) {
+    return false;
+  }
+
+  vesSourceData::Ptr positions = geometry->sourceData(vesVertexAttributeKeys::Position);
+  if (!positions || !positions->sizeOfArray()
+      || positions->attributeDataType(vesVertexAttributeKeys::Position) != vesDataType::Float
+      || positions->numberOfComponents(vesVertexAttributeKeys::Position) != 3
+      || positions->sizeOfArray() > static_cast<unsigned int>(maximumVerticesPerBatch())) {
+    return false;
+  }
+
+  for (unsigned int i = 0; i < geometry->numberOfSources(); ++i) {
+    if (geometry->source(i)->sizeOfArray() != positions->sizeOfArray()) {
+      return false;
+    }
+  }
+
+  for (unsigned int i = 0; i < geometry->numberOfPrimitiveTypes(); ++i) {
+    vesPrimitive::Ptr primitive = geometry->primitive(i);
+    const unsigned int type = primitive->primitiveType();
+    if (!primitive->numberOfIndices()
+        || (type != vesPrimitiveRenderType::Triangles
+            && type != vesPrimitiveRenderType::Lines
+            && type != vesPrimitiveRenderType::Points)) {
+      return false;
+    }
+  }
+
+  return geometry->numberOfPrimitiveTypes() > 0;
+}
+
+
+bool vesBatchedMapper::addPart(vesSharedPtr<vesActor> actor)
+{
+  if (!isBatchable(actor)) {
+    return false;
+  }
+
+  vesMapper::Ptr mapper = actor->mapper();
+  vesGeometryData::Ptr geometry = mapper->geometryData();
+  const vesBatchLayout layout = layoutOf(geometry);
+  const unsigned int numberOfVertices =
+    geometry->sourceData(vesVertexAttributeKeys::Position)->sizeOfArray();
+
+  if (this->m_batch->m_parts.empty()) {
+    this->m_batch->m_layout = layout;
+    for (size_t i = 0; i < layout.size(); ++i) {
+      vesBatchSourceData::Ptr source(new vesBatchSourceData(layout[i]));
+      this->m_batch->m_sources[layout[i].m_key] = source;
+      this->m_batch->m_geometry->addSource(source);
+    }
+    this->setColor(mapper->color()[0], mapper->color()[1], mapper->color()[2],
+                   mapper->color()[3]);
+    this->setPointSize(mapper->pointSize());
+    this->setLineWidth(mapper->lineWidth());
+    this->enableWireframe(mapper->isEnabledWireframe());
+  }
+  else if (!(layout == this->m_batch->m_layout)
+           || mapper->color()[3] != this->color()[3]
+           || mapper->pointSize() != this->pointSize()
+           || mapper->lineWidth() != this->lineWidth()
+           || mapper->isEnabledWireframe() != this->isEnabledWireframe()) {
+    return false;
+  }
+
+  if (this->m_batch->m_numberOfVertices + numberOfVertices
+      > static_cast<unsigned int>(maximumVerticesPerBatch())) {
+    return false;
+  }
+
+  // Copy the vertices, moving positions and normals to the parent frame.
+  const vesMatrix4x4f matrix = actor->modelViewMatrix();
+  const vesMatrix3x3f linear = matrix.topLeftCorner<3, 3>();
+  const vesMatrix3x3f normalMatrix = linear.inverse().transpose();
+  const vesVector3f translation = matrix.topRightCorner<3, 1>();
+  const unsigned int base = this->m_batch->m_numberOfVertices;
+
+  for (unsigned int i = 0; i < geometry->numberOfSources(); ++i) {
+    vesSourceData::Ptr source = geometry->source(i);
+    std::vector<int> keys = source->keys();
+    for (size_t j = 0; j < keys.size(); ++j) {
+      const int key = keys[j];
+      vesBatchSourceData::Ptr target = this->m_batch->m_sources[key];
+      const unsigned char *data = static_cast<const unsigned char*>(source->data())
+        + source->attributeOffset(key);
+      const unsigned int stride = source->attributeStride(key)
+        ? source->attributeStride(key)
+        : source->numberOfComponents(key) * source->sizeOfAttributeDataType(key);
+      const bool isVector3f = source->attributeDataType(key) == vesDataType::Float
+        && source->numberOfComponents(key) >= 3;
+
+      for (unsigned int v = 0; v < numberOfVertices; ++v) {
+        target->pushBackVertex(data + v * stride);
+        if (key == vesVertexAttributeKeys::Position) {
+          transformVector3f(linear, translation, false, target->vertex(base + v));
+        }
+        else if (key == vesVertexAttributeKeys::Normal && isVector3f) {
+          transformVector3f(normalMatrix, vesVector3f(0.0f, 0.0f, 0.0f), true,
+                            target->vertex(base + v));
+        }
+      }
+    }
+  }
+
+  if (!geometry->sourceData(vesVertexAttributeKeys::Color)) {
+    vesBatchSourceData::Ptr colors = this->m_batch->m_sources[vesVertexAttributeKeys::Color];
+    for (unsigned int v = 0; v < numberOfVertices; ++v) {
+      colors->pushBackVertex(mapper->color());
+    }
+  }
+
+  vesBatchSourceData::Ptr positions =
+    this->m_batch->m_sources[vesVertexAttributeKeys::Position];
+  for (unsigned int v = 0; v < numberOfVertices; ++v) {
+    const float *point = reinterpret_cast<const float*>(positions->vertex(base + v));
+    for (int k = 0; k < 3; ++k) {
+      if (base + v == 0 || point[k] < this->m_batch->m_boundsMin[k]) {
+        this->m_batch->m_boundsMin[k] = point[k];
+      }
+      if (base + v == 0 || point[k] > this->m_batch->m_boundsMax[k]) {
+        this->m_batch->m_boundsMax[k] = point[k];
+      }
+    }
+  }
+
+  // Append the indices, recording the range of the part per primitive type.
+  std::map<unsigned int, unsigned int> starts;
+  std::map<unsigned int, vesBatchPrimitive>::iterator itr =
+    this->m_batch->m_primitives.begin();
+  for (; itr != this->m_batch->m_primitives.end(); ++itr) {
+    starts[itr->first] = itr->second.m_indices->size();
+  }
+
+  for (unsigned int i = 0; i < geometry->numberOfPrimitiveTypes(); ++i) {
+    vesPrimitive::Ptr primitive = geometry->primitive(i);
+    vesBatchPrimitive &target = this->m_batch->primitive(
+      primitive->primitiveType(), primitive->indexCount(), starts);
+    std::vector<unsigned short> &indices = *target.m_indices->indices();
+    for (unsigned int j = 0; j < primitive->numberOfIndices(); ++j) {
+      indices.push_back(static_cast<unsigned short>(base + readIndex(primitive, j)));
+    }
+  }
+
+  for (itr = this->m_batch->m_primitives.begin();
+       itr != this->m_batch->m_primitives.end(); ++itr) {
+    const unsigned int first = starts[itr->first];
+    itr->second.m_partRanges.push_back(
+      vesBatchRange(first, itr->second.m_indices->size() - first));
+  }
+
+  this->m_batch->m_parts.push_back(actor);
+  this->m_batch->m_numberOfVertices += numberOfVertices;
+  this->m_batch->m_visibilityDirty = true;
+
+  this->m_initialized = false;
+  this->setBoundsDirty(true);
+  return true;
+}
+
+
+int vesBatchedMapper::numberOfParts() const
+{
+  return static_cast<int>(this->m_batch->m_parts.size());
+}
+
+
+vesSharedPtr<vesActor> vesBatchedMapper::part(int index) const
+{
+  return this->m_batch->m_parts[index];
+}
+
+
+int vesBatchedMapper::maximumVerticesPerBatch()
+{
+  return 65536;
+}
+
+
+int vesBatchedMapper::numberOfDrawCalls() const
+{
+  return this->m_batch->m_drawCalls;
+}
+
+
+void vesBatchedMapper::computeBounds()
+{
+  if (this->m_batch->m_parts.empty()) {
+    return;
+  }
+
+  this->setBounds(this->m_batch->m_boundsMin, this->m_batch->m_boundsMax);
+  this->setBoundsDirty(false);
+}
+
+
+void vesBatchedMapper::render(const vesRenderState &renderState)
+{
+  this->m_batch->m_drawCalls = 0;
+  if (this->m_batch->m_parts.empty()) {
+    return;
+  }
+
+  this->m_batch->updateVisibleRanges();
+  if (!this->m_batch->m_anyVisible) {
+    return;
+  }
+
+  vesMapper::render(renderState);
+}
+
+
+void vesBatchedMapper::drawElements(unsigned int mode, int count,
+                                    unsigned int type, const void *offset)
+{
+  // Wireframe draws the triangles one line loop at a time.
+  const unsigned int primitiveType = (mode == vesPrimitiveRenderType::LineLoop)
+    ? static_cast<unsigned int>(vesPrimitiveRenderType::Triangles) : mode;
+
+  std::map<unsigned int, vesBatchPrimitive>::const_iterator itr =
+    this->m_batch->m_primitives.find(primitiveType);
+  if (itr == this->m_batch->m_primitives.end()) {
+    vesMapper::drawElements(mode, count, type, offset);
+    ++this->m_batch->m_drawCalls;
+    return;
+  }
+
+  const unsigned int first = static_cast<unsigned int>(
+    reinterpret_cast<uintptr_t>(offset) / sizeof(unsigned short));
+  const unsigned int last = first + count;
+
+  const std::vector<vesBatchRange> &runs = itr->second.m_visibleRanges;
+  for (size_t i = 0; i < runs.size() && runs[i].m_first < last; ++i) {
+    const unsigned int runFirst = std::max(first, runs[i].m_first);
+    const unsigned int runLast = std::min(last, runs[i].m_first + runs[i].m_count);
+    if (runFirst < runLast) {
+      uintptr_t runOffset = runFirst * sizeof(unsigned short);
+      vesMapper::drawElements(mode, runLast - runFirst, type, (void*)runOffset);
+      ++this->m_batch->m_drawCalls;
+    }
+  }
+}
@@ -0,0 +1,93 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesBatchedMapper
+/// \ingroup ves
+/// \brief Mapper that draws the merged geometry of many static actors.
+///
+/// Every part is an actor whose mapper geometry is copied, pre-transformed by
+/// the actor matrix, into one vertex buffer per attribute and one index
+/// buffer per primitive type.  A part without vertex colors gets its mapper
+/// color baked into a Color attribute.  Each part owns a contiguous index
+/// range, and render() polls the visibility of the part actors every frame
+/// and only draws the ranges of the visible ones, merging neighbours, so a
+/// fully visible batch takes one draw call per primitive type.
+///
+/// Indices are 16 bit, which limits a batch to maximumVerticesPerBatch()
+/// vertices.
+///
+/// \see vesStaticBatcher
+
+#ifndef VESBATCHEDMAPPER_H
+#define VESBATCHEDMAPPER_H
+
+#include "vesMapper.h"
+
+// VES includes
+#include "vesSetGet.h"
+
+// Forward declarations
+class vesActor;
+
+class vesBatchedMapper : public vesMapper
+{
+public:
+  vesTypeMacro(vesBatchedMapper);
+
+  vesBatchedMapper();
+  virtual ~vesBatchedMapper();
+
+  /// Whether the geometry of \p actor can be merged at all.  It needs a plain
+  /// vesMapper whose geometry has float positions, no more vertices than
+  /// maximumVerticesPerBatch() and only indexed triangles, lines or points.
+  static bool isBatchable(vesSharedPtr<vesActor> actor);
+
+  /// Merge the geometry of \p actor.  Fails, leaving the batch unchanged, if
+  /// the vertex layout or the point size, line width, wireframe mode or
+  /// opacity differ from the first part, or if the batch would grow beyond
+  /// maximumVerticesPerBatch().
+  bool addPart(vesSharedPtr<vesActor> actor);
+
+  int numberOfParts() const;
+  vesSharedPtr<vesActor> part(int index) const;
+
+  /// Number of vertices a batch can hold with 16 bit indices.
+  static int maximumVerticesPerBatch();
+
+  /// Number of draw calls issued by the last render().
+  int numberOfDrawCalls() const;
+
+  /// Bounds of all parts, visible or not.
+  virtual void computeBounds();
+
+  virtual void render(const vesRenderState &renderState);
+
+protected:
+  virtual void drawElements(unsigned int mode, int count, unsigned int type,
+                            const void *offset);
+
+private:
+  vesBatchedMapper(const vesBatchedMapper&); // Not implemented
+  void operator=(const vesBatchedMapper&); // Not implemented
+
+  class vesBatch;
+  vesBatch *m_batch;
+};
+
+#endif // VESBATCHEDMAPPER_H
@@ -20,6 +20,9 @@
 
 #include "vesBlend.h"
 
+// VES includes
+#include "vesGLStateCache.h"
+
 // C/C++ includes
 #include <iostream>
 
@@ -46,13 +49,14 @@ void vesBlend::setBlendFunction(const vesBlendFunction &blendFunction)
 
 void vesBlend::bind(const vesRenderState &renderState)
 {
-  this->m_wasEnabled = glIsEnabled(GL_BLEND);
+  vesGLStateCache *state = vesGLStateCache::current();
+  this->m_wasEnabled = state->isEnabled(GL_BLEND);
 
   if (this->m_enable) {
-    glEnable(GL_BLEND);
+    state->enable(GL_BLEND);
     this->m_blendFunction.apply(renderState);
   } else {
-    glDisable(GL_BLEND);
+    state->disable(GL_BLEND);
   }
 }
 
@@ -61,11 +65,7 @@ void vesBlend::unbind(const vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
-  if (this->m_wasEnabled) {
-    glEnable(GL_BLEND);
-  } else {
-    glDisable(GL_BLEND);
-  }
+  vesGLStateCache::current()->setEnabled(GL_BLEND, this->m_wasEnabled);
 
   this->setDirtyStateOff();
 }
@@ -21,6 +21,7 @@
 #include "vesBlendFunction.h"
 
 // VES includes
+#include "vesGLStateCache.h"
 #include "vesRenderState.h"
 
 vesBlendFunction::vesBlendFunction(Parameter source, Parameter destination) :
@@ -39,6 +40,6 @@ void vesBlendFunction::apply(const vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
-  glBlendFunc(m_source, m_destination);
+  vesGLStateCache::current()->blendFunc(m_source, m_destination);
 }
 
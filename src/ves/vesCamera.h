@@ -191,6 +191,10 @@ public:
   /// one large screen.
   void setWindowCenter(double x, double y);
 
+  /// Get the center of the window in viewport coordinates.
+  vesVector2f windowCenter() const
+    { return vesVector2f(this->m_windowCenter[0], this->m_windowCenter[1]); }
+
   /// Set the location of the near and far clipping planes along the
   /// direction of projection.  Both of these values must be positive.
   /// How the clipping planes are set can have a large impact on how
@@ -24,19 +24,56 @@
 #include "vesActor.h"
 #include "vesCamera.h"
 #include "vesGroupNode.h"
+#include "vesMapper.h"
 #include "vesNode.h"
 #include "vesRenderStage.h"
 #include "vesTransformNode.h"
 
+// C/C++ includes
+#include <cmath>
+
 void vesCullVisitor::addGeometryAndStates(
   const vesSharedPtr<vesMapper> &mapper,
   const vesSharedPtr<vesMaterial> &material,
   const vesMatrix4x4f &modelViewMatrix,
   const vesMatrix4x4f &projectionMatrix,
-  float depth)
+  float depth, int levelOfDetail)
 {
   this->renderStage()->addRenderLeaf(
-    vesRenderLeaf(depth, modelViewMatrix, projectionMatrix, material, mapper));
+    vesRenderLeaf(depth, modelViewMatrix, projectionMatrix, material, mapper,
+                  levelOfDetail));
+}
+
+
+int vesCullVisitor::selectLevelOfDetail(vesMapper &mapper,
+  const vesMatrix4x4f &modelViewMatrix, const vesMatrix4x4f &projectionMatrix) const
+{
+  if (!mapper.numberOfLevelsOfDetail() || this->m_viewportHeight <= 0.0f) {
+    return 0;
+  }
+
+  if (mapper.boundsDirty()) {
+    mapper.computeBounds();
+  }
+
+  // Projected diameter of the bounding sphere, in pixels.
+  const vesVector3f &center = mapper.boundsCenter();
+  const vesVector4f eyeCenter = modelViewMatrix
+    * vesVector4f(center[0], center[1], center[2], 1.0f);
+  const float scale = modelViewMatrix.topLeftCorner<3, 3>().colwise().norm().maxCoeff();
+  const float radius = 0.5f * mapper.boundsSize().norm() * scale;
+  const float w = projectionMatrix.row(3).dot(eyeCenter);
+
+  float screenSize = this->m_viewportHeight;
+  if (w > radius) {
+    screenSize = radius * fabs(projectionMatrix(1, 1)) * this->m_viewportHeight / w;
+  }
+  else if (projectionMatrix(3, 3) != 0.0f) {
+    // Parallel projection, w is constant.
+    screenSize = radius * fabs(projectionMatrix(1, 1)) * this->m_viewportHeight;
+  }
+
+  return mapper.selectLevelOfDetail(screenSize, this->m_levelOfDetailBias);
 }
 
 
@@ -79,8 +116,10 @@ void vesCullVisitor::visit(vesActor &actor)
     }
     else {
       // \todo: We could do some optimization here.
+      const int levelOfDetail = actor.mapper() ? this->selectLevelOfDetail(
+        *actor.mapper(), this->modelViewMatrix(), this->projectionMatrix()) : 0;
       this->addGeometryAndStates(actor.mapper(), actor.material(),
-        this->modelViewMatrix(), this->projectionMatrix(), 1);
+        this->modelViewMatrix(), this->projectionMatrix(), 1, levelOfDetail);
     }
   }
 
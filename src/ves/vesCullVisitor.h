@@ -35,6 +35,7 @@
 
 // Forward declarations
 class vesCamera;
+class vesMapper;
 class vesRenderStage;
 
 class vesCullVisitor : public vesVisitor
@@ -43,7 +44,9 @@ public:
   vesTypeMacro(vesCullVisitor);
 
   vesCullVisitor(TraversalMode mode=TraverseAllChildren) :
-    vesVisitor    (CullVisitor, mode)
+    vesVisitor    (CullVisitor, mode),
+    m_viewportHeight(0.0f),
+    m_levelOfDetailBias(0)
   {
   }
 
@@ -81,6 +84,17 @@ public:
     this->m_renderStageStack.pop_back();
   }
 
+  /// Height in pixels used to measure the screen size of actors for
+  /// picking their mapper level of detail.  With 0, the default, the finest
+  /// level is used.
+  void setViewportHeight(float height) { this->m_viewportHeight = height; }
+  float viewportHeight() const { return this->m_viewportHeight; }
+
+  /// Number of levels of detail coarser than the screen size calls for,
+  /// e.g. while the camera moves.
+  void setLevelOfDetailBias(int bias) { this->m_levelOfDetailBias = bias; }
+  int levelOfDetailBias() const { return this->m_levelOfDetailBias; }
+
   virtual void visit(vesNode &node);
   virtual void visit(vesGroupNode &groupNode);
   virtual void visit(vesTransformNode &transformNode);
@@ -92,7 +106,10 @@ protected:
                             const vesSharedPtr<vesMaterial> &material,
                             const vesMatrix4x4f &modelViewMatrix,
                             const vesMatrix4x4f &projectionMatrix,
-                            float depth);
+                            float depth, int levelOfDetail = 0);
+
+  int selectLevelOfDetail(vesMapper &mapper, const vesMatrix4x4f &modelViewMatrix,
+                          const vesMatrix4x4f &projectionMatrix) const;
 
   inline void invokeCallbacksAndTraverse(vesNode &node)
   {
@@ -103,6 +120,9 @@ protected:
 
   RenderStageStack m_renderStageStack;
   vesSharedPtr<vesRenderStage> m_renderStage;
+
+  float m_viewportHeight;
+  int m_levelOfDetailBias;
 };
 
 #endif // VESCULLVISITOR_H
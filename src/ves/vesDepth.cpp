@@ -22,6 +22,7 @@
 
 // VES includes.
 #include "vesGL.h"
+#include "vesGLStateCache.h"
 
 // C/C++ includes.
 #include <iostream>
@@ -46,16 +47,17 @@ void vesDepth::bind(const vesRenderState &renderState)
   vesNotUsed(renderState);
 
   // Save current state.
-  this->m_wasEnabled = glIsEnabled(GL_DEPTH_TEST);
+  vesGLStateCache *state = vesGLStateCache::current();
+  this->m_wasEnabled = state->isEnabled(GL_DEPTH_TEST);
 
   // Save current depth mask for restoration later.
 //  glGet(GL_DEPTH_WRITEMASK, &this->m_previousDepthWriteMask);
 
   if (this->m_enable) {
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask((GLboolean) this->m_depthWriteMask);
+    state->enable(GL_DEPTH_TEST);
+    state->depthMask((GLboolean) this->m_depthWriteMask);
   } else {
-    glDisable(GL_DEPTH_TEST);
+    state->disable(GL_DEPTH_TEST);
   }
 }
 
@@ -64,11 +66,12 @@ void vesDepth::unbind(const vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
+  vesGLStateCache *state = vesGLStateCache::current();
   if (this->m_wasEnabled) {
-      glEnable(GL_DEPTH_TEST);
-      glDepthMask((GLboolean) this->m_depthWriteMask);
+      state->enable(GL_DEPTH_TEST);
+      state->depthMask((GLboolean) this->m_depthWriteMask);
   } else {
-    glDisable(GL_DEPTH_TEST);
+    state->disable(GL_DEPTH_TEST);
   }
 
   // Restore previous depth mask.
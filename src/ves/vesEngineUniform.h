@@ -93,8 +93,8 @@ public:
                               const vesRenderData  &renderData)
   {
     this->m_uniform->set(renderData.m_pritimiveType);
-    this->m_uniform->callGL(renderState.m_material->shaderProgram()->
-                            uniformLocation(this->m_uniform->name()));
+    renderState.m_material->shaderProgram()->updateUniform(
+      this->m_uniform.get());
   }
 };
 
@@ -110,8 +110,8 @@ public:
                               const vesRenderData  &renderData)
   {
     this->m_uniform->set(renderData.m_pointSize);
-    this->m_uniform->callGL(renderState.m_material->shaderProgram()->
-                            uniformLocation(this->m_uniform->name()));
+    renderState.m_material->shaderProgram()->updateUniform(
+      this->m_uniform.get());
   }
 };
 
@@ -127,8 +127,8 @@ public:
                               const vesRenderData  &renderData)
   {
     this->m_uniform->set(static_cast<float>(renderData.m_lineWidth));
-    this->m_uniform->callGL(renderState.m_material->shaderProgram()->
-                            uniformLocation(this->m_uniform->name()));
+    renderState.m_material->shaderProgram()->updateUniform(
+      this->m_uniform.get());
     glLineWidth(static_cast<int>(renderData.m_lineWidth));
   }
 };
@@ -148,8 +148,8 @@ public:
 
     vesVector2f windowSize = renderState.m_viewSize / 2.0;
     this->m_uniform->set(windowSize);
-    this->m_uniform->callGL(renderState.m_material->shaderProgram()->
-                            uniformLocation(this->m_uniform->name()));
+    renderState.m_material->shaderProgram()->updateUniform(
+      this->m_uniform.get());
   }
 };
 
@@ -32,10 +32,17 @@ class vesFBO::vesInternal
 {
 public:
   vesInternal() :
-    m_frameBufferHandle(0),
-    m_width            (0),
-    m_height           (0)
+    m_frameBufferHandle        (0),
+    m_previousFrameBufferHandle(0),
+    m_width                    (0),
+    m_height                   (0)
   {
+#ifdef VES_USE_DESKTOP_GL
+    this->m_attachmentToFormatMap[ColorAttachment0] = GL_RGBA4;
+#else
+    this->m_attachmentToFormatMap[ColorAttachment0] = GL_RGB565;
+#endif
+    this->m_attachmentToFormatMap[DepthAttachment] = GL_DEPTH_COMPONENT16;
   }
 
 
@@ -70,15 +77,21 @@ public:
 
   typedef std::map<AttachmentType, vesTexture*>  AttachmentToTextureMap;
   typedef std::map<AttachmentType, unsigned int> AttachmentToRBOMap;
+  typedef std::map<AttachmentType, unsigned int> AttachmentToFormatMap;
 
 
   unsigned int m_frameBufferHandle;
 
+  // Framebuffer bound before render(), which is not 0 when the window
+  // system renders into a framebuffer object itself, as on iOS.
+  int m_previousFrameBufferHandle;
+
   int m_width;
   int m_height;
 
   AttachmentToTextureMap m_attachmentToTextureMap;
   AttachmentToRBOMap     m_attachmentToRBOMap;
+  AttachmentToFormatMap  m_attachmentToFormatMap;
 };
 
 
@@ -92,6 +105,15 @@ vesFBO::vesFBO() : vesObject()
 
 vesFBO::~vesFBO()
 {
+  if (this->m_internal->m_frameBufferHandle) {
+    vesInternal::AttachmentToRBOMap::iterator itr =
+      this->m_internal->m_attachmentToRBOMap.begin();
+    for (; itr != this->m_internal->m_attachmentToRBOMap.end(); ++itr) {
+      glDeleteRenderbuffers(1, &(itr->second));
+    }
+    glDeleteFramebuffers(1, &this->m_internal->m_frameBufferHandle);
+  }
+
   delete this->m_internal; this->m_internal = 0x0;
 }
 
@@ -149,6 +171,21 @@ const vesTexture* vesFBO::texture(AttachmentType type) const
 }
 
 
+void vesFBO::setRenderbufferFormat(AttachmentType type, unsigned int format)
+{
+  if (this->m_internal->m_attachmentToFormatMap[type] != format) {
+    this->m_internal->m_attachmentToFormatMap[type] = format;
+    this->setDirtyStateOn();
+  }
+}
+
+
+unsigned int vesFBO::renderbufferFormat(AttachmentType type) const
+{
+  return this->m_internal->m_attachmentToFormatMap[type];
+}
+
+
 void vesFBO::setWidth(int width)
 {
   this->m_internal->m_width = width;
@@ -190,15 +227,18 @@ void vesFBO::setup(vesRenderState &renderState)
 
 void vesFBO::render(vesRenderState &renderState)
 {
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING,
+                &this->m_internal->m_previousFrameBufferHandle);
+
   // Call setup in case we have not done so already.
   this->setup(renderState);
 
   // Check for framebuffer complete
+  glBindFramebuffer(GL_FRAMEBUFFER, this->m_internal->m_frameBufferHandle);
   GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
-  if (status == GL_FRAMEBUFFER_COMPLETE) {
-    glBindFramebuffer(GL_FRAMEBUFFER, this->m_internal->m_frameBufferHandle);
-  }
-  else {
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+    glBindFramebuffer(GL_FRAMEBUFFER,
+                      this->m_internal->m_previousFrameBufferHandle);
     switch(status) {
     case GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT:
       std::cerr << "GL ERROR: GL_FRAMEBUFFER_INCOMPLETE_ATTACHMENT " << status << std::endl;
@@ -226,7 +266,8 @@ void vesFBO::remove(vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
-  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER,
+                    this->m_internal->m_previousFrameBufferHandle);
 }
 
 
@@ -242,15 +283,10 @@ void vesFBO::createFBO(vesRenderState &renderState)
     unsigned int colorBufferHandle;
     glGenRenderbuffers(1, &colorBufferHandle);
     glBindRenderbuffer(GL_RENDERBUFFER, colorBufferHandle);
-#ifdef VES_USE_DESKTOP_GL
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA4,
-                          this->m_internal->m_width,
-                          this->m_internal->m_height);
-#else
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGB565,
+    glRenderbufferStorage(GL_RENDERBUFFER,
+                          this->m_internal->m_attachmentToFormatMap[ColorAttachment0],
                           this->m_internal->m_width,
                           this->m_internal->m_height);
-#endif
 
     glFramebufferRenderbuffer(GL_FRAMEBUFFER, ColorAttachment0,
                               GL_RENDERBUFFER, colorBufferHandle);
@@ -268,7 +304,8 @@ void vesFBO::createFBO(vesRenderState &renderState)
     unsigned int depthBufferHandle;
     glGenRenderbuffers(1, &depthBufferHandle);
     glBindRenderbuffer(GL_RENDERBUFFER, depthBufferHandle);
-    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16,
+    glRenderbufferStorage(GL_RENDERBUFFER,
+                          this->m_internal->m_attachmentToFormatMap[DepthAttachment],
                           this->m_internal->m_width,
                           this->m_internal->m_height);
 
@@ -290,11 +327,13 @@ void vesFBO::deleteFBO(vesRenderState &renderState)
 {
   this->remove(renderState);
 
-  vesInternal::AttachmentToRBOMap::iterator itr = this->m_internal->m_attachmentToRBOMap.end();
+  vesInternal::AttachmentToRBOMap::iterator itr = this->m_internal->m_attachmentToRBOMap.begin();
 
   for (; itr != this->m_internal->m_attachmentToRBOMap.end(); ++itr) {
     glDeleteRenderbuffers(1, &(itr->second));
   }
+  this->m_internal->m_attachmentToRBOMap.clear();
 
   glDeleteFramebuffers (1, &this->m_internal->m_frameBufferHandle);
+  this->m_internal->m_frameBufferHandle = 0;
 }
@@ -59,6 +59,13 @@ public:
   void setHeight (int height);
   int height() const;
 
+  /// Set/Get the internal format of the renderbuffer created for an
+  /// attachment that has no texture.  By default colors are stored as
+  /// GL_RGBA4 on desktop GL and GL_RGB565 on OpenGL ES, and depth as
+  /// GL_DEPTH_COMPONENT16.
+  void setRenderbufferFormat(AttachmentType type, unsigned int format);
+  unsigned int renderbufferFormat(AttachmentType type) const;
+
   unsigned int frameBufferHandle();
 
   virtual void setup(vesRenderState &renderState);
@@ -46,3 +46,19 @@ bool vesFBORenderTarget::attach(vesFBO::AttachmentType type, vesTexture *texture
 }
 
 
+void vesFBORenderTarget::setup(vesRenderState &renderState)
+{
+  this->m_fbo->setup(renderState);
+}
+
+
+void vesFBORenderTarget::render(vesRenderState &renderState)
+{
+  this->m_fbo->render(renderState);
+}
+
+
+void vesFBORenderTarget::remove(vesRenderState &renderState)
+{
+  this->m_fbo->remove(renderState);
+}
@@ -43,6 +43,10 @@ public:
 
   virtual bool attach(vesFBO::AttachmentType type, vesTexture *texture);
 
+  virtual void setup(vesRenderState &renderState);
+  virtual void render(vesRenderState &renderState);
+  virtual void remove(vesRenderState &renderState);
+
 protected:
   vesFBO *m_fbo;
 };
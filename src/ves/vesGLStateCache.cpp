@@ -0,0 +1,371 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesGLStateCache.h"
+
+namespace {
+
+// Threads that render with their own context make their own cache current.
+vesGLStateCache defaultCache;
+vesThreadLocal vesGLStateCache* currentCache = 0;
+
+}
+
+vesGLStateCache::vesGLStateCache() :
+  m_issuedCalls(0),
+  m_skippedCalls(0)
+{
+  this->invalidate();
+}
+
+
+vesGLStateCache::~vesGLStateCache()
+{
+  if (currentCache == this) {
+    currentCache = 0;
+  }
+}
+
+
+vesGLStateCache* vesGLStateCache::current()
+{
+  return currentCache ? currentCache : &defaultCache;
+}
+
+
+void vesGLStateCache::makeCurrent()
+{
+  currentCache = this;
+}
+
+
+void vesGLStateCache::invalidate()
+{
+  this->m_programKnown = false;
+  this->m_program = 0;
+  this->m_arrayBufferKnown = false;
+  this->m_arrayBuffer = 0;
+  this->m_elementArrayBufferKnown = false;
+  this->m_elementArrayBuffer = 0;
+  this->m_activeTextureKnown = false;
+  this->m_activeTexture = GL_TEXTURE0;
+  this->m_textureBindings.clear();
+  this->m_capabilities.clear();
+  this->m_depthMaskKnown = false;
+  this->m_depthMask = GL_TRUE;
+  this->m_blendFuncKnown = false;
+  this->m_blendSource = GL_ONE;
+  this->m_blendDestination = GL_ZERO;
+  this->m_clearColorKnown = false;
+  this->m_viewportKnown = false;
+  this->m_vertexAttribArrays.clear();
+  this->m_vertexAttribValuesKnown.clear();
+  this->m_vertexAttribValues.clear();
+}
+
+
+void vesGLStateCache::resetCounters()
+{
+  this->m_issuedCalls = 0;
+  this->m_skippedCalls = 0;
+}
+
+
+template <typename T>
+bool vesGLStateCache::update(bool &known, T &current, const T &value)
+{
+  if (known && current == value) {
+    ++this->m_skippedCalls;
+    return false;
+  }
+
+  known = true;
+  current = value;
+  ++this->m_issuedCalls;
+  return true;
+}
+
+
+bool vesGLStateCache::updateState(int &current, bool value)
+{
+  const int state = value ? On : Off;
+  if (current == state) {
+    ++this->m_skippedCalls;
+    return false;
+  }
+
+  current = state;
+  ++this->m_issuedCalls;
+  return true;
+}
+
+
+void vesGLStateCache::useProgram(GLuint program)
+{
+  if (this->update(this->m_programKnown, this->m_program, program)) {
+    glUseProgram(program);
+  }
+}
+
+
+void vesGLStateCache::bindBuffer(GLenum target, GLuint buffer)
+{
+  bool changed = true;
+  if (target == GL_ARRAY_BUFFER) {
+    changed = this->update(this->m_arrayBufferKnown, this->m_arrayBuffer, buffer);
+  }
+  else if (target == GL_ELEMENT_ARRAY_BUFFER) {
+    changed = this->update(this->m_elementArrayBufferKnown,
+                           this->m_elementArrayBuffer, buffer);
+  }
+  else {
+    ++this->m_issuedCalls;
+  }
+
+  if (changed) {
+    glBindBuffer(target, buffer);
+  }
+}
+
+
+void vesGLStateCache::activeTexture(GLenum unit)
+{
+  if (this->update(this->m_activeTextureKnown, this->m_activeTexture, unit)) {
+    glActiveTexture(unit);
+  }
+}
+
+
+int& vesGLStateCache::textureUnitBinding(GLenum target)
+{
+  // Without a known active unit we cannot tell which binding changes.
+  if (target != GL_TEXTURE_2D || !this->m_activeTextureKnown) {
+    this->m_untrackedTextureBinding = Unknown;
+    return this->m_untrackedTextureBinding;
+  }
+
+  const size_t unit = this->m_activeTexture - GL_TEXTURE0;
+  if (unit >= this->m_textureBindings.size()) {
+    this->m_textureBindings.resize(unit + 1, Unknown);
+  }
+  return this->m_textureBindings[unit];
+}
+
+
+void vesGLStateCache::bindTexture(GLenum target, GLuint texture)
+{
+  int &binding = this->textureUnitBinding(target);
+  if (binding == static_cast<int>(texture)) {
+    ++this->m_skippedCalls;
+    return;
+  }
+
+  binding = static_cast<int>(texture);
+  ++this->m_issuedCalls;
+  glBindTexture(target, texture);
+}
+
+
+void vesGLStateCache::enable(GLenum capability)
+{
+  this->setEnabled(capability, true);
+}
+
+
+void vesGLStateCache::disable(GLenum capability)
+{
+  this->setEnabled(capability, false);
+}
+
+
+void vesGLStateCache::setEnabled(GLenum capability, bool enable)
+{
+  std::map<GLenum, int>::iterator itr = this->m_capabilities.find(capability);
+  if (itr == this->m_capabilities.end()) {
+    itr = this->m_capabilities.insert(std::make_pair(capability, int(Unknown))).first;
+  }
+
+  if (this->updateState(itr->second, enable)) {
+    if (enable) {
+      glEnable(capability);
+    }
+    else {
+      glDisable(capability);
+    }
+  }
+}
+
+
+bool vesGLStateCache::isEnabled(GLenum capability)
+{
+  std::map<GLenum, int>::iterator itr = this->m_capabilities.find(capability);
+  if (itr != this->m_capabilities.end() && itr->second != Unknown) {
+    return itr->second == On;
+  }
+
+  const bool enabled = glIsEnabled(capability) == GL_TRUE;
+  this->m_capabilities[capability] = enabled ? On : Off;
+  return enabled;
+}
+
+
+void vesGLStateCache::depthMask(GLboolean flag)
+{
+  if (this->update(this->m_depthMaskKnown, this->m_depthMask, flag)) {
+    glDepthMask(flag);
+  }
+}
+
+
+void vesGLStateCache::blendFunc(GLenum source, GLenum destination)
+{
+  if (this->m_blendFuncKnown && this->m_blendSource == source
+      && this->m_blendDestination == destination) {
+    ++this->m_skippedCalls;
+    return;
+  }
+
+  this->m_blendFuncKnown = true;
+  this->m_blendSource = source;
+  this->m_blendDestination = destination;
+  ++this->m_issuedCalls;
+  glBlendFunc(source, destination);
+}
+
+
+void vesGLStateCache::clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a)
+{
+  if (this->m_clearColorKnown && this->m_clearColor[0] == r
+      && this->m_clearColor[1] == g && this->m_clearColor[2] == b
+      && this->m_clearColor[3] == a) {
+    ++this->m_skippedCalls;
+    return;
+  }
+
+  this->m_clearColorKnown = true;
+  this->m_clearColor[0] = r;
+  this->m_clearColor[1] = g;
+  this->m_clearColor[2] = b;
+  this->m_clearColor[3] = a;
+  ++this->m_issuedCalls;
+  glClearColor(r, g, b, a);
+}
+
+
+void vesGLStateCache::viewport(GLint x, GLint y, GLsizei width, GLsizei height)
+{
+  if (this->m_viewportKnown && this->m_viewport[0] == x
+      && this->m_viewport[1] == y && this->m_viewport[2] == width
+      && this->m_viewport[3] == height) {
+    ++this->m_skippedCalls;
+    return;
+  }
+
+  this->m_viewportKnown = true;
+  this->m_viewport[0] = x;
+  this->m_viewport[1] = y;
+  this->m_viewport[2] = width;
+  this->m_viewport[3] = height;
+  ++this->m_issuedCalls;
+  glViewport(x, y, width, height);
+}
+
+
+void vesGLStateCache::enableVertexAttribArray(GLuint index)
+{
+  if (index >= this->m_vertexAttribArrays.size()) {
+    this->m_vertexAttribArrays.resize(index + 1, Unknown);
+  }
+
+  if (this->updateState(this->m_vertexAttribArrays[index], true)) {
+    glEnableVertexAttribArray(index);
+  }
+}
+
+
+void vesGLStateCache::disableVertexAttribArray(GLuint index)
+{
+  if (index >= this->m_vertexAttribArrays.size()) {
+    this->m_vertexAttribArrays.resize(index + 1, Unknown);
+  }
+
+  if (this->updateState(this->m_vertexAttribArrays[index], false)) {
+    glDisableVertexAttribArray(index);
+  }
+}
+
+
+void vesGLStateCache::vertexAttrib3fv(GLuint index, const GLfloat *values)
+{
+  if (index >= this->m_vertexAttribValuesKnown.size()) {
+    this->m_vertexAttribValuesKnown.resize(index + 1, false);
+    this->m_vertexAttribValues.resize(3 * (index + 1), 0.0f);
+  }
+
+  GLfloat *current = &this->m_vertexAttribValues[3 * index];
+  if (this->m_vertexAttribValuesKnown[index] && current[0] == values[0]
+      && current[1] == values[1] && current[2] == values[2]) {
+    ++this->m_skippedCalls;
+    return;
+  }
+
+  this->m_vertexAttribValuesKnown[index] = true;
+  current[0] = values[0];
+  current[1] = values[1];
+  current[2] = values[2];
+  ++this->m_issuedCalls;
+  glVertexAttrib3fv(index, values);
+}
+
+
+void vesGLStateCache::deleteProgram(GLuint program)
+{
+  if (this->m_programKnown && this->m_program == program) {
+    this->m_programKnown = false;
+  }
+  glDeleteProgram(program);
+}
+
+
+void vesGLStateCache::deleteBuffers(GLsizei count, const GLuint *buffers)
+{
+  for (GLsizei i = 0; i < count; ++i) {
+    if (this->m_arrayBuffer == buffers[i]) {
+      this->m_arrayBufferKnown = false;
+    }
+    if (this->m_elementArrayBuffer == buffers[i]) {
+      this->m_elementArrayBufferKnown = false;
+    }
+  }
+  glDeleteBuffers(count, buffers);
+}
+
+
+void vesGLStateCache::deleteTextures(GLsizei count, const GLuint *textures)
+{
+  for (GLsizei i = 0; i < count; ++i) {
+    for (size_t unit = 0; unit < this->m_textureBindings.size(); ++unit) {
+      if (this->m_textureBindings[unit] == static_cast<int>(textures[i])) {
+        this->m_textureBindings[unit] = Unknown;
+      }
+    }
+  }
+  glDeleteTextures(count, textures);
+}
@@ -0,0 +1,155 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesGLStateCache
+/// \ingroup ves
+/// \brief Shadow copy of the GL state of a context
+///
+/// Components change GL state through the cache, which skips calls that
+/// would set a state that is already current.  State that has not been
+/// set through the cache is unknown and the first call always reaches GL.
+///
+/// There is one current cache, matching the current GL context.  Code that
+/// changes state behind the cache's back, or makes another context current,
+/// must call invalidate().  vesRenderer invalidates the cache at the start
+/// of every frame so state changed by the application between frames is
+/// never trusted.
+///
+/// \see vesOpenGLSupport
+
+#ifndef VESGLSTATECACHE_H
+#define VESGLSTATECACHE_H
+
+// VES includes
+#include "vesGL.h"
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <map>
+#include <vector>
+
+class vesGLStateCache
+{
+public:
+  vesTypeMacro(vesGLStateCache);
+
+  vesGLStateCache();
+  ~vesGLStateCache();
+
+  /// Returns the cache of the current context.  A default cache is used
+  /// until makeCurrent() is called.  Each thread has its own current cache.
+  static vesGLStateCache* current();
+
+  /// Make this cache current.  Call this together with making the matching
+  /// GL context current.
+  void makeCurrent();
+
+  /// Forget all state so that every following call reaches GL.
+  void invalidate();
+
+  void useProgram(GLuint program);
+  void bindBuffer(GLenum target, GLuint buffer);
+  void activeTexture(GLenum unit);
+  void bindTexture(GLenum target, GLuint texture);
+
+  void enable(GLenum capability);
+  void disable(GLenum capability);
+  void setEnabled(GLenum capability, bool enable);
+
+  /// Returns the state of the capability, querying GL if it is unknown.
+  bool isEnabled(GLenum capability);
+
+  void depthMask(GLboolean flag);
+  void blendFunc(GLenum source, GLenum destination);
+  void clearColor(GLfloat r, GLfloat g, GLfloat b, GLfloat a);
+  void viewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+  void enableVertexAttribArray(GLuint index);
+  void disableVertexAttribArray(GLuint index);
+  void vertexAttrib3fv(GLuint index, const GLfloat *values);
+
+  /// Delete objects and forget any binding that referred to them, since GL
+  /// may hand the same names out again.
+  void deleteProgram(GLuint program);
+  void deleteBuffers(GLsizei count, const GLuint *buffers);
+  void deleteTextures(GLsizei count, const GLuint *textures);
+
+  /// Number of calls passed on to GL and skipped since the last reset.
+  unsigned long numberOfIssuedCalls() const { return this->m_issuedCalls; }
+  unsigned long numberOfSkippedCalls() const { return this->m_skippedCalls; }
+  void resetCounters();
+
+private:
+  vesGLStateCache(const vesGLStateCache&);
+  void operator=(const vesGLStateCache&);
+
+  enum KnownState
+  {
+    Unknown = -1,
+    Off = 0,
+    On = 1
+  };
+
+  // Returns true, and counts the call, if the value has to be sent to GL.
+  template <typename T>
+  bool update(bool &known, T &current, const T &value);
+
+  bool updateState(int &current, bool value);
+
+  int& textureUnitBinding(GLenum target);
+
+  bool m_programKnown;
+  GLuint m_program;
+
+  bool m_arrayBufferKnown;
+  GLuint m_arrayBuffer;
+  bool m_elementArrayBufferKnown;
+  GLuint m_elementArrayBuffer;
+
+  bool m_activeTextureKnown;
+  GLenum m_activeTexture;
+  // Texture bound to GL_TEXTURE_2D on each unit, -1 when unknown.
+  std::vector<int> m_textureBindings;
+  // Returned for bindings that are not tracked, always unknown.
+  int m_untrackedTextureBinding;
+
+  std::map<GLenum, int> m_capabilities;
+
+  bool m_depthMaskKnown;
+  GLboolean m_depthMask;
+
+  bool m_blendFuncKnown;
+  GLenum m_blendSource;
+  GLenum m_blendDestination;
+
+  bool m_clearColorKnown;
+  GLfloat m_clearColor[4];
+
+  bool m_viewportKnown;
+  GLint m_viewport[4];
+
+  std::vector<int> m_vertexAttribArrays;
+  std::vector<bool> m_vertexAttribValuesKnown;
+  std::vector<GLfloat> m_vertexAttribValues;
+
+  unsigned long m_issuedCalls;
+  unsigned long m_skippedCalls;
+};
+
+#endif // VESGLSTATECACHE_H
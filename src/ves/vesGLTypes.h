@@ -53,6 +53,7 @@ struct vesDataType
   enum Type
   {
     Float       = GL_FLOAT,
+    UnsignedByte = GL_UNSIGNED_BYTE,
     FloatVec2   = GL_FLOAT_VEC2,
     FloatVec3   = GL_FLOAT_VEC3,
     FloatVec4   = GL_FLOAT_VEC4,
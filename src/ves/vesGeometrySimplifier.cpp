@@ -0,0 +1,584 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesGeometrySimplifier.h"
+
+// VES includes
+#include "vesGeometryData.h"
+#include "vesGLTypes.h"
+#include "vesPrimitive.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+/// Symmetric 4x4 error quadric, upper triangle stored row by row.
+struct vesQuadric
+{
+  vesQuadric()
+  {
+    std::fill(this->m_values, this->m_values + 10, 0.0);
+  }
+
+  void addPlane(const vesVector3f &normal, double distance, double weight)
+  {
+    const double a = normal[0], b = normal[1], c = normal[2], d = distance;
+    double *q = this->m_values;
+    q[0] += weight * a * a; q[1] += weight * a * b; q[2] += weight * a * c;
+    q[3] += weight * a * d; q[4] += weight * b * b; q[5] += weight * b * c;
+    q[6] += weight * b * d; q[7] += weight * c * c; q[8] += weight * c * d;
+    q[9] += weight * d * d;
+  }
+
+  void add(const vesQuadric &other)
+  {
+    for (int i = 0; i < 10; ++i) {
+      this->m_values[i] += other.m_values[i];
+    }
+  }
+
+  double error(const vesVector3f &point) const
+  {
+    const double x = point[0], y = point[1], z = point[2];
+    const double *q = this->m_values;
+    const double result = q[0] * x * x + 2.0 * q[1] * x * y + 2.0 * q[2] * x * z
+      + 2.0 * q[3] * x + q[4] * y * y + 2.0 * q[5] * y * z + 2.0 * q[6] * y
+      + q[7] * z * z + 2.0 * q[8] * z + q[9];
+    return std::max(result, 0.0);
+  }
+
+  double m_values[10];
+};
+
+struct vesCollapse
+{
+  bool operator<(const vesCollapse &other) const
+  {
+    return this->m_cost < other.m_cost;
+  }
+
+  float m_cost;
+  unsigned int m_from;
+  unsigned int m_to;
+};
+
+struct vesEdge
+{
+  bool operator<(const vesEdge &other) const
+  {
+    return this->m_first < other.m_first
+      || (this->m_first == other.m_first && this->m_second < other.m_second);
+  }
+
+  unsigned int m_first;
+  unsigned int m_second;
+};
+
+/// Cosine of the largest angle a triangle normal may turn by in a collapse.
+/// Larger turns fold the surface over within a few collapses.
+const float vesMinimumNormalCosine = 0.2f;
+
+class vesPositionLess
+{
+public:
+  explicit vesPositionLess(const std::vector<vesVector3f> &positions) :
+    m_positions(positions)
+  {
+  }
+
+  bool operator()(unsigned int first, unsigned int second) const
+  {
+    const vesVector3f &a = this->m_positions[first];
+    const vesVector3f &b = this->m_positions[second];
+    if (a[0] != b[0]) {
+      return a[0] < b[0];
+    }
+    if (a[1] != b[1]) {
+      return a[1] < b[1];
+    }
+    return a[2] < b[2];
+  }
+
+private:
+  const std::vector<vesVector3f> &m_positions;
+};
+
+vesVector3f triangleNormal(const vesVector3f &a, const vesVector3f &b,
+                           const vesVector3f &c)
+{
+  return (b - a).cross(c - a);
+}
+
+template <typename T>
+vesPrimitive::Ptr createTriangles(const std::vector<unsigned int> &corners,
+                                  unsigned int indicesValueType)
+{
+  vesSharedPtr< vesIndices<T> > indices(new vesIndices<T>());
+  indices->indices()->assign(corners.begin(), corners.end());
+
+  vesPrimitive::Ptr triangles(new vesPrimitive());
+  triangles->setPrimitiveType(vesPrimitiveRenderType::Triangles);
+  triangles->setIndexCount(3);
+  triangles->setIndicesValueType(indicesValueType);
+  triangles->setVesIndices(indices);
+  return triangles;
+}
+
+/// Triangle soup over welded vertex classes, simplified in place.
+class vesSimplification
+{
+public:
+  vesSimplification(const std::vector<vesVector3f> &positions,
+                    const std::vector<unsigned int> &corners,
+                    const volatile bool *cancel);
+
+  unsigned int numberOfTriangles() const
+  {
+    return static_cast<unsigned int>(this->m_triangles.size() / 3);
+  }
+
+  /// Collapse edges until at most \p target triangles are left.  Returns
+  /// false if no further collapse is possible or the simplification was
+  /// cancelled.
+  bool reduce(unsigned int target);
+
+  bool isCancelled() const
+  {
+    return this->m_cancel && *this->m_cancel;
+  }
+
+  /// Corners of the remaining triangles as vertices of the input.
+  std::vector<unsigned int> corners() const;
+
+private:
+  bool collapsePass(unsigned int target);
+  bool flips(unsigned int from, unsigned int to) const;
+  bool isManifoldCollapse(unsigned int from, unsigned int to) const;
+  void buildAdjacency();
+  void removeDegenerateTriangles();
+
+  std::vector<vesVector3f> m_positions;         // per class
+  std::vector<unsigned int> m_representatives;  // class -> input vertex
+  std::vector<unsigned int> m_classes;          // input vertex -> class
+  std::vector<vesQuadric> m_quadrics;           // per class
+  std::vector<char> m_boundary;                 // per class
+  std::vector<unsigned int> m_triangles;        // corners as classes
+  std::vector<unsigned int> m_originals;        // corners as input vertices
+  std::vector<unsigned int> m_adjacencyOffsets; // class -> first triangle
+  std::vector<unsigned int> m_adjacency;        // triangles around a class
+  const volatile bool *m_cancel;
+};
+
+vesSimplification::vesSimplification(const std::vector<vesVector3f> &positions,
+                                     const std::vector<unsigned int> &corners,
+                                     const volatile bool *cancel) :
+  m_cancel(cancel)
+{
+  // Weld vertices that share a position, e.g. along normal or color seams,
+  // so that the surface is simplified as one piece.
+  const unsigned int numberOfVertices = static_cast<unsigned int>(positions.size());
+  std::vector<unsigned int> order(numberOfVertices);
+  for (unsigned int i = 0; i < numberOfVertices; ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), vesPositionLess(positions));
+
+  this->m_classes.resize(numberOfVertices);
+  for (unsigned int i = 0; i < numberOfVertices; ++i) {
+    if (i == 0 || positions[order[i]] != positions[order[i - 1]]) {
+      this->m_representatives.push_back(order[i]);
+      this->m_positions.push_back(positions[order[i]]);
+    }
+    this->m_classes[order[i]] =
+      static_cast<unsigned int>(this->m_representatives.size() - 1);
+  }
+
+  for (size_t i = 0; i + 2 < corners.size(); i += 3) {
+    const unsigned int a = this->m_classes[corners[i]];
+    const unsigned int b = this->m_classes[corners[i + 1]];
+    const unsigned int c = this->m_classes[corners[i + 2]];
+    if (a == b || b == c || c == a) {
+      continue;
+    }
+    this->m_triangles.push_back(a);
+    this->m_triangles.push_back(b);
+    this->m_triangles.push_back(c);
+    this->m_originals.insert(this->m_originals.end(), &corners[i], &corners[i] + 3);
+  }
+
+  // Every vertex accumulates the planes of its triangles weighted by area.
+  const unsigned int numberOfClasses =
+    static_cast<unsigned int>(this->m_positions.size());
+  this->m_quadrics.resize(numberOfClasses);
+  for (size_t i = 0; i < this->m_triangles.size(); i += 3) {
+    const vesVector3f &a = this->m_positions[this->m_triangles[i]];
+    vesVector3f normal = triangleNormal(a, this->m_positions[this->m_triangles[i + 1]],
+                                        this->m_positions[this->m_triangles[i + 2]]);
+    const float doubleArea = normal.norm();
+    if (doubleArea <= 0.0f) {
+      continue;
+    }
+    normal /= doubleArea;
+    for (int k = 0; k < 3; ++k) {
+      this->m_quadrics[this->m_triangles[i + k]].addPlane(
+        normal, -normal.dot(a), 0.5 * doubleArea);
+    }
+  }
+
+  // Edges used by a single triangle lie on a boundary.
+  std::vector<vesEdge> edges;
+  edges.reserve(this->m_triangles.size());
+  for (size_t i = 0; i < this->m_triangles.size(); i += 3) {
+    for (int k = 0; k < 3; ++k) {
+      const unsigned int first = this->m_triangles[i + k];
+      const unsigned int second = this->m_triangles[i + (k + 1) % 3];
+      vesEdge edge = { std::min(first, second), std::max(first, second) };
+      edges.push_back(edge);
+    }
+  }
+  std::sort(edges.begin(), edges.end());
+
+  this->m_boundary.assign(numberOfClasses, 0);
+  for (size_t i = 0; i < edges.size(); ) {
+    size_t j = i + 1;
+    while (j < edges.size() && !(edges[i] < edges[j])) {
+      ++j;
+    }
+    if (j - i == 1) {
+      this->m_boundary[edges[i].m_first] = 1;
+      this->m_boundary[edges[i].m_second] = 1;
+    }
+    i = j;
+  }
+}
+
+bool vesSimplification::reduce(unsigned int target)
+{
+  while (this->numberOfTriangles() > target) {
+    if (!this->collapsePass(target)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void vesSimplification::buildAdjacency()
+{
+  const size_t numberOfClasses = this->m_positions.size();
+  this->m_adjacencyOffsets.assign(numberOfClasses + 1, 0);
+  for (size_t i = 0; i < this->m_triangles.size(); ++i) {
+    ++this->m_adjacencyOffsets[this->m_triangles[i] + 1];
+  }
+  for (size_t i = 0; i < numberOfClasses; ++i) {
+    this->m_adjacencyOffsets[i + 1] += this->m_adjacencyOffsets[i];
+  }
+
+  std::vector<unsigned int> fill(this->m_adjacencyOffsets.begin(),
+                                 this->m_adjacencyOffsets.end() - 1);
+  this->m_adjacency.resize(this->m_triangles.size());
+  for (size_t i = 0; i < this->m_triangles.size(); ++i) {
+    this->m_adjacency[fill[this->m_triangles[i]]++] =
+      static_cast<unsigned int>(i / 3);
+  }
+}
+
+bool vesSimplification::flips(unsigned int from, unsigned int to) const
+{
+  for (unsigned int i = this->m_adjacencyOffsets[from];
+       i < this->m_adjacencyOffsets[from + 1]; ++i) {
+    const unsigned int *corners = &this->m_triangles[3 * this->m_adjacency[i]];
+    if (corners[0] == to || corners[1] == to || corners[2] == to) {
+      continue; // Collapses away.
+    }
+
+    vesVector3f points[3];
+    for (int k = 0; k < 3; ++k) {
+      points[k] = this->m_positions[corners[k]];
+    }
+    const vesVector3f before = triangleNormal(points[0], points[1], points[2]);
+    for (int k = 0; k < 3; ++k) {
+      if (corners[k] == from) {
+        points[k] = this->m_positions[to];
+      }
+    }
+    const vesVector3f after = triangleNormal(points[0], points[1], points[2]);
+    const float lengths = before.norm() * after.norm();
+    if (lengths <= 0.0f
+        || before.dot(after) <= vesMinimumNormalCosine * lengths) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool vesSimplification::isManifoldCollapse(unsigned int from, unsigned int to) const
+{
+  // The link condition: the only vertices adjacent to both ends of the edge
+  // are the apexes of the triangles sharing the edge.  Otherwise the
+  // collapse would pinch the surface or fold two triangles onto each other.
+  std::vector<unsigned int> fromNeighbors;
+  unsigned int numberOfEdgeTriangles = 0;
+  for (unsigned int i = this->m_adjacencyOffsets[from];
+       i < this->m_adjacencyOffsets[from + 1]; ++i) {
+    const unsigned int *corners = &this->m_triangles[3 * this->m_adjacency[i]];
+    if (corners[0] == to || corners[1] == to || corners[2] == to) {
+      ++numberOfEdgeTriangles;
+    }
+    for (int k = 0; k < 3; ++k) {
+      if (corners[k] != from) {
+        fromNeighbors.push_back(corners[k]);
+      }
+    }
+  }
+  std::sort(fromNeighbors.begin(), fromNeighbors.end());
+  fromNeighbors.erase(std::unique(fromNeighbors.begin(), fromNeighbors.end()),
+                      fromNeighbors.end());
+
+  std::vector<unsigned int> shared;
+  for (unsigned int i = this->m_adjacencyOffsets[to];
+       i < this->m_adjacencyOffsets[to + 1]; ++i) {
+    const unsigned int *corners = &this->m_triangles[3 * this->m_adjacency[i]];
+    for (int k = 0; k < 3; ++k) {
+      if (corners[k] != to && corners[k] != from
+          && std::binary_search(fromNeighbors.begin(), fromNeighbors.end(), corners[k])) {
+        shared.push_back(corners[k]);
+      }
+    }
+  }
+  std::sort(shared.begin(), shared.end());
+  shared.erase(std::unique(shared.begin(), shared.end()), shared.end());
+  return shared.size() == numberOfEdgeTriangles;
+}
+
+bool vesSimplification::collapsePass(unsigned int target)
+{
+  this->buildAdjacency();
+
+  // One candidate per edge, in its cheaper direction.  Boundary vertices
+  // only serve as targets.
+  std::vector<vesCollapse> candidates;
+  candidates.reserve(this->m_triangles.size() / 2);
+  for (size_t i = 0; i < this->m_triangles.size(); i += 3) {
+    for (int k = 0; k < 3; ++k) {
+      const unsigned int first = this->m_triangles[i + k];
+      const unsigned int second = this->m_triangles[i + (k + 1) % 3];
+      if (first > second && !this->m_boundary[first] && !this->m_boundary[second]) {
+        continue; // Interior edges are visited from both triangles.
+      }
+
+      vesQuadric quadric = this->m_quadrics[first];
+      quadric.add(this->m_quadrics[second]);
+      vesCollapse collapse;
+      collapse.m_cost = -1.0f;
+      if (!this->m_boundary[first]) {
+        collapse.m_cost = static_cast<float>(quadric.error(this->m_positions[second]));
+        collapse.m_from = first;
+        collapse.m_to = second;
+      }
+      if (!this->m_boundary[second]) {
+        const float cost = static_cast<float>(quadric.error(this->m_positions[first]));
+        if (collapse.m_cost < 0.0f || cost < collapse.m_cost) {
+          collapse.m_cost = cost;
+          collapse.m_from = second;
+          collapse.m_to = first;
+        }
+      }
+      if (collapse.m_cost >= 0.0f) {
+        candidates.push_back(collapse);
+      }
+    }
+  }
+  std::sort(candidates.begin(), candidates.end());
+
+  // Collapse the cheapest edges first.  A collapse changes the triangles
+  // around its source vertex, so their vertices are left alone for the rest
+  // of the pass and the flip test of later collapses stays exact.
+  const unsigned int excess = this->numberOfTriangles() - target;
+  unsigned int removed = 0;
+  std::vector<char> locked(this->m_positions.size(), 0);
+  std::vector<unsigned int> remap;
+  for (size_t i = 0; i < candidates.size() && removed < excess; ++i) {
+    if (this->isCancelled()) {
+      return false;
+    }
+
+    const unsigned int from = candidates[i].m_from;
+    const unsigned int to = candidates[i].m_to;
+    if (locked[from] || locked[to] || this->flips(from, to)
+        || !this->isManifoldCollapse(from, to)) {
+      continue;
+    }
+
+    if (remap.empty()) {
+      remap.resize(this->m_positions.size());
+      for (size_t j = 0; j < remap.size(); ++j) {
+        remap[j] = static_cast<unsigned int>(j);
+      }
+    }
+    remap[from] = to;
+    this->m_quadrics[to].add(this->m_quadrics[from]);
+
+    locked[to] = 1;
+    for (unsigned int j = this->m_adjacencyOffsets[from];
+         j < this->m_adjacencyOffsets[from + 1]; ++j) {
+      const unsigned int *corners = &this->m_triangles[3 * this->m_adjacency[j]];
+      if (corners[0] == to || corners[1] == to || corners[2] == to) {
+        ++removed;
+      }
+      locked[corners[0]] = locked[corners[1]] = locked[corners[2]] = 1;
+    }
+  }
+
+  if (remap.empty()) {
+    return false;
+  }
+
+  for (size_t i = 0; i < this->m_triangles.size(); ++i) {
+    this->m_triangles[i] = remap[this->m_triangles[i]];
+  }
+  this->removeDegenerateTriangles();
+  return true;
+}
+
+void vesSimplification::removeDegenerateTriangles()
+{
+  size_t size = 0;
+  for (size_t i = 0; i < this->m_triangles.size(); i += 3) {
+    const unsigned int *corners = &this->m_triangles[i];
+    if (corners[0] == corners[1] || corners[1] == corners[2]
+        || corners[2] == corners[0]) {
+      continue;
+    }
+    for (int k = 0; k < 3; ++k) {
+      this->m_triangles[size + k] = this->m_triangles[i + k];
+      this->m_originals[size + k] = this->m_originals[i + k];
+    }
+    size += 3;
+  }
+  this->m_triangles.resize(size);
+  this->m_originals.resize(size);
+}
+
+std::vector<unsigned int> vesSimplification::corners() const
+{
+  // Corners that did not move keep their own vertex, and with it their
+  // normal and color on seams.
+  std::vector<unsigned int> result(this->m_triangles.size());
+  for (size_t i = 0; i < this->m_triangles.size(); ++i) {
+    const unsigned int original = this->m_originals[i];
+    result[i] = (this->m_classes[original] == this->m_triangles[i])
+      ? original : this->m_representatives[this->m_triangles[i]];
+  }
+  return result;
+}
+
+void appendTriangles(vesPrimitive::Ptr primitive, std::vector<unsigned int> &corners)
+{
+  const unsigned int numberOfIndices = primitive->numberOfIndices();
+  const void *data = primitive->data();
+  for (unsigned int i = 0; i + 2 < numberOfIndices; i += 3) {
+    for (unsigned int k = 0; k < 3; ++k) {
+      corners.push_back(primitive->sizeOfDataType() == sizeof(unsigned short)
+        ? static_cast<const unsigned short*>(data)[i + k]
+        : static_cast<const unsigned int*>(data)[i + k]);
+    }
+  }
+}
+
+}
+
+std::vector<vesPrimitive::Ptr> vesGeometrySimplifier::simplify(
+  vesGeometryData::Ptr geometry, const std::vector<float> &ratios,
+  const volatile bool *cancel)
+{
+  std::vector<vesPrimitive::Ptr> levels;
+  vesSourceData::Ptr source = geometry
+    ? geometry->sourceData(vesVertexAttributeKeys::Position) : vesSourceData::Ptr();
+  if (!source || !source->sizeOfArray()
+      || source->attributeDataType(vesVertexAttributeKeys::Position) != vesDataType::Float
+      || source->numberOfComponents(vesVertexAttributeKeys::Position) < 3) {
+    return levels;
+  }
+
+  std::vector<vesVector3f> positions(source->sizeOfArray());
+  const unsigned char *data = static_cast<const unsigned char*>(source->data())
+    + source->attributeOffset(vesVertexAttributeKeys::Position);
+  const unsigned int stride =
+    source->attributeStride(vesVertexAttributeKeys::Position);
+  for (size_t i = 0; i < positions.size(); ++i) {
+    float point[3];
+    memcpy(point, data + i * stride, sizeof(point));
+    positions[i] = vesVector3f(point[0], point[1], point[2]);
+  }
+
+  std::vector<unsigned int> corners;
+  bool shortIndices = true;
+  for (unsigned int i = 0; i < geometry->numberOfPrimitiveTypes(); ++i) {
+    vesPrimitive::Ptr primitive = geometry->primitive(i);
+    if (primitive->primitiveType() == vesPrimitiveRenderType::Triangles
+        && primitive->numberOfIndices()) {
+      shortIndices = shortIndices
+        && primitive->sizeOfDataType() == sizeof(unsigned short);
+      appendTriangles(primitive, corners);
+    }
+  }
+  if (corners.empty()) {
+    return levels;
+  }
+
+  vesSimplification simplification(positions, corners, cancel);
+  unsigned int previous = static_cast<unsigned int>(corners.size() / 3);
+  for (size_t i = 0; i < ratios.size(); ++i) {
+    const unsigned int target = static_cast<unsigned int>(
+      std::max(1.0f, ratios[i] * (corners.size() / 3)));
+    const bool reached = simplification.reduce(target);
+    if (simplification.isCancelled()) {
+      return std::vector<vesPrimitive::Ptr>();
+    }
+
+    // Skip levels that hardly differ from the previous one.
+    if (simplification.numberOfTriangles() < previous * 0.9f) {
+      previous = simplification.numberOfTriangles();
+      levels.push_back(shortIndices
+        ? createTriangles<unsigned short>(simplification.corners(),
+                                          vesPrimitiveIndicesValueType::UnsignedShort)
+        : createTriangles<unsigned int>(simplification.corners(),
+                                        vesPrimitiveIndicesValueType::UnsignedInt));
+    }
+    if (!reached) {
+      break;
+    }
+  }
+  return levels;
+}
+
+unsigned int vesGeometrySimplifier::numberOfTriangles(vesGeometryData::Ptr geometry)
+{
+  unsigned int result = 0;
+  for (unsigned int i = 0; geometry && i < geometry->numberOfPrimitiveTypes(); ++i) {
+    vesPrimitive::Ptr primitive = geometry->primitive(i);
+    if (primitive->primitiveType() == vesPrimitiveRenderType::Triangles) {
+      result += primitive->numberOfIndices() / 3;
+    }
+  }
+  return result;
+}
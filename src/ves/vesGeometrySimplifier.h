@@ -0,0 +1,69 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesGeometrySimplifier
+/// \ingroup ves
+/// \brief Quadric error simplification of triangle geometry.
+///
+/// The triangles are simplified by edge collapses ordered by the quadric
+/// error metric of Garland and Heckbert.  Every collapse moves one vertex
+/// onto a neighbour instead of creating a new vertex, so the simplified
+/// triangles index the vertices of the input geometry and keep all of their
+/// attributes.  Each level costs only an index buffer when it is drawn
+/// through vesMapper::addLevelOfDetail().  Vertices on open boundaries are
+/// never removed, so the outline of the surface is kept.
+///
+/// simplify() only reads the geometry and may run on a background thread as
+/// long as the geometry is not modified meanwhile.
+///
+/// \see vesMapper
+
+#ifndef VESGEOMETRYSIMPLIFIER_H
+#define VESGEOMETRYSIMPLIFIER_H
+
+// VES includes
+#include "vesSharedPtr.h"
+
+// C/C++ includes
+#include <vector>
+
+// Forward declarations
+class vesGeometryData;
+class vesPrimitive;
+
+class vesGeometrySimplifier
+{
+public:
+  /// Simplify the triangles of \p geometry to about \p ratios of their
+  /// number, e.g. {0.25, 0.05}, largest ratio first.  Levels that can not be
+  /// reduced further are left out, so fewer levels than ratios may be
+  /// returned.  The simplification stops soon after \p cancel, when given,
+  /// becomes true, and then returns no levels.
+  static std::vector<vesSharedPtr<vesPrimitive> > simplify(
+    vesSharedPtr<vesGeometryData> geometry, const std::vector<float> &ratios,
+    const volatile bool *cancel = 0);
+
+  /// Number of triangles of all triangle primitives of \p geometry.
+  static unsigned int numberOfTriangles(vesSharedPtr<vesGeometryData> geometry);
+
+private:
+  vesGeometrySimplifier(); // Not implemented
+};
+
+#endif // VESGEOMETRYSIMPLIFIER_H
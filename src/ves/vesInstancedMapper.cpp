@@ -0,0 +1,525 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesInstancedMapper.h"
+
+// The instanced array entry points of OpenGL ES are extension prototypes.
+#if !defined(VES_USE_DESKTOP_GL) && !defined(GL_GLEXT_PROTOTYPES)
+  #define GL_GLEXT_PROTOTYPES
+#endif
+
+// VES includes
+#include "vesGeometryData.h"
+#include "vesGL.h"
+#include "vesGLStateCache.h"
+#include "vesGLTypes.h"
+#include "vesMaterial.h"
+#include "vesProfiler.h"
+#include "vesRenderState.h"
+#include "vesShaderProgram.h"
+#include "vesVertexAttributeKeys.h"
+
+// C/C++ includes
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+
+#if defined(VES_USE_DESKTOP_GL) && defined(GL_ARB_instanced_arrays) && defined(GL_ARB_draw_instanced)
+  #define VES_HAS_INSTANCED_ARRAYS
+  #define vesVertexAttribDivisor glVertexAttribDivisorARB
+  #define vesDrawElementsInstanced glDrawElementsInstancedARB
+  #define vesDrawArraysInstanced glDrawArraysInstancedARB
+  #define VES_INSTANCED_ARRAYS_EXTENSION "GL_ARB_instanced_arrays"
+  #define VES_DRAW_INSTANCED_EXTENSION "GL_ARB_draw_instanced"
+#elif !defined(VES_USE_DESKTOP_GL) && defined(GL_EXT_instanced_arrays) && defined(GL_EXT_draw_instanced)
+  #define VES_HAS_INSTANCED_ARRAYS
+  #define vesVertexAttribDivisor glVertexAttribDivisorEXT
+  #define vesDrawElementsInstanced glDrawElementsInstancedEXT
+  #define vesDrawArraysInstanced glDrawArraysInstancedEXT
+  #define VES_INSTANCED_ARRAYS_EXTENSION "GL_EXT_instanced_arrays"
+  #define VES_DRAW_INSTANCED_EXTENSION "GL_EXT_instanced_arrays"
+#endif
+
+namespace {
+
+vesVector3f readVector3f(vesSourceData::Ptr source, int key, unsigned int index)
+{
+  const unsigned char *bytes = static_cast<const unsigned char*>(source->data())
+    + source->attributeOffset(key) + index * source->attributeStride(key);
+  const unsigned int numberOfComponents = std::min(source->numberOfComponents(key), 3u);
+
+  float values[3] = {0.0f, 0.0f, 0.0f};
+  memcpy(values, bytes, numberOfComponents * sizeof(float));
+  return vesVector3f(values[0], values[1], values[2]);
+}
+
+unsigned int readIndex(vesPrimitive::Ptr primitive, unsigned int index)
+{
+  if (primitive->sizeOfDataType() == sizeof(unsigned short)) {
+    return static_cast<const unsigned short*>(primitive->data())[index];
+  }
+  return static_cast<const unsigned int*>(primitive->data())[index];
+}
+
+// Copies the glyph to the instances [first, last), pre-transformed, into one
+// geometry indexed with T.
+template <typename T>
+vesGeometryData::Ptr createBatch(vesGeometryData::Ptr glyph,
+                                 const std::vector<vesVector4f> &offsets,
+                                 const std::vector<vesVector3f> &colors,
+                                 const vesVector3f &defaultColor, int colorKey,
+                                 size_t first, size_t last,
+                                 unsigned int indicesValueType)
+{
+  vesSourceData::Ptr glyphPositions =
+    glyph->sourceData(vesVertexAttributeKeys::Position);
+  vesSourceData::Ptr glyphNormals =
+    glyph->sourceData(vesVertexAttributeKeys::Normal);
+  const unsigned int numberOfGlyphVertices = glyphPositions->sizeOfArray();
+
+  vesSourceDataP3N3f::Ptr points(new vesSourceDataP3N3f());
+  vesGenericSourceData3f::Ptr pointColors;
+  if (!colors.empty()) {
+    pointColors = vesGenericSourceData3f::Ptr(new vesGenericSourceData3f(colorKey));
+  }
+
+  for (size_t instance = first; instance < last; ++instance) {
+    const vesVector4f &offset = offsets[instance];
+    const vesVector3f center(offset[0], offset[1], offset[2]);
+    for (unsigned int i = 0; i < numberOfGlyphVertices; ++i) {
+      vesVertexDataP3N3f vertex;
+      vertex.m_position = readVector3f(glyphPositions, vesVertexAttributeKeys::Position, i)
+        * offset[3] + center;
+      vertex.m_normal = glyphNormals
+        ? readVector3f(glyphNormals, vesVertexAttributeKeys::Normal, i)
+        : vesVector3f(0.0f, 0.0f, 1.0f);
+      points->pushBack(vertex);
+      if (pointColors) {
+        pointColors->pushBack(instance < colors.size() ? colors[instance] : defaultColor);
+      }
+    }
+  }
+
+  vesGeometryData::Ptr batch(new vesGeometryData());
+  batch->setName(glyph->name());
+  batch->addSource(points);
+  if (pointColors) {
+    batch->addSource(pointColors);
+  }
+
+  for (unsigned int p = 0; p < glyph->numberOfPrimitiveTypes(); ++p) {
+    vesPrimitive::Ptr glyphPrimitive = glyph->primitive(p);
+    if (!glyphPrimitive->numberOfIndices()) {
+      continue;
+    }
+
+    vesSharedPtr< vesIndices<T> > indices(new vesIndices<T>());
+    std::vector<T> &values = *indices->indices();
+    values.reserve((last - first) * glyphPrimitive->numberOfIndices());
+    for (size_t instance = 0; instance < last - first; ++instance) {
+      const unsigned int base = static_cast<unsigned int>(instance) * numberOfGlyphVertices;
+      for (unsigned int i = 0; i < glyphPrimitive->numberOfIndices(); ++i) {
+        values.push_back(static_cast<T>(base + readIndex(glyphPrimitive, i)));
+      }
+    }
+
+    vesPrimitive::Ptr primitive(new vesPrimitive());
+    primitive->setIndexCount(glyphPrimitive->indexCount());
+    primitive->setIndicesValueType(indicesValueType);
+    primitive->setPrimitiveType(glyphPrimitive->primitiveType());
+    primitive->setVesIndices(indices);
+    batch->addPrimitive(primitive);
+  }
+
+  return batch;
+}
+
+}
+
+class vesInstancedMapper::vesInstancing
+{
+public:
+  vesInstancing() :
+    m_instancingEnabled(true),
+    m_supportChecked(false),
+    m_supported(false),
+    m_usedInstancing(false),
+    m_drawInstances(false),
+    m_instanceBuffer(0),
+    m_instanceBufferDirty(true),
+    m_batchesDirty(true),
+    m_batchColorKey(-1)
+  {
+  }
+
+  std::vector<vesVector4f> m_offsets;
+  std::vector<vesVector3f> m_colors;
+
+  bool m_instancingEnabled;
+  bool m_supportChecked;
+  bool m_supported;
+  bool m_usedInstancing;
+
+  // Set while vesMapper::render() issues the instanced draw calls.
+  bool m_drawInstances;
+
+  unsigned int m_instanceBuffer;
+  bool m_instanceBufferDirty;
+
+  std::vector<vesMapper::Ptr> m_batches;
+  vesGeometryData::Ptr m_batchGlyph;
+  bool m_batchesDirty;
+  int m_batchColorKey;
+
+  vesRenderState m_batchState;
+};
+
+
+vesInstancedMapper::vesInstancedMapper() : vesMapper(),
+  m_instancing(0x0)
+{
+  this->m_instancing = new vesInstancing();
+}
+
+
+vesInstancedMapper::~vesInstancedMapper()
+{
+  if (this->m_instancing->m_instanceBuffer) {
+    vesGLStateCache::current()->deleteBuffers(1, &this->m_instancing->m_instanceBuffer);
+  }
+
+  delete this->m_instancing; this->m_instancing = 0x0;
+}
+
+
+void vesInstancedMapper::setInstanceOffsets(const std::vector<vesVector4f> &offsets)
+{
+  this->m_instancing->m_offsets = offsets;
+  this->m_instancing->m_instanceBufferDirty = true;
+  this->m_instancing->m_batchesDirty = true;
+  this->setBoundsDirty(true);
+}
+
+
+const std::vector<vesVector4f>& vesInstancedMapper::instanceOffsets() const
+{
+  return this->m_instancing->m_offsets;
+}
+
+
+void vesInstancedMapper::setInstanceColors(const std::vector<vesVector3f> &colors)
+{
+  this->m_instancing->m_colors = colors;
+  this->m_instancing->m_instanceBufferDirty = true;
+  this->m_instancing->m_batchesDirty = true;
+}
+
+
+const std::vector<vesVector3f>& vesInstancedMapper::instanceColors() const
+{
+  return this->m_instancing->m_colors;
+}
+
+
+int vesInstancedMapper::numberOfInstances() const
+{
+  return static_cast<int>(this->m_instancing->m_offsets.size());
+}
+
+
+void vesInstancedMapper::setInstancingEnabled(bool value)
+{
+  this->m_instancing->m_instancingEnabled = value;
+}
+
+
+bool vesInstancedMapper::isInstancingEnabled() const
+{
+  return this->m_instancing->m_instancingEnabled;
+}
+
+
+bool vesInstancedMapper::isInstancingSupported()
+{
+#ifdef VES_HAS_INSTANCED_ARRAYS
+  const GLubyte *value = glGetString(GL_EXTENSIONS);
+  std::stringstream extensions(value ? reinterpret_cast<const char*>(value) : "");
+  std::string extension;
+  bool hasInstancedArrays = false;
+  bool hasDrawInstanced = false;
+  while (extensions >> extension) {
+    hasInstancedArrays = hasInstancedArrays || extension == VES_INSTANCED_ARRAYS_EXTENSION;
+    hasDrawInstanced = hasDrawInstanced || extension == VES_DRAW_INSTANCED_EXTENSION;
+  }
+  return hasInstancedArrays && hasDrawInstanced;
+#else
+  return false;
+#endif
+}
+
+
+bool vesInstancedMapper::usedInstancing() const
+{
+  return this->m_instancing->m_usedInstancing;
+}
+
+
+int vesInstancedMapper::maximumVerticesPerBatch()
+{
+  return 65536;
+}
+
+
+void vesInstancedMapper::computeBounds()
+{
+  assert(this->geometryData());
+
+  const std::vector<vesVector4f> &offsets = this->m_instancing->m_offsets;
+  if (offsets.empty()) {
+    this->resetBounds();
+    this->setBoundsDirty(false);
+    return;
+  }
+
+  const vesVector3f glyphMin = this->m_geometryData->boundsMin();
+  const vesVector3f glyphMax = this->m_geometryData->boundsMax();
+
+  vesVector3f min(offsets[0][0], offsets[0][1], offsets[0][2]);
+  vesVector3f max = min;
+  for (size_t i = 0; i < offsets.size(); ++i) {
+    const vesVector3f center(offsets[i][0], offsets[i][1], offsets[i][2]);
+    const float scale = offsets[i][3];
+    for (int j = 0; j < 3; ++j) {
+      const float a = center[j] + glyphMin[j] * scale;
+      const float b = center[j] + glyphMax[j] * scale;
+      min[j] = std::min(min[j], std::min(a, b));
+      max[j] = std::max(max[j], std::max(a, b));
+    }
+  }
+
+  this->setBounds(min, max);
+  this->setBoundsDirty(false);
+}
+
+
+void vesInstancedMapper::render(const vesRenderState &renderState)
+{
+  assert(this->m_geometryData);
+
+  if (this->m_instancing->m_offsets.empty()) {
+    return;
+  }
+
+  if (!this->m_instancing->m_supportChecked) {
+    this->m_instancing->m_supported = isInstancingSupported();
+    this->m_instancing->m_supportChecked = true;
+  }
+
+  vesShaderProgram::Ptr program = renderState.m_material->shaderProgram();
+  const bool readsInstanceOffset = program
+    && program->attribute(vesVertexAttributeKeys::InstanceOffset);
+
+  this->m_instancing->m_usedInstancing = this->m_instancing->m_instancingEnabled
+    && this->m_instancing->m_supported && readsInstanceOffset;
+
+  if (this->m_instancing->m_usedInstancing) {
+    this->renderInstanced(renderState);
+  }
+  else {
+    this->renderBatches(renderState);
+  }
+}
+
+
+void vesInstancedMapper::renderInstanced(const vesRenderState &renderState)
+{
+#ifdef VES_HAS_INSTANCED_ARRAYS
+  vesGLStateCache *state = vesGLStateCache::current();
+  vesInstancing *instancing = this->m_instancing;
+
+  const bool hasColors = !instancing->m_colors.empty();
+  const int numberOfFloats = hasColors ? 7 : 4;
+  const int stride = numberOfFloats * sizeof(float);
+
+  if (!instancing->m_instanceBuffer) {
+    glGenBuffers(1, &instancing->m_instanceBuffer);
+    instancing->m_instanceBufferDirty = true;
+  }
+  state->bindBuffer(GL_ARRAY_BUFFER, instancing->m_instanceBuffer);
+
+  if (instancing->m_instanceBufferDirty) {
+    std::vector<float> values;
+    values.reserve(instancing->m_offsets.size() * numberOfFloats);
+    for (size_t i = 0; i < instancing->m_offsets.size(); ++i) {
+      const vesVector4f &offset = instancing->m_offsets[i];
+      values.insert(values.end(), offset.data(), offset.data() + 4);
+      if (hasColors) {
+        const vesVector3f color = i < instancing->m_colors.size()
+          ? instancing->m_colors[i] : vesVector3f(this->color()[0],
+            this->color()[1], this->color()[2]);
+        values.insert(values.end(), color.data(), color.data() + 3);
+      }
+    }
+    glBufferData(GL_ARRAY_BUFFER, values.size() * sizeof(float), &values[0],
+                 GL_STATIC_DRAW);
+    vesProfiler::countBufferUpload(values.size() * sizeof(float));
+    instancing->m_instanceBufferDirty = false;
+  }
+
+  glVertexAttribPointer(vesVertexAttributeKeys::InstanceOffset, 4, GL_FLOAT,
+                        GL_FALSE, stride, (void*)0);
+  state->enableVertexAttribArray(vesVertexAttributeKeys::InstanceOffset);
+  vesVertexAttribDivisor(vesVertexAttributeKeys::InstanceOffset, 1);
+
+  if (hasColors) {
+    glVertexAttribPointer(vesVertexAttributeKeys::InstanceColor, 3, GL_FLOAT,
+                          GL_FALSE, stride, (void*)(4 * sizeof(float)));
+    state->enableVertexAttribArray(vesVertexAttributeKeys::InstanceColor);
+    vesVertexAttribDivisor(vesVertexAttributeKeys::InstanceColor, 1);
+  }
+  else {
+    state->vertexAttrib3fv(vesVertexAttributeKeys::InstanceColor, this->color());
+  }
+
+  instancing->m_drawInstances = true;
+  vesMapper::render(renderState);
+  instancing->m_drawInstances = false;
+
+  vesVertexAttribDivisor(vesVertexAttributeKeys::InstanceOffset, 0);
+  state->disableVertexAttribArray(vesVertexAttributeKeys::InstanceOffset);
+  if (hasColors) {
+    vesVertexAttribDivisor(vesVertexAttributeKeys::InstanceColor, 0);
+    state->disableVertexAttribArray(vesVertexAttributeKeys::InstanceColor);
+  }
+#else
+  this->renderBatches(renderState);
+#endif
+}
+
+
+void vesInstancedMapper::renderBatches(const vesRenderState &renderState)
+{
+  vesInstancing *instancing = this->m_instancing;
+
+  // Programs that do not know about instances still get the batch colors.
+  vesShaderProgram::Ptr program = renderState.m_material->shaderProgram();
+  const int colorKey = program
+    && !program->attribute(vesVertexAttributeKeys::InstanceColor)
+    ? vesVertexAttributeKeys::Color : vesVertexAttributeKeys::InstanceColor;
+
+  if (instancing->m_batchesDirty || instancing->m_batchGlyph != this->m_geometryData
+      || instancing->m_batchColorKey != colorKey) {
+    instancing->m_batches.clear();
+
+    vesGeometryData::Ptr glyph = this->m_geometryData;
+    vesSourceData::Ptr glyphPositions =
+      glyph->sourceData(vesVertexAttributeKeys::Position);
+    const unsigned int numberOfGlyphVertices =
+      glyphPositions ? glyphPositions->sizeOfArray() : 0;
+
+    if (numberOfGlyphVertices) {
+      const vesVector3f defaultColor(this->color()[0], this->color()[1],
+                                     this->color()[2]);
+      const size_t instancesPerBatch = std::max(
+        static_cast<size_t>(maximumVerticesPerBatch() / numberOfGlyphVertices),
+        static_cast<size_t>(1));
+      const size_t numberOfInstances = instancing->m_offsets.size();
+
+      for (size_t first = 0; first < numberOfInstances; first += instancesPerBatch) {
+        const size_t last = std::min(first + instancesPerBatch, numberOfInstances);
+        vesMapper::Ptr batch(new vesMapper());
+        if (numberOfGlyphVertices * instancesPerBatch
+            <= static_cast<size_t>(maximumVerticesPerBatch())) {
+          batch->setGeometryData(createBatch<unsigned short>(glyph,
+            instancing->m_offsets, instancing->m_colors, defaultColor, colorKey,
+            first, last,
+            vesPrimitiveIndicesValueType::UnsignedShort));
+        }
+        else {
+          batch->setGeometryData(createBatch<unsigned int>(glyph,
+            instancing->m_offsets, instancing->m_colors, defaultColor, colorKey,
+            first, last,
+            vesPrimitiveIndicesValueType::UnsignedInt));
+        }
+        instancing->m_batches.push_back(batch);
+      }
+    }
+
+    instancing->m_batchGlyph = glyph;
+    instancing->m_batchColorKey = colorKey;
+    instancing->m_batchesDirty = false;
+  }
+
+  vesGLStateCache *state = vesGLStateCache::current();
+  const float noOffset[3] = {0.0f, 0.0f, 0.0f};
+  state->vertexAttrib3fv(vesVertexAttributeKeys::InstanceOffset, noOffset);
+  if (instancing->m_colors.empty()) {
+    state->vertexAttrib3fv(vesVertexAttributeKeys::InstanceColor, this->color());
+  }
+
+  // The vertex attributes read the geometry of the mapper in the render state.
+  vesRenderState &batchState = instancing->m_batchState;
+  batchState.m_material = renderState.m_material;
+  batchState.m_viewSize = renderState.m_viewSize;
+  batchState.m_projectionMatrix = renderState.m_projectionMatrix;
+  batchState.m_modelViewMatrix = renderState.m_modelViewMatrix;
+
+  const float *color = this->color();
+  for (size_t i = 0; i < instancing->m_batches.size(); ++i) {
+    vesMapper::Ptr batch = instancing->m_batches[i];
+    batch->setColor(color[0], color[1], color[2], color[3]);
+    batch->setPointSize(this->pointSize());
+    batch->setLineWidth(this->lineWidth());
+    batch->enableWireframe(this->isEnabledWireframe());
+    batchState.m_mapper = batch;
+    batch->render(batchState);
+  }
+
+  batchState.m_material.reset();
+  batchState.m_mapper.reset();
+}
+
+
+void vesInstancedMapper::drawElements(unsigned int mode, int count,
+                                      unsigned int type, const void *offset)
+{
+#ifdef VES_HAS_INSTANCED_ARRAYS
+  if (this->m_instancing->m_drawInstances) {
+    vesDrawElementsInstanced(mode, count, type, offset, this->numberOfInstances());
+    vesProfiler::countDrawCall(mode, count, this->numberOfInstances());
+    return;
+  }
+#endif
+  vesMapper::drawElements(mode, count, type, offset);
+}
+
+
+void vesInstancedMapper::drawArrays(unsigned int mode, int first, int count)
+{
+#ifdef VES_HAS_INSTANCED_ARRAYS
+  if (this->m_instancing->m_drawInstances) {
+    vesDrawArraysInstanced(mode, first, count, this->numberOfInstances());
+    vesProfiler::countDrawCall(mode, count, this->numberOfInstances());
+    return;
+  }
+#endif
+  vesMapper::drawArrays(mode, first, count);
+}
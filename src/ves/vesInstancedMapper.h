@@ -0,0 +1,107 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesInstancedMapper
+/// \ingroup ves
+/// \brief Mapper that draws one geometry, e.g. a glyph, at many places.
+///
+/// The geometry data holds a single copy of the glyph.  Each instance has an
+/// offset, whose w component is a uniform scale, and optionally a color.  The
+/// shader program has to read them from the vesVertexAttributeKeys
+/// InstanceOffset and InstanceColor attributes, for example
+/// \code
+///   gl_Position = mvp * vec4(vertexPosition * instanceOffset.w + instanceOffset.xyz, 1.0);
+/// \endcode
+///
+/// When the context supports instanced arrays the glyph is uploaded once and
+/// all instances are drawn with one instanced draw call per primitive.
+/// Otherwise the glyph is copied to every instance on the CPU, pre-transformed,
+/// in batches small enough for 16 bit indices.  The batches keep the
+/// attribute layout, with InstanceOffset left at (0, 0, 0, 1), so the same
+/// shader program works for both paths.
+///
+/// \see vesMapper vesVertexAttributeKeys
+
+#ifndef VESINSTANCEDMAPPER_H
+#define VESINSTANCEDMAPPER_H
+
+#include "vesMapper.h"
+
+// VES includes
+#include "vesMath.h"
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <vector>
+
+class vesInstancedMapper : public vesMapper
+{
+public:
+  vesTypeMacro(vesInstancedMapper);
+
+  vesInstancedMapper();
+  virtual ~vesInstancedMapper();
+
+  /// Instance positions in xyz and uniform scales in w.
+  void setInstanceOffsets(const std::vector<vesVector4f> &offsets);
+  const std::vector<vesVector4f>& instanceOffsets() const;
+
+  /// One color per instance, or none to use the mapper color for all.
+  void setInstanceColors(const std::vector<vesVector3f> &colors);
+  const std::vector<vesVector3f>& instanceColors() const;
+
+  int numberOfInstances() const;
+
+  /// Allow the instanced draw path.  Enabled by default, disabling it forces
+  /// the batched CPU fallback.
+  void setInstancingEnabled(bool value);
+  bool isInstancingEnabled() const;
+
+  /// Whether the current context can draw instanced arrays.  Needs a current
+  /// context.
+  static bool isInstancingSupported();
+
+  /// Whether the last render() used the instanced draw path.
+  bool usedInstancing() const;
+
+  /// Number of vertices per batch of the CPU fallback.
+  static int maximumVerticesPerBatch();
+
+  /// Bounds of all instances.
+  virtual void computeBounds();
+
+  virtual void render(const vesRenderState &renderState);
+
+protected:
+  virtual void drawElements(unsigned int mode, int count, unsigned int type,
+                            const void *offset);
+  virtual void drawArrays(unsigned int mode, int first, int count);
+
+private:
+  vesInstancedMapper(const vesInstancedMapper&); // Not implemented
+  void operator=(const vesInstancedMapper&); // Not implemented
+
+  void renderInstanced(const vesRenderState &renderState);
+  void renderBatches(const vesRenderState &renderState);
+
+  class vesInstancing;
+  vesInstancing *m_instancing;
+};
+
+#endif
@@ -24,7 +24,9 @@
 // VES includes
 #include "vesMaterial.h"
 #include "vesGeometryData.h"
+#include "vesGLStateCache.h"
 #include "vesGLTypes.h"
+#include "vesProfiler.h"
 #include "vesRenderData.h"
 #include "vesRenderStage.h"
 #include "vesShaderProgram.h"
@@ -33,6 +35,7 @@
 #include "vesGL.h"
 
 // C++ includes
+#include <algorithm>
 #include <map>
 #include <vector>
 #include <cstdio>
@@ -41,7 +44,9 @@
 class vesMapper::vesInternal
 {
 public:
-  vesInternal()
+  vesInternal() :
+    m_sourcesDirty(false),
+    m_levelBuffersDirty(false)
   {
     this->m_color.resize(4);
   }
@@ -65,11 +70,46 @@ public:
   {
     this->m_bufferVertexAttributeMap.clear();
     this->m_buffers.clear();
+    this->m_backBuffers.clear();
+    this->m_levelBuffers.clear();
+    this->m_levelBuffersDirty = !this->m_levels.empty();
+    this->m_sourcesDirty = false;
   }
 
+  // True if the two geometries draw the same primitive objects in the same
+  // order, so the index buffers of one can be used for the other.
+  static bool sharePrimitives(const vesGeometryData &first, const vesGeometryData &second)
+  {
+    if (first.numberOfPrimitiveTypes() == 0
+        || first.numberOfPrimitiveTypes() != second.numberOfPrimitiveTypes()) {
+      return false;
+    }
+    for (unsigned int i = 0; i < first.numberOfPrimitiveTypes(); ++i) {
+      if (first.primitive(i) != second.primitive(i)) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  struct LevelOfDetail
+  {
+    vesSharedPtr<vesPrimitive> m_triangles;
+    float m_maximumScreenSize;
+  };
+
   std::vector< float >                       m_color;
   std::vector< unsigned int >                m_buffers;
   std::map< unsigned int, std::vector<int> > m_bufferVertexAttributeMap;
+
+  // Second set of vertex buffers for geometries that only replace the
+  // sources, swapped with the front of m_buffers on every upload.
+  std::vector< unsigned int >                m_backBuffers;
+  bool                                       m_sourcesDirty;
+
+  std::vector< LevelOfDetail >               m_levels;
+  std::vector< unsigned int >                m_levelBuffers;
+  bool                                       m_levelBuffersDirty;
 };
 
 
@@ -116,8 +156,23 @@ bool vesMapper::setGeometryData(vesSharedPtr<vesGeometryData> geometryData)
 
   if (geometryData && this->m_geometryData != geometryData)
   {
+    // A geometry that draws the same primitives, like the next frame of a
+    // series with fixed connectivity, keeps the index buffers and levels of
+    // detail; only its sources are uploaded.
+    if (this->m_initialized && this->m_geometryData
+        && this->m_geometryData->numberOfSources() == geometryData->numberOfSources()
+        && vesInternal::sharePrimitives(*this->m_geometryData, *geometryData)) {
+      this->m_internal->m_sourcesDirty = true;
+    }
+    else {
+      this->m_initialized = false;
+
+      // Levels of detail index the vertices of the previous geometry.
+      this->removeAllLevelsOfDetail();
+    }
+
     this->m_geometryData = geometryData;
-    this->m_initialized = false;
+    this->setBoundsDirty(true);
   }
   else
   {
@@ -194,6 +249,56 @@ bool vesMapper::isEnabledWireframe() const
 }
 
 
+void vesMapper::addLevelOfDetail(vesSharedPtr<vesPrimitive> triangles,
+                                 float maximumScreenSize)
+{
+  assert(triangles);
+
+  vesInternal::LevelOfDetail level;
+  level.m_triangles = triangles;
+  level.m_maximumScreenSize = maximumScreenSize;
+  this->m_internal->m_levels.push_back(level);
+  this->m_internal->m_levelBuffersDirty = true;
+}
+
+
+void vesMapper::removeAllLevelsOfDetail()
+{
+  this->m_internal->m_levels.clear();
+  this->m_internal->m_levelBuffersDirty = true;
+}
+
+
+int vesMapper::numberOfLevelsOfDetail() const
+{
+  return static_cast<int>(this->m_internal->m_levels.size());
+}
+
+
+vesSharedPtr<vesPrimitive> vesMapper::levelOfDetail(int level) const
+{
+  if (level < 1 || level > this->numberOfLevelsOfDetail()) {
+    return vesSharedPtr<vesPrimitive>();
+  }
+  return this->m_internal->m_levels[level - 1].m_triangles;
+}
+
+
+int vesMapper::selectLevelOfDetail(float screenSize, int bias) const
+{
+  const int numberOfLevels = this->numberOfLevelsOfDetail();
+
+  int level = 0;
+  while (level < numberOfLevels
+         && screenSize < this->m_internal->m_levels[level].m_maximumScreenSize) {
+    ++level;
+  }
+
+  level += bias;
+  return level < 0 ? 0 : (level > numberOfLevels ? numberOfLevels : level);
+}
+
+
 void vesMapper::render(const vesRenderState &renderState)
 {
   assert(this->m_geometryData);
@@ -201,13 +306,26 @@ void vesMapper::render(const vesRenderState &renderState)
   if (!this->m_initialized) {
     this->setupDrawObjects(renderState);
   }
+  else if (this->m_internal->m_sourcesDirty) {
+    this->updateVertexBufferObjects();
+  }
+
+  if (this->m_internal->m_levelBuffersDirty) {
+    this->createLevelOfDetailBufferObjects();
+  }
+
+  const int level = (renderState.m_levelOfDetail <= this->numberOfLevelsOfDetail())
+    ? renderState.m_levelOfDetail : this->numberOfLevelsOfDetail();
+  bool drawnLevel = false;
+
+  vesGLStateCache *state = vesGLStateCache::current();
 
   if (renderState.m_material->binNumber() == vesMaterial::Overlay) {
-    glDisable(GL_DEPTH_TEST);
+    state->disable(GL_DEPTH_TEST);
   }
 
   // Fixed vertex color.
-  glVertexAttrib3fv(vesVertexAttributeKeys::Color, this->color());
+  state->vertexAttrib3fv(vesVertexAttributeKeys::Color, this->color());
 
   std::map<unsigned int, std::vector<int> >::const_iterator constItr
     = this->m_internal->m_bufferVertexAttributeMap.begin();
@@ -215,7 +333,7 @@ void vesMapper::render(const vesRenderState &renderState)
   int bufferIndex = 0;
   for (; constItr != this->m_internal->m_bufferVertexAttributeMap.end();
        ++constItr) {
-    glBindBuffer(GL_ARRAY_BUFFER, constItr->first);
+    state->bindBuffer(GL_ARRAY_BUFFER, constItr->first);
     for (size_t i = 0; i < constItr->second.size(); ++i) {
       renderState.m_material->bindVertexData(renderState, constItr->second[i]);
     }
@@ -225,7 +343,21 @@ void vesMapper::render(const vesRenderState &renderState)
   unsigned int numberOfPrimitiveTypes = this->m_geometryData->numberOfPrimitiveTypes();
   for(unsigned int i = 0; i < numberOfPrimitiveTypes; ++i)
   {
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_internal->m_buffers[bufferIndex++]);
+    const unsigned int primitiveBuffer = this->m_internal->m_buffers[bufferIndex++];
+
+    if (level > 0 && this->m_geometryData->primitive(i)->primitiveType()
+      == vesPrimitiveRenderType::Triangles) {
+      // A level of detail replaces all triangles of the geometry.
+      if (!drawnLevel) {
+        state->bindBuffer(GL_ELEMENT_ARRAY_BUFFER,
+                          this->m_internal->m_levelBuffers[level - 1]);
+        this->drawTriangles(renderState, this->m_internal->m_levels[level - 1].m_triangles);
+        drawnLevel = true;
+      }
+      continue;
+    }
+
+    state->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, primitiveBuffer);
 
     if (this->m_geometryData->primitive(i)->primitiveType()
       == vesPrimitiveRenderType::Triangles) {
@@ -254,11 +386,11 @@ void vesMapper::render(const vesRenderState &renderState)
     ++bufferIndex;
   }
 
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+  state->bindBuffer(GL_ARRAY_BUFFER, 0);
+  state->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
   if (renderState.m_material->binNumber() == vesMaterial::Overlay) {
-    glEnable(GL_DEPTH_TEST);
+    state->enable(GL_DEPTH_TEST);
   }
 }
 
@@ -291,9 +423,10 @@ void vesMapper::createVertexBufferObjects()
   {
     glGenBuffers(1, &bufferId);
     this->m_internal->m_buffers.push_back(bufferId);
-    glBindBuffer(GL_ARRAY_BUFFER, this->m_internal->m_buffers.back());
+    vesGLStateCache::current()->bindBuffer(GL_ARRAY_BUFFER, this->m_internal->m_buffers.back());
     glBufferData(GL_ARRAY_BUFFER, this->m_geometryData->source(i)->sizeInBytes(),
       this->m_geometryData->source(i)->data(), GL_STATIC_DRAW);
+    vesProfiler::countBufferUpload(this->m_geometryData->source(i)->sizeInBytes());
 
     std::vector<int> keys = this->m_geometryData->source(i)->keys();
     for(size_t j = 0; j < keys.size(); ++j) {
@@ -307,23 +440,92 @@ void vesMapper::createVertexBufferObjects()
   {
     glGenBuffers(1, &bufferId);
     this->m_internal->m_buffers.push_back(bufferId);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_internal->m_buffers.back());
+    vesGLStateCache::current()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->m_internal->m_buffers.back());
     glBufferData(GL_ELEMENT_ARRAY_BUFFER,
       this->m_geometryData->primitive(i)->sizeInBytes(),
       this->m_geometryData->primitive(i)->data(),
       GL_STATIC_DRAW);
+    vesProfiler::countBufferUpload(this->m_geometryData->primitive(i)->sizeInBytes());
   }
 
   this->m_initialized = true;
 }
 
 
+void vesMapper::updateVertexBufferObjects()
+{
+  assert(this->m_geometryData);
+
+  // Upload into the buffers that were not drawn last, so the driver does not
+  // have to wait for draws still reading the current ones, then swap.
+  std::vector<unsigned int> &backBuffers = this->m_internal->m_backBuffers;
+  unsigned int numberOfSources = this->m_geometryData->numberOfSources();
+  if (backBuffers.size() != numberOfSources) {
+    if (!backBuffers.empty()) {
+      vesGLStateCache::current()->deleteBuffers(backBuffers.size(), &backBuffers.front());
+    }
+    backBuffers.resize(numberOfSources);
+    glGenBuffers(numberOfSources, &backBuffers.front());
+  }
+
+  this->m_internal->m_bufferVertexAttributeMap.clear();
+  for (unsigned int i = 0; i < numberOfSources; ++i)
+  {
+    vesGLStateCache::current()->bindBuffer(GL_ARRAY_BUFFER, backBuffers[i]);
+    glBufferData(GL_ARRAY_BUFFER, this->m_geometryData->source(i)->sizeInBytes(),
+      this->m_geometryData->source(i)->data(), GL_STATIC_DRAW);
+    vesProfiler::countBufferUpload(this->m_geometryData->source(i)->sizeInBytes());
+    std::swap(backBuffers[i], this->m_internal->m_buffers[i]);
+
+    std::vector<int> keys = this->m_geometryData->source(i)->keys();
+    for (size_t j = 0; j < keys.size(); ++j) {
+      this->m_internal->m_bufferVertexAttributeMap[
+      this->m_internal->m_buffers[i]].push_back(keys[j]);
+    }
+  }
+
+  this->m_internal->m_sourcesDirty = false;
+}
+
+
+void vesMapper::createLevelOfDetailBufferObjects()
+{
+  if (!this->m_internal->m_levelBuffers.empty()) {
+    vesGLStateCache::current()->deleteBuffers(this->m_internal->m_levelBuffers.size(),
+                    &this->m_internal->m_levelBuffers.front());
+    this->m_internal->m_levelBuffers.clear();
+  }
+
+  // Only the indices are uploaded, the levels share the vertex buffers.
+  for (size_t i = 0; i < this->m_internal->m_levels.size(); ++i) {
+    vesSharedPtr<vesPrimitive> triangles = this->m_internal->m_levels[i].m_triangles;
+    unsigned int bufferId;
+    glGenBuffers(1, &bufferId);
+    this->m_internal->m_levelBuffers.push_back(bufferId);
+    vesGLStateCache::current()->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, bufferId);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles->sizeInBytes(),
+      triangles->data(), GL_STATIC_DRAW);
+    vesProfiler::countBufferUpload(triangles->sizeInBytes());
+  }
+
+  this->m_internal->m_levelBuffersDirty = false;
+}
+
+
 void vesMapper::deleteVertexBufferObjects()
 {
   if (!this->m_internal->m_buffers.empty()) {
-    glDeleteBuffers(this->m_internal->m_buffers.size(),
+    vesGLStateCache::current()->deleteBuffers(this->m_internal->m_buffers.size(),
                     &this->m_internal->m_buffers.front());
   }
+  if (!this->m_internal->m_levelBuffers.empty()) {
+    vesGLStateCache::current()->deleteBuffers(this->m_internal->m_levelBuffers.size(),
+                    &this->m_internal->m_levelBuffers.front());
+  }
+  if (!this->m_internal->m_backBuffers.empty()) {
+    vesGLStateCache::current()->deleteBuffers(this->m_internal->m_backBuffers.size(),
+                    &this->m_internal->m_backBuffers.front());
+  }
 }
 
 
@@ -334,8 +536,8 @@ void vesMapper::drawPrimitive(const vesRenderState &renderState,
   renderState.m_material->bindRenderData(
     renderState, vesRenderData(primitive->primitiveType(), this->pointSize(), this->lineWidth()));
 
-  glDrawElements(primitive->primitiveType(), primitive->numberOfIndices(),
-                 primitive->indicesValueType(),  (void*)0);
+  this->drawElements(primitive->primitiveType(), primitive->numberOfIndices(),
+                     primitive->indicesValueType(), (void*)0);
 }
 
 
@@ -365,16 +567,16 @@ void vesMapper::drawTriangles(const vesRenderState &renderState,
     if (!this->m_enableWireframe) {
       offset = triangles->sizeOfDataType() * drawnIndices;
 
-      glDrawElements(triangles->primitiveType(), numberOfIndicesToDraw,
-                     triangles->indicesValueType(), (void*)offset);
+      this->drawElements(triangles->primitiveType(), numberOfIndicesToDraw,
+                         triangles->indicesValueType(), (void*)offset);
     }
     else {
       for(int i = 0; i < numberOfIndicesToDraw; i += 3)
       {
           offset = triangles->sizeOfDataType() * i + triangles->sizeOfDataType()
                    * drawnIndices;
-          glDrawElements(GL_LINE_LOOP, 3,
-                         triangles->indicesValueType(), (void*)offset);
+          this->drawElements(GL_LINE_LOOP, 3,
+                             triangles->indicesValueType(), (void*)offset);
       }
     }
 
@@ -400,6 +602,21 @@ void vesMapper::drawPoints(const vesRenderState &renderState,
     // Send the primitive type information out
     renderState.m_material->bindRenderData(
       renderState, vesRenderData(vesPrimitiveRenderType::Points, this->pointSize(), this->lineWidth()));
-    glDrawArrays(points->primitiveType(), 0, data->sizeOfArray());
+    this->drawArrays(points->primitiveType(), 0, data->sizeOfArray());
   }
 }
+
+
+void vesMapper::drawElements(unsigned int mode, int count, unsigned int type,
+                             const void *offset)
+{
+  glDrawElements(mode, count, type, offset);
+  vesProfiler::countDrawCall(mode, count);
+}
+
+
+void vesMapper::drawArrays(unsigned int mode, int first, int count)
+{
+  glDrawArrays(mode, first, count);
+  vesProfiler::countDrawCall(mode, count);
+}
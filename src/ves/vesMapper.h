@@ -58,7 +58,10 @@ public:
   /// Compute bounds of the mapper
   virtual void computeBounds();
 
-  /// Set geometry data for the mapper
+  /// Set geometry data for the mapper.  If the new geometry holds the same
+  /// primitive objects and as many sources as the current one, the index
+  /// buffers and levels of detail are kept and only the sources are uploaded
+  /// into a second set of vertex buffers.
   bool setGeometryData(vesSharedPtr<vesGeometryData> geometryData);
 
   /// Get geometry data of the mapper
@@ -83,14 +86,34 @@ public:
   /// Check whether or not wireframe rendering is enabled
   bool isEnabledWireframe() const;
 
+  /// Add a coarser set of triangles over the same vertices, drawn in place
+  /// of the geometry triangles when the mapper bounds cover fewer than
+  /// \p maximumScreenSize pixels.  Add levels from the finest to the
+  /// coarsest; they only cost an extra index buffer each.  The levels are
+  /// removed when the geometry data is replaced.
+  /// \see vesGeometrySimplifier
+  void addLevelOfDetail(vesSharedPtr<vesPrimitive> triangles, float maximumScreenSize);
+  void removeAllLevelsOfDetail();
+  int numberOfLevelsOfDetail() const;
+
+  /// Triangles of \p level, from 1 to numberOfLevelsOfDetail().
+  vesSharedPtr<vesPrimitive> levelOfDetail(int level) const;
+
+  /// Level to draw when the bounds cover \p screenSize pixels, made
+  /// \p bias levels coarser.  Level 0 is the geometry itself.
+  int selectLevelOfDetail(float screenSize, int bias) const;
+
   /// Render the geometry
   virtual void render(const vesRenderState &renderState);
 
 private:
   virtual void setupDrawObjects(const vesRenderState &renderState);
 
+  void createLevelOfDetailBufferObjects();
+
   virtual void createVertexBufferObjects();
   virtual void deleteVertexBufferObjects();
+  void updateVertexBufferObjects();
 
 protected:
   void drawPrimitive(const vesRenderState &renderState,
@@ -100,6 +123,12 @@ protected:
   void drawPoints(const vesRenderState &renderState,
                   vesSharedPtr<vesPrimitive> points);
 
+  /// Every draw call of render() goes through these, so subclasses can
+  /// draw the same buffers differently, e.g. several instances at once.
+  virtual void drawElements(unsigned int mode, int count, unsigned int type,
+                            const void *offset);
+  virtual void drawArrays(unsigned int mode, int first, int count);
+
   bool m_initialized;
   bool m_enableWireframe;
 
@@ -0,0 +1,296 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+// The buffer mapping entry points of OpenGL ES are extension prototypes,
+// and the header below includes the GL headers.
+#if !defined(VES_USE_DESKTOP_GL) && !defined(GL_GLEXT_PROTOTYPES)
+  #define GL_GLEXT_PROTOTYPES
+#endif
+
+#include "vesOffscreenRenderTarget.h"
+
+// VES includes
+#include "vesGL.h"
+#include "vesGLTypes.h"
+
+// C/C++ includes
+#include <cstdio>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(VES_USE_DESKTOP_GL) && defined(GL_PIXEL_PACK_BUFFER)
+  #define VES_HAS_PIXEL_BUFFER_OBJECT
+  #define VES_PIXEL_PACK_BUFFER GL_PIXEL_PACK_BUFFER
+  #define VES_PIXEL_PACK_USAGE GL_STREAM_READ
+  #define vesMapPixelPackBuffer(size) glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY)
+  #define vesUnmapPixelPackBuffer() glUnmapBuffer(GL_PIXEL_PACK_BUFFER)
+#elif !defined(VES_USE_DESKTOP_GL) && defined(GL_PIXEL_PACK_BUFFER_NV) \
+  && defined(GL_MAP_READ_BIT_EXT) && defined(GL_OES_mapbuffer)
+  #define VES_HAS_PIXEL_BUFFER_OBJECT
+  #define VES_PIXEL_PACK_BUFFER GL_PIXEL_PACK_BUFFER_NV
+  #define VES_PIXEL_PACK_USAGE GL_STREAM_DRAW
+  #define vesMapPixelPackBuffer(size) \
+    glMapBufferRangeEXT(GL_PIXEL_PACK_BUFFER_NV, 0, size, GL_MAP_READ_BIT_EXT)
+  #define vesUnmapPixelPackBuffer() glUnmapBufferOES(GL_PIXEL_PACK_BUFFER_NV)
+#endif
+
+namespace {
+
+bool hasExtension(const std::string &name)
+{
+  const GLubyte *value = glGetString(GL_EXTENSIONS);
+  std::stringstream extensions(
+    value ? reinterpret_cast<const char*>(value) : "");
+  std::string extension;
+  while (extensions >> extension) {
+    if (extension == name) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+
+vesOffscreenRenderTarget::vesOffscreenRenderTarget(int width, int height) :
+  vesFBORenderTarget(),
+  m_width(0),
+  m_height(0),
+  m_imageWidth(0),
+  m_imageHeight(0),
+  m_imageX(0),
+  m_imageY(0),
+  m_asynchronousReadback(true),
+  m_initialized(false),
+  m_pixelBufferObjectsSupported(false),
+  m_numberOfFrames(0),
+  m_imageFrameNumber(0),
+  m_pixelBufferWidth(0),
+  m_pixelBufferHeight(0)
+{
+  this->m_pixelBuffers[0] = this->m_pixelBuffers[1] = 0;
+  this->m_pixelBufferFrameNumbers[0] = this->m_pixelBufferFrameNumbers[1] = 0;
+
+  this->setSize(width, height);
+}
+
+
+vesOffscreenRenderTarget::~vesOffscreenRenderTarget()
+{
+  this->deletePixelBuffers();
+}
+
+
+void vesOffscreenRenderTarget::setSize(int width, int height)
+{
+  width = width > 0 ? width : 1;
+  height = height > 0 ? height : 1;
+  if (width == this->m_width && height == this->m_height) {
+    return;
+  }
+
+  this->m_width = width;
+  this->m_height = height;
+  this->m_fbo->setWidth(width);
+  this->m_fbo->setHeight(height);
+}
+
+
+void vesOffscreenRenderTarget::setImageRegion(int imageWidth, int imageHeight, int x, int y)
+{
+  this->m_imageWidth = imageWidth;
+  this->m_imageHeight = imageHeight;
+  this->m_imageX = x;
+  this->m_imageY = y;
+}
+
+
+void vesOffscreenRenderTarget::setAsynchronousReadback(bool enabled)
+{
+  this->m_asynchronousReadback = enabled;
+}
+
+
+void vesOffscreenRenderTarget::render(vesRenderState &renderState)
+{
+  if (!this->m_initialized) {
+    this->initialize();
+  }
+
+  vesFBORenderTarget::render(renderState);
+}
+
+
+void vesOffscreenRenderTarget::readPixels()
+{
+  ++this->m_numberOfFrames;
+
+#ifdef VES_HAS_PIXEL_BUFFER_OBJECT
+  if (this->m_asynchronousReadback && this->m_pixelBufferObjectsSupported) {
+    // Frames pending in buffers of another size are dropped.
+    if (this->m_pixelBufferWidth != this->m_width
+        || this->m_pixelBufferHeight != this->m_height) {
+      this->deletePixelBuffers();
+    }
+
+    const GLsizeiptr size =
+      static_cast<GLsizeiptr>(this->m_width) * this->m_height * 4;
+    if (!this->m_pixelBuffers[0]) {
+      glGenBuffers(2, this->m_pixelBuffers);
+      for (int i = 0; i < 2; ++i) {
+        glBindBuffer(VES_PIXEL_PACK_BUFFER, this->m_pixelBuffers[i]);
+        glBufferData(VES_PIXEL_PACK_BUFFER, size, 0, VES_PIXEL_PACK_USAGE);
+      }
+      this->m_pixelBufferWidth = this->m_width;
+      this->m_pixelBufferHeight = this->m_height;
+    }
+
+    // Start copying this frame into one buffer, which returns at once, and
+    // read the previous frame from the other one, which is done by now.
+    const int index = static_cast<int>(this->m_numberOfFrames % 2);
+    glBindBuffer(VES_PIXEL_PACK_BUFFER, this->m_pixelBuffers[index]);
+    glReadPixels(0, 0, this->m_width, this->m_height, GL_RGBA,
+                 GL_UNSIGNED_BYTE, 0);
+    this->m_pixelBufferFrameNumbers[index] = this->m_numberOfFrames;
+    glBindBuffer(VES_PIXEL_PACK_BUFFER, 0);
+
+    if (this->m_pixelBufferFrameNumbers[1 - index]) {
+      this->copyPixelBuffer(1 - index);
+    }
+    return;
+  }
+
+  // The frames pending in the buffers are older than this one.
+  this->m_pixelBufferFrameNumbers[0] = this->m_pixelBufferFrameNumbers[1] = 0;
+#endif
+
+  this->m_pixelBufferWidth = this->m_width;
+  this->m_pixelBufferHeight = this->m_height;
+  glReadPixels(0, 0, this->m_width, this->m_height, GL_RGBA, GL_UNSIGNED_BYTE,
+               this->imageData());
+  this->m_imageFrameNumber = this->m_numberOfFrames;
+}
+
+
+void vesOffscreenRenderTarget::finish()
+{
+  const int newest =
+    this->m_pixelBufferFrameNumbers[0] > this->m_pixelBufferFrameNumbers[1] ? 0 : 1;
+  if (this->m_pixelBufferFrameNumbers[newest]) {
+    this->copyPixelBuffer(newest);
+  }
+  this->m_pixelBufferFrameNumbers[0] = this->m_pixelBufferFrameNumbers[1] = 0;
+}
+
+
+vesSharedPtr<vesImage> vesOffscreenRenderTarget::image() const
+{
+  return this->m_imageFrameNumber ? this->m_image : vesSharedPtr<vesImage>();
+}
+
+
+void vesOffscreenRenderTarget::initialize()
+{
+  this->m_initialized = true;
+
+#ifdef VES_USE_DESKTOP_GL
+  this->m_fbo->setRenderbufferFormat(vesFBO::ColorAttachment0, GL_RGBA8);
+  this->m_fbo->setRenderbufferFormat(vesFBO::DepthAttachment, GL_DEPTH_COMPONENT24);
+#else
+#if defined(GL_RGBA8_OES) && defined(GL_DEPTH_COMPONENT24_OES)
+  this->m_fbo->setRenderbufferFormat(vesFBO::ColorAttachment0,
+    hasExtension("GL_OES_rgb8_rgba8") ? GL_RGBA8_OES : GL_RGBA4);
+  this->m_fbo->setRenderbufferFormat(vesFBO::DepthAttachment,
+    hasExtension("GL_OES_depth24") ? GL_DEPTH_COMPONENT24_OES : GL_DEPTH_COMPONENT16);
+#else
+  this->m_fbo->setRenderbufferFormat(vesFBO::ColorAttachment0, GL_RGBA4);
+#endif
+#endif
+
+#ifdef VES_HAS_PIXEL_BUFFER_OBJECT
+#ifdef VES_USE_DESKTOP_GL
+  // Pixel buffer objects are core since OpenGL 2.1.
+  int major = 0;
+  int minor = 0;
+  const GLubyte *version = glGetString(GL_VERSION);
+  if (version) {
+    sscanf(reinterpret_cast<const char*>(version), "%d.%d", &major, &minor);
+  }
+  this->m_pixelBufferObjectsSupported = major > 2 || (major == 2 && minor >= 1)
+    || hasExtension("GL_ARB_pixel_buffer_object");
+#else
+  this->m_pixelBufferObjectsSupported = hasExtension("GL_NV_pixel_buffer_object")
+    && hasExtension("GL_EXT_map_buffer_range") && hasExtension("GL_OES_mapbuffer");
+#endif
+#endif
+}
+
+
+void vesOffscreenRenderTarget::deletePixelBuffers()
+{
+  if (this->m_pixelBuffers[0]) {
+    glDeleteBuffers(2, this->m_pixelBuffers);
+  }
+  this->m_pixelBuffers[0] = this->m_pixelBuffers[1] = 0;
+  this->m_pixelBufferFrameNumbers[0] = this->m_pixelBufferFrameNumbers[1] = 0;
+}
+
+
+void vesOffscreenRenderTarget::copyPixelBuffer(int index)
+{
+#ifdef VES_HAS_PIXEL_BUFFER_OBJECT
+  const GLsizeiptr size =
+    static_cast<GLsizeiptr>(this->m_pixelBufferWidth) * this->m_pixelBufferHeight * 4;
+  glBindBuffer(VES_PIXEL_PACK_BUFFER, this->m_pixelBuffers[index]);
+  const void *data = vesMapPixelPackBuffer(size);
+  if (data) {
+    memcpy(this->imageData(), data, size);
+    vesUnmapPixelPackBuffer();
+    this->m_imageFrameNumber = this->m_pixelBufferFrameNumbers[index];
+  }
+  glBindBuffer(VES_PIXEL_PACK_BUFFER, 0);
+#else
+  vesNotUsed(index);
+#endif
+  this->m_pixelBufferFrameNumbers[index] = 0;
+}
+
+
+void *vesOffscreenRenderTarget::imageData()
+{
+  const int width = this->m_pixelBufferWidth;
+  const int height = this->m_pixelBufferHeight;
+  if (!this->m_image || this->m_image->width() != width
+      || this->m_image->height() != height) {
+    // A new image rather than a resized one, in case the last is still used.
+    this->m_image = vesImage::Ptr(new vesImage());
+    this->m_image->setWidth(width);
+    this->m_image->setHeight(height);
+    this->m_image->setDepth(1);
+    this->m_image->setPixelFormat(vesColorDataType::RGBA);
+    this->m_image->setPixelDataType(vesColorDataType::UnsignedByte);
+    std::vector<unsigned char> pixels(static_cast<size_t>(width) * height * 4, 0);
+    this->m_image->setData(&pixels[0], static_cast<unsigned int>(pixels.size()));
+  }
+  return this->m_image->data();
+}
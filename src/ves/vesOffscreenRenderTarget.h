@@ -0,0 +1,131 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesOffscreenRenderTarget
+/// \ingroup ves
+/// \brief Renders into memory instead of the window
+///
+/// The target is a framebuffer object of its own size with 8 bit RGBA color
+/// and a 24 bit depth buffer.  On OpenGL ES those need GL_OES_rgb8_rgba8 and
+/// GL_OES_depth24, without which RGBA4 and 16 bit depth are used.
+///
+/// Every frame rendered into the target is read back into image().  When
+/// the driver has pixel buffer objects, the readback is asynchronous: a
+/// frame is copied into one of two pixel buffers while the other one, which
+/// holds the previous frame, is read.  image() then lags one frame behind,
+/// and finish() completes the pending readback.  Without pixel buffer
+/// objects, or with asynchronous readback disabled, every frame is read with
+/// a synchronous glReadPixels.
+///
+/// \see vesRenderer::setOffscreenTarget()
+
+#ifndef VESOFFSCREENRENDERTARGET_H
+#define VESOFFSCREENRENDERTARGET_H
+
+#include "vesFBORenderTarget.h"
+
+// VES includes
+#include "vesImage.h"
+#include "vesSetGet.h"
+
+class vesOffscreenRenderTarget : public vesFBORenderTarget
+{
+public:
+  vesTypeMacro(vesOffscreenRenderTarget);
+
+  vesOffscreenRenderTarget(int width = 0, int height = 0);
+  virtual ~vesOffscreenRenderTarget();
+
+  /// Set/Get the size of the target in pixels.
+  void setSize(int width, int height);
+  int width() const { return this->m_width; }
+  int height() const { return this->m_height; }
+
+  /// Set the region of a larger image the target renders: its bottom left
+  /// corner is at pixel (\p x, \p y) of an image of size \p imageWidth x
+  /// \p imageHeight.  vesRenderer lays out the background and 2D items in the
+  /// image, so that tiles rendered with matching cameras fit together.  A
+  /// zero image size, the default, makes the target the whole image.
+  /// \see vesCamera::setWindowCenter()
+  void setImageRegion(int imageWidth, int imageHeight, int x, int y);
+  int imageWidth() const { return this->m_imageWidth > 0 ? this->m_imageWidth : this->m_width; }
+  int imageHeight() const { return this->m_imageHeight > 0 ? this->m_imageHeight : this->m_height; }
+  int imageX() const { return this->m_imageWidth > 0 ? this->m_imageX : 0; }
+  int imageY() const { return this->m_imageHeight > 0 ? this->m_imageY : 0; }
+
+  /// Set/Get whether frames are read back through pixel buffer objects
+  /// when the driver has them.  On by default.
+  void setAsynchronousReadback(bool enabled);
+  bool asynchronousReadback() const { return this->m_asynchronousReadback; }
+
+  /// True once a frame was rendered and the driver has pixel buffer
+  /// objects.
+  bool hasPixelBufferObjects() const { return this->m_pixelBufferObjectsSupported; }
+
+  virtual void render(vesRenderState &renderState);
+
+  /// Start reading the frame just rendered.  Called by vesRenderer after
+  /// the render stage, while the target is bound.
+  void readPixels();
+
+  /// Wait for the pending readback, so that image() holds the last rendered
+  /// frame.  Needs the context of the target current.
+  void finish();
+
+  /// Last frame read back, in RGBA with 8 bits per channel and the bottom
+  /// row first, or null before the first readback completed.  The image is
+  /// reused, so copy it to keep a frame.
+  vesSharedPtr<vesImage> image() const;
+
+  /// Number of frames rendered into the target, and the number of the frame
+  /// image() holds, counting from 1.
+  unsigned long numberOfFrames() const { return this->m_numberOfFrames; }
+  unsigned long imageFrameNumber() const { return this->m_imageFrameNumber; }
+
+private:
+  vesOffscreenRenderTarget(const vesOffscreenRenderTarget&);
+  void operator=(const vesOffscreenRenderTarget&);
+
+  void initialize();
+  void deletePixelBuffers();
+  void copyPixelBuffer(int index);
+  void *imageData();
+
+  int m_width;
+  int m_height;
+  int m_imageWidth;
+  int m_imageHeight;
+  int m_imageX;
+  int m_imageY;
+  bool m_asynchronousReadback;
+  bool m_initialized;
+  bool m_pixelBufferObjectsSupported;
+
+  unsigned long m_numberOfFrames;
+  unsigned long m_imageFrameNumber;
+  vesSharedPtr<vesImage> m_image;
+
+  // Two pixel buffers used in turn, and the frame each one receives, or 0.
+  unsigned int m_pixelBuffers[2];
+  unsigned long m_pixelBufferFrameNumbers[2];
+  int m_pixelBufferWidth;
+  int m_pixelBufferHeight;
+};
+
+#endif // VESOFFSCREENRENDERTARGET_H
@@ -24,11 +24,13 @@
 #include "vesGL.h"
 
 // C++ includes
+#include <algorithm>
 #include <cassert>
 #include <sstream>
 
 vesOpenGLSupport::vesOpenGLSupport() :
-  m_initialized(false)
+  m_initialized(false),
+  m_maximumRenderSize(0)
 {
 }
 
@@ -69,6 +71,13 @@ void vesOpenGLSupport::initialize()
     this->m_extensionList.insert(str);
   }
 
+  GLint renderbufferSize = 0;
+  GLint viewportDims[2] = {0, 0};
+  glGetIntegerv(GL_MAX_RENDERBUFFER_SIZE, &renderbufferSize);
+  glGetIntegerv(GL_MAX_VIEWPORT_DIMS, viewportDims);
+  this->m_maximumRenderSize = std::min(renderbufferSize,
+                                       std::min(viewportDims[0], viewportDims[1]));
+
   this->m_initialized = true;
 }
 
@@ -57,6 +57,13 @@ public:
 
   bool isSupportedIndexUnsignedInt() const;
 
+  /// Largest width or height in pixels of an image rendered at once: the
+  /// smaller of the maximum renderbuffer size and viewport dimensions.
+  int maximumRenderSize() const
+  {
+    return m_maximumRenderSize;
+  }
+
   static void readBuffer(int x, int y, int width, int height,
                          int format, int type, void* data,
                          int bufferType=vesBufferType::Back);
@@ -67,6 +74,7 @@ private:
 
   std::string m_version;
   std::string m_vendor;
+  int m_maximumRenderSize;
 
   std::set<std::string> m_extensionList;
 };
@@ -0,0 +1,525 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesProfiler.h"
+
+// The timer query entry points of OpenGL ES are extension prototypes.
+#if !defined(VES_USE_DESKTOP_GL) && !defined(GL_GLEXT_PROTOTYPES)
+  #define GL_GLEXT_PROTOTYPES
+#endif
+
+// VES includes
+#include "vesGL.h"
+
+// C/C++ includes
+#include <cassert>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#if defined(_WIN32)
+  #include <windows.h>
+#elif defined(__APPLE__)
+  #include <mach/mach_time.h>
+#else
+  #include <time.h>
+#endif
+
+#if defined(VES_USE_DESKTOP_GL) && defined(GL_TIME_ELAPSED)
+  #define VES_HAS_TIMER_QUERY
+  #define vesGenQueries glGenQueries
+  #define vesDeleteQueries glDeleteQueries
+  #define vesBeginQuery glBeginQuery
+  #define vesEndQuery glEndQuery
+  #define vesGetQueryObjectiv glGetQueryObjectiv
+  #define vesGetQueryObjectui64v glGetQueryObjectui64v
+  #define VES_TIME_ELAPSED GL_TIME_ELAPSED
+  #define VES_QUERY_RESULT GL_QUERY_RESULT
+  #define VES_QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE
+  #define VES_TIMER_QUERY_EXTENSION "GL_ARB_timer_query"
+#elif !defined(VES_USE_DESKTOP_GL) && defined(GL_GPU_DISJOINT_EXT)
+  #define VES_HAS_TIMER_QUERY
+  #define VES_HAS_DISJOINT_TIMER_QUERY
+  #define vesGenQueries glGenQueriesEXT
+  #define vesDeleteQueries glDeleteQueriesEXT
+  #define vesBeginQuery glBeginQueryEXT
+  #define vesEndQuery glEndQueryEXT
+  #define vesGetQueryObjectiv glGetQueryObjectivEXT
+  #define vesGetQueryObjectui64v glGetQueryObjectui64vEXT
+  #define VES_TIME_ELAPSED GL_TIME_ELAPSED_EXT
+  #define VES_QUERY_RESULT GL_QUERY_RESULT_EXT
+  #define VES_QUERY_RESULT_AVAILABLE GL_QUERY_RESULT_AVAILABLE_EXT
+  #define VES_TIMER_QUERY_EXTENSION "GL_EXT_disjoint_timer_query"
+#endif
+
+namespace {
+
+vesThreadLocal unsigned long numberOfDrawCallsCounter = 0;
+vesThreadLocal unsigned long numberOfTrianglesCounter = 0;
+vesThreadLocal unsigned long numberOfBufferUploadsCounter = 0;
+vesThreadLocal unsigned long numberOfUploadedBytesCounter = 0;
+
+void resetFrame(vesProfiler::Frame &frame)
+{
+  frame.m_frameNumber = 0;
+  frame.m_startTime = 0.0;
+  frame.m_duration = 0.0;
+  for (int i = 0; i < vesProfiler::NumberOfPhases; ++i) {
+    frame.m_phaseStartTime[i] = 0.0;
+    frame.m_phaseDuration[i] = 0.0;
+    frame.m_gpuDuration[i] = -1.0;
+  }
+  frame.m_drawCalls = 0;
+  frame.m_triangles = 0;
+  frame.m_bufferUploads = 0;
+  frame.m_uploadedBytes = 0;
+}
+
+// Complete ("X") event of the Chrome trace format, times in microseconds
+// relative to the first recorded frame.
+void writeEvent(std::ostream &out, bool &first, const char *name,
+                int threadId, double start, double duration)
+{
+  out << (first ? "\n" : ",\n")
+      << "  {\"name\": \"" << name << "\", \"ph\": \"X\", \"pid\": 0, "
+      << "\"tid\": " << threadId << ", \"ts\": " << start * 1.0e6
+      << ", \"dur\": " << duration * 1.0e6 << "}";
+  first = false;
+}
+
+}
+
+vesProfiler::vesProfiler(int capacity) :
+  m_frames(capacity > 0 ? capacity : 1),
+  m_next(0),
+  m_count(0),
+  m_frameNumber(0),
+  m_inFrame(false),
+  m_gpuTimersEnabled(false),
+  m_gpuTimersInitialized(false),
+  m_gpuTimersSupported(false)
+{
+  resetFrame(this->m_current);
+}
+
+
+vesProfiler::~vesProfiler()
+{
+  // GL objects can only be deleted with a current context, which the
+  // renderer does not guarantee at destruction, so the queries are left to
+  // the context like the other GL objects of VES.
+}
+
+
+void vesProfiler::setGPUTimersEnabled(bool enabled)
+{
+  this->m_gpuTimersEnabled = enabled;
+}
+
+
+void vesProfiler::beginFrame()
+{
+  resetFrame(this->m_current);
+  this->m_current.m_frameNumber = this->m_frameNumber++;
+  this->m_current.m_startTime = currentTime();
+  this->m_current.m_drawCalls = numberOfDrawCallsCounter;
+  this->m_current.m_triangles = numberOfTrianglesCounter;
+  this->m_current.m_bufferUploads = numberOfBufferUploadsCounter;
+  this->m_current.m_uploadedBytes = numberOfUploadedBytesCounter;
+  this->m_inFrame = true;
+
+  if (this->m_gpuTimersEnabled && !this->m_gpuTimersInitialized) {
+    this->initializeGPUTimers();
+  }
+  else if (!this->m_gpuTimersEnabled && this->m_gpuTimersInitialized) {
+    this->deleteGPUTimers();
+  }
+}
+
+
+void vesProfiler::endFrame()
+{
+  if (!this->m_inFrame) {
+    return;
+  }
+
+  // The counters only grow, the frame stores what this frame added.
+  this->m_current.m_duration = currentTime() - this->m_current.m_startTime;
+  this->m_current.m_drawCalls =
+    numberOfDrawCallsCounter - this->m_current.m_drawCalls;
+  this->m_current.m_triangles =
+    numberOfTrianglesCounter - this->m_current.m_triangles;
+  this->m_current.m_bufferUploads =
+    numberOfBufferUploadsCounter - this->m_current.m_bufferUploads;
+  this->m_current.m_uploadedBytes =
+    numberOfUploadedBytesCounter - this->m_current.m_uploadedBytes;
+  this->m_inFrame = false;
+
+  this->m_frames[this->m_next] = this->m_current;
+  this->m_next = (this->m_next + 1) % this->capacity();
+  if (this->m_count < this->capacity()) {
+    ++this->m_count;
+  }
+
+  if (this->m_gpuTimersSupported) {
+    this->collectGPUTimers();
+  }
+}
+
+
+void vesProfiler::beginPhase(Phase phase)
+{
+  if (!this->m_inFrame) {
+    return;
+  }
+
+  this->m_current.m_phaseStartTime[phase] = currentTime();
+
+#ifdef VES_HAS_TIMER_QUERY
+  if (phase == Render && this->m_gpuTimersSupported) {
+    // The slot of this frame is reused, so its query must be finished.
+    // Reading a finished query does not stall the pipeline.
+    int slot = this->m_next;
+    if (this->m_queryPending[slot]) {
+      GLint available = 0;
+      vesGetQueryObjectiv(this->m_queries[slot], VES_QUERY_RESULT_AVAILABLE,
+                          &available);
+      if (!available) {
+        return;
+      }
+      this->collectGPUTimers();
+    }
+
+    vesBeginQuery(VES_TIME_ELAPSED, this->m_queries[slot]);
+    this->m_queryFrameNumbers[slot] = this->m_current.m_frameNumber;
+    this->m_queryPending[slot] = true;
+  }
+#endif
+}
+
+
+void vesProfiler::endPhase(Phase phase)
+{
+  if (!this->m_inFrame) {
+    return;
+  }
+
+  this->m_current.m_phaseDuration[phase] =
+    currentTime() - this->m_current.m_phaseStartTime[phase];
+
+#ifdef VES_HAS_TIMER_QUERY
+  if (phase == Render && this->m_gpuTimersSupported
+      && this->m_queryPending[this->m_next]
+      && this->m_queryFrameNumbers[this->m_next]
+         == this->m_current.m_frameNumber) {
+    vesEndQuery(VES_TIME_ELAPSED);
+  }
+#endif
+}
+
+
+int vesProfiler::numberOfFrames() const
+{
+  return this->m_count;
+}
+
+
+const vesProfiler::Frame& vesProfiler::frame(int index) const
+{
+  assert(index >= 0 && index < this->m_count);
+  int capacity = this->capacity();
+  return this->m_frames[(this->m_next - this->m_count + index + capacity)
+                        % capacity];
+}
+
+
+const vesProfiler::Frame& vesProfiler::lastFrame() const
+{
+  return this->frame(this->m_count - 1);
+}
+
+
+double vesProfiler::averageFrameTime() const
+{
+  if (this->m_count == 0) {
+    return 0.0;
+  }
+
+  double total = 0.0;
+  for (int i = 0; i < this->m_count; ++i) {
+    total += this->frame(i).m_duration;
+  }
+  return total / this->m_count;
+}
+
+
+void vesProfiler::clear()
+{
+  this->m_next = 0;
+  this->m_count = 0;
+  for (size_t i = 0; i < this->m_queryPending.size(); ++i) {
+    // A pending result would land in a frame recorded after the clear.
+    this->m_queryFrameNumbers[i] = static_cast<unsigned long>(-1);
+  }
+}
+
+
+std::string vesProfiler::chromeTrace() const
+{
+  std::stringstream out;
+  out << std::fixed << std::setprecision(3);
+  out << "{\"traceEvents\": [";
+
+  const double origin = this->m_count ? this->frame(0).m_startTime : 0.0;
+
+  bool first = true;
+  out << "\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+      << "\"tid\": 0, \"args\": {\"name\": \"CPU\"}},"
+      << "\n  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 0, "
+      << "\"tid\": 1, \"args\": {\"name\": \"GPU\"}}";
+  first = false;
+
+  for (int i = 0; i < this->m_count; ++i) {
+    const Frame &frame = this->frame(i);
+
+    writeEvent(out, first, "frame", 0, frame.m_startTime - origin,
+               frame.m_duration);
+    for (int phase = 0; phase < NumberOfPhases; ++phase) {
+      // Phases are skipped when the renderer has no scene.
+      if (frame.m_phaseStartTime[phase] == 0.0) {
+        continue;
+      }
+
+      const char *name = phaseName(static_cast<Phase>(phase));
+      const double start = frame.m_phaseStartTime[phase] - origin;
+      writeEvent(out, first, name, 0, start, frame.m_phaseDuration[phase]);
+      if (frame.m_gpuDuration[phase] >= 0.0) {
+        writeEvent(out, first, name, 1, start, frame.m_gpuDuration[phase]);
+      }
+    }
+
+    out << ",\n  {\"name\": \"work\", \"ph\": \"C\", \"pid\": 0, \"ts\": "
+        << (frame.m_startTime - origin) * 1.0e6 << ", \"args\": {"
+        << "\"draw calls\": " << frame.m_drawCalls
+        << ", \"triangles\": " << frame.m_triangles
+        << ", \"buffer uploads\": " << frame.m_bufferUploads
+        << ", \"uploaded bytes\": " << frame.m_uploadedBytes << "}}";
+  }
+
+  out << "\n],\n\"displayTimeUnit\": \"ms\"}\n";
+  return out.str();
+}
+
+
+bool vesProfiler::writeChromeTrace(const std::string &fileName) const
+{
+  std::ofstream file(fileName.c_str());
+  if (!file) {
+    return false;
+  }
+
+  file << this->chromeTrace();
+  return file.good();
+}
+
+
+const char* vesProfiler::phaseName(Phase phase)
+{
+  switch (phase) {
+    case Update:
+      return "update";
+    case Cull:
+      return "cull";
+    case Render:
+      return "render";
+    default:
+      return "unknown";
+  }
+}
+
+
+double vesProfiler::currentTime()
+{
+#ifdef _WIN32
+  LARGE_INTEGER frequency;
+  LARGE_INTEGER counter;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&counter);
+  return static_cast<double>(counter.QuadPart)
+    / static_cast<double>(frequency.QuadPart);
+#elif defined(__APPLE__)
+  // clock_gettime() is missing before iOS 10.
+  mach_timebase_info_data_t timebase;
+  mach_timebase_info(&timebase);
+  return static_cast<double>(mach_absolute_time()) * timebase.numer
+    / timebase.denom * 1.0e-9;
+#else
+  // Unlike gettimeofday(), not affected by changes of the system time.
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec * 1.0e-9;
+#endif
+}
+
+
+void vesProfiler::countDrawCall(unsigned int mode, int count, int instances)
+{
+  ++numberOfDrawCallsCounter;
+
+  unsigned long triangles = 0;
+  if (mode == GL_TRIANGLES) {
+    triangles = count / 3;
+  }
+  else if ((mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+           && count > 2) {
+    triangles = count - 2;
+  }
+  numberOfTrianglesCounter += triangles * instances;
+}
+
+
+void vesProfiler::countBufferUpload(unsigned long bytes)
+{
+  ++numberOfBufferUploadsCounter;
+  numberOfUploadedBytesCounter += bytes;
+}
+
+
+unsigned long vesProfiler::numberOfDrawCalls()
+{
+  return numberOfDrawCallsCounter;
+}
+
+
+unsigned long vesProfiler::numberOfTriangles()
+{
+  return numberOfTrianglesCounter;
+}
+
+
+unsigned long vesProfiler::numberOfBufferUploads()
+{
+  return numberOfBufferUploadsCounter;
+}
+
+
+unsigned long vesProfiler::numberOfUploadedBytes()
+{
+  return numberOfUploadedBytesCounter;
+}
+
+
+void vesProfiler::initializeGPUTimers()
+{
+  this->m_gpuTimersInitialized = true;
+  this->m_gpuTimersSupported = false;
+
+#ifdef VES_HAS_TIMER_QUERY
+  const GLubyte *value = glGetString(GL_EXTENSIONS);
+  std::stringstream extensions(
+    value ? reinterpret_cast<const char*>(value) : "");
+  std::string extension;
+  bool hasExtension = false;
+  while (extensions >> extension) {
+    hasExtension = hasExtension || extension == VES_TIMER_QUERY_EXTENSION;
+  }
+
+  if (!hasExtension) {
+    return;
+  }
+
+  size_t capacity = this->m_frames.size();
+  this->m_queries.resize(capacity);
+  this->m_queryFrameNumbers.assign(capacity, static_cast<unsigned long>(-1));
+  this->m_queryPending.assign(capacity, false);
+  vesGenQueries(static_cast<GLsizei>(capacity), &this->m_queries[0]);
+
+  // Some drivers, llvmpipe among them, return a meaningless time for the
+  // first query of a context, so one is issued and its result dropped.
+  vesBeginQuery(VES_TIME_ELAPSED, this->m_queries[0]);
+  vesEndQuery(VES_TIME_ELAPSED);
+  this->m_queryPending[0] = true;
+
+#ifdef VES_HAS_DISJOINT_TIMER_QUERY
+  // Reading the disjoint state clears it.
+  GLint disjoint = 0;
+  glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+#endif
+
+  this->m_gpuTimersSupported = true;
+#endif
+}
+
+
+void vesProfiler::deleteGPUTimers()
+{
+#ifdef VES_HAS_TIMER_QUERY
+  if (!this->m_queries.empty()) {
+    vesDeleteQueries(static_cast<GLsizei>(this->m_queries.size()),
+                     &this->m_queries[0]);
+  }
+#endif
+
+  this->m_queries.clear();
+  this->m_queryFrameNumbers.clear();
+  this->m_queryPending.clear();
+  this->m_gpuTimersInitialized = false;
+  this->m_gpuTimersSupported = false;
+}
+
+
+void vesProfiler::collectGPUTimers()
+{
+#ifdef VES_HAS_TIMER_QUERY
+  bool disjoint = false;
+#ifdef VES_HAS_DISJOINT_TIMER_QUERY
+  // A disjoint event, like a frequency change, makes every pending result
+  // meaningless.
+  GLint disjointValue = 0;
+  glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjointValue);
+  disjoint = disjointValue != 0;
+#endif
+
+  for (size_t slot = 0; slot < this->m_queries.size(); ++slot) {
+    if (!this->m_queryPending[slot]) {
+      continue;
+    }
+
+    GLint available = 0;
+    vesGetQueryObjectiv(this->m_queries[slot], VES_QUERY_RESULT_AVAILABLE,
+                        &available);
+    if (!available) {
+      continue;
+    }
+
+    GLuint64 elapsed = 0;
+    vesGetQueryObjectui64v(this->m_queries[slot], VES_QUERY_RESULT, &elapsed);
+    this->m_queryPending[slot] = false;
+
+    // The slot holds the frame the query was issued for unless it was
+    // overwritten or cleared since.
+    Frame &frame = this->m_frames[slot];
+    if (!disjoint && slot < static_cast<size_t>(this->m_count)
+        && frame.m_frameNumber == this->m_queryFrameNumbers[slot]) {
+      frame.m_gpuDuration[Render] = elapsed * 1.0e-9;
+    }
+  }
+#endif
+}
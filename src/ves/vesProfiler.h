@@ -0,0 +1,189 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesProfiler
+/// \ingroup ves
+/// \brief Records where the time of the last rendered frames went
+///
+/// A renderer with a profiler times its update traversal, cull traversal and
+/// render stage on the CPU.  When GPU timers are enabled and the driver has
+/// GL_EXT_disjoint_timer_query, or ARB_timer_query on desktop GL, the render
+/// stage is also timed on the GPU.  Those results arrive a few frames late
+/// and are filled into the recorded frames as they become available.
+///
+/// Draw calls, triangles and buffer uploads are counted by the mappers for
+/// every frame, whether or not a profiler is set.
+///
+/// The last frames are kept in a ring buffer and can be written as a Chrome
+/// trace, which chrome://tracing and similar viewers load.
+///
+/// \see vesRenderer::setProfiler()
+
+#ifndef VESPROFILER_H
+#define VESPROFILER_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+#include <vector>
+
+class vesProfiler
+{
+public:
+  vesTypeMacro(vesProfiler);
+
+  enum Phase
+  {
+    Update = 0,
+    Cull,
+    Render,
+    NumberOfPhases
+  };
+
+  struct Frame
+  {
+    unsigned long m_frameNumber;
+
+    /// Times in seconds on the currentTime() clock.
+    double m_startTime;
+    double m_duration;
+    double m_phaseStartTime[NumberOfPhases];
+    double m_phaseDuration[NumberOfPhases];
+
+    /// GPU time of each phase in seconds, or a negative value if it was not
+    /// measured or is not available yet.
+    double m_gpuDuration[NumberOfPhases];
+
+    unsigned long m_drawCalls;
+    unsigned long m_triangles;
+    unsigned long m_bufferUploads;
+    unsigned long m_uploadedBytes;
+  };
+
+  /// Times a phase of the profiler's current frame for the lifetime of the
+  /// object.  Does nothing if the profiler is null.
+  class ScopedPhase
+  {
+  public:
+    ScopedPhase(vesProfiler *profiler, Phase phase) :
+      m_profiler(profiler),
+      m_phase(phase)
+    {
+      if (this->m_profiler) {
+        this->m_profiler->beginPhase(this->m_phase);
+      }
+    }
+
+    ~ScopedPhase()
+    {
+      if (this->m_profiler) {
+        this->m_profiler->endPhase(this->m_phase);
+      }
+    }
+
+  private:
+    ScopedPhase(const ScopedPhase&);
+    void operator=(const ScopedPhase&);
+
+    vesProfiler *m_profiler;
+    Phase m_phase;
+  };
+
+  /// Keep the last \p capacity frames.
+  vesProfiler(int capacity = 300);
+  ~vesProfiler();
+
+  /// Time the render phase on the GPU as well.  Takes effect at the next
+  /// frame, which must be rendered with a current GL context.  Off by
+  /// default.
+  void setGPUTimersEnabled(bool enabled);
+  bool gpuTimersEnabled() const { return this->m_gpuTimersEnabled; }
+
+  /// True once GPU timers were requested and the driver supports them.
+  bool hasGPUTimers() const { return this->m_gpuTimersSupported; }
+
+  /// Called by vesRenderer around a frame and its phases.
+  void beginFrame();
+  void endFrame();
+  void beginPhase(Phase phase);
+  void endPhase(Phase phase);
+
+  /// Number of recorded frames, at most capacity().
+  int numberOfFrames() const;
+  int capacity() const { return static_cast<int>(this->m_frames.size()); }
+
+  /// Recorded frame, from 0 for the oldest to numberOfFrames() - 1 for the
+  /// last one.
+  const Frame& frame(int index) const;
+  const Frame& lastFrame() const;
+
+  /// Average duration of the recorded frames in seconds.
+  double averageFrameTime() const;
+
+  /// Forget the recorded frames.
+  void clear();
+
+  /// Write the recorded frames in the Chrome trace event format.  GPU times
+  /// are shown on their own row, aligned with the start of the CPU phase.
+  std::string chromeTrace() const;
+  bool writeChromeTrace(const std::string &fileName) const;
+
+  static const char* phaseName(Phase phase);
+
+  /// Seconds on a monotonic clock.
+  static double currentTime();
+
+  /// Counters for the work submitted to GL on the calling thread, updated by
+  /// the mappers.
+  static void countDrawCall(unsigned int mode, int count, int instances = 1);
+  static void countBufferUpload(unsigned long bytes);
+  static unsigned long numberOfDrawCalls();
+  static unsigned long numberOfTriangles();
+  static unsigned long numberOfBufferUploads();
+  static unsigned long numberOfUploadedBytes();
+
+private:
+  vesProfiler(const vesProfiler&);
+  void operator=(const vesProfiler&);
+
+  void initializeGPUTimers();
+  void deleteGPUTimers();
+  void collectGPUTimers();
+
+  std::vector<Frame> m_frames;
+  int m_next;
+  int m_count;
+  unsigned long m_frameNumber;
+  bool m_inFrame;
+  Frame m_current;
+
+  bool m_gpuTimersEnabled;
+  bool m_gpuTimersInitialized;
+  bool m_gpuTimersSupported;
+
+  // One query per recorded frame for the render phase.  The frame number a
+  // query was issued for tells whether its slot still holds that frame.
+  std::vector<unsigned int> m_queries;
+  std::vector<unsigned long> m_queryFrameNumbers;
+  std::vector<bool> m_queryPending;
+};
+
+#endif // VESPROFILER_H
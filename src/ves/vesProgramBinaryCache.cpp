@@ -0,0 +1,241 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesProgramBinaryCache.h"
+
+// The program binary entry points of OpenGL ES are extension prototypes.
+#if !defined(VES_USE_DESKTOP_GL) && !defined(GL_GLEXT_PROTOTYPES)
+  #define GL_GLEXT_PROTOTYPES
+#endif
+
+// VES includes
+#include "vesGL.h"
+
+// C/C++ includes
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+#if defined(_WIN32)
+  #include <process.h>
+  #define vesGetProcessId _getpid
+#else
+  #include <unistd.h>
+  #define vesGetProcessId getpid
+#endif
+
+#if defined(VES_USE_DESKTOP_GL) && defined(GL_PROGRAM_BINARY_LENGTH)
+  #define VES_HAS_PROGRAM_BINARY
+  #define vesGetProgramBinary glGetProgramBinary
+  #define vesProgramBinary glProgramBinary
+  #define VES_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH
+  #define VES_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS
+  #define VES_PROGRAM_BINARY_EXTENSION "GL_ARB_get_program_binary"
+#elif !defined(VES_USE_DESKTOP_GL) && defined(GL_PROGRAM_BINARY_LENGTH_OES)
+  #define VES_HAS_PROGRAM_BINARY
+  #define vesGetProgramBinary glGetProgramBinaryOES
+  #define vesProgramBinary glProgramBinaryOES
+  #define VES_PROGRAM_BINARY_LENGTH GL_PROGRAM_BINARY_LENGTH_OES
+  #define VES_NUM_PROGRAM_BINARY_FORMATS GL_NUM_PROGRAM_BINARY_FORMATS_OES
+  #define VES_PROGRAM_BINARY_EXTENSION "GL_OES_get_program_binary"
+#endif
+
+namespace {
+
+const unsigned int programBinaryMagic = 0x56455350; // "VESP"
+
+std::string glString(GLenum name)
+{
+  const GLubyte *value = glGetString(name);
+  return value ? reinterpret_cast<const char*>(value) : std::string();
+}
+
+}
+
+vesProgramBinaryCache::vesProgramBinaryCache(const std::string &directory) :
+  m_directory(directory),
+  m_supported(false)
+{
+}
+
+
+vesProgramBinaryCache::~vesProgramBinaryCache()
+{
+}
+
+
+bool vesProgramBinaryCache::initialize()
+{
+  this->m_supported = false;
+
+#ifdef VES_HAS_PROGRAM_BINARY
+  std::stringstream extensions(glString(GL_EXTENSIONS));
+  std::string extension;
+  bool hasExtension = false;
+  while (extensions >> extension) {
+    hasExtension = hasExtension || extension == VES_PROGRAM_BINARY_EXTENSION;
+  }
+
+  GLint numberOfFormats = 0;
+  if (hasExtension) {
+    glGetIntegerv(VES_NUM_PROGRAM_BINARY_FORMATS, &numberOfFormats);
+  }
+
+  this->m_supported = numberOfFormats > 0;
+#endif
+
+  this->m_driver = glString(GL_VENDOR) + "\n" + glString(GL_RENDERER)
+    + "\n" + glString(GL_VERSION);
+
+  return this->m_supported;
+}
+
+
+std::string vesProgramBinaryCache::key(const std::string &programDescription) const
+{
+  // 64 bit FNV-1a, the key names a file and only needs to be well spread.
+  const std::string text = this->m_driver + "\n" + programDescription;
+  unsigned long long hash = 14695981039346656037ULL;
+  for (size_t i = 0; i < text.size(); ++i) {
+    hash ^= static_cast<unsigned char>(text[i]);
+    hash *= 1099511628211ULL;
+  }
+
+  char key[17];
+  sprintf(key, "%08x%08x", static_cast<unsigned int>(hash >> 32),
+          static_cast<unsigned int>(hash & 0xffffffff));
+  return key;
+}
+
+
+std::string vesProgramBinaryCache::fileName(const std::string &key) const
+{
+  return this->m_directory + "/" + key + ".vesprogram";
+}
+
+
+void vesProgramBinaryCache::prepareProgram(unsigned int programHandle)
+{
+#if defined(VES_HAS_PROGRAM_BINARY) && defined(VES_USE_DESKTOP_GL)
+  if (this->m_supported) {
+    glProgramParameteri(programHandle, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+  }
+#else
+  vesNotUsed(programHandle);
+#endif
+}
+
+
+bool vesProgramBinaryCache::loadProgram(unsigned int programHandle,
+                                        const std::string &key)
+{
+#ifdef VES_HAS_PROGRAM_BINARY
+  if (!this->m_supported) {
+    return false;
+  }
+
+  std::ifstream file(this->fileName(key).c_str(), std::ios::in | std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  unsigned int header[3] = {0, 0, 0};
+  file.read(reinterpret_cast<char*>(header), sizeof(header));
+  std::vector<char> binary;
+  if (file && header[0] == programBinaryMagic && header[2] > 0) {
+    binary.resize(header[2]);
+    file.read(&binary[0], binary.size());
+  }
+  const bool readSucceeded = file && !binary.empty();
+  file.close();
+
+  GLint status = 0;
+  if (readSucceeded) {
+    vesProgramBinary(programHandle, header[1], &binary[0], binary.size());
+    glGetProgramiv(programHandle, GL_LINK_STATUS, &status);
+  }
+
+  if (!status) {
+    // Stale or corrupt, the program is compiled from source and stored again.
+    std::remove(this->fileName(key).c_str());
+    return false;
+  }
+
+  return true;
+#else
+  vesNotUsed(programHandle);
+  vesNotUsed(key);
+  return false;
+#endif
+}
+
+
+bool vesProgramBinaryCache::storeProgram(unsigned int programHandle,
+                                         const std::string &key)
+{
+#ifdef VES_HAS_PROGRAM_BINARY
+  if (!this->m_supported) {
+    return false;
+  }
+
+  GLint length = 0;
+  glGetProgramiv(programHandle, VES_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) {
+    return false;
+  }
+
+  std::vector<char> binary(length);
+  GLenum format = 0;
+  GLsizei writtenLength = 0;
+  vesGetProgramBinary(programHandle, length, &writtenLength, &format, &binary[0]);
+  if (writtenLength <= 0) {
+    return false;
+  }
+
+  // Write to a temporary file first so a crash never leaves half a binary.
+  // Other processes, and threads with their own cache, may store the same
+  // program meanwhile, so the name is unique to this process and cache.
+  const std::string fileName = this->fileName(key);
+  std::ostringstream temporaryName;
+  temporaryName << fileName << "." << vesGetProcessId() << "." << this << ".tmp";
+  const std::string temporaryFileName = temporaryName.str();
+  std::ofstream file(temporaryFileName.c_str(), std::ios::out | std::ios::binary);
+  const unsigned int header[3] = {programBinaryMagic, format,
+                                  static_cast<unsigned int>(writtenLength)};
+  file.write(reinterpret_cast<const char*>(header), sizeof(header));
+  file.write(&binary[0], writtenLength);
+  file.close();
+
+  std::remove(fileName.c_str());
+  if (!file || std::rename(temporaryFileName.c_str(), fileName.c_str()) != 0) {
+    std::remove(temporaryFileName.c_str());
+    std::cerr << "Failed to store program binary: " << fileName << std::endl;
+    return false;
+  }
+
+  return true;
+#else
+  vesNotUsed(programHandle);
+  vesNotUsed(key);
+  return false;
+#endif
+}
@@ -0,0 +1,84 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesProgramBinaryCache
+/// \ingroup ves
+/// \brief Stores linked shader programs on disk to skip compiling them
+///
+/// Linked programs are saved with GL_OES_get_program_binary, or
+/// ARB_get_program_binary on desktop GL, in one file per program.  The file
+/// name is a hash of the program sources together with the GL vendor,
+/// renderer and version strings, so a driver update never loads a stale
+/// binary.  A binary the driver rejects is deleted and the program is
+/// compiled from source again.
+///
+/// \see vesShaderProgram::setProgramBinaryCache()
+
+#ifndef VESPROGRAMBINARYCACHE_H
+#define VESPROGRAMBINARYCACHE_H
+
+// VES includes
+#include "vesSetGet.h"
+
+// C/C++ includes
+#include <string>
+
+class vesProgramBinaryCache
+{
+public:
+  vesTypeMacro(vesProgramBinaryCache);
+
+  /// The directory must exist and be writable.
+  vesProgramBinaryCache(const std::string &directory);
+  ~vesProgramBinaryCache();
+
+  /// Query the driver.  Must be called with a current GL context before the
+  /// cache is used.  Returns false if program binaries are not supported.
+  bool initialize();
+
+  bool isSupported() const { return this->m_supported; }
+
+  const std::string& directory() const { return this->m_directory; }
+
+  /// Returns the key for a program described by the given text, which must
+  /// contain everything that affects linking.
+  std::string key(const std::string &programDescription) const;
+
+  /// Load the stored binary for the key into the program.  Returns false,
+  /// leaving the program unlinked, if there is no usable binary.
+  bool loadProgram(unsigned int programHandle, const std::string &key);
+
+  /// Store the binary of a linked program under the key.
+  bool storeProgram(unsigned int programHandle, const std::string &key);
+
+  /// Must be called before linking a program that will be stored.
+  void prepareProgram(unsigned int programHandle);
+
+private:
+  vesProgramBinaryCache(const vesProgramBinaryCache&);
+  void operator=(const vesProgramBinaryCache&);
+
+  std::string fileName(const std::string &key) const;
+
+  std::string m_directory;
+  std::string m_driver;
+  bool m_supported;
+};
+
+#endif // VESPROGRAMBINARYCACHE_H
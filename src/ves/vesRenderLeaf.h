@@ -39,9 +39,11 @@ public:
     int depth, const vesMatrix4x4f &modelViewMatrix,
     const vesMatrix4x4f &projectionMatrix,
     const vesSharedPtr<vesMaterial> &material,
-    const vesSharedPtr<vesMapper> &mapper)
+    const vesSharedPtr<vesMapper> &mapper,
+    int levelOfDetail = 0)
   {
     this->m_depth = depth;
+    this->m_levelOfDetail = levelOfDetail;
     this->m_modelViewMatrix = modelViewMatrix;
     this->m_projectionMatrix = projectionMatrix;
 
@@ -76,6 +78,7 @@ public:
 
     if (this->m_mapper) {
       renderState.applyMapper(this->m_mapper);
+      renderState.m_levelOfDetail = this->m_levelOfDetail;
 
       this->m_material->render(renderState);
       this->m_mapper->render  (renderState);
@@ -94,6 +97,7 @@ public:
 
   int m_depth;
   int m_bin;
+  int m_levelOfDetail;
 
   vesMatrix4x4f m_projectionMatrix;
   vesMatrix4x4f m_modelViewMatrix;
@@ -26,6 +26,7 @@
 
 // VES includes.
 #include "vesGL.h"
+#include "vesGLStateCache.h"
 #include "vesMapper.h"
 #include "vesMaterial.h"
 #include "vesMath.h"
@@ -90,13 +91,13 @@ public:
       this->m_viewport->render(renderState);
 
       if (this->m_clearMask & GL_COLOR_BUFFER_BIT) {
-        glClearColor(this->m_clearColor[0], this->m_clearColor[1],
-          this->m_clearColor[2], this->m_clearColor[2]);
+        vesGLStateCache::current()->clearColor(this->m_clearColor[0],
+          this->m_clearColor[1], this->m_clearColor[2], this->m_clearColor[2]);
       }
 
       if (this->m_clearMask & GL_DEPTH_BUFFER_BIT) {
         glClearDepthf(this->m_clearDepth);
-        glDepthMask( GL_TRUE );
+        vesGLStateCache::current()->depthMask(GL_TRUE);
       }
 
       glClear(this->m_clearMask);
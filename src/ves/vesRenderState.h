@@ -44,6 +44,7 @@ public:
     this->m_modelViewMatrix   = this->m_identity;
     this->m_projectionMatrix  = this->m_identity;
     this->m_viewSize = vesVector2f(0.0, 0.0);
+    this->m_levelOfDetail = 0;
   }
 
 
@@ -98,6 +99,7 @@ public:
   vesSharedPtr<vesMapper> m_mapper;
 
   vesVector2f m_viewSize;
+  int m_levelOfDetail;
   vesMatrix4x4f *m_identity;
   vesMatrix4x4f *m_projectionMatrix;
   vesMatrix4x4f *m_modelViewMatrix;
@@ -23,10 +23,14 @@
 #include "vesBackground.h"
 #include "vesCamera.h"
 #include "vesCullVisitor.h"
+#include "vesGLStateCache.h"
 #include "vesGroupNode.h"
+#include "vesOffscreenRenderTarget.h"
+#include "vesProfiler.h"
 #include "vesRenderer.h"
 #include "vesRenderStage.h"
 #include "vesShaderProgram.h"
+#include "vesUniform.h"
 #include "vesVisitor.h"
 
 // C/C++ includes
@@ -37,6 +41,10 @@
 vesRenderer::vesRenderer():
   m_width(100),
   m_height(100),
+  m_uniformCallCount(0),
+  m_stateCallCount(0),
+  m_skippedStateCallCount(0),
+  m_levelOfDetailBias(0),
   m_camera(new vesCamera()),
   m_sceneRoot(new vesGroupNode()),
   m_renderStage(new vesRenderStage()),
@@ -57,34 +65,99 @@ vesRenderer::~vesRenderer()
 
 void vesRenderer::render()
 {
+  vesProfiler *profiler = this->m_profiler.get();
+  if (profiler) {
+    profiler->beginFrame();
+  }
+
+  const unsigned long uniformCallsBefore = vesUniform::numberOfGLCalls();
+
+  // State may have been changed outside of VES since the last frame.
+  vesGLStateCache *state = vesGLStateCache::current();
+  state->invalidate();
+  const unsigned long issuedCallsBefore = state->numberOfIssuedCalls();
+  const unsigned long skippedCallsBefore = state->numberOfSkippedCalls();
+
   // By default enable depth test.
-  glEnable(GL_DEPTH_TEST);
+  state->enable(GL_DEPTH_TEST);
+
+  // An offscreen target is rendered at its own size, so the viewport is
+  // changed before the cull traversal computes the projection.  A target
+  // rendering a tile draws the part of the background the tile covers.
+  vesOffscreenRenderTarget *offscreenTarget = this->m_offscreenTarget.get();
+  if (offscreenTarget) {
+    this->m_camera->viewport()->setViewport(
+      0, 0, offscreenTarget->width(), offscreenTarget->height());
+    this->updateBackgroundViewport();
+
+    const float imageWidth = static_cast<float>(offscreenTarget->imageWidth());
+    const float imageHeight = static_cast<float>(offscreenTarget->imageHeight());
+    this->m_background->setRegion(
+      offscreenTarget->imageX() / imageWidth,
+      offscreenTarget->imageY() / imageHeight,
+      (offscreenTarget->imageX() + offscreenTarget->width()) / imageWidth,
+      (offscreenTarget->imageY() + offscreenTarget->height()) / imageHeight);
+  }
 
   if (this->m_sceneRoot) {
 
     // Update traversal.
-    this->updateTraverseScene();
+    {
+      vesProfiler::ScopedPhase phase(profiler, vesProfiler::Update);
+      this->updateTraverseScene();
+    }
 
     // Cull traversal.
-    this->cullTraverseScene();
+    {
+      vesProfiler::ScopedPhase phase(profiler, vesProfiler::Cull);
+      this->cullTraverseScene();
+    }
+
+    vesProfiler::ScopedPhase phase(profiler, vesProfiler::Render);
 
     vesRenderState renderState;
-    renderState.m_viewSize = vesVector2f(this->m_width, this->m_height);
+    renderState.m_viewSize = offscreenTarget
+      ? vesVector2f(offscreenTarget->width(), offscreenTarget->height())
+      : vesVector2f(this->m_width, this->m_height);
 
     // Clear all the previous render targets.
     this->m_camera->clearRenderTargets(renderState);
 
     // For now, lets not push camera to the stage, just call
     // render on render target of the current camera.
-    this->m_camera->renderTarget()->render(renderState);
+    if (offscreenTarget) {
+      offscreenTarget->render(renderState);
+    }
+    else {
+      this->m_camera->renderTarget()->render(renderState);
+    }
 
     this->m_renderStage->render(renderState, 0);
 
+    if (offscreenTarget) {
+      offscreenTarget->readPixels();
+      offscreenTarget->remove(renderState);
+    }
+
     // \note: For now clear the stage.
     // \todo: Add an optimization where we could save whole or
     // part of the the stage.
     this->m_renderStage->clearAll();
   }
+
+  this->m_uniformCallCount = vesUniform::numberOfGLCalls() - uniformCallsBefore;
+  this->m_stateCallCount = state->numberOfIssuedCalls() - issuedCallsBefore;
+  this->m_skippedStateCallCount = state->numberOfSkippedCalls() - skippedCallsBefore;
+
+  if (offscreenTarget) {
+    this->m_camera->viewport()->setViewport(0, 0, this->m_width, this->m_height);
+    this->updateBackgroundViewport();
+    this->m_background->setRegion(0.0f, 0.0f, 1.0f, 1.0f);
+  }
+
+  if (profiler) {
+    profiler->endFrame();
+  }
 }
 
 
@@ -406,8 +479,18 @@ void vesRenderer::cullTraverseScene()
 {
   vesCullVisitor cullVisitor;
 
-  vesMatrix4x4f projection2DMatrix = vesOrtho(0, this->width(), 0, this->height(), -1, 1);
+  // 2D overlays are laid out in the pixels of the image being rendered, of
+  // which an offscreen target may render a tile.
+  const vesOffscreenRenderTarget *offscreenTarget = this->m_offscreenTarget.get();
+  const int x = offscreenTarget ? offscreenTarget->imageX() : 0;
+  const int y = offscreenTarget ? offscreenTarget->imageY() : 0;
+  const int width = offscreenTarget ? offscreenTarget->width() : this->width();
+  const int height = offscreenTarget ? offscreenTarget->height() : this->height();
+
+  vesMatrix4x4f projection2DMatrix = vesOrtho(x, x + width, y, y + height, -1, 1);
   cullVisitor.setProjection2DMatrix(projection2DMatrix);
+  cullVisitor.setViewportHeight(static_cast<float>(height));
+  cullVisitor.setLevelOfDetailBias(this->m_levelOfDetailBias);
 
   cullVisitor.setRenderStage(this->m_renderStage);
 
@@ -46,6 +46,8 @@ class vesActor;
 class vesBackground;
 class vesCamera;
 class vesGroupNode;
+class vesOffscreenRenderTarget;
+class vesProfiler;
 class vesRenderStage;
 class vesTexture;
 
@@ -106,6 +108,39 @@ public:
   /// Get height of the window last set
   inline int height()  { return this->m_height; }
 
+  /// Number of glUniform calls made during the last render.  Uniforms are
+  /// only sent when their value changed, so a static scene sends few.
+  unsigned long uniformCallCount() const { return this->m_uniformCallCount; }
+
+  /// Number of GL state changes made and skipped as redundant during the
+  /// last render.
+  /// \see vesGLStateCache
+  unsigned long stateCallCount() const { return this->m_stateCallCount; }
+  unsigned long skippedStateCallCount() const { return this->m_skippedStateCallCount; }
+
+  /// Draw every mapper this many levels of detail coarser than its screen
+  /// size calls for.  Interactive applications raise it while the camera
+  /// moves and reset it to 0 when it stops.
+  /// \see vesMapper::addLevelOfDetail
+  void setLevelOfDetailBias(int bias) { this->m_levelOfDetailBias = bias; }
+  int levelOfDetailBias() const { return this->m_levelOfDetailBias; }
+
+  /// Set/Get the profiler that records the timings of every render, null by
+  /// default.
+  /// \see vesProfiler
+  void setProfiler(vesSharedPtr<vesProfiler> profiler) { this->m_profiler = profiler; }
+  vesSharedPtr<vesProfiler> profiler() const { return this->m_profiler; }
+
+  /// Set/Get the target rendered into instead of the window, null by
+  /// default.  The scene is rendered at the size of the target, whatever the
+  /// size of the window, and every frame is read back into the target's
+  /// image.  The background and 2D items follow the target's image region.
+  /// \see vesOffscreenRenderTarget
+  void setOffscreenTarget(vesSharedPtr<vesOffscreenRenderTarget> target)
+    { this->m_offscreenTarget = target; }
+  vesSharedPtr<vesOffscreenRenderTarget> offscreenTarget() const
+    { return this->m_offscreenTarget; }
+
   /// Transform a vector in world space to display space
   vesVector3f computeWorldToDisplay(const vesVector3f &world);
 
@@ -125,12 +160,18 @@ private:
   double m_aspect[2];
   int m_width;
   int m_height;
+  unsigned long m_uniformCallCount;
+  unsigned long m_stateCallCount;
+  unsigned long m_skippedStateCallCount;
+  int m_levelOfDetailBias;
 
   vesSharedPtr<vesCamera> m_camera;
   vesSharedPtr<vesGroupNode> m_sceneRoot;
 
   vesSharedPtr<vesRenderStage> m_renderStage;
   vesSharedPtr<vesBackground> m_background;
+  vesSharedPtr<vesProfiler> m_profiler;
+  vesSharedPtr<vesOffscreenRenderTarget> m_offscreenTarget;
 };
 
 #endif
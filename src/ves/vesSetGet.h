@@ -30,6 +30,15 @@
   #define vesNotUsed(x)
 #endif
 
+// Gives every thread its own copy of a global of plain old data, for the
+// counters and current objects that must not be shared between threads
+// rendering with different contexts.
+#ifdef _MSC_VER
+  #define vesThreadLocal __declspec(thread)
+#else
+  #define vesThreadLocal __thread
+#endif
+
 #define vesTypeMacro(className) \
   typedef vesSharedPtr< className > Ptr; \
   typedef const vesSharedPtr< className > ConstPtr;
@@ -24,6 +24,8 @@
 // VES includes
 #include "vesBooleanUniform.h"
 #include "vesEngineUniform.h"
+#include "vesGLStateCache.h"
+#include "vesProgramBinaryCache.h"
 #include "vesShader.h"
 #include "vesUniform.h"
 #include "vesVertexAttribute.h"
@@ -32,6 +34,14 @@
 #include <map>
 #include <vector>
 #include <iostream>
+#include <sstream>
+
+namespace {
+
+// Threads that render with their own context set their own cache.
+vesThreadLocal vesProgramBinaryCache* currentProgramBinaryCache = 0;
+
+}
 
 class vesShaderProgram::vesInternal
 {
@@ -53,6 +63,47 @@ public:
       this->m_engineUniforms.clear();
     }
 
+  // Uniform resolved to its location when the program is linked.  The
+  // modified count of the value last sent is kept per program because GL
+  // stores uniform values per program object.
+  struct UniformSlot
+  {
+    UniformSlot(vesUniform *uniform, int location) :
+      m_uniform(uniform), m_location(location), m_sentModifiedCount(0)
+    {
+    }
+
+    vesUniform *m_uniform;
+    int m_location;
+    unsigned long m_sentModifiedCount;
+  };
+
+  void updateSlot(UniformSlot &slot)
+  {
+    if (slot.m_location >= 0
+        && slot.m_sentModifiedCount != slot.m_uniform->modifiedCount()) {
+      slot.m_uniform->callGL(slot.m_location);
+      slot.m_sentModifiedCount = slot.m_uniform->modifiedCount();
+    }
+  }
+
+  // Everything that affects the linked program, to key its binary.
+  std::string programDescription() const
+  {
+    std::stringstream description;
+    for (size_t i = 0; i < this->m_shaders.size(); ++i) {
+      description << this->m_shaders[i]->shaderType() << "\n"
+                  << this->m_shaders[i]->shaderSource() << "\n";
+    }
+
+    std::map<int, vesSharedPtr<vesVertexAttribute> >::const_iterator itr =
+      this->m_vertexAttributes.begin();
+    for (; itr != this->m_vertexAttributes.end(); ++itr) {
+      description << itr->second->name() << "=" << itr->first << "\n";
+    }
+    return description.str();
+  }
+
   typedef std::map<std::string, int>          UniformNameToLocation;
   typedef std::map<std::string, int>          VertexAttributeNameToLocation;
   typedef std::map<std::string, unsigned int> AttributeBindingMap;
@@ -65,6 +116,7 @@ public:
   std::map<int, bool> m_enabledVertexAttributes;
 
   UniformNameToLocation m_uniformNameToLocation;
+  std::vector<UniformSlot> m_uniformSlots;
   VertexAttributeNameToLocation m_vertexAttributeNameToLocation;
 
   std::vector< vesSharedPtr<vesEngineUniform> > m_engineUniforms;
@@ -247,7 +299,7 @@ int vesShaderProgram::attributeLocation(const std::string &name) const
 
 void vesShaderProgram::use()
 {
-  glUseProgram(this->m_internal->m_programHandle);
+  vesGLStateCache::current()->useProgram(this->m_internal->m_programHandle);
 }
 
 
@@ -266,7 +318,7 @@ int vesShaderProgram::queryAttributeLocation(const std::string &value)
 void vesShaderProgram::deleteProgram()
 {
   if (this->m_internal->m_programHandle) {
-    glDeleteProgram(this->m_internal->m_programHandle);
+    vesGLStateCache::current()->deleteProgram(this->m_internal->m_programHandle);
     this->m_internal->m_programHandle = 0;
   }
 }
@@ -335,9 +387,13 @@ void vesShaderProgram::bindUniforms()
   std::vector< vesSharedPtr<vesUniform> >::const_iterator constItr =
     this->m_internal->m_uniforms.begin();
 
+  this->m_internal->m_uniformSlots.clear();
+
   for (;constItr != this->m_internal->m_uniforms.end(); ++constItr) {
-    this->m_internal->m_uniformNameToLocation[(*constItr)->name()] =
-      queryUniformLocation((*constItr)->name());
+    int location = queryUniformLocation((*constItr)->name());
+    this->m_internal->m_uniformNameToLocation[(*constItr)->name()] = location;
+    this->m_internal->m_uniformSlots.push_back(
+      vesInternal::UniformSlot(constItr->get(), location));
   }
 }
 
@@ -411,15 +467,41 @@ bool vesShaderProgram::uniformExist(const std::string &name)
 
 void vesShaderProgram::updateUniforms()
 {
-  std::vector< vesSharedPtr<vesUniform> >::const_iterator constItr =
-    this->m_internal->m_uniforms.begin();
+  std::vector<vesInternal::UniformSlot>::iterator itr =
+    this->m_internal->m_uniformSlots.begin();
 
-  for (; constItr != this->m_internal->m_uniforms.end(); ++constItr) {
-    (*constItr)->callGL(this->m_internal->m_uniformNameToLocation[(*constItr)->name()]);
+  for (; itr != this->m_internal->m_uniformSlots.end(); ++itr) {
+    this->m_internal->updateSlot(*itr);
+  }
+}
+
+
+void vesShaderProgram::updateUniform(const vesUniform *uniform)
+{
+  std::vector<vesInternal::UniformSlot>::iterator itr =
+    this->m_internal->m_uniformSlots.begin();
+
+  for (; itr != this->m_internal->m_uniformSlots.end(); ++itr) {
+    if (itr->m_uniform == uniform) {
+      this->m_internal->updateSlot(*itr);
+      return;
+    }
   }
 }
 
 
+void vesShaderProgram::setProgramBinaryCache(vesProgramBinaryCache *cache)
+{
+  currentProgramBinaryCache = cache;
+}
+
+
+vesProgramBinaryCache* vesShaderProgram::programBinaryCache()
+{
+  return currentProgramBinaryCache;
+}
+
+
 void vesShaderProgram::setup(const vesRenderState &renderState)
 {
   vesNotUsed(renderState);
@@ -438,23 +520,43 @@ void vesShaderProgram::bind(const vesRenderState &renderState)
       return;
     }
 
-    // Compile shaders.
-    std::vector< vesSharedPtr<vesShader> >::iterator itr
-      = this->m_internal->m_shaders.begin();
-    for (; itr != this->m_internal->m_shaders.end(); ++itr) {
-      //std::cerr << "INFO: Compiling shaders: " << std::endl;
-
-      (*itr)->compileShader();
-
-      (*itr)->attachShader(this->m_internal->m_programHandle);
+    vesProgramBinaryCache *binaryCache = currentProgramBinaryCache;
+    std::string binaryKey;
+    bool loadedBinary = false;
+    if (binaryCache && binaryCache->isSupported()) {
+      binaryKey = binaryCache->key(this->m_internal->programDescription());
+      loadedBinary = binaryCache->loadProgram(
+        this->m_internal->m_programHandle, binaryKey);
     }
 
+    // A loaded binary was linked with these attribute locations already,
+    // binding them again only fills in the name to location map.
     this->bindAttributes();
 
-    // link program
-    if (!this->link()) {
-      std::cerr << "ERROR: Failed to link Program" << std::endl;
-      this->cleanUp();
+    if (!loadedBinary) {
+      // Compile shaders.
+      std::vector< vesSharedPtr<vesShader> >::iterator itr
+        = this->m_internal->m_shaders.begin();
+      for (; itr != this->m_internal->m_shaders.end(); ++itr) {
+        //std::cerr << "INFO: Compiling shaders: " << std::endl;
+
+        (*itr)->compileShader();
+
+        (*itr)->attachShader(this->m_internal->m_programHandle);
+      }
+
+      if (!binaryKey.empty()) {
+        binaryCache->prepareProgram(this->m_internal->m_programHandle);
+      }
+
+      // link program
+      if (!this->link()) {
+        std::cerr << "ERROR: Failed to link Program" << std::endl;
+        this->cleanUp();
+      }
+      else if (!binaryKey.empty()) {
+        binaryCache->storeProgram(this->m_internal->m_programHandle, binaryKey);
+      }
     }
 
     this->use();
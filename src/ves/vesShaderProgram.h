@@ -35,6 +35,7 @@
 #include <string>
 
 // Forward declarations
+class vesProgramBinaryCache;
 class vesShader;
 class vesRenderState;
 class vesUniform;
@@ -65,10 +66,23 @@ public:
 
   bool uniformExist(const std::string &name);
 
+  /// Send the uniforms whose value changed since they were last sent to
+  /// this program.
   virtual void updateUniforms();
 
+  /// Send a single uniform of this program if its value changed.
+  void updateUniform(const vesUniform *uniform);
+
   bool link();
 
+  /// Set the cache that programs bound on the calling thread store linked
+  /// binaries in.  Programs found in the cache are loaded instead of
+  /// compiled when first bound.  The cache must be initialized with the
+  /// context of the thread current and is not owned, pass 0 before it is
+  /// destroyed.
+  static void setProgramBinaryCache(vesProgramBinaryCache *cache);
+  static vesProgramBinaryCache* programBinaryCache();
+
   bool validate();
   void use();
 
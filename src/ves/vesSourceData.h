@@ -110,6 +110,12 @@ struct vesVertexDataP3T3C3f
   vesVector3f m_color;
 };
 
+struct vesVertexDataP3C4ub
+{
+  vesVector3f m_position;
+  unsigned char m_color[4];
+};
+
 struct vesVertexDataf
 {
   float m_scalar;
@@ -662,4 +668,31 @@ public:
   }
 };
 
+/// Positions interleaved with normalized byte colors, 16 bytes per vertex.
+/// Used for large point clouds, where float colors would double the size of
+/// the vertex buffer.
+class vesSourceDataP3C4ub : public vesGenericSourceData<vesVertexDataP3C4ub>
+{
+public:
+  vesTypeMacro(vesSourceDataP3C4ub);
+
+  vesSourceDataP3C4ub() : vesGenericSourceData<vesVertexDataP3C4ub>()
+  {
+    const int stride = sizeof(vesVertexDataP3C4ub);
+
+    this->setAttributeDataType(vesVertexAttributeKeys::Position, vesDataType::Float);
+    this->setAttributeDataType(vesVertexAttributeKeys::Color, vesDataType::UnsignedByte);
+    this->setAttributeOffset(vesVertexAttributeKeys::Position, 0);
+    this->setAttributeOffset(vesVertexAttributeKeys::Color, 12);
+    this->setAttributeStride(vesVertexAttributeKeys::Position, stride);
+    this->setAttributeStride(vesVertexAttributeKeys::Color, stride);
+    this->setNumberOfComponents(vesVertexAttributeKeys::Position, 3);
+    this->setNumberOfComponents(vesVertexAttributeKeys::Color, 4);
+    this->setSizeOfAttributeDataType(vesVertexAttributeKeys::Position, sizeof(float));
+    this->setSizeOfAttributeDataType(vesVertexAttributeKeys::Color, sizeof(unsigned char));
+    this->setIsAttributeNormalized(vesVertexAttributeKeys::Position, false);
+    this->setIsAttributeNormalized(vesVertexAttributeKeys::Color, true);
+  }
+};
+
 #endif // VESSOURCEDATA_H
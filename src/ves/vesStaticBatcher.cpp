@@ -0,0 +1,121 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+
+#include "vesStaticBatcher.h"
+
+// VES includes
+#include "vesActor.h"
+#include "vesBatchedMapper.h"
+#include "vesDepth.h"
+#include "vesMaterial.h"
+
+namespace {
+
+bool isAttributeEnabled(vesMaterial::Ptr material,
+                        vesMaterialAttribute::AttributeType type)
+{
+  vesMaterialAttribute::Ptr attribute = material->attribute(type);
+  return attribute && attribute->isEnabled();
+}
+
+bool isDepthWriteEnabled(vesMaterial::Ptr material)
+{
+  vesDepth::Ptr depth = std::tr1::dynamic_pointer_cast<vesDepth>(
+    material->attribute(vesMaterialAttribute::Depth));
+  return !depth || !depth->isEnabled() || depth->writeMask();
+}
+
+struct vesStaticBatch
+{
+  vesMaterial::Ptr m_material;
+  vesBatchedMapper::Ptr m_mapper;
+};
+
+}
+
+std::vector<vesActor::Ptr> vesStaticBatcher::merge(
+  const std::vector<vesActor::Ptr> &actors)
+{
+  std::vector<vesStaticBatch> batches;
+  std::vector<vesActor::Ptr> unbatched;
+
+  for (size_t i = 0; i < actors.size(); ++i) {
+    const vesActor::Ptr &actor = actors[i];
+
+    // Translucent parts would need sorting, overlays are drawn differently.
+    if (!actor->material() || actor->isOverlayNode()
+        || actor->material()->attribute(vesMaterialAttribute::Texture)
+        || !vesBatchedMapper::isBatchable(actor)
+        || actor->mapper()->color()[3] < 1.0f) {
+      unbatched.push_back(actor);
+      continue;
+    }
+
+    bool merged = false;
+    for (size_t j = 0; j < batches.size() && !merged; ++j) {
+      merged = isEquivalent(batches[j].m_material, actor->material())
+        && batches[j].m_mapper->addPart(actor);
+    }
+
+    if (!merged) {
+      vesStaticBatch batch;
+      batch.m_material = actor->material();
+      batch.m_mapper = vesBatchedMapper::Ptr(new vesBatchedMapper());
+      if (!batch.m_mapper->addPart(actor)) {
+        unbatched.push_back(actor);
+        continue;
+      }
+      batches.push_back(batch);
+    }
+  }
+
+  std::vector<vesActor::Ptr> result;
+  for (size_t i = 0; i < batches.size(); ++i) {
+    if (batches[i].m_mapper->numberOfParts() == 1) {
+      unbatched.push_back(batches[i].m_mapper->part(0));
+      continue;
+    }
+
+    vesActor::Ptr actor(new vesActor());
+    actor->setMapper(batches[i].m_mapper);
+    actor->setMaterial(batches[i].m_material);
+    result.push_back(actor);
+  }
+
+  result.insert(result.end(), unbatched.begin(), unbatched.end());
+  return result;
+}
+
+bool vesStaticBatcher::isEquivalent(vesMaterial::Ptr first,
+                                    vesMaterial::Ptr second)
+{
+  if (first == second) {
+    return true;
+  }
+
+  return first && second
+    && first->shaderProgram() == second->shaderProgram()
+    && first->binNumber() == second->binNumber()
+    && !first->attribute(vesMaterialAttribute::Texture)
+    && !second->attribute(vesMaterialAttribute::Texture)
+    && isAttributeEnabled(first, vesMaterialAttribute::Blend)
+       == isAttributeEnabled(second, vesMaterialAttribute::Blend)
+    && isDepthWriteEnabled(first) == isDepthWriteEnabled(second);
+}
@@ -0,0 +1,67 @@
+/*========================================================================
+  VES --- VTK OpenGL ES Rendering Toolkit
+
+      http://www.kitware.com/ves
+
+  Copyright 2011 Kitware, Inc.
+
+  Licensed under the Apache License, Version 2.0 (the "License");
+  you may not use this file except in compliance with the License.
+  You may obtain a copy of the License at
+
+      http://www.apache.org/licenses/LICENSE-2.0
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+ ========================================================================*/
+/// \class vesStaticBatcher
+/// \ingroup ves
+/// \brief Merges static actors that share a material into a few batches.
+///
+/// Scenes made of hundreds of small actors spend most of the frame binding
+/// buffers and issuing draw calls.  merge() groups actors whose materials
+/// render the same way, i.e. the same shader program, bin number, blending
+/// and depth writes and no texture, and whose geometries share a vertex
+/// layout, and replaces every group by one actor with a vesBatchedMapper.
+///
+/// Batching is opt-in: the caller adds the returned actors to the renderer
+/// instead of the original ones.  The geometry is copied, so the original
+/// actors must not move or change geometry afterwards, but toggling their
+/// visibility still shows or hides their part of the batch.
+///
+/// \see vesBatchedMapper
+
+#ifndef VESSTATICBATCHER_H
+#define VESSTATICBATCHER_H
+
+// VES includes
+#include "vesSharedPtr.h"
+
+// C/C++ includes
+#include <vector>
+
+// Forward declarations
+class vesActor;
+class vesMaterial;
+
+class vesStaticBatcher
+{
+public:
+  /// Return the actors to render in place of \p actors: one batch actor per
+  /// group of mergeable actors, followed by the actors that could not be
+  /// merged with any other, unchanged.
+  static std::vector<vesSharedPtr<vesActor> > merge(
+    const std::vector<vesSharedPtr<vesActor> > &actors);
+
+  /// Whether actors with these materials can be drawn in one batch.
+  static bool isEquivalent(vesSharedPtr<vesMaterial> first,
+                           vesSharedPtr<vesMaterial> second);
+
+private:
+  vesStaticBatcher(); // Not implemented
+};
+
+#endif // VESSTATICBATCHER_H
@@ -23,6 +23,7 @@
 
 // VES includes
 #include "vesGL.h"
+#include "vesGLStateCache.h"
 #include "vesRenderState.h"
 #include "vesShaderProgram.h"
 #include "vesUniform.h"
@@ -40,7 +41,12 @@ vesTexture::vesTexture() : vesMaterialAttribute(),
   m_textureUnit(0),
   m_pixelFormat(vesColorDataType::PixelFormatNone),
   m_pixelDataType(vesColorDataType::PixelDataTypeNone),
-  m_internalFormat(0)
+  m_internalFormat(0),
+  m_allocatedWidth(0),
+  m_allocatedHeight(0),
+  m_allocatedInternalFormat(0),
+  m_allocatedPixelFormat(0),
+  m_allocatedPixelDataType(0)
 {
   this->m_type    = vesMaterialAttribute::Texture;
   this->m_binding = vesMaterialAttribute::BindMinimal;
@@ -49,7 +55,7 @@ vesTexture::vesTexture() : vesMaterialAttribute(),
 
 vesTexture::~vesTexture()
 {
-  glDeleteTextures(1, &this->m_textureHandle);
+  vesGLStateCache::current()->deleteTextures(1, &this->m_textureHandle);
 }
 
 
@@ -57,8 +63,9 @@ void vesTexture::bind(const vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
-  glActiveTexture(GL_TEXTURE0 + this->m_textureUnit);
-  glBindTexture(GL_TEXTURE_2D, this->m_textureHandle);
+  vesGLStateCache *state = vesGLStateCache::current();
+  state->activeTexture(GL_TEXTURE0 + this->m_textureUnit);
+  state->bindTexture(GL_TEXTURE_2D, this->m_textureHandle);
 }
 
 
@@ -66,7 +73,7 @@ void vesTexture::unbind(const vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
-  glBindTexture(GL_TEXTURE_2D, 0);
+  vesGLStateCache::current()->bindTexture(GL_TEXTURE_2D, 0);
 }
 
 
@@ -233,28 +240,51 @@ void vesTexture::setup(const vesRenderState &renderState)
   vesNotUsed(renderState);
 
   if (this->dirtyState()) {
-    glDeleteTextures(1, &this->m_textureHandle);
+    vesGLStateCache *state = vesGLStateCache::current();
+
+    if (this->m_hasImage) {
+      this->updateDimensions();
+      this->computeInternalFormatUsingImage();
+    }
+    const int pixelFormat =
+      this->m_pixelFormat ? this->m_pixelFormat : this->m_internalFormat;
+    const int pixelDataType =
+      this->m_pixelDataType ? this->m_pixelDataType : GL_UNSIGNED_BYTE;
+
+    // A new image of the same size and format, like the next frame of a
+    // video or background, replaces the pixels of the texture.
+    if (this->m_textureHandle && this->m_hasImage
+        && this->m_width == this->m_allocatedWidth
+        && this->m_height == this->m_allocatedHeight
+        && this->m_internalFormat == this->m_allocatedInternalFormat
+        && pixelFormat == this->m_allocatedPixelFormat
+        && pixelDataType == this->m_allocatedPixelDataType) {
+      state->bindTexture(GL_TEXTURE_2D, this->m_textureHandle);
+      glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, this->m_width, this->m_height,
+                      pixelFormat, pixelDataType, this->m_image->data());
+      this->setDirtyStateOff();
+      return;
+    }
+
+    state->deleteTextures(1, &this->m_textureHandle);
     glGenTextures(1, &this->m_textureHandle);
-    glBindTexture(GL_TEXTURE_2D, this->m_textureHandle);
+    state->bindTexture(GL_TEXTURE_2D, this->m_textureHandle);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
 
-    if (this->m_hasImage) {
-      this->updateDimensions();
-      this->computeInternalFormatUsingImage();
+    glTexImage2D(GL_TEXTURE_2D, 0, this->m_internalFormat, this->m_width, this->m_height, 0,
+                 pixelFormat, pixelDataType,
+                 this->m_hasImage ? this->m_image->data() : NULL);
 
-      glTexImage2D(GL_TEXTURE_2D, 0, this->m_internalFormat, this->m_width, this->m_height, 0,
-                   this->m_pixelFormat ? this->m_pixelFormat : this->m_internalFormat,
-                   this->m_pixelDataType ? this->m_pixelDataType : GL_UNSIGNED_BYTE, this->m_image->data());
-    }
-    else {
-      glTexImage2D(GL_TEXTURE_2D, 0, this->m_internalFormat, this->m_width, this->m_height, 0,
-                   this->m_pixelFormat ? this->m_pixelFormat : this->m_internalFormat,
-                   this->m_pixelDataType ? this->m_pixelDataType : GL_UNSIGNED_BYTE, NULL);
-    }
+    this->m_allocatedWidth = this->m_width;
+    this->m_allocatedHeight = this->m_height;
+    this->m_allocatedInternalFormat = this->m_internalFormat;
+    this->m_allocatedPixelFormat = pixelFormat;
+    this->m_allocatedPixelDataType = pixelDataType;
 
     this->setDirtyStateOff();
   }
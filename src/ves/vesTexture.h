@@ -105,5 +105,13 @@ protected:
   vesColorDataType::PixelDataType m_pixelDataType;
 
   int m_internalFormat;
+
+  // Size and formats the GL texture was allocated with.  An image that
+  // matches them is uploaded into the texture instead of reallocating it.
+  int m_allocatedWidth;
+  int m_allocatedHeight;
+  int m_allocatedInternalFormat;
+  int m_allocatedPixelFormat;
+  int m_allocatedPixelDataType;
 };
 #endif // __vesTexture_h
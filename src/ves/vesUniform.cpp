@@ -25,12 +25,20 @@
 #include "vesShaderProgram.h"
 
 // C++ includes
+#include <algorithm>
 #include <limits>
 #include <iostream>
 
+namespace {
+
+vesThreadLocal unsigned long numberOfGLCallsCounter = 0;
+
+}
+
 vesUniform::vesUniform() :
   m_type            (Undefined),
-  m_numberElements  (0)
+  m_numberElements  (0),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
 }
@@ -80,7 +88,8 @@ void vesUniform::setName(const std::string &name)
 
 vesUniform::vesUniform(const std::string &name, float value) :
   m_type            (Float),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -91,7 +100,8 @@ vesUniform::vesUniform(const std::string &name, float value) :
 
 vesUniform::vesUniform(const std::string &name, int value) :
   m_type            (Int),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -102,7 +112,8 @@ vesUniform::vesUniform(const std::string &name, int value) :
 
 vesUniform::vesUniform(const std::string &name, bool value) :
   m_type            (Bool),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -113,7 +124,8 @@ vesUniform::vesUniform(const std::string &name, bool value) :
 
 vesUniform::vesUniform(const std::string &name, const vesVector2f& vector) :
   m_type            (FloatVec2),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -124,7 +136,8 @@ vesUniform::vesUniform(const std::string &name, const vesVector2f& vector) :
 
 vesUniform::vesUniform(const std::string &name, const vesVector3f& vector) :
   m_type            (FloatVec3),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -135,7 +148,8 @@ vesUniform::vesUniform(const std::string &name, const vesVector3f& vector) :
 
 vesUniform::vesUniform(const std::string &name, const vesVector4f& vector) :
   m_type            (FloatVec4),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -146,7 +160,8 @@ vesUniform::vesUniform(const std::string &name, const vesVector4f& vector) :
 
 vesUniform::vesUniform(const std::string &name, const vesMatrix3x3f& matrix) :
   m_type            (FloatMat3),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -157,7 +172,8 @@ vesUniform::vesUniform(const std::string &name, const vesMatrix3x3f& matrix) :
 
 vesUniform::vesUniform(const std::string &name, const vesMatrix4x4f& matrix) :
   m_type            (FloatMat4),
-  m_numberElements  (1)
+  m_numberElements  (1),
+  m_modifiedCount   (1)
 {
   this->setMinimalDefaults();
   this->setName(name);
@@ -287,9 +303,7 @@ bool vesUniform::setElement(unsigned int index, float value)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  (*this->m_floatArray)[j] = value;
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_floatArray)[j], &value, 1);
 
   return true;
 }
@@ -302,9 +316,7 @@ bool vesUniform::setElement(unsigned int index, int value)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  (*this->m_intArray)[j] = value;
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_intArray)[j], &value, 1);
 
   return true;
 }
@@ -315,13 +327,12 @@ bool vesUniform::setElement(unsigned int index, bool value)
   if (index >= this->m_numberElements || !isCompatibleType(Bool))
     return false;
 
-    unsigned int j = index * getTypeNumberOfComponents(getType());
+  unsigned int j = index * getTypeNumberOfComponents(getType());
 
-    (*this->m_intArray)[j] = value;
+  GLint intValue = value;
+  this->assignData(&(*this->m_intArray)[j], &intValue, 1);
 
-    // \todo: Make state dirty.
-
-    return true;
+  return true;
 }
 
 
@@ -332,10 +343,7 @@ bool vesUniform::setElement(unsigned int index, const vesVector2f &vector)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  (*this->m_floatArray)[j]   = vector[0];
-  (*this->m_floatArray)[j+1] = vector[1];
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_floatArray)[j], vector.data(), 2);
 
   return true;
 }
@@ -348,11 +356,7 @@ bool vesUniform::setElement(unsigned int index, const vesVector3f &vector)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  (*this->m_floatArray)[j]   = vector[0];
-  (*this->m_floatArray)[j+1] = vector[1];
-  (*this->m_floatArray)[j+2] = vector[2];
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_floatArray)[j], vector.data(), 3);
 
   return true;
 }
@@ -365,12 +369,7 @@ bool vesUniform::setElement(unsigned int index, const vesVector4f &vector)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  (*this->m_floatArray)[j]   = vector[0];
-  (*this->m_floatArray)[j+1] = vector[1];
-  (*this->m_floatArray)[j+2] = vector[2];
-  (*this->m_floatArray)[j+3] = vector[3];
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_floatArray)[j], vector.data(), 4);
 
   return true;
 }
@@ -383,10 +382,7 @@ bool vesUniform::setElement(unsigned int index, const vesMatrix3x3f &matrix)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  for (int i = 0; i < 9; ++i)
-    (*this->m_floatArray)[j+i] = matrix.data()[i];
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_floatArray)[j], matrix.data(), 9);
 
   return true;
 }
@@ -399,10 +395,7 @@ bool vesUniform::setElement(unsigned int index, const vesMatrix4x4f &matrix)
 
   unsigned int j = index * getTypeNumberOfComponents(this->m_type);
 
-  for (int i = 0; i < 16; ++i)
-    (*this->m_floatArray)[j+i] = matrix.data()[i];
-
-  // \todo: Make state dirty.
+  this->assignData(&(*this->m_floatArray)[j], matrix.data(), 16);
 
   return true;
 }
@@ -518,6 +511,8 @@ void vesUniform::callGL(int location) const
   if (this->m_numberElements < 1)
     return;
 
+  ++numberOfGLCallsCounter;
+
   switch (this->m_type)
   {
     case Bool:
@@ -570,6 +565,32 @@ void vesUniform::callGL(int location) const
 }
 
 
+unsigned long vesUniform::numberOfGLCalls()
+{
+  return numberOfGLCallsCounter;
+}
+
+
+void vesUniform::resetNumberOfGLCalls()
+{
+  numberOfGLCallsCounter = 0;
+}
+
+
+template <typename T>
+void vesUniform::assignData(T *destination, const T *source, int count)
+{
+  // Only a real change invalidates the values programs have already sent.
+  for (int i = 0; i < count; ++i) {
+    if (destination[i] != source[i]) {
+      std::copy(source + i, source + count, destination + i);
+      ++this->m_modifiedCount;
+      return;
+    }
+  }
+}
+
+
 void vesUniform::setMinimalDefaults()
 {
   m_intArray    = 0;
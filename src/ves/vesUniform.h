@@ -173,6 +173,19 @@ public:
 
   void callGL(int location) const;
 
+  /// Returns a counter that is incremented whenever the value of the
+  /// uniform changes.  Programs compare it with the value they last sent
+  /// to skip uploads of unchanged uniforms.
+  unsigned long modifiedCount() const { return this->m_modifiedCount; }
+
+  /// Force the uniform to be sent again by every program that uses it.
+  void modified() { ++this->m_modifiedCount; }
+
+  /// Number of glUniform calls made by all uniforms on the calling thread
+  /// since the last reset.
+  static unsigned long numberOfGLCalls();
+  static void resetNumberOfGLCalls();
+
 protected:
   vesUniform& operator=(const vesUniform&);
 
@@ -188,10 +201,14 @@ protected:
 
   void allocateDataArray();
 
+  template <typename T>
+  void assignData(T *destination, const T *source, int count);
+
   Type m_type;
   std::string m_name;
 
   unsigned int m_numberElements;
+  unsigned long m_modifiedCount;
 
   IntArray *m_intArray;
   FloatArray *m_floatArray;
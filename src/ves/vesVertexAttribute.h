@@ -26,6 +26,7 @@
 // VES includes
 #include "vesGeometryData.h"
 #include "vesGL.h"
+#include "vesGLStateCache.h"
 #include "vesMapper.h"
 #include "vesRenderState.h"
 #include "vesSetGet.h"
@@ -104,8 +105,8 @@ public:
                           sourceData->attributeStride(key),
                           (void*)static_cast<intptr_t>(sourceData->attributeOffset(key)));
 
-    glEnableVertexAttribArray(renderState.m_material->shaderProgram()->
-                              attributeLocation(this->m_name));
+    vesGLStateCache::current()->enableVertexAttribArray(
+      renderState.m_material->shaderProgram()->attributeLocation(this->m_name));
   }
 
   virtual void unbindVertexData(const vesRenderState &renderState, int key)
@@ -113,8 +114,8 @@ public:
     vesNotUsed(key);
     assert(renderState.m_material && renderState.m_material->shaderProgram());
 
-    glDisableVertexAttribArray(renderState.m_material->shaderProgram()->
-                               attributeLocation(this->m_name));
+    vesGLStateCache::current()->disableVertexAttribArray(
+      renderState.m_material->shaderProgram()->attributeLocation(this->m_name));
   }
 };
 
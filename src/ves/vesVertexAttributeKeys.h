@@ -29,7 +29,9 @@ struct vesVertexAttributeKeys
     TextureCoordinate   = 2,
     Color               = 3,
     Scalar              = 4,
-    CountAttributeIndex = 5
+    InstanceOffset      = 5,
+    InstanceColor       = 6,
+    CountAttributeIndex = 7
   };
 };
 
@@ -3,6 +3,7 @@
 
 // VES includes.
 #include "vesGL.h"
+#include "vesGLStateCache.h"
 
 vesViewport::vesViewport()
 {
@@ -43,8 +44,9 @@ void vesViewport::render(vesRenderState &renderState)
 {
   vesNotUsed(renderState);
 
-  glViewport(static_cast<GLint>(this->m_x), static_cast<GLint>(this->m_y),
-             static_cast<GLsizei>(this->m_width), static_cast<GLsizei>(this->m_height));
+  vesGLStateCache::current()->viewport(
+    static_cast<GLint>(this->m_x), static_cast<GLint>(this->m_y),
+    static_cast<GLsizei>(this->m_width), static_cast<GLsizei>(this->m_height));
 }
 
 